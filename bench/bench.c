@@ -0,0 +1,433 @@
+/*
+ * Copyright (c) 2014 Jerry Lundström <lundstrom.jerry@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+/*
+ * This is a benchmark of the CRUD operations of the objects generated from
+ * bench.json on each backend that has been compiled in. The throughput and
+ * latency percentiles are printed as JSON on stdout.
+ */
+
+#include "config.h"
+
+#include "item.h"
+
+#include <libdbo/libdbo.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * The configuration of a backend to benchmark, the settings are pairs of
+ * name and value ending with NULL.
+ */
+typedef struct bench_backend {
+    const char* name;
+    const char* settings[15];
+} bench_backend_t;
+
+static const bench_backend_t bench_backends[] = {
+    { "memory", { "backend", "memory", "unique", "item.name", NULL } },
+    { "cache", { "backend", "cache", "cache_backend", "memory", "unique", "item.name", NULL } },
+#if defined(HAVE_SQLITE3)
+    { "sqlite", { "backend", "sqlite", "file", "bench.db", NULL } },
+#endif
+#if defined(HAVE_LMDB)
+    { "lmdb", { "backend", "lmdb", "file", "bench.lmdb", "unique", "item.name", NULL } },
+#endif
+#if defined(TEST_MYSQL)
+    { "mysql", { "backend", "mysql", "host", TEST_MYSQL_HOST, "port", TEST_MYSQL_PORT_TXT, "user", TEST_MYSQL_USER, "pass", TEST_MYSQL_PASS, "db", TEST_MYSQL_DB, NULL } },
+#endif
+#if defined(TEST_POSTGRESQL)
+    { "postgresql", { "backend", "postgresql", "host", TEST_POSTGRESQL_HOST, "port", TEST_POSTGRESQL_PORT_TXT, "user", TEST_POSTGRESQL_USER, "pass", TEST_POSTGRESQL_PASS, "db", TEST_POSTGRESQL_DB, NULL } },
+#endif
+    { NULL, { NULL } }
+};
+
+/*
+ * Display the options that can be used.
+ */
+void usage(void) {
+    fprintf(stderr, "Usage: dbo-bench [options]\n"
+        "\n"
+        "Options:\n"
+        "  -n <objects>  number of objects to create, read, update and delete (default 1000)\n"
+        "  -s <scans>    number of list scans and counts (default 10)\n"
+        "  -b <backend>  only benchmark this backend\n"
+        "  -h            display this help\n"
+        "\n"
+        "Backends:\n"
+        );
+}
+
+/*
+ * Setup and connect a connection to a backend, the configuration list is
+ * not owned by the connection and must be freed after it.
+ */
+libdbo_connection_t* bench_connect(const bench_backend_t* backend, libdbo_configuration_list_t** configuration_list) {
+    libdbo_configuration_t* configuration;
+    libdbo_connection_t* connection;
+    int i;
+
+    if (!(*configuration_list = libdbo_configuration_list_new())) {
+        return NULL;
+    }
+    for (i = 0; backend->settings[i]; i += 2) {
+        if (!(configuration = libdbo_configuration_new())
+            || libdbo_configuration_set_name(configuration, backend->settings[i])
+            || libdbo_configuration_set_value(configuration, backend->settings[i + 1])
+            || libdbo_configuration_list_add(*configuration_list, configuration))
+        {
+            libdbo_configuration_free(configuration);
+            return NULL;
+        }
+    }
+
+    if (!(connection = libdbo_connection_new())
+        || libdbo_connection_set_configuration_list(connection, *configuration_list)
+        || libdbo_connection_setup(connection)
+        || libdbo_connection_connect(connection))
+    {
+        libdbo_connection_free(connection);
+        return NULL;
+    }
+
+    return connection;
+}
+
+static void __bench_start(struct timespec* start) {
+    clock_gettime(CLOCK_MONOTONIC, start);
+}
+
+static unsigned long long __bench_elapsed(const struct timespec* start) {
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (end.tv_sec < start->tv_sec
+        || (end.tv_sec == start->tv_sec && end.tv_nsec < start->tv_nsec))
+    {
+        return 0;
+    }
+    return (unsigned long long)(end.tv_sec - start->tv_sec) * 1000000
+        + (end.tv_nsec - start->tv_nsec) / 1000;
+}
+
+/*
+ * Print the throughput and latency of one operation, the latencies of the
+ * calls have been recorded in the statistics and `usec` is the time the
+ * whole run took.
+ */
+void bench_print(const char* operation, libdbo_stats_t* stats, libdbo_stats_operation_t stats_operation, unsigned long long usec, int last) {
+    libdbo_stats_counters_t counters;
+    unsigned long long percentile[3];
+    const double percentiles[3] = { 50, 90, 99 };
+    int i;
+
+    if (libdbo_stats_operation(stats, stats_operation, &counters)) {
+        memset(&counters, 0, sizeof(counters));
+    }
+
+    /*
+     * The percentiles are the highest latency of their buckets so they are
+     * capped by the highest latency seen.
+     */
+    for (i = 0; i < 3; i++) {
+        percentile[i] = libdbo_stats_histogram_percentile(&(counters.latency), percentiles[i]);
+        if (percentile[i] > counters.max_usec) {
+            percentile[i] = counters.max_usec;
+        }
+    }
+
+    printf("        \"%s\": {\n"
+        "          \"calls\": %lu,\n"
+        "          \"errors\": %lu,\n"
+        "          \"seconds\": %.6f,\n"
+        "          \"per_second\": %.1f,\n"
+        "          \"usec\": { \"mean\": %.1f, \"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"max\": %llu }\n"
+        "        }%s\n",
+        operation,
+        counters.calls,
+        counters.errors,
+        usec / 1000000.0,
+        usec ? counters.calls * 1000000.0 / usec : 0.0,
+        counters.calls ? (double)counters.total_usec / counters.calls : 0.0,
+        percentile[0],
+        percentile[1],
+        percentile[2],
+        counters.max_usec,
+        last ? "" : ",");
+}
+
+/*
+ * Run the benchmark on a connection, the objects are created, read by id,
+ * scanned as a list, updated with their revision, counted and deleted.
+ */
+int bench_run(const libdbo_connection_t* connection, size_t objects, size_t scans) {
+    libdbo_stats_t* stats[6] = { NULL, NULL, NULL, NULL, NULL, NULL };
+    unsigned long long usec[6] = { 0, 0, 0, 0, 0, 0 };
+    struct timespec run, start;
+    libdbo_value_t* ids = NULL;
+    item_t** items = NULL;
+    item_t* item = NULL;
+    item_list_t* item_list;
+    const item_t* item2;
+    char name[64];
+    size_t i, count;
+    int ret, error = 1;
+
+    for (i = 0; i < 6; i++) {
+        if (!(stats[i] = libdbo_stats_new())) {
+            goto done;
+        }
+    }
+    if (!(ids = calloc(objects, sizeof(libdbo_value_t)))
+        || !(items = calloc(objects, sizeof(item_t*))))
+    {
+        goto done;
+    }
+
+    /*
+     * Create
+     */
+    __bench_start(&run);
+    for (i = 0; i < objects; i++) {
+        snprintf(name, sizeof(name), "bench %lu", (unsigned long)i);
+        if (!(item = item_new(connection))
+            || item_set_name(item, name)
+            || item_set_value(item, (unsigned int)i))
+        {
+            goto done;
+        }
+        __bench_start(&start);
+        ret = item_create(item);
+        libdbo_stats_record(stats[0], LIBDBO_STATS_CREATE, NULL, __bench_elapsed(&start), ret);
+        item_free(item);
+        item = NULL;
+    }
+    usec[0] = __bench_elapsed(&run);
+
+    /*
+     * Get the ids of the objects created, this is not measured.
+     */
+    if (!(item_list = item_list_new_get(connection))) {
+        goto done;
+    }
+    for (i = 0, item2 = item_list_begin(item_list); i < objects && item2; i++, item2 = item_list_next(item_list)) {
+        if (libdbo_value_copy(&ids[i], item_id(item2))) {
+            item_list_free(item_list);
+            goto done;
+        }
+    }
+    item_list_free(item_list);
+    if (i != objects) {
+        goto done;
+    }
+
+    /*
+     * Get by id
+     */
+    __bench_start(&run);
+    for (i = 0; i < objects; i++) {
+        if (!(items[i] = item_new(connection))) {
+            goto done;
+        }
+        __bench_start(&start);
+        ret = item_get_by_id(items[i], &ids[i]);
+        libdbo_stats_record(stats[1], LIBDBO_STATS_READ, NULL, __bench_elapsed(&start), ret);
+    }
+    usec[1] = __bench_elapsed(&run);
+
+    /*
+     * List scan, walking all objects
+     */
+    __bench_start(&run);
+    for (i = 0; i < scans; i++) {
+        __bench_start(&start);
+        count = 0;
+        if ((item_list = item_list_new_get(connection))) {
+            for (item2 = item_list_begin(item_list); item2; item2 = item_list_next(item_list)) {
+                count++;
+            }
+            item_list_free(item_list);
+        }
+        libdbo_stats_record(stats[2], LIBDBO_STATS_READ, NULL, __bench_elapsed(&start), !item_list || count != objects);
+    }
+    usec[2] = __bench_elapsed(&run);
+
+    /*
+     * Update with revision
+     */
+    __bench_start(&run);
+    for (i = 0; i < objects; i++) {
+        if (item_set_value(items[i], item_value(items[i]) + 1)) {
+            goto done;
+        }
+        __bench_start(&start);
+        ret = item_update(items[i]);
+        libdbo_stats_record(stats[3], LIBDBO_STATS_UPDATE, NULL, __bench_elapsed(&start), ret);
+    }
+    usec[3] = __bench_elapsed(&run);
+
+    /*
+     * Count
+     */
+    __bench_start(&run);
+    for (i = 0; i < scans; i++) {
+        __bench_start(&start);
+        ret = item_count(items[0], NULL, &count);
+        libdbo_stats_record(stats[4], LIBDBO_STATS_COUNT, NULL, __bench_elapsed(&start), ret || count != objects);
+    }
+    usec[4] = __bench_elapsed(&run);
+
+    /*
+     * Delete, the objects are read again first to get the revision from the
+     * update which is not measured.
+     */
+    for (i = 0; i < objects; i++) {
+        item_free(items[i]);
+        if (!(items[i] = item_new(connection))
+            || item_get_by_id(items[i], &ids[i]))
+        {
+            goto done;
+        }
+    }
+    __bench_start(&run);
+    for (i = 0; i < objects; i++) {
+        __bench_start(&start);
+        ret = item_delete(items[i]);
+        libdbo_stats_record(stats[5], LIBDBO_STATS_DELETE, NULL, __bench_elapsed(&start), ret);
+    }
+    usec[5] = __bench_elapsed(&run);
+
+    printf("      \"operations\": {\n");
+    bench_print("create", stats[0], LIBDBO_STATS_CREATE, usec[0], 0);
+    bench_print("get_by_id", stats[1], LIBDBO_STATS_READ, usec[1], 0);
+    bench_print("list_scan", stats[2], LIBDBO_STATS_READ, usec[2], 0);
+    bench_print("update", stats[3], LIBDBO_STATS_UPDATE, usec[3], 0);
+    bench_print("count", stats[4], LIBDBO_STATS_COUNT, usec[4], 0);
+    bench_print("delete", stats[5], LIBDBO_STATS_DELETE, usec[5], 1);
+    printf("      }\n");
+    error = 0;
+
+done:
+    item_free(item);
+    if (items) {
+        for (i = 0; i < objects; i++) {
+            item_free(items[i]);
+        }
+        free(items);
+    }
+    if (ids) {
+        for (i = 0; i < objects; i++) {
+            libdbo_value_reset(&ids[i]);
+        }
+        free(ids);
+    }
+    for (i = 0; i < 6; i++) {
+        libdbo_stats_free(stats[i]);
+    }
+    return error;
+}
+
+int main(int argc, char* argv[]) {
+    const bench_backend_t* backend;
+    libdbo_configuration_list_t* configuration_list;
+    libdbo_connection_t* connection;
+    const char* only = NULL;
+    size_t objects = 1000;
+    size_t scans = 10;
+    int opt, first = 1, error = 0;
+
+    while ((opt = getopt(argc, argv, "n:s:b:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            objects = (size_t)atol(optarg);
+            break;
+
+        case 's':
+            scans = (size_t)atol(optarg);
+            break;
+
+        case 'b':
+            only = optarg;
+            break;
+
+        case 'h':
+        default:
+            usage();
+            for (backend = bench_backends; backend->name; backend++) {
+                fprintf(stderr, "  %s\n", backend->name);
+            }
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (!objects || !scans) {
+        usage();
+        return 1;
+    }
+    if (only) {
+        for (backend = bench_backends; backend->name; backend++) {
+            if (!strcmp(only, backend->name)) {
+                break;
+            }
+        }
+        if (!backend->name) {
+            fprintf(stderr, "dbo-bench: unknown backend %s\n", only);
+            return 1;
+        }
+    }
+
+    printf("{\n"
+        "  \"objects\": %lu,\n"
+        "  \"scans\": %lu,\n"
+        "  \"backends\": {",
+        (unsigned long)objects, (unsigned long)scans);
+    for (backend = bench_backends; backend->name; backend++) {
+        if (only && strcmp(only, backend->name)) {
+            continue;
+        }
+
+        printf("%s\n    \"%s\": {\n", first ? "" : ",", backend->name);
+        first = 0;
+        configuration_list = NULL;
+        if (!(connection = bench_connect(backend, &configuration_list))) {
+            printf("      \"error\": \"unable to connect\"\n");
+            error = 1;
+        }
+        else if (bench_run(connection, objects, scans)) {
+            printf("      \"error\": \"benchmark failed\"\n");
+            error = 1;
+        }
+        printf("    }");
+        libdbo_connection_free(connection);
+        libdbo_configuration_list_free(configuration_list);
+    }
+    printf("\n  }\n}\n");
+
+    libdbo_backend_factory_shutdown();
+    return error;
+}
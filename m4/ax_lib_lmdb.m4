@@ -0,0 +1,153 @@
+# ===========================================================================
+#                             ax_lib_lmdb.m4
+# ===========================================================================
+#
+# SYNOPSIS
+#
+#   AX_LIB_LMDB([MINIMUM-VERSION])
+#
+# DESCRIPTION
+#
+#   Test for the LMDB library of a particular version (or newer)
+#
+#   This macro takes only one optional argument, required version of LMDB
+#   library. If required version is not passed, 0.9.0 is used in the test
+#   of existance of LMDB.
+#
+#   If no intallation prefix to the installed LMDB library is given the
+#   macro searches under /usr, /usr/local, and /opt.
+#
+#   This macro calls:
+#
+#     AC_SUBST(LMDB_CFLAGS)
+#     AC_SUBST(LMDB_LDFLAGS)
+#     AC_SUBST(LMDB_VERSION)
+#
+#   And sets:
+#
+#     HAVE_LMDB
+#
+# LICENSE
+#
+#   Based on ax_lib_sqlite3.m4,
+#   Copyright (c) 2008 Mateusz Loskot <mateusz@loskot.net>
+#
+#   Copying and distribution of this file, with or without modification, are
+#   permitted in any medium without royalty provided the copyright notice
+#   and this notice are preserved. This file is offered as-is, without any
+#   warranty.
+
+#serial 1
+
+AC_DEFUN([AX_LIB_LMDB],
+[
+    AC_ARG_WITH([lmdb],
+        AS_HELP_STRING(
+            [--with-lmdb=@<:@ARG@:>@],
+            [use LMDB library @<:@default=yes@:>@, optionally specify the prefix for lmdb library]
+        ),
+        [
+        if test "$withval" = "no"; then
+            WANT_LMDB="no"
+        elif test "$withval" = "yes"; then
+            WANT_LMDB="yes"
+            ac_lmdb_path=""
+        else
+            WANT_LMDB="yes"
+            ac_lmdb_path="$withval"
+        fi
+        ],
+        [WANT_LMDB="yes"]
+    )
+
+    LMDB_CFLAGS=""
+    LMDB_LDFLAGS=""
+    LMDB_VERSION=""
+
+    if test "x$WANT_LMDB" = "xyes"; then
+
+        ac_lmdb_header="lmdb.h"
+
+        lmdb_version_req=ifelse([$1], [], [0.9.0], [$1])
+        lmdb_version_req_major=`expr $lmdb_version_req : '\([[0-9]]*\)'`
+        lmdb_version_req_minor=`expr $lmdb_version_req : '[[0-9]]*\.\([[0-9]]*\)'`
+        lmdb_version_req_micro=`expr $lmdb_version_req : '[[0-9]]*\.[[0-9]]*\.\([[0-9]]*\)'`
+        if test "x$lmdb_version_req_micro" = "x" ; then
+            lmdb_version_req_micro="0"
+        fi
+
+        AC_MSG_CHECKING([for LMDB library >= $lmdb_version_req])
+
+        if test "$ac_lmdb_path" != ""; then
+            ac_lmdb_ldflags="-L$ac_lmdb_path/lib"
+            ac_lmdb_cppflags="-I$ac_lmdb_path/include"
+        else
+            for ac_lmdb_path_tmp in /usr /usr/local /opt ; do
+                if test -f "$ac_lmdb_path_tmp/include/$ac_lmdb_header" \
+                    && test -r "$ac_lmdb_path_tmp/include/$ac_lmdb_header"; then
+                    ac_lmdb_path=$ac_lmdb_path_tmp
+                    ac_lmdb_cppflags="-I$ac_lmdb_path_tmp/include"
+                    ac_lmdb_ldflags="-L$ac_lmdb_path_tmp/lib"
+                    break;
+                fi
+            done
+        fi
+
+        ac_lmdb_ldflags="$ac_lmdb_ldflags -llmdb"
+
+        saved_CPPFLAGS="$CPPFLAGS"
+        CPPFLAGS="$CPPFLAGS $ac_lmdb_cppflags"
+
+        AC_LANG_PUSH(C)
+        AC_COMPILE_IFELSE(
+            [
+            AC_LANG_PROGRAM([[@%:@include <lmdb.h>]],
+                [[
+#if (MDB_VERSION_FULL >= MDB_VERINT($lmdb_version_req_major, $lmdb_version_req_minor, $lmdb_version_req_micro))
+/* Everything is okay */
+#else
+#  error LMDB version is too old
+#endif
+                ]]
+            )
+            ],
+            [
+            AC_MSG_RESULT([yes])
+            success="yes"
+            ],
+            [
+            AC_MSG_RESULT([not found])
+            success="no"
+            ]
+        )
+        AC_LANG_POP(C)
+
+        CPPFLAGS="$saved_CPPFLAGS"
+
+        if test "$success" = "yes"; then
+
+            LMDB_CFLAGS="$ac_lmdb_cppflags"
+            LMDB_LDFLAGS="$ac_lmdb_ldflags"
+
+            ac_lmdb_header_path="$ac_lmdb_path/include/$ac_lmdb_header"
+
+            dnl Retrieve LMDB release version
+            if test "x$ac_lmdb_header_path" != "x"; then
+                ac_lmdb_version=`cat $ac_lmdb_header_path \
+                    | grep '#define.*MDB_VERSION_\(MAJOR\|MINOR\|PATCH\)' \
+                    | sed -e 's/.*MDB_VERSION_[[A-Z]]*[[ 	]]*\([[0-9]]*\).*/\1/' \
+                    | tr '\n' '.' | sed -e 's/\.$//'`
+                if test "$ac_lmdb_version" != ""; then
+                    LMDB_VERSION=$ac_lmdb_version
+                else
+                    AC_MSG_WARN([Cannot find MDB_VERSION macros in lmdb.h header to retrieve LMDB version!])
+                fi
+            fi
+
+            AC_SUBST(LMDB_CFLAGS)
+            AC_SUBST(LMDB_LDFLAGS)
+            AC_SUBST(LMDB_VERSION)
+            AC_DEFINE([HAVE_LMDB], [], [Have the LMDB library])
+        fi
+    fi
+])
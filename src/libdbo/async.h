@@ -0,0 +1,334 @@
+/*
+ * Copyright (c) 2014 Jerry Lundström <lundstrom.jerry@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/** \file libdbo/async.h */
+/** \defgroup libdbo_async libdbo_async
+ * Database Asynchronous Operations.
+ * These are the functions and container for handling worker threads that
+ * execute database operations without blocking the caller.
+ */
+/** \defgroup libdbo_async_future libdbo_async_future
+ * Database Asynchronous Future.
+ * These are the functions and container for handling the outcome of a
+ * database operation submitted to libdbo_async.
+ */
+
+#ifndef libdbo_async_h
+#define libdbo_async_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+struct libdbo_async;
+struct libdbo_async_future;
+#endif
+
+/** \addtogroup libdbo_async */
+/** \{ */
+/**
+ * A set of worker threads, each with its own connection, executing database
+ * operations.
+ */
+typedef struct libdbo_async libdbo_async_t;
+/** \} */
+/** \addtogroup libdbo_async_future */
+/** \{ */
+/**
+ * The outcome of a database operation submitted to libdbo_async.
+ */
+typedef struct libdbo_async_future libdbo_async_future_t;
+/** \} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#include <libdbo/configuration.h>
+#include <libdbo/object.h>
+#include <libdbo/join.h>
+#include <libdbo/clause.h>
+#include <libdbo/result.h>
+#include <libdbo/value.h>
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \addtogroup libdbo_async */
+/** \{ */
+
+/**
+ * Submit an operation to the worker with the least operations queued.
+ */
+#define LIBDBO_ASYNC_ANY_WORKER ((unsigned int)-1)
+
+/**
+ * Function pointer called by a worker thread when an operation has completed.
+ * \param[in] future a libdbo_async_future_t pointer, it is valid until the
+ * function returns unless the submitter still holds it.
+ * \param[in] user_data the user data given when submitting the operation.
+ */
+typedef void (*libdbo_async_callback_t)(libdbo_async_future_t* future, void* user_data);
+
+/**
+ * Create a new set of worker threads, each with its own connection setup and
+ * connected with the configuration list. The configuration list is not copied
+ * and must be kept until the workers are deleted.
+ * \param[in] configuration_list a libdbo_configuration_list_t pointer.
+ * \param[in] workers the number of worker threads.
+ * \return a libdbo_async_t pointer or NULL on error.
+ */
+libdbo_async_t* libdbo_async_new(const libdbo_configuration_list_t* configuration_list, size_t workers);
+
+/**
+ * Delete a set of worker threads, operations already submitted are executed
+ * before the workers are stopped.
+ * \param[in] async a libdbo_async_t pointer.
+ */
+void libdbo_async_free(libdbo_async_t* async);
+
+/**
+ * Enable group commit of writes. A worker that finds a create, update or
+ * delete first in its queue, outside of a transaction submitted to it, waits
+ * until there are `size` writes first in the queue or `delay` milliseconds
+ * have passed and then executes them in one transaction. Each write is done
+ * in a nested transaction of its own so that a write that fails, such as an
+ * update with a revision conflict, only fails its own future. If the
+ * transaction can not be committed the writes in it that had not already
+ * failed fail with the error of the commit. A queued operation
+ * that is not a write ends the group early to keep the order.
+ * \param[in] async a libdbo_async_t pointer.
+ * \param[in] size the maximum number of writes in a transaction, 0 or 1
+ * disables group commit.
+ * \param[in] delay the maximum time in milliseconds to wait for more writes.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_async_set_group_commit(libdbo_async_t* async, size_t size, unsigned int delay);
+
+/**
+ * Get the number of worker threads.
+ * \param[in] async a libdbo_async_t pointer.
+ * \return a size_t.
+ */
+size_t libdbo_async_workers(const libdbo_async_t* async);
+
+/**
+ * Submit a create of an object.
+ *
+ * All operations submitted with the same affinity are executed in order by
+ * the same worker and connection, use it to keep the operations of a
+ * transaction together. The object and lists given must be kept until the
+ * operation has completed.
+ * \param[in] async a libdbo_async_t pointer.
+ * \param[in] affinity the worker affinity or LIBDBO_ASYNC_ANY_WORKER.
+ * \param[in] object a libdbo_object_t pointer.
+ * \param[in] object_field_list a libdbo_object_field_list_t pointer.
+ * \param[in] value_set a libdbo_value_set_t pointer.
+ * \param[in] callback a libdbo_async_callback_t function pointer or NULL.
+ * \param[in] user_data a pointer given to the callback.
+ * \return a libdbo_async_future_t pointer or NULL on error.
+ */
+libdbo_async_future_t* libdbo_async_create(libdbo_async_t* async, unsigned int affinity, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, libdbo_async_callback_t callback, void* user_data);
+
+/**
+ * Submit a read of objects, all results are fetched by the worker. See
+ * libdbo_async_create() for the affinity and lifetime of the arguments.
+ * \param[in] async a libdbo_async_t pointer.
+ * \param[in] affinity the worker affinity or LIBDBO_ASYNC_ANY_WORKER.
+ * \param[in] object a libdbo_object_t pointer.
+ * \param[in] join_list a libdbo_join_list_t pointer.
+ * \param[in] clause_list a libdbo_clause_list_t pointer.
+ * \param[in] callback a libdbo_async_callback_t function pointer or NULL.
+ * \param[in] user_data a pointer given to the callback.
+ * \return a libdbo_async_future_t pointer or NULL on error.
+ */
+libdbo_async_future_t* libdbo_async_read(libdbo_async_t* async, unsigned int affinity, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list, libdbo_async_callback_t callback, void* user_data);
+
+/**
+ * Submit an update of objects. See libdbo_async_create() for the affinity
+ * and lifetime of the arguments.
+ * \param[in] async a libdbo_async_t pointer.
+ * \param[in] affinity the worker affinity or LIBDBO_ASYNC_ANY_WORKER.
+ * \param[in] object a libdbo_object_t pointer.
+ * \param[in] object_field_list a libdbo_object_field_list_t pointer.
+ * \param[in] value_set a libdbo_value_set_t pointer.
+ * \param[in] clause_list a libdbo_clause_list_t pointer.
+ * \param[in] callback a libdbo_async_callback_t function pointer or NULL.
+ * \param[in] user_data a pointer given to the callback.
+ * \return a libdbo_async_future_t pointer or NULL on error.
+ */
+libdbo_async_future_t* libdbo_async_update(libdbo_async_t* async, unsigned int affinity, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, const libdbo_clause_list_t* clause_list, libdbo_async_callback_t callback, void* user_data);
+
+/**
+ * Submit a delete of objects. See libdbo_async_create() for the affinity and
+ * lifetime of the arguments.
+ * \param[in] async a libdbo_async_t pointer.
+ * \param[in] affinity the worker affinity or LIBDBO_ASYNC_ANY_WORKER.
+ * \param[in] object a libdbo_object_t pointer.
+ * \param[in] clause_list a libdbo_clause_list_t pointer.
+ * \param[in] callback a libdbo_async_callback_t function pointer or NULL.
+ * \param[in] user_data a pointer given to the callback.
+ * \return a libdbo_async_future_t pointer or NULL on error.
+ */
+libdbo_async_future_t* libdbo_async_delete(libdbo_async_t* async, unsigned int affinity, const libdbo_object_t* object, const libdbo_clause_list_t* clause_list, libdbo_async_callback_t callback, void* user_data);
+
+/**
+ * Submit a count of objects. See libdbo_async_create() for the affinity and
+ * lifetime of the arguments.
+ * \param[in] async a libdbo_async_t pointer.
+ * \param[in] affinity the worker affinity or LIBDBO_ASYNC_ANY_WORKER.
+ * \param[in] object a libdbo_object_t pointer.
+ * \param[in] join_list a libdbo_join_list_t pointer.
+ * \param[in] clause_list a libdbo_clause_list_t pointer.
+ * \param[in] callback a libdbo_async_callback_t function pointer or NULL.
+ * \param[in] user_data a pointer given to the callback.
+ * \return a libdbo_async_future_t pointer or NULL on error.
+ */
+libdbo_async_future_t* libdbo_async_count(libdbo_async_t* async, unsigned int affinity, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list, libdbo_async_callback_t callback, void* user_data);
+
+/**
+ * Submit the beginning of a transaction on the connection of the worker
+ * selected by the affinity.
+ * \param[in] async a libdbo_async_t pointer.
+ * \param[in] affinity the worker affinity.
+ * \param[in] callback a libdbo_async_callback_t function pointer or NULL.
+ * \param[in] user_data a pointer given to the callback.
+ * \return a libdbo_async_future_t pointer or NULL on error.
+ */
+libdbo_async_future_t* libdbo_async_transaction_begin(libdbo_async_t* async, unsigned int affinity, libdbo_async_callback_t callback, void* user_data);
+
+/**
+ * Submit the commit of a transaction on the connection of the worker
+ * selected by the affinity.
+ * \param[in] async a libdbo_async_t pointer.
+ * \param[in] affinity the worker affinity.
+ * \param[in] callback a libdbo_async_callback_t function pointer or NULL.
+ * \param[in] user_data a pointer given to the callback.
+ * \return a libdbo_async_future_t pointer or NULL on error.
+ */
+libdbo_async_future_t* libdbo_async_transaction_commit(libdbo_async_t* async, unsigned int affinity, libdbo_async_callback_t callback, void* user_data);
+
+/**
+ * Submit the roll back of a transaction on the connection of the worker
+ * selected by the affinity.
+ * \param[in] async a libdbo_async_t pointer.
+ * \param[in] affinity the worker affinity.
+ * \param[in] callback a libdbo_async_callback_t function pointer or NULL.
+ * \param[in] user_data a pointer given to the callback.
+ * \return a libdbo_async_future_t pointer or NULL on error.
+ */
+libdbo_async_future_t* libdbo_async_transaction_rollback(libdbo_async_t* async, unsigned int affinity, libdbo_async_callback_t callback, void* user_data);
+
+/** \} */
+
+/** \addtogroup libdbo_async_future */
+/** \{ */
+
+/**
+ * Release a database asynchronous future. If the operation has not completed
+ * it is still executed and the future is deleted by the worker afterwards,
+ * used to submit operations that only need the callback.
+ * \param[in] future a libdbo_async_future_t pointer.
+ */
+void libdbo_async_future_free(libdbo_async_future_t* future);
+
+/**
+ * Check if the operation of a database asynchronous future has completed.
+ * \param[in] future a libdbo_async_future_t pointer.
+ * \return non-zero if it has completed, otherwise zero.
+ */
+int libdbo_async_future_done(libdbo_async_future_t* future);
+
+/**
+ * Wait for the operation of a database asynchronous future to complete.
+ * \param[in] future a libdbo_async_future_t pointer.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_async_future_wait(libdbo_async_future_t* future);
+
+/**
+ * Get the status of a completed operation.
+ * \param[in] future a libdbo_async_future_t pointer.
+ * \return LIBDBO_ERROR_* if the operation failed or has not completed,
+ * otherwise LIBDBO_OK.
+ */
+int libdbo_async_future_status(libdbo_async_future_t* future);
+
+/**
+ * Take the result list of a completed read, the caller is responsible for
+ * freeing it.
+ * \param[in] future a libdbo_async_future_t pointer.
+ * \return a libdbo_result_list_t pointer or NULL on error, if the operation
+ * has not completed or if the result list has already been taken.
+ */
+libdbo_result_list_t* libdbo_async_future_take_result_list(libdbo_async_future_t* future);
+
+/**
+ * Get the count of a completed count.
+ * \param[in] future a libdbo_async_future_t pointer.
+ * \return a size_t, 0 if the operation has not completed.
+ */
+size_t libdbo_async_future_count(libdbo_async_future_t* future);
+
+/** \} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#ifdef LIBDBO_SHORT_NAMES
+#define DB_ASYNC_ANY_WORKER LIBDBO_ASYNC_ANY_WORKER
+#define db_async_t libdbo_async_t
+#define db_async_future_t libdbo_async_future_t
+#define db_async_callback_t libdbo_async_callback_t
+#define db_async_new(...) libdbo_async_new(__VA_ARGS__)
+#define db_async_free(...) libdbo_async_free(__VA_ARGS__)
+#define db_async_set_group_commit(...) libdbo_async_set_group_commit(__VA_ARGS__)
+#define db_async_workers(...) libdbo_async_workers(__VA_ARGS__)
+#define db_async_create(...) libdbo_async_create(__VA_ARGS__)
+#define db_async_read(...) libdbo_async_read(__VA_ARGS__)
+#define db_async_update(...) libdbo_async_update(__VA_ARGS__)
+#define db_async_delete(...) libdbo_async_delete(__VA_ARGS__)
+#define db_async_count(...) libdbo_async_count(__VA_ARGS__)
+#define db_async_transaction_begin(...) libdbo_async_transaction_begin(__VA_ARGS__)
+#define db_async_transaction_commit(...) libdbo_async_transaction_commit(__VA_ARGS__)
+#define db_async_transaction_rollback(...) libdbo_async_transaction_rollback(__VA_ARGS__)
+#define db_async_future_free(...) libdbo_async_future_free(__VA_ARGS__)
+#define db_async_future_done(...) libdbo_async_future_done(__VA_ARGS__)
+#define db_async_future_wait(...) libdbo_async_future_wait(__VA_ARGS__)
+#define db_async_future_status(...) libdbo_async_future_status(__VA_ARGS__)
+#define db_async_future_take_result_list(...) libdbo_async_future_take_result_list(__VA_ARGS__)
+#define db_async_future_count(...) libdbo_async_future_count(__VA_ARGS__)
+#endif
+#endif
+
+#endif
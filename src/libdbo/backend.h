@@ -113,6 +113,7 @@ typedef struct libdbo_backend_meta_data_list libdbo_backend_meta_data_list_t;
 #include <libdbo/join.h>
 #include <libdbo/clause.h>
 #include <libdbo/value.h>
+#include <libdbo/stats.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -177,6 +178,23 @@ typedef int (*libdbo_backend_handle_create_t)(void* data, const libdbo_object_t*
  */
 typedef libdbo_result_list_t* (*libdbo_backend_handle_read_t)(void* data, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list);
 
+/**
+ * Function pointer for doing `size` independent reads of objects from database
+ * backend at the same time. Each read is described by the object in `objects`
+ * and the join and clause lists at the same position in `join_lists` and
+ * `clause_lists`, which may be NULL. The result list of each read is stored at
+ * the same position in `result_lists`. The backend handle specific data is
+ * supplied in `data`.
+ * \param[in] data a void pointer.
+ * \param[in] size a size_t.
+ * \param[in] objects a libdbo_object_t pointer array.
+ * \param[in] join_lists a libdbo_join_list_t pointer array.
+ * \param[in] clause_lists a libdbo_clause_list_t pointer array.
+ * \param[out] result_lists a libdbo_result_list_t pointer array.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+typedef int (*libdbo_backend_handle_read_batch_t)(void* data, size_t size, const libdbo_object_t** objects, const libdbo_join_list_t** join_lists, const libdbo_clause_list_t** clause_lists, libdbo_result_list_t** result_lists);
+
 /**
  * Function pointer for updating objects in a database backend. The backend
  * handle specific data is supplied in `data`.
@@ -189,6 +207,20 @@ typedef libdbo_result_list_t* (*libdbo_backend_handle_read_t)(void* data, const
  */
 typedef int (*libdbo_backend_handle_update_t)(void* data, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, const libdbo_clause_list_t* clause_list);
 
+/**
+ * Function pointer for creating or updating a object in a database backend.
+ * The `clause_list` lists the unique fields that identifies the object and may
+ * contain the current revision if the object has one. The backend handle
+ * specific data is supplied in `data`.
+ * \param[in] data a void pointer.
+ * \param[in] object a libdbo_object_t pointer.
+ * \param[in] object_field_list a libdbo_object_field_list_t pointer.
+ * \param[in] value_set a libdbo_value_set_t pointer.
+ * \param[in] clause_list a libdbo_clause_list_t pointer.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+typedef int (*libdbo_backend_handle_upsert_t)(void* data, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, const libdbo_clause_list_t* clause_list);
+
 /**
  * Function pointer for deleting objects from database backend. The backend
  * handle specific data is supplied in `data`.
@@ -253,6 +285,8 @@ struct libdbo_backend_handle {
     libdbo_backend_handle_update_t update_function;
     libdbo_backend_handle_delete_t delete_function;
     libdbo_backend_handle_count_t count_function;
+    libdbo_backend_handle_upsert_t upsert_function;
+    libdbo_backend_handle_read_batch_t read_batch_function;
     libdbo_backend_handle_free_t free_function;
     libdbo_backend_handle_transaction_begin_t transaction_begin_function;
     libdbo_backend_handle_transaction_commit_t transaction_commit_function;
@@ -357,6 +391,34 @@ int libdbo_backend_handle_delete(const libdbo_backend_handle_t* backend_handle,
  */
 int libdbo_backend_handle_count(const libdbo_backend_handle_t* backend_handle, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list, size_t* count);
 
+/**
+ * Create an object in the database or update it if an object with the same
+ * unique fields, given as equal clauses in `clause_list`, already exists. If
+ * the object has a revision field the current revision can also be given in
+ * `clause_list` and the update will then only be done on that revision.
+ * \param[in] backend_handle a libdbo_backend_handle_t pointer.
+ * \param[in] object a libdbo_object_t pointer.
+ * \param[in] object_field_list a libdbo_object_field_list_t pointer.
+ * \param[in] value_set a libdbo_value_set_t pointer.
+ * \param[in] clause_list a libdbo_clause_list_t pointer.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_backend_handle_upsert(const libdbo_backend_handle_t* backend_handle, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, const libdbo_clause_list_t* clause_list);
+
+/**
+ * Do `size` independent reads of objects from the database at the same time if
+ * the backend supports it, otherwise one after another. On error no result
+ * lists are returned.
+ * \param[in] backend_handle a libdbo_backend_handle_t pointer.
+ * \param[in] size a size_t.
+ * \param[in] objects a libdbo_object_t pointer array.
+ * \param[in] join_lists a libdbo_join_list_t pointer array.
+ * \param[in] clause_lists a libdbo_clause_list_t pointer array.
+ * \param[out] result_lists a libdbo_result_list_t pointer array.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_backend_handle_read_batch(const libdbo_backend_handle_t* backend_handle, size_t size, const libdbo_object_t** objects, const libdbo_join_list_t** join_lists, const libdbo_clause_list_t** clause_lists, libdbo_result_list_t** result_lists);
+
 /**
  * Begin a transaction for a database connection.
  * \param[in] backend_handle a libdbo_backend_handle_t pointer.
@@ -457,6 +519,23 @@ int libdbo_backend_handle_set_delete(libdbo_backend_handle_t* backend_handle, li
  */
 int libdbo_backend_handle_set_count(libdbo_backend_handle_t* backend_handle, libdbo_backend_handle_count_t count_function);
 
+/**
+ * Set the upsert function of a database backend handle.
+ * \param[in] backend_handle a libdbo_backend_handle_t pointer.
+ * \param[in] upsert_function a libdbo_backend_handle_upsert_t.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_backend_handle_set_upsert(libdbo_backend_handle_t* backend_handle, libdbo_backend_handle_upsert_t upsert_function);
+
+/**
+ * Set the read batch function of a database backend handle, this function is
+ * optional and reads are done one after another if not set.
+ * \param[in] backend_handle a libdbo_backend_handle_t pointer.
+ * \param[in] read_batch_function a libdbo_backend_handle_read_batch_t.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_backend_handle_set_read_batch(libdbo_backend_handle_t* backend_handle, libdbo_backend_handle_read_batch_t read_batch_function);
+
 /**
  * Set the free function of a database backend handle.
  * \param[in] backend_handle a libdbo_backend_handle_t pointer.
@@ -511,6 +590,7 @@ struct libdbo_backend {
     libdbo_backend_t* next;
     char* name;
     libdbo_backend_handle_t* handle;
+    libdbo_stats_t* stats;
 };
 #endif
 
@@ -544,6 +624,16 @@ const char* libdbo_backend_name(const libdbo_backend_t* backend);
  */
 const libdbo_backend_handle_t* libdbo_backend_handle(const libdbo_backend_t* backend);
 
+/**
+ * Get the statistics of a database backend, the calls, failures, latency and
+ * rows returned of each operation are recorded for all operations and for
+ * each table.
+ * \param[in] backend a libdbo_backend_t pointer.
+ * \return a libdbo_stats_t pointer or NULL on error or if the backend does
+ * not keep statistics.
+ */
+libdbo_stats_t* libdbo_backend_stats(const libdbo_backend_t* backend);
+
 /**
  * Set the name of a database backend.
  * \param[in] backend a libdbo_backend_t pointer.
@@ -561,6 +651,16 @@ int libdbo_backend_set_name(libdbo_backend_t* backend, const char* name);
  */
 int libdbo_backend_set_handle(libdbo_backend_t* backend, libdbo_backend_handle_t* handle);
 
+/**
+ * Set the statistics of a database backend, this takes over the ownership of
+ * the statistics. Backends created by libdbo_backend_factory_get_backend()
+ * always have statistics.
+ * \param[in] backend a libdbo_backend_t pointer.
+ * \param[in] stats a libdbo_stats_t pointer.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_backend_set_stats(libdbo_backend_t* backend, libdbo_stats_t* stats);
+
 /**
  * Check if a database backend is not empty.
  * \param[in] backend a libdbo_backend_t pointer.
@@ -652,6 +752,34 @@ int libdbo_backend_delete(const libdbo_backend_t* backend, const libdbo_object_t
  */
 int libdbo_backend_count(const libdbo_backend_t* backend, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list, size_t* count);
 
+/**
+ * Create an object in the database or update it if an object with the same
+ * unique fields, given as equal clauses in `clause_list`, already exists. If
+ * the object has a revision field the current revision can also be given in
+ * `clause_list` and the update will then only be done on that revision.
+ * \param[in] backend a libdbo_backend_t pointer.
+ * \param[in] object a libdbo_object_t pointer.
+ * \param[in] object_field_list a libdbo_object_field_list_t pointer.
+ * \param[in] value_set a libdbo_value_set_t pointer.
+ * \param[in] clause_list a libdbo_clause_list_t pointer.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_backend_upsert(const libdbo_backend_t* backend, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, const libdbo_clause_list_t* clause_list);
+
+/**
+ * Do `size` independent reads of objects from the database at the same time if
+ * the backend supports it, otherwise one after another. On error no result
+ * lists are returned.
+ * \param[in] backend a libdbo_backend_t pointer.
+ * \param[in] size a size_t.
+ * \param[in] objects a libdbo_object_t pointer array.
+ * \param[in] join_lists a libdbo_join_list_t pointer array.
+ * \param[in] clause_lists a libdbo_clause_list_t pointer array.
+ * \param[out] result_lists a libdbo_result_list_t pointer array.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_backend_read_batch(const libdbo_backend_t* backend, size_t size, const libdbo_object_t** objects, const libdbo_join_list_t** join_lists, const libdbo_clause_list_t** clause_lists, libdbo_result_list_t** result_lists);
+
 /**
  * Begin a transaction for a database connection.
  * \param[in] backend a libdbo_backend_t pointer.
@@ -851,6 +979,8 @@ const libdbo_backend_meta_data_t* libdbo_backend_meta_data_list_find(const libdb
 #define db_backend_handle_update_t libdbo_backend_handle_update_t
 #define db_backend_handle_delete_t libdbo_backend_handle_delete_t
 #define db_backend_handle_count_t libdbo_backend_handle_count_t
+#define db_backend_handle_upsert_t libdbo_backend_handle_upsert_t
+#define db_backend_handle_read_batch_t libdbo_backend_handle_read_batch_t
 #define db_backend_handle_free_t libdbo_backend_handle_free_t
 #define db_backend_handle_transaction_begin_t libdbo_backend_handle_transaction_begin_t
 #define db_backend_handle_transaction_commit_t libdbo_backend_handle_transaction_commit_t
@@ -866,6 +996,8 @@ const libdbo_backend_meta_data_t* libdbo_backend_meta_data_list_find(const libdb
 #define db_backend_handle_update(...) libdbo_backend_handle_update(__VA_ARGS__)
 #define db_backend_handle_delete(...) libdbo_backend_handle_delete(__VA_ARGS__)
 #define db_backend_handle_count(...) libdbo_backend_handle_count(__VA_ARGS__)
+#define db_backend_handle_upsert(...) libdbo_backend_handle_upsert(__VA_ARGS__)
+#define db_backend_handle_read_batch(...) libdbo_backend_handle_read_batch(__VA_ARGS__)
 #define db_backend_handle_transaction_begin(...) libdbo_backend_handle_transaction_begin(__VA_ARGS__)
 #define db_backend_handle_transaction_commit(...) libdbo_backend_handle_transaction_commit(__VA_ARGS__)
 #define db_backend_handle_transaction_rollback(...) libdbo_backend_handle_transaction_rollback(__VA_ARGS__)
@@ -879,6 +1011,8 @@ const libdbo_backend_meta_data_t* libdbo_backend_meta_data_list_find(const libdb
 #define db_backend_handle_set_update(...) libdbo_backend_handle_set_update(__VA_ARGS__)
 #define db_backend_handle_set_delete(...) libdbo_backend_handle_set_delete(__VA_ARGS__)
 #define db_backend_handle_set_count(...) libdbo_backend_handle_set_count(__VA_ARGS__)
+#define db_backend_handle_set_upsert(...) libdbo_backend_handle_set_upsert(__VA_ARGS__)
+#define db_backend_handle_set_read_batch(...) libdbo_backend_handle_set_read_batch(__VA_ARGS__)
 #define db_backend_handle_set_free(...) libdbo_backend_handle_set_free(__VA_ARGS__)
 #define db_backend_handle_set_transaction_begin(...) libdbo_backend_handle_set_transaction_begin(__VA_ARGS__)
 #define db_backend_handle_set_transaction_commit(...) libdbo_backend_handle_set_transaction_commit(__VA_ARGS__)
@@ -889,8 +1023,10 @@ const libdbo_backend_meta_data_t* libdbo_backend_meta_data_list_find(const libdb
 #define db_backend_free(...) libdbo_backend_free(__VA_ARGS__)
 #define db_backend_name(...) libdbo_backend_name(__VA_ARGS__)
 #define db_backend_handle(...) libdbo_backend_handle(__VA_ARGS__)
+#define db_backend_stats(...) libdbo_backend_stats(__VA_ARGS__)
 #define db_backend_set_name(...) libdbo_backend_set_name(__VA_ARGS__)
 #define db_backend_set_handle(...) libdbo_backend_set_handle(__VA_ARGS__)
+#define db_backend_set_stats(...) libdbo_backend_set_stats(__VA_ARGS__)
 #define db_backend_not_empty(...) libdbo_backend_not_empty(__VA_ARGS__)
 #define db_backend_initialize(...) libdbo_backend_initialize(__VA_ARGS__)
 #define db_backend_shutdown(...) libdbo_backend_shutdown(__VA_ARGS__)
@@ -901,6 +1037,8 @@ const libdbo_backend_meta_data_t* libdbo_backend_meta_data_list_find(const libdb
 #define db_backend_update(...) libdbo_backend_update(__VA_ARGS__)
 #define db_backend_delete(...) libdbo_backend_delete(__VA_ARGS__)
 #define db_backend_count(...) libdbo_backend_count(__VA_ARGS__)
+#define db_backend_upsert(...) libdbo_backend_upsert(__VA_ARGS__)
+#define db_backend_read_batch(...) libdbo_backend_read_batch(__VA_ARGS__)
 #define db_backend_transaction_begin(...) libdbo_backend_transaction_begin(__VA_ARGS__)
 #define db_backend_transaction_commit(...) libdbo_backend_transaction_commit(__VA_ARGS__)
 #define db_backend_transaction_rollback(...) libdbo_backend_transaction_rollback(__VA_ARGS__)
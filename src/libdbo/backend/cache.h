@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2014 Jerry Lundström <lundstrom.jerry@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/** \file libdbo/backend/cache.h */
+/** \defgroup libdbo_backend_cache libdbo_backend_cache
+ * Database Backend Cache.
+ * These are the functions for creating a caching backend handle that wraps
+ * another backend.
+ */
+
+#ifndef libdbo_backend_cache_h
+#define libdbo_backend_cache_h
+
+#include <libdbo/backend.h>
+#include <libdbo/connection.h>
+
+/** \addtogroup libdbo_backend_cache */
+/** \{ */
+
+/**
+ * Default maximum number of cached reads and counts.
+ */
+#define LIBDBO_BACKEND_CACHE_DEFAULT_SIZE 1024
+/**
+ * Default number of seconds a cached read or count is used.
+ */
+#define LIBDBO_BACKEND_CACHE_DEFAULT_TTL 60
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Statistics of a cache backend.
+ */
+typedef struct libdbo_backend_cache_stats {
+    /** The number of reads and counts currently cached. */
+    size_t entries;
+    /** The number of reads and counts served from the cache. */
+    unsigned long hits;
+    /** The number of reads and counts sent to the wrapped backend. */
+    unsigned long misses;
+    /** The number of cached entries dropped because they were too old. */
+    unsigned long expired;
+    /** The number of cached entries dropped to make room for new ones. */
+    unsigned long evictions;
+    /** The number of writes that invalidated the cache of a table. */
+    unsigned long invalidations;
+} libdbo_backend_cache_stats_t;
+
+/**
+ * Create a new database backend handle that caches reads and counts of
+ * another backend.
+ *
+ * The configuration `cache_backend` names the backend to wrap, it is given
+ * the same configuration when connecting. Reads and counts are cached by the
+ * table, fields, joins and clauses, and served from the cache while they are
+ * less then `cache_ttl` seconds old, 0 disables the expiry. At most
+ * `cache_size` entries are kept, the least recently used is dropped first, and
+ * reads with more then `cache_max_results` results are not cached if that is
+ * set.
+ *
+ * Creates, updates, deletes and upserts are sent to the wrapped backend and
+ * invalidates every cached entry that uses the table written to, a rollback
+ * invalidates everything. Writes made through other connections are only seen
+ * once the entries expire.
+ * \return a libdbo_backend_handle_t pointer or NULL on error.
+ */
+libdbo_backend_handle_t* libdbo_backend_cache_new_handle(void);
+
+/**
+ * Get the statistics of the cache backend of a connection.
+ * \param[in] connection a libdbo_connection_t pointer.
+ * \param[out] stats a libdbo_backend_cache_stats_t pointer.
+ * \return LIBDBO_ERROR_* on failure or if the connection does not use the
+ * cache backend, otherwise LIBDBO_OK.
+ */
+int libdbo_backend_cache_stats(const libdbo_connection_t* connection, libdbo_backend_cache_stats_t* stats);
+
+/**
+ * Drop all cached entries of the cache backend of a connection.
+ * \param[in] connection a libdbo_connection_t pointer.
+ * \return LIBDBO_ERROR_* on failure or if the connection does not use the
+ * cache backend, otherwise LIBDBO_OK.
+ */
+int libdbo_backend_cache_flush(const libdbo_connection_t* connection);
+
+/** \} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#ifdef LIBDBO_SHORT_NAMES
+#define DB_BACKEND_CACHE_DEFAULT_SIZE 1024
+#define DB_BACKEND_CACHE_DEFAULT_TTL 60
+#define db_backend_cache_stats_t libdbo_backend_cache_stats_t
+#define db_backend_cache_new_handle(...) libdbo_backend_cache_new_handle(__VA_ARGS__)
+#define db_backend_cache_stats(...) libdbo_backend_cache_stats(__VA_ARGS__)
+#define db_backend_cache_flush(...) libdbo_backend_cache_flush(__VA_ARGS__)
+#endif
+#endif
+
+#endif
@@ -53,6 +53,16 @@ extern "C" {
 
 /**
  * Create a new database backend handle for CouchDB.
+ *
+ * The configuration `url` is required and points to the database. If the
+ * configuration `preload_design` is non-zero then the design documents that
+ * already exist in the database are loaded into the design document cache on
+ * connect so that reads using them do not need to create them.
+ *
+ * Reads with clauses are done with views by default, if the configuration
+ * `query` is `mango` then Mango queries are used instead and an index is
+ * created for the fields in clauses that are only AND'ed. The configuration
+ * `mango_limit` sets the maximum number of documents a Mango query returns.
  * \return a libdbo_backend_handle_t pointer or NULL on error.
  */
 libdbo_backend_handle_t* libdbo_backend_couchdb_new_handle(void);
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2014 Jerry Lundström <lundstrom.jerry@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/** \file libdbo/backend/lmdb.h */
+/** \defgroup libdbo_backend_lmdb libdbo_backend_lmdb
+ * Database Backend LMDB.
+ * These are the functions for creating a LMDB backend handle.
+ */
+
+#ifndef libdbo_backend_lmdb_h
+#define libdbo_backend_lmdb_h
+
+#include <libdbo/backend.h>
+
+/** \addtogroup libdbo_backend_lmdb */
+/** \{ */
+
+/**
+ * Default size in megabytes of the memory map and so the maximum size of the
+ * database.
+ */
+#define LIBDBO_BACKEND_LMDB_DEFAULT_MAPSIZE 1024
+/**
+ * Maximum number of tables and indexes in one database.
+ */
+#define LIBDBO_BACKEND_LMDB_MAXDBS 256
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Create a new database backend handle for LMDB.
+ *
+ * The configuration `file` is the database file, the lock file is created
+ * next to it with `-lock` appended. The configuration `mapsize` sets the size
+ * of the memory map in megabytes. Connections to the same file within a
+ * process share the LMDB environment.
+ *
+ * Each table is a sub-database of rows in a compact binary format keyed by
+ * the primary key, which is an unsigned 64-bit integer given out in sequence.
+ * The fields of a table are kept in the database so rows stay readable when
+ * fields are added. Revision fields are checked as in the SQL backends.
+ *
+ * The configurations `unique` and `index` are comma separated `table.field`
+ * lists of fields to keep an index sub-database for, the index of unique
+ * fields also makes creates and updates that would make two objects have
+ * the same value fail. Equal clauses on the primary key or an indexed field
+ * are looked up directly and all other clauses are matched while scanning
+ * the table.
+ *
+ * Transactions can be nested and are LMDB write transactions, reads outside
+ * of a transaction uses a read-only transaction that does not block or get
+ * blocked by writers.
+ * \return a libdbo_backend_handle_t pointer or NULL on error.
+ */
+libdbo_backend_handle_t* libdbo_backend_lmdb_new_handle(void);
+
+/** \} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#ifdef LIBDBO_SHORT_NAMES
+#define DB_BACKEND_LMDB_DEFAULT_MAPSIZE 1024
+#define DB_BACKEND_LMDB_MAXDBS 256
+#define db_backend_lmdb_new_handle(...) libdbo_backend_lmdb_new_handle(__VA_ARGS__)
+#endif
+#endif
+
+#endif
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2014 Jerry Lundström <lundstrom.jerry@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/** \file libdbo/backend/memory.h */
+/** \defgroup libdbo_backend_memory libdbo_backend_memory
+ * Database Backend Memory.
+ * These are the functions for creating an in-memory backend handle.
+ */
+
+#ifndef libdbo_backend_memory_h
+#define libdbo_backend_memory_h
+
+#include <libdbo/backend.h>
+
+/** \addtogroup libdbo_backend_memory */
+/** \{ */
+
+/**
+ * Initial number of buckets in the hash indexes, the indexes grow when they
+ * have more entries then buckets.
+ */
+#define LIBDBO_BACKEND_MEMORY_INDEX_SIZE 64
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Create a new database backend handle that keeps all tables in memory.
+ *
+ * Tables are created when first used by an object and live as long as the
+ * backend handle, they are not shared between connections. The primary key is
+ * an auto-incremented 64 bit integer and revision fields are checked as in the
+ * SQL backends.
+ *
+ * The primary key is always hash indexed. The configuration `unique` is a comma
+ * separated list of `table.field` that are also hash indexed, these fields
+ * must be unique and creates or updates that would make them not unique fail.
+ * \return a libdbo_backend_handle_t pointer or NULL on error.
+ */
+libdbo_backend_handle_t* libdbo_backend_memory_new_handle(void);
+
+/** \} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#ifdef LIBDBO_SHORT_NAMES
+#define DB_BACKEND_MEMORY_INDEX_SIZE 64
+#define db_backend_memory_new_handle(...) libdbo_backend_memory_new_handle(__VA_ARGS__)
+#endif
+#endif
+
+#endif
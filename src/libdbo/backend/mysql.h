@@ -67,6 +67,11 @@ extern "C" {
 
 /**
  * Create a new database backend handle for MySQL.
+ *
+ * If the configuration `slow_query` is set then any statement taking at least
+ * that many milliseconds to execute is logged as a warning with the SQL and
+ * the values bound unless `slow_query_redact` is non-zero. The output of
+ * `EXPLAIN` for it is logged when the statement is finished.
  * \return a libdbo_backend_handle_t pointer or NULL on error.
  */
 libdbo_backend_handle_t* libdbo_backend_mysql_new_handle(void);
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2014 Jerry Lundström <lundstrom.jerry@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/** \file libdbo/backend/postgresql.h */
+/** \defgroup libdbo_backend_postgresql libdbo_backend_postgresql
+ * Database Backend PostgreSQL.
+ * These are the functions for creating a PostgreSQL backend handle.
+ */
+
+#ifndef libdbo_backend_postgresql_h
+#define libdbo_backend_postgresql_h
+
+#include <libdbo/backend.h>
+
+/** \addtogroup libdbo_backend_postgresql */
+/** \{ */
+
+/**
+ * Default connection timeout for PostgreSQL.
+ */
+#define LIBDBO_BACKEND_POSTGRESQL_DEFAULT_TIMEOUT 30
+/**
+ * Maximum number of named prepared statements kept per connection, SQL that
+ * does not fit in the cache is executed as an unnamed statement.
+ */
+#define LIBDBO_BACKEND_POSTGRESQL_PREPARED_MAX 256
+/**
+ * Maximum number of statements queued in pipeline mode before the results are
+ * collected.
+ */
+#define LIBDBO_BACKEND_POSTGRESQL_PIPELINE_MAX 128
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Create a new database backend handle for PostgreSQL.
+ *
+ * The configurations `host`, `port`, `user`, `pass` and `db` are used to
+ * connect and `timeout` sets the connection timeout in seconds.
+ *
+ * If the configuration `pipeline` is non-zero then creates and updates done
+ * within a transaction are sent in pipeline mode without waiting for each
+ * result. The results are collected when the pipeline is full or before any
+ * other operation, so an error in a pipelined create or update is returned by
+ * the following operation or by the commit of the transaction.
+ *
+ * If the configuration `slow_query` is set then any statement, that is not
+ * pipelined, taking at least that many milliseconds to execute is logged as a
+ * warning with the SQL, the values bound unless `slow_query_redact` is
+ * non-zero, and the output of `EXPLAIN` for it.
+ * \return a libdbo_backend_handle_t pointer or NULL on error.
+ */
+libdbo_backend_handle_t* libdbo_backend_postgresql_new_handle(void);
+
+/** \} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#ifdef LIBDBO_SHORT_NAMES
+#define DB_BACKEND_POSTGRESQL_DEFAULT_TIMEOUT 30
+#define DB_BACKEND_POSTGRESQL_PREPARED_MAX 256
+#define DB_BACKEND_POSTGRESQL_PIPELINE_MAX 128
+#define db_backend_postgresql_new_handle(...) libdbo_backend_postgresql_new_handle(__VA_ARGS__)
+#endif
+#endif
+
+#endif
@@ -63,6 +63,11 @@ extern "C" {
 
 /**
  * Create a new database backend handle for SQLite.
+ *
+ * If the configuration `slow_query` is set then any step of a statement
+ * taking at least that many milliseconds is logged as a warning with the SQL,
+ * the values bound unless `slow_query_redact` is non-zero, and the output of
+ * `EXPLAIN QUERY PLAN` for it.
  * \return a libdbo_backend_handle_t pointer or NULL on error.
  */
 libdbo_backend_handle_t* libdbo_backend_sqlite_new_handle(void);
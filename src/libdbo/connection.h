@@ -68,6 +68,9 @@ typedef struct libdbo_connection libdbo_connection_t;
 #include <libdbo/object.h>
 #include <libdbo/join.h>
 #include <libdbo/clause.h>
+#include <libdbo/identity_map.h>
+#include <libdbo/lookup_filter.h>
+#include <libdbo/stats.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -77,6 +80,10 @@ extern "C" {
 struct libdbo_connection {
     const libdbo_configuration_list_t* configuration_list;
     libdbo_backend_t* backend;
+    libdbo_identity_map_t* identity_map;
+    libdbo_lookup_filter_t* lookup_filter;
+    char* clause_shape_log;
+    int transaction;
 };
 #endif
 
@@ -105,7 +112,18 @@ int libdbo_connection_set_configuration_list(libdbo_connection_t* connection, co
 
 /**
  * Setup the database connection, this verifies the information in the database
- * configuration list and allocated a database backend.
+ * configuration list and allocated a database backend. If the configuration
+ * `identity_map` is set to a number above zero then the connection keeps up to
+ * that many objects read by primary key and serves such reads from them, see
+ * libdbo_identity_map. If the configuration `lookup_filter` is set to a comma
+ * separated list of unique `table.field` then lookups on them that will not
+ * find anything are answered without the backend, see libdbo_lookup_filter.
+ * The configurations `lookup_filter_bits` and `lookup_negative_cache` set the
+ * minimum size of the Bloom filters and the size of the negative cache.
+ * If the configuration `clause_shape_log` is set to a file then the clause
+ * shapes of the reads and counts in the statistics of the backend are
+ * appended to it when the connection is deleted, see
+ * libdbo_stats_write_shapes().
  * \param[in] connection a libdbo_connection_t pointer.
  * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
  */
@@ -180,26 +198,107 @@ int libdbo_connection_delete(const libdbo_connection_t* connection, const libdbo
 int libdbo_connection_count(const libdbo_connection_t* connection, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list, size_t* count);
 
 /**
- * Begin a transaction for a database connection.
+ * Create an object in the database or update it if an object with the same
+ * unique fields, given as equal clauses in `clause_list`, already exists.
+ * \param[in] connection a libdbo_connection_t pointer.
+ * \param[in] object a libdbo_object_t pointer.
+ * \param[in] object_field_list a libdbo_object_field_list_t pointer.
+ * \param[in] value_set a libdbo_value_set_t pointer.
+ * \param[in] clause_list a libdbo_clause_list_t pointer.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_connection_upsert(const libdbo_connection_t* connection, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, const libdbo_clause_list_t* clause_list);
+
+/**
+ * Do `size` independent reads of objects from the database in one batch. Each
+ * read is described by the object in `objects` and the join and clause lists
+ * at the same position in `join_lists` and `clause_lists`, which may be NULL.
+ * Backends that support it have all the reads in flight at the same time. The
+ * result list of each read is stored at the same position in `result_lists`
+ * and on error no result lists are returned.
+ * \param[in] connection a libdbo_connection_t pointer.
+ * \param[in] size a size_t.
+ * \param[in] objects a libdbo_object_t pointer array.
+ * \param[in] join_lists a libdbo_join_list_t pointer array.
+ * \param[in] clause_lists a libdbo_clause_list_t pointer array.
+ * \param[out] result_lists a libdbo_result_list_t pointer array.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_connection_read_batch(const libdbo_connection_t* connection, size_t size, const libdbo_object_t** objects, const libdbo_join_list_t** join_lists, const libdbo_clause_list_t** clause_lists, libdbo_result_list_t** result_lists);
+
+/**
+ * Begin a transaction for a database connection. If a transaction has already
+ * been begun then a nested transaction is begun, if the backend supports it,
+ * which can be committed or rolled back without affecting the outer
+ * transaction. All objects in the identity map are dropped so that objects
+ * read before the transaction are not returned inside it.
  * \param[in] connection a libdbo_connection_t pointer.
  * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
  */
 int libdbo_connection_transaction_begin(const libdbo_connection_t* connection);
 
 /**
- * Commit a transaction for a database connection.
+ * Commit a transaction for a database connection. Committing a nested
+ * transaction only makes its changes part of the outer transaction. All
+ * objects in the identity map are dropped, they are only kept within a
+ * transaction.
  * \param[in] connection a libdbo_connection_t pointer.
  * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
  */
 int libdbo_connection_transaction_commit(const libdbo_connection_t* connection);
 
 /**
- * Roll back a transaction for a database connection.
+ * Roll back a transaction for a database connection. Rolling back a nested
+ * transaction only discards the changes made since it was begun. All objects
+ * in the identity map and lookup filter are dropped since they may have been
+ * read inside the transaction.
  * \param[in] connection a libdbo_connection_t pointer.
  * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
  */
 int libdbo_connection_transaction_rollback(const libdbo_connection_t* connection);
 
+/**
+ * Get the number of transactions begun on a database connection that have
+ * not yet been committed or rolled back, nested transactions included.
+ * \param[in] connection a libdbo_connection_t pointer.
+ * \return the number of open transactions, zero if none or on error.
+ */
+int libdbo_connection_transaction(const libdbo_connection_t* connection);
+
+/**
+ * Get the identity map of a database connection.
+ * \param[in] connection a libdbo_connection_t pointer.
+ * \return a libdbo_identity_map_t pointer or NULL on error or if the connection
+ * does not use an identity map.
+ */
+const libdbo_identity_map_t* libdbo_connection_identity_map(const libdbo_connection_t* connection);
+
+/**
+ * Get the lookup filter of a database connection.
+ * \param[in] connection a libdbo_connection_t pointer.
+ * \return a libdbo_lookup_filter_t pointer or NULL on error or if the connection
+ * does not use a lookup filter.
+ */
+const libdbo_lookup_filter_t* libdbo_connection_lookup_filter(const libdbo_connection_t* connection);
+
+/**
+ * Get the statistics of the operations a database connection has performed
+ * on its backend, reads answered by the identity map or the lookup filter are
+ * not counted.
+ * \param[in] connection a libdbo_connection_t pointer.
+ * \return a libdbo_stats_t pointer or NULL on error or if the connection has
+ * not been setup.
+ */
+libdbo_stats_t* libdbo_connection_stats(const libdbo_connection_t* connection);
+
+/**
+ * Drop all objects in the identity map of a database connection, used to
+ * forget objects between independent units of work.
+ * \param[in] connection a libdbo_connection_t pointer.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_connection_identity_map_clear(const libdbo_connection_t* connection);
+
 /** \} */
 
 #ifdef __cplusplus
@@ -220,9 +319,16 @@ int libdbo_connection_transaction_rollback(const libdbo_connection_t* connection
 #define db_connection_update(...) libdbo_connection_update(__VA_ARGS__)
 #define db_connection_delete(...) libdbo_connection_delete(__VA_ARGS__)
 #define db_connection_count(...) libdbo_connection_count(__VA_ARGS__)
+#define db_connection_upsert(...) libdbo_connection_upsert(__VA_ARGS__)
+#define db_connection_read_batch(...) libdbo_connection_read_batch(__VA_ARGS__)
 #define db_connection_transaction_begin(...) libdbo_connection_transaction_begin(__VA_ARGS__)
 #define db_connection_transaction_commit(...) libdbo_connection_transaction_commit(__VA_ARGS__)
 #define db_connection_transaction_rollback(...) libdbo_connection_transaction_rollback(__VA_ARGS__)
+#define db_connection_transaction(...) libdbo_connection_transaction(__VA_ARGS__)
+#define db_connection_identity_map(...) libdbo_connection_identity_map(__VA_ARGS__)
+#define db_connection_lookup_filter(...) libdbo_connection_lookup_filter(__VA_ARGS__)
+#define db_connection_stats(...) libdbo_connection_stats(__VA_ARGS__)
+#define db_connection_identity_map_clear(...) libdbo_connection_identity_map_clear(__VA_ARGS__)
 #endif
 #endif
 
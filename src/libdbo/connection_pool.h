@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2014 Jerry Lundström <lundstrom.jerry@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/** \file libdbo/connection_pool.h */
+/** \defgroup libdbo_connection_pool libdbo_connection_pool
+ * Database Connection Pool.
+ * These are the functions and container for handling a pool of database
+ * connections that can be shared between threads.
+ */
+
+#ifndef libdbo_connection_pool_h
+#define libdbo_connection_pool_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+struct libdbo_connection_pool;
+#endif
+
+/** \addtogroup libdbo_connection_pool */
+/** \{ */
+/**
+ * A database connection pool.
+ */
+typedef struct libdbo_connection_pool libdbo_connection_pool_t;
+/** \} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#include <libdbo/configuration.h>
+#include <libdbo/connection.h>
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \addtogroup libdbo_connection_pool */
+/** \{ */
+
+/**
+ * Function pointer for validating a connection before it is checked out of a
+ * database connection pool.
+ * \param[in] connection a libdbo_connection_t pointer.
+ * \param[in] user_data the user data given to
+ * libdbo_connection_pool_set_validate().
+ * \return LIBDBO_ERROR_* if the connection is not usable, otherwise LIBDBO_OK.
+ */
+typedef int (*libdbo_connection_pool_validate_t)(const libdbo_connection_t* connection, void* user_data);
+
+/**
+ * Statistics of a database connection pool.
+ */
+typedef struct libdbo_connection_pool_stats {
+    /** The number of connections open or being opened. */
+    size_t size;
+    /** The number of connections checked out. */
+    size_t in_use;
+    /** The number of connections waiting to be checked out. */
+    size_t idle;
+    /** The number of successful checkouts. */
+    unsigned long checkouts;
+    /** The number of checkouts that had to wait for a connection. */
+    unsigned long waits;
+    /** The number of timed checkouts that did not get a connection in time. */
+    unsigned long timeouts;
+    /** The number of connections opened. */
+    unsigned long created;
+    /** The number of idle connections closed because of the idle timeout. */
+    unsigned long evicted;
+    /** The number of connections closed because they failed validation or
+     * were discarded. */
+    unsigned long invalid;
+    /** The total time checkouts have waited, in microseconds. */
+    unsigned long long wait_usec;
+    /** The longest time a checkout has waited, in microseconds. */
+    unsigned long long max_wait_usec;
+} libdbo_connection_pool_stats_t;
+
+/**
+ * Create a new database connection pool and open the minimum number of
+ * connections. More connections are opened when needed up to the maximum
+ * number. Each connection is setup and connected with the configuration list,
+ * which is not copied and must be kept until the pool is deleted.
+ *
+ * By default a connection is validated on checkout by beginning and
+ * committing an empty transaction.
+ * \param[in] configuration_list a libdbo_configuration_list_t pointer.
+ * \param[in] min_size the number of connections to keep open.
+ * \param[in] max_size the maximum number of connections to open.
+ * \return a libdbo_connection_pool_t pointer or NULL on error.
+ */
+libdbo_connection_pool_t* libdbo_connection_pool_new(const libdbo_configuration_list_t* configuration_list, size_t min_size, size_t max_size);
+
+/**
+ * Delete a database connection pool and close all its connections, any
+ * connections checked out are also closed and may not be used afterwards.
+ * \param[in] connection_pool a libdbo_connection_pool_t pointer.
+ */
+void libdbo_connection_pool_free(libdbo_connection_pool_t* connection_pool);
+
+/**
+ * Set the number of seconds a connection may be idle before it is closed, the
+ * minimum number of connections are always kept open. Idle connections are
+ * closed on checkin or by libdbo_connection_pool_evict().
+ * \param[in] connection_pool a libdbo_connection_pool_t pointer.
+ * \param[in] idle_timeout the idle timeout in seconds, 0 disables it.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_connection_pool_set_idle_timeout(libdbo_connection_pool_t* connection_pool, unsigned int idle_timeout);
+
+/**
+ * Set the function used to validate a connection before it is checked out, a
+ * connection that fails validation is closed and another is used.
+ * \param[in] connection_pool a libdbo_connection_pool_t pointer.
+ * \param[in] validate a libdbo_connection_pool_validate_t function pointer,
+ * NULL disables validation.
+ * \param[in] user_data a pointer given to the function.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_connection_pool_set_validate(libdbo_connection_pool_t* connection_pool, libdbo_connection_pool_validate_t validate, void* user_data);
+
+/**
+ * Check out a connection from a database connection pool, waiting until one
+ * is available if the maximum number of connections are in use.
+ * \param[in] connection_pool a libdbo_connection_pool_t pointer.
+ * \return a libdbo_connection_t pointer or NULL on error.
+ */
+libdbo_connection_t* libdbo_connection_pool_checkout(libdbo_connection_pool_t* connection_pool);
+
+/**
+ * Check out a connection from a database connection pool, waiting at most
+ * the given time until one is available.
+ * \param[in] connection_pool a libdbo_connection_pool_t pointer.
+ * \param[in] timeout the time to wait in milliseconds.
+ * \return a libdbo_connection_t pointer or NULL on error or timeout.
+ */
+libdbo_connection_t* libdbo_connection_pool_checkout_timed(libdbo_connection_pool_t* connection_pool, unsigned int timeout);
+
+/**
+ * Check in a connection to the database connection pool it was checked out
+ * from. Transactions left open on it, nested ones included, are rolled back
+ * before it is made available again. If they can not be rolled back the
+ * connection is discarded as with libdbo_connection_pool_discard() and an
+ * error is returned.
+ * \param[in] connection_pool a libdbo_connection_pool_t pointer.
+ * \param[in] connection a libdbo_connection_t pointer.
+ * \return LIBDBO_ERROR_* on failure, if the connection is not checked out
+ * from the pool or if it was discarded, otherwise LIBDBO_OK.
+ */
+int libdbo_connection_pool_checkin(libdbo_connection_pool_t* connection_pool, libdbo_connection_t* connection);
+
+/**
+ * Close a connection that was checked out from a database connection pool
+ * instead of checking it in, used when the connection is known to be broken.
+ * \param[in] connection_pool a libdbo_connection_pool_t pointer.
+ * \param[in] connection a libdbo_connection_t pointer.
+ * \return LIBDBO_ERROR_* on failure or if the connection is not checked out
+ * from the pool, otherwise LIBDBO_OK.
+ */
+int libdbo_connection_pool_discard(libdbo_connection_pool_t* connection_pool, libdbo_connection_t* connection);
+
+/**
+ * Close the connections of a database connection pool that have been idle
+ * longer then the idle timeout.
+ * \param[in] connection_pool a libdbo_connection_pool_t pointer.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_connection_pool_evict(libdbo_connection_pool_t* connection_pool);
+
+/**
+ * Get the statistics of a database connection pool.
+ * \param[in] connection_pool a libdbo_connection_pool_t pointer.
+ * \param[out] stats a libdbo_connection_pool_stats_t pointer.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_connection_pool_stats(libdbo_connection_pool_t* connection_pool, libdbo_connection_pool_stats_t* stats);
+
+/** \} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#ifdef LIBDBO_SHORT_NAMES
+#define db_connection_pool_t libdbo_connection_pool_t
+#define db_connection_pool_validate_t libdbo_connection_pool_validate_t
+#define db_connection_pool_stats_t libdbo_connection_pool_stats_t
+#define db_connection_pool_new(...) libdbo_connection_pool_new(__VA_ARGS__)
+#define db_connection_pool_free(...) libdbo_connection_pool_free(__VA_ARGS__)
+#define db_connection_pool_set_idle_timeout(...) libdbo_connection_pool_set_idle_timeout(__VA_ARGS__)
+#define db_connection_pool_set_validate(...) libdbo_connection_pool_set_validate(__VA_ARGS__)
+#define db_connection_pool_checkout(...) libdbo_connection_pool_checkout(__VA_ARGS__)
+#define db_connection_pool_checkout_timed(...) libdbo_connection_pool_checkout_timed(__VA_ARGS__)
+#define db_connection_pool_checkin(...) libdbo_connection_pool_checkin(__VA_ARGS__)
+#define db_connection_pool_discard(...) libdbo_connection_pool_discard(__VA_ARGS__)
+#define db_connection_pool_evict(...) libdbo_connection_pool_evict(__VA_ARGS__)
+#define db_connection_pool_stats(...) libdbo_connection_pool_stats(__VA_ARGS__)
+#endif
+#endif
+
+#endif
@@ -53,6 +53,11 @@
  * A failed operation with an unknown error.
  */
 #define LIBDBO_ERROR_UNKNOWN 1
+/**
+ * A failed update or delete because the revision of the object did not match
+ * the one in the database, the object was changed by someone else.
+ */
+#define LIBDBO_ERROR_REVISION 2
 
 /**
  * Returns a null-terminated string containing the error message for the
@@ -68,6 +73,7 @@ const char* libdbo_errstr(int errno);
 #ifdef LIBDBO_SHORT_NAMES
 #define DB_OK 0
 #define DB_ERROR_UNKNOWN 1
+#define DB_ERROR_REVISION 2
 #define db_errstr(...) libdbo_errstr(__VA_ARGS__)
 #endif
 #endif
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2014 Jerry Lundström <lundstrom.jerry@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/** \file libdbo/identity_map.h */
+/** \defgroup libdbo_identity_map libdbo_identity_map
+ * Database Identity Map.
+ * These are the functions and container for handling the objects a
+ * connection has read by their primary key.
+ */
+
+#ifndef libdbo_identity_map_h
+#define libdbo_identity_map_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+struct libdbo_identity_map;
+#endif
+
+/** \addtogroup libdbo_identity_map */
+/** \{ */
+/**
+ * A database identity map, keeps the last results of reads by primary key
+ * for each table.
+ */
+typedef struct libdbo_identity_map libdbo_identity_map_t;
+/** \} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#include <libdbo/object.h>
+#include <libdbo/join.h>
+#include <libdbo/clause.h>
+#include <libdbo/result.h>
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \addtogroup libdbo_identity_map */
+/** \{ */
+
+/**
+ * Create a new database identity map.
+ * \param[in] size the maximum number of objects to keep, the least recently
+ * used is dropped first.
+ * \return a libdbo_identity_map_t pointer or NULL on error.
+ */
+libdbo_identity_map_t* libdbo_identity_map_new(size_t size);
+
+/**
+ * Delete a database identity map and all objects in it.
+ * \param[in] identity_map a libdbo_identity_map_t pointer.
+ */
+void libdbo_identity_map_free(libdbo_identity_map_t* identity_map);
+
+/**
+ * Drop all objects in a database identity map.
+ * \param[in] identity_map a libdbo_identity_map_t pointer.
+ */
+void libdbo_identity_map_clear(libdbo_identity_map_t* identity_map);
+
+/**
+ * Get the primary key value a read is for, that is a read without joins and
+ * with only one clause that is the primary key equal to a value.
+ * \param[in] object a libdbo_object_t pointer.
+ * \param[in] join_list a libdbo_join_list_t pointer.
+ * \param[in] clause_list a libdbo_clause_list_t pointer.
+ * \return a libdbo_value_t pointer or NULL if the read is not by primary key.
+ */
+const libdbo_value_t* libdbo_identity_map_primary_key(const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list);
+
+/**
+ * Get a copy of the result for a read by primary key from a database identity
+ * map.
+ * \param[in] identity_map a libdbo_identity_map_t pointer.
+ * \param[in] object a libdbo_object_t pointer.
+ * \param[in] join_list a libdbo_join_list_t pointer.
+ * \param[in] clause_list a libdbo_clause_list_t pointer.
+ * \return a libdbo_result_list_t pointer with one result or NULL if the object
+ * is not in the identity map or the read is not by primary key.
+ */
+libdbo_result_list_t* libdbo_identity_map_get(libdbo_identity_map_t* identity_map, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list);
+
+/**
+ * Add the result of a read by primary key to a database identity map, reads
+ * that are not by primary key or did not return exactly one result are
+ * ignored.
+ * \param[in] identity_map a libdbo_identity_map_t pointer.
+ * \param[in] object a libdbo_object_t pointer.
+ * \param[in] join_list a libdbo_join_list_t pointer.
+ * \param[in] clause_list a libdbo_clause_list_t pointer.
+ * \param[in] result_list a libdbo_result_list_t pointer, it must have been
+ * fully fetched.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_identity_map_put(libdbo_identity_map_t* identity_map, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list, const libdbo_result_list_t* result_list);
+
+/**
+ * Drop the objects a write can change from a database identity map, if the
+ * clause list selects by primary key only that object is dropped otherwise
+ * all objects of the table.
+ * \param[in] identity_map a libdbo_identity_map_t pointer.
+ * \param[in] object a libdbo_object_t pointer.
+ * \param[in] clause_list a libdbo_clause_list_t pointer.
+ */
+void libdbo_identity_map_invalidate(libdbo_identity_map_t* identity_map, const libdbo_object_t* object, const libdbo_clause_list_t* clause_list);
+
+/**
+ * Get the number of objects in a database identity map.
+ * \param[in] identity_map a libdbo_identity_map_t pointer.
+ * \return a size_t.
+ */
+size_t libdbo_identity_map_size(const libdbo_identity_map_t* identity_map);
+
+/**
+ * Get the number of reads served from a database identity map.
+ * \param[in] identity_map a libdbo_identity_map_t pointer.
+ * \return an unsigned long.
+ */
+unsigned long libdbo_identity_map_hits(const libdbo_identity_map_t* identity_map);
+
+/**
+ * Get the number of reads by primary key that was not in a database identity
+ * map.
+ * \param[in] identity_map a libdbo_identity_map_t pointer.
+ * \return an unsigned long.
+ */
+unsigned long libdbo_identity_map_misses(const libdbo_identity_map_t* identity_map);
+
+/** \} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#ifdef LIBDBO_SHORT_NAMES
+#define db_identity_map_t libdbo_identity_map_t
+#define db_identity_map_new(...) libdbo_identity_map_new(__VA_ARGS__)
+#define db_identity_map_free(...) libdbo_identity_map_free(__VA_ARGS__)
+#define db_identity_map_clear(...) libdbo_identity_map_clear(__VA_ARGS__)
+#define db_identity_map_primary_key(...) libdbo_identity_map_primary_key(__VA_ARGS__)
+#define db_identity_map_get(...) libdbo_identity_map_get(__VA_ARGS__)
+#define db_identity_map_put(...) libdbo_identity_map_put(__VA_ARGS__)
+#define db_identity_map_invalidate(...) libdbo_identity_map_invalidate(__VA_ARGS__)
+#define db_identity_map_size(...) libdbo_identity_map_size(__VA_ARGS__)
+#define db_identity_map_hits(...) libdbo_identity_map_hits(__VA_ARGS__)
+#define db_identity_map_misses(...) libdbo_identity_map_misses(__VA_ARGS__)
+#endif
+#endif
+
+#endif
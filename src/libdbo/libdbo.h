@@ -27,16 +27,23 @@
 
 /** \file libdbo/libdbo.h */
 
+#include <libdbo/async.h>
 #include <libdbo/backend.h>
 #include <libdbo/clause.h>
 #include <libdbo/configuration.h>
 #include <libdbo/connection.h>
+#include <libdbo/connection_pool.h>
 #include <libdbo/enum.h>
 #include <libdbo/error.h>
+#include <libdbo/identity_map.h>
 #include <libdbo/join.h>
+#include <libdbo/lookup_filter.h>
 #include <libdbo/mm.h>
 #include <libdbo/object.h>
 #include <libdbo/result.h>
+#include <libdbo/retry.h>
+#include <libdbo/stats.h>
+#include <libdbo/trace.h>
 #include <libdbo/type.h>
 #include <libdbo/value.h>
 #include <libdbo/log.h>
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2014 Jerry Lundström <lundstrom.jerry@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/** \file libdbo/lookup_filter.h */
+/** \defgroup libdbo_lookup_filter libdbo_lookup_filter
+ * Database Lookup Filter.
+ * These are the functions and container for handling the Bloom filters and
+ * negative cache a connection uses to answer lookups on unique fields that
+ * will not find anything without asking the backend.
+ */
+
+#ifndef libdbo_lookup_filter_h
+#define libdbo_lookup_filter_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+struct libdbo_lookup_filter;
+#endif
+
+/** \addtogroup libdbo_lookup_filter */
+/** \{ */
+/**
+ * A database lookup filter.
+ */
+typedef struct libdbo_lookup_filter libdbo_lookup_filter_t;
+/** \} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#include <libdbo/connection.h>
+#include <libdbo/object.h>
+#include <libdbo/join.h>
+#include <libdbo/clause.h>
+#include <libdbo/value.h>
+
+#include <stddef.h>
+
+/** \addtogroup libdbo_lookup_filter */
+/** \{ */
+
+/**
+ * Default number of bits in the Bloom filter of a field.
+ */
+#define LIBDBO_LOOKUP_FILTER_DEFAULT_BITS 1048576
+/**
+ * Default number of lookups that found nothing to remember.
+ */
+#define LIBDBO_LOOKUP_FILTER_DEFAULT_NEGATIVE_SIZE 1024
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Create a new database lookup filter.
+ * \param[in] fields a comma separated list of `table.field` to filter
+ * lookups on, the values of the fields should be unique.
+ * \param[in] bits the minimum number of bits in the Bloom filter of a field.
+ * \param[in] negative_size the number of lookups that found nothing to
+ * remember, 0 disables the negative cache.
+ * \return a libdbo_lookup_filter_t pointer or NULL on error.
+ */
+libdbo_lookup_filter_t* libdbo_lookup_filter_new(const char* fields, size_t bits, size_t negative_size);
+
+/**
+ * Delete a database lookup filter.
+ * \param[in] lookup_filter a libdbo_lookup_filter_t pointer.
+ */
+void libdbo_lookup_filter_free(libdbo_lookup_filter_t* lookup_filter);
+
+/**
+ * Forget everything in a database lookup filter, the Bloom filters are
+ * rebuilt on the next lookup.
+ * \param[in] lookup_filter a libdbo_lookup_filter_t pointer.
+ */
+void libdbo_lookup_filter_reset(libdbo_lookup_filter_t* lookup_filter);
+
+/**
+ * Check if a read or count is a lookup on a filtered field, that is a read
+ * without joins and with only one clause that is the field equal to a value.
+ * \param[in] lookup_filter a libdbo_lookup_filter_t pointer.
+ * \param[in] object a libdbo_object_t pointer.
+ * \param[in] join_list a libdbo_join_list_t pointer.
+ * \param[in] clause_list a libdbo_clause_list_t pointer.
+ * \return non-zero if it is a lookup on a filtered field, otherwise zero.
+ */
+int libdbo_lookup_filter_lookup(const libdbo_lookup_filter_t* lookup_filter, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list);
+
+/**
+ * Check if a lookup on a filtered field will certainly not find anything.
+ * The Bloom filter of the field is built by reading all objects of the table
+ * through the connection the first time it is needed.
+ * \param[in] lookup_filter a libdbo_lookup_filter_t pointer.
+ * \param[in] connection a libdbo_connection_t pointer.
+ * \param[in] object a libdbo_object_t pointer.
+ * \param[in] clause_list a libdbo_clause_list_t pointer.
+ * \return non-zero if the lookup will not find anything, otherwise zero.
+ */
+int libdbo_lookup_filter_miss(libdbo_lookup_filter_t* lookup_filter, const libdbo_connection_t* connection, const libdbo_object_t* object, const libdbo_clause_list_t* clause_list);
+
+/**
+ * Remember that a lookup on a filtered field did not find anything.
+ * \param[in] lookup_filter a libdbo_lookup_filter_t pointer.
+ * \param[in] object a libdbo_object_t pointer.
+ * \param[in] clause_list a libdbo_clause_list_t pointer.
+ */
+void libdbo_lookup_filter_add_miss(libdbo_lookup_filter_t* lookup_filter, const libdbo_object_t* object, const libdbo_clause_list_t* clause_list);
+
+/**
+ * Tell a database lookup filter about values written to a table by a create,
+ * update or upsert so that lookups on them are not filtered.
+ * \param[in] lookup_filter a libdbo_lookup_filter_t pointer.
+ * \param[in] object a libdbo_object_t pointer.
+ * \param[in] object_field_list a libdbo_object_field_list_t pointer.
+ * \param[in] value_set a libdbo_value_set_t pointer.
+ */
+void libdbo_lookup_filter_write(libdbo_lookup_filter_t* lookup_filter, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set);
+
+/**
+ * Get the number of lookups a database lookup filter has answered with its
+ * Bloom filters.
+ * \param[in] lookup_filter a libdbo_lookup_filter_t pointer.
+ * \return an unsigned long.
+ */
+unsigned long libdbo_lookup_filter_bloom_hits(const libdbo_lookup_filter_t* lookup_filter);
+
+/**
+ * Get the number of lookups a database lookup filter has answered with its
+ * negative cache.
+ * \param[in] lookup_filter a libdbo_lookup_filter_t pointer.
+ * \return an unsigned long.
+ */
+unsigned long libdbo_lookup_filter_negative_hits(const libdbo_lookup_filter_t* lookup_filter);
+
+/** \} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#ifdef LIBDBO_SHORT_NAMES
+#define DB_LOOKUP_FILTER_DEFAULT_BITS LIBDBO_LOOKUP_FILTER_DEFAULT_BITS
+#define DB_LOOKUP_FILTER_DEFAULT_NEGATIVE_SIZE LIBDBO_LOOKUP_FILTER_DEFAULT_NEGATIVE_SIZE
+#define db_lookup_filter_t libdbo_lookup_filter_t
+#define db_lookup_filter_new(...) libdbo_lookup_filter_new(__VA_ARGS__)
+#define db_lookup_filter_free(...) libdbo_lookup_filter_free(__VA_ARGS__)
+#define db_lookup_filter_reset(...) libdbo_lookup_filter_reset(__VA_ARGS__)
+#define db_lookup_filter_lookup(...) libdbo_lookup_filter_lookup(__VA_ARGS__)
+#define db_lookup_filter_miss(...) libdbo_lookup_filter_miss(__VA_ARGS__)
+#define db_lookup_filter_add_miss(...) libdbo_lookup_filter_add_miss(__VA_ARGS__)
+#define db_lookup_filter_write(...) libdbo_lookup_filter_write(__VA_ARGS__)
+#define db_lookup_filter_bloom_hits(...) libdbo_lookup_filter_bloom_hits(__VA_ARGS__)
+#define db_lookup_filter_negative_hits(...) libdbo_lookup_filter_negative_hits(__VA_ARGS__)
+#endif
+#endif
+
+#endif
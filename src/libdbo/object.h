@@ -423,6 +423,17 @@ int libdbo_object_delete(const libdbo_object_t* object, const libdbo_clause_list
  */
 int libdbo_object_count(const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list, size_t* count);
 
+/**
+ * Create an object in the database or update it if an object with the same
+ * unique fields, given as equal clauses in `clause_list`, already exists.
+ * \param[in] object a libdbo_object_t pointer.
+ * \param[in] object_field_list a libdbo_object_field_list_t pointer.
+ * \param[in] value_set a libdbo_value_set_t pointer.
+ * \param[in] clause_list a libdbo_clause_list_t pointer.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_object_upsert(const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, const libdbo_clause_list_t* clause_list);
+
 /** \} */
 
 #ifdef __cplusplus
@@ -470,6 +481,7 @@ int libdbo_object_count(const libdbo_object_t* object, const libdbo_join_list_t*
 #define db_object_update(...) libdbo_object_update(__VA_ARGS__)
 #define db_object_delete(...) libdbo_object_delete(__VA_ARGS__)
 #define db_object_count(...) libdbo_object_count(__VA_ARGS__)
+#define db_object_upsert(...) libdbo_object_upsert(__VA_ARGS__)
 #endif
 #endif
 
@@ -187,6 +187,7 @@ struct libdbo_result_list {
     void* next_data;
     size_t size;
     int begun;
+    int error;
 };
 #endif
 
@@ -232,6 +233,21 @@ int libdbo_result_list_copy(libdbo_result_list_t* result_list, const libdbo_resu
  */
 int libdbo_result_list_set_next(libdbo_result_list_t* result_list, libdbo_result_list_next_t next_function, void* next_data, size_t size);
 
+/**
+ * Replace the function pointer for fetching the next database result of a
+ * database result list that uses one, the previous function pointer and data
+ * are returned so that the new function can call them.
+ * \param[in] result_list a libdbo_result_list_t pointer.
+ * \param[in] next_function a libdbo_result_list_next_t function pointer.
+ * \param[in] next_data a void pointer.
+ * \param[out] wrapped_function a libdbo_result_list_next_t pointer to store the
+ * previous function pointer in.
+ * \param[out] wrapped_data a void pointer pointer to store the previous data
+ * in.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_result_list_wrap_next(libdbo_result_list_t* result_list, libdbo_result_list_next_t next_function, void* next_data, libdbo_result_list_next_t* wrapped_function, void** wrapped_data);
+
 /**
  * Add a database result to a database result list, this will takes over the
  * ownership of the database result.
@@ -266,6 +282,25 @@ const libdbo_result_t* libdbo_result_list_next(libdbo_result_list_t* result_list
  */
 size_t libdbo_result_list_size(const libdbo_result_list_t* result_list);
 
+/**
+ * Set the error of a database result list, this is used by backends that
+ * fetch the results while the list is walked to tell that a result could not
+ * be fetched and that the results are incomplete.
+ * \param[in] result_list a libdbo_result_list_t pointer.
+ * \param[in] error a LIBDBO_ERROR_* error code.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_result_list_set_error(libdbo_result_list_t* result_list, int error);
+
+/**
+ * Get the error of a database result list, a NULL returned from
+ * libdbo_result_list_begin() or libdbo_result_list_next() is the end of the
+ * list only if there is no error.
+ * \param[in] result_list a libdbo_result_list_t pointer.
+ * \return a LIBDBO_ERROR_* error code or LIBDBO_OK if there is no error.
+ */
+int libdbo_result_list_error(const libdbo_result_list_t* result_list);
+
 /**
  * Make sure that all objects in this database result list is loaded into memory
  * so that libdbo_result_list_begin() can be used to iterate over the list multiple
@@ -300,10 +335,13 @@ int libdbo_result_list_fetch_all(libdbo_result_list_t* result_list);
 #define db_result_list_free(...) libdbo_result_list_free(__VA_ARGS__)
 #define db_result_list_copy(...) libdbo_result_list_copy(__VA_ARGS__)
 #define db_result_list_set_next(...) libdbo_result_list_set_next(__VA_ARGS__)
+#define db_result_list_wrap_next(...) libdbo_result_list_wrap_next(__VA_ARGS__)
 #define db_result_list_add(...) libdbo_result_list_add(__VA_ARGS__)
 #define db_result_list_begin(...) libdbo_result_list_begin(__VA_ARGS__)
 #define db_result_list_next(...) libdbo_result_list_next(__VA_ARGS__)
 #define db_result_list_size(...) libdbo_result_list_size(__VA_ARGS__)
+#define db_result_list_set_error(...) libdbo_result_list_set_error(__VA_ARGS__)
+#define db_result_list_error(...) libdbo_result_list_error(__VA_ARGS__)
 #define db_result_list_fetch_all(...) libdbo_result_list_fetch_all(__VA_ARGS__)
 #endif
 #endif
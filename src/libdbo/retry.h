@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2014 Jerry Lundström <lundstrom.jerry@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/** \file libdbo/retry.h */
+/** \defgroup libdbo_retry libdbo_retry
+ * Database Retry.
+ * These are the functions and container for retrying updates of objects with
+ * a revision that conflict with updates made by someone else.
+ */
+
+#ifndef libdbo_retry_h
+#define libdbo_retry_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+struct libdbo_retry;
+#endif
+
+/** \addtogroup libdbo_retry */
+/** \{ */
+/**
+ * A database retry executor.
+ */
+typedef struct libdbo_retry libdbo_retry_t;
+/** \} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#include <libdbo/value.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \addtogroup libdbo_retry */
+/** \{ */
+
+/**
+ * Default number of attempts made before giving up.
+ */
+#define LIBDBO_RETRY_DEFAULT_ATTEMPTS 5
+/**
+ * Default delay before the first retry, in milliseconds.
+ */
+#define LIBDBO_RETRY_DEFAULT_BASE_DELAY 10
+/**
+ * Default maximum delay before a retry, in milliseconds.
+ */
+#define LIBDBO_RETRY_DEFAULT_MAX_DELAY 1000
+
+/**
+ * Function pointer for fetching an object by its primary key, the object
+ * should be replaced with what is currently in the database. The generated
+ * `*_get_by_id()` functions can be used through a small wrapper.
+ * \param[in] object the object given to libdbo_retry_update().
+ * \param[in] id a libdbo_value_t pointer to the primary key of the object.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+typedef int (*libdbo_retry_fetch_t)(void* object, const libdbo_value_t* id);
+
+/**
+ * Function pointer for applying a change to an object and updating it in the
+ * database. It is called again after the object has been fetched if the
+ * update failed with LIBDBO_ERROR_REVISION so it must apply the change to
+ * what the object currently is and not to what it was on the first attempt.
+ * \param[in] object the object given to libdbo_retry_update().
+ * \param[in] user_data the user data given to libdbo_retry_update().
+ * \param[in] attempt the number of the attempt, starting at 0.
+ * \return LIBDBO_ERROR_REVISION if the object was changed by someone else,
+ * any other LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+typedef int (*libdbo_retry_update_t)(void* object, void* user_data, unsigned int attempt);
+
+/**
+ * Statistics of a database retry executor.
+ */
+typedef struct libdbo_retry_stats {
+    /** The number of calls to libdbo_retry_update(). */
+    unsigned long calls;
+    /** The number of calls that succeeded. */
+    unsigned long successes;
+    /** The number of calls that failed with an error other than a revision
+     * conflict. */
+    unsigned long failures;
+    /** The number of attempts that failed because of a revision conflict. */
+    unsigned long conflicts;
+    /** The number of attempts made after a revision conflict. */
+    unsigned long retries;
+    /** The number of calls that gave up because all attempts conflicted. */
+    unsigned long exhausted;
+    /** The total time slept before retries, in microseconds. */
+    unsigned long long sleep_usec;
+} libdbo_retry_stats_t;
+
+/**
+ * Create a new database retry executor. The delay before retry `n`, starting
+ * at 1, is a random time between zero and the base delay doubled `n - 1`
+ * times but never more than the maximum delay.
+ * \param[in] attempts the maximum number of attempts, at least 1.
+ * \param[in] base_delay the delay before the first retry, in milliseconds, 0
+ * retries without delay.
+ * \param[in] max_delay the maximum delay before a retry, in milliseconds.
+ * \return a libdbo_retry_t pointer or NULL on error.
+ */
+libdbo_retry_t* libdbo_retry_new(unsigned int attempts, unsigned int base_delay, unsigned int max_delay);
+
+/**
+ * Delete a database retry executor.
+ * \param[in] retry a libdbo_retry_t pointer.
+ */
+void libdbo_retry_free(libdbo_retry_t* retry);
+
+/**
+ * Update an object with a revision, retrying if it was changed by someone
+ * else. The update function is called and if it fails with
+ * LIBDBO_ERROR_REVISION the executor sleeps, fetches the object by its
+ * primary key and calls the update function again until it succeeds, fails
+ * with another error or the maximum number of attempts has been made. A
+ * retry executor may be used by multiple threads at the same time.
+ * \param[in] retry a libdbo_retry_t pointer.
+ * \param[in] object a pointer to the object, passed to the functions.
+ * \param[in] id a libdbo_value_t pointer to the primary key of the object, it
+ * is copied before the first attempt so it may point into the object.
+ * \param[in] fetch a libdbo_retry_fetch_t function pointer.
+ * \param[in] update a libdbo_retry_update_t function pointer.
+ * \param[in] user_data a void pointer that will be given to the update
+ * function.
+ * \return LIBDBO_ERROR_REVISION if all attempts conflicted, any other
+ * LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_retry_update(libdbo_retry_t* retry, void* object, const libdbo_value_t* id, libdbo_retry_fetch_t fetch, libdbo_retry_update_t update, void* user_data);
+
+/**
+ * Get the statistics of a database retry executor.
+ * \param[in] retry a libdbo_retry_t pointer.
+ * \param[out] stats a libdbo_retry_stats_t pointer to store the statistics
+ * in.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_retry_stats(libdbo_retry_t* retry, libdbo_retry_stats_t* stats);
+
+/** \} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#ifdef LIBDBO_SHORT_NAMES
+#define DB_RETRY_DEFAULT_ATTEMPTS LIBDBO_RETRY_DEFAULT_ATTEMPTS
+#define DB_RETRY_DEFAULT_BASE_DELAY LIBDBO_RETRY_DEFAULT_BASE_DELAY
+#define DB_RETRY_DEFAULT_MAX_DELAY LIBDBO_RETRY_DEFAULT_MAX_DELAY
+#define db_retry_t libdbo_retry_t
+#define db_retry_fetch_t libdbo_retry_fetch_t
+#define db_retry_update_t libdbo_retry_update_t
+#define db_retry_stats_t libdbo_retry_stats_t
+#define db_retry_new(...) libdbo_retry_new(__VA_ARGS__)
+#define db_retry_free(...) libdbo_retry_free(__VA_ARGS__)
+#define db_retry_update(...) libdbo_retry_update(__VA_ARGS__)
+#define db_retry_stats(...) libdbo_retry_stats(__VA_ARGS__)
+#endif
+#endif
+
+#endif
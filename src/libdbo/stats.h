@@ -0,0 +1,385 @@
+/*
+ * Copyright (c) 2014 Jerry Lundström <lundstrom.jerry@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/** \file libdbo/stats.h */
+/** \defgroup libdbo_stats libdbo_stats
+ * Database Statistics.
+ * These are the functions and container for the counters and latency
+ * histograms every database backend keeps of the operations it performs.
+ *
+ * The statistics also count the clause shapes of the reads and counts on
+ * each table, that is which fields the clauses compare and how. A clause
+ * shape is the fields compared for equality followed by the fields compared
+ * by range, each sorted by name and separated by a comma, with `=` after a
+ * field compared for equality and `<` after a field compared by range, for
+ * example `group_id=,name=,rev<`. Clauses that an index can not be used for,
+ * on other tables or joined with OR are left out.
+ */
+
+#ifndef libdbo_stats_h
+#define libdbo_stats_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+struct libdbo_stats;
+#endif
+
+/** \addtogroup libdbo_stats */
+/** \{ */
+/**
+ * Database statistics.
+ */
+typedef struct libdbo_stats libdbo_stats_t;
+/** \} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#include <libdbo/result.h>
+#include <libdbo/clause.h>
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \addtogroup libdbo_stats */
+/** \{ */
+
+/**
+ * The operations that statistics are kept for.
+ */
+typedef enum {
+    /**
+     * libdbo_backend_create().
+     */
+    LIBDBO_STATS_CREATE,
+    /**
+     * libdbo_backend_read().
+     */
+    LIBDBO_STATS_READ,
+    /**
+     * libdbo_backend_update().
+     */
+    LIBDBO_STATS_UPDATE,
+    /**
+     * libdbo_backend_delete().
+     */
+    LIBDBO_STATS_DELETE,
+    /**
+     * libdbo_backend_count().
+     */
+    LIBDBO_STATS_COUNT,
+    /**
+     * libdbo_backend_upsert().
+     */
+    LIBDBO_STATS_UPSERT,
+    /**
+     * libdbo_backend_read_batch().
+     */
+    LIBDBO_STATS_READ_BATCH,
+    /**
+     * libdbo_backend_transaction_begin().
+     */
+    LIBDBO_STATS_TRANSACTION_BEGIN,
+    /**
+     * libdbo_backend_transaction_commit().
+     */
+    LIBDBO_STATS_TRANSACTION_COMMIT,
+    /**
+     * libdbo_backend_transaction_rollback().
+     */
+    LIBDBO_STATS_TRANSACTION_ROLLBACK,
+    /**
+     * The number of operations, not an operation.
+     */
+    LIBDBO_STATS_OPERATIONS
+} libdbo_stats_operation_t;
+
+/**
+ * The number of buckets for each power of two in a latency histogram, this
+ * gives a precision of 1/16 of the value.
+ */
+#define LIBDBO_STATS_HISTOGRAM_SUB_BUCKETS 16
+/**
+ * The number of buckets in a latency histogram, latencies of up to 2^36
+ * microseconds are recorded and longer ones are counted in the last bucket.
+ */
+#define LIBDBO_STATS_HISTOGRAM_BUCKETS 528
+
+/**
+ * A latency histogram in microseconds with log-linear buckets, each power of
+ * two is divided into LIBDBO_STATS_HISTOGRAM_SUB_BUCKETS linear buckets.
+ */
+typedef struct libdbo_stats_histogram {
+    /** The number of latencies recorded in each bucket. */
+    unsigned long buckets[LIBDBO_STATS_HISTOGRAM_BUCKETS];
+} libdbo_stats_histogram_t;
+
+/**
+ * The counters of an operation.
+ */
+typedef struct libdbo_stats_counters {
+    /** The number of calls. */
+    unsigned long calls;
+    /** The number of calls that failed. */
+    unsigned long errors;
+    /** The number of rows returned by reads. */
+    unsigned long long rows;
+    /** The number of bytes of text in the rows returned by reads. */
+    unsigned long long text_bytes;
+    /** The total time of all calls, in microseconds. */
+    unsigned long long total_usec;
+    /** The longest time of a call, in microseconds. */
+    unsigned long long max_usec;
+    /** The latency histogram of the calls. */
+    libdbo_stats_histogram_t latency;
+} libdbo_stats_counters_t;
+
+/**
+ * Function pointer for walking the statistics of the tables.
+ * \param[in] table a null-terminated string with the name of the table.
+ * \param[in] operation a libdbo_stats_operation_t.
+ * \param[in] counters a libdbo_stats_counters_t pointer.
+ * \param[in] user_data the user data given to libdbo_stats_foreach().
+ */
+typedef void (*libdbo_stats_foreach_t)(const char* table, libdbo_stats_operation_t operation, const libdbo_stats_counters_t* counters, void* user_data);
+
+/**
+ * Function pointer for walking the clause shapes of the tables.
+ * \param[in] table a null-terminated string with the name of the table.
+ * \param[in] shape a null-terminated string with the clause shape.
+ * \param[in] calls the number of reads and counts with the clause shape.
+ * \param[in] rows the number of rows returned by the reads and counted by the
+ * counts.
+ * \param[in] user_data the user data given to libdbo_stats_shape_foreach().
+ */
+typedef void (*libdbo_stats_shape_foreach_t)(const char* table, const char* shape, unsigned long calls, unsigned long long rows, void* user_data);
+
+/**
+ * Create new database statistics.
+ * \return a libdbo_stats_t pointer or NULL on error.
+ */
+libdbo_stats_t* libdbo_stats_new(void);
+
+/**
+ * Delete database statistics. If result lists recorded with
+ * libdbo_stats_record_result_list() are still being walked the statistics are
+ * deleted when the last of them is freed.
+ * \param[in] stats a libdbo_stats_t pointer.
+ */
+void libdbo_stats_free(libdbo_stats_t* stats);
+
+/**
+ * Reset all counters and histograms of database statistics to zero.
+ * \param[in] stats a libdbo_stats_t pointer.
+ */
+void libdbo_stats_reset(libdbo_stats_t* stats);
+
+/**
+ * Record a call of an operation.
+ * \param[in] stats a libdbo_stats_t pointer.
+ * \param[in] operation a libdbo_stats_operation_t.
+ * \param[in] table a null-terminated string with the name of the table or
+ * NULL if the operation is not on a table.
+ * \param[in] usec the time of the call in microseconds.
+ * \param[in] error non-zero if the call failed.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_stats_record(libdbo_stats_t* stats, libdbo_stats_operation_t operation, const char* table, unsigned long long usec, int error);
+
+/**
+ * Record a call of an operation that returned a result list, a NULL result
+ * list is recorded as a failed call. The rows and bytes of text of a result
+ * list that fetches the results from the backend as they are walked are
+ * counted when the result list is finished with, so it must not outlive the
+ * statistics.
+ * \param[in] stats a libdbo_stats_t pointer.
+ * \param[in] operation a libdbo_stats_operation_t.
+ * \param[in] table a null-terminated string with the name of the table.
+ * \param[in] usec the time of the call in microseconds.
+ * \param[in] result_list a libdbo_result_list_t pointer.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_stats_record_result_list(libdbo_stats_t* stats, libdbo_stats_operation_t operation, const char* table, unsigned long long usec, libdbo_result_list_t* result_list);
+
+/**
+ * Record a call of libdbo_backend_read() like
+ * libdbo_stats_record_result_list() and count the clause shape of the clause
+ * list, the rows returned are added to it.
+ * \param[in] stats a libdbo_stats_t pointer.
+ * \param[in] table a null-terminated string with the name of the table or
+ * NULL to not count the clause shape.
+ * \param[in] clause_list a libdbo_clause_list_t pointer or NULL if the read
+ * had no clauses.
+ * \param[in] usec the time of the call in microseconds.
+ * \param[in] result_list a libdbo_result_list_t pointer.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_stats_record_read(libdbo_stats_t* stats, const char* table, const libdbo_clause_list_t* clause_list, unsigned long long usec, libdbo_result_list_t* result_list);
+
+/**
+ * Record a call of libdbo_backend_count() and, if it did not fail, count the
+ * clause shape of the clause list with the rows counted.
+ * \param[in] stats a libdbo_stats_t pointer.
+ * \param[in] table a null-terminated string with the name of the table or
+ * NULL to not count the clause shape.
+ * \param[in] clause_list a libdbo_clause_list_t pointer or NULL if the count
+ * had no clauses.
+ * \param[in] usec the time of the call in microseconds.
+ * \param[in] error non-zero if the call failed.
+ * \param[in] count the number of rows counted.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_stats_record_count(libdbo_stats_t* stats, const char* table, const libdbo_clause_list_t* clause_list, unsigned long long usec, int error, size_t count);
+
+/**
+ * Get the counters of an operation over all tables.
+ * \param[in] stats a libdbo_stats_t pointer.
+ * \param[in] operation a libdbo_stats_operation_t.
+ * \param[out] counters a libdbo_stats_counters_t pointer to store the
+ * counters in.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_stats_operation(libdbo_stats_t* stats, libdbo_stats_operation_t operation, libdbo_stats_counters_t* counters);
+
+/**
+ * Get the counters of an operation on a table, they are all zero if the
+ * operation has not been performed on the table.
+ * \param[in] stats a libdbo_stats_t pointer.
+ * \param[in] table a null-terminated string with the name of the table.
+ * \param[in] operation a libdbo_stats_operation_t.
+ * \param[out] counters a libdbo_stats_counters_t pointer to store the
+ * counters in.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_stats_table(libdbo_stats_t* stats, const char* table, libdbo_stats_operation_t operation, libdbo_stats_counters_t* counters);
+
+/**
+ * Walk the counters of all operations performed on each table. The
+ * statistics are locked while walking so the function must not use them.
+ * \param[in] stats a libdbo_stats_t pointer.
+ * \param[in] function a libdbo_stats_foreach_t function pointer.
+ * \param[in] user_data a void pointer that will be given to the function.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_stats_foreach(libdbo_stats_t* stats, libdbo_stats_foreach_t function, void* user_data);
+
+/**
+ * Walk the clause shapes of the reads and counts on each table. The
+ * statistics are locked while walking so the function must not use them.
+ * \param[in] stats a libdbo_stats_t pointer.
+ * \param[in] function a libdbo_stats_shape_foreach_t function pointer.
+ * \param[in] user_data a void pointer that will be given to the function.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_stats_shape_foreach(libdbo_stats_t* stats, libdbo_stats_shape_foreach_t function, void* user_data);
+
+/**
+ * Append the clause shapes of the reads and counts on each table to a file,
+ * one line for each with the table, clause shape, calls and rows separated by
+ * a tab. This is the log read by `dbo-index-advisor`.
+ * \param[in] stats a libdbo_stats_t pointer.
+ * \param[in] path a null-terminated string with the path of the file.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+int libdbo_stats_write_shapes(libdbo_stats_t* stats, const char* path);
+
+/**
+ * Get the name of an operation.
+ * \param[in] operation a libdbo_stats_operation_t.
+ * \return a null-terminated string or NULL if the operation is not valid.
+ */
+const char* libdbo_stats_operation_name(libdbo_stats_operation_t operation);
+
+/**
+ * Get the number of latencies recorded in a latency histogram.
+ * \param[in] histogram a libdbo_stats_histogram_t pointer.
+ * \return an unsigned long.
+ */
+unsigned long libdbo_stats_histogram_count(const libdbo_stats_histogram_t* histogram);
+
+/**
+ * Get the latency at a percentile of a latency histogram, this is the
+ * highest latency of the bucket that holds the percentile.
+ * \param[in] histogram a libdbo_stats_histogram_t pointer.
+ * \param[in] percentile the percentile between 0 and 100.
+ * \return the latency in microseconds or 0 if the histogram is empty.
+ */
+unsigned long long libdbo_stats_histogram_percentile(const libdbo_stats_histogram_t* histogram, double percentile);
+
+/** \} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#ifdef LIBDBO_SHORT_NAMES
+#define DB_STATS_CREATE LIBDBO_STATS_CREATE
+#define DB_STATS_READ LIBDBO_STATS_READ
+#define DB_STATS_UPDATE LIBDBO_STATS_UPDATE
+#define DB_STATS_DELETE LIBDBO_STATS_DELETE
+#define DB_STATS_COUNT LIBDBO_STATS_COUNT
+#define DB_STATS_UPSERT LIBDBO_STATS_UPSERT
+#define DB_STATS_READ_BATCH LIBDBO_STATS_READ_BATCH
+#define DB_STATS_TRANSACTION_BEGIN LIBDBO_STATS_TRANSACTION_BEGIN
+#define DB_STATS_TRANSACTION_COMMIT LIBDBO_STATS_TRANSACTION_COMMIT
+#define DB_STATS_TRANSACTION_ROLLBACK LIBDBO_STATS_TRANSACTION_ROLLBACK
+#define DB_STATS_OPERATIONS LIBDBO_STATS_OPERATIONS
+#define DB_STATS_HISTOGRAM_SUB_BUCKETS LIBDBO_STATS_HISTOGRAM_SUB_BUCKETS
+#define DB_STATS_HISTOGRAM_BUCKETS LIBDBO_STATS_HISTOGRAM_BUCKETS
+#define db_stats_t libdbo_stats_t
+#define db_stats_operation_t libdbo_stats_operation_t
+#define db_stats_histogram_t libdbo_stats_histogram_t
+#define db_stats_counters_t libdbo_stats_counters_t
+#define db_stats_foreach_t libdbo_stats_foreach_t
+#define db_stats_shape_foreach_t libdbo_stats_shape_foreach_t
+#define db_stats_new(...) libdbo_stats_new(__VA_ARGS__)
+#define db_stats_free(...) libdbo_stats_free(__VA_ARGS__)
+#define db_stats_reset(...) libdbo_stats_reset(__VA_ARGS__)
+#define db_stats_record(...) libdbo_stats_record(__VA_ARGS__)
+#define db_stats_record_result_list(...) libdbo_stats_record_result_list(__VA_ARGS__)
+#define db_stats_record_read(...) libdbo_stats_record_read(__VA_ARGS__)
+#define db_stats_record_count(...) libdbo_stats_record_count(__VA_ARGS__)
+#define db_stats_operation(...) libdbo_stats_operation(__VA_ARGS__)
+#define db_stats_table(...) libdbo_stats_table(__VA_ARGS__)
+#define db_stats_foreach(...) libdbo_stats_foreach(__VA_ARGS__)
+#define db_stats_shape_foreach(...) libdbo_stats_shape_foreach(__VA_ARGS__)
+#define db_stats_write_shapes(...) libdbo_stats_write_shapes(__VA_ARGS__)
+#define db_stats_operation_name(...) libdbo_stats_operation_name(__VA_ARGS__)
+#define db_stats_histogram_count(...) libdbo_stats_histogram_count(__VA_ARGS__)
+#define db_stats_histogram_percentile(...) libdbo_stats_histogram_percentile(__VA_ARGS__)
+#endif
+#endif
+
+#endif
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2014 Jerry Lundström <lundstrom.jerry@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/** \file libdbo/trace.h */
+/** \defgroup libdbo_trace libdbo_trace
+ * Database Tracing.
+ * These are the functions and container for the tracing hook the backends
+ * call just before and after executing a statement in the database.
+ */
+
+#ifndef libdbo_trace_h
+#define libdbo_trace_h
+
+#include <libdbo/stats.h>
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \addtogroup libdbo_trace */
+/** \{ */
+
+/**
+ * The phase of a traced call.
+ */
+typedef enum {
+    /**
+     * Just before the statement is executed.
+     */
+    LIBDBO_TRACE_BEGIN,
+    /**
+     * Just after the statement was executed, `rows` and `status` are set.
+     */
+    LIBDBO_TRACE_END
+} libdbo_trace_phase_t;
+
+/**
+ * A traced call, the same event is given to the hook for both phases of a
+ * call.
+ */
+typedef struct libdbo_trace_event {
+    /** The name of the backend. */
+    const char* backend;
+    /** The operation the statement is executed for. */
+    libdbo_stats_operation_t operation;
+    /** The table of the operation or NULL if not on a table. */
+    const char* table;
+    /** The SQL text or the CouchDB URL or NULL if not known. */
+    const char* statement;
+    /** The number of values bound to the statement. */
+    size_t binds;
+    /** The number of rows returned or changed, if known. */
+    unsigned long long rows;
+    /** LIBDBO_ERROR_* if the call failed, otherwise LIBDBO_OK. */
+    int status;
+    /** Free for the hook to use between the phases of a call. */
+    void* hook_data;
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    void (*hook)(libdbo_trace_phase_t, struct libdbo_trace_event*, void*);
+    void* user_data;
+#endif
+} libdbo_trace_event_t;
+
+/**
+ * Function pointer for the tracing hook. It is called from the thread doing
+ * the call and must not use the connection being traced.
+ * \param[in] phase a libdbo_trace_phase_t.
+ * \param[in] event a libdbo_trace_event_t pointer.
+ * \param[in] user_data the user data given to libdbo_trace_set_hook().
+ */
+typedef void (*libdbo_trace_hook_t)(libdbo_trace_phase_t phase, libdbo_trace_event_t* event, void* user_data);
+
+/**
+ * Set the tracing hook for all backends, this should be done before any
+ * connections are used since it is not synchronized with the backends.
+ * \param[in] hook a libdbo_trace_hook_t function pointer or NULL to remove the
+ * hook.
+ * \param[in] user_data a void pointer that will be given to the hook.
+ */
+void libdbo_trace_set_hook(libdbo_trace_hook_t hook, void* user_data);
+
+/**
+ * Start tracing a call, for use by the backends through
+ * LIBDBO_TRACE_CALL_BEGIN(). The hook is remembered in the event so that the
+ * end of the call goes to the same hook.
+ * \param[in] event a libdbo_trace_event_t pointer with the backend, operation,
+ * table, statement and binds set.
+ * \return non-zero if the call is traced, otherwise zero.
+ */
+int libdbo_trace_begin(libdbo_trace_event_t* event);
+
+/**
+ * End tracing a call, for use by the backends through
+ * LIBDBO_TRACE_CALL_END().
+ * \param[in] event a libdbo_trace_event_t pointer given to
+ * libdbo_trace_begin().
+ * \param[in] rows the number of rows returned or changed, if known.
+ * \param[in] status LIBDBO_ERROR_* if the call failed, otherwise LIBDBO_OK.
+ */
+void libdbo_trace_end(libdbo_trace_event_t* event, unsigned long long rows, int status);
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+extern libdbo_trace_hook_t __libdbo_trace_hook;
+#endif
+
+/**
+ * Evaluates to non-zero if a hook is set, for backends that need to keep
+ * something around only for the hook.
+ */
+#if defined(USE_LIBDBO_TRACE)
+#define LIBDBO_TRACE_HOOKED() (__libdbo_trace_hook != NULL)
+#else
+#define LIBDBO_TRACE_HOOKED() 0
+#endif
+
+/**
+ * Start tracing a call if a hook is set, evaluates to non-zero if the call is
+ * traced. The event is only filled in when traced and nothing is compiled in
+ * if libdbo was configured without tracing.
+ */
+#if defined(USE_LIBDBO_TRACE)
+#define LIBDBO_TRACE_CALL_BEGIN(event, backend_name, trace_operation, trace_table, trace_statement, trace_binds) \
+    (__libdbo_trace_hook \
+        && ((event)->backend = (backend_name), \
+            (event)->operation = (trace_operation), \
+            (event)->table = (trace_table), \
+            (event)->statement = (trace_statement), \
+            (event)->binds = (trace_binds), \
+            libdbo_trace_begin(event)))
+#else
+#define LIBDBO_TRACE_CALL_BEGIN(event, backend_name, trace_operation, trace_table, trace_statement, trace_binds) ((void)(event), 0)
+#endif
+
+/**
+ * End tracing a call that LIBDBO_TRACE_CALL_BEGIN() evaluated to non-zero for.
+ */
+#if defined(USE_LIBDBO_TRACE)
+#define LIBDBO_TRACE_CALL_END(event, trace_rows, trace_status) libdbo_trace_end((event), (trace_rows), (trace_status))
+#else
+#define LIBDBO_TRACE_CALL_END(event, trace_rows, trace_status) ((void)(event))
+#endif
+
+/** \} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#ifdef LIBDBO_SHORT_NAMES
+#define DB_TRACE_BEGIN LIBDBO_TRACE_BEGIN
+#define DB_TRACE_END LIBDBO_TRACE_END
+#define DB_TRACE_HOOKED LIBDBO_TRACE_HOOKED
+#define DB_TRACE_CALL_BEGIN LIBDBO_TRACE_CALL_BEGIN
+#define DB_TRACE_CALL_END LIBDBO_TRACE_CALL_END
+#define db_trace_phase_t libdbo_trace_phase_t
+#define db_trace_event_t libdbo_trace_event_t
+#define db_trace_hook_t libdbo_trace_hook_t
+#define db_trace_set_hook(...) libdbo_trace_set_hook(__VA_ARGS__)
+#define db_trace_begin(...) libdbo_trace_begin(__VA_ARGS__)
+#define db_trace_end(...) libdbo_trace_end(__VA_ARGS__)
+#endif
+#endif
+
+#endif
@@ -0,0 +1,761 @@
+/*
+ * Copyright (c) 2014 Jerry Lundström <lundstrom.jerry@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "libdbo/async.h"
+#include "libdbo/error.h"
+
+#include "libdbo/connection_pool.h"
+#include "libdbo/mm.h"
+
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+
+/**
+ * The operations a future can hold.
+ */
+#define LIBDBO_ASYNC_CREATE 1
+#define LIBDBO_ASYNC_READ 2
+#define LIBDBO_ASYNC_UPDATE 3
+#define LIBDBO_ASYNC_DELETE 4
+#define LIBDBO_ASYNC_COUNT 5
+#define LIBDBO_ASYNC_TRANSACTION_BEGIN 6
+#define LIBDBO_ASYNC_TRANSACTION_COMMIT 7
+#define LIBDBO_ASYNC_TRANSACTION_ROLLBACK 8
+
+/**
+ * A future is referenced by both the submitter and the worker, the last one
+ * to release it deletes it.
+ */
+struct libdbo_async_future {
+    libdbo_async_future_t* next;
+    int operation;
+    const libdbo_object_t* object;
+    const libdbo_object_field_list_t* object_field_list;
+    const libdbo_value_set_t* value_set;
+    const libdbo_join_list_t* join_list;
+    const libdbo_clause_list_t* clause_list;
+    libdbo_async_callback_t callback;
+    void* user_data;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int references;
+    int done;
+    int status;
+    libdbo_result_list_t* result_list;
+    size_t count;
+};
+
+static libdbo_mm_t __async_future_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_async_future_t));
+
+/**
+ * A worker thread with its own connection and queue of futures, `transaction`
+ * is the depth of transactions begun through the queue and is only used by the
+ * worker thread.
+ */
+typedef struct libdbo_async_worker {
+    libdbo_async_t* async;
+    pthread_t thread;
+    int started;
+    libdbo_connection_t* connection;
+    int transaction;
+    pthread_cond_t cond;
+    libdbo_async_future_t* first;
+    libdbo_async_future_t* last;
+    size_t queued;
+} libdbo_async_worker_t;
+
+/**
+ * The workers share one lock for their queues.
+ */
+struct libdbo_async {
+    libdbo_connection_pool_t* connection_pool;
+    libdbo_async_worker_t* workers;
+    size_t workers_size;
+    pthread_mutex_t lock;
+    int stop;
+    size_t group_commit_size;
+    unsigned int group_commit_delay;
+};
+
+static libdbo_mm_t __async_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_async_t));
+
+static void __async_future_release(libdbo_async_future_t* future) {
+    int references;
+
+    pthread_mutex_lock(&(future->lock));
+    references = --future->references;
+    pthread_mutex_unlock(&(future->lock));
+
+    if (!references) {
+        if (future->result_list) {
+            libdbo_result_list_free(future->result_list);
+        }
+        pthread_cond_destroy(&(future->cond));
+        pthread_mutex_destroy(&(future->lock));
+        libdbo_mm_delete(&__async_future_alloc, future);
+    }
+}
+
+static void __async_execute(const libdbo_connection_t* connection, libdbo_async_future_t* future) {
+    switch (future->operation) {
+    case LIBDBO_ASYNC_CREATE:
+        future->status = libdbo_connection_create(connection, future->object, future->object_field_list, future->value_set);
+        break;
+
+    case LIBDBO_ASYNC_READ:
+        future->status = LIBDBO_ERROR_UNKNOWN;
+        if ((future->result_list = libdbo_connection_read(connection, future->object, future->join_list, future->clause_list))) {
+            if (libdbo_result_list_fetch_all(future->result_list)) {
+                libdbo_result_list_free(future->result_list);
+                future->result_list = NULL;
+                break;
+            }
+            future->status = LIBDBO_OK;
+        }
+        break;
+
+    case LIBDBO_ASYNC_UPDATE:
+        future->status = libdbo_connection_update(connection, future->object, future->object_field_list, future->value_set, future->clause_list);
+        break;
+
+    case LIBDBO_ASYNC_DELETE:
+        future->status = libdbo_connection_delete(connection, future->object, future->clause_list);
+        break;
+
+    case LIBDBO_ASYNC_COUNT:
+        future->status = libdbo_connection_count(connection, future->object, future->join_list, future->clause_list, &(future->count));
+        break;
+
+    case LIBDBO_ASYNC_TRANSACTION_BEGIN:
+        future->status = libdbo_connection_transaction_begin(connection);
+        break;
+
+    case LIBDBO_ASYNC_TRANSACTION_COMMIT:
+        future->status = libdbo_connection_transaction_commit(connection);
+        break;
+
+    case LIBDBO_ASYNC_TRANSACTION_ROLLBACK:
+        future->status = libdbo_connection_transaction_rollback(connection);
+        break;
+
+    default:
+        future->status = LIBDBO_ERROR_UNKNOWN;
+        break;
+    }
+}
+
+static void __async_complete(libdbo_async_future_t* future) {
+    pthread_mutex_lock(&(future->lock));
+    future->done = 1;
+    pthread_cond_broadcast(&(future->cond));
+    pthread_mutex_unlock(&(future->lock));
+    if (future->callback) {
+        future->callback(future, future->user_data);
+    }
+    __async_future_release(future);
+}
+
+static int __async_is_write(const libdbo_async_future_t* future) {
+    return future->operation == LIBDBO_ASYNC_CREATE
+        || future->operation == LIBDBO_ASYNC_UPDATE
+        || future->operation == LIBDBO_ASYNC_DELETE;
+}
+
+/**
+ * Count the writes at the head of the queue of a worker, at most the group
+ * commit size. Must be called with the lock held.
+ */
+static size_t __async_writes(const libdbo_async_t* async, const libdbo_async_worker_t* worker) {
+    const libdbo_async_future_t* future;
+    size_t writes = 0;
+
+    for (future = worker->first; future && __async_is_write(future) && writes < async->group_commit_size; future = future->next) {
+        writes++;
+    }
+    return writes;
+}
+
+/**
+ * Take the writes at the head of the queue of a worker for a group commit,
+ * waits for more writes until there are enough of them or the delay since the
+ * first has passed. Must be called with the lock held.
+ */
+static libdbo_async_future_t* __async_take_group(libdbo_async_t* async, libdbo_async_worker_t* worker) {
+    libdbo_async_future_t* first;
+    libdbo_async_future_t* last;
+    struct timespec deadline;
+    size_t writes;
+
+    if (clock_gettime(CLOCK_REALTIME, &deadline)) {
+        deadline.tv_sec = 0;
+        deadline.tv_nsec = 0;
+    }
+    deadline.tv_sec += async->group_commit_delay / 1000;
+    deadline.tv_nsec += (long)(async->group_commit_delay % 1000) * 1000000;
+    if (deadline.tv_nsec > 999999999) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    for (;;) {
+        writes = __async_writes(async, worker);
+        if (writes >= async->group_commit_size || writes < worker->queued || async->stop) {
+            break;
+        }
+        if (pthread_cond_timedwait(&(worker->cond), &(async->lock), &deadline)) {
+            writes = __async_writes(async, worker);
+            break;
+        }
+    }
+
+    if (!writes) {
+        writes = 1;
+    }
+    first = last = worker->first;
+    worker->queued -= writes;
+    while (--writes) {
+        last = last->next;
+    }
+    if (!(worker->first = last->next)) {
+        worker->last = NULL;
+    }
+    last->next = NULL;
+    return first;
+}
+
+/**
+ * Execute a group of writes in one transaction, each write in a nested
+ * transaction of its own so that a failed write does not affect the others.
+ * If the transaction can not be begun the writes are executed one by one and
+ * if it can not be committed all writes that had not already failed fail with
+ * the error of the commit.
+ */
+static void __async_execute_group(const libdbo_connection_t* connection, libdbo_async_future_t* group) {
+    libdbo_async_future_t* future;
+    int ret;
+
+    if (libdbo_connection_transaction_begin(connection)) {
+        for (future = group; future; future = future->next) {
+            __async_execute(connection, future);
+        }
+        return;
+    }
+
+    for (future = group; future; future = future->next) {
+        if (libdbo_connection_transaction_begin(connection)) {
+            __async_execute(connection, future);
+            continue;
+        }
+        __async_execute(connection, future);
+        if (future->status) {
+            libdbo_connection_transaction_rollback(connection);
+        }
+        else if ((ret = libdbo_connection_transaction_commit(connection))) {
+            future->status = ret;
+        }
+    }
+
+    if ((ret = libdbo_connection_transaction_commit(connection))) {
+        libdbo_connection_transaction_rollback(connection);
+        for (future = group; future; future = future->next) {
+            if (future->status == LIBDBO_OK) {
+                future->status = ret;
+            }
+        }
+    }
+}
+
+static void* __async_worker(void* data) {
+    libdbo_async_worker_t* worker = (libdbo_async_worker_t*)data;
+    libdbo_async_t* async = worker->async;
+    libdbo_async_future_t* future;
+    libdbo_async_future_t* next;
+
+    pthread_mutex_lock(&(async->lock));
+    for (;;) {
+        while (!worker->first && !async->stop) {
+            pthread_cond_wait(&(worker->cond), &(async->lock));
+        }
+        if (!(future = worker->first)) {
+            break;
+        }
+
+        if (async->group_commit_size > 1 && !worker->transaction && __async_is_write(future)) {
+            future = __async_take_group(async, worker);
+            pthread_mutex_unlock(&(async->lock));
+
+            __async_execute_group(worker->connection, future);
+            for (; future; future = next) {
+                next = future->next;
+                future->next = NULL;
+                __async_complete(future);
+            }
+
+            pthread_mutex_lock(&(async->lock));
+            continue;
+        }
+
+        if (!(worker->first = future->next)) {
+            worker->last = NULL;
+        }
+        future->next = NULL;
+        worker->queued--;
+        pthread_mutex_unlock(&(async->lock));
+
+        __async_execute(worker->connection, future);
+        if (!future->status) {
+            if (future->operation == LIBDBO_ASYNC_TRANSACTION_BEGIN) {
+                worker->transaction++;
+            }
+            else if (worker->transaction
+                && (future->operation == LIBDBO_ASYNC_TRANSACTION_COMMIT
+                    || future->operation == LIBDBO_ASYNC_TRANSACTION_ROLLBACK))
+            {
+                worker->transaction--;
+            }
+        }
+        __async_complete(future);
+
+        pthread_mutex_lock(&(async->lock));
+    }
+    pthread_mutex_unlock(&(async->lock));
+
+    return NULL;
+}
+
+static libdbo_async_future_t* __async_submit(libdbo_async_t* async, unsigned int affinity, libdbo_async_future_t* future) {
+    libdbo_async_worker_t* worker;
+    size_t i;
+
+    if (pthread_mutex_init(&(future->lock), NULL)) {
+        libdbo_mm_delete(&__async_future_alloc, future);
+        return NULL;
+    }
+    if (pthread_cond_init(&(future->cond), NULL)) {
+        pthread_mutex_destroy(&(future->lock));
+        libdbo_mm_delete(&__async_future_alloc, future);
+        return NULL;
+    }
+    future->references = 2;
+
+    if (pthread_mutex_lock(&(async->lock))) {
+        pthread_cond_destroy(&(future->cond));
+        pthread_mutex_destroy(&(future->lock));
+        libdbo_mm_delete(&__async_future_alloc, future);
+        return NULL;
+    }
+    if (async->stop) {
+        pthread_mutex_unlock(&(async->lock));
+        pthread_cond_destroy(&(future->cond));
+        pthread_mutex_destroy(&(future->lock));
+        libdbo_mm_delete(&__async_future_alloc, future);
+        return NULL;
+    }
+
+    if (affinity == LIBDBO_ASYNC_ANY_WORKER) {
+        worker = &(async->workers[0]);
+        for (i = 1; i < async->workers_size; i++) {
+            if (async->workers[i].queued < worker->queued) {
+                worker = &(async->workers[i]);
+            }
+        }
+    }
+    else {
+        worker = &(async->workers[affinity % async->workers_size]);
+    }
+
+    if (worker->last) {
+        worker->last->next = future;
+    }
+    else {
+        worker->first = future;
+    }
+    worker->last = future;
+    worker->queued++;
+    pthread_cond_signal(&(worker->cond));
+    pthread_mutex_unlock(&(async->lock));
+
+    return future;
+}
+
+static libdbo_async_future_t* __async_future_new(int operation, libdbo_async_callback_t callback, void* user_data) {
+    libdbo_async_future_t* future =
+        (libdbo_async_future_t*)libdbo_mm_new0(&__async_future_alloc);
+
+    if (future) {
+        future->operation = operation;
+        future->callback = callback;
+        future->user_data = user_data;
+    }
+    return future;
+}
+
+/* DB ASYNC */
+
+libdbo_async_t* libdbo_async_new(const libdbo_configuration_list_t* configuration_list, size_t workers) {
+    libdbo_async_t* async;
+    size_t i;
+
+    if (!configuration_list) {
+        return NULL;
+    }
+    if (!workers) {
+        return NULL;
+    }
+
+    if (!(async = (libdbo_async_t*)libdbo_mm_new0(&__async_alloc))) {
+        return NULL;
+    }
+    if (pthread_mutex_init(&(async->lock), NULL)) {
+        libdbo_mm_delete(&__async_alloc, async);
+        return NULL;
+    }
+    if (!(async->workers = (libdbo_async_worker_t*)calloc(workers, sizeof(libdbo_async_worker_t)))
+        || !(async->connection_pool = libdbo_connection_pool_new(configuration_list, workers, workers))
+        || libdbo_connection_pool_set_validate(async->connection_pool, NULL, NULL))
+    {
+        libdbo_async_free(async);
+        return NULL;
+    }
+
+    for (i = 0; i < workers; i++) {
+        libdbo_async_worker_t* worker = &(async->workers[i]);
+
+        worker->async = async;
+        if (!(worker->connection = libdbo_connection_pool_checkout(async->connection_pool))) {
+            libdbo_async_free(async);
+            return NULL;
+        }
+        if (pthread_cond_init(&(worker->cond), NULL)) {
+            libdbo_connection_pool_checkin(async->connection_pool, worker->connection);
+            worker->connection = NULL;
+            libdbo_async_free(async);
+            return NULL;
+        }
+        async->workers_size++;
+        if (pthread_create(&(worker->thread), NULL, __async_worker, worker)) {
+            libdbo_async_free(async);
+            return NULL;
+        }
+        worker->started = 1;
+    }
+
+    return async;
+}
+
+void libdbo_async_free(libdbo_async_t* async) {
+    size_t i;
+
+    if (async) {
+        pthread_mutex_lock(&(async->lock));
+        async->stop = 1;
+        for (i = 0; i < async->workers_size; i++) {
+            pthread_cond_signal(&(async->workers[i].cond));
+        }
+        pthread_mutex_unlock(&(async->lock));
+
+        for (i = 0; i < async->workers_size; i++) {
+            libdbo_async_worker_t* worker = &(async->workers[i]);
+
+            if (worker->started) {
+                pthread_join(worker->thread, NULL);
+            }
+            pthread_cond_destroy(&(worker->cond));
+            libdbo_connection_pool_checkin(async->connection_pool, worker->connection);
+        }
+        if (async->connection_pool) {
+            libdbo_connection_pool_free(async->connection_pool);
+        }
+        if (async->workers) {
+            free(async->workers);
+        }
+        pthread_mutex_destroy(&(async->lock));
+        libdbo_mm_delete(&__async_alloc, async);
+    }
+}
+
+int libdbo_async_set_group_commit(libdbo_async_t* async, size_t size, unsigned int delay) {
+    if (!async) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (pthread_mutex_lock(&(async->lock))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    async->group_commit_size = size;
+    async->group_commit_delay = delay;
+    pthread_mutex_unlock(&(async->lock));
+    return LIBDBO_OK;
+}
+
+size_t libdbo_async_workers(const libdbo_async_t* async) {
+    if (!async) {
+        return 0;
+    }
+
+    return async->workers_size;
+}
+
+libdbo_async_future_t* libdbo_async_create(libdbo_async_t* async, unsigned int affinity, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, libdbo_async_callback_t callback, void* user_data) {
+    libdbo_async_future_t* future;
+
+    if (!async) {
+        return NULL;
+    }
+    if (!object) {
+        return NULL;
+    }
+    if (!object_field_list) {
+        return NULL;
+    }
+    if (!value_set) {
+        return NULL;
+    }
+
+    if (!(future = __async_future_new(LIBDBO_ASYNC_CREATE, callback, user_data))) {
+        return NULL;
+    }
+    future->object = object;
+    future->object_field_list = object_field_list;
+    future->value_set = value_set;
+    return __async_submit(async, affinity, future);
+}
+
+libdbo_async_future_t* libdbo_async_read(libdbo_async_t* async, unsigned int affinity, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list, libdbo_async_callback_t callback, void* user_data) {
+    libdbo_async_future_t* future;
+
+    if (!async) {
+        return NULL;
+    }
+    if (!object) {
+        return NULL;
+    }
+
+    if (!(future = __async_future_new(LIBDBO_ASYNC_READ, callback, user_data))) {
+        return NULL;
+    }
+    future->object = object;
+    future->join_list = join_list;
+    future->clause_list = clause_list;
+    return __async_submit(async, affinity, future);
+}
+
+libdbo_async_future_t* libdbo_async_update(libdbo_async_t* async, unsigned int affinity, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, const libdbo_clause_list_t* clause_list, libdbo_async_callback_t callback, void* user_data) {
+    libdbo_async_future_t* future;
+
+    if (!async) {
+        return NULL;
+    }
+    if (!object) {
+        return NULL;
+    }
+    if (!object_field_list) {
+        return NULL;
+    }
+    if (!value_set) {
+        return NULL;
+    }
+
+    if (!(future = __async_future_new(LIBDBO_ASYNC_UPDATE, callback, user_data))) {
+        return NULL;
+    }
+    future->object = object;
+    future->object_field_list = object_field_list;
+    future->value_set = value_set;
+    future->clause_list = clause_list;
+    return __async_submit(async, affinity, future);
+}
+
+libdbo_async_future_t* libdbo_async_delete(libdbo_async_t* async, unsigned int affinity, const libdbo_object_t* object, const libdbo_clause_list_t* clause_list, libdbo_async_callback_t callback, void* user_data) {
+    libdbo_async_future_t* future;
+
+    if (!async) {
+        return NULL;
+    }
+    if (!object) {
+        return NULL;
+    }
+
+    if (!(future = __async_future_new(LIBDBO_ASYNC_DELETE, callback, user_data))) {
+        return NULL;
+    }
+    future->object = object;
+    future->clause_list = clause_list;
+    return __async_submit(async, affinity, future);
+}
+
+libdbo_async_future_t* libdbo_async_count(libdbo_async_t* async, unsigned int affinity, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list, libdbo_async_callback_t callback, void* user_data) {
+    libdbo_async_future_t* future;
+
+    if (!async) {
+        return NULL;
+    }
+    if (!object) {
+        return NULL;
+    }
+
+    if (!(future = __async_future_new(LIBDBO_ASYNC_COUNT, callback, user_data))) {
+        return NULL;
+    }
+    future->object = object;
+    future->join_list = join_list;
+    future->clause_list = clause_list;
+    return __async_submit(async, affinity, future);
+}
+
+libdbo_async_future_t* libdbo_async_transaction_begin(libdbo_async_t* async, unsigned int affinity, libdbo_async_callback_t callback, void* user_data) {
+    libdbo_async_future_t* future;
+
+    if (!async) {
+        return NULL;
+    }
+    if (affinity == LIBDBO_ASYNC_ANY_WORKER) {
+        return NULL;
+    }
+
+    if (!(future = __async_future_new(LIBDBO_ASYNC_TRANSACTION_BEGIN, callback, user_data))) {
+        return NULL;
+    }
+    return __async_submit(async, affinity, future);
+}
+
+libdbo_async_future_t* libdbo_async_transaction_commit(libdbo_async_t* async, unsigned int affinity, libdbo_async_callback_t callback, void* user_data) {
+    libdbo_async_future_t* future;
+
+    if (!async) {
+        return NULL;
+    }
+    if (affinity == LIBDBO_ASYNC_ANY_WORKER) {
+        return NULL;
+    }
+
+    if (!(future = __async_future_new(LIBDBO_ASYNC_TRANSACTION_COMMIT, callback, user_data))) {
+        return NULL;
+    }
+    return __async_submit(async, affinity, future);
+}
+
+libdbo_async_future_t* libdbo_async_transaction_rollback(libdbo_async_t* async, unsigned int affinity, libdbo_async_callback_t callback, void* user_data) {
+    libdbo_async_future_t* future;
+
+    if (!async) {
+        return NULL;
+    }
+    if (affinity == LIBDBO_ASYNC_ANY_WORKER) {
+        return NULL;
+    }
+
+    if (!(future = __async_future_new(LIBDBO_ASYNC_TRANSACTION_ROLLBACK, callback, user_data))) {
+        return NULL;
+    }
+    return __async_submit(async, affinity, future);
+}
+
+/* DB ASYNC FUTURE */
+
+void libdbo_async_future_free(libdbo_async_future_t* future) {
+    if (future) {
+        __async_future_release(future);
+    }
+}
+
+int libdbo_async_future_done(libdbo_async_future_t* future) {
+    int done;
+
+    if (!future) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&(future->lock));
+    done = future->done;
+    pthread_mutex_unlock(&(future->lock));
+    return done;
+}
+
+int libdbo_async_future_wait(libdbo_async_future_t* future) {
+    if (!future) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (pthread_mutex_lock(&(future->lock))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    while (!future->done) {
+        if (pthread_cond_wait(&(future->cond), &(future->lock))) {
+            pthread_mutex_unlock(&(future->lock));
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+    pthread_mutex_unlock(&(future->lock));
+    return LIBDBO_OK;
+}
+
+int libdbo_async_future_status(libdbo_async_future_t* future) {
+    int status;
+
+    if (!future) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    pthread_mutex_lock(&(future->lock));
+    status = future->done ? future->status : LIBDBO_ERROR_UNKNOWN;
+    pthread_mutex_unlock(&(future->lock));
+    return status;
+}
+
+libdbo_result_list_t* libdbo_async_future_take_result_list(libdbo_async_future_t* future) {
+    libdbo_result_list_t* result_list = NULL;
+
+    if (!future) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&(future->lock));
+    if (future->done) {
+        result_list = future->result_list;
+        future->result_list = NULL;
+    }
+    pthread_mutex_unlock(&(future->lock));
+    return result_list;
+}
+
+size_t libdbo_async_future_count(libdbo_async_future_t* future) {
+    size_t count = 0;
+
+    if (!future) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&(future->lock));
+    if (future->done) {
+        count = future->count;
+    }
+    pthread_mutex_unlock(&(future->lock));
+    return count;
+}
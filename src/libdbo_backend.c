@@ -45,12 +45,21 @@
 #if defined(HAVE_MYSQL)
 #include "libdbo/backend/mysql.h"
 #endif
+#if defined(HAVE_POSTGRESQL)
+#include "libdbo/backend/postgresql.h"
+#endif
+#if defined(HAVE_LMDB)
+#include "libdbo/backend/lmdb.h"
+#endif
+#include "libdbo/backend/memory.h"
+#include "libdbo/backend/cache.h"
 #include "libdbo/error.h"
 
 #include "libdbo/mm.h"
 
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 /* DB BACKEND HANDLE */
 
@@ -207,6 +216,67 @@ int libdbo_backend_handle_count(const libdbo_backend_handle_t* backend_handle, c
     return backend_handle->count_function((void*)backend_handle->data, object, join_list, clause_list, count);
 }
 
+int libdbo_backend_handle_upsert(const libdbo_backend_handle_t* backend_handle, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, const libdbo_clause_list_t* clause_list) {
+    if (!backend_handle) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object_field_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!value_set) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!clause_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_handle->upsert_function) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    return backend_handle->upsert_function((void*)backend_handle->data, object, object_field_list, value_set, clause_list);
+}
+
+int libdbo_backend_handle_read_batch(const libdbo_backend_handle_t* backend_handle, size_t size, const libdbo_object_t** objects, const libdbo_join_list_t** join_lists, const libdbo_clause_list_t** clause_lists, libdbo_result_list_t** result_lists) {
+    size_t i;
+
+    if (!backend_handle) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!objects) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!result_lists) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    for (i = 0; i < size; i++) {
+        if (!objects[i]) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        result_lists[i] = NULL;
+    }
+
+    if (backend_handle->read_batch_function) {
+        return backend_handle->read_batch_function((void*)backend_handle->data, size, objects, join_lists, clause_lists, result_lists);
+    }
+
+    if (!backend_handle->read_function) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    for (i = 0; i < size; i++) {
+        if (!(result_lists[i] = backend_handle->read_function((void*)backend_handle->data, objects[i], join_lists ? join_lists[i] : NULL, clause_lists ? clause_lists[i] : NULL))) {
+            while (i--) {
+                libdbo_result_list_free(result_lists[i]);
+                result_lists[i] = NULL;
+            }
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+    return LIBDBO_OK;
+}
+
 int libdbo_backend_handle_transaction_begin(const libdbo_backend_handle_t* backend_handle) {
     if (!backend_handle) {
         return LIBDBO_ERROR_UNKNOWN;
@@ -329,6 +399,24 @@ int libdbo_backend_handle_set_count(libdbo_backend_handle_t* backend_handle, lib
     return LIBDBO_OK;
 }
 
+int libdbo_backend_handle_set_upsert(libdbo_backend_handle_t* backend_handle, libdbo_backend_handle_upsert_t upsert_function) {
+    if (!backend_handle) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    backend_handle->upsert_function = upsert_function;
+    return LIBDBO_OK;
+}
+
+int libdbo_backend_handle_set_read_batch(libdbo_backend_handle_t* backend_handle, libdbo_backend_handle_read_batch_t read_batch_function) {
+    if (!backend_handle) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    backend_handle->read_batch_function = read_batch_function;
+    return LIBDBO_OK;
+}
+
 int libdbo_backend_handle_set_free(libdbo_backend_handle_t* backend_handle, libdbo_backend_handle_free_t free_function) {
     if (!backend_handle) {
         return LIBDBO_ERROR_UNKNOWN;
@@ -408,6 +496,9 @@ int libdbo_backend_handle_not_empty(const libdbo_backend_handle_t* backend_handl
     if (!backend_handle->delete_function) {
         return LIBDBO_ERROR_UNKNOWN;
     }
+    if (!backend_handle->upsert_function) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
     if (!backend_handle->free_function) {
         return LIBDBO_ERROR_UNKNOWN;
     }
@@ -427,6 +518,33 @@ int libdbo_backend_handle_not_empty(const libdbo_backend_handle_t* backend_handl
 
 static libdbo_mm_t __backend_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_backend_t));
 
+/**
+ * Get the start time of an operation.
+ */
+static void __backend_start(struct timespec* start) {
+    if (clock_gettime(CLOCK_MONOTONIC, start)) {
+        start->tv_sec = 0;
+        start->tv_nsec = 0;
+    }
+}
+
+/**
+ * Get the time since the start of an operation in microseconds.
+ */
+static unsigned long long __backend_elapsed(const struct timespec* start) {
+    struct timespec now;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &now)
+        || now.tv_sec < start->tv_sec
+        || (now.tv_sec == start->tv_sec && now.tv_nsec < start->tv_nsec))
+    {
+        return 0;
+    }
+
+    return (unsigned long long)(now.tv_sec - start->tv_sec) * 1000000
+        + (now.tv_nsec - start->tv_nsec) / 1000;
+}
+
 libdbo_backend_t* libdbo_backend_new(void) {
     libdbo_backend_t* backend =
         (libdbo_backend_t*)libdbo_mm_new0(&__backend_alloc);
@@ -442,6 +560,7 @@ void libdbo_backend_free(libdbo_backend_t* backend) {
         if (backend->name) {
             free(backend->name);
         }
+        libdbo_stats_free(backend->stats);
         libdbo_mm_delete(&__backend_alloc, backend);
     }
 }
@@ -462,6 +581,14 @@ const libdbo_backend_handle_t* libdbo_backend_handle(const libdbo_backend_t* bac
     return backend->handle;
 }
 
+libdbo_stats_t* libdbo_backend_stats(const libdbo_backend_t* backend) {
+    if (!backend) {
+        return NULL;
+    }
+
+    return backend->stats;
+}
+
 int libdbo_backend_set_name(libdbo_backend_t* backend, const char* name) {
     char* new_name;
 
@@ -492,6 +619,21 @@ int libdbo_backend_set_handle(libdbo_backend_t* backend, libdbo_backend_handle_t
     return LIBDBO_OK;
 }
 
+int libdbo_backend_set_stats(libdbo_backend_t* backend, libdbo_stats_t* stats) {
+    if (!backend) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!stats) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (backend->stats) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    backend->stats = stats;
+    return LIBDBO_OK;
+}
+
 int libdbo_backend_not_empty(const libdbo_backend_t* backend) {
     if (!backend) {
         return LIBDBO_ERROR_UNKNOWN;
@@ -553,6 +695,9 @@ int libdbo_backend_disconnect(const libdbo_backend_t* backend) {
 }
 
 int libdbo_backend_create(const libdbo_backend_t* backend, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set) {
+    struct timespec start;
+    int ret;
+
     if (!backend) {
         return LIBDBO_ERROR_UNKNOWN;
     }
@@ -569,10 +714,20 @@ int libdbo_backend_create(const libdbo_backend_t* backend, const libdbo_object_t
         return LIBDBO_ERROR_UNKNOWN;
     }
 
-    return libdbo_backend_handle_create(backend->handle, object, object_field_list, value_set);
+    if (!backend->stats) {
+        return libdbo_backend_handle_create(backend->handle, object, object_field_list, value_set);
+    }
+
+    __backend_start(&start);
+    ret = libdbo_backend_handle_create(backend->handle, object, object_field_list, value_set);
+    libdbo_stats_record(backend->stats, LIBDBO_STATS_CREATE, libdbo_object_table(object), __backend_elapsed(&start), ret);
+    return ret;
 }
 
 libdbo_result_list_t* libdbo_backend_read(const libdbo_backend_t* backend, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list) {
+    struct timespec start;
+    libdbo_result_list_t* result_list;
+
     if (!backend) {
         return NULL;
     }
@@ -583,10 +738,20 @@ libdbo_result_list_t* libdbo_backend_read(const libdbo_backend_t* backend, const
         return NULL;
     }
 
-    return libdbo_backend_handle_read(backend->handle, object, join_list, clause_list);
+    if (!backend->stats) {
+        return libdbo_backend_handle_read(backend->handle, object, join_list, clause_list);
+    }
+
+    __backend_start(&start);
+    result_list = libdbo_backend_handle_read(backend->handle, object, join_list, clause_list);
+    libdbo_stats_record_read(backend->stats, libdbo_object_table(object), clause_list, __backend_elapsed(&start), result_list);
+    return result_list;
 }
 
 int libdbo_backend_update(const libdbo_backend_t* backend, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, const libdbo_clause_list_t* clause_list) {
+    struct timespec start;
+    int ret;
+
     if (!backend) {
         return LIBDBO_ERROR_UNKNOWN;
     }
@@ -603,10 +768,20 @@ int libdbo_backend_update(const libdbo_backend_t* backend, const libdbo_object_t
         return LIBDBO_ERROR_UNKNOWN;
     }
 
-    return libdbo_backend_handle_update(backend->handle, object, object_field_list, value_set, clause_list);
+    if (!backend->stats) {
+        return libdbo_backend_handle_update(backend->handle, object, object_field_list, value_set, clause_list);
+    }
+
+    __backend_start(&start);
+    ret = libdbo_backend_handle_update(backend->handle, object, object_field_list, value_set, clause_list);
+    libdbo_stats_record(backend->stats, LIBDBO_STATS_UPDATE, libdbo_object_table(object), __backend_elapsed(&start), ret);
+    return ret;
 }
 
 int libdbo_backend_delete(const libdbo_backend_t* backend, const libdbo_object_t* object, const libdbo_clause_list_t* clause_list) {
+    struct timespec start;
+    int ret;
+
     if (!backend) {
         return LIBDBO_ERROR_UNKNOWN;
     }
@@ -617,10 +792,20 @@ int libdbo_backend_delete(const libdbo_backend_t* backend, const libdbo_object_t
         return LIBDBO_ERROR_UNKNOWN;
     }
 
-    return libdbo_backend_handle_delete(backend->handle, object, clause_list);
+    if (!backend->stats) {
+        return libdbo_backend_handle_delete(backend->handle, object, clause_list);
+    }
+
+    __backend_start(&start);
+    ret = libdbo_backend_handle_delete(backend->handle, object, clause_list);
+    libdbo_stats_record(backend->stats, LIBDBO_STATS_DELETE, libdbo_object_table(object), __backend_elapsed(&start), ret);
+    return ret;
 }
 
 int libdbo_backend_count(const libdbo_backend_t* backend, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list, size_t* count) {
+    struct timespec start;
+    int ret;
+
     if (!backend) {
         return LIBDBO_ERROR_UNKNOWN;
     }
@@ -634,10 +819,80 @@ int libdbo_backend_count(const libdbo_backend_t* backend, const libdbo_object_t*
         return LIBDBO_ERROR_UNKNOWN;
     }
 
-    return libdbo_backend_handle_count(backend->handle, object, join_list, clause_list, count);
+    if (!backend->stats) {
+        return libdbo_backend_handle_count(backend->handle, object, join_list, clause_list, count);
+    }
+
+    __backend_start(&start);
+    ret = libdbo_backend_handle_count(backend->handle, object, join_list, clause_list, count);
+    libdbo_stats_record_count(backend->stats, libdbo_object_table(object), clause_list, __backend_elapsed(&start), ret, ret ? 0 : *count);
+    return ret;
+}
+
+int libdbo_backend_upsert(const libdbo_backend_t* backend, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, const libdbo_clause_list_t* clause_list) {
+    struct timespec start;
+    int ret;
+
+    if (!backend) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object_field_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!value_set) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!clause_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend->handle) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (!backend->stats) {
+        return libdbo_backend_handle_upsert(backend->handle, object, object_field_list, value_set, clause_list);
+    }
+
+    __backend_start(&start);
+    ret = libdbo_backend_handle_upsert(backend->handle, object, object_field_list, value_set, clause_list);
+    libdbo_stats_record(backend->stats, LIBDBO_STATS_UPSERT, libdbo_object_table(object), __backend_elapsed(&start), ret);
+    return ret;
+}
+
+int libdbo_backend_read_batch(const libdbo_backend_t* backend, size_t size, const libdbo_object_t** objects, const libdbo_join_list_t** join_lists, const libdbo_clause_list_t** clause_lists, libdbo_result_list_t** result_lists) {
+    struct timespec start;
+    int ret;
+
+    if (!backend) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!objects) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!result_lists) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend->handle) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (!backend->stats) {
+        return libdbo_backend_handle_read_batch(backend->handle, size, objects, join_lists, clause_lists, result_lists);
+    }
+
+    __backend_start(&start);
+    ret = libdbo_backend_handle_read_batch(backend->handle, size, objects, join_lists, clause_lists, result_lists);
+    libdbo_stats_record(backend->stats, LIBDBO_STATS_READ_BATCH, NULL, __backend_elapsed(&start), ret);
+    return ret;
 }
 
 int libdbo_backend_transaction_begin(const libdbo_backend_t* backend) {
+    struct timespec start;
+    int ret;
+
     if (!backend) {
         return LIBDBO_ERROR_UNKNOWN;
     }
@@ -645,10 +900,20 @@ int libdbo_backend_transaction_begin(const libdbo_backend_t* backend) {
         return LIBDBO_ERROR_UNKNOWN;
     }
 
-    return libdbo_backend_handle_transaction_begin(backend->handle);
+    if (!backend->stats) {
+        return libdbo_backend_handle_transaction_begin(backend->handle);
+    }
+
+    __backend_start(&start);
+    ret = libdbo_backend_handle_transaction_begin(backend->handle);
+    libdbo_stats_record(backend->stats, LIBDBO_STATS_TRANSACTION_BEGIN, NULL, __backend_elapsed(&start), ret);
+    return ret;
 }
 
 int libdbo_backend_transaction_commit(const libdbo_backend_t* backend) {
+    struct timespec start;
+    int ret;
+
     if (!backend) {
         return LIBDBO_ERROR_UNKNOWN;
     }
@@ -656,10 +921,20 @@ int libdbo_backend_transaction_commit(const libdbo_backend_t* backend) {
         return LIBDBO_ERROR_UNKNOWN;
     }
 
-    return libdbo_backend_handle_transaction_commit(backend->handle);
+    if (!backend->stats) {
+        return libdbo_backend_handle_transaction_commit(backend->handle);
+    }
+
+    __backend_start(&start);
+    ret = libdbo_backend_handle_transaction_commit(backend->handle);
+    libdbo_stats_record(backend->stats, LIBDBO_STATS_TRANSACTION_COMMIT, NULL, __backend_elapsed(&start), ret);
+    return ret;
 }
 
 int libdbo_backend_transaction_rollback(const libdbo_backend_t* backend) {
+    struct timespec start;
+    int ret;
+
     if (!backend) {
         return LIBDBO_ERROR_UNKNOWN;
     }
@@ -667,7 +942,14 @@ int libdbo_backend_transaction_rollback(const libdbo_backend_t* backend) {
         return LIBDBO_ERROR_UNKNOWN;
     }
 
-    return libdbo_backend_handle_transaction_rollback(backend->handle);
+    if (!backend->stats) {
+        return libdbo_backend_handle_transaction_rollback(backend->handle);
+    }
+
+    __backend_start(&start);
+    ret = libdbo_backend_handle_transaction_rollback(backend->handle);
+    libdbo_stats_record(backend->stats, LIBDBO_STATS_TRANSACTION_ROLLBACK, NULL, __backend_elapsed(&start), ret);
+    return ret;
 }
 
 /* DB BACKEND FACTORY */
@@ -684,6 +966,7 @@ libdbo_backend_t* libdbo_backend_factory_get_backend(const char* name) {
         if (!(backend = libdbo_backend_new())
             || libdbo_backend_set_name(backend, "sqlite")
             || libdbo_backend_set_handle(backend, libdbo_backend_sqlite_new_handle())
+            || libdbo_backend_set_stats(backend, libdbo_stats_new())
             || libdbo_backend_initialize(backend))
         {
             libdbo_backend_free(backend);
@@ -697,6 +980,7 @@ libdbo_backend_t* libdbo_backend_factory_get_backend(const char* name) {
         if (!(backend = libdbo_backend_new())
             || libdbo_backend_set_name(backend, "couchdb")
             || libdbo_backend_set_handle(backend, libdbo_backend_couchdb_new_handle())
+            || libdbo_backend_set_stats(backend, libdbo_stats_new())
             || libdbo_backend_initialize(backend))
         {
             libdbo_backend_free(backend);
@@ -710,6 +994,35 @@ libdbo_backend_t* libdbo_backend_factory_get_backend(const char* name) {
         if (!(backend = libdbo_backend_new())
             || libdbo_backend_set_name(backend, "mysql")
             || libdbo_backend_set_handle(backend, libdbo_backend_mysql_new_handle())
+            || libdbo_backend_set_stats(backend, libdbo_stats_new())
+            || libdbo_backend_initialize(backend))
+        {
+            libdbo_backend_free(backend);
+            return NULL;
+        }
+        return backend;
+    }
+#endif
+#if defined(HAVE_POSTGRESQL)
+    if (!strcmp(name, "postgresql")) {
+        if (!(backend = libdbo_backend_new())
+            || libdbo_backend_set_name(backend, "postgresql")
+            || libdbo_backend_set_handle(backend, libdbo_backend_postgresql_new_handle())
+            || libdbo_backend_set_stats(backend, libdbo_stats_new())
+            || libdbo_backend_initialize(backend))
+        {
+            libdbo_backend_free(backend);
+            return NULL;
+        }
+        return backend;
+    }
+#endif
+#if defined(HAVE_LMDB)
+    if (!strcmp(name, "lmdb")) {
+        if (!(backend = libdbo_backend_new())
+            || libdbo_backend_set_name(backend, "lmdb")
+            || libdbo_backend_set_handle(backend, libdbo_backend_lmdb_new_handle())
+            || libdbo_backend_set_stats(backend, libdbo_stats_new())
             || libdbo_backend_initialize(backend))
         {
             libdbo_backend_free(backend);
@@ -718,6 +1031,30 @@ libdbo_backend_t* libdbo_backend_factory_get_backend(const char* name) {
         return backend;
     }
 #endif
+    if (!strcmp(name, "memory")) {
+        if (!(backend = libdbo_backend_new())
+            || libdbo_backend_set_name(backend, "memory")
+            || libdbo_backend_set_handle(backend, libdbo_backend_memory_new_handle())
+            || libdbo_backend_set_stats(backend, libdbo_stats_new())
+            || libdbo_backend_initialize(backend))
+        {
+            libdbo_backend_free(backend);
+            return NULL;
+        }
+        return backend;
+    }
+    if (!strcmp(name, "cache")) {
+        if (!(backend = libdbo_backend_new())
+            || libdbo_backend_set_name(backend, "cache")
+            || libdbo_backend_set_handle(backend, libdbo_backend_cache_new_handle())
+            || libdbo_backend_set_stats(backend, libdbo_stats_new())
+            || libdbo_backend_initialize(backend))
+        {
+            libdbo_backend_free(backend);
+            return NULL;
+        }
+        return backend;
+    }
 
     return backend;
 }
@@ -759,6 +1096,46 @@ int libdbo_backend_factory_shutdown(void) {
     libdbo_backend_free(backend);
     backend = NULL;
 #endif
+#if defined(HAVE_POSTGRESQL)
+    if (!(backend = libdbo_backend_new())
+        || libdbo_backend_set_name(backend, "postgresql")
+        || libdbo_backend_set_handle(backend, libdbo_backend_postgresql_new_handle())
+        || libdbo_backend_shutdown(backend))
+    {
+        ret = LIBDBO_ERROR_UNKNOWN;
+    }
+    libdbo_backend_free(backend);
+    backend = NULL;
+#endif
+#if defined(HAVE_LMDB)
+    if (!(backend = libdbo_backend_new())
+        || libdbo_backend_set_name(backend, "lmdb")
+        || libdbo_backend_set_handle(backend, libdbo_backend_lmdb_new_handle())
+        || libdbo_backend_shutdown(backend))
+    {
+        ret = LIBDBO_ERROR_UNKNOWN;
+    }
+    libdbo_backend_free(backend);
+    backend = NULL;
+#endif
+    if (!(backend = libdbo_backend_new())
+        || libdbo_backend_set_name(backend, "memory")
+        || libdbo_backend_set_handle(backend, libdbo_backend_memory_new_handle())
+        || libdbo_backend_shutdown(backend))
+    {
+        ret = LIBDBO_ERROR_UNKNOWN;
+    }
+    libdbo_backend_free(backend);
+    backend = NULL;
+    if (!(backend = libdbo_backend_new())
+        || libdbo_backend_set_name(backend, "cache")
+        || libdbo_backend_set_handle(backend, libdbo_backend_cache_new_handle())
+        || libdbo_backend_shutdown(backend))
+    {
+        ret = LIBDBO_ERROR_UNKNOWN;
+    }
+    libdbo_backend_free(backend);
+    backend = NULL;
 
     return ret;
 }
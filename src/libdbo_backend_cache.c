@@ -0,0 +1,961 @@
+/*
+ * Copyright (c) 2014 Jerry Lundström <lundstrom.jerry@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "libdbo/backend/cache.h"
+
+#include "libdbo/error.h"
+#include "libdbo/mm.h"
+#include "libdbo/log.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * Keep track of if we have initialized the cache backend.
+ */
+static int __cache_initialized = 0;
+
+/**
+ * The kind of a cached entry.
+ */
+typedef enum {
+    LIBDBO_BACKEND_CACHE_READ = 'R',
+    LIBDBO_BACKEND_CACHE_COUNT = 'N'
+} libdbo_backend_cache_kind_t;
+
+/**
+ * A cached read or count, it is both in a hash bucket and in the LRU list.
+ */
+typedef struct libdbo_backend_cache_entry libdbo_backend_cache_entry_t;
+struct libdbo_backend_cache_entry {
+    libdbo_backend_cache_entry_t* bucket_next;
+    libdbo_backend_cache_entry_t* lru_prev;
+    libdbo_backend_cache_entry_t* lru_next;
+    unsigned char* key;
+    size_t key_length;
+    unsigned long hash;
+    time_t expires;
+    /** The tables used by the entry, each NUL terminated and the last followed by an empty one. */
+    char* tables;
+    libdbo_result_list_t* result_list;
+    size_t count;
+};
+
+static libdbo_mm_t __cache_entry_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_backend_cache_entry_t));
+
+/**
+ * A growing buffer used to build the cache keys.
+ */
+typedef struct libdbo_backend_cache_buffer {
+    unsigned char* data;
+    size_t length;
+    size_t size;
+} libdbo_backend_cache_buffer_t;
+
+typedef struct libdbo_backend_cache {
+    libdbo_backend_t* backend;
+    size_t size;
+    time_t ttl;
+    size_t max_results;
+    libdbo_backend_cache_entry_t** buckets;
+    size_t buckets_size;
+    libdbo_backend_cache_entry_t* lru_first;
+    libdbo_backend_cache_entry_t* lru_last;
+    libdbo_backend_cache_stats_t stats;
+    libdbo_backend_cache_buffer_t key;
+    libdbo_backend_cache_buffer_t tables;
+} libdbo_backend_cache_t;
+
+static libdbo_mm_t __cache_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_backend_cache_t));
+
+/**
+ * Append data to a buffer.
+ */
+static int __db_backend_cache_buffer_add(libdbo_backend_cache_buffer_t* buffer, const void* data, size_t length) {
+    unsigned char* new_data;
+    size_t new_size;
+
+    if (!buffer) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!data && length) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (buffer->length + length > buffer->size) {
+        new_size = buffer->size ? buffer->size : 256;
+        while (buffer->length + length > new_size) {
+            new_size *= 2;
+        }
+        if (!(new_data = (unsigned char*)realloc(buffer->data, new_size))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        buffer->data = new_data;
+        buffer->size = new_size;
+    }
+    if (length) {
+        memcpy(buffer->data + buffer->length, data, length);
+        buffer->length += length;
+    }
+    return LIBDBO_OK;
+}
+
+static int __db_backend_cache_buffer_add_char(libdbo_backend_cache_buffer_t* buffer, unsigned char c) {
+    return __db_backend_cache_buffer_add(buffer, &c, 1);
+}
+
+static int __db_backend_cache_buffer_add_int(libdbo_backend_cache_buffer_t* buffer, libdbo_type_int64_t i) {
+    return __db_backend_cache_buffer_add(buffer, &i, sizeof(i));
+}
+
+/**
+ * Append a string to a buffer, NULL and empty strings are kept apart.
+ */
+static int __db_backend_cache_buffer_add_text(libdbo_backend_cache_buffer_t* buffer, const char* text) {
+    if (!text) {
+        return __db_backend_cache_buffer_add_char(buffer, 0);
+    }
+    if (__db_backend_cache_buffer_add_char(buffer, 1)
+        || __db_backend_cache_buffer_add(buffer, text, strlen(text) + 1))
+    {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    return LIBDBO_OK;
+}
+
+/**
+ * Add a table to the list of tables used by an entry if it is not already in
+ * it.
+ */
+static int __db_backend_cache_tables_add(libdbo_backend_cache_buffer_t* tables, const char* table) {
+    size_t position = 0;
+
+    if (!tables) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!table) {
+        return LIBDBO_OK;
+    }
+
+    while (position < tables->length) {
+        if (!strcmp((const char*)tables->data + position, table)) {
+            return LIBDBO_OK;
+        }
+        position += strlen((const char*)tables->data + position) + 1;
+    }
+    return __db_backend_cache_buffer_add(tables, table, strlen(table) + 1);
+}
+
+static int __db_backend_cache_key_value(libdbo_backend_cache_buffer_t* key, const libdbo_value_t* value) {
+    const libdbo_type_int32_t* int32;
+    const libdbo_type_uint32_t* uint32;
+    const libdbo_type_int64_t* int64;
+    const libdbo_type_uint64_t* uint64;
+    int enum_value;
+
+    if (!key) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!value) {
+        return __db_backend_cache_buffer_add_char(key, 0);
+    }
+
+    if (__db_backend_cache_buffer_add_char(key, 1 + (unsigned char)libdbo_value_type(value))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    switch (libdbo_value_type(value)) {
+    case LIBDBO_TYPE_EMPTY:
+        return LIBDBO_OK;
+
+    case LIBDBO_TYPE_INT32:
+        if (!(int32 = libdbo_value_int32(value))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        return __db_backend_cache_buffer_add_int(key, *int32);
+
+    case LIBDBO_TYPE_UINT32:
+        if (!(uint32 = libdbo_value_uint32(value))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        return __db_backend_cache_buffer_add_int(key, *uint32);
+
+    case LIBDBO_TYPE_INT64:
+        if (!(int64 = libdbo_value_int64(value))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        return __db_backend_cache_buffer_add_int(key, *int64);
+
+    case LIBDBO_TYPE_UINT64:
+        if (!(uint64 = libdbo_value_uint64(value))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        return __db_backend_cache_buffer_add(key, uint64, sizeof(*uint64));
+
+    case LIBDBO_TYPE_TEXT:
+        return __db_backend_cache_buffer_add_text(key, libdbo_value_text(value));
+
+    case LIBDBO_TYPE_ENUM:
+        if (libdbo_value_enum_value(value, &enum_value)
+            || __db_backend_cache_buffer_add_int(key, enum_value)
+            || __db_backend_cache_buffer_add_text(key, libdbo_value_enum_text(value)))
+        {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        return LIBDBO_OK;
+
+    default:
+        break;
+    }
+
+    return LIBDBO_ERROR_UNKNOWN;
+}
+
+static int __db_backend_cache_key_clause_list(libdbo_backend_cache_buffer_t* key, libdbo_backend_cache_buffer_t* tables, const libdbo_clause_list_t* clause_list) {
+    const libdbo_clause_t* clause;
+
+    if (!key) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!tables) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (__db_backend_cache_buffer_add_char(key, '(')) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    clause = libdbo_clause_list_begin(clause_list);
+    while (clause) {
+        if (__db_backend_cache_buffer_add_char(key, 'c')
+            || __db_backend_cache_buffer_add_text(key, libdbo_clause_table(clause))
+            || __db_backend_cache_buffer_add_text(key, libdbo_clause_field(clause))
+            || __db_backend_cache_buffer_add_int(key, libdbo_clause_type(clause))
+            || __db_backend_cache_buffer_add_int(key, libdbo_clause_operator(clause))
+            || __db_backend_cache_tables_add(tables, libdbo_clause_table(clause)))
+        {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        if (libdbo_clause_type(clause) == LIBDBO_CLAUSE_NESTED) {
+            if (__db_backend_cache_key_clause_list(key, tables, libdbo_clause_list(clause))) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+        }
+        else if (__db_backend_cache_key_value(key, libdbo_clause_value(clause))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        clause = libdbo_clause_next(clause);
+    }
+    return __db_backend_cache_buffer_add_char(key, ')');
+}
+
+/**
+ * Build the key of a read or count in the key buffer of the cache backend,
+ * and the list of tables it uses in the tables buffer.
+ */
+static int __db_backend_cache_key(libdbo_backend_cache_t* backend_cache, libdbo_backend_cache_kind_t kind, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list) {
+    const libdbo_object_field_t* object_field;
+    const libdbo_join_t* join;
+
+    if (!backend_cache) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!libdbo_object_table(object)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    backend_cache->key.length = 0;
+    backend_cache->tables.length = 0;
+
+    if (__db_backend_cache_buffer_add_char(&(backend_cache->key), (unsigned char)kind)
+        || __db_backend_cache_buffer_add_text(&(backend_cache->key), libdbo_object_table(object))
+        || __db_backend_cache_tables_add(&(backend_cache->tables), libdbo_object_table(object)))
+    {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    object_field = libdbo_object_field_list_begin(libdbo_object_object_field_list(object));
+    while (object_field) {
+        if (__db_backend_cache_buffer_add_char(&(backend_cache->key), 'f')
+            || __db_backend_cache_buffer_add_text(&(backend_cache->key), libdbo_object_field_name(object_field))
+            || __db_backend_cache_buffer_add_int(&(backend_cache->key), libdbo_object_field_type(object_field)))
+        {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        object_field = libdbo_object_field_next(object_field);
+    }
+
+    join = libdbo_join_list_begin(join_list);
+    while (join) {
+        if (__db_backend_cache_buffer_add_char(&(backend_cache->key), 'j')
+            || __db_backend_cache_buffer_add_text(&(backend_cache->key), libdbo_join_from_table(join))
+            || __db_backend_cache_buffer_add_text(&(backend_cache->key), libdbo_join_from_field(join))
+            || __db_backend_cache_buffer_add_text(&(backend_cache->key), libdbo_join_to_table(join))
+            || __db_backend_cache_buffer_add_text(&(backend_cache->key), libdbo_join_to_field(join))
+            || __db_backend_cache_tables_add(&(backend_cache->tables), libdbo_join_from_table(join))
+            || __db_backend_cache_tables_add(&(backend_cache->tables), libdbo_join_to_table(join)))
+        {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        join = libdbo_join_next(join);
+    }
+
+    if (__db_backend_cache_key_clause_list(&(backend_cache->key), &(backend_cache->tables), clause_list)
+        || __db_backend_cache_buffer_add_char(&(backend_cache->tables), 0))
+    {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    return LIBDBO_OK;
+}
+
+/**
+ * FNV-1a of the key in the key buffer.
+ */
+static unsigned long __db_backend_cache_hash(const libdbo_backend_cache_buffer_t* key) {
+    unsigned long hash = 2166136261UL;
+    size_t i;
+
+    for (i = 0; i < key->length; i++) {
+        hash ^= key->data[i];
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+static void __db_backend_cache_lru_unlink(libdbo_backend_cache_t* backend_cache, libdbo_backend_cache_entry_t* entry) {
+    if (entry->lru_prev) {
+        entry->lru_prev->lru_next = entry->lru_next;
+    }
+    else {
+        backend_cache->lru_first = entry->lru_next;
+    }
+    if (entry->lru_next) {
+        entry->lru_next->lru_prev = entry->lru_prev;
+    }
+    else {
+        backend_cache->lru_last = entry->lru_prev;
+    }
+    entry->lru_prev = NULL;
+    entry->lru_next = NULL;
+}
+
+static void __db_backend_cache_lru_push(libdbo_backend_cache_t* backend_cache, libdbo_backend_cache_entry_t* entry) {
+    entry->lru_prev = NULL;
+    entry->lru_next = backend_cache->lru_first;
+    if (backend_cache->lru_first) {
+        backend_cache->lru_first->lru_prev = entry;
+    }
+    else {
+        backend_cache->lru_last = entry;
+    }
+    backend_cache->lru_first = entry;
+}
+
+/**
+ * Remove an entry from the cache and free it.
+ */
+static void __db_backend_cache_entry_remove(libdbo_backend_cache_t* backend_cache, libdbo_backend_cache_entry_t* entry) {
+    libdbo_backend_cache_entry_t** bucket;
+
+    bucket = &(backend_cache->buckets[entry->hash & (backend_cache->buckets_size - 1)]);
+    while (*bucket) {
+        if (*bucket == entry) {
+            *bucket = entry->bucket_next;
+            break;
+        }
+        bucket = &((*bucket)->bucket_next);
+    }
+    __db_backend_cache_lru_unlink(backend_cache, entry);
+
+    if (entry->result_list) {
+        libdbo_result_list_free(entry->result_list);
+    }
+    free(entry->key);
+    free(entry->tables);
+    libdbo_mm_delete(&__cache_entry_alloc, entry);
+    backend_cache->stats.entries--;
+}
+
+static void __db_backend_cache_flush(libdbo_backend_cache_t* backend_cache) {
+    while (backend_cache->lru_first) {
+        __db_backend_cache_entry_remove(backend_cache, backend_cache->lru_first);
+    }
+}
+
+/**
+ * Find the entry for the key in the key buffer, expired entries are removed
+ * and not returned.
+ */
+static libdbo_backend_cache_entry_t* __db_backend_cache_lookup(libdbo_backend_cache_t* backend_cache, unsigned long hash) {
+    libdbo_backend_cache_entry_t* entry;
+
+    entry = backend_cache->buckets[hash & (backend_cache->buckets_size - 1)];
+    while (entry) {
+        if (entry->hash == hash
+            && entry->key_length == backend_cache->key.length
+            && !memcmp(entry->key, backend_cache->key.data, entry->key_length))
+        {
+            break;
+        }
+        entry = entry->bucket_next;
+    }
+    if (!entry) {
+        return NULL;
+    }
+
+    if (backend_cache->ttl && entry->expires <= time(NULL)) {
+        __db_backend_cache_entry_remove(backend_cache, entry);
+        backend_cache->stats.expired++;
+        return NULL;
+    }
+
+    __db_backend_cache_lru_unlink(backend_cache, entry);
+    __db_backend_cache_lru_push(backend_cache, entry);
+    return entry;
+}
+
+/**
+ * Store a new entry for the key in the key buffer, takes ownership of the
+ * result list even on error.
+ */
+static int __db_backend_cache_store(libdbo_backend_cache_t* backend_cache, unsigned long hash, libdbo_result_list_t* result_list, size_t count) {
+    libdbo_backend_cache_entry_t* entry;
+    libdbo_backend_cache_entry_t** bucket;
+
+    if (!(entry = (libdbo_backend_cache_entry_t*)libdbo_mm_new0(&__cache_entry_alloc))
+        || !(entry->key = (unsigned char*)malloc(backend_cache->key.length))
+        || !(entry->tables = (char*)malloc(backend_cache->tables.length)))
+    {
+        if (entry) {
+            free(entry->key);
+            libdbo_mm_delete(&__cache_entry_alloc, entry);
+        }
+        if (result_list) {
+            libdbo_result_list_free(result_list);
+        }
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    memcpy(entry->key, backend_cache->key.data, backend_cache->key.length);
+    entry->key_length = backend_cache->key.length;
+    memcpy(entry->tables, backend_cache->tables.data, backend_cache->tables.length);
+    entry->hash = hash;
+    entry->expires = time(NULL) + backend_cache->ttl;
+    entry->result_list = result_list;
+    entry->count = count;
+
+    bucket = &(backend_cache->buckets[hash & (backend_cache->buckets_size - 1)]);
+    entry->bucket_next = *bucket;
+    *bucket = entry;
+    __db_backend_cache_lru_push(backend_cache, entry);
+    backend_cache->stats.entries++;
+
+    while (backend_cache->stats.entries > backend_cache->size && backend_cache->lru_last) {
+        __db_backend_cache_entry_remove(backend_cache, backend_cache->lru_last);
+        backend_cache->stats.evictions++;
+    }
+    return LIBDBO_OK;
+}
+
+/**
+ * Remove all entries that uses a table.
+ */
+static void __db_backend_cache_invalidate(libdbo_backend_cache_t* backend_cache, const libdbo_object_t* object) {
+    libdbo_backend_cache_entry_t* entry;
+    libdbo_backend_cache_entry_t* next;
+    const char* table;
+    const char* entry_table;
+
+    if (!object || !(table = libdbo_object_table(object))) {
+        __db_backend_cache_flush(backend_cache);
+        backend_cache->stats.invalidations++;
+        return;
+    }
+
+    entry = backend_cache->lru_first;
+    while (entry) {
+        next = entry->lru_next;
+        entry_table = entry->tables;
+        while (*entry_table) {
+            if (!strcmp(entry_table, table)) {
+                __db_backend_cache_entry_remove(backend_cache, entry);
+                break;
+            }
+            entry_table += strlen(entry_table) + 1;
+        }
+        entry = next;
+    }
+    backend_cache->stats.invalidations++;
+}
+
+static int libdbo_backend_cache_initialize(void* data) {
+    libdbo_backend_cache_t* backend_cache = (libdbo_backend_cache_t*)data;
+
+    if (!backend_cache) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    __cache_initialized = 1;
+    return LIBDBO_OK;
+}
+
+static int libdbo_backend_cache_shutdown(void* data) {
+    libdbo_backend_cache_t* backend_cache = (libdbo_backend_cache_t*)data;
+
+    if (!backend_cache) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    __cache_initialized = 0;
+    return LIBDBO_OK;
+}
+
+static int libdbo_backend_cache_connect(void* data, const libdbo_configuration_list_t* configuration_list) {
+    libdbo_backend_cache_t* backend_cache = (libdbo_backend_cache_t*)data;
+    const libdbo_configuration_t* configuration;
+    const char* name;
+    long value;
+    size_t size = LIBDBO_BACKEND_CACHE_DEFAULT_SIZE;
+    time_t ttl = LIBDBO_BACKEND_CACHE_DEFAULT_TTL;
+    size_t max_results = 0;
+    size_t buckets_size = 16;
+
+    if (!__cache_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_cache) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (backend_cache->backend) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!configuration_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (!(configuration = libdbo_configuration_list_find(configuration_list, "cache_backend"))
+        || !(name = libdbo_configuration_value(configuration)))
+    {
+        libdbo_log(LIBDBO_LOG_ERROR, "cache: missing configuration cache_backend");
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!strcmp(name, "cache")) {
+        libdbo_log(LIBDBO_LOG_ERROR, "cache: can not cache the cache backend");
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if ((configuration = libdbo_configuration_list_find(configuration_list, "cache_size"))) {
+        if ((value = atol(libdbo_configuration_value(configuration))) < 1) {
+            libdbo_log(LIBDBO_LOG_ERROR, "cache: invalid cache_size");
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        size = (size_t)value;
+    }
+    if ((configuration = libdbo_configuration_list_find(configuration_list, "cache_ttl"))) {
+        if ((value = atol(libdbo_configuration_value(configuration))) < 0) {
+            libdbo_log(LIBDBO_LOG_ERROR, "cache: invalid cache_ttl");
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        ttl = (time_t)value;
+    }
+    if ((configuration = libdbo_configuration_list_find(configuration_list, "cache_max_results"))) {
+        if ((value = atol(libdbo_configuration_value(configuration))) < 0) {
+            libdbo_log(LIBDBO_LOG_ERROR, "cache: invalid cache_max_results");
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        max_results = (size_t)value;
+    }
+
+    while (buckets_size < size) {
+        buckets_size *= 2;
+    }
+    if (!(backend_cache->buckets = (libdbo_backend_cache_entry_t**)calloc(buckets_size, sizeof(libdbo_backend_cache_entry_t*)))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (!(backend_cache->backend = libdbo_backend_factory_get_backend(name))) {
+        libdbo_log(LIBDBO_LOG_ERROR, "cache: unable to get backend %s", name);
+        free(backend_cache->buckets);
+        backend_cache->buckets = NULL;
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (libdbo_backend_connect(backend_cache->backend, configuration_list)) {
+        libdbo_backend_free(backend_cache->backend);
+        backend_cache->backend = NULL;
+        free(backend_cache->buckets);
+        backend_cache->buckets = NULL;
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    backend_cache->size = size;
+    backend_cache->ttl = ttl;
+    backend_cache->max_results = max_results;
+    backend_cache->buckets_size = buckets_size;
+    memset(&(backend_cache->stats), 0, sizeof(backend_cache->stats));
+    return LIBDBO_OK;
+}
+
+static int libdbo_backend_cache_disconnect(void* data) {
+    libdbo_backend_cache_t* backend_cache = (libdbo_backend_cache_t*)data;
+    int ret;
+
+    if (!__cache_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_cache) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_cache->backend) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    __db_backend_cache_flush(backend_cache);
+    free(backend_cache->buckets);
+    backend_cache->buckets = NULL;
+    backend_cache->buckets_size = 0;
+
+    ret = libdbo_backend_disconnect(backend_cache->backend);
+    libdbo_backend_free(backend_cache->backend);
+    backend_cache->backend = NULL;
+    return ret;
+}
+
+static int libdbo_backend_cache_create(void* data, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set) {
+    libdbo_backend_cache_t* backend_cache = (libdbo_backend_cache_t*)data;
+    int ret;
+
+    if (!__cache_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_cache) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_cache->backend) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    ret = libdbo_backend_create(backend_cache->backend, object, object_field_list, value_set);
+    __db_backend_cache_invalidate(backend_cache, object);
+    return ret;
+}
+
+static libdbo_result_list_t* libdbo_backend_cache_read(void* data, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list) {
+    libdbo_backend_cache_t* backend_cache = (libdbo_backend_cache_t*)data;
+    libdbo_backend_cache_entry_t* entry;
+    libdbo_result_list_t* result_list;
+    libdbo_result_list_t* cached;
+    unsigned long hash;
+
+    if (!__cache_initialized) {
+        return NULL;
+    }
+    if (!backend_cache) {
+        return NULL;
+    }
+    if (!backend_cache->backend) {
+        return NULL;
+    }
+
+    if (__db_backend_cache_key(backend_cache, LIBDBO_BACKEND_CACHE_READ, object, join_list, clause_list)) {
+        backend_cache->stats.misses++;
+        return libdbo_backend_read(backend_cache->backend, object, join_list, clause_list);
+    }
+    hash = __db_backend_cache_hash(&(backend_cache->key));
+
+    if ((entry = __db_backend_cache_lookup(backend_cache, hash))) {
+        backend_cache->stats.hits++;
+        return libdbo_result_list_new_copy(entry->result_list);
+    }
+    backend_cache->stats.misses++;
+
+    if (!(result_list = libdbo_backend_read(backend_cache->backend, object, join_list, clause_list))) {
+        return NULL;
+    }
+    if (libdbo_result_list_fetch_all(result_list)) {
+        libdbo_result_list_free(result_list);
+        return NULL;
+    }
+
+    if (!backend_cache->max_results || libdbo_result_list_size(result_list) <= backend_cache->max_results) {
+        if ((cached = libdbo_result_list_new_copy(result_list))) {
+            (void)__db_backend_cache_store(backend_cache, hash, cached, 0);
+        }
+    }
+    return result_list;
+}
+
+static int libdbo_backend_cache_update(void* data, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, const libdbo_clause_list_t* clause_list) {
+    libdbo_backend_cache_t* backend_cache = (libdbo_backend_cache_t*)data;
+    int ret;
+
+    if (!__cache_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_cache) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_cache->backend) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    ret = libdbo_backend_update(backend_cache->backend, object, object_field_list, value_set, clause_list);
+    __db_backend_cache_invalidate(backend_cache, object);
+    return ret;
+}
+
+static int libdbo_backend_cache_delete(void* data, const libdbo_object_t* object, const libdbo_clause_list_t* clause_list) {
+    libdbo_backend_cache_t* backend_cache = (libdbo_backend_cache_t*)data;
+    int ret;
+
+    if (!__cache_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_cache) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_cache->backend) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    ret = libdbo_backend_delete(backend_cache->backend, object, clause_list);
+    __db_backend_cache_invalidate(backend_cache, object);
+    return ret;
+}
+
+static int libdbo_backend_cache_count(void* data, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list, size_t* count) {
+    libdbo_backend_cache_t* backend_cache = (libdbo_backend_cache_t*)data;
+    libdbo_backend_cache_entry_t* entry;
+    unsigned long hash;
+
+    if (!__cache_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_cache) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_cache->backend) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!count) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (__db_backend_cache_key(backend_cache, LIBDBO_BACKEND_CACHE_COUNT, object, join_list, clause_list)) {
+        backend_cache->stats.misses++;
+        return libdbo_backend_count(backend_cache->backend, object, join_list, clause_list, count);
+    }
+    hash = __db_backend_cache_hash(&(backend_cache->key));
+
+    if ((entry = __db_backend_cache_lookup(backend_cache, hash))) {
+        backend_cache->stats.hits++;
+        *count = entry->count;
+        return LIBDBO_OK;
+    }
+    backend_cache->stats.misses++;
+
+    if (libdbo_backend_count(backend_cache->backend, object, join_list, clause_list, count)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    (void)__db_backend_cache_store(backend_cache, hash, NULL, *count);
+    return LIBDBO_OK;
+}
+
+static int libdbo_backend_cache_upsert(void* data, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, const libdbo_clause_list_t* clause_list) {
+    libdbo_backend_cache_t* backend_cache = (libdbo_backend_cache_t*)data;
+    int ret;
+
+    if (!__cache_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_cache) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_cache->backend) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    ret = libdbo_backend_upsert(backend_cache->backend, object, object_field_list, value_set, clause_list);
+    __db_backend_cache_invalidate(backend_cache, object);
+    return ret;
+}
+
+static void libdbo_backend_cache_free(void* data) {
+    libdbo_backend_cache_t* backend_cache = (libdbo_backend_cache_t*)data;
+
+    if (backend_cache) {
+        if (backend_cache->backend) {
+            __db_backend_cache_flush(backend_cache);
+            libdbo_backend_free(backend_cache->backend);
+        }
+        free(backend_cache->buckets);
+        free(backend_cache->key.data);
+        free(backend_cache->tables.data);
+        libdbo_mm_delete(&__cache_alloc, backend_cache);
+    }
+}
+
+static int libdbo_backend_cache_transaction_begin(void* data) {
+    libdbo_backend_cache_t* backend_cache = (libdbo_backend_cache_t*)data;
+
+    if (!__cache_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_cache) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_cache->backend) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    return libdbo_backend_transaction_begin(backend_cache->backend);
+}
+
+static int libdbo_backend_cache_transaction_commit(void* data) {
+    libdbo_backend_cache_t* backend_cache = (libdbo_backend_cache_t*)data;
+
+    if (!__cache_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_cache) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_cache->backend) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    return libdbo_backend_transaction_commit(backend_cache->backend);
+}
+
+static int libdbo_backend_cache_transaction_rollback(void* data) {
+    libdbo_backend_cache_t* backend_cache = (libdbo_backend_cache_t*)data;
+
+    if (!__cache_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_cache) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_cache->backend) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * Reads made inside the transaction may have been cached with rows that
+     * are now gone.
+     */
+    __db_backend_cache_invalidate(backend_cache, NULL);
+    return libdbo_backend_transaction_rollback(backend_cache->backend);
+}
+
+libdbo_backend_handle_t* libdbo_backend_cache_new_handle(void) {
+    libdbo_backend_handle_t* backend_handle = NULL;
+    libdbo_backend_cache_t* backend_cache =
+        (libdbo_backend_cache_t*)libdbo_mm_new0(&__cache_alloc);
+
+    if (backend_cache && (backend_handle = libdbo_backend_handle_new())) {
+        if (libdbo_backend_handle_set_data(backend_handle, (void*)backend_cache)
+            || libdbo_backend_handle_set_initialize(backend_handle, libdbo_backend_cache_initialize)
+            || libdbo_backend_handle_set_shutdown(backend_handle, libdbo_backend_cache_shutdown)
+            || libdbo_backend_handle_set_connect(backend_handle, libdbo_backend_cache_connect)
+            || libdbo_backend_handle_set_disconnect(backend_handle, libdbo_backend_cache_disconnect)
+            || libdbo_backend_handle_set_create(backend_handle, libdbo_backend_cache_create)
+            || libdbo_backend_handle_set_read(backend_handle, libdbo_backend_cache_read)
+            || libdbo_backend_handle_set_update(backend_handle, libdbo_backend_cache_update)
+            || libdbo_backend_handle_set_delete(backend_handle, libdbo_backend_cache_delete)
+            || libdbo_backend_handle_set_count(backend_handle, libdbo_backend_cache_count)
+            || libdbo_backend_handle_set_upsert(backend_handle, libdbo_backend_cache_upsert)
+            || libdbo_backend_handle_set_free(backend_handle, libdbo_backend_cache_free)
+            || libdbo_backend_handle_set_transaction_begin(backend_handle, libdbo_backend_cache_transaction_begin)
+            || libdbo_backend_handle_set_transaction_commit(backend_handle, libdbo_backend_cache_transaction_commit)
+            || libdbo_backend_handle_set_transaction_rollback(backend_handle, libdbo_backend_cache_transaction_rollback))
+        {
+            libdbo_backend_handle_free(backend_handle);
+            libdbo_mm_delete(&__cache_alloc, backend_cache);
+            return NULL;
+        }
+    }
+    return backend_handle;
+}
+
+/**
+ * Get the cache backend data of a connection.
+ */
+static libdbo_backend_cache_t* __db_backend_cache_of(const libdbo_connection_t* connection) {
+    const libdbo_backend_handle_t* backend_handle;
+
+    if (!connection) {
+        return NULL;
+    }
+    if (!connection->backend) {
+        return NULL;
+    }
+    if (!libdbo_backend_name(connection->backend)
+        || strcmp(libdbo_backend_name(connection->backend), "cache"))
+    {
+        return NULL;
+    }
+    if (!(backend_handle = libdbo_backend_handle(connection->backend))) {
+        return NULL;
+    }
+
+    return (libdbo_backend_cache_t*)libdbo_backend_handle_data(backend_handle);
+}
+
+int libdbo_backend_cache_stats(const libdbo_connection_t* connection, libdbo_backend_cache_stats_t* stats) {
+    libdbo_backend_cache_t* backend_cache;
+
+    if (!connection) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!stats) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!(backend_cache = __db_backend_cache_of(connection))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    *stats = backend_cache->stats;
+    return LIBDBO_OK;
+}
+
+int libdbo_backend_cache_flush(const libdbo_connection_t* connection) {
+    libdbo_backend_cache_t* backend_cache;
+
+    if (!connection) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!(backend_cache = __db_backend_cache_of(connection))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (backend_cache->buckets) {
+        __db_backend_cache_flush(backend_cache);
+    }
+    return LIBDBO_OK;
+}
@@ -33,10 +33,14 @@
  * All rights reserved.
  */
 
+#include "config.h"
+
 #include "libdbo/backend/couchdb.h"
 #include "libdbo/error.h"
+#include "libdbo/log.h"
 
 #include "libdbo/mm.h"
+#include "libdbo/trace.h"
 
 #include <curl/curl.h>
 #include <stdlib.h>
@@ -44,7 +48,15 @@
 #include <string.h>
 #include <openssl/sha.h>
 
-#define REQUEST_BUFFER_SIZE (4*1024*1024)
+#define REQUEST_BUFFER_SIZE (64*1024)
+#define STREAM_BUFFER_SIZE (16*1024)
+/*
+ * Streams that are not being walked are paused when they have this much data
+ * that has not been parsed.
+ */
+#define STREAM_PAUSE_SIZE (256*1024)
+#define DESIGN_CACHE_SIZE 1024
+#define MANGO_LIMIT 2147483647
 
 #define COUCHLIBDBO_REQUEST_GET 1
 #define COUCHLIBDBO_REQUEST_PUT 2
@@ -62,8 +74,26 @@ static int __couchdb_initialized = 0;
  */
 typedef struct libdbo_backend_couchdb {
     char* url;
+    /** The CURL handle, kept for the connection to reuse its connections. */
     CURL* curl;
+    /** The headers used for requests with JSON data. */
+    struct curl_slist* headers;
+    /** Shares connections between the connection and its streams. */
+    CURLSH* share;
+    /** Drives the transfers of all the streams of the connection. */
+    CURLM* multi;
+    /** The streams of the connection that have not been freed. */
+    struct libdbo_backend_couchdb_stream* stream_list;
+    /** The stream that more data is being transferred for. */
+    struct libdbo_backend_couchdb_stream* active;
+    /** The hashes of the design documents known to exist. */
+    unsigned char* design_cache;
+    /** Use Mango queries instead of views for reads with clauses. */
+    int mango;
+    /** The limit of documents returned by a Mango query. */
+    json_int_t mango_limit;
     char* buffer;
+    size_t buffer_size;
     size_t buffer_position;
     char* write;
     size_t write_length;
@@ -72,6 +102,51 @@ typedef struct libdbo_backend_couchdb {
 
 static libdbo_mm_t __couchdb_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_backend_couchdb_t));
 
+/**
+ * The CouchDB database backend specific data for streaming the rows of a view
+ * or the documents of a Mango query, each stream has its own CURL handle so
+ * that other requests can be made on the connection while the rows are being
+ * walked. All streams of a connection are transferred by the same CURL multi
+ * handle so they are in flight at the same time.
+ */
+typedef struct libdbo_backend_couchdb_stream {
+    libdbo_backend_couchdb_t* backend_couchdb;
+    CURL* curl;
+    const libdbo_object_t* object;
+    /** The hash of the design document used, if any. */
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    int hashed;
+    /** The rows are the documents in `docs` and not the rows of a view. */
+    int documents;
+    char* buffer;
+    size_t buffer_size;
+    size_t buffer_length;
+    /** The position in the buffer that has been parsed. */
+    size_t position;
+    /** The position in the buffer where the current row starts. */
+    size_t row;
+    int depth;
+    int in_string;
+    int escape;
+    int expect_key;
+    int in_key;
+    int rows_key;
+    int in_rows;
+    char key[8];
+    size_t key_length;
+    int done;
+    CURLcode status;
+    /** The transfer is paused until the stream is walked. */
+    int paused;
+    /** The result list walking the stream, gets the error if it fails. */
+    libdbo_result_list_t* result_list;
+    /** The stream has failed and no more rows are returned. */
+    int error;
+    struct libdbo_backend_couchdb_stream* next;
+} libdbo_backend_couchdb_stream_t;
+
+static libdbo_mm_t __couchdb_stream_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_backend_couchdb_stream_t));
+
 /*
 typedef struct libdbo_backend_couchdb_query {
     libdbo_backend_couchdb_t* backend_couchdb;
@@ -122,9 +197,23 @@ static int libdbo_backend_couchdb_shutdown(void* data) {
  */
 static size_t __db_backend_couchdb_write_response(void* ptr, size_t size, size_t nmemb, void* userdata) {
     libdbo_backend_couchdb_t* backend_couchdb = (libdbo_backend_couchdb_t*)userdata;
+    size_t buffer_size;
+    char* buffer;
 
-    if(backend_couchdb->buffer_position + size * nmemb >= REQUEST_BUFFER_SIZE - 1) {
-        return 0;
+    /*
+     * Grow the buffer if needed, one byte is always kept for terminating the
+     * response.
+     */
+    if (backend_couchdb->buffer_position + size * nmemb >= backend_couchdb->buffer_size) {
+        buffer_size = backend_couchdb->buffer_size;
+        while (backend_couchdb->buffer_position + size * nmemb >= buffer_size) {
+            buffer_size *= 2;
+        }
+        if (!(buffer = realloc(backend_couchdb->buffer, buffer_size))) {
+            return 0;
+        }
+        backend_couchdb->buffer = buffer;
+        backend_couchdb->buffer_size = buffer_size;
     }
 
     memcpy(backend_couchdb->buffer + backend_couchdb->buffer_position, ptr, size * nmemb);
@@ -159,22 +248,61 @@ static size_t __db_backend_couchdb_read_request(void* ptr, size_t size, size_t n
     return write;
 }
 
+/**
+ * Build the full URL for a request to CouchDB with the URL `request_url`.
+ * \param[in] backend_couchdb a libdbo_backend_couchdb_t pointer.
+ * \param[in] request_url a character pointer.
+ * \param[in] url a character pointer.
+ * \param[in] size a size_t.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_couchdb_url(const libdbo_backend_couchdb_t* backend_couchdb, const char* request_url, char* url, size_t size) {
+    char* urlp;
+    int ret, left;
+
+    left = size;
+    urlp = url;
+
+    if ((ret = snprintf(urlp, left, "%s", backend_couchdb->url)) >= left) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    urlp += ret;
+    left -= ret;
+
+    if (*(urlp - 1) != '/') {
+        if (*request_url != '/') {
+            if ((ret = snprintf(urlp, left, "/")) >= left) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            urlp += ret;
+            left -= ret;
+        }
+    }
+
+    if ((ret = snprintf(urlp, left, "%s", request_url)) >= left) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    return LIBDBO_OK;
+}
+
 /**
  * Make a request to CouchDB. The URL is specified by `request_url`, the request
  * type by `request_type` and the JSON data by `root`.
  * \param[in] backend_couchdb a libdbo_backend_couchdb_t pointer.
+ * \param[in] operation a libdbo_stats_operation_t for tracing.
+ * \param[in] object a libdbo_object_t pointer for tracing or NULL.
  * \param[in] request_url a character pointer.
  * \param[in] request_type an integer.
  * \param[in] root a json_t pointer.
  * \return a long with the HTTP response code or zero on error.
  */
-static long __db_backend_couchdb_request(libdbo_backend_couchdb_t* backend_couchdb, const char* request_url, int request_type, json_t* root) {
+static long __db_backend_couchdb_request(libdbo_backend_couchdb_t* backend_couchdb, libdbo_stats_operation_t operation, const libdbo_object_t* object, const char* request_url, int request_type, json_t* root) {
+    libdbo_trace_event_t event;
     CURLcode status;
     long code;
     char url[1024];
-    char* urlp;
-    int ret, left;
-    struct curl_slist* headers = NULL;
+    int traced;
 
     if (!backend_couchdb) {
         return 0;
@@ -182,48 +310,32 @@ static long __db_backend_couchdb_request(libdbo_backend_couchdb_t* backend_couch
     if (!backend_couchdb->url) {
         return 0;
     }
-    if (!backend_couchdb->buffer) {
-        return 0;
-    }
-    if (!request_url) {
+    if (!backend_couchdb->curl) {
         return 0;
     }
-
-    if (backend_couchdb->curl) {
-        curl_easy_cleanup(backend_couchdb->curl);
-    }
-    if (!(backend_couchdb->curl = curl_easy_init())) {
+    if (!backend_couchdb->buffer) {
         return 0;
     }
-
-    left = sizeof(url);
-    urlp = url;
-
-    if ((ret = snprintf(urlp, left, "%s", backend_couchdb->url)) >= left) {
+    if (!request_url) {
         return 0;
     }
-    urlp += ret;
-    left -= ret;
 
-    if (*(urlp - 1) != '/') {
-        if (*request_url != '/') {
-            if ((ret = snprintf(urlp, left, "/")) >= left) {
-                return 0;
-            }
-            urlp += ret;
-            left -= ret;
-        }
-    }
+    /*
+     * Reset the options of the previous request but keep the handle so that
+     * open connections are reused.
+     */
+    curl_easy_reset(backend_couchdb->curl);
 
-    if ((ret = snprintf(urlp, left, "%s", request_url)) >= left) {
+    if (__db_backend_couchdb_url(backend_couchdb, request_url, url, sizeof(url))) {
         return 0;
     }
-    urlp += ret;
-    left -= ret;
 
-    if ((status = curl_easy_setopt(backend_couchdb->curl, CURLOPT_URL, url))
+    if ((status = curl_easy_setopt(backend_couchdb->curl, CURLOPT_SHARE, backend_couchdb->share))
+        || (status = curl_easy_setopt(backend_couchdb->curl, CURLOPT_URL, url))
         || (status = curl_easy_setopt(backend_couchdb->curl, CURLOPT_WRITEFUNCTION, __db_backend_couchdb_write_response))
-        || (status = curl_easy_setopt(backend_couchdb->curl, CURLOPT_WRITEDATA, backend_couchdb)))
+        || (status = curl_easy_setopt(backend_couchdb->curl, CURLOPT_WRITEDATA, backend_couchdb))
+        || (status = curl_easy_setopt(backend_couchdb->curl, CURLOPT_TCP_NODELAY, 1L))
+        || (status = curl_easy_setopt(backend_couchdb->curl, CURLOPT_TCP_KEEPALIVE, 1L)))
     {
         puts(curl_easy_strerror(status));
         return 0;
@@ -249,15 +361,12 @@ static long __db_backend_couchdb_request(libdbo_backend_couchdb_t* backend_couch
         backend_couchdb->write_length = strlen(backend_couchdb->write);
         backend_couchdb->write_position = 0;
 
-        headers = curl_slist_append(headers, "Content-Type: application/json");
-
-        if ((status = curl_easy_setopt(backend_couchdb->curl, CURLOPT_HTTPHEADER, headers))
+        if ((status = curl_easy_setopt(backend_couchdb->curl, CURLOPT_HTTPHEADER, backend_couchdb->headers))
             || (status = curl_easy_setopt(backend_couchdb->curl, CURLOPT_INFILESIZE, (long)backend_couchdb->write_length))
             || (status = curl_easy_setopt(backend_couchdb->curl, CURLOPT_READFUNCTION, __db_backend_couchdb_read_request))
             || (status = curl_easy_setopt(backend_couchdb->curl, CURLOPT_READDATA, backend_couchdb))
             || (status = curl_easy_setopt(backend_couchdb->curl, CURLOPT_PUT, 1)))
         {
-            curl_slist_free_all(headers);
             free(backend_couchdb->write);
             backend_couchdb->write = NULL;
             puts(curl_easy_strerror(status));
@@ -280,16 +389,13 @@ static long __db_backend_couchdb_request(libdbo_backend_couchdb_t* backend_couch
         backend_couchdb->write_length = strlen(backend_couchdb->write);
         backend_couchdb->write_position = 0;
 
-        headers = curl_slist_append(headers, "Content-Type: application/json");
-
-        if ((status = curl_easy_setopt(backend_couchdb->curl, CURLOPT_HTTPHEADER, headers))
+        if ((status = curl_easy_setopt(backend_couchdb->curl, CURLOPT_HTTPHEADER, backend_couchdb->headers))
             || (status = curl_easy_setopt(backend_couchdb->curl, CURLOPT_POSTFIELDS, NULL))
             || (status = curl_easy_setopt(backend_couchdb->curl, CURLOPT_POSTFIELDSIZE, (long)backend_couchdb->write_length))
             || (status = curl_easy_setopt(backend_couchdb->curl, CURLOPT_READFUNCTION, __db_backend_couchdb_read_request))
             || (status = curl_easy_setopt(backend_couchdb->curl, CURLOPT_READDATA, backend_couchdb))
             || (status = curl_easy_setopt(backend_couchdb->curl, CURLOPT_POST, 1)))
         {
-            curl_slist_free_all(headers);
             free(backend_couchdb->write);
             backend_couchdb->write = NULL;
             puts(curl_easy_strerror(status));
@@ -308,39 +414,219 @@ static long __db_backend_couchdb_request(libdbo_backend_couchdb_t* backend_couch
         return 0;
     }
 
-    /*
-    puts(url);
-    if (backend_couchdb->write) puts(backend_couchdb->write);
-    curl_easy_setopt(backend_couchdb->curl, CURLOPT_VERBOSE, 1);
-    */
+    traced = LIBDBO_TRACE_CALL_BEGIN(&event, "couchdb", operation,
+        object ? libdbo_object_table(object) : NULL, url, 0);
+    status = curl_easy_perform(backend_couchdb->curl);
 
-    if ((status = curl_easy_perform(backend_couchdb->curl))) {
+    if (backend_couchdb->write) {
+        free(backend_couchdb->write);
+        backend_couchdb->write = NULL;
+    }
+    if (status) {
+        if (traced) {
+            LIBDBO_TRACE_CALL_END(&event, 0, LIBDBO_ERROR_UNKNOWN);
+        }
         puts(curl_easy_strerror(status));
         return 0;
     }
 
     backend_couchdb->buffer[backend_couchdb->buffer_position] = 0;
 
-    /*
-    puts(backend_couchdb->buffer);
-    */
+    if (curl_easy_getinfo(backend_couchdb->curl, CURLINFO_RESPONSE_CODE, &code) != CURLE_OK) {
+        code = 0;
+    }
+    if (traced) {
+        LIBDBO_TRACE_CALL_END(&event, 0,
+            code == 409 ? LIBDBO_ERROR_REVISION : (code >= 200 && code < 300 ? LIBDBO_OK : LIBDBO_ERROR_UNKNOWN));
+    }
+
+    return code;
+}
+
+/**
+ * Get the slot in the design document cache for the hash `hash`.
+ */
+static inline unsigned char* __db_backend_couchdb_design_slot(const libdbo_backend_couchdb_t* backend_couchdb, const unsigned char* hash) {
+    size_t index;
 
-    curl_easy_getinfo(backend_couchdb->curl, CURLINFO_RESPONSE_CODE, &code);
+    index = ((size_t)hash[0] << 24 | (size_t)hash[1] << 16 | (size_t)hash[2] << 8 | (size_t)hash[3]) % DESIGN_CACHE_SIZE;
+    return backend_couchdb->design_cache + (index * SHA256_DIGEST_LENGTH);
+}
 
-    if (headers) {
-        curl_slist_free_all(headers);
+/**
+ * Check if the design document with the hash `hash` is known to exist.
+ * \param[in] backend_couchdb a libdbo_backend_couchdb_t pointer.
+ * \param[in] hash an unsigned character pointer.
+ * \return non-zero if it exists, otherwise zero.
+ */
+static int __db_backend_couchdb_design_exists(const libdbo_backend_couchdb_t* backend_couchdb, const unsigned char* hash) {
+    if (!backend_couchdb->design_cache) {
+        return 0;
     }
-    if (backend_couchdb->write) {
-        free(backend_couchdb->write);
-        backend_couchdb->write = NULL;
+
+    return !memcmp(__db_backend_couchdb_design_slot(backend_couchdb, hash), hash, SHA256_DIGEST_LENGTH);
+}
+
+/**
+ * Remember that the design document with the hash `hash` exists, the cache
+ * has a fixed size and may replace a hash already in it.
+ * \param[in] backend_couchdb a libdbo_backend_couchdb_t pointer.
+ * \param[in] hash an unsigned character pointer.
+ */
+static void __db_backend_couchdb_design_add(libdbo_backend_couchdb_t* backend_couchdb, const unsigned char* hash) {
+    if (backend_couchdb->design_cache) {
+        memcpy(__db_backend_couchdb_design_slot(backend_couchdb, hash), hash, SHA256_DIGEST_LENGTH);
+    }
+}
+
+/**
+ * Forget the design document with the hash `hash`.
+ * \param[in] backend_couchdb a libdbo_backend_couchdb_t pointer.
+ * \param[in] hash an unsigned character pointer.
+ */
+static void __db_backend_couchdb_design_remove(libdbo_backend_couchdb_t* backend_couchdb, const unsigned char* hash) {
+    if (__db_backend_couchdb_design_exists(backend_couchdb, hash)) {
+        memset(__db_backend_couchdb_design_slot(backend_couchdb, hash), 0, SHA256_DIGEST_LENGTH);
     }
+}
 
-    return code;
+/**
+ * Load the hashes of all the design documents that exist in the database
+ * into the design document cache.
+ * \param[in] backend_couchdb a libdbo_backend_couchdb_t pointer.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_couchdb_design_preload(libdbo_backend_couchdb_t* backend_couchdb) {
+    json_t* root;
+    json_t* rows;
+    json_t* id;
+    json_error_t error;
+    size_t i, j;
+    const char* text;
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    unsigned int byte;
+
+    if (__db_backend_couchdb_request(backend_couchdb, LIBDBO_STATS_READ, NULL, "/_all_docs?startkey=%22_design%2F%22&endkey=%22_design0%22", COUCHLIBDBO_REQUEST_GET, NULL) != 200) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (!(root = json_loadb(backend_couchdb->buffer, backend_couchdb->buffer_position, 0, &error))) {
+        libdbo_log(LIBDBO_LOG_ERROR, "CouchDB design preload JSON error on line %d: %s",
+            error.line, error.text);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!(rows = json_object_get(root, "rows"))
+        || !json_is_array(rows))
+    {
+        json_decref(root);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    for (i = 0; i < json_array_size(rows); i++) {
+        if (!(id = json_object_get(json_array_get(rows, i), "id"))
+            || !(text = json_string_value(id))
+            || strncmp(text, "_design/", 8)
+            || strlen(text + 8) != SHA256_DIGEST_LENGTH * 2)
+        {
+            continue;
+        }
+        text += 8;
+
+        for (j = 0; j < SHA256_DIGEST_LENGTH; j++) {
+            if (sscanf(text + (j * 2), "%2x", &byte) != 1) {
+                break;
+            }
+            hash[j] = byte;
+        }
+        if (j == SHA256_DIGEST_LENGTH) {
+            __db_backend_couchdb_design_add(backend_couchdb, hash);
+        }
+    }
+
+    json_decref(root);
+    return LIBDBO_OK;
+}
+
+/**
+ * Create the design document `_design/<hash_string>` with a view named `view`
+ * using the map function `map_function` and the built-in `_count` reduce
+ * function.
+ * \param[in] backend_couchdb a libdbo_backend_couchdb_t pointer.
+ * \param[in] hash_string a character pointer.
+ * \param[in] map_function a character pointer.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_couchdb_put_design(libdbo_backend_couchdb_t* backend_couchdb, const char* hash_string, const char* map_function) {
+    json_t* map = NULL;
+    json_t* view = NULL;
+    json_t* views = NULL;
+    json_t* root = NULL;
+    char string[1024];
+    long code;
+
+    if (!(map = json_string(map_function))
+        || !(view = json_object())
+        || !(views = json_object())
+        || !(root = json_object()))
+    {
+        json_decref(map);
+        json_decref(view);
+        json_decref(views);
+        json_decref(root);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (json_object_set(view, "map", map)) {
+        json_decref(map);
+        json_decref(view);
+        json_decref(views);
+        json_decref(root);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    json_decref(map);
+
+    if (json_object_set_new(view, "reduce", json_string("_count"))) {
+        json_decref(view);
+        json_decref(views);
+        json_decref(root);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (json_object_set(views, "view", view)) {
+        json_decref(view);
+        json_decref(views);
+        json_decref(root);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    json_decref(view);
+
+    if (json_object_set(root, "views", views)) {
+        json_decref(views);
+        json_decref(root);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    json_decref(views);
+
+    if (snprintf(string, sizeof(string), "/_design/%s", hash_string) >= (int)sizeof(string)) {
+        json_decref(root);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    code = __db_backend_couchdb_request(backend_couchdb, LIBDBO_STATS_READ, NULL, string, COUCHLIBDBO_REQUEST_PUT, root);
+    json_decref(root);
+    if (code != 201 && code != 202 && code != 409) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    return LIBDBO_OK;
 }
 
 static int libdbo_backend_couchdb_connect(void* data, const libdbo_configuration_list_t* configuration_list) {
     libdbo_backend_couchdb_t* backend_couchdb = (libdbo_backend_couchdb_t*)data;
     const libdbo_configuration_t* url;
+    const libdbo_configuration_t* preload_design;
+    const libdbo_configuration_t* query;
+    const libdbo_configuration_t* mango_limit;
 
     if (!__couchdb_initialized) {
         return LIBDBO_ERROR_UNKNOWN;
@@ -359,6 +645,7 @@ static int libdbo_backend_couchdb_connect(void* data, const libdbo_configuration
         if (!(backend_couchdb->buffer = calloc(REQUEST_BUFFER_SIZE, 1))) {
             return LIBDBO_ERROR_UNKNOWN;
         }
+        backend_couchdb->buffer_size = REQUEST_BUFFER_SIZE;
     }
 
     if (!(url = libdbo_configuration_list_find(configuration_list, "url"))) {
@@ -371,11 +658,65 @@ static int libdbo_backend_couchdb_connect(void* data, const libdbo_configuration
         return LIBDBO_ERROR_UNKNOWN;
     }
 
+    backend_couchdb->mango = 0;
+    if ((query = libdbo_configuration_list_find(configuration_list, "query"))) {
+        if (!strcmp(libdbo_configuration_value(query), "mango")) {
+            backend_couchdb->mango = 1;
+        }
+        else if (strcmp(libdbo_configuration_value(query), "view")) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+    backend_couchdb->mango_limit = MANGO_LIMIT;
+    if ((mango_limit = libdbo_configuration_list_find(configuration_list, "mango_limit"))) {
+        if ((backend_couchdb->mango_limit = atoi(libdbo_configuration_value(mango_limit))) < 1) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+
+    /*
+     * Create the CURL handle and headers that are used for all requests on
+     * this connection.
+     */
+    if (!backend_couchdb->headers
+        && !(backend_couchdb->headers = curl_slist_append(NULL, "Content-Type: application/json")))
+    {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_couchdb->share) {
+        if (!(backend_couchdb->share = curl_share_init())
+            || curl_share_setopt(backend_couchdb->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT)
+            || curl_share_setopt(backend_couchdb->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS))
+        {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+    if (!backend_couchdb->multi && !(backend_couchdb->multi = curl_multi_init())) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!(backend_couchdb->curl = curl_easy_init())) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (!backend_couchdb->design_cache) {
+        if (!(backend_couchdb->design_cache = calloc(DESIGN_CACHE_SIZE, SHA256_DIGEST_LENGTH))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+    if ((preload_design = libdbo_configuration_list_find(configuration_list, "preload_design"))
+        && atoi(libdbo_configuration_value(preload_design)))
+    {
+        if (__db_backend_couchdb_design_preload(backend_couchdb)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+
     return LIBDBO_OK;
 }
 
 static int libdbo_backend_couchdb_disconnect(void* data) {
     libdbo_backend_couchdb_t* backend_couchdb = (libdbo_backend_couchdb_t*)data;
+    libdbo_backend_couchdb_stream_t* stream;
 
     if (!__couchdb_initialized) {
         return LIBDBO_ERROR_UNKNOWN;
@@ -388,6 +729,39 @@ static int libdbo_backend_couchdb_disconnect(void* data) {
         curl_easy_cleanup(backend_couchdb->curl);
         backend_couchdb->curl = NULL;
     }
+    if (backend_couchdb->headers) {
+        curl_slist_free_all(backend_couchdb->headers);
+        backend_couchdb->headers = NULL;
+    }
+
+    /*
+     * Result lists may still be walking streams of the connection, stop their
+     * transfers and detach them so they can be freed later. The rows already
+     * received are still returned after that but a stream that was not done
+     * fails when it needs more.
+     */
+    while ((stream = backend_couchdb->stream_list)) {
+        backend_couchdb->stream_list = stream->next;
+        stream->next = NULL;
+        if (stream->curl) {
+            curl_multi_remove_handle(backend_couchdb->multi, stream->curl);
+            curl_easy_cleanup(stream->curl);
+            stream->curl = NULL;
+        }
+        stream->backend_couchdb = NULL;
+    }
+    if (backend_couchdb->multi) {
+        curl_multi_cleanup(backend_couchdb->multi);
+        backend_couchdb->multi = NULL;
+    }
+    if (backend_couchdb->share) {
+        curl_share_cleanup(backend_couchdb->share);
+        backend_couchdb->share = NULL;
+    }
+    if (backend_couchdb->design_cache) {
+        free(backend_couchdb->design_cache);
+        backend_couchdb->design_cache = NULL;
+    }
 
     return LIBDBO_OK;
 }
@@ -523,6 +897,7 @@ static int libdbo_backend_couchdb_create(void* data, const libdbo_object_t* obje
         }
 
         object_field = libdbo_object_field_next(object_field);
+        value_pos++;
     }
 
     if (!(json_value = json_string(libdbo_object_table(object)))) {
@@ -535,7 +910,7 @@ static int libdbo_backend_couchdb_create(void* data, const libdbo_object_t* obje
         return LIBDBO_ERROR_UNKNOWN;
     }
 
-    code = __db_backend_couchdb_request(backend_couchdb, "", COUCHLIBDBO_REQUEST_POST, root);
+    code = __db_backend_couchdb_request(backend_couchdb, LIBDBO_STATS_CREATE, object, "", COUCHLIBDBO_REQUEST_POST, root);
     json_decref(root);
     if (code != 201 && code != 202) {
         return LIBDBO_ERROR_UNKNOWN;
@@ -711,100 +1086,471 @@ static libdbo_result_t* __db_backend_couchdb_result_from_json_object(const libdb
 }
 
 /**
- * Store the response from a CouchDB request into a database result list
- * specified by `result_list`. If the response comes from a CouchDB view then
- * `view` must be non-zero.
- * \param[in] backend_couchdb a libdbo_backend_couchdb_t pointer.
- * \param[in] object a libdbo_object_t pointer.
- * \param[in] result_list a libdbo_result_list_t pointer.
- * \param[in] view an integer.
- * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ * Callback function for CURL to get the response from a streamed HTTP
+ * request, only the data that has not been parsed into rows is kept.
+ * \param[in] ptr a void pointer.
+ * \param[in] size a size_t.
+ * \param[in] nmemb a size_t.
+ * \param[in] userdata a void pointer.
+ * \return a size_t.
  */
-static int __db_backend_couchdb_store_result(libdbo_backend_couchdb_t* backend_couchdb, const libdbo_object_t* object, libdbo_result_list_t* result_list, int view) {
-    json_t *root;
-    json_t *rows;
-    json_t *entry;
-    json_error_t error;
-    size_t i;
-    libdbo_result_t* result;
+static size_t __db_backend_couchdb_stream_write(void* ptr, size_t size, size_t nmemb, void* userdata) {
+    libdbo_backend_couchdb_stream_t* stream = (libdbo_backend_couchdb_stream_t*)userdata;
+    size_t length = size * nmemb;
+    size_t buffer_size;
+    char* buffer;
 
-    if (!(root = json_loads(backend_couchdb->buffer, 0, &error))) {
-        fprintf(stderr, "error: on line %d: %s\n", error.line, error.text);
-        return LIBDBO_ERROR_UNKNOWN;
+    /*
+     * Stop the transfer of a stream that is not walked when it has buffered
+     * enough, CURL delivers the data again when it is resumed.
+     */
+    if (stream != stream->backend_couchdb->active
+        && stream->buffer_length >= STREAM_PAUSE_SIZE)
+    {
+        stream->paused = 1;
+        return CURL_WRITEFUNC_PAUSE;
     }
 
-    if (view) {
-        if (!json_is_object(root)) {
-            json_decref(root);
-            return LIBDBO_ERROR_UNKNOWN;
+    if (stream->buffer_length + length > stream->buffer_size) {
+        buffer_size = stream->buffer_size;
+        while (stream->buffer_length + length > buffer_size) {
+            buffer_size *= 2;
         }
-        rows = json_object_get(root, "rows");
-        if (!rows) {
-            json_decref(root);
-            return LIBDBO_ERROR_UNKNOWN;
+        if (!(buffer = realloc(stream->buffer, buffer_size))) {
+            return 0;
         }
-    }
-    else {
-        rows = root;
+        stream->buffer = buffer;
+        stream->buffer_size = buffer_size;
     }
 
-    if (json_is_object(rows)) {
-        if (view) {
-            entry = json_object_get(rows, "doc");
-            if (!entry) {
-                json_decref(root);
-                return LIBDBO_ERROR_UNKNOWN;
+    memcpy(stream->buffer + stream->buffer_length, ptr, length);
+    stream->buffer_length += length;
+
+    return length;
+}
+
+/**
+ * Free a stream and its CURL handle, the stream is removed from its connection
+ * unless the connection has been disconnected.
+ * \param[in] stream a libdbo_backend_couchdb_stream_t pointer.
+ */
+static void __db_backend_couchdb_stream_free(libdbo_backend_couchdb_stream_t* stream) {
+    libdbo_backend_couchdb_stream_t** streamp;
+
+    if (stream) {
+        if (stream->backend_couchdb) {
+            for (streamp = &(stream->backend_couchdb->stream_list); *streamp; streamp = &((*streamp)->next)) {
+                if (*streamp == stream) {
+                    *streamp = stream->next;
+                    break;
+                }
             }
         }
-        else {
-            entry = rows;
+        if (stream->curl) {
+            if (stream->backend_couchdb && stream->backend_couchdb->multi) {
+                curl_multi_remove_handle(stream->backend_couchdb->multi, stream->curl);
+            }
+            curl_easy_cleanup(stream->curl);
         }
+        free(stream->buffer);
+        libdbo_mm_delete(&__couchdb_stream_alloc, stream);
+    }
+}
 
-        if (!(result = __db_backend_couchdb_result_from_json_object(object, entry))) {
-            json_decref(root);
+/**
+ * Let CURL transfer more data for a stream, waits for data if none is
+ * available. This also transfers the data of all the other streams of the
+ * connection until they have STREAM_PAUSE_SIZE of data buffered, they are
+ * then paused until they are walked.
+ * \param[in] stream a libdbo_backend_couchdb_stream_t pointer.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_couchdb_stream_perform(libdbo_backend_couchdb_stream_t* stream) {
+    CURLM* multi;
+    libdbo_backend_couchdb_stream_t* done_stream;
+    size_t buffer_length = stream->buffer_length;
+    int running, msgs;
+    CURLMsg* msg;
+    int ret = LIBDBO_OK;
+
+    if (!stream->backend_couchdb) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!(multi = stream->backend_couchdb->multi)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    stream->backend_couchdb->active = stream;
+    if (stream->paused) {
+        stream->paused = 0;
+        if (curl_easy_pause(stream->curl, CURLPAUSE_CONT) != CURLE_OK) {
+            stream->backend_couchdb->active = NULL;
             return LIBDBO_ERROR_UNKNOWN;
         }
+    }
 
-        if (libdbo_result_list_add(result_list, result)) {
-            json_decref(root);
-            libdbo_result_free(result);
-            return LIBDBO_ERROR_UNKNOWN;
+    for (;;) {
+        if (curl_multi_perform(multi, &running) != CURLM_OK) {
+            ret = LIBDBO_ERROR_UNKNOWN;
+            break;
+        }
+        while ((msg = curl_multi_info_read(multi, &msgs))) {
+            if (msg->msg == CURLMSG_DONE
+                && curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char**)&done_stream) == CURLE_OK
+                && done_stream)
+            {
+                done_stream->done = 1;
+                done_stream->status = msg->data.result;
+            }
+        }
+        if (stream->done || stream->buffer_length != buffer_length) {
+            break;
+        }
+        if (curl_multi_wait(multi, NULL, 0, 1000, NULL) != CURLM_OK) {
+            ret = LIBDBO_ERROR_UNKNOWN;
+            break;
         }
     }
-    else if (json_is_array(rows)) {
-        for (i = 0; i < json_array_size(rows); i++) {
-            entry = json_array_get(rows, i);
-            if (!json_is_object(entry)) {
-                json_decref(root);
-                return LIBDBO_ERROR_UNKNOWN;
+
+    stream->backend_couchdb->active = NULL;
+    return ret;
+}
+
+/**
+ * Parse the streamed data of a view for the next complete row, the parser
+ * only tracks the structure of the JSON to find where each row in `rows`, or
+ * `docs` for a Mango query, starts and ends.
+ * \param[in] stream a libdbo_backend_couchdb_stream_t pointer.
+ * \return 1 if a complete row was found, the row is between `stream->row` and
+ * `stream->position`, otherwise 0.
+ */
+static int __db_backend_couchdb_stream_row(libdbo_backend_couchdb_stream_t* stream) {
+    char c;
+
+    while (stream->position < stream->buffer_length) {
+        c = stream->buffer[stream->position++];
+
+        if (stream->in_string) {
+            if (stream->escape) {
+                stream->escape = 0;
+            }
+            else if (c == '\\') {
+                stream->escape = 1;
+            }
+            else if (c == '"') {
+                stream->in_string = 0;
+            }
+            else if (stream->in_key && stream->key_length < sizeof(stream->key)) {
+                stream->key[stream->key_length++] = c;
             }
+            continue;
+        }
 
-            if (view) {
-                entry = json_object_get(entry, "doc");
-                if (!entry) {
-                    json_decref(root);
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
+        switch (c) {
+        case '"':
+            stream->in_string = 1;
+            stream->in_key = stream->depth == 1 && stream->expect_key;
+            stream->key_length = 0;
+            stream->expect_key = 0;
+            break;
+
+        case ':':
+            if (stream->depth == 1) {
+                stream->rows_key = stream->in_key && stream->key_length == 4 && !memcmp(stream->key, stream->documents ? "docs" : "rows", 4);
+                stream->in_key = 0;
             }
+            break;
 
-            if (!(result = __db_backend_couchdb_result_from_json_object(object, entry))) {
-                json_decref(root);
-                return LIBDBO_ERROR_UNKNOWN;
+        case ',':
+            if (stream->depth == 1) {
+                stream->expect_key = 1;
+            }
+            break;
+
+        case '{':
+        case '[':
+            stream->depth++;
+            if (stream->depth == 1 && c == '{') {
+                stream->expect_key = 1;
+            }
+            else if (stream->depth == 2 && c == '[' && stream->rows_key) {
+                stream->in_rows = 1;
             }
+            else if (stream->depth == 3 && stream->in_rows && c == '{') {
+                stream->row = stream->position - 1;
+            }
+            break;
+
+        case '}':
+        case ']':
+            stream->depth--;
+            if (stream->depth == 2 && stream->in_rows && c == '}') {
+                return 1;
+            }
+            if (stream->depth == 1) {
+                stream->in_rows = 0;
+                stream->rows_key = 0;
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Remove the data that has been parsed and is not part of a row still being
+ * received.
+ * \param[in] stream a libdbo_backend_couchdb_stream_t pointer.
+ */
+static void __db_backend_couchdb_stream_compact(libdbo_backend_couchdb_stream_t* stream) {
+    size_t keep;
+
+    keep = (stream->depth > 2 && stream->in_rows) ? stream->row : stream->position;
+    if (keep) {
+        memmove(stream->buffer, stream->buffer + keep, stream->buffer_length - keep);
+        stream->buffer_length -= keep;
+        stream->position -= keep;
+        if (stream->row >= keep) {
+            stream->row -= keep;
+        }
+        else {
+            stream->row = 0;
+        }
+    }
+}
+
+/**
+ * Mark a stream as failed, the error is set on the result list walking it so
+ * that the rows returned so far are not taken as all of them.
+ * \param[in] stream a libdbo_backend_couchdb_stream_t pointer.
+ */
+static void __db_backend_couchdb_stream_error(libdbo_backend_couchdb_stream_t* stream) {
+    stream->error = 1;
+    if (stream->result_list) {
+        libdbo_result_list_set_error(stream->result_list, LIBDBO_ERROR_UNKNOWN);
+    }
+}
+
+static libdbo_result_t* libdbo_backend_couchdb_next(void* data, int finish) {
+    libdbo_backend_couchdb_stream_t* stream = (libdbo_backend_couchdb_stream_t*)data;
+    json_t* root;
+    json_t* entry;
+    json_error_t error;
+    libdbo_result_t* result;
+
+    if (!stream) {
+        return NULL;
+    }
+
+    if (finish) {
+        __db_backend_couchdb_stream_free(stream);
+        return NULL;
+    }
+    if (stream->error) {
+        return NULL;
+    }
 
-            if (libdbo_result_list_add(result_list, result)) {
+    for (;;) {
+        if (__db_backend_couchdb_stream_row(stream)) {
+            if (!(root = json_loadb(stream->buffer + stream->row, stream->position - stream->row, 0, &error))) {
+                libdbo_log(LIBDBO_LOG_ERROR, "CouchDB stream parse error on line %d: %s",
+                    error.line, error.text);
+                __db_backend_couchdb_stream_error(stream);
+                return NULL;
+            }
+            entry = stream->documents ? root : json_object_get(root, "doc");
+            if (!entry || json_is_null(entry)) {
+                /*
+                 * Rows for ids that does not exist, or has been deleted, have
+                 * no document.
+                 */
                 json_decref(root);
-                libdbo_result_free(result);
-                return LIBDBO_ERROR_UNKNOWN;
+                continue;
+            }
+            if (!(result = __db_backend_couchdb_result_from_json_object(stream->object, entry))) {
+                libdbo_log(LIBDBO_LOG_ERROR, "CouchDB stream row is not a %s object",
+                    libdbo_object_table(stream->object));
+                json_decref(root);
+                __db_backend_couchdb_stream_error(stream);
+                return NULL;
             }
+            json_decref(root);
+            return result;
+        }
+
+        if (stream->done) {
+            if (stream->status != CURLE_OK) {
+                libdbo_log(LIBDBO_LOG_ERROR, "CouchDB stream transfer error: %s",
+                    curl_easy_strerror(stream->status));
+                __db_backend_couchdb_stream_error(stream);
+            }
+            else if (stream->depth || stream->in_string) {
+                libdbo_log(LIBDBO_LOG_ERROR, "CouchDB stream ended before the end of the response");
+                __db_backend_couchdb_stream_error(stream);
+            }
+            return NULL;
+        }
+
+        if (!stream->backend_couchdb) {
+            libdbo_log(LIBDBO_LOG_ERROR, "CouchDB stream ended by the connection being disconnected");
+            __db_backend_couchdb_stream_error(stream);
+            return NULL;
+        }
+
+        __db_backend_couchdb_stream_compact(stream);
+        if (__db_backend_couchdb_stream_perform(stream)) {
+            libdbo_log(LIBDBO_LOG_ERROR, "CouchDB stream transfer failed");
+            __db_backend_couchdb_stream_error(stream);
+            return NULL;
         }
     }
-    else {
-        json_decref(root);
-        return LIBDBO_ERROR_UNKNOWN;
+}
+
+/**
+ * Start a streamed GET request of a view with the URL `request_url`. If `root`
+ * is given it is POSTed instead, if `documents` is non-zero the response is
+ * from a Mango query and has documents and not the rows of a view. The hash of
+ * the design document used can be given in `hash`. The request is in flight
+ * when this returns, use __db_backend_couchdb_stream_result() to get the
+ * result list.
+ * \param[in] backend_couchdb a libdbo_backend_couchdb_t pointer.
+ * \param[in] object a libdbo_object_t pointer.
+ * \param[in] request_url a character pointer.
+ * \param[in] root a json_t pointer.
+ * \param[in] documents an integer.
+ * \param[in] hash an unsigned character pointer.
+ * \return a libdbo_backend_couchdb_stream_t pointer or NULL on error.
+ */
+static libdbo_backend_couchdb_stream_t* __db_backend_couchdb_stream_start(libdbo_backend_couchdb_t* backend_couchdb, const libdbo_object_t* object, const char* request_url, json_t* root, int documents, const unsigned char* hash) {
+    libdbo_backend_couchdb_stream_t* stream;
+    char url[1024];
+    char* write = NULL;
+
+    if (!backend_couchdb) {
+        return NULL;
     }
-    json_decref(root);
-    return LIBDBO_OK;
+    if (!backend_couchdb->url) {
+        return NULL;
+    }
+    if (!backend_couchdb->multi) {
+        return NULL;
+    }
+    if (!object) {
+        return NULL;
+    }
+    if (!request_url) {
+        return NULL;
+    }
+
+    if (__db_backend_couchdb_url(backend_couchdb, request_url, url, sizeof(url))) {
+        return NULL;
+    }
+
+    if (!(stream = libdbo_mm_new0(&__couchdb_stream_alloc))) {
+        return NULL;
+    }
+    stream->backend_couchdb = backend_couchdb;
+    stream->next = backend_couchdb->stream_list;
+    backend_couchdb->stream_list = stream;
+    stream->object = object;
+    stream->documents = documents;
+    stream->buffer_size = STREAM_BUFFER_SIZE;
+    if (hash) {
+        memcpy(stream->hash, hash, SHA256_DIGEST_LENGTH);
+        stream->hashed = 1;
+    }
+
+    if (root && !(write = json_dumps(root, JSON_ENSURE_ASCII))) {
+        __db_backend_couchdb_stream_free(stream);
+        return NULL;
+    }
+
+    if (!(stream->buffer = malloc(stream->buffer_size))
+        || !(stream->curl = curl_easy_init())
+        || curl_easy_setopt(stream->curl, CURLOPT_SHARE, backend_couchdb->share)
+        || curl_easy_setopt(stream->curl, CURLOPT_PRIVATE, (char*)stream)
+        || curl_easy_setopt(stream->curl, CURLOPT_URL, url)
+        || curl_easy_setopt(stream->curl, CURLOPT_WRITEFUNCTION, __db_backend_couchdb_stream_write)
+        || curl_easy_setopt(stream->curl, CURLOPT_WRITEDATA, stream)
+        || curl_easy_setopt(stream->curl, CURLOPT_TCP_NODELAY, 1L)
+        || curl_easy_setopt(stream->curl, CURLOPT_TCP_KEEPALIVE, 1L)
+        || (write
+            && (curl_easy_setopt(stream->curl, CURLOPT_HTTPHEADER, backend_couchdb->headers)
+                || curl_easy_setopt(stream->curl, CURLOPT_POSTFIELDSIZE, (long)strlen(write))
+                || curl_easy_setopt(stream->curl, CURLOPT_COPYPOSTFIELDS, write)))
+        || curl_multi_add_handle(backend_couchdb->multi, stream->curl) != CURLM_OK)
+    {
+        free(write);
+        __db_backend_couchdb_stream_free(stream);
+        return NULL;
+    }
+    free(write);
+
+    return stream;
+}
+
+/**
+ * Wait for the response of a stream started with
+ * __db_backend_couchdb_stream_start() and create the result list that parses
+ * the rows when walked. The stream is freed on error.
+ * \param[in] stream a libdbo_backend_couchdb_stream_t pointer.
+ * \return a libdbo_result_list_t pointer or NULL on error.
+ */
+static libdbo_result_list_t* __db_backend_couchdb_stream_result(libdbo_backend_couchdb_stream_t* stream) {
+    libdbo_result_list_t* result_list;
+    libdbo_trace_event_t event;
+    long code = 0;
+    char* url = NULL;
+    int traced;
+
+    if (!stream) {
+        return NULL;
+    }
+
+    /*
+     * Transfer until we know the HTTP response code, the rows are streamed
+     * after that so only this part is traced.
+     */
+    traced = LIBDBO_TRACE_CALL_BEGIN(&event, "couchdb", LIBDBO_STATS_READ,
+        libdbo_object_table(stream->object),
+        curl_easy_getinfo(stream->curl, CURLINFO_EFFECTIVE_URL, &url) == CURLE_OK ? url : NULL, 0);
+    while (!code) {
+        if (__db_backend_couchdb_stream_perform(stream)
+            || curl_easy_getinfo(stream->curl, CURLINFO_RESPONSE_CODE, &code) != CURLE_OK
+            || (stream->done && (stream->status != CURLE_OK || !code)))
+        {
+            code = 0;
+            break;
+        }
+    }
+    if (traced) {
+        LIBDBO_TRACE_CALL_END(&event, 0, code == 200 ? LIBDBO_OK : LIBDBO_ERROR_UNKNOWN);
+    }
+    if (code != 200) {
+        if (stream->hashed) {
+            /*
+             * The design document may have been removed, make sure it is
+             * created on the next read.
+             */
+            __db_backend_couchdb_design_remove(stream->backend_couchdb, stream->hash);
+        }
+        __db_backend_couchdb_stream_free(stream);
+        return NULL;
+    }
+
+    if (!(result_list = libdbo_result_list_new())
+        || libdbo_result_list_set_next(result_list, libdbo_backend_couchdb_next, stream, 0))
+    {
+        libdbo_result_list_free(result_list);
+        __db_backend_couchdb_stream_free(stream);
+        return NULL;
+    }
+    stream->result_list = result_list;
+    return result_list;
 }
 
 /**
@@ -844,6 +1590,10 @@ static int __db_backend_couchdb_build_map_function(const libdbo_object_t* object
 
     clause = libdbo_clause_list_begin(clause_list);
     while (clause) {
+        /*
+         * The operator joins the clause with the previous one so the first
+         * clause in the list does not have one.
+         */
         switch (libdbo_clause_operator(clause)) {
         case LIBDBO_CLAUSE_OPERATOR_AND:
             if ((ret = snprintf(*stringp, *left, " &&")) >= *left) {
@@ -860,10 +1610,20 @@ static int __db_backend_couchdb_build_map_function(const libdbo_object_t* object
         default:
             return LIBDBO_ERROR_UNKNOWN;
         }
-        *stringp += ret;
-        *left -= ret;
+        if (clause != libdbo_clause_list_begin(clause_list)) {
+            *stringp += ret;
+            *left -= ret;
+        }
 
-        if ((ret = snprintf(*stringp, *left, " doc.%s_%s", libdbo_object_table(object), libdbo_clause_field(clause))) >= *left) {
+        if (libdbo_clause_type(clause) == LIBDBO_CLAUSE_NESTED) {
+            ret = 0;
+        }
+        else if (!strcmp(libdbo_clause_field(clause), libdbo_object_primary_key_name(object))) {
+            if ((ret = snprintf(*stringp, *left, " doc._id")) >= *left) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+        }
+        else if ((ret = snprintf(*stringp, *left, " doc.%s_%s", libdbo_object_table(object), libdbo_clause_field(clause))) >= *left) {
             return LIBDBO_ERROR_UNKNOWN;
         }
         *stringp += ret;
@@ -1031,309 +1791,953 @@ static int __db_backend_couchdb_build_map_function(const libdbo_object_t* object
     return LIBDBO_OK;
 }
 
-static libdbo_result_list_t* libdbo_backend_couchdb_read(void* data, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list) {
-    libdbo_backend_couchdb_t* backend_couchdb = (libdbo_backend_couchdb_t*)data;
-    long code;
-    libdbo_result_list_t* result_list;
+/**
+ * Create, unless it is known to already exist, the design document with a view
+ * of the objects matching the database clause list `clause_list`, or all
+ * objects if `clause_list` is NULL. The hash naming the design document is
+ * stored in `hash` and `hash_string`.
+ * \param[in] backend_couchdb a libdbo_backend_couchdb_t pointer.
+ * \param[in] object a libdbo_object_t pointer.
+ * \param[in] clause_list a libdbo_clause_list_t pointer.
+ * \param[in] hash an unsigned character pointer.
+ * \param[in] hash_string a character pointer.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_couchdb_view(libdbo_backend_couchdb_t* backend_couchdb, const libdbo_object_t* object, const libdbo_clause_list_t* clause_list, unsigned char* hash, char* hash_string) {
     char string[4096];
     char* stringp;
-    int ret, left, only_ids, have_clauses;
-    const libdbo_clause_t* clause;
-    libdbo_type_int32_t int32;
-    libdbo_type_uint32_t uint32;
-    libdbo_type_int64_t int64;
-    libdbo_type_uint64_t uint64;
-    unsigned char hash[SHA256_DIGEST_LENGTH];
-    char hash_string[(SHA256_DIGEST_LENGTH*2)+1];
+    int ret, left;
     SHA256_CTX sha256;
 
-    if (!__couchdb_initialized) {
-        return NULL;
-    }
-    if (!backend_couchdb) {
-        return NULL;
-    }
-    if (!object) {
-        return NULL;
+    left = sizeof(string);
+    stringp = string;
+
+    if ((ret = snprintf(stringp, left, "function(doc) { if (doc.type == \"%s\"", libdbo_object_table(object))) >= left) {
+        return LIBDBO_ERROR_UNKNOWN;
     }
+    stringp += ret;
+    left -= ret;
 
-    if (join_list) {
-        /*
-         * Joins is not supported by this backend, check if there are any and
-         * return error if so.
-         */
-        if (libdbo_join_list_begin(join_list)) {
-            return NULL;
+    if (clause_list && libdbo_clause_list_begin(clause_list)) {
+        if ((ret = snprintf(stringp, left, " && (")) >= left) {
+            return LIBDBO_ERROR_UNKNOWN;
         }
-    }
+        stringp += ret;
+        left -= ret;
 
-    only_ids = 0;
-    have_clauses = 0;
-    if (clause_list) {
-        clause = libdbo_clause_list_begin(clause_list);
-        only_ids = 1;
-        while (clause) {
-            if (libdbo_clause_table(clause)) {
-                /*
-                 * This backend only supports clauses on the objects table.
-                 */
-                if (strcmp(libdbo_clause_table(clause), libdbo_object_table(object))) {
-                    return NULL;
-                }
-            }
+        if (__db_backend_couchdb_build_map_function(object, clause_list, &stringp, &left)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
 
-            if (strcmp(libdbo_clause_field(clause), libdbo_object_primary_key_name(object))) {
-                only_ids = 0;
-                have_clauses = 1;
-            }
-            clause = libdbo_clause_next(clause);
+        if ((ret = snprintf(stringp, left, " )")) >= left) {
+            return LIBDBO_ERROR_UNKNOWN;
         }
+        stringp += ret;
+        left -= ret;
     }
 
-    if (!(result_list = libdbo_result_list_new())) {
-        return NULL;
+    if ((ret = snprintf(stringp, left, ") { emit(doc._id, null); } }")) >= left) {
+        return LIBDBO_ERROR_UNKNOWN;
     }
+    stringp += ret;
+    left -= ret;
 
-    if (only_ids) {
-        clause = libdbo_clause_list_begin(clause_list);
-        while (clause) {
-            left = sizeof(string);
-            stringp = string;
-
-            switch (libdbo_value_type(libdbo_clause_value(clause))) {
-            case LIBDBO_TYPE_INT32:
-                if (libdbo_value_to_int32(libdbo_clause_value(clause), &int32)) {
-                    libdbo_result_list_free(result_list);
-                    return NULL;
-                }
-                if ((ret = snprintf(stringp, left, "/%d", int32)) >= left) {
-                    libdbo_result_list_free(result_list);
-                    return NULL;
-                }
-                break;
-
-            case LIBDBO_TYPE_UINT32:
-                if (libdbo_value_to_uint32(libdbo_clause_value(clause), &uint32)) {
-                    libdbo_result_list_free(result_list);
-                    return NULL;
-                }
-                if ((ret = snprintf(stringp, left, "/%u", uint32)) >= left) {
-                    libdbo_result_list_free(result_list);
-                    return NULL;
-                }
-                break;
-
-            case LIBDBO_TYPE_INT64:
-                if (libdbo_value_to_int64(libdbo_clause_value(clause), &int64)) {
-                    libdbo_result_list_free(result_list);
-                    return NULL;
-                }
-                if ((ret = snprintf(stringp, left, "/%ld", int64)) >= left) {
-                    libdbo_result_list_free(result_list);
-                    return NULL;
-                }
-                break;
-
-            case LIBDBO_TYPE_UINT64:
-                if (libdbo_value_to_uint64(libdbo_clause_value(clause), &uint64)) {
-                    libdbo_result_list_free(result_list);
-                    return NULL;
-                }
-                if ((ret = snprintf(stringp, left, "/%lu", uint64)) >= left) {
-                    libdbo_result_list_free(result_list);
-                    return NULL;
-                }
-                break;
+    SHA256_Init(&sha256);
+    SHA256_Update(&sha256, string, (unsigned long)(stringp - string));
+    SHA256_Final(hash, &sha256);
 
-            case LIBDBO_TYPE_TEXT:
-                if ((ret = snprintf(stringp, left, "/%s", libdbo_value_text(libdbo_clause_value(clause)))) >= left) {
-                    libdbo_result_list_free(result_list);
-                    return NULL;
-                }
-                break;
+    for (ret = 0; ret < SHA256_DIGEST_LENGTH; ret++) {
+        sprintf(&hash_string[ret*2], "%02x", hash[ret]);
+    }
+    hash_string[(SHA256_DIGEST_LENGTH*2)] = 0;
 
-            default:
-                libdbo_result_list_free(result_list);
-                return NULL;
-            }
-            stringp += ret;
-            left -= ret;
+    /*
+     * Create the design document with the view unless it is known to
+     * already exist.
+     */
+    if (!__db_backend_couchdb_design_exists(backend_couchdb, hash)) {
+        if (__db_backend_couchdb_put_design(backend_couchdb, hash_string, string)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        __db_backend_couchdb_design_add(backend_couchdb, hash);
+    }
 
-            code = __db_backend_couchdb_request(backend_couchdb, string, COUCHLIBDBO_REQUEST_GET, NULL);
-            if (code != 200) {
-                libdbo_result_list_free(result_list);
-                return NULL;
-            }
+    return LIBDBO_OK;
+}
 
-            if (__db_backend_couchdb_store_result(backend_couchdb, object, result_list, 0)) {
-                libdbo_result_list_free(result_list);
-                return NULL;
-            }
+/**
+ * Convert a database value to a JSON value.
+ * \param[in] value a libdbo_value_t pointer.
+ * \return a json_t pointer or NULL on error.
+ */
+static json_t* __db_backend_couchdb_json_value(const libdbo_value_t* value) {
+    libdbo_type_int32_t int32;
+    libdbo_type_uint32_t uint32;
+#ifdef JSON_INTEGER_IS_LONG_LONG
+    libdbo_type_int64_t int64;
+    libdbo_type_uint64_t uint64;
+#endif
 
-            clause = libdbo_clause_next(clause);
-        }
+    if (!value) {
+        return NULL;
     }
-    else if (have_clauses) {
-        json_t* map = NULL;
-        json_t* view = NULL;
-        json_t* views = NULL;
-        json_t* root = NULL;
-
-        left = sizeof(string);
-        stringp = string;
 
-        if ((ret = snprintf(stringp, left, "function(doc) { if (doc.type == \"%s\"", libdbo_object_table(object))) >= left) {
-            libdbo_result_list_free(result_list);
+    switch (libdbo_value_type(value)) {
+    case LIBDBO_TYPE_INT32:
+        if (libdbo_value_to_int32(value, &int32)) {
             return NULL;
         }
-        stringp += ret;
-        left -= ret;
+        return json_integer(int32);
 
-        if (__db_backend_couchdb_build_map_function(object, clause_list, &stringp, &left)) {
-            libdbo_result_list_free(result_list);
+    case LIBDBO_TYPE_UINT32:
+        if (libdbo_value_to_uint32(value, &uint32)) {
             return NULL;
         }
+        return json_integer(uint32);
 
-        if ((ret = snprintf(stringp, left, ") { emit(doc._id, doc.test_name); } }")) >= left) {
-            libdbo_result_list_free(result_list);
+#ifdef JSON_INTEGER_IS_LONG_LONG
+    case LIBDBO_TYPE_INT64:
+        if (libdbo_value_to_int64(value, &int64)) {
             return NULL;
         }
-        stringp += ret;
-        left -= ret;
-
-        SHA256_Init(&sha256);
-        SHA256_Update(&sha256, string, (unsigned long)(stringp - string));
-        SHA256_Final(hash, &sha256);
-
-        for (ret = 0; ret < SHA256_DIGEST_LENGTH; ret++) {
-            sprintf(&hash_string[ret*2], "%02x", hash[ret]);
-        }
-        hash_string[(SHA256_DIGEST_LENGTH*2)] = 0;
+        return json_integer(int64);
 
-        if (!(map = json_string(string))
-            || !(view = json_object())
-            || !(views = json_object())
-            || !(root = json_object()))
-        {
-            json_decref(map);
-            json_decref(view);
-            json_decref(views);
-            json_decref(root);
-            libdbo_result_list_free(result_list);
+    case LIBDBO_TYPE_UINT64:
+        if (libdbo_value_to_uint64(value, &uint64)) {
             return NULL;
         }
+        return json_integer(uint64);
+#endif
 
-        if (json_object_set(view, "map", map)) {
-            json_decref(map);
-            json_decref(view);
-            json_decref(views);
-            json_decref(root);
-            libdbo_result_list_free(result_list);
-            return NULL;
-        }
-        json_decref(map);
+    case LIBDBO_TYPE_TEXT:
+        return json_string(libdbo_value_text(value));
 
-        if (json_object_set(views, "view", view)) {
-            json_decref(view);
-            json_decref(views);
-            json_decref(root);
-            libdbo_result_list_free(result_list);
+    case LIBDBO_TYPE_ENUM:
+        if (libdbo_value_enum_value(value, &int32)) {
             return NULL;
         }
-        json_decref(view);
+        return json_integer(int32);
 
-        if (json_object_set(root, "views", views)) {
-            json_decref(views);
-            json_decref(root);
-            libdbo_result_list_free(result_list);
-            return NULL;
-        }
-        json_decref(views);
+    default:
+        break;
+    }
 
-        left = sizeof(string);
-        stringp = string;
+    return NULL;
+}
 
-        if ((ret = snprintf(stringp, left, "/_design/%s", hash_string)) >= left) {
-            json_decref(root);
-            libdbo_result_list_free(result_list);
-            return NULL;
-        }
-        stringp += ret;
-        left -= ret;
+/**
+ * Create a JSON object with the member `key` set to `value`, the reference to
+ * `value` is stolen.
+ * \param[in] key a character pointer.
+ * \param[in] value a json_t pointer.
+ * \return a json_t pointer or NULL on error.
+ */
+static json_t* __db_backend_couchdb_json_pair(const char* key, json_t* value) {
+    json_t* pair;
 
-        code = __db_backend_couchdb_request(backend_couchdb, string, COUCHLIBDBO_REQUEST_PUT, root);
-        json_decref(root);
-        if (code != 201 && code != 202 && code != 409) {
-            libdbo_result_list_free(result_list);
-            return NULL;
-        }
+    if (!value) {
+        return NULL;
+    }
 
-        left = sizeof(string);
-        stringp = string;
+    if (!(pair = json_object())) {
+        json_decref(value);
+        return NULL;
+    }
+    if (json_object_set_new(pair, key, value)) {
+        json_decref(pair);
+        return NULL;
+    }
 
-        if ((ret = snprintf(stringp, left, "/_design/%s/_view/view?include_docs=true", hash_string)) >= left) {
-            libdbo_result_list_free(result_list);
-            return NULL;
-        }
-        stringp += ret;
-        left -= ret;
+    return pair;
+}
 
-        code = __db_backend_couchdb_request(backend_couchdb, string, COUCHLIBDBO_REQUEST_GET, NULL);
-        if (code != 200) {
-            libdbo_result_list_free(result_list);
-            return NULL;
-        }
+/**
+ * Get the name of the member in the CouchDB documents for the field `field`.
+ * \param[in] object a libdbo_object_t pointer.
+ * \param[in] field a character pointer.
+ * \param[in] name a character pointer.
+ * \param[in] size a size_t.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_couchdb_field_name(const libdbo_object_t* object, const char* field, char* name, size_t size) {
+    int ret;
 
-        if (__db_backend_couchdb_store_result(backend_couchdb, object, result_list, 1)) {
-            libdbo_result_list_free(result_list);
-            return NULL;
-        }
+    if (!strcmp(field, libdbo_object_primary_key_name(object))) {
+        ret = snprintf(name, size, "_id");
     }
     else {
-        left = sizeof(string);
-        stringp = string;
+        ret = snprintf(name, size, "%s_%s", libdbo_object_table(object), field);
+    }
+    if (ret < 0 || (size_t)ret >= size) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Build a Mango selector from the database clause list specified by
+ * `clause_list`. AND binds harder then OR so the clauses are grouped into
+ * `$and` selectors which are combined with `$or` if there are any ORs. The
+ * fields used in the top level AND clauses are added to `index_fields` if
+ * given.
+ * \param[in] object a libdbo_object_t pointer.
+ * \param[in] clause_list a libdbo_clause_list_t pointer.
+ * \param[in] index_fields a json_t pointer.
+ * \return a json_t pointer or NULL on error.
+ */
+static json_t* __db_backend_couchdb_build_selector(const libdbo_object_t* object, const libdbo_clause_list_t* clause_list, json_t* index_fields) {
+    const libdbo_clause_t* clause;
+    json_t* or_list = NULL;
+    json_t* and_list;
+    json_t* condition;
+    json_t* json_value;
+    const char* operator;
+    char field[1024];
+    size_t i;
+
+    if (!object) {
+        return NULL;
+    }
+    if (!clause_list) {
+        return NULL;
+    }
+
+    if (!(and_list = json_array())) {
+        return NULL;
+    }
+
+    clause = libdbo_clause_list_begin(clause_list);
+    while (clause) {
+        switch (libdbo_clause_operator(clause)) {
+        case LIBDBO_CLAUSE_OPERATOR_AND:
+            break;
+
+        case LIBDBO_CLAUSE_OPERATOR_OR:
+            if (!json_array_size(and_list)) {
+                break;
+            }
+            if (!or_list && !(or_list = json_array())) {
+                json_decref(and_list);
+                return NULL;
+            }
+            if (json_array_append_new(or_list, __db_backend_couchdb_json_pair("$and", and_list))
+                || !(and_list = json_array()))
+            {
+                json_decref(or_list);
+                return NULL;
+            }
+            break;
 
-        if ((ret = snprintf(stringp, left, "/_design/application/_view/%s?include_docs=true", libdbo_object_table(object))) >= left) {
-            libdbo_result_list_free(result_list);
+        default:
+            json_decref(and_list);
+            json_decref(or_list);
             return NULL;
         }
-        stringp += ret;
-        left -= ret;
 
-        code = __db_backend_couchdb_request(backend_couchdb, string, COUCHLIBDBO_REQUEST_GET, NULL);
-        if (code != 200) {
-            libdbo_result_list_free(result_list);
-            return NULL;
+        if (libdbo_clause_type(clause) == LIBDBO_CLAUSE_NESTED) {
+            condition = __db_backend_couchdb_build_selector(object, libdbo_clause_list(clause), NULL);
         }
+        else {
+            if (__db_backend_couchdb_field_name(object, libdbo_clause_field(clause), field, sizeof(field))) {
+                json_decref(and_list);
+                json_decref(or_list);
+                return NULL;
+            }
+
+            operator = NULL;
+            json_value = NULL;
+            switch (libdbo_clause_type(clause)) {
+            case LIBDBO_CLAUSE_EQUAL:
+                operator = "$eq";
+                break;
+
+            case LIBDBO_CLAUSE_NOT_EQUAL:
+                operator = "$ne";
+                break;
+
+            case LIBDBO_CLAUSE_LESS_THEN:
+                operator = "$lt";
+                break;
+
+            case LIBDBO_CLAUSE_LESS_OR_EQUAL:
+                operator = "$lte";
+                break;
+
+            case LIBDBO_CLAUSE_GREATER_OR_EQUAL:
+                operator = "$gte";
+                break;
+
+            case LIBDBO_CLAUSE_GREATER_THEN:
+                operator = "$gt";
+                break;
+
+            case LIBDBO_CLAUSE_IS_NULL:
+                operator = "$eq";
+                json_value = json_null();
+                break;
+
+            case LIBDBO_CLAUSE_IS_NOT_NULL:
+                operator = "$ne";
+                json_value = json_null();
+                break;
+
+            default:
+                json_decref(and_list);
+                json_decref(or_list);
+                return NULL;
+            }
+            if (!json_value) {
+                json_value = __db_backend_couchdb_json_value(libdbo_clause_value(clause));
+            }
+            condition = __db_backend_couchdb_json_pair(field, __db_backend_couchdb_json_pair(operator, json_value));
 
-        if (__db_backend_couchdb_store_result(backend_couchdb, object, result_list, 1)) {
-            libdbo_result_list_free(result_list);
+            if (condition && index_fields) {
+                for (i = 0; i < json_array_size(index_fields); i++) {
+                    if (!strcmp(json_string_value(json_array_get(index_fields, i)), field)) {
+                        break;
+                    }
+                }
+                if (i == json_array_size(index_fields)
+                    && json_array_append_new(index_fields, json_string(field)))
+                {
+                    json_decref(condition);
+                    condition = NULL;
+                }
+            }
+        }
+
+        if (!condition || json_array_append_new(and_list, condition)) {
+            json_decref(and_list);
+            json_decref(or_list);
             return NULL;
         }
+
+        clause = libdbo_clause_next(clause);
     }
 
-    return result_list;
+    if (!or_list) {
+        return __db_backend_couchdb_json_pair("$and", and_list);
+    }
+    if (json_array_append_new(or_list, __db_backend_couchdb_json_pair("$and", and_list))) {
+        json_decref(or_list);
+        return NULL;
+    }
+    return __db_backend_couchdb_json_pair("$or", or_list);
 }
 
-static int libdbo_backend_couchdb_update(void* data, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, const libdbo_clause_list_t* clause_list) {
-    libdbo_backend_couchdb_t* backend_couchdb = (libdbo_backend_couchdb_t*)data;
+/**
+ * Create a Mango index named `index` on the fields `fields` in the design
+ * document `_design/<hash_string>` unless it is known to already exist. The
+ * hash of the fields is stored in `hash` and `hash_string`.
+ * \param[in] backend_couchdb a libdbo_backend_couchdb_t pointer.
+ * \param[in] fields a json_t pointer.
+ * \param[in] hash an unsigned character pointer.
+ * \param[in] hash_string a character pointer.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_couchdb_mango_index(libdbo_backend_couchdb_t* backend_couchdb, json_t* fields, unsigned char* hash, char* hash_string) {
+    json_t* index;
+    json_t* root;
+    char* string;
+    SHA256_CTX sha256;
     long code;
-    char url[4096];
-    char* urlp;
-    int ret, left;
+    int i;
+
+    if (!(string = json_dumps(fields, JSON_ENSURE_ASCII))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    SHA256_Init(&sha256);
+    SHA256_Update(&sha256, string, strlen(string));
+    SHA256_Final(hash, &sha256);
+    free(string);
+
+    for (i = 0; i < SHA256_DIGEST_LENGTH; i++) {
+        sprintf(&hash_string[i*2], "%02x", hash[i]);
+    }
+    hash_string[(SHA256_DIGEST_LENGTH*2)] = 0;
+
+    if (__db_backend_couchdb_design_exists(backend_couchdb, hash)) {
+        return LIBDBO_OK;
+    }
+
+    if (!(index = json_object())) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (json_object_set(index, "fields", fields)) {
+        json_decref(index);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!(root = __db_backend_couchdb_json_pair("index", index))
+        || json_object_set_new(root, "ddoc", json_string(hash_string))
+        || json_object_set_new(root, "name", json_string("index"))
+        || json_object_set_new(root, "type", json_string("json")))
+    {
+        json_decref(root);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    code = __db_backend_couchdb_request(backend_couchdb, LIBDBO_STATS_READ, NULL, "/_index", COUCHLIBDBO_REQUEST_POST, root);
+    json_decref(root);
+    if (code != 200 && code != 201) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    __db_backend_couchdb_design_add(backend_couchdb, hash);
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Start reading the objects matching the database clause list `clause_list`
+ * with a Mango query, only the fields of the object are returned. If the
+ * clauses are only AND'ed an index on the fields used is created and the query
+ * is told to use it.
+ * \param[in] backend_couchdb a libdbo_backend_couchdb_t pointer.
+ * \param[in] object a libdbo_object_t pointer.
+ * \param[in] clause_list a libdbo_clause_list_t pointer.
+ * \return a libdbo_backend_couchdb_stream_t pointer or NULL on error.
+ */
+static libdbo_backend_couchdb_stream_t* __db_backend_couchdb_find(libdbo_backend_couchdb_t* backend_couchdb, const libdbo_object_t* object, const libdbo_clause_list_t* clause_list) {
+    libdbo_backend_couchdb_stream_t* stream;
+    json_t* root;
+    json_t* selector;
+    json_t* and_list;
+    json_t* index_fields;
+    json_t* fields;
+    json_t* use_index;
+    const libdbo_object_field_t* object_field;
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    char hash_string[(SHA256_DIGEST_LENGTH*2)+1];
+    char field[1024];
+    int indexed;
+
+    if (!(index_fields = json_array())) {
+        return NULL;
+    }
+    if (json_array_append_new(index_fields, json_string("type"))
+        || !(selector = __db_backend_couchdb_build_selector(object, clause_list, index_fields)))
+    {
+        json_decref(index_fields);
+        return NULL;
+    }
+    indexed = !json_object_get(selector, "$or");
+
+    if (!(and_list = json_array())
+        || json_array_append_new(and_list, __db_backend_couchdb_json_pair("type", json_string(libdbo_object_table(object)))))
+    {
+        json_decref(and_list);
+        json_decref(selector);
+        json_decref(index_fields);
+        return NULL;
+    }
+    if (json_array_append_new(and_list, selector)
+        || !(root = __db_backend_couchdb_json_pair("selector", __db_backend_couchdb_json_pair("$and", and_list))))
+    {
+        json_decref(index_fields);
+        return NULL;
+    }
+
+    if (!(fields = json_array())
+        || json_object_set_new(root, "fields", fields)
+        || json_array_append_new(fields, json_string("_rev"))
+        || json_object_set_new(root, "limit", json_integer(backend_couchdb->mango_limit)))
+    {
+        json_decref(root);
+        json_decref(index_fields);
+        return NULL;
+    }
+
+    object_field = libdbo_object_field_list_begin(libdbo_object_object_field_list(object));
+    while (object_field) {
+        if (__db_backend_couchdb_field_name(object, libdbo_object_field_name(object_field), field, sizeof(field))
+            || json_array_append_new(fields, json_string(field)))
+        {
+            json_decref(root);
+            json_decref(index_fields);
+            return NULL;
+        }
+        object_field = libdbo_object_field_next(object_field);
+    }
+
+    if (indexed) {
+        if (__db_backend_couchdb_mango_index(backend_couchdb, index_fields, hash, hash_string)
+            || !(use_index = json_array())
+            || json_object_set_new(root, "use_index", use_index)
+            || json_array_append_new(use_index, json_string(hash_string))
+            || json_array_append_new(use_index, json_string("index")))
+        {
+            json_decref(root);
+            json_decref(index_fields);
+            return NULL;
+        }
+    }
+    json_decref(index_fields);
+
+    stream = __db_backend_couchdb_stream_start(backend_couchdb, object, "/_find", root, 1, indexed ? hash : NULL);
+    json_decref(root);
+    return stream;
+}
+
+/**
+ * Convert the value of a primary key to a JSON string with the id of the
+ * document.
+ * \param[in] value a libdbo_value_t pointer.
+ * \return a json_t pointer or NULL on error.
+ */
+static json_t* __db_backend_couchdb_json_id(const libdbo_value_t* value) {
+    libdbo_type_int32_t int32;
+    libdbo_type_uint32_t uint32;
+    libdbo_type_int64_t int64;
+    libdbo_type_uint64_t uint64;
+    char string[64];
+
+    switch (libdbo_value_type(value)) {
+    case LIBDBO_TYPE_INT32:
+        if (libdbo_value_to_int32(value, &int32)) {
+            return NULL;
+        }
+        snprintf(string, sizeof(string), "%d", int32);
+        break;
+
+    case LIBDBO_TYPE_UINT32:
+        if (libdbo_value_to_uint32(value, &uint32)) {
+            return NULL;
+        }
+        snprintf(string, sizeof(string), "%u", uint32);
+        break;
+
+    case LIBDBO_TYPE_INT64:
+        if (libdbo_value_to_int64(value, &int64)) {
+            return NULL;
+        }
+        snprintf(string, sizeof(string), "%ld", int64);
+        break;
+
+    case LIBDBO_TYPE_UINT64:
+        if (libdbo_value_to_uint64(value, &uint64)) {
+            return NULL;
+        }
+        snprintf(string, sizeof(string), "%lu", uint64);
+        break;
+
+    case LIBDBO_TYPE_TEXT:
+        return json_string(libdbo_value_text(value));
+
+    default:
+        return NULL;
+    }
+
+    return json_string(string);
+}
+
+/**
+ * Start reading the objects matching the database clause list `clause_list`,
+ * the request is in flight when this returns.
+ * \param[in] backend_couchdb a libdbo_backend_couchdb_t pointer.
+ * \param[in] object a libdbo_object_t pointer.
+ * \param[in] join_list a libdbo_join_list_t pointer.
+ * \param[in] clause_list a libdbo_clause_list_t pointer.
+ * \return a libdbo_backend_couchdb_stream_t pointer or NULL on error.
+ */
+static libdbo_backend_couchdb_stream_t* __db_backend_couchdb_read_start(libdbo_backend_couchdb_t* backend_couchdb, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list) {
+    libdbo_backend_couchdb_stream_t* stream;
+    char string[1024];
+    int only_ids, have_clauses;
+    const libdbo_clause_t* clause;
+    json_t* keys;
+    json_t* root;
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    char hash_string[(SHA256_DIGEST_LENGTH*2)+1];
+
+    if (!backend_couchdb) {
+        return NULL;
+    }
+    if (!object) {
+        return NULL;
+    }
+
+    if (join_list) {
+        /*
+         * Joins is not supported by this backend, check if there are any and
+         * return error if so.
+         */
+        if (libdbo_join_list_begin(join_list)) {
+            return NULL;
+        }
+    }
+
+    only_ids = 0;
+    have_clauses = 0;
+    if (clause_list) {
+        clause = libdbo_clause_list_begin(clause_list);
+        only_ids = 1;
+        while (clause) {
+            if (libdbo_clause_table(clause)) {
+                /*
+                 * This backend only supports clauses on the objects table.
+                 */
+                if (strcmp(libdbo_clause_table(clause), libdbo_object_table(object))) {
+                    return NULL;
+                }
+            }
+
+            if (strcmp(libdbo_clause_field(clause), libdbo_object_primary_key_name(object))) {
+                only_ids = 0;
+                have_clauses = 1;
+            }
+            clause = libdbo_clause_next(clause);
+        }
+    }
+
+    if (only_ids) {
+        /*
+         * Get all the documents by their ids in one request.
+         */
+        if (!(keys = json_array())) {
+            return NULL;
+        }
+        clause = libdbo_clause_list_begin(clause_list);
+        while (clause) {
+            if (json_array_append_new(keys, __db_backend_couchdb_json_id(libdbo_clause_value(clause)))) {
+                json_decref(keys);
+                return NULL;
+            }
+            clause = libdbo_clause_next(clause);
+        }
+        if (!(root = __db_backend_couchdb_json_pair("keys", keys))) {
+            return NULL;
+        }
+
+        stream = __db_backend_couchdb_stream_start(backend_couchdb, object, "/_all_docs?include_docs=true", root, 0, NULL);
+        json_decref(root);
+        return stream;
+    }
+    else if (have_clauses && backend_couchdb->mango) {
+        return __db_backend_couchdb_find(backend_couchdb, object, clause_list);
+    }
+    else if (have_clauses) {
+        if (__db_backend_couchdb_view(backend_couchdb, object, clause_list, hash, hash_string)) {
+            return NULL;
+        }
+
+        if (snprintf(string, sizeof(string), "/_design/%s/_view/view?include_docs=true&reduce=false", hash_string) >= (int)sizeof(string)) {
+            return NULL;
+        }
+
+        return __db_backend_couchdb_stream_start(backend_couchdb, object, string, NULL, 0, hash);
+    }
+
+    if (snprintf(string, sizeof(string), "/_design/application/_view/%s?include_docs=true", libdbo_object_table(object)) >= (int)sizeof(string)) {
+        return NULL;
+    }
+
+    return __db_backend_couchdb_stream_start(backend_couchdb, object, string, NULL, 0, NULL);
+}
+
+static libdbo_result_list_t* libdbo_backend_couchdb_read(void* data, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list) {
+    libdbo_backend_couchdb_t* backend_couchdb = (libdbo_backend_couchdb_t*)data;
+
+    if (!__couchdb_initialized) {
+        return NULL;
+    }
+    if (!backend_couchdb) {
+        return NULL;
+    }
+    if (!object) {
+        return NULL;
+    }
+
+    return __db_backend_couchdb_stream_result(__db_backend_couchdb_read_start(backend_couchdb, object, join_list, clause_list));
+}
+
+static int libdbo_backend_couchdb_read_batch(void* data, size_t size, const libdbo_object_t** objects, const libdbo_join_list_t** join_lists, const libdbo_clause_list_t** clause_lists, libdbo_result_list_t** result_lists) {
+    libdbo_backend_couchdb_t* backend_couchdb = (libdbo_backend_couchdb_t*)data;
+    libdbo_backend_couchdb_stream_t** streams;
+    size_t i;
+    int ret = LIBDBO_OK;
+
+    if (!__couchdb_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_couchdb) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!objects) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!result_lists) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (!size) {
+        return LIBDBO_OK;
+    }
+    if (!(streams = calloc(size, sizeof(libdbo_backend_couchdb_stream_t*)))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * Start all the reads before waiting for any of them so that they are in
+     * flight at the same time.
+     */
+    for (i = 0; i < size; i++) {
+        if (!(streams[i] = __db_backend_couchdb_read_start(backend_couchdb, objects[i], join_lists ? join_lists[i] : NULL, clause_lists ? clause_lists[i] : NULL))) {
+            ret = LIBDBO_ERROR_UNKNOWN;
+            break;
+        }
+    }
+    for (i = 0; !ret && i < size; i++) {
+        if (!(result_lists[i] = __db_backend_couchdb_stream_result(streams[i]))) {
+            ret = LIBDBO_ERROR_UNKNOWN;
+        }
+        streams[i] = NULL;
+    }
+
+    if (ret) {
+        for (i = 0; i < size; i++) {
+            __db_backend_couchdb_stream_free(streams[i]);
+            libdbo_result_list_free(result_lists[i]);
+            result_lists[i] = NULL;
+        }
+    }
+    free(streams);
+    return ret;
+}
+
+/**
+ * Store the object with the id `id` on the revision `rev` in CouchDB by
+ * replacing the document with the fields from `object_field_list` and values
+ * from `value_set`.
+ */
+static int __db_backend_couchdb_put(libdbo_backend_couchdb_t* backend_couchdb, libdbo_stats_operation_t operation, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, const libdbo_value_t* id, const libdbo_value_t* rev) {
+    long code;
+    char url[4096];
+    char* urlp;
+    int ret, left;
+    libdbo_type_int32_t int32;
+    libdbo_type_uint32_t uint32;
+    libdbo_type_int64_t int64;
+    libdbo_type_uint64_t uint64;
+    json_t* root;
+    json_t* json_value;
+    const libdbo_object_field_t* object_field;
+    const libdbo_value_t* value;
+    size_t value_pos;
+    char string[1024];
+    char* stringp;
+
+    if (!backend_couchdb) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object_field_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!value_set) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!id) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!rev) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    left = sizeof(url);
+    urlp = url;
+
+    switch (libdbo_value_type(id)) {
+    case LIBDBO_TYPE_INT32:
+        if (libdbo_value_to_int32(id, &int32)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        if ((ret = snprintf(urlp, left, "/%d", int32)) >= left) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        break;
+
+    case LIBDBO_TYPE_UINT32:
+        if (libdbo_value_to_uint32(id, &uint32)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        if ((ret = snprintf(urlp, left, "/%u", uint32)) >= left) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        break;
+
+    case LIBDBO_TYPE_INT64:
+        if (libdbo_value_to_int64(id, &int64)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        if ((ret = snprintf(urlp, left, "/%ld", int64)) >= left) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        break;
+
+    case LIBDBO_TYPE_UINT64:
+        if (libdbo_value_to_uint64(id, &uint64)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        if ((ret = snprintf(urlp, left, "/%lu", uint64)) >= left) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        break;
+
+    case LIBDBO_TYPE_TEXT:
+        if ((ret = snprintf(urlp, left, "/%s", libdbo_value_text(id))) >= left) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        break;
+
+    default:
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    root = json_object();
+    if (!root) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    object_field = libdbo_object_field_list_begin(object_field_list);
+    value_pos = 0;
+    while (object_field) {
+        if (!(value = libdbo_value_set_at(value_set, value_pos))) {
+            json_decref(root);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+
+        switch (libdbo_value_type(value)) {
+        case LIBDBO_TYPE_INT32:
+            if (libdbo_value_to_int32(value, &int32)) {
+                json_decref(root);
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            if (!(json_value = json_integer(int32))) {
+                json_decref(root);
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            break;
+
+        case LIBDBO_TYPE_UINT32:
+            if (libdbo_value_to_uint32(value, &uint32)) {
+                json_decref(root);
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            if (!(json_value = json_integer(uint32))) {
+                json_decref(root);
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            break;
+
+#ifdef JSON_INTEGER_IS_LONG_LONG
+        case LIBDBO_TYPE_INT64:
+            if (libdbo_value_to_int64(value, &int64)) {
+                json_decref(root);
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            if (!(json_value = json_integer(int64))) {
+                json_decref(root);
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            break;
+
+        case LIBDBO_TYPE_UINT64:
+            if (libdbo_value_to_uint64(value, &uint64)) {
+                json_decref(root);
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            if (!(json_value = json_integer(uint64))) {
+                json_decref(root);
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            break;
+#endif
+
+        case LIBDBO_TYPE_TEXT:
+            if (!(json_value = json_string(libdbo_value_text(value)))) {
+                json_decref(root);
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            break;
+
+        case LIBDBO_TYPE_ENUM:
+            if (libdbo_value_enum_value(value, &int32)) {
+                json_decref(root);
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            if (!(json_value = json_integer(int32))) {
+                json_decref(root);
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            break;
+
+        default:
+            json_decref(root);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+
+        left = sizeof(string);
+        stringp = string;
+
+        if ((ret = snprintf(stringp, left, "%s_%s", libdbo_object_table(object), libdbo_object_field_name(object_field))) >= left) {
+            json_decref(json_value);
+            json_decref(root);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+
+        if (json_object_set_new(root, string, json_value)) {
+            json_decref(json_value);
+            json_decref(root);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+
+        object_field = libdbo_object_field_next(object_field);
+        value_pos++;
+    }
+
+    if (!(json_value = json_string(libdbo_object_table(object)))) {
+        json_decref(root);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (json_object_set_new(root, "type", json_value)) {
+        json_decref(json_value);
+        json_decref(root);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (!(json_value = json_string(libdbo_value_text(rev)))) {
+        json_decref(root);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (json_object_set_new(root, "_rev", json_value)) {
+        json_decref(json_value);
+        json_decref(root);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    code = __db_backend_couchdb_request(backend_couchdb, operation, object, url, COUCHLIBDBO_REQUEST_PUT, root);
+    json_decref(root);
+    if (code == 409) {
+        /*
+         * The document is no longer on the revision `rev`, someone else
+         * updated it.
+         */
+        return LIBDBO_ERROR_REVISION;
+    }
+    if (code != 201 && code != 202) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    return LIBDBO_OK;
+}
+
+static int libdbo_backend_couchdb_update(void* data, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, const libdbo_clause_list_t* clause_list) {
+    libdbo_backend_couchdb_t* backend_couchdb = (libdbo_backend_couchdb_t*)data;
     const libdbo_clause_t* clause;
-    libdbo_type_int32_t int32;
-    libdbo_type_uint32_t uint32;
-    libdbo_type_int64_t int64;
-    libdbo_type_uint64_t uint64;
     const libdbo_backend_meta_data_t* rev;
-    json_t* root;
-    json_t* json_value;
-    const libdbo_object_field_t* object_field;
-    const libdbo_value_t* value;
-    size_t value_pos;
-    char string[1024];
-    char* stringp;
+    int ret;
 
     if (!__couchdb_initialized) {
         return LIBDBO_ERROR_UNKNOWN;
@@ -1384,186 +2788,105 @@ static int libdbo_backend_couchdb_update(void* data, const libdbo_object_t* obje
 
     clause = libdbo_clause_list_begin(clause_list);
     while (clause) {
-        left = sizeof(url);
-        urlp = url;
-
-        switch (libdbo_value_type(libdbo_clause_value(clause))) {
-        case LIBDBO_TYPE_INT32:
-            if (libdbo_value_to_int32(libdbo_clause_value(clause), &int32)) {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            if ((ret = snprintf(urlp, left, "/%d", int32)) >= left) {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            break;
-
-        case LIBDBO_TYPE_UINT32:
-            if (libdbo_value_to_uint32(libdbo_clause_value(clause), &uint32)) {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            if ((ret = snprintf(urlp, left, "/%u", uint32)) >= left) {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            break;
-
-        case LIBDBO_TYPE_INT64:
-            if (libdbo_value_to_int64(libdbo_clause_value(clause), &int64)) {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            if ((ret = snprintf(urlp, left, "/%ld", int64)) >= left) {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            break;
-
-        case LIBDBO_TYPE_UINT64:
-            if (libdbo_value_to_uint64(libdbo_clause_value(clause), &uint64)) {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            if ((ret = snprintf(urlp, left, "/%lu", uint64)) >= left) {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            break;
-
-        case LIBDBO_TYPE_TEXT:
-            if ((ret = snprintf(urlp, left, "/%s", libdbo_value_text(libdbo_clause_value(clause)))) >= left) {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            break;
-
-        default:
-            return LIBDBO_ERROR_UNKNOWN;
-        }
-
-        root = json_object();
-        if (!root) {
-            return LIBDBO_ERROR_UNKNOWN;
+        if ((ret = __db_backend_couchdb_put(backend_couchdb, LIBDBO_STATS_UPDATE, object, object_field_list, value_set, libdbo_clause_value(clause), libdbo_backend_meta_data_value(rev)))) {
+            return ret;
         }
 
-        object_field = libdbo_object_field_list_begin(object_field_list);
-        value_pos = 0;
-        while (object_field) {
-            if (!(value = libdbo_value_set_at(value_set, value_pos))) {
-                json_decref(root);
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-
-            switch (libdbo_value_type(value)) {
-            case LIBDBO_TYPE_INT32:
-                if (libdbo_value_to_int32(value, &int32)) {
-                    json_decref(root);
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
-                if (!(json_value = json_integer(int32))) {
-                    json_decref(root);
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
-                break;
-
-            case LIBDBO_TYPE_UINT32:
-                if (libdbo_value_to_uint32(value, &uint32)) {
-                    json_decref(root);
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
-                if (!(json_value = json_integer(uint32))) {
-                    json_decref(root);
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
-                break;
-
-#ifdef JSON_INTEGER_IS_LONG_LONG
-            case LIBDBO_TYPE_INT64:
-                if (libdbo_value_to_int64(value, &int64)) {
-                    json_decref(root);
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
-                if (!(json_value = json_integer(int64))) {
-                    json_decref(root);
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
-                break;
-
-            case LIBDBO_TYPE_UINT64:
-                if (libdbo_value_to_uint64(value, &uint64)) {
-                    json_decref(root);
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
-                if (!(json_value = json_integer(uint64))) {
-                    json_decref(root);
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
-                break;
-#endif
-
-            case LIBDBO_TYPE_TEXT:
-                if (!(json_value = json_string(libdbo_value_text(value)))) {
-                    json_decref(root);
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
-                break;
-
-            case LIBDBO_TYPE_ENUM:
-                if (libdbo_value_enum_value(value, &int32)) {
-                    json_decref(root);
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
-                if (!(json_value = json_integer(int32))) {
-                    json_decref(root);
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
-                break;
-
-            default:
-                json_decref(root);
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-
-            left = sizeof(string);
-            stringp = string;
-
-            if ((ret = snprintf(stringp, left, "%s_%s", libdbo_object_table(object), libdbo_object_field_name(object_field))) >= left) {
-                json_decref(json_value);
-                json_decref(root);
-                return LIBDBO_ERROR_UNKNOWN;
-            }
+        clause = libdbo_clause_next(clause);
+    }
+    return LIBDBO_OK;
+}
 
-            if (json_object_set_new(root, string, json_value)) {
-                json_decref(json_value);
-                json_decref(root);
-                return LIBDBO_ERROR_UNKNOWN;
-            }
+static int libdbo_backend_couchdb_upsert(void* data, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, const libdbo_clause_list_t* clause_list) {
+    libdbo_backend_couchdb_t* backend_couchdb = (libdbo_backend_couchdb_t*)data;
+    const libdbo_clause_t* clause;
+    const libdbo_backend_meta_data_t* rev = NULL;
+    const libdbo_object_field_t* object_field;
+    libdbo_result_list_t* result_list;
+    const libdbo_result_t* result;
+    size_t primary_key_pos;
+    int ret;
 
-            object_field = libdbo_object_field_next(object_field);
-        }
+    if (!__couchdb_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_couchdb) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object_field_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!value_set) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!clause_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
 
-        if (!(json_value = json_string(libdbo_object_table(object)))) {
-            json_decref(root);
-            return LIBDBO_ERROR_UNKNOWN;
-        }
-        if (json_object_set_new(root, "type", json_value)) {
-            json_decref(json_value);
-            json_decref(root);
+    /*
+     * Only equal clauses on the unique fields are supported.
+     */
+    clause = libdbo_clause_list_begin(clause_list);
+    if (!clause) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    while (clause) {
+        if (libdbo_clause_type(clause) != LIBDBO_CLAUSE_EQUAL) {
             return LIBDBO_ERROR_UNKNOWN;
         }
+        clause = libdbo_clause_next(clause);
+    }
 
-        if (!(json_value = json_string(libdbo_value_text(libdbo_backend_meta_data_value(rev))))) {
-            json_decref(root);
-            return LIBDBO_ERROR_UNKNOWN;
-        }
-        if (json_object_set_new(root, "_rev", json_value)) {
-            json_decref(json_value);
-            json_decref(root);
-            return LIBDBO_ERROR_UNKNOWN;
+    /*
+     * Find the position of the primary key in the results.
+     */
+    primary_key_pos = 0;
+    object_field = libdbo_object_field_list_begin(libdbo_object_object_field_list(object));
+    while (object_field) {
+        if (libdbo_object_field_type(object_field) == LIBDBO_TYPE_PRIMARY_KEY) {
+            break;
         }
+        object_field = libdbo_object_field_next(object_field);
+        primary_key_pos++;
+    }
+    if (!object_field) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
 
-        code = __db_backend_couchdb_request(backend_couchdb, url, COUCHLIBDBO_REQUEST_PUT, root);
-        json_decref(root);
-        if (code != 201 && code != 202) {
-            return LIBDBO_ERROR_UNKNOWN;
-        }
+    /*
+     * CouchDB has no native upsert so look the object up by its unique fields
+     * and create it if it does not exist.
+     */
+    if (!(result_list = libdbo_backend_couchdb_read(data, object, NULL, clause_list))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!(result = libdbo_result_list_begin(result_list))) {
+        libdbo_result_list_free(result_list);
+        return libdbo_backend_couchdb_create(data, object, object_field_list, value_set);
+    }
 
-        clause = libdbo_clause_next(clause);
+    /*
+     * Update the existing object, if the object carries the rev from an
+     * earlier read then use that so that CouchDB rejects the update if the
+     * object has been changed since.
+     */
+    if (libdbo_object_backend_meta_data_list(object)) {
+        rev = libdbo_backend_meta_data_list_find(libdbo_object_backend_meta_data_list(object), "rev");
     }
-    return LIBDBO_OK;
+    if (!rev) {
+        rev = libdbo_backend_meta_data_list_find(libdbo_result_backend_meta_data_list(result), "rev");
+    }
+    if (!rev) {
+        libdbo_result_list_free(result_list);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    ret = __db_backend_couchdb_put(backend_couchdb, LIBDBO_STATS_UPSERT, object, object_field_list, value_set, libdbo_value_set_at(libdbo_result_value_set(result), primary_key_pos), libdbo_backend_meta_data_value(rev));
+    libdbo_result_list_free(result_list);
+    return ret;
 }
 
 static int libdbo_backend_couchdb_delete(void* data, const libdbo_object_t* object, const libdbo_clause_list_t* clause_list) {
@@ -1678,7 +3001,7 @@ static int libdbo_backend_couchdb_delete(void* data, const libdbo_object_t* obje
             return LIBDBO_ERROR_UNKNOWN;
         }
 
-        code = __db_backend_couchdb_request(backend_couchdb, url, COUCHLIBDBO_REQUEST_DELETE, NULL);
+        code = __db_backend_couchdb_request(backend_couchdb, LIBDBO_STATS_DELETE, object, url, COUCHLIBDBO_REQUEST_DELETE, NULL);
         if (code != 200 && code != 202) {
             return LIBDBO_ERROR_UNKNOWN;
         }
@@ -1689,7 +3012,106 @@ static int libdbo_backend_couchdb_delete(void* data, const libdbo_object_t* obje
 }
 
 static int libdbo_backend_couchdb_count(void* data, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list, size_t* count) {
-    return LIBDBO_ERROR_UNKNOWN;
+    libdbo_backend_couchdb_t* backend_couchdb = (libdbo_backend_couchdb_t*)data;
+    const libdbo_clause_t* clause;
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    char hash_string[(SHA256_DIGEST_LENGTH*2)+1];
+    char string[1024];
+    json_t* root;
+    json_t* rows;
+    json_t* value;
+    json_error_t error;
+
+    if (!__couchdb_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_couchdb) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!count) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (join_list) {
+        /*
+         * Joins is not supported by this backend, check if there are any and
+         * return error if so.
+         */
+        if (libdbo_join_list_begin(join_list)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+
+    if (clause_list) {
+        clause = libdbo_clause_list_begin(clause_list);
+        while (clause) {
+            /*
+             * This backend only supports clauses on the objects table.
+             */
+            if (libdbo_clause_table(clause)
+                && strcmp(libdbo_clause_table(clause), libdbo_object_table(object)))
+            {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            clause = libdbo_clause_next(clause);
+        }
+    }
+
+    /*
+     * Let the reduce function of the view count the objects so that only the
+     * count is transferred.
+     */
+    if (__db_backend_couchdb_view(backend_couchdb, object, clause_list, hash, hash_string)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (snprintf(string, sizeof(string), "/_design/%s/_view/view?reduce=true&group=false", hash_string) >= (int)sizeof(string)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (__db_backend_couchdb_request(backend_couchdb, LIBDBO_STATS_COUNT, object, string, COUCHLIBDBO_REQUEST_GET, NULL) != 200) {
+        /*
+         * The design document may have been removed, make sure it is created
+         * on the next request.
+         */
+        __db_backend_couchdb_design_remove(backend_couchdb, hash);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (!(root = json_loadb(backend_couchdb->buffer, backend_couchdb->buffer_position, 0, &error))) {
+        libdbo_log(LIBDBO_LOG_ERROR, "CouchDB count JSON error on line %d: %s",
+            error.line, error.text);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!(rows = json_object_get(root, "rows"))
+        || !json_is_array(rows))
+    {
+        json_decref(root);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * The reduce of an empty view has no rows.
+     */
+    if (!json_array_size(rows)) {
+        *count = 0;
+    }
+    else if (!(value = json_object_get(json_array_get(rows, 0), "value"))
+        || !json_is_integer(value)
+        || json_integer_value(value) < 0)
+    {
+        json_decref(root);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    else {
+        *count = (size_t)json_integer_value(value);
+    }
+
+    json_decref(root);
+    return LIBDBO_OK;
 }
 
 static void libdbo_backend_couchdb_free(void* data) {
@@ -1699,7 +3121,7 @@ static void libdbo_backend_couchdb_free(void* data) {
         if (backend_couchdb->url) {
             free(backend_couchdb->url);
         }
-        if (backend_couchdb->curl) {
+        if (backend_couchdb->curl || backend_couchdb->headers || backend_couchdb->share || backend_couchdb->multi || backend_couchdb->design_cache) {
             libdbo_backend_couchdb_disconnect(backend_couchdb);
         }
         if (backend_couchdb->buffer) {
@@ -1764,6 +3186,8 @@ libdbo_backend_handle_t* libdbo_backend_couchdb_new_handle(void) {
             || libdbo_backend_handle_set_update(backend_handle, libdbo_backend_couchdb_update)
             || libdbo_backend_handle_set_delete(backend_handle, libdbo_backend_couchdb_delete)
             || libdbo_backend_handle_set_count(backend_handle, libdbo_backend_couchdb_count)
+            || libdbo_backend_handle_set_read_batch(backend_handle, libdbo_backend_couchdb_read_batch)
+            || libdbo_backend_handle_set_upsert(backend_handle, libdbo_backend_couchdb_upsert)
             || libdbo_backend_handle_set_free(backend_handle, libdbo_backend_couchdb_free)
             || libdbo_backend_handle_set_transaction_begin(backend_handle, libdbo_backend_couchdb_transaction_begin)
             || libdbo_backend_handle_set_transaction_commit(backend_handle, libdbo_backend_couchdb_transaction_commit)
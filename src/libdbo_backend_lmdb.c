@@ -0,0 +1,2905 @@
+/*
+ * Copyright (c) 2014 Jerry Lundström <lundstrom.jerry@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "libdbo/backend/lmdb.h"
+
+#include "libdbo/error.h"
+#include "libdbo/mm.h"
+#include "libdbo/log.h"
+
+#include <lmdb.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+static int libdbo_backend_lmdb_transaction_rollback(void*);
+
+/**
+ * Keep track of if we have initialized the LMDB backend.
+ */
+static int __lmdb_initialized = 0;
+
+/**
+ * The sub-database holding the description of the tables, the next id of
+ * each table and which indexes has been built.
+ */
+#define LIBDBO_BACKEND_LMDB_META "__libdbo"
+
+/**
+ * The flags of a field in the stored description of a table.
+ */
+#define LIBDBO_BACKEND_LMDB_FIELD 'f'
+#define LIBDBO_BACKEND_LMDB_PRIMARY_KEY 'p'
+#define LIBDBO_BACKEND_LMDB_REVISION 'r'
+
+/**
+ * Used for the primary key and revision position of a table that has none.
+ */
+#define LIBDBO_BACKEND_LMDB_NONE ((size_t)-1)
+
+/**
+ * Text longer then this is indexed by its prefix and a hash of it to stay
+ * within the key size limit of LMDB.
+ */
+#define LIBDBO_BACKEND_LMDB_KEY_TEXT 400
+
+/**
+ * A LMDB environment, it can only be opened once per process so it is shared
+ * by all connections to the same file.
+ */
+typedef struct libdbo_backend_lmdb_env libdbo_backend_lmdb_env_t;
+struct libdbo_backend_lmdb_env {
+    libdbo_backend_lmdb_env_t* next;
+    char* file;
+    MDB_env* env;
+    MDB_dbi meta;
+    int references;
+};
+
+static libdbo_mm_t __lmdb_env_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_backend_lmdb_env_t));
+static libdbo_backend_lmdb_env_t* __lmdb_env_list = NULL;
+static pthread_mutex_t __lmdb_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * An index sub-database of a field, it maps the value to the primary key of
+ * the row and has duplicates sorted unless it is unique.
+ */
+typedef struct libdbo_backend_lmdb_index libdbo_backend_lmdb_index_t;
+struct libdbo_backend_lmdb_index {
+    libdbo_backend_lmdb_index_t* next;
+    size_t field;
+    MDB_dbi dbi;
+    int unique;
+};
+
+static libdbo_mm_t __lmdb_index_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_backend_lmdb_index_t));
+
+/**
+ * A table sub-database and its fields, rows store their values in the same
+ * order as the fields.
+ */
+typedef struct libdbo_backend_lmdb_table libdbo_backend_lmdb_table_t;
+struct libdbo_backend_lmdb_table {
+    libdbo_backend_lmdb_table_t* next;
+    char* name;
+    MDB_dbi dbi;
+    char** fields;
+    size_t fields_size;
+    size_t fields_allocated;
+    size_t primary_key;
+    size_t revision;
+    libdbo_backend_lmdb_index_t* index_list;
+    /**
+     * The transaction depth the table was opened or changed in, the table is
+     * forgotten if that transaction is rolled back.
+     */
+    int depth;
+};
+
+static libdbo_mm_t __lmdb_table_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_backend_lmdb_table_t));
+
+/**
+ * A value of a field, text points into the row or the value it was taken
+ * from so nothing is copied until a result is built.
+ */
+typedef struct libdbo_backend_lmdb_field {
+    libdbo_type_t type;
+    int negative;
+    libdbo_type_uint64_t magnitude;
+    const char* text;
+    size_t length;
+} libdbo_backend_lmdb_field_t;
+
+/**
+ * A growable buffer for encoding rows and keys.
+ */
+typedef struct libdbo_backend_lmdb_buffer {
+    unsigned char* data;
+    size_t size;
+    size_t allocated;
+} libdbo_backend_lmdb_buffer_t;
+
+/**
+ * The LMDB database backend specific data.
+ */
+typedef struct libdbo_backend_lmdb {
+    libdbo_backend_lmdb_env_t* env;
+    /** A read-only transaction that is reset and renewed for each read. */
+    MDB_txn* read_txn;
+    /** The stack of write transactions started by transaction_begin. */
+    MDB_txn** txns;
+    size_t txns_allocated;
+    int transaction;
+    char* unique;
+    char* index;
+    libdbo_backend_lmdb_table_t* table_list;
+    libdbo_backend_lmdb_buffer_t row;
+    libdbo_backend_lmdb_buffer_t key;
+    libdbo_backend_lmdb_buffer_t key2;
+} libdbo_backend_lmdb_t;
+
+static libdbo_mm_t __lmdb_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_backend_lmdb_t));
+
+/**
+ * A row of a table that is part of the rows being matched, the first one is
+ * from the table being operated on and the rest are from joined tables.
+ */
+typedef struct libdbo_backend_lmdb_tuple {
+    libdbo_backend_lmdb_table_t* table;
+    libdbo_type_uint64_t key;
+    libdbo_backend_lmdb_field_t* fields;
+} libdbo_backend_lmdb_tuple_t;
+
+/**
+ * A join resolved to the tables and fields it uses.
+ */
+typedef struct libdbo_backend_lmdb_join {
+    size_t from;
+    size_t from_field;
+    libdbo_backend_lmdb_table_t* table;
+    size_t field;
+    const libdbo_backend_lmdb_index_t* index;
+} libdbo_backend_lmdb_join_t;
+
+/**
+ * Called for each combination of rows that matches a select.
+ */
+typedef int (*libdbo_backend_lmdb_match_t)(void* context, const libdbo_backend_lmdb_tuple_t* tuples);
+
+/**
+ * The state of a select.
+ */
+typedef struct libdbo_backend_lmdb_select {
+    libdbo_backend_lmdb_t* backend_lmdb;
+    MDB_txn* txn;
+    libdbo_backend_lmdb_tuple_t* tuples;
+    libdbo_backend_lmdb_join_t* joins;
+    size_t joins_size;
+    const libdbo_clause_list_t* clause_list;
+    /** A top level clause that is not matched. */
+    const libdbo_clause_t* skip;
+    libdbo_backend_lmdb_match_t match;
+    void* context;
+} libdbo_backend_lmdb_select_t;
+
+/**
+ * Log a LMDB error.
+ */
+static void __db_backend_lmdb_error(const char* what, int ret) {
+    libdbo_log(LIBDBO_LOG_ERROR, "LMDB %s: %s", what, mdb_strerror(ret));
+}
+
+/**
+ * Make room for `size` more bytes in a buffer.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_lmdb_buffer_reserve(libdbo_backend_lmdb_buffer_t* buffer, size_t size) {
+    unsigned char* data;
+    size_t allocated;
+
+    if (buffer->size + size <= buffer->allocated) {
+        return LIBDBO_OK;
+    }
+
+    allocated = buffer->allocated ? buffer->allocated : 256;
+    while (allocated < buffer->size + size) {
+        allocated *= 2;
+    }
+    if (!(data = realloc(buffer->data, allocated))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    buffer->data = data;
+    buffer->allocated = allocated;
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Add bytes to a buffer.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_lmdb_buffer_add(libdbo_backend_lmdb_buffer_t* buffer, const void* data, size_t size) {
+    if (__db_backend_lmdb_buffer_reserve(buffer, size)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    memcpy(buffer->data + buffer->size, data, size);
+    buffer->size += size;
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Encode a primary key as a key of a table, big endian so that the rows are
+ * kept in order.
+ */
+static void __db_backend_lmdb_key(libdbo_type_uint64_t id, unsigned char key[8]) {
+    int i;
+
+    for (i = 7; i >= 0; i--) {
+        key[i] = (unsigned char)(id & 0xff);
+        id >>= 8;
+    }
+}
+
+/**
+ * Decode a key of a table.
+ */
+static libdbo_type_uint64_t __db_backend_lmdb_key_id(const void* data) {
+    const unsigned char* key = (const unsigned char*)data;
+    libdbo_type_uint64_t id = 0;
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        id = (id << 8) | key[i];
+    }
+
+    return id;
+}
+
+/**
+ * Set a field to an integer.
+ */
+static void __db_backend_lmdb_field_integer(libdbo_backend_lmdb_field_t* field, libdbo_type_t type, int negative, libdbo_type_uint64_t magnitude) {
+    field->type = type;
+    field->negative = negative;
+    field->magnitude = magnitude;
+}
+
+/**
+ * Set a field to a signed integer.
+ */
+static void __db_backend_lmdb_field_signed(libdbo_backend_lmdb_field_t* field, libdbo_type_t type, libdbo_type_int64_t value) {
+    if (value < 0) {
+        __db_backend_lmdb_field_integer(field, type, 1, ~(libdbo_type_uint64_t)value + 1);
+    }
+    else {
+        __db_backend_lmdb_field_integer(field, type, 0, (libdbo_type_uint64_t)value);
+    }
+}
+
+/**
+ * Get the signed value of an integer field.
+ */
+static libdbo_type_int64_t __db_backend_lmdb_field_int64(const libdbo_backend_lmdb_field_t* field) {
+    if (field->negative) {
+        return (libdbo_type_int64_t)(~field->magnitude + 1);
+    }
+    return (libdbo_type_int64_t)field->magnitude;
+}
+
+/**
+ * Set a field from a value, text is not copied. Enums are stored as their
+ * integer value just like the SQL backends.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_lmdb_field_from_value(libdbo_backend_lmdb_field_t* field, const libdbo_value_t* value) {
+    const libdbo_type_int32_t* int32;
+    const libdbo_type_uint32_t* uint32;
+    const libdbo_type_int64_t* int64;
+    const libdbo_type_uint64_t* uint64;
+    int enum_value;
+
+    memset(field, 0, sizeof(libdbo_backend_lmdb_field_t));
+
+    switch (libdbo_value_type(value)) {
+    case LIBDBO_TYPE_EMPTY:
+        field->type = LIBDBO_TYPE_EMPTY;
+        break;
+
+    case LIBDBO_TYPE_INT32:
+        if (!(int32 = libdbo_value_int32(value))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        __db_backend_lmdb_field_signed(field, LIBDBO_TYPE_INT32, *int32);
+        break;
+
+    case LIBDBO_TYPE_UINT32:
+        if (!(uint32 = libdbo_value_uint32(value))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        __db_backend_lmdb_field_integer(field, LIBDBO_TYPE_UINT32, 0, *uint32);
+        break;
+
+    case LIBDBO_TYPE_INT64:
+        if (!(int64 = libdbo_value_int64(value))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        __db_backend_lmdb_field_signed(field, LIBDBO_TYPE_INT64, *int64);
+        break;
+
+    case LIBDBO_TYPE_UINT64:
+        if (!(uint64 = libdbo_value_uint64(value))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        __db_backend_lmdb_field_integer(field, LIBDBO_TYPE_UINT64, 0, *uint64);
+        break;
+
+    case LIBDBO_TYPE_ENUM:
+        if (libdbo_value_enum_value(value, &enum_value)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        __db_backend_lmdb_field_signed(field, LIBDBO_TYPE_INT32, enum_value);
+        break;
+
+    case LIBDBO_TYPE_TEXT:
+        if (!(field->text = libdbo_value_text(value))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        field->type = LIBDBO_TYPE_TEXT;
+        field->length = strlen(field->text);
+        break;
+
+    default:
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Set an empty value from a field.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_lmdb_field_to_value(const libdbo_backend_lmdb_field_t* field, libdbo_value_t* value) {
+    switch (field->type) {
+    case LIBDBO_TYPE_EMPTY:
+        return LIBDBO_OK;
+
+    case LIBDBO_TYPE_INT32:
+        return libdbo_value_from_int32(value, (libdbo_type_int32_t)__db_backend_lmdb_field_int64(field));
+
+    case LIBDBO_TYPE_UINT32:
+        return libdbo_value_from_uint32(value, (libdbo_type_uint32_t)field->magnitude);
+
+    case LIBDBO_TYPE_INT64:
+        return libdbo_value_from_int64(value, __db_backend_lmdb_field_int64(field));
+
+    case LIBDBO_TYPE_UINT64:
+        return libdbo_value_from_uint64(value, field->magnitude);
+
+    case LIBDBO_TYPE_TEXT:
+        return libdbo_value_from_text(value, field->text);
+
+    default:
+        break;
+    }
+
+    return LIBDBO_ERROR_UNKNOWN;
+}
+
+/**
+ * Compare two fields, integers of different types are compared by their
+ * numeric value and text byte by byte.
+ * \param[out] result set to less then, equal to or greater then zero.
+ * \return LIBDBO_ERROR_* if the fields can not be compared to each other,
+ * otherwise LIBDBO_OK.
+ */
+static int __db_backend_lmdb_compare(const libdbo_backend_lmdb_field_t* field_a, const libdbo_backend_lmdb_field_t* field_b, int* result) {
+    if (field_a->type == LIBDBO_TYPE_EMPTY || field_b->type == LIBDBO_TYPE_EMPTY) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (field_a->type == LIBDBO_TYPE_TEXT || field_b->type == LIBDBO_TYPE_TEXT) {
+        if (field_a->type != field_b->type) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        *result = memcmp(field_a->text, field_b->text, field_a->length < field_b->length ? field_a->length : field_b->length);
+        if (!*result && field_a->length != field_b->length) {
+            *result = field_a->length < field_b->length ? -1 : 1;
+        }
+        return LIBDBO_OK;
+    }
+
+    if (field_a->negative != field_b->negative) {
+        *result = field_a->negative ? -1 : 1;
+    }
+    else if (field_a->magnitude == field_b->magnitude) {
+        *result = 0;
+    }
+    else if (field_a->negative) {
+        *result = field_a->magnitude > field_b->magnitude ? -1 : 1;
+    }
+    else {
+        *result = field_a->magnitude < field_b->magnitude ? -1 : 1;
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Get the primary key from a field.
+ * \return LIBDBO_ERROR_* if the field is not a positive integer, otherwise
+ * LIBDBO_OK.
+ */
+static int __db_backend_lmdb_field_id(const libdbo_backend_lmdb_field_t* field, libdbo_type_uint64_t* id) {
+    if (field->type == LIBDBO_TYPE_EMPTY
+        || field->type == LIBDBO_TYPE_TEXT
+        || field->negative)
+    {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    *id = field->magnitude;
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Encode the fields of a row into a buffer. A row is the number of fields
+ * followed by each field as its type and value, integers in host byte order
+ * and text with its length and a terminating null so it can be used directly.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_lmdb_encode(libdbo_backend_lmdb_buffer_t* buffer, const libdbo_backend_lmdb_field_t* fields, size_t fields_size) {
+    libdbo_type_int32_t int32;
+    libdbo_type_uint32_t uint32;
+    libdbo_type_int64_t int64;
+    libdbo_type_uint64_t uint64;
+    unsigned char type;
+    size_t i;
+
+    buffer->size = 0;
+    uint32 = (libdbo_type_uint32_t)fields_size;
+    if (__db_backend_lmdb_buffer_add(buffer, &uint32, sizeof(uint32))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    for (i = 0; i < fields_size; i++) {
+        type = (unsigned char)fields[i].type;
+        if (__db_backend_lmdb_buffer_add(buffer, &type, 1)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+
+        switch (fields[i].type) {
+        case LIBDBO_TYPE_EMPTY:
+            break;
+
+        case LIBDBO_TYPE_INT32:
+            int32 = (libdbo_type_int32_t)__db_backend_lmdb_field_int64(&fields[i]);
+            if (__db_backend_lmdb_buffer_add(buffer, &int32, sizeof(int32))) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            break;
+
+        case LIBDBO_TYPE_UINT32:
+            uint32 = (libdbo_type_uint32_t)fields[i].magnitude;
+            if (__db_backend_lmdb_buffer_add(buffer, &uint32, sizeof(uint32))) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            break;
+
+        case LIBDBO_TYPE_INT64:
+            int64 = __db_backend_lmdb_field_int64(&fields[i]);
+            if (__db_backend_lmdb_buffer_add(buffer, &int64, sizeof(int64))) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            break;
+
+        case LIBDBO_TYPE_UINT64:
+            uint64 = fields[i].magnitude;
+            if (__db_backend_lmdb_buffer_add(buffer, &uint64, sizeof(uint64))) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            break;
+
+        case LIBDBO_TYPE_TEXT:
+            uint32 = (libdbo_type_uint32_t)fields[i].length;
+            if (__db_backend_lmdb_buffer_add(buffer, &uint32, sizeof(uint32))
+                || __db_backend_lmdb_buffer_add(buffer, fields[i].text, fields[i].length + 1))
+            {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            break;
+
+        default:
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Decode a row into fields that points into the row, fields that are not in
+ * the row are empty.
+ * \return LIBDBO_ERROR_* if the row is corrupt, otherwise LIBDBO_OK.
+ */
+static int __db_backend_lmdb_decode(const MDB_val* data, libdbo_backend_lmdb_field_t* fields, size_t fields_size) {
+    const unsigned char* row = (const unsigned char*)data->mv_data;
+    const unsigned char* end = row + data->mv_size;
+    libdbo_backend_lmdb_field_t field;
+    libdbo_type_int32_t int32;
+    libdbo_type_uint32_t uint32;
+    libdbo_type_int64_t int64;
+    libdbo_type_uint64_t uint64;
+    libdbo_type_uint32_t count, i;
+
+    memset(fields, 0, fields_size * sizeof(libdbo_backend_lmdb_field_t));
+
+    if ((size_t)(end - row) < sizeof(count)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    memcpy(&count, row, sizeof(count));
+    row += sizeof(count);
+
+    for (i = 0; i < count; i++) {
+        memset(&field, 0, sizeof(field));
+        if (row >= end) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        field.type = (libdbo_type_t)*row++;
+
+        switch (field.type) {
+        case LIBDBO_TYPE_EMPTY:
+            break;
+
+        case LIBDBO_TYPE_INT32:
+            if ((size_t)(end - row) < sizeof(int32)) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            memcpy(&int32, row, sizeof(int32));
+            row += sizeof(int32);
+            __db_backend_lmdb_field_signed(&field, LIBDBO_TYPE_INT32, int32);
+            break;
+
+        case LIBDBO_TYPE_UINT32:
+            if ((size_t)(end - row) < sizeof(uint32)) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            memcpy(&uint32, row, sizeof(uint32));
+            row += sizeof(uint32);
+            __db_backend_lmdb_field_integer(&field, LIBDBO_TYPE_UINT32, 0, uint32);
+            break;
+
+        case LIBDBO_TYPE_INT64:
+            if ((size_t)(end - row) < sizeof(int64)) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            memcpy(&int64, row, sizeof(int64));
+            row += sizeof(int64);
+            __db_backend_lmdb_field_signed(&field, LIBDBO_TYPE_INT64, int64);
+            break;
+
+        case LIBDBO_TYPE_UINT64:
+            if ((size_t)(end - row) < sizeof(uint64)) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            memcpy(&uint64, row, sizeof(uint64));
+            row += sizeof(uint64);
+            __db_backend_lmdb_field_integer(&field, LIBDBO_TYPE_UINT64, 0, uint64);
+            break;
+
+        case LIBDBO_TYPE_TEXT:
+            if ((size_t)(end - row) < sizeof(uint32)) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            memcpy(&uint32, row, sizeof(uint32));
+            row += sizeof(uint32);
+            if ((size_t)(end - row) < (size_t)uint32 + 1 || row[uint32]) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            field.text = (const char*)row;
+            field.length = uint32;
+            row += uint32 + 1;
+            break;
+
+        default:
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+
+        if (i < fields_size) {
+            fields[i] = field;
+        }
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Encode a field as a key of an index.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_lmdb_index_key(libdbo_backend_lmdb_buffer_t* buffer, const libdbo_backend_lmdb_field_t* field, MDB_val* key) {
+    unsigned char data[10];
+    libdbo_type_uint64_t hash;
+    size_t i;
+
+    buffer->size = 0;
+
+    if (field->type == LIBDBO_TYPE_TEXT) {
+        if (field->length > LIBDBO_BACKEND_LMDB_KEY_TEXT) {
+            /*
+             * FNV-1a
+             */
+            hash = 14695981039346656037ULL;
+            for (i = 0; i < field->length; i++) {
+                hash ^= (unsigned char)field->text[i];
+                hash *= 1099511628211ULL;
+            }
+            data[0] = 'h';
+            __db_backend_lmdb_key(hash, &data[1]);
+            if (__db_backend_lmdb_buffer_add(buffer, data, 9)
+                || __db_backend_lmdb_buffer_add(buffer, field->text, LIBDBO_BACKEND_LMDB_KEY_TEXT))
+            {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+        }
+        else {
+            data[0] = 't';
+            if (__db_backend_lmdb_buffer_add(buffer, data, 1)
+                || __db_backend_lmdb_buffer_add(buffer, field->text, field->length))
+            {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+        }
+    }
+    else {
+        data[0] = 'i';
+        data[1] = field->negative ? 0 : 1;
+        __db_backend_lmdb_key(field->magnitude, &data[2]);
+        if (__db_backend_lmdb_buffer_add(buffer, data, 10)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+
+    key->mv_size = buffer->size;
+    key->mv_data = buffer->data;
+    return LIBDBO_OK;
+}
+
+/**
+ * Check if `table.field` is in a comma separated list.
+ * \return non-zero if it is.
+ */
+static int __db_backend_lmdb_listed(const char* list, const char* table, const char* field) {
+    size_t table_length = strlen(table);
+    size_t field_length = strlen(field);
+    const char* end;
+
+    while (list && *list) {
+        while (*list == ' ' || *list == ',') {
+            list++;
+        }
+        if (!*list) {
+            break;
+        }
+        if (!(end = strchr(list, ','))) {
+            end = list + strlen(list);
+        }
+        if ((size_t)(end - list) == table_length + 1 + field_length
+            && !strncmp(list, table, table_length)
+            && list[table_length] == '.'
+            && !strncmp(list + table_length + 1, field, field_length))
+        {
+            return 1;
+        }
+        list = end;
+    }
+
+    return 0;
+}
+
+/**
+ * Build the key of an entry in the meta sub-database.
+ * \return a newly allocated string or NULL on error.
+ */
+static char* __db_backend_lmdb_meta_key(const char* prefix, const char* name) {
+    char* key;
+    size_t size = strlen(prefix) + strlen(name) + 1;
+
+    if ((key = malloc(size))) {
+        snprintf(key, size, "%s%s", prefix, name);
+    }
+
+    return key;
+}
+
+/**
+ * Get the position of a field in a table.
+ * \return the position or `fields_size` of the table if not found.
+ */
+static size_t __db_backend_lmdb_field(const libdbo_backend_lmdb_table_t* table, const char* name) {
+    size_t i;
+
+    for (i = 0; i < table->fields_size; i++) {
+        if (!strcmp(table->fields[i], name)) {
+            break;
+        }
+    }
+
+    return i;
+}
+
+/**
+ * Add a field to a table.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_lmdb_field_add(libdbo_backend_lmdb_table_t* table, const char* name, size_t length) {
+    char** fields;
+    size_t allocated;
+
+    if (table->fields_size == table->fields_allocated) {
+        allocated = table->fields_allocated ? table->fields_allocated * 2 : 8;
+        if (!(fields = realloc(table->fields, allocated * sizeof(char*)))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        table->fields = fields;
+        table->fields_allocated = allocated;
+    }
+    if (!(table->fields[table->fields_size] = malloc(length + 1))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    memcpy(table->fields[table->fields_size], name, length);
+    table->fields[table->fields_size][length] = 0;
+    table->fields_size++;
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Free a table.
+ */
+static void __db_backend_lmdb_table_free(libdbo_backend_lmdb_table_t* table) {
+    libdbo_backend_lmdb_index_t* index;
+    size_t i;
+
+    if (!table) {
+        return;
+    }
+
+    while ((index = table->index_list)) {
+        table->index_list = index->next;
+        libdbo_mm_delete(&__lmdb_index_alloc, index);
+    }
+    for (i = 0; i < table->fields_size; i++) {
+        free(table->fields[i]);
+    }
+    free(table->fields);
+    free(table->name);
+    libdbo_mm_delete(&__lmdb_table_alloc, table);
+}
+
+/**
+ * Forget the tables opened or changed in transactions deeper then `depth`.
+ */
+static void __db_backend_lmdb_table_forget(libdbo_backend_lmdb_t* backend_lmdb, int depth) {
+    libdbo_backend_lmdb_table_t** table = &(backend_lmdb->table_list);
+    libdbo_backend_lmdb_table_t* forget;
+
+    while (*table) {
+        if ((*table)->depth > depth) {
+            forget = *table;
+            *table = forget->next;
+            __db_backend_lmdb_table_free(forget);
+            continue;
+        }
+        table = &((*table)->next);
+    }
+}
+
+/**
+ * Find the index of a field.
+ * \return a libdbo_backend_lmdb_index_t pointer or NULL if the field is not
+ * indexed.
+ */
+static libdbo_backend_lmdb_index_t* __db_backend_lmdb_index(const libdbo_backend_lmdb_table_t* table, size_t field) {
+    libdbo_backend_lmdb_index_t* index;
+
+    for (index = table->index_list; index; index = index->next) {
+        if (index->field == field) {
+            return index;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Add the index entries of a row.
+ * \return LIBDBO_ERROR_* on failure or if a unique index already has the
+ * value, otherwise LIBDBO_OK.
+ */
+static int __db_backend_lmdb_index_put(libdbo_backend_lmdb_t* backend_lmdb, MDB_txn* txn, const libdbo_backend_lmdb_table_t* table, const libdbo_backend_lmdb_field_t* fields, libdbo_type_uint64_t id) {
+    const libdbo_backend_lmdb_index_t* index;
+    unsigned char id_key[8];
+    MDB_val key, data;
+    int ret;
+
+    __db_backend_lmdb_key(id, id_key);
+    for (index = table->index_list; index; index = index->next) {
+        if (fields[index->field].type == LIBDBO_TYPE_EMPTY) {
+            continue;
+        }
+        if (__db_backend_lmdb_index_key(&(backend_lmdb->key), &fields[index->field], &key)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        data.mv_size = sizeof(id_key);
+        data.mv_data = id_key;
+        ret = mdb_put(txn, index->dbi, &key, &data, index->unique ? MDB_NOOVERWRITE : MDB_NODUPDATA);
+        if (ret == MDB_KEYEXIST && !index->unique) {
+            continue;
+        }
+        if (ret) {
+            if (ret != MDB_KEYEXIST) {
+                __db_backend_lmdb_error("index put", ret);
+            }
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Remove the index entry of a field of a row.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_lmdb_index_del(libdbo_backend_lmdb_buffer_t* buffer, MDB_txn* txn, const libdbo_backend_lmdb_index_t* index, const libdbo_backend_lmdb_field_t* field, libdbo_type_uint64_t id) {
+    unsigned char id_key[8];
+    MDB_val key, data;
+    int ret;
+
+    if (field->type == LIBDBO_TYPE_EMPTY) {
+        return LIBDBO_OK;
+    }
+    if (__db_backend_lmdb_index_key(buffer, field, &key)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    __db_backend_lmdb_key(id, id_key);
+    data.mv_size = sizeof(id_key);
+    data.mv_data = id_key;
+    if ((ret = mdb_del(txn, index->dbi, &key, &data)) && ret != MDB_NOTFOUND) {
+        __db_backend_lmdb_error("index del", ret);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Open the index sub-databases of the fields of a table that are configured
+ * to be indexed, an index that has not been built yet is built from the rows
+ * in the table.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_lmdb_table_indexes(libdbo_backend_lmdb_t* backend_lmdb, MDB_txn* txn, libdbo_backend_lmdb_table_t* table) {
+    libdbo_backend_lmdb_index_t* index;
+    libdbo_backend_lmdb_field_t* fields;
+    MDB_cursor* cursor;
+    MDB_val key, data;
+    char* name;
+    char* meta_key;
+    size_t i;
+    int unique, ret;
+
+    for (i = 0; i < table->fields_size; i++) {
+        if (i == table->primary_key || __db_backend_lmdb_index(table, i)) {
+            continue;
+        }
+        unique = __db_backend_lmdb_listed(backend_lmdb->unique, table->name, table->fields[i]);
+        if (!unique && !__db_backend_lmdb_listed(backend_lmdb->index, table->name, table->fields[i])) {
+            continue;
+        }
+
+        if (!(index = libdbo_mm_new0(&__lmdb_index_alloc))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        index->field = i;
+        index->unique = unique;
+        if (!(name = malloc(strlen(table->name) + strlen(table->fields[i]) + 2))) {
+            libdbo_mm_delete(&__lmdb_index_alloc, index);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        sprintf(name, "%s.%s", table->name, table->fields[i]);
+        if ((ret = mdb_dbi_open(txn, name, MDB_CREATE | (unique ? 0 : MDB_DUPSORT | MDB_DUPFIXED), &(index->dbi)))) {
+            libdbo_log(LIBDBO_LOG_ERROR, "LMDB open index %s: %s", name, mdb_strerror(ret));
+            free(name);
+            libdbo_mm_delete(&__lmdb_index_alloc, index);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        index->next = table->index_list;
+        table->index_list = index;
+
+        /*
+         * Build the index if it has not been built before.
+         */
+        if (!(meta_key = __db_backend_lmdb_meta_key("index:", name))) {
+            free(name);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        free(name);
+        key.mv_size = strlen(meta_key);
+        key.mv_data = meta_key;
+        if (!(ret = mdb_get(txn, backend_lmdb->env->meta, &key, &data))) {
+            free(meta_key);
+            continue;
+        }
+        if (ret != MDB_NOTFOUND
+            || !(fields = calloc(table->fields_size, sizeof(libdbo_backend_lmdb_field_t))))
+        {
+            free(meta_key);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        if ((ret = mdb_cursor_open(txn, table->dbi, &cursor))) {
+            __db_backend_lmdb_error("cursor open", ret);
+            free(fields);
+            free(meta_key);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        ret = mdb_cursor_get(cursor, &key, &data, MDB_FIRST);
+        while (!ret) {
+            if (key.mv_size != 8
+                || __db_backend_lmdb_decode(&data, fields, table->fields_size)
+                || __db_backend_lmdb_index_put(backend_lmdb, txn, table, fields, __db_backend_lmdb_key_id(key.mv_data)))
+            {
+                libdbo_log(LIBDBO_LOG_ERROR, "LMDB unable to build index on %s.%s", table->name, table->fields[i]);
+                break;
+            }
+            ret = mdb_cursor_get(cursor, &key, &data, MDB_NEXT);
+        }
+        mdb_cursor_close(cursor);
+        free(fields);
+        if (ret != MDB_NOTFOUND) {
+            free(meta_key);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        key.mv_size = strlen(meta_key);
+        key.mv_data = meta_key;
+        data.mv_size = 1;
+        data.mv_data = "1";
+        ret = mdb_put(txn, backend_lmdb->env->meta, &key, &data, 0);
+        free(meta_key);
+        if (ret) {
+            __db_backend_lmdb_error("meta put", ret);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Check if an object has fields that the table does not have.
+ * \return non-zero if it has.
+ */
+static int __db_backend_lmdb_table_missing(const libdbo_backend_lmdb_table_t* table, const libdbo_object_t* object) {
+    const libdbo_object_field_t* object_field;
+
+    object_field = libdbo_object_field_list_begin(libdbo_object_object_field_list(object));
+    while (object_field) {
+        if (__db_backend_lmdb_field(table, libdbo_object_field_name(object_field)) == table->fields_size) {
+            return 1;
+        }
+        object_field = libdbo_object_field_next(object_field);
+    }
+
+    return 0;
+}
+
+/**
+ * Begin a write transaction, nested in the current transaction if there is
+ * one.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_lmdb_begin(libdbo_backend_lmdb_t* backend_lmdb, MDB_txn** txn) {
+    int ret;
+
+    if ((ret = mdb_txn_begin(backend_lmdb->env->env,
+        backend_lmdb->transaction ? backend_lmdb->txns[backend_lmdb->transaction - 1] : NULL,
+        0, txn)))
+    {
+        __db_backend_lmdb_error("begin", ret);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Commit a write transaction started with __db_backend_lmdb_begin().
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_lmdb_commit(MDB_txn* txn) {
+    int ret;
+
+    if ((ret = mdb_txn_commit(txn))) {
+        __db_backend_lmdb_error("commit", ret);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Get a transaction to read with, the current transaction if there is one
+ * otherwise the read-only transaction which is renewed to see the latest
+ * committed data.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_lmdb_read_begin(libdbo_backend_lmdb_t* backend_lmdb, MDB_txn** txn) {
+    int ret;
+
+    if (backend_lmdb->transaction) {
+        *txn = backend_lmdb->txns[backend_lmdb->transaction - 1];
+        return LIBDBO_OK;
+    }
+
+    if (backend_lmdb->read_txn) {
+        ret = mdb_txn_renew(backend_lmdb->read_txn);
+    }
+    else {
+        ret = mdb_txn_begin(backend_lmdb->env->env, NULL, MDB_RDONLY, &(backend_lmdb->read_txn));
+    }
+    if (ret) {
+        __db_backend_lmdb_error("read begin", ret);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    *txn = backend_lmdb->read_txn;
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Release a transaction from __db_backend_lmdb_read_begin().
+ */
+static void __db_backend_lmdb_read_end(libdbo_backend_lmdb_t* backend_lmdb, MDB_txn* txn) {
+    if (txn == backend_lmdb->read_txn) {
+        mdb_txn_reset(txn);
+    }
+}
+
+/**
+ * Get a table, it is opened and created if needed and the fields of the
+ * object, if given, are added to it if it does not have them.
+ * \return a libdbo_backend_lmdb_table_t pointer or NULL on error.
+ */
+static libdbo_backend_lmdb_table_t* __db_backend_lmdb_table(libdbo_backend_lmdb_t* backend_lmdb, const char* name, const libdbo_object_t* object) {
+    libdbo_backend_lmdb_table_t* table;
+    libdbo_backend_lmdb_table_t** list;
+    libdbo_backend_lmdb_buffer_t description = { NULL, 0, 0 };
+    const libdbo_object_field_t* object_field;
+    const char* field;
+    const char* end;
+    char* meta_key = NULL;
+    MDB_txn* txn;
+    MDB_val key, data;
+    size_t i;
+    int opened = 0, changed = 0, ret;
+    unsigned char flag;
+
+    for (table = backend_lmdb->table_list; table; table = table->next) {
+        if (!strcmp(table->name, name)) {
+            break;
+        }
+    }
+    if (table && (!object || !__db_backend_lmdb_table_missing(table, object))) {
+        return table;
+    }
+
+    if (__db_backend_lmdb_begin(backend_lmdb, &txn)) {
+        return NULL;
+    }
+    if (!(meta_key = __db_backend_lmdb_meta_key("fields:", name))) {
+        mdb_txn_abort(txn);
+        return NULL;
+    }
+
+    if (!table) {
+        opened = 1;
+        if (!(table = libdbo_mm_new0(&__lmdb_table_alloc))
+            || !(table->name = strdup(name)))
+        {
+            goto error;
+        }
+        table->primary_key = LIBDBO_BACKEND_LMDB_NONE;
+        table->revision = LIBDBO_BACKEND_LMDB_NONE;
+        if ((ret = mdb_dbi_open(txn, name, MDB_CREATE, &(table->dbi)))) {
+            libdbo_log(LIBDBO_LOG_ERROR, "LMDB open table %s: %s", name, mdb_strerror(ret));
+            goto error;
+        }
+
+        /*
+         * Load the stored description of the table, each field is a flag
+         * followed by the null terminated name.
+         */
+        key.mv_size = strlen(meta_key);
+        key.mv_data = meta_key;
+        if (!(ret = mdb_get(txn, backend_lmdb->env->meta, &key, &data))) {
+            field = (const char*)data.mv_data;
+            end = field + data.mv_size;
+            while (field < end) {
+                flag = (unsigned char)*field++;
+                for (i = 0; field + i < end && field[i]; i++);
+                if (field + i >= end) {
+                    libdbo_log(LIBDBO_LOG_ERROR, "LMDB description of table %s is corrupt", name);
+                    goto error;
+                }
+                if (flag == LIBDBO_BACKEND_LMDB_PRIMARY_KEY) {
+                    table->primary_key = table->fields_size;
+                }
+                else if (flag == LIBDBO_BACKEND_LMDB_REVISION) {
+                    table->revision = table->fields_size;
+                }
+                if (__db_backend_lmdb_field_add(table, field, i)) {
+                    goto error;
+                }
+                field += i + 1;
+            }
+        }
+        else if (ret != MDB_NOTFOUND) {
+            __db_backend_lmdb_error("meta get", ret);
+            goto error;
+        }
+    }
+
+    if (object) {
+        object_field = libdbo_object_field_list_begin(libdbo_object_object_field_list(object));
+        while (object_field) {
+            if (__db_backend_lmdb_field(table, libdbo_object_field_name(object_field)) == table->fields_size) {
+                if (libdbo_object_field_type(object_field) == LIBDBO_TYPE_PRIMARY_KEY
+                    && table->primary_key == LIBDBO_BACKEND_LMDB_NONE)
+                {
+                    table->primary_key = table->fields_size;
+                }
+                else if (libdbo_object_field_type(object_field) == LIBDBO_TYPE_REVISION
+                    && table->revision == LIBDBO_BACKEND_LMDB_NONE)
+                {
+                    table->revision = table->fields_size;
+                }
+                if (__db_backend_lmdb_field_add(table, libdbo_object_field_name(object_field), strlen(libdbo_object_field_name(object_field)))) {
+                    goto error;
+                }
+                changed = 1;
+            }
+            object_field = libdbo_object_field_next(object_field);
+        }
+    }
+
+    if (changed) {
+        for (i = 0; i < table->fields_size; i++) {
+            if (i == table->primary_key) {
+                flag = LIBDBO_BACKEND_LMDB_PRIMARY_KEY;
+            }
+            else if (i == table->revision) {
+                flag = LIBDBO_BACKEND_LMDB_REVISION;
+            }
+            else {
+                flag = LIBDBO_BACKEND_LMDB_FIELD;
+            }
+            if (__db_backend_lmdb_buffer_add(&description, &flag, 1)
+                || __db_backend_lmdb_buffer_add(&description, table->fields[i], strlen(table->fields[i]) + 1))
+            {
+                goto error;
+            }
+        }
+        key.mv_size = strlen(meta_key);
+        key.mv_data = meta_key;
+        data.mv_size = description.size;
+        data.mv_data = description.data;
+        if ((ret = mdb_put(txn, backend_lmdb->env->meta, &key, &data, 0))) {
+            __db_backend_lmdb_error("meta put", ret);
+            goto error;
+        }
+    }
+
+    if ((opened || changed)
+        && __db_backend_lmdb_table_indexes(backend_lmdb, txn, table))
+    {
+        goto error;
+    }
+
+    if (__db_backend_lmdb_commit(txn)) {
+        txn = NULL;
+        goto error;
+    }
+    free(description.data);
+    free(meta_key);
+
+    if (opened || changed) {
+        table->depth = backend_lmdb->transaction;
+    }
+    if (opened) {
+        table->next = backend_lmdb->table_list;
+        backend_lmdb->table_list = table;
+    }
+    return table;
+
+error:
+    if (txn) {
+        mdb_txn_abort(txn);
+    }
+    free(description.data);
+    free(meta_key);
+    if (!opened) {
+        /*
+         * The table was changed, forget it so it is loaded again.
+         */
+        for (list = &(backend_lmdb->table_list); *list; list = &((*list)->next)) {
+            if (*list == table) {
+                *list = table->next;
+                break;
+            }
+        }
+    }
+    __db_backend_lmdb_table_free(table);
+    return NULL;
+}
+
+/**
+ * Get the field of the clause from the rows being matched.
+ * \return a libdbo_backend_lmdb_field_t pointer or NULL if the field does not
+ * exist.
+ */
+static const libdbo_backend_lmdb_field_t* __db_backend_lmdb_clause_field(const libdbo_backend_lmdb_select_t* select, const libdbo_clause_t* clause) {
+    const char* table = libdbo_clause_table(clause) ? libdbo_clause_table(clause) : select->tuples[0].table->name;
+    size_t i, field;
+
+    for (i = 0; i <= select->joins_size; i++) {
+        if (!strcmp(select->tuples[i].table->name, table)) {
+            if ((field = __db_backend_lmdb_field(select->tuples[i].table, libdbo_clause_field(clause))) == select->tuples[i].table->fields_size) {
+                break;
+            }
+            return &(select->tuples[i].fields[field]);
+        }
+    }
+
+    libdbo_log(LIBDBO_LOG_ERROR, "LMDB clause field %s.%s not found", table, libdbo_clause_field(clause));
+    return NULL;
+}
+
+static int __db_backend_lmdb_match(const libdbo_backend_lmdb_select_t* select, const libdbo_clause_list_t* clause_list, int* match);
+
+/**
+ * Check if a single clause matches the rows being matched. Like in SQL an
+ * empty value never matches a comparison and neither does a comparison
+ * between values of types that can not be compared.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_lmdb_match_clause(const libdbo_backend_lmdb_select_t* select, const libdbo_clause_t* clause, int* match) {
+    const libdbo_backend_lmdb_field_t* field;
+    libdbo_backend_lmdb_field_t value;
+    int cmp;
+
+    if (libdbo_clause_type(clause) == LIBDBO_CLAUSE_NESTED) {
+        return __db_backend_lmdb_match(select, libdbo_clause_list(clause), match);
+    }
+
+    if (!(field = __db_backend_lmdb_clause_field(select, clause))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    switch (libdbo_clause_type(clause)) {
+    case LIBDBO_CLAUSE_IS_NULL:
+        *match = field->type == LIBDBO_TYPE_EMPTY;
+        return LIBDBO_OK;
+
+    case LIBDBO_CLAUSE_IS_NOT_NULL:
+        *match = field->type != LIBDBO_TYPE_EMPTY;
+        return LIBDBO_OK;
+
+    default:
+        break;
+    }
+
+    if (__db_backend_lmdb_field_from_value(&value, libdbo_clause_value(clause))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (__db_backend_lmdb_compare(field, &value, &cmp)) {
+        *match = 0;
+        return LIBDBO_OK;
+    }
+
+    switch (libdbo_clause_type(clause)) {
+    case LIBDBO_CLAUSE_EQUAL:
+        *match = cmp == 0;
+        break;
+
+    case LIBDBO_CLAUSE_NOT_EQUAL:
+        *match = cmp != 0;
+        break;
+
+    case LIBDBO_CLAUSE_LESS_THEN:
+        *match = cmp < 0;
+        break;
+
+    case LIBDBO_CLAUSE_LESS_OR_EQUAL:
+        *match = cmp <= 0;
+        break;
+
+    case LIBDBO_CLAUSE_GREATER_OR_EQUAL:
+        *match = cmp >= 0;
+        break;
+
+    case LIBDBO_CLAUSE_GREATER_THEN:
+        *match = cmp > 0;
+        break;
+
+    default:
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Check if a clause list matches the rows being matched. The operator of each
+ * clause joins it with the clause before it and AND is evaluated before OR,
+ * the same way the SQL backends builds their WHERE.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_lmdb_match(const libdbo_backend_lmdb_select_t* select, const libdbo_clause_list_t* clause_list, int* match) {
+    const libdbo_clause_t* clause;
+    int any = 0, group = 1, first = 1, clause_match;
+
+    for (clause = libdbo_clause_list_begin(clause_list); clause; clause = libdbo_clause_next(clause)) {
+        if (first) {
+            first = 0;
+        }
+        else {
+            switch (libdbo_clause_operator(clause)) {
+            case LIBDBO_CLAUSE_OPERATOR_AND:
+                break;
+
+            case LIBDBO_CLAUSE_OPERATOR_OR:
+                any |= group;
+                group = 1;
+                break;
+
+            default:
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+        }
+
+        if (!group || any || clause == select->skip) {
+            continue;
+        }
+        if (__db_backend_lmdb_match_clause(select, clause, &clause_match)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        group = clause_match;
+    }
+
+    *match = any | group;
+    return LIBDBO_OK;
+}
+
+static int __db_backend_lmdb_select_join(const libdbo_backend_lmdb_select_t* select, size_t join);
+
+/**
+ * Process a row found for tuple `tuple`, it is matched against the join it
+ * was found for and then the next join is processed or, if this was the last
+ * one, the clauses are matched.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_lmdb_select_row(const libdbo_backend_lmdb_select_t* select, size_t tuple, const MDB_val* key, const MDB_val* data) {
+    libdbo_backend_lmdb_tuple_t* current = &(select->tuples[tuple]);
+    const libdbo_backend_lmdb_join_t* join;
+    int match = 1, cmp;
+
+    if (key->mv_size != 8
+        || __db_backend_lmdb_decode(data, current->fields, current->table->fields_size))
+    {
+        libdbo_log(LIBDBO_LOG_ERROR, "LMDB row in table %s is corrupt", current->table->name);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    current->key = __db_backend_lmdb_key_id(key->mv_data);
+
+    if (tuple) {
+        /*
+         * Check that the row found by an index or scan really matches the
+         * join.
+         */
+        join = &(select->joins[tuple - 1]);
+        if (__db_backend_lmdb_compare(&(select->tuples[join->from].fields[join->from_field]), &(current->fields[join->field]), &cmp)
+            || cmp)
+        {
+            return LIBDBO_OK;
+        }
+    }
+
+    if (tuple < select->joins_size) {
+        return __db_backend_lmdb_select_join(select, tuple);
+    }
+
+    if (select->clause_list && __db_backend_lmdb_match(select, select->clause_list, &match)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (match) {
+        return select->match(select->context, select->tuples);
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Find the rows of a table with a field equal to `field`, using the primary
+ * key or an index if possible, and process them for tuple `tuple`.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_lmdb_select_equal(const libdbo_backend_lmdb_select_t* select, size_t tuple, const libdbo_backend_lmdb_table_t* table, size_t position, const libdbo_backend_lmdb_index_t* index, const libdbo_backend_lmdb_field_t* field) {
+    libdbo_backend_lmdb_buffer_t buffer = { NULL, 0, 0 };
+    unsigned char id_key[8];
+    libdbo_type_uint64_t id;
+    MDB_cursor* cursor;
+    MDB_val key, data, row_key, row;
+    int ret;
+
+    if (field->type == LIBDBO_TYPE_EMPTY) {
+        return LIBDBO_OK;
+    }
+
+    if (position == table->primary_key) {
+        if (__db_backend_lmdb_field_id(field, &id)) {
+            return LIBDBO_OK;
+        }
+        __db_backend_lmdb_key(id, id_key);
+        key.mv_size = sizeof(id_key);
+        key.mv_data = id_key;
+        if ((ret = mdb_get(select->txn, table->dbi, &key, &row))) {
+            if (ret == MDB_NOTFOUND) {
+                return LIBDBO_OK;
+            }
+            __db_backend_lmdb_error("get", ret);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        return __db_backend_lmdb_select_row(select, tuple, &key, &row);
+    }
+
+    /*
+     * The key buffer can not be shared since the rows processed may look up
+     * other indexes.
+     */
+    if (__db_backend_lmdb_index_key(&buffer, field, &key)) {
+        free(buffer.data);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if ((ret = mdb_cursor_open(select->txn, index->dbi, &cursor))) {
+        __db_backend_lmdb_error("cursor open", ret);
+        free(buffer.data);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    ret = mdb_cursor_get(cursor, &key, &data, MDB_SET_KEY);
+    while (!ret) {
+        if (data.mv_size != 8) {
+            ret = MDB_CORRUPTED;
+            break;
+        }
+        row_key = data;
+        if ((ret = mdb_get(select->txn, table->dbi, &row_key, &row))) {
+            break;
+        }
+        if (__db_backend_lmdb_select_row(select, tuple, &row_key, &row)) {
+            mdb_cursor_close(cursor);
+            free(buffer.data);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        if (index->unique) {
+            ret = MDB_NOTFOUND;
+            break;
+        }
+        ret = mdb_cursor_get(cursor, &key, &data, MDB_NEXT_DUP);
+    }
+    mdb_cursor_close(cursor);
+    free(buffer.data);
+    if (ret != MDB_NOTFOUND) {
+        __db_backend_lmdb_error("index get", ret);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Process all the rows of a table for tuple `tuple`.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_lmdb_select_scan(const libdbo_backend_lmdb_select_t* select, size_t tuple, const libdbo_backend_lmdb_table_t* table) {
+    MDB_cursor* cursor;
+    MDB_val key, data;
+    int ret;
+
+    if ((ret = mdb_cursor_open(select->txn, table->dbi, &cursor))) {
+        __db_backend_lmdb_error("cursor open", ret);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    ret = mdb_cursor_get(cursor, &key, &data, MDB_FIRST);
+    while (!ret) {
+        if (__db_backend_lmdb_select_row(select, tuple, &key, &data)) {
+            mdb_cursor_close(cursor);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        ret = mdb_cursor_get(cursor, &key, &data, MDB_NEXT);
+    }
+    mdb_cursor_close(cursor);
+    if (ret != MDB_NOTFOUND) {
+        __db_backend_lmdb_error("cursor get", ret);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Find the rows of the joined table of join `join`.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_lmdb_select_join(const libdbo_backend_lmdb_select_t* select, size_t join) {
+    const libdbo_backend_lmdb_join_t* current = &(select->joins[join]);
+
+    if (current->field == current->table->primary_key || current->index) {
+        return __db_backend_lmdb_select_equal(select, join + 1, current->table, current->field, current->index,
+            &(select->tuples[current->from].fields[current->from_field]));
+    }
+
+    return __db_backend_lmdb_select_scan(select, join + 1, current->table);
+}
+
+/**
+ * Find an equal clause on the primary key, or an indexed field, of the table
+ * that every row must match, that is when all top level clauses are joined
+ * by AND.
+ * \return a libdbo_clause_t pointer or NULL if none.
+ */
+static const libdbo_clause_t* __db_backend_lmdb_select_clause(const libdbo_backend_lmdb_select_t* select, size_t* position, const libdbo_backend_lmdb_index_t** index) {
+    const libdbo_backend_lmdb_table_t* table = select->tuples[0].table;
+    const libdbo_clause_t* clause;
+    const libdbo_clause_t* found = NULL;
+    size_t field;
+    int first = 1;
+
+    for (clause = libdbo_clause_list_begin(select->clause_list); clause; clause = libdbo_clause_next(clause)) {
+        if (!first && libdbo_clause_operator(clause) != LIBDBO_CLAUSE_OPERATOR_AND) {
+            return NULL;
+        }
+        first = 0;
+
+        if (clause == select->skip
+            || libdbo_clause_type(clause) != LIBDBO_CLAUSE_EQUAL
+            || (libdbo_clause_table(clause) && strcmp(libdbo_clause_table(clause), table->name))
+            || (field = __db_backend_lmdb_field(table, libdbo_clause_field(clause))) == table->fields_size)
+        {
+            continue;
+        }
+        if (field == table->primary_key) {
+            *position = field;
+            *index = NULL;
+            found = clause;
+        }
+        else if (!found && __db_backend_lmdb_index(table, field)) {
+            *position = field;
+            *index = __db_backend_lmdb_index(table, field);
+            found = clause;
+        }
+    }
+
+    return found;
+}
+
+/**
+ * Select the rows of a table that matches the joins and clauses, `match` is
+ * called for each combination of joined rows that matches. If the clauses
+ * require the primary key or an indexed field to be equal to a value only
+ * those rows are checked, otherwise all rows are.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_lmdb_select(libdbo_backend_lmdb_t* backend_lmdb, MDB_txn* txn, libdbo_backend_lmdb_table_t* table, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list, const libdbo_clause_t* skip, libdbo_backend_lmdb_match_t match, void* context) {
+    libdbo_backend_lmdb_select_t select;
+    const libdbo_join_t* join;
+    const libdbo_clause_t* clause = NULL;
+    const libdbo_backend_lmdb_index_t* index = NULL;
+    libdbo_backend_lmdb_field_t value;
+    size_t position, i, j;
+    int ret = LIBDBO_ERROR_UNKNOWN;
+
+    memset(&select, 0, sizeof(select));
+    select.backend_lmdb = backend_lmdb;
+    select.txn = txn;
+    select.clause_list = clause_list;
+    select.skip = skip;
+    select.match = match;
+    select.context = context;
+
+    if (join_list) {
+        for (join = libdbo_join_list_begin(join_list); join; join = libdbo_join_next(join)) {
+            select.joins_size++;
+        }
+    }
+    if (!(select.tuples = calloc(select.joins_size + 1, sizeof(libdbo_backend_lmdb_tuple_t)))
+        || (select.joins_size && !(select.joins = calloc(select.joins_size, sizeof(libdbo_backend_lmdb_join_t)))))
+    {
+        goto done;
+    }
+    select.tuples[0].table = table;
+
+    /*
+     * Resolve the joins, the tables must already be open since tables can
+     * not be opened while the read transaction is in use.
+     */
+    i = 0;
+    for (join = select.joins_size ? libdbo_join_list_begin(join_list) : NULL; join; join = libdbo_join_next(join), i++) {
+        for (select.joins[i].table = backend_lmdb->table_list; select.joins[i].table; select.joins[i].table = select.joins[i].table->next) {
+            if (!strcmp(select.joins[i].table->name, libdbo_join_to_table(join))) {
+                break;
+            }
+        }
+        for (j = 0; select.joins[i].table && j <= i; j++) {
+            if (!strcmp(select.tuples[j].table->name, libdbo_join_from_table(join))) {
+                break;
+            }
+        }
+        if (!select.joins[i].table
+            || j > i
+            || (select.joins[i].from_field = __db_backend_lmdb_field(select.tuples[j].table, libdbo_join_from_field(join))) == select.tuples[j].table->fields_size
+            || (select.joins[i].field = __db_backend_lmdb_field(select.joins[i].table, libdbo_join_to_field(join))) == select.joins[i].table->fields_size)
+        {
+            libdbo_log(LIBDBO_LOG_ERROR, "LMDB unable to join %s.%s to %s.%s",
+                libdbo_join_from_table(join), libdbo_join_from_field(join),
+                libdbo_join_to_table(join), libdbo_join_to_field(join));
+            goto done;
+        }
+        select.joins[i].from = j;
+        select.joins[i].index = __db_backend_lmdb_index(select.joins[i].table, select.joins[i].field);
+        select.tuples[i + 1].table = select.joins[i].table;
+    }
+    for (i = 0; i <= select.joins_size; i++) {
+        if (!(select.tuples[i].fields = calloc(select.tuples[i].table->fields_size + 1, sizeof(libdbo_backend_lmdb_field_t)))) {
+            goto done;
+        }
+    }
+
+    if (clause_list) {
+        clause = __db_backend_lmdb_select_clause(&select, &position, &index);
+    }
+    if (clause) {
+        if (__db_backend_lmdb_field_from_value(&value, libdbo_clause_value(clause))) {
+            goto done;
+        }
+        ret = __db_backend_lmdb_select_equal(&select, 0, table, position, index, &value);
+    }
+    else {
+        ret = __db_backend_lmdb_select_scan(&select, 0, table);
+    }
+
+done:
+    if (select.tuples) {
+        for (i = 0; i <= select.joins_size; i++) {
+            free(select.tuples[i].fields);
+        }
+    }
+    free(select.tuples);
+    free(select.joins);
+    return ret;
+}
+
+/**
+ * Open the tables of the joins.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_lmdb_join_tables(libdbo_backend_lmdb_t* backend_lmdb, const libdbo_join_list_t* join_list) {
+    const libdbo_join_t* join;
+
+    for (join = join_list ? libdbo_join_list_begin(join_list) : NULL; join; join = libdbo_join_next(join)) {
+        if (!__db_backend_lmdb_table(backend_lmdb, libdbo_join_to_table(join), NULL)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * A list of primary keys of matched rows.
+ */
+typedef struct libdbo_backend_lmdb_ids {
+    libdbo_type_uint64_t* ids;
+    size_t size;
+    size_t allocated;
+} libdbo_backend_lmdb_ids_t;
+
+static int __db_backend_lmdb_match_ids(void* context, const libdbo_backend_lmdb_tuple_t* tuples) {
+    libdbo_backend_lmdb_ids_t* ids = (libdbo_backend_lmdb_ids_t*)context;
+    libdbo_type_uint64_t* new_ids;
+    size_t allocated;
+
+    if (ids->size == ids->allocated) {
+        allocated = ids->allocated ? ids->allocated * 2 : 16;
+        if (!(new_ids = realloc(ids->ids, allocated * sizeof(libdbo_type_uint64_t)))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        ids->ids = new_ids;
+        ids->allocated = allocated;
+    }
+    ids->ids[ids->size++] = tuples[0].key;
+
+    return LIBDBO_OK;
+}
+
+static int __db_backend_lmdb_match_count(void* context, const libdbo_backend_lmdb_tuple_t* tuples) {
+    (void)tuples;
+    (*(size_t*)context)++;
+    return LIBDBO_OK;
+}
+
+/**
+ * The state of a read.
+ */
+typedef struct libdbo_backend_lmdb_read {
+    const libdbo_object_t* object;
+    size_t* fields;
+    size_t fields_size;
+    libdbo_result_list_t* result_list;
+} libdbo_backend_lmdb_read_t;
+
+static int __db_backend_lmdb_match_read(void* context, const libdbo_backend_lmdb_tuple_t* tuples) {
+    libdbo_backend_lmdb_read_t* read = (libdbo_backend_lmdb_read_t*)context;
+    const libdbo_object_field_t* object_field;
+    libdbo_value_set_t* value_set;
+    libdbo_result_t* result = NULL;
+    size_t i;
+
+    if (!(value_set = libdbo_value_set_new(read->fields_size))
+        || !(result = libdbo_result_new())
+        || libdbo_result_set_value_set(result, value_set))
+    {
+        libdbo_value_set_free(value_set);
+        libdbo_result_free(result);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    object_field = libdbo_object_field_list_begin(libdbo_object_object_field_list(read->object));
+    for (i = 0; object_field; i++) {
+        if (__db_backend_lmdb_field_to_value(&(tuples[0].fields[read->fields[i]]), libdbo_value_set_get(value_set, i))
+            || (libdbo_object_field_type(object_field) == LIBDBO_TYPE_PRIMARY_KEY
+                && libdbo_value_set_primary_key(libdbo_value_set_get(value_set, i))))
+        {
+            libdbo_result_free(result);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        object_field = libdbo_object_field_next(object_field);
+    }
+    if (libdbo_result_list_add(read->result_list, result)) {
+        libdbo_result_free(result);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Find the revision field of an object.
+ * \return LIBDBO_ERROR_* if the object has more then one revision field,
+ * otherwise LIBDBO_OK.
+ */
+static int __db_backend_lmdb_revision_field(const libdbo_object_t* object, const libdbo_object_field_t** revision_field) {
+    const libdbo_object_field_t* object_field;
+
+    *revision_field = NULL;
+    object_field = libdbo_object_field_list_begin(libdbo_object_object_field_list(object));
+    while (object_field) {
+        if (libdbo_object_field_type(object_field) == LIBDBO_TYPE_REVISION) {
+            if (*revision_field) {
+                /*
+                 * We do not support multiple revision fields.
+                 */
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+
+            *revision_field = object_field;
+        }
+        object_field = libdbo_object_field_next(object_field);
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Find the clause on the revision field and get the revision from it.
+ * \return a libdbo_clause_t pointer or NULL if not found or if the revision
+ * is not a positive integer.
+ */
+static const libdbo_clause_t* __db_backend_lmdb_revision_clause(const libdbo_clause_list_t* clause_list, const libdbo_object_field_t* revision_field, libdbo_type_uint64_t* revision_number) {
+    const libdbo_clause_t* clause;
+    libdbo_backend_lmdb_field_t field;
+
+    for (clause = libdbo_clause_list_begin(clause_list); clause; clause = libdbo_clause_next(clause)) {
+        if (!strcmp(libdbo_clause_field(clause), libdbo_object_field_name(revision_field))) {
+            if (__db_backend_lmdb_field_from_value(&field, libdbo_clause_value(clause))
+                || __db_backend_lmdb_field_id(&field, revision_number))
+            {
+                return NULL;
+            }
+            return clause;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Set the fields of a row from the fields and values given.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_lmdb_fields_set(const libdbo_backend_lmdb_table_t* table, libdbo_backend_lmdb_field_t* fields, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set) {
+    const libdbo_object_field_t* object_field;
+    size_t i, field;
+
+    if (libdbo_object_field_list_size(object_field_list) != libdbo_value_set_size(value_set)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    object_field = libdbo_object_field_list_begin(object_field_list);
+    for (i = 0; object_field; i++) {
+        if ((field = __db_backend_lmdb_field(table, libdbo_object_field_name(object_field))) == table->fields_size) {
+            libdbo_log(LIBDBO_LOG_ERROR, "LMDB field %s not found in table %s",
+                libdbo_object_field_name(object_field), table->name);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        if (field != table->revision
+            && __db_backend_lmdb_field_from_value(&fields[field], libdbo_value_set_at(value_set, i)))
+        {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        object_field = libdbo_object_field_next(object_field);
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Insert a new row with the fields and values given, the primary key is set
+ * to the next id of the table unless given and the revision to 1.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_lmdb_insert(libdbo_backend_lmdb_t* backend_lmdb, MDB_txn* txn, libdbo_backend_lmdb_table_t* table, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set) {
+    libdbo_backend_lmdb_field_t* fields;
+    libdbo_type_uint64_t id, next_id = 1;
+    unsigned char id_key[8];
+    char* meta_key;
+    MDB_val key, data;
+    int ret;
+
+    if (table->primary_key == LIBDBO_BACKEND_LMDB_NONE) {
+        libdbo_log(LIBDBO_LOG_ERROR, "LMDB table %s has no primary key", table->name);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!(fields = calloc(table->fields_size, sizeof(libdbo_backend_lmdb_field_t)))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (__db_backend_lmdb_fields_set(table, fields, object_field_list, value_set)
+        || !(meta_key = __db_backend_lmdb_meta_key("id:", table->name)))
+    {
+        free(fields);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    key.mv_size = strlen(meta_key);
+    key.mv_data = meta_key;
+    if (!(ret = mdb_get(txn, backend_lmdb->env->meta, &key, &data)) && data.mv_size == 8) {
+        next_id = __db_backend_lmdb_key_id(data.mv_data);
+    }
+    else if (ret && ret != MDB_NOTFOUND) {
+        __db_backend_lmdb_error("meta get", ret);
+        free(meta_key);
+        free(fields);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (fields[table->primary_key].type == LIBDBO_TYPE_EMPTY) {
+        id = next_id;
+    }
+    else if (__db_backend_lmdb_field_id(&fields[table->primary_key], &id)) {
+        free(meta_key);
+        free(fields);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    __db_backend_lmdb_field_integer(&fields[table->primary_key], LIBDBO_TYPE_UINT64, 0, id);
+    if (table->revision != LIBDBO_BACKEND_LMDB_NONE) {
+        __db_backend_lmdb_field_integer(&fields[table->revision], LIBDBO_TYPE_INT64, 0, 1);
+    }
+
+    /*
+     * Keep the next id after any primary key given.
+     */
+    if (id >= next_id) {
+        __db_backend_lmdb_key(id + 1, id_key);
+        key.mv_size = strlen(meta_key);
+        key.mv_data = meta_key;
+        data.mv_size = sizeof(id_key);
+        data.mv_data = id_key;
+        if ((ret = mdb_put(txn, backend_lmdb->env->meta, &key, &data, 0))) {
+            __db_backend_lmdb_error("meta put", ret);
+            free(meta_key);
+            free(fields);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+    free(meta_key);
+
+    if (__db_backend_lmdb_index_put(backend_lmdb, txn, table, fields, id)
+        || __db_backend_lmdb_encode(&(backend_lmdb->row), fields, table->fields_size))
+    {
+        free(fields);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    free(fields);
+
+    __db_backend_lmdb_key(id, id_key);
+    key.mv_size = sizeof(id_key);
+    key.mv_data = id_key;
+    data.mv_size = backend_lmdb->row.size;
+    data.mv_data = backend_lmdb->row.data;
+    if ((ret = mdb_put(txn, table->dbi, &key, &data, MDB_NOOVERWRITE))) {
+        if (ret != MDB_KEYEXIST) {
+            __db_backend_lmdb_error("put", ret);
+        }
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Update a row with the fields and values given, the revision is set to
+ * `revision_number` if the table has a revision field.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_lmdb_update_row(libdbo_backend_lmdb_t* backend_lmdb, MDB_txn* txn, libdbo_backend_lmdb_table_t* table, libdbo_type_uint64_t id, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, libdbo_type_uint64_t revision_number) {
+    libdbo_backend_lmdb_field_t* fields;
+    libdbo_backend_lmdb_field_t* old_fields;
+    const libdbo_backend_lmdb_index_t* index;
+    unsigned char id_key[8];
+    libdbo_type_uint64_t new_id;
+    MDB_val key, data, old_key, new_key;
+    int ret, cmp;
+
+    if (!(fields = calloc(table->fields_size * 2, sizeof(libdbo_backend_lmdb_field_t)))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    old_fields = &fields[table->fields_size];
+
+    __db_backend_lmdb_key(id, id_key);
+    key.mv_size = sizeof(id_key);
+    key.mv_data = id_key;
+    if ((ret = mdb_get(txn, table->dbi, &key, &data))) {
+        __db_backend_lmdb_error("get", ret);
+        free(fields);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (__db_backend_lmdb_decode(&data, old_fields, table->fields_size)) {
+        free(fields);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    memcpy(fields, old_fields, table->fields_size * sizeof(libdbo_backend_lmdb_field_t));
+    if (__db_backend_lmdb_fields_set(table, fields, object_field_list, value_set)) {
+        free(fields);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (__db_backend_lmdb_field_id(&fields[table->primary_key], &new_id) || new_id != id) {
+        /*
+         * Changing the primary key is not supported, it is the key of the row.
+         */
+        libdbo_log(LIBDBO_LOG_ERROR, "LMDB can not change the primary key of a row in table %s", table->name);
+        free(fields);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (table->revision != LIBDBO_BACKEND_LMDB_NONE) {
+        __db_backend_lmdb_field_integer(&fields[table->revision], LIBDBO_TYPE_INT64, 0, revision_number);
+    }
+
+    /*
+     * Encode the row before any change since the old fields points into the
+     * stored row.
+     */
+    if (__db_backend_lmdb_encode(&(backend_lmdb->row), fields, table->fields_size)) {
+        free(fields);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    for (index = table->index_list; index; index = index->next) {
+        if (fields[index->field].type == old_fields[index->field].type
+            && (fields[index->field].type == LIBDBO_TYPE_EMPTY
+                || (!__db_backend_lmdb_compare(&fields[index->field], &old_fields[index->field], &cmp) && !cmp)))
+        {
+            continue;
+        }
+        if (__db_backend_lmdb_index_del(&(backend_lmdb->key2), txn, index, &old_fields[index->field], id)) {
+            free(fields);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        if (fields[index->field].type == LIBDBO_TYPE_EMPTY) {
+            continue;
+        }
+        if (__db_backend_lmdb_index_key(&(backend_lmdb->key), &fields[index->field], &new_key)) {
+            free(fields);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        old_key.mv_size = sizeof(id_key);
+        old_key.mv_data = id_key;
+        ret = mdb_put(txn, index->dbi, &new_key, &old_key, index->unique ? MDB_NOOVERWRITE : MDB_NODUPDATA);
+        if (ret && (index->unique || ret != MDB_KEYEXIST)) {
+            if (ret != MDB_KEYEXIST) {
+                __db_backend_lmdb_error("index put", ret);
+            }
+            free(fields);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+    free(fields);
+
+    key.mv_size = sizeof(id_key);
+    key.mv_data = id_key;
+    data.mv_size = backend_lmdb->row.size;
+    data.mv_data = backend_lmdb->row.data;
+    if ((ret = mdb_put(txn, table->dbi, &key, &data, 0))) {
+        __db_backend_lmdb_error("put", ret);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Delete a row and its index entries.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_lmdb_delete_row(libdbo_backend_lmdb_t* backend_lmdb, MDB_txn* txn, libdbo_backend_lmdb_table_t* table, libdbo_type_uint64_t id) {
+    libdbo_backend_lmdb_field_t* fields;
+    const libdbo_backend_lmdb_index_t* index;
+    unsigned char id_key[8];
+    MDB_val key, data;
+    int ret;
+
+    __db_backend_lmdb_key(id, id_key);
+    key.mv_size = sizeof(id_key);
+    key.mv_data = id_key;
+
+    if (table->index_list) {
+        if (!(fields = calloc(table->fields_size, sizeof(libdbo_backend_lmdb_field_t)))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        if ((ret = mdb_get(txn, table->dbi, &key, &data))
+            || __db_backend_lmdb_decode(&data, fields, table->fields_size))
+        {
+            free(fields);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        for (index = table->index_list; index; index = index->next) {
+            if (__db_backend_lmdb_index_del(&(backend_lmdb->key), txn, index, &fields[index->field], id)) {
+                free(fields);
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+        }
+        free(fields);
+    }
+
+    key.mv_size = sizeof(id_key);
+    key.mv_data = id_key;
+    if ((ret = mdb_del(txn, table->dbi, &key, NULL))) {
+        __db_backend_lmdb_error("del", ret);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Check if the fields and values given sets any uniquely indexed field,
+ * doing so for more then one row would make them conflict with each other.
+ * \return non-zero if a unique field is set.
+ */
+static int __db_backend_lmdb_unique_set(const libdbo_backend_lmdb_table_t* table, const libdbo_object_field_list_t* object_field_list) {
+    const libdbo_object_field_t* object_field;
+    const libdbo_backend_lmdb_index_t* index;
+    size_t field;
+
+    object_field = libdbo_object_field_list_begin(object_field_list);
+    while (object_field) {
+        if ((field = __db_backend_lmdb_field(table, libdbo_object_field_name(object_field))) != table->fields_size
+            && (index = __db_backend_lmdb_index(table, field))
+            && index->unique)
+        {
+            return 1;
+        }
+        object_field = libdbo_object_field_next(object_field);
+    }
+
+    return 0;
+}
+
+static int libdbo_backend_lmdb_initialize(void* data) {
+    libdbo_backend_lmdb_t* backend_lmdb = (libdbo_backend_lmdb_t*)data;
+
+    if (!backend_lmdb) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    __lmdb_initialized = 1;
+    return LIBDBO_OK;
+}
+
+static int libdbo_backend_lmdb_shutdown(void* data) {
+    libdbo_backend_lmdb_t* backend_lmdb = (libdbo_backend_lmdb_t*)data;
+
+    if (!backend_lmdb) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    __lmdb_initialized = 0;
+    return LIBDBO_OK;
+}
+
+/**
+ * Release an environment, it is closed when the last connection is done
+ * with it.
+ */
+static void __db_backend_lmdb_env_release(libdbo_backend_lmdb_env_t* env) {
+    libdbo_backend_lmdb_env_t** list;
+
+    pthread_mutex_lock(&__lmdb_mutex);
+    if (!--env->references) {
+        for (list = &__lmdb_env_list; *list; list = &((*list)->next)) {
+            if (*list == env) {
+                *list = env->next;
+                break;
+            }
+        }
+        mdb_env_close(env->env);
+        free(env->file);
+        libdbo_mm_delete(&__lmdb_env_alloc, env);
+    }
+    pthread_mutex_unlock(&__lmdb_mutex);
+}
+
+/**
+ * Get the environment of a file, it is opened if no other connection has it
+ * open.
+ * \return a libdbo_backend_lmdb_env_t pointer or NULL on error.
+ */
+static libdbo_backend_lmdb_env_t* __db_backend_lmdb_env_get(const char* file, size_t mapsize) {
+    libdbo_backend_lmdb_env_t* env;
+    MDB_txn* txn;
+    int ret;
+
+    if (pthread_mutex_lock(&__lmdb_mutex)) {
+        return NULL;
+    }
+
+    for (env = __lmdb_env_list; env; env = env->next) {
+        if (!strcmp(env->file, file)) {
+            env->references++;
+            pthread_mutex_unlock(&__lmdb_mutex);
+            return env;
+        }
+    }
+
+    if (!(env = libdbo_mm_new0(&__lmdb_env_alloc))
+        || !(env->file = strdup(file)))
+    {
+        if (env) {
+            libdbo_mm_delete(&__lmdb_env_alloc, env);
+        }
+        pthread_mutex_unlock(&__lmdb_mutex);
+        return NULL;
+    }
+
+    if ((ret = mdb_env_create(&(env->env)))
+        || (ret = mdb_env_set_maxdbs(env->env, LIBDBO_BACKEND_LMDB_MAXDBS))
+        || (ret = mdb_env_set_mapsize(env->env, mapsize * 1024 * 1024))
+        || (ret = mdb_env_open(env->env, file, MDB_NOSUBDIR | MDB_NOTLS, 0644))
+        || (ret = mdb_txn_begin(env->env, NULL, 0, &txn)))
+    {
+        libdbo_log(LIBDBO_LOG_ERROR, "LMDB open %s: %s", file, mdb_strerror(ret));
+        if (env->env) {
+            mdb_env_close(env->env);
+        }
+        free(env->file);
+        libdbo_mm_delete(&__lmdb_env_alloc, env);
+        pthread_mutex_unlock(&__lmdb_mutex);
+        return NULL;
+    }
+    if ((ret = mdb_dbi_open(txn, LIBDBO_BACKEND_LMDB_META, MDB_CREATE, &(env->meta)))
+        || (ret = mdb_txn_commit(txn)))
+    {
+        libdbo_log(LIBDBO_LOG_ERROR, "LMDB open %s: %s", file, mdb_strerror(ret));
+        if (ret) {
+            mdb_txn_abort(txn);
+        }
+        mdb_env_close(env->env);
+        free(env->file);
+        libdbo_mm_delete(&__lmdb_env_alloc, env);
+        pthread_mutex_unlock(&__lmdb_mutex);
+        return NULL;
+    }
+
+    env->references = 1;
+    env->next = __lmdb_env_list;
+    __lmdb_env_list = env;
+    pthread_mutex_unlock(&__lmdb_mutex);
+    return env;
+}
+
+static int libdbo_backend_lmdb_connect(void* data, const libdbo_configuration_list_t* configuration_list) {
+    libdbo_backend_lmdb_t* backend_lmdb = (libdbo_backend_lmdb_t*)data;
+    const libdbo_configuration_t* file;
+    const libdbo_configuration_t* mapsize;
+    const libdbo_configuration_t* unique;
+    const libdbo_configuration_t* index;
+    long size = LIBDBO_BACKEND_LMDB_DEFAULT_MAPSIZE;
+
+    if (!__lmdb_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_lmdb) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (backend_lmdb->env) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!configuration_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (!(file = libdbo_configuration_list_find(configuration_list, "file"))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if ((mapsize = libdbo_configuration_list_find(configuration_list, "mapsize"))) {
+        size = atol(libdbo_configuration_value(mapsize));
+        if (size < 1) {
+            size = LIBDBO_BACKEND_LMDB_DEFAULT_MAPSIZE;
+        }
+    }
+
+    free(backend_lmdb->unique);
+    backend_lmdb->unique = NULL;
+    free(backend_lmdb->index);
+    backend_lmdb->index = NULL;
+    if (((unique = libdbo_configuration_list_find(configuration_list, "unique"))
+            && !(backend_lmdb->unique = strdup(libdbo_configuration_value(unique))))
+        || ((index = libdbo_configuration_list_find(configuration_list, "index"))
+            && !(backend_lmdb->index = strdup(libdbo_configuration_value(index)))))
+    {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (!(backend_lmdb->env = __db_backend_lmdb_env_get(libdbo_configuration_value(file), (size_t)size))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    return LIBDBO_OK;
+}
+
+static int libdbo_backend_lmdb_disconnect(void* data) {
+    libdbo_backend_lmdb_t* backend_lmdb = (libdbo_backend_lmdb_t*)data;
+
+    if (!__lmdb_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_lmdb) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_lmdb->env) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    while (backend_lmdb->transaction) {
+        libdbo_backend_lmdb_transaction_rollback(backend_lmdb);
+    }
+    if (backend_lmdb->read_txn) {
+        mdb_txn_abort(backend_lmdb->read_txn);
+        backend_lmdb->read_txn = NULL;
+    }
+    __db_backend_lmdb_table_forget(backend_lmdb, -1);
+    __db_backend_lmdb_env_release(backend_lmdb->env);
+    backend_lmdb->env = NULL;
+
+    return LIBDBO_OK;
+}
+
+static int libdbo_backend_lmdb_create(void* data, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set) {
+    libdbo_backend_lmdb_t* backend_lmdb = (libdbo_backend_lmdb_t*)data;
+    libdbo_backend_lmdb_table_t* table;
+    const libdbo_object_field_t* revision_field;
+    MDB_txn* txn;
+
+    if (!__lmdb_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_lmdb) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_lmdb->env) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object_field_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!value_set) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (__db_backend_lmdb_revision_field(object, &revision_field)
+        || !(table = __db_backend_lmdb_table(backend_lmdb, libdbo_object_table(object), object))
+        || __db_backend_lmdb_begin(backend_lmdb, &txn))
+    {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (__db_backend_lmdb_insert(backend_lmdb, txn, table, object_field_list, value_set)) {
+        mdb_txn_abort(txn);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    return __db_backend_lmdb_commit(txn);
+}
+
+static libdbo_result_list_t* libdbo_backend_lmdb_read(void* data, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list) {
+    libdbo_backend_lmdb_t* backend_lmdb = (libdbo_backend_lmdb_t*)data;
+    libdbo_backend_lmdb_table_t* table;
+    libdbo_backend_lmdb_read_t read;
+    const libdbo_object_field_t* object_field;
+    MDB_txn* txn;
+    size_t i;
+    int ret;
+
+    if (!__lmdb_initialized) {
+        return NULL;
+    }
+    if (!backend_lmdb) {
+        return NULL;
+    }
+    if (!backend_lmdb->env) {
+        return NULL;
+    }
+    if (!object) {
+        return NULL;
+    }
+
+    if (!(table = __db_backend_lmdb_table(backend_lmdb, libdbo_object_table(object), object))
+        || __db_backend_lmdb_join_tables(backend_lmdb, join_list))
+    {
+        return NULL;
+    }
+
+    /*
+     * Map the fields of the object to the fields of the table.
+     */
+    memset(&read, 0, sizeof(read));
+    read.object = object;
+    read.fields_size = libdbo_object_field_list_size(libdbo_object_object_field_list(object));
+    if (!(read.fields = calloc(read.fields_size + 1, sizeof(size_t)))) {
+        return NULL;
+    }
+    object_field = libdbo_object_field_list_begin(libdbo_object_object_field_list(object));
+    for (i = 0; object_field; i++) {
+        read.fields[i] = __db_backend_lmdb_field(table, libdbo_object_field_name(object_field));
+        object_field = libdbo_object_field_next(object_field);
+    }
+
+    if (!(read.result_list = libdbo_result_list_new())
+        || __db_backend_lmdb_read_begin(backend_lmdb, &txn))
+    {
+        libdbo_result_list_free(read.result_list);
+        free(read.fields);
+        return NULL;
+    }
+    ret = __db_backend_lmdb_select(backend_lmdb, txn, table, join_list, clause_list, NULL, __db_backend_lmdb_match_read, &read);
+    __db_backend_lmdb_read_end(backend_lmdb, txn);
+    free(read.fields);
+    if (ret) {
+        libdbo_result_list_free(read.result_list);
+        return NULL;
+    }
+
+    return read.result_list;
+}
+
+static int libdbo_backend_lmdb_update(void* data, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, const libdbo_clause_list_t* clause_list) {
+    libdbo_backend_lmdb_t* backend_lmdb = (libdbo_backend_lmdb_t*)data;
+    libdbo_backend_lmdb_table_t* table;
+    libdbo_backend_lmdb_ids_t ids = { NULL, 0, 0 };
+    const libdbo_object_field_t* revision_field;
+    libdbo_type_uint64_t revision_number = 0;
+    MDB_txn* txn;
+    size_t i;
+
+    if (!__lmdb_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_lmdb) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_lmdb->env) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object_field_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!value_set) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * Check if the object has a revision field and keep it for later use.
+     */
+    if (__db_backend_lmdb_revision_field(object, &revision_field)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (revision_field) {
+        /*
+         * If we have a revision field we should also have it in the clause,
+         * find it and get the value for later use or return error if not found.
+         */
+        if (!__db_backend_lmdb_revision_clause(clause_list, revision_field, &revision_number)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        revision_number++;
+    }
+
+    if (!(table = __db_backend_lmdb_table(backend_lmdb, libdbo_object_table(object), object))
+        || __db_backend_lmdb_begin(backend_lmdb, &txn))
+    {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (__db_backend_lmdb_select(backend_lmdb, txn, table, NULL, clause_list, NULL, __db_backend_lmdb_match_ids, &ids)) {
+        mdb_txn_abort(txn);
+        free(ids.ids);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * If we are using revision we have to have a positive number of changes
+     * otherwise its a failure.
+     */
+    if (revision_field && !ids.size) {
+        mdb_txn_abort(txn);
+        free(ids.ids);
+        return LIBDBO_ERROR_REVISION;
+    }
+    if (ids.size > 1 && __db_backend_lmdb_unique_set(table, object_field_list)) {
+        mdb_txn_abort(txn);
+        free(ids.ids);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    for (i = 0; i < ids.size; i++) {
+        if (__db_backend_lmdb_update_row(backend_lmdb, txn, table, ids.ids[i], object_field_list, value_set, revision_number)) {
+            mdb_txn_abort(txn);
+            free(ids.ids);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+    free(ids.ids);
+
+    return __db_backend_lmdb_commit(txn);
+}
+
+static int libdbo_backend_lmdb_delete(void* data, const libdbo_object_t* object, const libdbo_clause_list_t* clause_list) {
+    libdbo_backend_lmdb_t* backend_lmdb = (libdbo_backend_lmdb_t*)data;
+    libdbo_backend_lmdb_table_t* table;
+    libdbo_backend_lmdb_ids_t ids = { NULL, 0, 0 };
+    const libdbo_object_field_t* revision_field;
+    libdbo_type_uint64_t revision_number;
+    MDB_txn* txn;
+    size_t i;
+
+    if (!__lmdb_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_lmdb) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_lmdb->env) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * Check if the object has a revision field and keep it for later use.
+     */
+    if (__db_backend_lmdb_revision_field(object, &revision_field)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (revision_field) {
+        /*
+         * If we have a revision field we should also have it in the clause,
+         * find it or return error if not found.
+         */
+        if (!__db_backend_lmdb_revision_clause(clause_list, revision_field, &revision_number)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+
+    if (!(table = __db_backend_lmdb_table(backend_lmdb, libdbo_object_table(object), object))
+        || __db_backend_lmdb_begin(backend_lmdb, &txn))
+    {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (__db_backend_lmdb_select(backend_lmdb, txn, table, NULL, clause_list, NULL, __db_backend_lmdb_match_ids, &ids)) {
+        mdb_txn_abort(txn);
+        free(ids.ids);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * If we are using revision we have to have a positive number of changes
+     * otherwise its a failure.
+     */
+    if (revision_field && !ids.size) {
+        mdb_txn_abort(txn);
+        free(ids.ids);
+        return LIBDBO_ERROR_REVISION;
+    }
+
+    for (i = 0; i < ids.size; i++) {
+        if (__db_backend_lmdb_delete_row(backend_lmdb, txn, table, ids.ids[i])) {
+            mdb_txn_abort(txn);
+            free(ids.ids);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+    free(ids.ids);
+
+    return __db_backend_lmdb_commit(txn);
+}
+
+static int libdbo_backend_lmdb_count(void* data, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list, size_t* count) {
+    libdbo_backend_lmdb_t* backend_lmdb = (libdbo_backend_lmdb_t*)data;
+    libdbo_backend_lmdb_table_t* table;
+    MDB_txn* txn;
+    int ret;
+
+    if (!__lmdb_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_lmdb) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_lmdb->env) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!count) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (!(table = __db_backend_lmdb_table(backend_lmdb, libdbo_object_table(object), object))
+        || __db_backend_lmdb_join_tables(backend_lmdb, join_list)
+        || __db_backend_lmdb_read_begin(backend_lmdb, &txn))
+    {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    *count = 0;
+    ret = __db_backend_lmdb_select(backend_lmdb, txn, table, join_list, clause_list, NULL, __db_backend_lmdb_match_count, count);
+    __db_backend_lmdb_read_end(backend_lmdb, txn);
+
+    return ret;
+}
+
+static int libdbo_backend_lmdb_upsert(void* data, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, const libdbo_clause_list_t* clause_list) {
+    libdbo_backend_lmdb_t* backend_lmdb = (libdbo_backend_lmdb_t*)data;
+    libdbo_backend_lmdb_table_t* table;
+    libdbo_backend_lmdb_ids_t ids = { NULL, 0, 0 };
+    libdbo_backend_lmdb_field_t* fields;
+    libdbo_backend_lmdb_field_t revision;
+    const libdbo_object_field_t* revision_field;
+    const libdbo_clause_t* clause;
+    const libdbo_clause_t* revision_clause = NULL;
+    libdbo_type_uint64_t revision_number = 0;
+    unsigned char id_key[8];
+    MDB_txn* txn;
+    MDB_val key, row;
+    int ret, cmp;
+
+    if (!__lmdb_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_lmdb) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_lmdb->env) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object_field_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!value_set) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!clause_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!libdbo_object_field_list_begin(object_field_list)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * The clauses can only be equal clauses on the unique fields and the
+     * revision field, the revision clause is optional and if given the update
+     * will only be done if the object is still on that revision.
+     */
+    if (__db_backend_lmdb_revision_field(object, &revision_field)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    clause = libdbo_clause_list_begin(clause_list);
+    if (!clause) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    while (clause) {
+        if (libdbo_clause_type(clause) != LIBDBO_CLAUSE_EQUAL
+            || libdbo_clause_operator(clause) != LIBDBO_CLAUSE_OPERATOR_AND)
+        {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        if (revision_field
+            && !strcmp(libdbo_clause_field(clause), libdbo_object_field_name(revision_field)))
+        {
+            if (revision_clause) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            revision_clause = clause;
+        }
+        clause = libdbo_clause_next(clause);
+    }
+
+    if (!(table = __db_backend_lmdb_table(backend_lmdb, libdbo_object_table(object), object))
+        || __db_backend_lmdb_begin(backend_lmdb, &txn))
+    {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (__db_backend_lmdb_select(backend_lmdb, txn, table, NULL, clause_list, revision_clause, __db_backend_lmdb_match_ids, &ids)) {
+        mdb_txn_abort(txn);
+        free(ids.ids);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (!ids.size) {
+        free(ids.ids);
+        if (__db_backend_lmdb_insert(backend_lmdb, txn, table, object_field_list, value_set)) {
+            mdb_txn_abort(txn);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        return __db_backend_lmdb_commit(txn);
+    }
+    if (ids.size > 1) {
+        /*
+         * The clauses does not identify a single object.
+         */
+        mdb_txn_abort(txn);
+        free(ids.ids);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * If the update was restricted to a revision the object must still be on
+     * that revision otherwise it was changed by someone else.
+     */
+    if (table->revision != LIBDBO_BACKEND_LMDB_NONE) {
+        if (!(fields = calloc(table->fields_size, sizeof(libdbo_backend_lmdb_field_t)))) {
+            mdb_txn_abort(txn);
+            free(ids.ids);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        __db_backend_lmdb_key(ids.ids[0], id_key);
+        key.mv_size = sizeof(id_key);
+        key.mv_data = id_key;
+        if ((ret = mdb_get(txn, table->dbi, &key, &row))
+            || __db_backend_lmdb_decode(&row, fields, table->fields_size)
+            || __db_backend_lmdb_field_id(&fields[table->revision], &revision_number)
+            || (revision_clause
+                && (__db_backend_lmdb_field_from_value(&revision, libdbo_clause_value(revision_clause))
+                    || __db_backend_lmdb_compare(&fields[table->revision], &revision, &cmp))))
+        {
+            free(fields);
+            mdb_txn_abort(txn);
+            free(ids.ids);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        if (revision_clause && cmp) {
+            free(fields);
+            mdb_txn_abort(txn);
+            free(ids.ids);
+            return LIBDBO_ERROR_REVISION;
+        }
+        free(fields);
+        revision_number++;
+    }
+
+    if (__db_backend_lmdb_update_row(backend_lmdb, txn, table, ids.ids[0], object_field_list, value_set, revision_number)) {
+        mdb_txn_abort(txn);
+        free(ids.ids);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    free(ids.ids);
+
+    return __db_backend_lmdb_commit(txn);
+}
+
+static void libdbo_backend_lmdb_free(void* data) {
+    libdbo_backend_lmdb_t* backend_lmdb = (libdbo_backend_lmdb_t*)data;
+
+    if (backend_lmdb) {
+        if (backend_lmdb->env) {
+            (void)libdbo_backend_lmdb_disconnect(backend_lmdb);
+        }
+        free(backend_lmdb->txns);
+        free(backend_lmdb->unique);
+        free(backend_lmdb->index);
+        free(backend_lmdb->row.data);
+        free(backend_lmdb->key.data);
+        free(backend_lmdb->key2.data);
+        libdbo_mm_delete(&__lmdb_alloc, backend_lmdb);
+    }
+}
+
+static int libdbo_backend_lmdb_transaction_begin(void* data) {
+    libdbo_backend_lmdb_t* backend_lmdb = (libdbo_backend_lmdb_t*)data;
+    MDB_txn** txns;
+    size_t allocated;
+
+    if (!__lmdb_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_lmdb) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_lmdb->env) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if ((size_t)backend_lmdb->transaction == backend_lmdb->txns_allocated) {
+        allocated = backend_lmdb->txns_allocated ? backend_lmdb->txns_allocated * 2 : 8;
+        if (!(txns = realloc(backend_lmdb->txns, allocated * sizeof(MDB_txn*)))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        backend_lmdb->txns = txns;
+        backend_lmdb->txns_allocated = allocated;
+    }
+
+    if (__db_backend_lmdb_begin(backend_lmdb, &(backend_lmdb->txns[backend_lmdb->transaction]))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    backend_lmdb->transaction++;
+
+    return LIBDBO_OK;
+}
+
+static int libdbo_backend_lmdb_transaction_commit(void* data) {
+    libdbo_backend_lmdb_t* backend_lmdb = (libdbo_backend_lmdb_t*)data;
+    libdbo_backend_lmdb_table_t* table;
+    int depth;
+
+    if (!__lmdb_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_lmdb) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_lmdb->transaction) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    depth = backend_lmdb->transaction--;
+    if (__db_backend_lmdb_commit(backend_lmdb->txns[backend_lmdb->transaction])) {
+        __db_backend_lmdb_table_forget(backend_lmdb, backend_lmdb->transaction);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * Tables opened in the committed transaction now belong to the parent.
+     */
+    for (table = backend_lmdb->table_list; table; table = table->next) {
+        if (table->depth == depth) {
+            table->depth = backend_lmdb->transaction;
+        }
+    }
+
+    return LIBDBO_OK;
+}
+
+static int libdbo_backend_lmdb_transaction_rollback(void* data) {
+    libdbo_backend_lmdb_t* backend_lmdb = (libdbo_backend_lmdb_t*)data;
+
+    if (!__lmdb_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_lmdb) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_lmdb->transaction) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    backend_lmdb->transaction--;
+    mdb_txn_abort(backend_lmdb->txns[backend_lmdb->transaction]);
+    __db_backend_lmdb_table_forget(backend_lmdb, backend_lmdb->transaction);
+
+    return LIBDBO_OK;
+}
+
+libdbo_backend_handle_t* libdbo_backend_lmdb_new_handle(void) {
+    libdbo_backend_handle_t* backend_handle = NULL;
+    libdbo_backend_lmdb_t* backend_lmdb =
+        (libdbo_backend_lmdb_t*)libdbo_mm_new0(&__lmdb_alloc);
+
+    if (backend_lmdb && (backend_handle = libdbo_backend_handle_new())) {
+        if (libdbo_backend_handle_set_data(backend_handle, (void*)backend_lmdb)
+            || libdbo_backend_handle_set_initialize(backend_handle, libdbo_backend_lmdb_initialize)
+            || libdbo_backend_handle_set_shutdown(backend_handle, libdbo_backend_lmdb_shutdown)
+            || libdbo_backend_handle_set_connect(backend_handle, libdbo_backend_lmdb_connect)
+            || libdbo_backend_handle_set_disconnect(backend_handle, libdbo_backend_lmdb_disconnect)
+            || libdbo_backend_handle_set_create(backend_handle, libdbo_backend_lmdb_create)
+            || libdbo_backend_handle_set_read(backend_handle, libdbo_backend_lmdb_read)
+            || libdbo_backend_handle_set_update(backend_handle, libdbo_backend_lmdb_update)
+            || libdbo_backend_handle_set_delete(backend_handle, libdbo_backend_lmdb_delete)
+            || libdbo_backend_handle_set_count(backend_handle, libdbo_backend_lmdb_count)
+            || libdbo_backend_handle_set_upsert(backend_handle, libdbo_backend_lmdb_upsert)
+            || libdbo_backend_handle_set_free(backend_handle, libdbo_backend_lmdb_free)
+            || libdbo_backend_handle_set_transaction_begin(backend_handle, libdbo_backend_lmdb_transaction_begin)
+            || libdbo_backend_handle_set_transaction_commit(backend_handle, libdbo_backend_lmdb_transaction_commit)
+            || libdbo_backend_handle_set_transaction_rollback(backend_handle, libdbo_backend_lmdb_transaction_rollback))
+        {
+            libdbo_backend_handle_free(backend_handle);
+            libdbo_mm_delete(&__lmdb_alloc, backend_lmdb);
+            return NULL;
+        }
+    }
+    return backend_handle;
+}
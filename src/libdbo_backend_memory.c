@@ -0,0 +1,2197 @@
+/*
+ * Copyright (c) 2014 Jerry Lundström <lundstrom.jerry@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "libdbo/backend/memory.h"
+
+#include "libdbo/error.h"
+#include "libdbo/mm.h"
+#include "libdbo/log.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Keep track of if we have initialized the memory backend.
+ */
+static int __memory_initialized = 0;
+
+/**
+ * A row in a table, the value set has one value for each field in the table.
+ */
+typedef struct libdbo_backend_memory_row {
+    libdbo_value_set_t* value_set;
+    /** The position of the row in the table. */
+    size_t position;
+} libdbo_backend_memory_row_t;
+
+static libdbo_mm_t __memory_row_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_backend_memory_row_t));
+
+/**
+ * An entry in a hash index bucket.
+ */
+typedef struct libdbo_backend_memory_entry libdbo_backend_memory_entry_t;
+struct libdbo_backend_memory_entry {
+    libdbo_backend_memory_entry_t* next;
+    libdbo_type_uint64_t hash;
+    libdbo_backend_memory_row_t* row;
+};
+
+static libdbo_mm_t __memory_entry_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_backend_memory_entry_t));
+
+/**
+ * A unique hash index on one field of a table. Rows with an empty value for
+ * the field are not indexed.
+ */
+typedef struct libdbo_backend_memory_index libdbo_backend_memory_index_t;
+struct libdbo_backend_memory_index {
+    libdbo_backend_memory_index_t* next;
+    size_t field;
+    libdbo_backend_memory_entry_t** buckets;
+    size_t buckets_size;
+    size_t size;
+};
+
+static libdbo_mm_t __memory_index_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_backend_memory_index_t));
+
+/**
+ * A table, the fields are taken from the first object that uses the table.
+ * Deleted rows leave a NULL in `rows` until the table is compacted.
+ */
+typedef struct libdbo_backend_memory_table libdbo_backend_memory_table_t;
+struct libdbo_backend_memory_table {
+    libdbo_backend_memory_table_t* next;
+    char* name;
+    char** fields;
+    size_t fields_size;
+    /** The primary key field, `fields_size` if none. */
+    size_t primary_key;
+    /** The revision field, `fields_size` if none. */
+    size_t revision;
+    libdbo_backend_memory_row_t** rows;
+    size_t rows_size;
+    size_t rows_allocated;
+    size_t rows_deleted;
+    libdbo_type_int64_t next_id;
+    libdbo_backend_memory_index_t* index_list;
+};
+
+static libdbo_mm_t __memory_table_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_backend_memory_table_t));
+
+/**
+ * The types of changes that are recorded in the undo log.
+ */
+#define LIBDBO_BACKEND_MEMORY_UNDO_CREATE 1
+#define LIBDBO_BACKEND_MEMORY_UNDO_UPDATE 2
+#define LIBDBO_BACKEND_MEMORY_UNDO_DELETE 3
+
+/**
+ * A change done within a transaction. For updates `value_set` is the value
+ * set of the row before the update and for deletes `row` is kept until the
+ * transaction is committed.
+ */
+typedef struct libdbo_backend_memory_undo libdbo_backend_memory_undo_t;
+struct libdbo_backend_memory_undo {
+    libdbo_backend_memory_undo_t* next;
+    int type;
+    libdbo_backend_memory_table_t* table;
+    libdbo_backend_memory_row_t* row;
+    libdbo_value_set_t* value_set;
+};
+
+static libdbo_mm_t __memory_undo_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_backend_memory_undo_t));
+
+/**
+ * The memory database backend specific data.
+ */
+typedef struct libdbo_backend_memory {
+    int connected;
+    libdbo_backend_memory_table_t* table_list;
+    /** The `unique` configuration, comma separated `table.field`. */
+    char* unique;
+    /** The undo log, newest change first. */
+    libdbo_backend_memory_undo_t* undo_list;
+    /** The head of the undo log when each nested transaction was started. */
+    libdbo_backend_memory_undo_t** savepoints;
+    size_t savepoints_size;
+    int transaction;
+} libdbo_backend_memory_t;
+
+static libdbo_mm_t __memory_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_backend_memory_t));
+
+/**
+ * A growable list of rows.
+ */
+typedef struct libdbo_backend_memory_rows {
+    libdbo_backend_memory_row_t** rows;
+    size_t size;
+    size_t allocated;
+} libdbo_backend_memory_rows_t;
+
+/**
+ * A row of a table that is part of the rows being matched, the first one is
+ * from the table being operated on and the rest are from joined tables.
+ */
+typedef struct libdbo_backend_memory_tuple {
+    const libdbo_backend_memory_table_t* table;
+    const libdbo_backend_memory_row_t* row;
+} libdbo_backend_memory_tuple_t;
+
+/**
+ * A join resolved to the tables and fields it uses.
+ */
+typedef struct libdbo_backend_memory_join {
+    size_t from;
+    size_t from_field;
+    const libdbo_backend_memory_table_t* table;
+    size_t field;
+    const libdbo_backend_memory_index_t* index;
+} libdbo_backend_memory_join_t;
+
+/**
+ * Add a row to a list of rows.
+ */
+static int __db_backend_memory_rows_add(libdbo_backend_memory_rows_t* rows, libdbo_backend_memory_row_t* row) {
+    libdbo_backend_memory_row_t** new_rows;
+    size_t allocated;
+
+    if (rows->size == rows->allocated) {
+        allocated = rows->allocated ? rows->allocated * 2 : 16;
+        if (!(new_rows = realloc(rows->rows, allocated * sizeof(libdbo_backend_memory_row_t*)))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        rows->rows = new_rows;
+        rows->allocated = allocated;
+    }
+    rows->rows[rows->size++] = row;
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Get an integer value as a sign and magnitude so that integers of all types
+ * can be compared and hashed the same way. Enums are compared by their
+ * integer value.
+ * \return LIBDBO_ERROR_* if the value is not an integer, otherwise LIBDBO_OK.
+ */
+static int __db_backend_memory_integer(const libdbo_value_t* value, int* negative, libdbo_type_uint64_t* magnitude) {
+    const libdbo_type_int32_t* int32;
+    const libdbo_type_uint32_t* uint32;
+    const libdbo_type_int64_t* int64;
+    const libdbo_type_uint64_t* uint64;
+    int enum_value;
+
+    switch (libdbo_value_type(value)) {
+    case LIBDBO_TYPE_INT32:
+        if (!(int32 = libdbo_value_int32(value))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        *negative = *int32 < 0;
+        *magnitude = *negative ? (libdbo_type_uint64_t)0 - (libdbo_type_uint64_t)(libdbo_type_int64_t)*int32 : (libdbo_type_uint64_t)*int32;
+        break;
+
+    case LIBDBO_TYPE_UINT32:
+        if (!(uint32 = libdbo_value_uint32(value))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        *negative = 0;
+        *magnitude = *uint32;
+        break;
+
+    case LIBDBO_TYPE_INT64:
+        if (!(int64 = libdbo_value_int64(value))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        *negative = *int64 < 0;
+        *magnitude = *negative ? (libdbo_type_uint64_t)0 - (libdbo_type_uint64_t)*int64 : (libdbo_type_uint64_t)*int64;
+        break;
+
+    case LIBDBO_TYPE_UINT64:
+        if (!(uint64 = libdbo_value_uint64(value))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        *negative = 0;
+        *magnitude = *uint64;
+        break;
+
+    case LIBDBO_TYPE_ENUM:
+        if (libdbo_value_enum_value(value, &enum_value)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        *negative = enum_value < 0;
+        *magnitude = *negative ? (libdbo_type_uint64_t)0 - (libdbo_type_uint64_t)(libdbo_type_int64_t)enum_value : (libdbo_type_uint64_t)enum_value;
+        break;
+
+    default:
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Compare two values, integers of different types are compared by their
+ * numeric value and text by strcmp().
+ * \param[out] result set to less then, equal to or greater then zero.
+ * \return LIBDBO_ERROR_* if the values can not be compared to each other,
+ * otherwise LIBDBO_OK.
+ */
+static int __db_backend_memory_compare(const libdbo_value_t* value_a, const libdbo_value_t* value_b, int* result) {
+    const char* text_a;
+    const char* text_b;
+    int negative_a, negative_b;
+    libdbo_type_uint64_t magnitude_a, magnitude_b;
+
+    if (libdbo_value_type(value_a) == LIBDBO_TYPE_TEXT
+        || libdbo_value_type(value_b) == LIBDBO_TYPE_TEXT)
+    {
+        if (!(text_a = libdbo_value_text(value_a))
+            || !(text_b = libdbo_value_text(value_b)))
+        {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        *result = strcmp(text_a, text_b);
+        return LIBDBO_OK;
+    }
+
+    if (__db_backend_memory_integer(value_a, &negative_a, &magnitude_a)
+        || __db_backend_memory_integer(value_b, &negative_b, &magnitude_b))
+    {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (negative_a != negative_b) {
+        *result = negative_a ? -1 : 1;
+    }
+    else if (magnitude_a == magnitude_b) {
+        *result = 0;
+    }
+    else if (negative_a) {
+        *result = magnitude_a > magnitude_b ? -1 : 1;
+    }
+    else {
+        *result = magnitude_a < magnitude_b ? -1 : 1;
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Hash a value, values that compare equal with __db_backend_memory_compare()
+ * hash to the same value.
+ * \return LIBDBO_ERROR_* if the value can not be hashed, otherwise LIBDBO_OK.
+ */
+static int __db_backend_memory_hash(const libdbo_value_t* value, libdbo_type_uint64_t* hash) {
+    const unsigned char* text;
+    int negative;
+    libdbo_type_uint64_t magnitude;
+
+    if (libdbo_value_type(value) == LIBDBO_TYPE_TEXT) {
+        if (!(text = (const unsigned char*)libdbo_value_text(value))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        /*
+         * FNV-1a
+         */
+        *hash = 14695981039346656037ULL;
+        while (*text) {
+            *hash ^= *text++;
+            *hash *= 1099511628211ULL;
+        }
+        return LIBDBO_OK;
+    }
+
+    if (__db_backend_memory_integer(value, &negative, &magnitude)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    magnitude ^= magnitude >> 33;
+    magnitude *= 0xff51afd7ed558ccdULL;
+    magnitude ^= magnitude >> 33;
+    *hash = negative ? ~magnitude : magnitude;
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Copy a value into an empty value, enums are stored as their integer value
+ * just like the SQL backends returns them.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_memory_value_copy(libdbo_value_t* value, const libdbo_value_t* from_value) {
+    const libdbo_type_int32_t* int32;
+    const libdbo_type_uint32_t* uint32;
+    const libdbo_type_int64_t* int64;
+    const libdbo_type_uint64_t* uint64;
+    const char* text;
+    int enum_value;
+
+    switch (libdbo_value_type(from_value)) {
+    case LIBDBO_TYPE_EMPTY:
+        return LIBDBO_OK;
+
+    case LIBDBO_TYPE_INT32:
+        if (!(int32 = libdbo_value_int32(from_value))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        return libdbo_value_from_int32(value, *int32);
+
+    case LIBDBO_TYPE_UINT32:
+        if (!(uint32 = libdbo_value_uint32(from_value))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        return libdbo_value_from_uint32(value, *uint32);
+
+    case LIBDBO_TYPE_INT64:
+        if (!(int64 = libdbo_value_int64(from_value))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        return libdbo_value_from_int64(value, *int64);
+
+    case LIBDBO_TYPE_UINT64:
+        if (!(uint64 = libdbo_value_uint64(from_value))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        return libdbo_value_from_uint64(value, *uint64);
+
+    case LIBDBO_TYPE_TEXT:
+        if (!(text = libdbo_value_text(from_value))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        return libdbo_value_from_text(value, text);
+
+    case LIBDBO_TYPE_ENUM:
+        if (libdbo_value_enum_value(from_value, &enum_value)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        return libdbo_value_from_int32(value, enum_value);
+
+    default:
+        break;
+    }
+
+    return LIBDBO_ERROR_UNKNOWN;
+}
+
+/**
+ * Free a row.
+ */
+static void __db_backend_memory_row_free(libdbo_backend_memory_row_t* row) {
+    if (row) {
+        libdbo_value_set_free(row->value_set);
+        libdbo_mm_delete(&__memory_row_alloc, row);
+    }
+}
+
+/**
+ * Free an index.
+ */
+static void __db_backend_memory_index_free(libdbo_backend_memory_index_t* index) {
+    libdbo_backend_memory_entry_t* entry;
+    size_t i;
+
+    if (!index) {
+        return;
+    }
+
+    for (i = 0; i < index->buckets_size; i++) {
+        while ((entry = index->buckets[i])) {
+            index->buckets[i] = entry->next;
+            libdbo_mm_delete(&__memory_entry_alloc, entry);
+        }
+    }
+    free(index->buckets);
+    libdbo_mm_delete(&__memory_index_alloc, index);
+}
+
+/**
+ * Find the row with the value `value` in an index.
+ * \return a libdbo_backend_memory_row_t pointer or NULL if not found.
+ */
+static libdbo_backend_memory_row_t* __db_backend_memory_index_find(const libdbo_backend_memory_index_t* index, const libdbo_value_t* value) {
+    const libdbo_backend_memory_entry_t* entry;
+    libdbo_type_uint64_t hash;
+    int cmp;
+
+    if (__db_backend_memory_hash(value, &hash)) {
+        return NULL;
+    }
+
+    for (entry = index->buckets[hash % index->buckets_size]; entry; entry = entry->next) {
+        if (entry->hash == hash
+            && !__db_backend_memory_compare(libdbo_value_set_at(entry->row->value_set, index->field), value, &cmp)
+            && !cmp)
+        {
+            return entry->row;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Add a row to an index, the index grows when it has more entries then
+ * buckets.
+ * \return LIBDBO_ERROR_* on failure or if the value of the row is already in
+ * the index, otherwise LIBDBO_OK.
+ */
+static int __db_backend_memory_index_add(libdbo_backend_memory_index_t* index, libdbo_backend_memory_row_t* row) {
+    const libdbo_value_t* value = libdbo_value_set_at(row->value_set, index->field);
+    libdbo_backend_memory_entry_t** buckets;
+    libdbo_backend_memory_entry_t* entry;
+    size_t buckets_size, i;
+
+    if (!value) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (libdbo_value_type(value) == LIBDBO_TYPE_EMPTY) {
+        return LIBDBO_OK;
+    }
+    if (__db_backend_memory_index_find(index, value)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (index->size >= index->buckets_size) {
+        buckets_size = index->buckets_size * 2;
+        if ((buckets = calloc(buckets_size, sizeof(libdbo_backend_memory_entry_t*)))) {
+            for (i = 0; i < index->buckets_size; i++) {
+                while ((entry = index->buckets[i])) {
+                    index->buckets[i] = entry->next;
+                    entry->next = buckets[entry->hash % buckets_size];
+                    buckets[entry->hash % buckets_size] = entry;
+                }
+            }
+            free(index->buckets);
+            index->buckets = buckets;
+            index->buckets_size = buckets_size;
+        }
+    }
+
+    if (!(entry = libdbo_mm_new0(&__memory_entry_alloc))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (__db_backend_memory_hash(value, &(entry->hash))) {
+        libdbo_mm_delete(&__memory_entry_alloc, entry);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    entry->row = row;
+    entry->next = index->buckets[entry->hash % index->buckets_size];
+    index->buckets[entry->hash % index->buckets_size] = entry;
+    index->size++;
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Remove a row from an index.
+ */
+static void __db_backend_memory_index_remove(libdbo_backend_memory_index_t* index, const libdbo_backend_memory_row_t* row) {
+    const libdbo_value_t* value = libdbo_value_set_at(row->value_set, index->field);
+    libdbo_backend_memory_entry_t** entry;
+    libdbo_backend_memory_entry_t* found;
+    libdbo_type_uint64_t hash;
+
+    if (!value || __db_backend_memory_hash(value, &hash)) {
+        return;
+    }
+
+    for (entry = &(index->buckets[hash % index->buckets_size]); *entry; entry = &((*entry)->next)) {
+        if ((*entry)->row == row) {
+            found = *entry;
+            *entry = found->next;
+            libdbo_mm_delete(&__memory_entry_alloc, found);
+            index->size--;
+            return;
+        }
+    }
+}
+
+/**
+ * Add a row to all indexes of a table, if any of them fails the row is
+ * removed from the indexes it was added to.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_memory_index_add_all(libdbo_backend_memory_table_t* table, libdbo_backend_memory_row_t* row) {
+    libdbo_backend_memory_index_t* index;
+    libdbo_backend_memory_index_t* added;
+
+    for (index = table->index_list; index; index = index->next) {
+        if (__db_backend_memory_index_add(index, row)) {
+            for (added = table->index_list; added != index; added = added->next) {
+                __db_backend_memory_index_remove(added, row);
+            }
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Remove a row from all indexes of a table.
+ */
+static void __db_backend_memory_index_remove_all(libdbo_backend_memory_table_t* table, const libdbo_backend_memory_row_t* row) {
+    libdbo_backend_memory_index_t* index;
+
+    for (index = table->index_list; index; index = index->next) {
+        __db_backend_memory_index_remove(index, row);
+    }
+}
+
+/**
+ * Find the index of a field.
+ * \return a libdbo_backend_memory_index_t pointer or NULL if the field is not
+ * indexed.
+ */
+static libdbo_backend_memory_index_t* __db_backend_memory_index(const libdbo_backend_memory_table_t* table, size_t field) {
+    libdbo_backend_memory_index_t* index;
+
+    for (index = table->index_list; index; index = index->next) {
+        if (index->field == field) {
+            return index;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Create an index on a field of a table.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_memory_index_new(libdbo_backend_memory_table_t* table, size_t field) {
+    libdbo_backend_memory_index_t* index;
+
+    if (__db_backend_memory_index(table, field)) {
+        return LIBDBO_OK;
+    }
+
+    if (!(index = libdbo_mm_new0(&__memory_index_alloc))
+        || !(index->buckets = calloc(LIBDBO_BACKEND_MEMORY_INDEX_SIZE, sizeof(libdbo_backend_memory_entry_t*))))
+    {
+        __db_backend_memory_index_free(index);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    index->field = field;
+    index->buckets_size = LIBDBO_BACKEND_MEMORY_INDEX_SIZE;
+    index->next = table->index_list;
+    table->index_list = index;
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Get the position of a field in a table.
+ * \return the position or `fields_size` of the table if not found.
+ */
+static size_t __db_backend_memory_field(const libdbo_backend_memory_table_t* table, const char* name) {
+    size_t i;
+
+    for (i = 0; i < table->fields_size; i++) {
+        if (!strcmp(table->fields[i], name)) {
+            break;
+        }
+    }
+
+    return i;
+}
+
+/**
+ * Free a table and all its rows.
+ */
+static void __db_backend_memory_table_free(libdbo_backend_memory_table_t* table) {
+    libdbo_backend_memory_index_t* index;
+    size_t i;
+
+    if (!table) {
+        return;
+    }
+
+    while ((index = table->index_list)) {
+        table->index_list = index->next;
+        __db_backend_memory_index_free(index);
+    }
+    for (i = 0; i < table->rows_size; i++) {
+        __db_backend_memory_row_free(table->rows[i]);
+    }
+    free(table->rows);
+    if (table->fields) {
+        for (i = 0; i < table->fields_size; i++) {
+            free(table->fields[i]);
+        }
+        free(table->fields);
+    }
+    free(table->name);
+    libdbo_mm_delete(&__memory_table_alloc, table);
+}
+
+/**
+ * Get the table for an object, if `create` is set the table is created with
+ * the fields of the object if it does not exist.
+ * \return a libdbo_backend_memory_table_t pointer or NULL if not found or on
+ * error.
+ */
+static libdbo_backend_memory_table_t* __db_backend_memory_table(libdbo_backend_memory_t* backend_memory, const char* name, const libdbo_object_t* object) {
+    libdbo_backend_memory_table_t* table;
+    const libdbo_object_field_t* object_field;
+    const char* unique;
+    const char* end;
+    size_t length, field;
+
+    for (table = backend_memory->table_list; table; table = table->next) {
+        if (!strcmp(table->name, name)) {
+            return table;
+        }
+    }
+    if (!object) {
+        return NULL;
+    }
+
+    if (!(table = libdbo_mm_new0(&__memory_table_alloc))
+        || !(table->name = strdup(name))
+        || !(table->fields = calloc(libdbo_object_field_list_size(libdbo_object_object_field_list(object)) + 1, sizeof(char*))))
+    {
+        __db_backend_memory_table_free(table);
+        return NULL;
+    }
+    table->next_id = 1;
+
+    object_field = libdbo_object_field_list_begin(libdbo_object_object_field_list(object));
+    while (object_field) {
+        if (!(table->fields[table->fields_size] = strdup(libdbo_object_field_name(object_field)))) {
+            __db_backend_memory_table_free(table);
+            return NULL;
+        }
+        table->fields_size++;
+        object_field = libdbo_object_field_next(object_field);
+    }
+    table->primary_key = table->fields_size;
+    table->revision = table->fields_size;
+    object_field = libdbo_object_field_list_begin(libdbo_object_object_field_list(object));
+    for (field = 0; object_field; field++) {
+        switch (libdbo_object_field_type(object_field)) {
+        case LIBDBO_TYPE_PRIMARY_KEY:
+            table->primary_key = field;
+            break;
+
+        case LIBDBO_TYPE_REVISION:
+            if (table->revision != table->fields_size) {
+                /*
+                 * We do not support multiple revision fields.
+                 */
+                __db_backend_memory_table_free(table);
+                return NULL;
+            }
+            table->revision = field;
+            break;
+
+        default:
+            break;
+        }
+        object_field = libdbo_object_field_next(object_field);
+    }
+
+    /*
+     * Index the primary key and the fields configured as unique.
+     */
+    if (table->primary_key != table->fields_size
+        && __db_backend_memory_index_new(table, table->primary_key))
+    {
+        __db_backend_memory_table_free(table);
+        return NULL;
+    }
+    for (unique = backend_memory->unique; unique && *unique; unique = *end ? end + 1 : end) {
+        if (!(end = strchr(unique, ','))) {
+            end = unique + strlen(unique);
+        }
+        while (*unique == ' ') {
+            unique++;
+        }
+        length = strlen(table->name);
+        if ((size_t)(end - unique) <= length + 1
+            || strncmp(unique, table->name, length)
+            || unique[length] != '.')
+        {
+            continue;
+        }
+        unique += length + 1;
+        for (field = 0; field < table->fields_size; field++) {
+            if (strlen(table->fields[field]) == (size_t)(end - unique)
+                && !strncmp(table->fields[field], unique, end - unique))
+            {
+                break;
+            }
+        }
+        if (field == table->fields_size) {
+            libdbo_log(LIBDBO_LOG_WARNING, "Memory backend unique field %.*s not found in table %s",
+                (int)(end - unique), unique, table->name);
+            continue;
+        }
+        if (__db_backend_memory_index_new(table, field)) {
+            __db_backend_memory_table_free(table);
+            return NULL;
+        }
+    }
+
+    table->next = backend_memory->table_list;
+    backend_memory->table_list = table;
+    return table;
+}
+
+/**
+ * Remove the deleted rows from a table, this is only done outside of
+ * transactions since the undo log refers to the position of rows.
+ */
+static void __db_backend_memory_table_compact(libdbo_backend_memory_table_t* table) {
+    size_t i, position = 0;
+
+    for (i = 0; i < table->rows_size; i++) {
+        if (table->rows[i]) {
+            table->rows[i]->position = position;
+            table->rows[position++] = table->rows[i];
+        }
+    }
+    table->rows_size = position;
+    table->rows_deleted = 0;
+}
+
+/**
+ * Record a change in the undo log.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_memory_undo_add(libdbo_backend_memory_t* backend_memory, int type, libdbo_backend_memory_table_t* table, libdbo_backend_memory_row_t* row, libdbo_value_set_t* value_set) {
+    libdbo_backend_memory_undo_t* undo;
+
+    if (!(undo = libdbo_mm_new0(&__memory_undo_alloc))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    undo->type = type;
+    undo->table = table;
+    undo->row = row;
+    undo->value_set = value_set;
+    undo->next = backend_memory->undo_list;
+    backend_memory->undo_list = undo;
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Free an undo log entry, making the change it recorded permanent.
+ */
+static void __db_backend_memory_undo_free(libdbo_backend_memory_undo_t* undo) {
+    switch (undo->type) {
+    case LIBDBO_BACKEND_MEMORY_UNDO_UPDATE:
+        libdbo_value_set_free(undo->value_set);
+        break;
+
+    case LIBDBO_BACKEND_MEMORY_UNDO_DELETE:
+        __db_backend_memory_row_free(undo->row);
+        break;
+
+    default:
+        break;
+    }
+    libdbo_mm_delete(&__memory_undo_alloc, undo);
+}
+
+/**
+ * Undo an undo log entry, reverting the change it recorded, and free it.
+ */
+static void __db_backend_memory_undo_revert(libdbo_backend_memory_undo_t* undo) {
+    libdbo_backend_memory_table_t* table = undo->table;
+    libdbo_backend_memory_row_t* row = undo->row;
+
+    switch (undo->type) {
+    case LIBDBO_BACKEND_MEMORY_UNDO_CREATE:
+        __db_backend_memory_index_remove_all(table, row);
+        table->rows[row->position] = NULL;
+        table->rows_deleted++;
+        __db_backend_memory_row_free(row);
+        break;
+
+    case LIBDBO_BACKEND_MEMORY_UNDO_UPDATE:
+        __db_backend_memory_index_remove_all(table, row);
+        libdbo_value_set_free(row->value_set);
+        row->value_set = undo->value_set;
+        if (__db_backend_memory_index_add_all(table, row)) {
+            libdbo_log(LIBDBO_LOG_ERROR, "Memory backend unable to reindex row in table %s on rollback", table->name);
+        }
+        break;
+
+    case LIBDBO_BACKEND_MEMORY_UNDO_DELETE:
+        table->rows[row->position] = row;
+        table->rows_deleted--;
+        if (__db_backend_memory_index_add_all(table, row)) {
+            libdbo_log(LIBDBO_LOG_ERROR, "Memory backend unable to reindex row in table %s on rollback", table->name);
+        }
+        break;
+
+    default:
+        break;
+    }
+    libdbo_mm_delete(&__memory_undo_alloc, undo);
+}
+
+/**
+ * Add a row to a table, it must not conflict with any of the indexes.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_memory_row_insert(libdbo_backend_memory_t* backend_memory, libdbo_backend_memory_table_t* table, libdbo_backend_memory_row_t* row) {
+    libdbo_backend_memory_row_t** rows;
+    size_t allocated;
+
+    if (table->rows_size == table->rows_allocated) {
+        allocated = table->rows_allocated ? table->rows_allocated * 2 : 64;
+        if (!(rows = realloc(table->rows, allocated * sizeof(libdbo_backend_memory_row_t*)))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        table->rows = rows;
+        table->rows_allocated = allocated;
+    }
+
+    if (__db_backend_memory_index_add_all(table, row)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (backend_memory->transaction
+        && __db_backend_memory_undo_add(backend_memory, LIBDBO_BACKEND_MEMORY_UNDO_CREATE, table, row, NULL))
+    {
+        __db_backend_memory_index_remove_all(table, row);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    row->position = table->rows_size;
+    table->rows[table->rows_size++] = row;
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Remove a row from a table, within a transaction the row is kept in the undo
+ * log otherwise it is freed.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_memory_row_remove(libdbo_backend_memory_t* backend_memory, libdbo_backend_memory_table_t* table, libdbo_backend_memory_row_t* row) {
+    if (backend_memory->transaction
+        && __db_backend_memory_undo_add(backend_memory, LIBDBO_BACKEND_MEMORY_UNDO_DELETE, table, row, NULL))
+    {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    __db_backend_memory_index_remove_all(table, row);
+    table->rows[row->position] = NULL;
+    table->rows_deleted++;
+    if (!backend_memory->transaction) {
+        __db_backend_memory_row_free(row);
+        if (table->rows_deleted > 16 && table->rows_deleted * 2 > table->rows_size) {
+            __db_backend_memory_table_compact(table);
+        }
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Replace the value set of a row, the new value set must not conflict with
+ * any of the indexes for other rows.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_memory_row_replace(libdbo_backend_memory_t* backend_memory, libdbo_backend_memory_table_t* table, libdbo_backend_memory_row_t* row, libdbo_value_set_t* value_set) {
+    libdbo_value_set_t* old_value_set = row->value_set;
+
+    if (backend_memory->transaction
+        && __db_backend_memory_undo_add(backend_memory, LIBDBO_BACKEND_MEMORY_UNDO_UPDATE, table, row, old_value_set))
+    {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    __db_backend_memory_index_remove_all(table, row);
+    row->value_set = value_set;
+    if (__db_backend_memory_index_add_all(table, row)) {
+        row->value_set = old_value_set;
+        if (__db_backend_memory_index_add_all(table, row)) {
+            libdbo_log(LIBDBO_LOG_ERROR, "Memory backend unable to reindex row in table %s", table->name);
+        }
+        if (backend_memory->transaction) {
+            /*
+             * Drop the undo entry we just added without freeing the old
+             * value set that is back in the row.
+             */
+            libdbo_backend_memory_undo_t* undo = backend_memory->undo_list;
+            backend_memory->undo_list = undo->next;
+            libdbo_mm_delete(&__memory_undo_alloc, undo);
+        }
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_memory->transaction) {
+        libdbo_value_set_free(old_value_set);
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Check if any index of a table would conflict with `value_set` for any
+ * other row then `row`.
+ * \return non-zero if there is a conflict.
+ */
+static int __db_backend_memory_row_conflict(const libdbo_backend_memory_table_t* table, const libdbo_backend_memory_row_t* row, const libdbo_value_set_t* value_set) {
+    const libdbo_backend_memory_index_t* index;
+    const libdbo_backend_memory_row_t* found;
+    const libdbo_value_t* value;
+
+    for (index = table->index_list; index; index = index->next) {
+        value = libdbo_value_set_at(value_set, index->field);
+        if (!value || libdbo_value_type(value) == LIBDBO_TYPE_EMPTY) {
+            continue;
+        }
+        if ((found = __db_backend_memory_index_find(index, value)) && found != row) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Check if the fields and values given sets any indexed field to a value,
+ * doing so for more then one row would make them conflict with each other.
+ * \return non-zero if an indexed field is set.
+ */
+static int __db_backend_memory_unique_set(const libdbo_backend_memory_table_t* table, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set) {
+    const libdbo_object_field_t* object_field;
+    const libdbo_value_t* value;
+    size_t i, field;
+
+    object_field = libdbo_object_field_list_begin(object_field_list);
+    for (i = 0; object_field; i++) {
+        if ((field = __db_backend_memory_field(table, libdbo_object_field_name(object_field))) != table->fields_size
+            && __db_backend_memory_index(table, field)
+            && (value = libdbo_value_set_at(value_set, i))
+            && libdbo_value_type(value) != LIBDBO_TYPE_EMPTY)
+        {
+            return 1;
+        }
+        object_field = libdbo_object_field_next(object_field);
+    }
+
+    return 0;
+}
+
+/**
+ * Get the value of the field a clause refers to from the rows being matched.
+ * \return a libdbo_value_t pointer or NULL if the field does not exist.
+ */
+static const libdbo_value_t* __db_backend_memory_clause_value(const libdbo_backend_memory_tuple_t* tuples, size_t tuples_size, const libdbo_clause_t* clause) {
+    const char* table = libdbo_clause_table(clause) ? libdbo_clause_table(clause) : tuples[0].table->name;
+    size_t i, field;
+
+    for (i = 0; i < tuples_size; i++) {
+        if (!strcmp(tuples[i].table->name, table)) {
+            if ((field = __db_backend_memory_field(tuples[i].table, libdbo_clause_field(clause))) == tuples[i].table->fields_size) {
+                break;
+            }
+            return libdbo_value_set_at(tuples[i].row->value_set, field);
+        }
+    }
+
+    libdbo_log(LIBDBO_LOG_ERROR, "Memory backend clause field %s.%s not found", table, libdbo_clause_field(clause));
+    return NULL;
+}
+
+static int __db_backend_memory_match(const libdbo_backend_memory_tuple_t* tuples, size_t tuples_size, const libdbo_clause_list_t* clause_list, int* match);
+
+/**
+ * Check if a single clause matches the rows being matched. Like in SQL an
+ * empty value never matches a comparison and neither does a comparison
+ * between values of types that can not be compared.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_memory_match_clause(const libdbo_backend_memory_tuple_t* tuples, size_t tuples_size, const libdbo_clause_t* clause, int* match) {
+    const libdbo_value_t* value;
+    int cmp;
+
+    if (libdbo_clause_type(clause) == LIBDBO_CLAUSE_NESTED) {
+        return __db_backend_memory_match(tuples, tuples_size, libdbo_clause_list(clause), match);
+    }
+
+    if (!(value = __db_backend_memory_clause_value(tuples, tuples_size, clause))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    switch (libdbo_clause_type(clause)) {
+    case LIBDBO_CLAUSE_IS_NULL:
+        *match = libdbo_value_type(value) == LIBDBO_TYPE_EMPTY;
+        return LIBDBO_OK;
+
+    case LIBDBO_CLAUSE_IS_NOT_NULL:
+        *match = libdbo_value_type(value) != LIBDBO_TYPE_EMPTY;
+        return LIBDBO_OK;
+
+    default:
+        break;
+    }
+
+    if (libdbo_value_type(value) == LIBDBO_TYPE_EMPTY
+        || __db_backend_memory_compare(value, libdbo_clause_value(clause), &cmp))
+    {
+        *match = 0;
+        return LIBDBO_OK;
+    }
+
+    switch (libdbo_clause_type(clause)) {
+    case LIBDBO_CLAUSE_EQUAL:
+        *match = cmp == 0;
+        break;
+
+    case LIBDBO_CLAUSE_NOT_EQUAL:
+        *match = cmp != 0;
+        break;
+
+    case LIBDBO_CLAUSE_LESS_THEN:
+        *match = cmp < 0;
+        break;
+
+    case LIBDBO_CLAUSE_LESS_OR_EQUAL:
+        *match = cmp <= 0;
+        break;
+
+    case LIBDBO_CLAUSE_GREATER_OR_EQUAL:
+        *match = cmp >= 0;
+        break;
+
+    case LIBDBO_CLAUSE_GREATER_THEN:
+        *match = cmp > 0;
+        break;
+
+    default:
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Check if a clause list matches the rows being matched. The operator of each
+ * clause joins it with the clause before it and AND is evaluated before OR,
+ * the same way the SQL backends builds their WHERE.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_memory_match(const libdbo_backend_memory_tuple_t* tuples, size_t tuples_size, const libdbo_clause_list_t* clause_list, int* match) {
+    const libdbo_clause_t* clause;
+    int any = 0, group = 1, first = 1, clause_match;
+
+    for (clause = libdbo_clause_list_begin(clause_list); clause; clause = libdbo_clause_next(clause)) {
+        if (first) {
+            first = 0;
+        }
+        else {
+            switch (libdbo_clause_operator(clause)) {
+            case LIBDBO_CLAUSE_OPERATOR_AND:
+                break;
+
+            case LIBDBO_CLAUSE_OPERATOR_OR:
+                any |= group;
+                group = 1;
+                break;
+
+            default:
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+        }
+
+        if (!group || any) {
+            continue;
+        }
+        if (__db_backend_memory_match_clause(tuples, tuples_size, clause, &clause_match)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        group = clause_match;
+    }
+
+    *match = any | group;
+    return LIBDBO_OK;
+}
+
+/**
+ * Find an equal clause on an indexed field of the table that every row must
+ * match, that is when all top level clauses are joined by AND.
+ * \return a libdbo_clause_t pointer or NULL if none.
+ */
+static const libdbo_clause_t* __db_backend_memory_index_clause(const libdbo_backend_memory_table_t* table, const libdbo_clause_list_t* clause_list, const libdbo_backend_memory_index_t** index) {
+    const libdbo_clause_t* clause;
+    const libdbo_clause_t* found = NULL;
+    size_t field;
+    int first = 1;
+
+    for (clause = libdbo_clause_list_begin(clause_list); clause; clause = libdbo_clause_next(clause)) {
+        if (!first && libdbo_clause_operator(clause) != LIBDBO_CLAUSE_OPERATOR_AND) {
+            return NULL;
+        }
+        first = 0;
+
+        if (found
+            || libdbo_clause_type(clause) != LIBDBO_CLAUSE_EQUAL
+            || (libdbo_clause_table(clause) && strcmp(libdbo_clause_table(clause), table->name))
+            || (field = __db_backend_memory_field(table, libdbo_clause_field(clause))) == table->fields_size
+            || !(*index = __db_backend_memory_index(table, field)))
+        {
+            continue;
+        }
+        found = clause;
+    }
+
+    return found;
+}
+
+/**
+ * Match the rows of the joined tables, starting with join number `join`, and
+ * then the clause list. The row of the table being operated on is added to
+ * `rows` for each combination of joined rows that matches.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_memory_select_join(libdbo_backend_memory_tuple_t* tuples, const libdbo_backend_memory_join_t* joins, size_t joins_size, size_t join, const libdbo_clause_list_t* clause_list, libdbo_backend_memory_rows_t* rows) {
+    const libdbo_backend_memory_join_t* current;
+    const libdbo_value_t* value;
+    const libdbo_backend_memory_row_t* row;
+    size_t i;
+    int match = 1, cmp;
+
+    if (join == joins_size) {
+        if (clause_list && __db_backend_memory_match(tuples, joins_size + 1, clause_list, &match)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        if (match) {
+            return __db_backend_memory_rows_add(rows, (libdbo_backend_memory_row_t*)tuples[0].row);
+        }
+        return LIBDBO_OK;
+    }
+
+    current = &(joins[join]);
+    value = libdbo_value_set_at(tuples[current->from].row->value_set, current->from_field);
+    if (!value || libdbo_value_type(value) == LIBDBO_TYPE_EMPTY) {
+        return LIBDBO_OK;
+    }
+    tuples[join + 1].table = current->table;
+
+    if (current->index) {
+        if ((row = __db_backend_memory_index_find(current->index, value))) {
+            tuples[join + 1].row = row;
+            return __db_backend_memory_select_join(tuples, joins, joins_size, join + 1, clause_list, rows);
+        }
+        return LIBDBO_OK;
+    }
+
+    for (i = 0; i < current->table->rows_size; i++) {
+        if (!(row = current->table->rows[i])
+            || __db_backend_memory_compare(libdbo_value_set_at(row->value_set, current->field), value, &cmp)
+            || cmp)
+        {
+            continue;
+        }
+        tuples[join + 1].row = row;
+        if (__db_backend_memory_select_join(tuples, joins, joins_size, join + 1, clause_list, rows)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Select the rows of a table that matches the joins and clauses. If the
+ * clauses require an indexed field to be equal to a value then only the row
+ * found in the index is checked, otherwise all rows are.
+ * \param[in] backend_memory a libdbo_backend_memory_t pointer.
+ * \param[in] table a libdbo_backend_memory_table_t pointer.
+ * \param[in] join_list a libdbo_join_list_t pointer or NULL.
+ * \param[in] clause_list a libdbo_clause_list_t pointer or NULL.
+ * \param[out] rows a libdbo_backend_memory_rows_t pointer, a row is added once
+ * for each combination of joined rows it matched.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_memory_select(libdbo_backend_memory_t* backend_memory, const libdbo_backend_memory_table_t* table, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list, libdbo_backend_memory_rows_t* rows) {
+    libdbo_backend_memory_tuple_t* tuples;
+    libdbo_backend_memory_join_t* joins = NULL;
+    const libdbo_join_t* join;
+    const libdbo_clause_t* clause = NULL;
+    const libdbo_backend_memory_index_t* index = NULL;
+    const libdbo_backend_memory_row_t* row;
+    size_t joins_size = 0, i, j;
+    int ret = LIBDBO_OK;
+
+    if (join_list) {
+        for (join = libdbo_join_list_begin(join_list); join; join = libdbo_join_next(join)) {
+            joins_size++;
+        }
+    }
+    if (!(tuples = calloc(joins_size + 1, sizeof(libdbo_backend_memory_tuple_t)))
+        || (joins_size && !(joins = calloc(joins_size, sizeof(libdbo_backend_memory_join_t)))))
+    {
+        free(tuples);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    tuples[0].table = table;
+
+    /*
+     * Resolve the joins, a join to a table that does not exist yet can not
+     * match anything.
+     */
+    i = 0;
+    for (join = joins_size ? libdbo_join_list_begin(join_list) : NULL; join; join = libdbo_join_next(join), i++) {
+        if (!(joins[i].table = __db_backend_memory_table(backend_memory, libdbo_join_to_table(join), NULL))) {
+            free(joins);
+            free(tuples);
+            return LIBDBO_OK;
+        }
+        tuples[i + 1].table = joins[i].table;
+        for (j = 0; j <= i; j++) {
+            if (!strcmp(tuples[j].table->name, libdbo_join_from_table(join))) {
+                break;
+            }
+        }
+        if (j > i
+            || (joins[i].from_field = __db_backend_memory_field(tuples[j].table, libdbo_join_from_field(join))) == tuples[j].table->fields_size
+            || (joins[i].field = __db_backend_memory_field(joins[i].table, libdbo_join_to_field(join))) == joins[i].table->fields_size)
+        {
+            libdbo_log(LIBDBO_LOG_ERROR, "Memory backend unable to join %s.%s to %s.%s",
+                libdbo_join_from_table(join), libdbo_join_from_field(join),
+                libdbo_join_to_table(join), libdbo_join_to_field(join));
+            free(joins);
+            free(tuples);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        joins[i].from = j;
+        joins[i].index = __db_backend_memory_index(joins[i].table, joins[i].field);
+    }
+
+    if (clause_list) {
+        clause = __db_backend_memory_index_clause(table, clause_list, &index);
+    }
+    if (clause) {
+        if ((row = __db_backend_memory_index_find(index, libdbo_clause_value(clause)))) {
+            tuples[0].row = row;
+            ret = __db_backend_memory_select_join(tuples, joins, joins_size, 0, clause_list, rows);
+        }
+    }
+    else {
+        for (i = 0; !ret && i < table->rows_size; i++) {
+            if (!(tuples[0].row = table->rows[i])) {
+                continue;
+            }
+            ret = __db_backend_memory_select_join(tuples, joins, joins_size, 0, clause_list, rows);
+        }
+    }
+
+    free(joins);
+    free(tuples);
+    return ret;
+}
+
+/**
+ * Find the revision field of an object.
+ * \return LIBDBO_ERROR_* if the object has more then one revision field,
+ * otherwise LIBDBO_OK.
+ */
+static int __db_backend_memory_revision_field(const libdbo_object_t* object, const libdbo_object_field_t** revision_field) {
+    const libdbo_object_field_t* object_field;
+
+    *revision_field = NULL;
+    object_field = libdbo_object_field_list_begin(libdbo_object_object_field_list(object));
+    while (object_field) {
+        if (libdbo_object_field_type(object_field) == LIBDBO_TYPE_REVISION) {
+            if (*revision_field) {
+                /*
+                 * We do not support multiple revision fields.
+                 */
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+
+            *revision_field = object_field;
+        }
+        object_field = libdbo_object_field_next(object_field);
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Get a revision number from a value.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_memory_revision(const libdbo_value_t* value, libdbo_type_int64_t* revision_number) {
+    libdbo_type_uint64_t magnitude;
+    int negative;
+
+    if (__db_backend_memory_integer(value, &negative, &magnitude)
+        || negative
+        || magnitude >= 0x7fffffffffffffffULL)
+    {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    *revision_number = (libdbo_type_int64_t)magnitude;
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Build the value set of a new row from the fields and values given, the
+ * primary key is set to the next id unless given and the revision to 1.
+ * \return a libdbo_value_set_t pointer or NULL on error.
+ */
+static libdbo_value_set_t* __db_backend_memory_new_value_set(libdbo_backend_memory_table_t* table, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set) {
+    libdbo_value_set_t* new_value_set;
+    const libdbo_object_field_t* object_field;
+    size_t i, field;
+
+    if (libdbo_object_field_list_size(object_field_list) != libdbo_value_set_size(value_set)
+        || !(new_value_set = libdbo_value_set_new(table->fields_size)))
+    {
+        return NULL;
+    }
+
+    object_field = libdbo_object_field_list_begin(object_field_list);
+    for (i = 0; object_field; i++) {
+        if ((field = __db_backend_memory_field(table, libdbo_object_field_name(object_field))) == table->fields_size) {
+            libdbo_log(LIBDBO_LOG_ERROR, "Memory backend field %s not found in table %s",
+                libdbo_object_field_name(object_field), table->name);
+            libdbo_value_set_free(new_value_set);
+            return NULL;
+        }
+        if (field != table->revision
+            && __db_backend_memory_value_copy(libdbo_value_set_get(new_value_set, field), libdbo_value_set_at(value_set, i)))
+        {
+            libdbo_value_set_free(new_value_set);
+            return NULL;
+        }
+        object_field = libdbo_object_field_next(object_field);
+    }
+
+    if ((table->primary_key != table->fields_size
+            && libdbo_value_type(libdbo_value_set_at(new_value_set, table->primary_key)) == LIBDBO_TYPE_EMPTY
+            && libdbo_value_from_int64(libdbo_value_set_get(new_value_set, table->primary_key), table->next_id))
+        || (table->revision != table->fields_size
+            && libdbo_value_from_int64(libdbo_value_set_get(new_value_set, table->revision), 1)))
+    {
+        libdbo_value_set_free(new_value_set);
+        return NULL;
+    }
+
+    return new_value_set;
+}
+
+/**
+ * Insert a new row with the fields and values given.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_memory_insert(libdbo_backend_memory_t* backend_memory, libdbo_backend_memory_table_t* table, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set) {
+    libdbo_backend_memory_row_t* row;
+    libdbo_type_int64_t revision_number;
+
+    if (!(row = libdbo_mm_new0(&__memory_row_alloc))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!(row->value_set = __db_backend_memory_new_value_set(table, object_field_list, value_set))
+        || __db_backend_memory_row_insert(backend_memory, table, row))
+    {
+        __db_backend_memory_row_free(row);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * Keep the next id after any primary key given.
+     */
+    if (table->primary_key != table->fields_size
+        && !__db_backend_memory_revision(libdbo_value_set_at(row->value_set, table->primary_key), &revision_number)
+        && revision_number >= table->next_id)
+    {
+        table->next_id = revision_number + 1;
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Build the value set of an updated row from the current value set and the
+ * fields and values given, the revision is set to `revision_number` unless
+ * it is negative.
+ * \return a libdbo_value_set_t pointer or NULL on error.
+ */
+static libdbo_value_set_t* __db_backend_memory_update_value_set(const libdbo_backend_memory_table_t* table, const libdbo_backend_memory_row_t* row, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, libdbo_type_int64_t revision_number) {
+    libdbo_value_set_t* new_value_set;
+    const libdbo_object_field_t* object_field;
+    const libdbo_value_t** values;
+    size_t i, field;
+
+    if (libdbo_object_field_list_size(object_field_list) != libdbo_value_set_size(value_set)
+        || !(values = calloc(table->fields_size, sizeof(libdbo_value_t*))))
+    {
+        return NULL;
+    }
+    for (i = 0; i < table->fields_size; i++) {
+        values[i] = libdbo_value_set_at(row->value_set, i);
+    }
+
+    object_field = libdbo_object_field_list_begin(object_field_list);
+    for (i = 0; object_field; i++) {
+        if ((field = __db_backend_memory_field(table, libdbo_object_field_name(object_field))) == table->fields_size) {
+            libdbo_log(LIBDBO_LOG_ERROR, "Memory backend field %s not found in table %s",
+                libdbo_object_field_name(object_field), table->name);
+            free(values);
+            return NULL;
+        }
+        values[field] = libdbo_value_set_at(value_set, i);
+        object_field = libdbo_object_field_next(object_field);
+    }
+
+    if (!(new_value_set = libdbo_value_set_new(table->fields_size))) {
+        free(values);
+        return NULL;
+    }
+    for (i = 0; i < table->fields_size; i++) {
+        if (i == table->revision && revision_number >= 0) {
+            if (libdbo_value_from_int64(libdbo_value_set_get(new_value_set, i), revision_number)) {
+                break;
+            }
+        }
+        else if (__db_backend_memory_value_copy(libdbo_value_set_get(new_value_set, i), values[i])) {
+            break;
+        }
+    }
+    free(values);
+    if (i < table->fields_size) {
+        libdbo_value_set_free(new_value_set);
+        return NULL;
+    }
+
+    return new_value_set;
+}
+
+static int libdbo_backend_memory_transaction_rollback(void* data);
+
+static int libdbo_backend_memory_initialize(void* data) {
+    libdbo_backend_memory_t* backend_memory = (libdbo_backend_memory_t*)data;
+
+    if (!backend_memory) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    __memory_initialized = 1;
+    return LIBDBO_OK;
+}
+
+static int libdbo_backend_memory_shutdown(void* data) {
+    libdbo_backend_memory_t* backend_memory = (libdbo_backend_memory_t*)data;
+
+    if (!backend_memory) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    __memory_initialized = 0;
+    return LIBDBO_OK;
+}
+
+static int libdbo_backend_memory_connect(void* data, const libdbo_configuration_list_t* configuration_list) {
+    libdbo_backend_memory_t* backend_memory = (libdbo_backend_memory_t*)data;
+    const libdbo_configuration_t* configuration;
+
+    if (!__memory_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_memory) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (backend_memory->connected) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!configuration_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    free(backend_memory->unique);
+    backend_memory->unique = NULL;
+    if ((configuration = libdbo_configuration_list_find(configuration_list, "unique"))
+        && !(backend_memory->unique = strdup(libdbo_configuration_value(configuration))))
+    {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    backend_memory->connected = 1;
+    return LIBDBO_OK;
+}
+
+static int libdbo_backend_memory_disconnect(void* data) {
+    libdbo_backend_memory_t* backend_memory = (libdbo_backend_memory_t*)data;
+
+    if (!__memory_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_memory) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_memory->connected) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (backend_memory->transaction) {
+        /*
+         * Rolling back the outer most transaction also discards all the
+         * nested ones.
+         */
+        backend_memory->transaction = 1;
+        libdbo_backend_memory_transaction_rollback(backend_memory);
+    }
+
+    backend_memory->connected = 0;
+    return LIBDBO_OK;
+}
+
+static int libdbo_backend_memory_create(void* data, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set) {
+    libdbo_backend_memory_t* backend_memory = (libdbo_backend_memory_t*)data;
+    libdbo_backend_memory_table_t* table;
+    const libdbo_object_field_t* revision_field;
+
+    if (!__memory_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_memory) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_memory->connected) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object_field_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!value_set) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (__db_backend_memory_revision_field(object, &revision_field)
+        || !(table = __db_backend_memory_table(backend_memory, libdbo_object_table(object), object)))
+    {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    return __db_backend_memory_insert(backend_memory, table, object_field_list, value_set);
+}
+
+static libdbo_result_list_t* libdbo_backend_memory_read(void* data, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list) {
+    libdbo_backend_memory_t* backend_memory = (libdbo_backend_memory_t*)data;
+    libdbo_backend_memory_table_t* table;
+    libdbo_backend_memory_rows_t rows = { NULL, 0, 0 };
+    const libdbo_object_field_t* object_field;
+    libdbo_result_list_t* result_list;
+    libdbo_result_t* result;
+    libdbo_value_set_t* value_set;
+    size_t* fields;
+    size_t i, j;
+
+    if (!__memory_initialized) {
+        return NULL;
+    }
+    if (!backend_memory) {
+        return NULL;
+    }
+    if (!backend_memory->connected) {
+        return NULL;
+    }
+    if (!object) {
+        return NULL;
+    }
+
+    if (!(result_list = libdbo_result_list_new())) {
+        return NULL;
+    }
+    if (!(table = __db_backend_memory_table(backend_memory, libdbo_object_table(object), NULL))) {
+        return result_list;
+    }
+
+    /*
+     * Map the fields of the object to the fields of the table.
+     */
+    if (!(fields = calloc(libdbo_object_field_list_size(libdbo_object_object_field_list(object)) + 1, sizeof(size_t)))) {
+        libdbo_result_list_free(result_list);
+        return NULL;
+    }
+    object_field = libdbo_object_field_list_begin(libdbo_object_object_field_list(object));
+    for (i = 0; object_field; i++) {
+        if ((fields[i] = __db_backend_memory_field(table, libdbo_object_field_name(object_field))) == table->fields_size) {
+            libdbo_log(LIBDBO_LOG_ERROR, "Memory backend field %s not found in table %s",
+                libdbo_object_field_name(object_field), table->name);
+            free(fields);
+            libdbo_result_list_free(result_list);
+            return NULL;
+        }
+        object_field = libdbo_object_field_next(object_field);
+    }
+
+    if (__db_backend_memory_select(backend_memory, table, join_list, clause_list, &rows)) {
+        free(rows.rows);
+        free(fields);
+        libdbo_result_list_free(result_list);
+        return NULL;
+    }
+
+    for (i = 0; i < rows.size; i++) {
+        result = NULL;
+        if (!(value_set = libdbo_value_set_new(libdbo_object_field_list_size(libdbo_object_object_field_list(object))))
+            || !(result = libdbo_result_new())
+            || libdbo_result_set_value_set(result, value_set))
+        {
+            libdbo_value_set_free(value_set);
+            libdbo_result_free(result);
+            break;
+        }
+
+        object_field = libdbo_object_field_list_begin(libdbo_object_object_field_list(object));
+        for (j = 0; object_field; j++) {
+            if (__db_backend_memory_value_copy(libdbo_value_set_get(value_set, j), libdbo_value_set_at(rows.rows[i]->value_set, fields[j]))
+                || (libdbo_object_field_type(object_field) == LIBDBO_TYPE_PRIMARY_KEY
+                    && libdbo_value_set_primary_key(libdbo_value_set_get(value_set, j))))
+            {
+                break;
+            }
+            object_field = libdbo_object_field_next(object_field);
+        }
+        if (object_field || libdbo_result_list_add(result_list, result)) {
+            libdbo_result_free(result);
+            break;
+        }
+    }
+    free(fields);
+    if (i < rows.size) {
+        free(rows.rows);
+        libdbo_result_list_free(result_list);
+        return NULL;
+    }
+    free(rows.rows);
+
+    return result_list;
+}
+
+static int libdbo_backend_memory_update(void* data, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, const libdbo_clause_list_t* clause_list) {
+    libdbo_backend_memory_t* backend_memory = (libdbo_backend_memory_t*)data;
+    libdbo_backend_memory_table_t* table;
+    libdbo_backend_memory_rows_t rows = { NULL, 0, 0 };
+    const libdbo_object_field_t* revision_field;
+    const libdbo_clause_t* clause;
+    const libdbo_clause_t* revision_clause = NULL;
+    libdbo_type_int64_t revision_number = -1;
+    libdbo_value_set_t** value_sets;
+    size_t i;
+    int ret = LIBDBO_OK;
+
+    if (!__memory_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_memory) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_memory->connected) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object_field_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!value_set) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * Check if the object has a revision field and keep it for later use.
+     */
+    if (__db_backend_memory_revision_field(object, &revision_field)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (revision_field) {
+        /*
+         * If we have a revision field we should also have it in the clause,
+         * find it and get the value for later use or return error if not found.
+         */
+        clause = libdbo_clause_list_begin(clause_list);
+        while (clause) {
+            if (!strcmp(libdbo_clause_field(clause), libdbo_object_field_name(revision_field))) {
+                revision_clause = clause;
+                break;
+            }
+            clause = libdbo_clause_next(clause);
+        }
+        if (!revision_clause
+            || __db_backend_memory_revision(libdbo_clause_value(revision_clause), &revision_number))
+        {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        revision_number++;
+    }
+
+    if (!(table = __db_backend_memory_table(backend_memory, libdbo_object_table(object), NULL))) {
+        return revision_field ? LIBDBO_ERROR_REVISION : LIBDBO_OK;
+    }
+    if (__db_backend_memory_select(backend_memory, table, NULL, clause_list, &rows)) {
+        free(rows.rows);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * If we are using revision we have to have a positive number of changes
+     * otherwise its a failure.
+     */
+    if (!rows.size) {
+        free(rows.rows);
+        return revision_field ? LIBDBO_ERROR_REVISION : LIBDBO_OK;
+    }
+
+    /*
+     * Build all the new value sets and check them against the indexes before
+     * changing anything so that the update is all or nothing.
+     */
+    if (!(value_sets = calloc(rows.size, sizeof(libdbo_value_set_t*)))) {
+        free(rows.rows);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (rows.size > 1 && __db_backend_memory_unique_set(table, object_field_list, value_set)) {
+        ret = LIBDBO_ERROR_UNKNOWN;
+    }
+    for (i = 0; !ret && i < rows.size; i++) {
+        if (!(value_sets[i] = __db_backend_memory_update_value_set(table, rows.rows[i], object_field_list, value_set, revision_number))
+            || __db_backend_memory_row_conflict(table, rows.rows[i], value_sets[i]))
+        {
+            ret = LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+    for (i = 0; !ret && i < rows.size; i++) {
+        if (__db_backend_memory_row_replace(backend_memory, table, rows.rows[i], value_sets[i])) {
+            ret = LIBDBO_ERROR_UNKNOWN;
+            break;
+        }
+        value_sets[i] = NULL;
+    }
+    for (i = 0; i < rows.size; i++) {
+        libdbo_value_set_free(value_sets[i]);
+    }
+    free(value_sets);
+    free(rows.rows);
+
+    return ret;
+}
+
+static int libdbo_backend_memory_delete(void* data, const libdbo_object_t* object, const libdbo_clause_list_t* clause_list) {
+    libdbo_backend_memory_t* backend_memory = (libdbo_backend_memory_t*)data;
+    libdbo_backend_memory_table_t* table;
+    libdbo_backend_memory_rows_t rows = { NULL, 0, 0 };
+    const libdbo_object_field_t* revision_field;
+    const libdbo_clause_t* clause;
+    size_t i;
+
+    if (!__memory_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_memory) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_memory->connected) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * Check if the object has a revision field and keep it for later use.
+     */
+    if (__db_backend_memory_revision_field(object, &revision_field)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (revision_field) {
+        /*
+         * If we have a revision field we should also have it in the clause,
+         * find it or return error if not found.
+         */
+        clause = libdbo_clause_list_begin(clause_list);
+        while (clause) {
+            if (!strcmp(libdbo_clause_field(clause), libdbo_object_field_name(revision_field))) {
+                break;
+            }
+            clause = libdbo_clause_next(clause);
+        }
+        if (!clause) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+
+    if (!(table = __db_backend_memory_table(backend_memory, libdbo_object_table(object), NULL))) {
+        return revision_field ? LIBDBO_ERROR_REVISION : LIBDBO_OK;
+    }
+    if (__db_backend_memory_select(backend_memory, table, NULL, clause_list, &rows)) {
+        free(rows.rows);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * If we are using revision we have to have a positive number of changes
+     * otherwise its a failure.
+     */
+    if (revision_field && !rows.size) {
+        free(rows.rows);
+        return LIBDBO_ERROR_REVISION;
+    }
+
+    for (i = 0; i < rows.size; i++) {
+        if (__db_backend_memory_row_remove(backend_memory, table, rows.rows[i])) {
+            free(rows.rows);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+    free(rows.rows);
+
+    return LIBDBO_OK;
+}
+
+static int libdbo_backend_memory_count(void* data, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list, size_t* count) {
+    libdbo_backend_memory_t* backend_memory = (libdbo_backend_memory_t*)data;
+    libdbo_backend_memory_table_t* table;
+    libdbo_backend_memory_rows_t rows = { NULL, 0, 0 };
+
+    if (!__memory_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_memory) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_memory->connected) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!count) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    *count = 0;
+    if (!(table = __db_backend_memory_table(backend_memory, libdbo_object_table(object), NULL))) {
+        return LIBDBO_OK;
+    }
+    if (__db_backend_memory_select(backend_memory, table, join_list, clause_list, &rows)) {
+        free(rows.rows);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    *count = rows.size;
+    free(rows.rows);
+
+    return LIBDBO_OK;
+}
+
+static int libdbo_backend_memory_upsert(void* data, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, const libdbo_clause_list_t* clause_list) {
+    libdbo_backend_memory_t* backend_memory = (libdbo_backend_memory_t*)data;
+    libdbo_backend_memory_table_t* table;
+    libdbo_backend_memory_tuple_t tuple;
+    libdbo_backend_memory_row_t* row = NULL;
+    const libdbo_backend_memory_index_t* index;
+    const libdbo_object_field_t* revision_field;
+    const libdbo_clause_t* clause;
+    const libdbo_clause_t* index_clause;
+    const libdbo_clause_t* revision_clause = NULL;
+    libdbo_value_set_t* new_value_set;
+    libdbo_type_int64_t revision_number = -1;
+    size_t i, field;
+    int match;
+
+    if (!__memory_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_memory) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_memory->connected) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object_field_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!value_set) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!clause_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!libdbo_object_field_list_begin(object_field_list)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (__db_backend_memory_revision_field(object, &revision_field)
+        || !(table = __db_backend_memory_table(backend_memory, libdbo_object_table(object), object)))
+    {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * The clauses can only be equal clauses on the unique fields and the
+     * revision field, the revision clause is optional and if given the update
+     * will only be done if the object is still on that revision.
+     */
+    clause = libdbo_clause_list_begin(clause_list);
+    if (!clause) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    while (clause) {
+        if (libdbo_clause_type(clause) != LIBDBO_CLAUSE_EQUAL) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        if (revision_field
+            && !strcmp(libdbo_clause_field(clause), libdbo_object_field_name(revision_field)))
+        {
+            if (revision_clause) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            revision_clause = clause;
+        }
+        clause = libdbo_clause_next(clause);
+    }
+
+    /*
+     * Find the existing row by the unique fields, using an index if one of
+     * them is indexed.
+     */
+    tuple.table = table;
+    for (index_clause = libdbo_clause_list_begin(clause_list); index_clause; index_clause = libdbo_clause_next(index_clause)) {
+        if (index_clause != revision_clause
+            && (field = __db_backend_memory_field(table, libdbo_clause_field(index_clause))) != table->fields_size
+            && (index = __db_backend_memory_index(table, field)))
+        {
+            break;
+        }
+    }
+    for (i = 0; index_clause ? !i : i < table->rows_size; i++) {
+        if (index_clause) {
+            tuple.row = __db_backend_memory_index_find(index, libdbo_clause_value(index_clause));
+        }
+        else {
+            tuple.row = table->rows[i];
+        }
+        if (!tuple.row) {
+            continue;
+        }
+
+        match = 1;
+        for (clause = libdbo_clause_list_begin(clause_list); match && clause; clause = libdbo_clause_next(clause)) {
+            if (clause != revision_clause
+                && __db_backend_memory_match_clause(&tuple, 1, clause, &match))
+            {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+        }
+        if (match) {
+            if (row) {
+                /*
+                 * The clauses does not identify a single object.
+                 */
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            row = (libdbo_backend_memory_row_t*)tuple.row;
+        }
+    }
+
+    if (!row) {
+        return __db_backend_memory_insert(backend_memory, table, object_field_list, value_set);
+    }
+
+    /*
+     * If the update was restricted to a revision the object must still be on
+     * that revision otherwise it was changed by someone else.
+     */
+    if (table->revision != table->fields_size) {
+        if (__db_backend_memory_revision(libdbo_value_set_at(row->value_set, table->revision), &revision_number)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        if (revision_clause) {
+            tuple.row = row;
+            if (__db_backend_memory_match_clause(&tuple, 1, revision_clause, &match)) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            if (!match) {
+                return LIBDBO_ERROR_REVISION;
+            }
+        }
+        revision_number++;
+    }
+
+    if (!(new_value_set = __db_backend_memory_update_value_set(table, row, object_field_list, value_set, revision_number))
+        || __db_backend_memory_row_conflict(table, row, new_value_set)
+        || __db_backend_memory_row_replace(backend_memory, table, row, new_value_set))
+    {
+        libdbo_value_set_free(new_value_set);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    return LIBDBO_OK;
+}
+
+static void libdbo_backend_memory_free(void* data) {
+    libdbo_backend_memory_t* backend_memory = (libdbo_backend_memory_t*)data;
+    libdbo_backend_memory_table_t* table;
+
+    if (backend_memory) {
+        if (backend_memory->connected) {
+            (void)libdbo_backend_memory_disconnect(backend_memory);
+        }
+        while ((table = backend_memory->table_list)) {
+            backend_memory->table_list = table->next;
+            __db_backend_memory_table_free(table);
+        }
+        free(backend_memory->savepoints);
+        free(backend_memory->unique);
+        libdbo_mm_delete(&__memory_alloc, backend_memory);
+    }
+}
+
+/*
+ * Transactions can be nested, each transaction remembers where the undo log
+ * was when it was started and rolling back reverts the changes made since
+ * then. The undo log is kept until the outer most transaction is committed.
+ */
+
+static int libdbo_backend_memory_transaction_begin(void* data) {
+    libdbo_backend_memory_t* backend_memory = (libdbo_backend_memory_t*)data;
+    libdbo_backend_memory_undo_t** savepoints;
+    size_t size;
+
+    if (!__memory_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_memory) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_memory->connected) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if ((size_t)backend_memory->transaction == backend_memory->savepoints_size) {
+        size = backend_memory->savepoints_size ? backend_memory->savepoints_size * 2 : 8;
+        if (!(savepoints = realloc(backend_memory->savepoints, size * sizeof(libdbo_backend_memory_undo_t*)))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        backend_memory->savepoints = savepoints;
+        backend_memory->savepoints_size = size;
+    }
+
+    backend_memory->savepoints[backend_memory->transaction] = backend_memory->undo_list;
+    backend_memory->transaction++;
+    return LIBDBO_OK;
+}
+
+static int libdbo_backend_memory_transaction_commit(void* data) {
+    libdbo_backend_memory_t* backend_memory = (libdbo_backend_memory_t*)data;
+    libdbo_backend_memory_undo_t* undo;
+    libdbo_backend_memory_table_t* table;
+
+    if (!__memory_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_memory) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_memory->transaction) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    backend_memory->transaction--;
+    if (!backend_memory->transaction) {
+        while ((undo = backend_memory->undo_list)) {
+            backend_memory->undo_list = undo->next;
+            __db_backend_memory_undo_free(undo);
+        }
+        for (table = backend_memory->table_list; table; table = table->next) {
+            if (table->rows_deleted > 16 && table->rows_deleted * 2 > table->rows_size) {
+                __db_backend_memory_table_compact(table);
+            }
+        }
+    }
+
+    return LIBDBO_OK;
+}
+
+static int libdbo_backend_memory_transaction_rollback(void* data) {
+    libdbo_backend_memory_t* backend_memory = (libdbo_backend_memory_t*)data;
+    libdbo_backend_memory_undo_t* undo;
+    libdbo_backend_memory_undo_t* savepoint;
+
+    if (!__memory_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_memory) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_memory->transaction) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    backend_memory->transaction--;
+    savepoint = backend_memory->savepoints[backend_memory->transaction];
+    while ((undo = backend_memory->undo_list) && undo != savepoint) {
+        backend_memory->undo_list = undo->next;
+        __db_backend_memory_undo_revert(undo);
+    }
+
+    return LIBDBO_OK;
+}
+
+libdbo_backend_handle_t* libdbo_backend_memory_new_handle(void) {
+    libdbo_backend_handle_t* backend_handle = NULL;
+    libdbo_backend_memory_t* backend_memory =
+        (libdbo_backend_memory_t*)libdbo_mm_new0(&__memory_alloc);
+
+    if (backend_memory && (backend_handle = libdbo_backend_handle_new())) {
+        if (libdbo_backend_handle_set_data(backend_handle, (void*)backend_memory)
+            || libdbo_backend_handle_set_initialize(backend_handle, libdbo_backend_memory_initialize)
+            || libdbo_backend_handle_set_shutdown(backend_handle, libdbo_backend_memory_shutdown)
+            || libdbo_backend_handle_set_connect(backend_handle, libdbo_backend_memory_connect)
+            || libdbo_backend_handle_set_disconnect(backend_handle, libdbo_backend_memory_disconnect)
+            || libdbo_backend_handle_set_create(backend_handle, libdbo_backend_memory_create)
+            || libdbo_backend_handle_set_read(backend_handle, libdbo_backend_memory_read)
+            || libdbo_backend_handle_set_update(backend_handle, libdbo_backend_memory_update)
+            || libdbo_backend_handle_set_delete(backend_handle, libdbo_backend_memory_delete)
+            || libdbo_backend_handle_set_count(backend_handle, libdbo_backend_memory_count)
+            || libdbo_backend_handle_set_upsert(backend_handle, libdbo_backend_memory_upsert)
+            || libdbo_backend_handle_set_free(backend_handle, libdbo_backend_memory_free)
+            || libdbo_backend_handle_set_transaction_begin(backend_handle, libdbo_backend_memory_transaction_begin)
+            || libdbo_backend_handle_set_transaction_commit(backend_handle, libdbo_backend_memory_transaction_commit)
+            || libdbo_backend_handle_set_transaction_rollback(backend_handle, libdbo_backend_memory_transaction_rollback))
+        {
+            libdbo_backend_handle_free(backend_handle);
+            libdbo_mm_delete(&__memory_alloc, backend_memory);
+            return NULL;
+        }
+    }
+    return backend_handle;
+}
@@ -33,11 +33,14 @@
  * All rights reserved.
  */
 
+#include "config.h"
+
 #include "libdbo/backend/mysql.h"
 
 #include "libdbo/error.h"
 #include "libdbo/mm.h"
 #include "libdbo/log.h"
+#include "libdbo/trace.h"
 
 #include <mysql/mysql.h>
 #include <stdlib.h>
@@ -47,6 +50,7 @@
 #include <time.h>
 #include <pthread.h>
 #include <errno.h>
+#include <stdarg.h>
 
 static int libdbo_backend_mysql_transaction_rollback(void*);
 
@@ -55,13 +59,47 @@ static int libdbo_backend_mysql_transaction_rollback(void*);
  */
 static int __mysql_initialized = 0;
 
+/**
+ * The types of SQL templates that are cached per object.
+ */
+#define LIBDBO_BACKEND_MYSQL_TEMPLATE_SELECT 1
+#define LIBDBO_BACKEND_MYSQL_TEMPLATE_INSERT 2
+#define LIBDBO_BACKEND_MYSQL_TEMPLATE_UPDATE 3
+
+/**
+ * A cached SQL template, the static part of the SQL for an operation on a
+ * table with a specific set of fields. The fields are stored comma separated
+ * and are used together with the type, table and revision field to find the
+ * template.
+ */
+typedef struct libdbo_backend_mysql_template libdbo_backend_mysql_template_t;
+struct libdbo_backend_mysql_template {
+    libdbo_backend_mysql_template_t* next;
+    int type;
+    char* table;
+    char* fields;
+    char* revision;
+    char* sql;
+    size_t length;
+    int fields_size;
+};
+
+static libdbo_mm_t __mysql_template_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_backend_mysql_template_t));
+
 /**
  * The MySQL database backend specific data.
  */
 typedef struct libdbo_backend_mysql {
     MYSQL* db;
+    /** The depth of nested transactions, zero if none. */
     int transaction;
     unsigned int timeout;
+    /** Statements taking at least this many microseconds are logged, 0 if not. */
+    unsigned long slow_query;
+    /** If the values bound to a slow statement are left out of the log. */
+    int slow_query_redact;
+    /** The cached SQL templates. */
+    libdbo_backend_mysql_template_t* template_list;
 } libdbo_backend_mysql_t;
 
 static libdbo_mm_t __mysql_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_backend_mysql_t));
@@ -95,10 +133,334 @@ typedef struct libdbo_backend_mysql_statement {
     libdbo_object_field_list_t* object_field_list;
     int fields;
     int bound;
+    /**
+     * A copy of the SQL, only kept for the slow query log or if a tracing
+     * hook is set.
+     */
+    char* sql;
+    /** The SQL with the values of a slow statement, explained on finish. */
+    char* explain;
 } libdbo_backend_mysql_statement_t;
 
 static libdbo_mm_t __mysql_statement_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_backend_mysql_statement_t));
 
+/**
+ * The initial size of the SQL buffer, this is kept on the stack and only SQL
+ * larger then this will be allocated.
+ */
+#define LIBDBO_BACKEND_MYSQL_SQL_SIZE 1024
+
+/**
+ * A growable buffer used to build SQL.
+ */
+typedef struct libdbo_backend_mysql_sql {
+    char* string;
+    size_t length;
+    size_t size;
+    char buffer[LIBDBO_BACKEND_MYSQL_SQL_SIZE];
+} libdbo_backend_mysql_sql_t;
+
+/**
+ * Initialize a SQL buffer.
+ */
+static inline void __db_backend_mysql_sql_init(libdbo_backend_mysql_sql_t* sql) {
+    sql->string = sql->buffer;
+    sql->length = 0;
+    sql->size = sizeof(sql->buffer);
+    sql->buffer[0] = 0;
+}
+
+/**
+ * Release any memory allocated by a SQL buffer.
+ */
+static inline void __db_backend_mysql_sql_reset(libdbo_backend_mysql_sql_t* sql) {
+    if (sql->string != sql->buffer) {
+        free(sql->string);
+    }
+    __db_backend_mysql_sql_init(sql);
+}
+
+/**
+ * Append one or more strings to a SQL buffer, the list of strings must be
+ * terminated by a NULL.
+ */
+static int __db_backend_mysql_sql_append(libdbo_backend_mysql_sql_t* sql, ...) {
+    va_list ap;
+    const char* string;
+    size_t length, size;
+    char* new_string;
+
+    if (!sql) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    va_start(ap, sql);
+    while ((string = va_arg(ap, const char*))) {
+        length = strlen(string);
+        if (sql->length + length >= sql->size) {
+            size = sql->size * 2;
+            while (sql->length + length >= size) {
+                size *= 2;
+            }
+            if (sql->string == sql->buffer) {
+                if ((new_string = malloc(size))) {
+                    memcpy(new_string, sql->buffer, sql->length + 1);
+                }
+            }
+            else {
+                new_string = realloc(sql->string, size);
+            }
+            if (!new_string) {
+                va_end(ap);
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            sql->string = new_string;
+            sql->size = size;
+        }
+        memcpy(sql->string + sql->length, string, length + 1);
+        sql->length += length;
+    }
+    va_end(ap);
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Free all the cached SQL templates.
+ */
+static void __db_backend_mysql_template_free(libdbo_backend_mysql_t* backend_mysql) {
+    libdbo_backend_mysql_template_t* template;
+
+    while ((template = backend_mysql->template_list)) {
+        backend_mysql->template_list = template->next;
+        free(template->table);
+        free(template->fields);
+        free(template->revision);
+        free(template->sql);
+        libdbo_mm_delete(&__mysql_template_alloc, template);
+    }
+}
+
+/**
+ * Check if a template matches the fields in `object_field_list`.
+ */
+static int __db_backend_mysql_template_match(const libdbo_backend_mysql_template_t* template, const libdbo_object_field_list_t* object_field_list) {
+    const libdbo_object_field_t* object_field;
+    const char* fields = template->fields;
+    size_t length;
+
+    object_field = libdbo_object_field_list_begin(object_field_list);
+    while (object_field) {
+        length = strlen(libdbo_object_field_name(object_field));
+        if (strncmp(fields, libdbo_object_field_name(object_field), length)) {
+            return 0;
+        }
+        fields += length;
+        if (*fields == ',') {
+            fields++;
+        }
+        else if (*fields) {
+            return 0;
+        }
+        object_field = libdbo_object_field_next(object_field);
+    }
+
+    return !*fields;
+}
+
+/**
+ * Get the SQL template of type `type` for the object with the fields in
+ * `object_field_list` and the revision field `revision_field`, the template is
+ * created and cached if it does not already exist.
+ * \param[in] backend_mysql a libdbo_backend_mysql_t pointer.
+ * \param[in] type an integer.
+ * \param[in] object a libdbo_object_t pointer.
+ * \param[in] object_field_list a libdbo_object_field_list_t pointer.
+ * \param[in] revision_field a libdbo_object_field_t pointer or NULL.
+ * \return a libdbo_backend_mysql_template_t pointer or NULL on error.
+ */
+static const libdbo_backend_mysql_template_t* __db_backend_mysql_template(libdbo_backend_mysql_t* backend_mysql, int type, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_object_field_t* revision_field) {
+    libdbo_backend_mysql_template_t* template;
+    const libdbo_object_field_t* object_field;
+    const char* table = libdbo_object_table(object);
+    const char* revision = revision_field ? libdbo_object_field_name(revision_field) : NULL;
+    libdbo_backend_mysql_sql_t sql;
+    libdbo_backend_mysql_sql_t fields;
+    int first, fields_size, ret;
+
+    for (template = backend_mysql->template_list; template; template = template->next) {
+        if (template->type == type
+            && !strcmp(template->table, table)
+            && (revision ? (template->revision && !strcmp(template->revision, revision)) : !template->revision)
+            && __db_backend_mysql_template_match(template, object_field_list))
+        {
+            return template;
+        }
+    }
+
+    __db_backend_mysql_sql_init(&sql);
+    __db_backend_mysql_sql_init(&fields);
+    ret = LIBDBO_OK;
+
+    switch (type) {
+    case LIBDBO_BACKEND_MYSQL_TEMPLATE_SELECT:
+        ret = __db_backend_mysql_sql_append(&sql, "SELECT", NULL);
+        break;
+
+    case LIBDBO_BACKEND_MYSQL_TEMPLATE_INSERT:
+        if (!libdbo_object_field_list_begin(object_field_list) && !revision) {
+            /*
+             * Special case when tables has no fields except maybe a primary key.
+             */
+            ret = __db_backend_mysql_sql_append(&sql, "INSERT INTO ", table, " () VALUES ()", NULL);
+        }
+        else {
+            ret = __db_backend_mysql_sql_append(&sql, "INSERT INTO ", table, " (", NULL);
+        }
+        break;
+
+    case LIBDBO_BACKEND_MYSQL_TEMPLATE_UPDATE:
+        ret = __db_backend_mysql_sql_append(&sql, "UPDATE ", table, " SET", NULL);
+        break;
+
+    default:
+        return NULL;
+    }
+
+    object_field = libdbo_object_field_list_begin(object_field_list);
+    first = 1;
+    fields_size = 0;
+    while (!ret && object_field) {
+        switch (type) {
+        case LIBDBO_BACKEND_MYSQL_TEMPLATE_SELECT:
+            ret = __db_backend_mysql_sql_append(&sql, first ? " " : ", ", table, ".", libdbo_object_field_name(object_field), NULL);
+            break;
+
+        case LIBDBO_BACKEND_MYSQL_TEMPLATE_INSERT:
+            ret = __db_backend_mysql_sql_append(&sql, first ? " " : ", ", libdbo_object_field_name(object_field), NULL);
+            break;
+
+        case LIBDBO_BACKEND_MYSQL_TEMPLATE_UPDATE:
+            ret = __db_backend_mysql_sql_append(&sql, first ? " " : ", ", libdbo_object_field_name(object_field), " = ?", NULL);
+            break;
+        }
+        if (!ret) {
+            ret = __db_backend_mysql_sql_append(&fields, first ? "" : ",", libdbo_object_field_name(object_field), NULL);
+        }
+        first = 0;
+        fields_size++;
+
+        object_field = libdbo_object_field_next(object_field);
+    }
+
+    switch (type) {
+    case LIBDBO_BACKEND_MYSQL_TEMPLATE_SELECT:
+        if (!ret) {
+            ret = __db_backend_mysql_sql_append(&sql, " FROM ", table, NULL);
+        }
+        break;
+
+    case LIBDBO_BACKEND_MYSQL_TEMPLATE_INSERT:
+        if (!libdbo_object_field_list_begin(object_field_list) && !revision) {
+            break;
+        }
+        if (!ret && revision) {
+            ret = __db_backend_mysql_sql_append(&sql, first ? " " : ", ", revision, NULL);
+        }
+        if (!ret) {
+            ret = __db_backend_mysql_sql_append(&sql, " ) VALUES (", NULL);
+        }
+        for (first = 0; !ret && first < fields_size + (revision ? 1 : 0); first++) {
+            ret = __db_backend_mysql_sql_append(&sql, first ? ", ?" : " ?", NULL);
+        }
+        if (!ret) {
+            ret = __db_backend_mysql_sql_append(&sql, " )", NULL);
+        }
+        break;
+
+    case LIBDBO_BACKEND_MYSQL_TEMPLATE_UPDATE:
+        if (!ret && revision) {
+            ret = __db_backend_mysql_sql_append(&sql, first ? " " : ", ", revision, " = ?", NULL);
+        }
+        break;
+    }
+
+    if (ret
+        || !(template = libdbo_mm_new0(&__mysql_template_alloc))
+        || !(template->table = strdup(table))
+        || !(template->fields = strdup(fields.string))
+        || (revision && !(template->revision = strdup(revision)))
+        || !(template->sql = strdup(sql.string)))
+    {
+        if (template) {
+            free(template->table);
+            free(template->fields);
+            free(template->revision);
+            libdbo_mm_delete(&__mysql_template_alloc, template);
+        }
+        __db_backend_mysql_sql_reset(&sql);
+        __db_backend_mysql_sql_reset(&fields);
+        return NULL;
+    }
+    template->type = type;
+    template->length = sql.length;
+    template->fields_size = fields_size;
+    template->next = backend_mysql->template_list;
+    backend_mysql->template_list = template;
+
+    __db_backend_mysql_sql_reset(&sql);
+    __db_backend_mysql_sql_reset(&fields);
+    return template;
+}
+
+/**
+ * Log the query plan MySQL uses for the SQL `sql`, the SQL must have all
+ * values in it since EXPLAIN is done with the text protocol.
+ */
+static void __db_backend_mysql_explain(libdbo_backend_mysql_t* backend_mysql, const char* sql) {
+    libdbo_backend_mysql_sql_t explain;
+    MYSQL_RES* result;
+    MYSQL_FIELD* fields;
+    MYSQL_ROW row;
+    unsigned int i, num_fields;
+
+    if (!backend_mysql || !backend_mysql->db) {
+        return;
+    }
+
+    __db_backend_mysql_sql_init(&explain);
+    if (__db_backend_mysql_sql_append(&explain, "EXPLAIN ", sql, NULL)
+        || mysql_real_query(backend_mysql->db, explain.string, explain.length)
+        || !(result = mysql_store_result(backend_mysql->db)))
+    {
+        libdbo_log(LIBDBO_LOG_WARNING, "MySQL slow query plan error %u: %s",
+            mysql_errno(backend_mysql->db), mysql_error(backend_mysql->db));
+        __db_backend_mysql_sql_reset(&explain);
+        return;
+    }
+
+    num_fields = mysql_num_fields(result);
+    fields = mysql_fetch_fields(result);
+    __db_backend_mysql_sql_reset(&explain);
+    for (i = 0; i < num_fields; i++) {
+        if (__db_backend_mysql_sql_append(&explain, i ? " | " : "", fields[i].name, NULL)) {
+            break;
+        }
+    }
+    libdbo_log(LIBDBO_LOG_WARNING, "MySQL slow query plan: %s", explain.string);
+    while ((row = mysql_fetch_row(result))) {
+        __db_backend_mysql_sql_reset(&explain);
+        for (i = 0; i < num_fields; i++) {
+            if (__db_backend_mysql_sql_append(&explain, i ? " | " : "", row[i] ? row[i] : "NULL", NULL)) {
+                break;
+            }
+        }
+        libdbo_log(LIBDBO_LOG_WARNING, "MySQL slow query plan: %s", explain.string);
+    }
+    mysql_free_result(result);
+    __db_backend_mysql_sql_reset(&explain);
+}
+
 /**
  * MySQL finish function.
  *
@@ -114,6 +476,14 @@ static inline void __db_backend_mysql_finish(libdbo_backend_mysql_statement_t* s
     if (statement->statement) {
         mysql_stmt_close(statement->statement);
     }
+    if (statement->explain) {
+        /*
+         * The plan of a slow statement is only asked for now since the
+         * connection can not be used while a result is pending.
+         */
+        __db_backend_mysql_explain(statement->backend_mysql, statement->explain);
+        free(statement->explain);
+    }
     if (statement->mysql_bind_input) {
         free(statement->mysql_bind_input);
     }
@@ -136,6 +506,7 @@ static inline void __db_backend_mysql_finish(libdbo_backend_mysql_statement_t* s
     if (statement->object_field_list) {
         libdbo_object_field_list_free(statement->object_field_list);
     }
+    free(statement->sql);
 
     libdbo_mm_delete(&__mysql_statement_alloc, statement);
 }
@@ -188,6 +559,18 @@ static inline int __db_backend_mysql_prepare(libdbo_backend_mysql_t* backend_mys
 
     (*statement)->backend_mysql = backend_mysql;
 
+    /*
+     * MySQL can not give back the SQL of a prepared statement so keep a copy
+     * for the slow query log and the tracing hook, the SQL is gone by the
+     * time it is executed.
+     */
+    if ((backend_mysql->slow_query || LIBDBO_TRACE_HOOKED())
+        && ((*statement)->sql = malloc(size + 1)))
+    {
+        memcpy((*statement)->sql, sql, size);
+        (*statement)->sql[size] = 0;
+    }
+
     /*
      * Create the input binding based on the number of parameters in the SQL
      * statement.
@@ -599,18 +982,115 @@ static inline int __db_backend_mysql_fetch(libdbo_backend_mysql_statement_t* sta
     return LIBDBO_OK;
 }
 
+/**
+ * Append the value bound by `bind` to `sql` as a SQL literal.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_mysql_sql_append_bind(libdbo_backend_mysql_t* backend_mysql, libdbo_backend_mysql_sql_t* sql, const MYSQL_BIND* bind) {
+    char number[32];
+    char* escaped;
+    int ret;
+
+    switch (bind->buffer_type) {
+    case MYSQL_TYPE_LONG:
+        if (bind->is_unsigned) {
+            snprintf(number, sizeof(number), "%lu", (unsigned long)*(const libdbo_type_uint32_t*)bind->buffer);
+        }
+        else {
+            snprintf(number, sizeof(number), "%ld", (long)*(const libdbo_type_int32_t*)bind->buffer);
+        }
+        return __db_backend_mysql_sql_append(sql, number, NULL);
+
+    case MYSQL_TYPE_LONGLONG:
+        if (bind->is_unsigned) {
+            snprintf(number, sizeof(number), "%llu", (unsigned long long)*(const libdbo_type_uint64_t*)bind->buffer);
+        }
+        else {
+            snprintf(number, sizeof(number), "%lld", (long long)*(const libdbo_type_int64_t*)bind->buffer);
+        }
+        return __db_backend_mysql_sql_append(sql, number, NULL);
+
+    case MYSQL_TYPE_STRING:
+        if (!(escaped = malloc(bind->buffer_length * 2 + 1))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        mysql_real_escape_string(backend_mysql->db, escaped, (const char*)bind->buffer, bind->buffer_length);
+        ret = __db_backend_mysql_sql_append(sql, "'", escaped, "'", NULL);
+        free(escaped);
+        return ret;
+
+    default:
+        break;
+    }
+
+    return __db_backend_mysql_sql_append(sql, "NULL", NULL);
+}
+
+/**
+ * Log a statement that was slow to execute. The SQL with the values put in
+ * place of the parameters is kept so the statement can be explained when it
+ * is finished.
+ */
+static void __db_backend_mysql_slow_query(libdbo_backend_mysql_statement_t* statement, unsigned long usec) {
+    libdbo_backend_mysql_bind_t* bind = statement->bind_input;
+    libdbo_backend_mysql_sql_t sql;
+    const char* c;
+    char part[2] = { 0, 0 };
+    int ret = LIBDBO_OK;
+
+    if (!statement->sql) {
+        return;
+    }
+
+    __db_backend_mysql_sql_init(&sql);
+    for (c = statement->sql; *c && !ret; c++) {
+        if (*c == '?' && bind) {
+            ret = __db_backend_mysql_sql_append_bind(statement->backend_mysql, &sql, bind->bind);
+            bind = bind->next;
+        }
+        else {
+            part[0] = *c;
+            ret = __db_backend_mysql_sql_append(&sql, part, NULL);
+        }
+    }
+
+    if (ret || statement->backend_mysql->slow_query_redact) {
+        libdbo_log(LIBDBO_LOG_WARNING, "MySQL slow query %lu.%03lu ms: %s (%lu values not shown)",
+            usec / 1000, usec % 1000, statement->sql, mysql_stmt_param_count(statement->statement));
+    }
+    else {
+        libdbo_log(LIBDBO_LOG_WARNING, "MySQL slow query %lu.%03lu ms: %s",
+            usec / 1000, usec % 1000, sql.string);
+    }
+
+    if (!ret && !statement->explain) {
+        statement->explain = strdup(sql.string);
+    }
+    __db_backend_mysql_sql_reset(&sql);
+}
+
 /**
  * MySQL execute function.
  *
  * Execute a prepared statement in the libdbo_backend_mysql_statement_t.
+ * Statements slower than the `slow_query` configuration are logged.
  */
-static inline int __db_backend_mysql_execute(libdbo_backend_mysql_statement_t* statement) {
+static inline int __db_backend_mysql_execute(libdbo_backend_mysql_statement_t* statement, libdbo_stats_operation_t operation, const libdbo_object_t* object) {
+    libdbo_trace_event_t event;
+    struct timespec start, end;
+    unsigned long usec;
+    int traced;
+    int ret;
+
     if (!statement) {
         return LIBDBO_ERROR_UNKNOWN;
     }
     if (!statement->statement) {
         return LIBDBO_ERROR_UNKNOWN;
     }
+    if (!statement->backend_mysql) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
 
     /*
      * Bind the input parameters.
@@ -626,7 +1106,26 @@ static inline int __db_backend_mysql_execute(libdbo_backend_mysql_statement_t* s
     /*
      * Execute the statement.
      */
-    if (mysql_stmt_execute(statement->statement)) {
+    if (statement->backend_mysql->slow_query) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+    }
+    traced = LIBDBO_TRACE_CALL_BEGIN(&event, "mysql", operation,
+        object ? libdbo_object_table(object) : NULL, statement->sql,
+        mysql_stmt_param_count(statement->statement));
+    ret = mysql_stmt_execute(statement->statement);
+    if (traced) {
+        LIBDBO_TRACE_CALL_END(&event,
+            !ret && !mysql_stmt_field_count(statement->statement) ? (unsigned long long)mysql_stmt_affected_rows(statement->statement) : 0,
+            ret ? LIBDBO_ERROR_UNKNOWN : LIBDBO_OK);
+    }
+    if (statement->backend_mysql->slow_query) {
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        usec = (end.tv_sec - start.tv_sec) * 1000000 + (end.tv_nsec - start.tv_nsec) / 1000;
+        if (usec >= statement->backend_mysql->slow_query) {
+            __db_backend_mysql_slow_query(statement, usec);
+        }
+    }
+    if (ret) {
         libdbo_log(LIBDBO_LOG_ERROR, "MySQL execute statement error %d: %s",
             mysql_stmt_errno(statement->statement), mysql_stmt_error(statement->statement));
         return LIBDBO_ERROR_UNKNOWN;
@@ -673,6 +1172,8 @@ static int libdbo_backend_mysql_connect(void* data, const libdbo_configuration_l
     const libdbo_configuration_t* db;
     const libdbo_configuration_t* port_configuration;
     const libdbo_configuration_t* timeout_configuration;
+    const libdbo_configuration_t* slow_query;
+    double slow_query_ms;
     int timeout;
     unsigned int port = 0;
 
@@ -709,6 +1210,22 @@ static int libdbo_backend_mysql_connect(void* data, const libdbo_configuration_l
         }
     }
 
+    backend_mysql->slow_query = 0;
+    if ((slow_query = libdbo_configuration_list_find(configuration_list, "slow_query"))
+        && (slow_query_ms = strtod(libdbo_configuration_value(slow_query), NULL)) > 0)
+    {
+        backend_mysql->slow_query = slow_query_ms * 1000;
+        if (!backend_mysql->slow_query) {
+            backend_mysql->slow_query = 1;
+        }
+    }
+    backend_mysql->slow_query_redact = 0;
+    if ((slow_query = libdbo_configuration_list_find(configuration_list, "slow_query_redact"))
+        && atoi(libdbo_configuration_value(slow_query)))
+    {
+        backend_mysql->slow_query_redact = 1;
+    }
+
     if (!(backend_mysql->db = mysql_init(NULL))
         || mysql_options(backend_mysql->db, MYSQL_OPT_CONNECT_TIMEOUT, &backend_mysql->timeout)
         || !mysql_real_connect(backend_mysql->db,
@@ -747,6 +1264,11 @@ static int libdbo_backend_mysql_disconnect(void* data) {
     }
 
     if (backend_mysql->transaction) {
+        /*
+         * Rolling back the outer most transaction also discards all the
+         * nested ones.
+         */
+        backend_mysql->transaction = 1;
         libdbo_backend_mysql_transaction_rollback(backend_mysql);
     }
 
@@ -757,31 +1279,21 @@ static int libdbo_backend_mysql_disconnect(void* data) {
 }
 
 /**
- * Build the clause/WHERE SQL and append it to `sqlp`, how much that is left in
- * the buffer pointed by `sqlp` is specified by `left`.
+ * Build the clause/WHERE SQL and append it to the SQL buffer `sql`.
  * \param[in] object a libdbo_object_t pointer.
  * \param[in] clause_list a libdbo_clause_list_t pointer.
- * \param[in] sqlp a character pointer pointer.
- * \param[in] left an integer pointer.
+ * \param[in] sql a libdbo_backend_mysql_sql_t pointer.
  * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
  */
-static int __db_backend_mysql_build_clause(const libdbo_object_t* object, const libdbo_clause_list_t* clause_list, char** sqlp, int* left) {
+static int __db_backend_mysql_build_clause(const libdbo_object_t* object, const libdbo_clause_list_t* clause_list, libdbo_backend_mysql_sql_t* sql) {
     const libdbo_clause_t* clause;
+    const char* table;
     int first, ret;
 
     if (!clause_list) {
         return LIBDBO_ERROR_UNKNOWN;
     }
-    if (!sqlp) {
-        return LIBDBO_ERROR_UNKNOWN;
-    }
-    if (!*sqlp) {
-        return LIBDBO_ERROR_UNKNOWN;
-    }
-    if (!left) {
-        return LIBDBO_ERROR_UNKNOWN;
-    }
-    if (*left < 1) {
+    if (!sql) {
         return LIBDBO_ERROR_UNKNOWN;
     }
 
@@ -794,116 +1306,70 @@ static int __db_backend_mysql_build_clause(const libdbo_object_t* object, const
         else {
             switch (libdbo_clause_operator(clause)) {
             case LIBDBO_CLAUSE_OPERATOR_AND:
-                if ((ret = snprintf(*sqlp, *left, " AND")) >= *left) {
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
+                ret = __db_backend_mysql_sql_append(sql, " AND", NULL);
                 break;
 
             case LIBDBO_CLAUSE_OPERATOR_OR:
-                if ((ret = snprintf(*sqlp, *left, " OR")) >= *left) {
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
+                ret = __db_backend_mysql_sql_append(sql, " OR", NULL);
                 break;
 
             default:
                 return LIBDBO_ERROR_UNKNOWN;
             }
-            *sqlp += ret;
-            *left -= ret;
+            if (ret) {
+                return ret;
+            }
         }
 
+        table = libdbo_clause_table(clause) ? libdbo_clause_table(clause) : libdbo_object_table(object);
         switch (libdbo_clause_type(clause)) {
         case LIBDBO_CLAUSE_EQUAL:
-            if ((ret = snprintf(*sqlp, *left, " %s.%s = ?",
-                (libdbo_clause_table(clause) ? libdbo_clause_table(clause) : libdbo_object_table(object)),
-                libdbo_clause_field(clause))) >= *left)
-            {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
+            ret = __db_backend_mysql_sql_append(sql, " ", table, ".", libdbo_clause_field(clause), " = ?", NULL);
             break;
 
         case LIBDBO_CLAUSE_NOT_EQUAL:
-            if ((ret = snprintf(*sqlp, *left, " %s.%s != ?",
-                (libdbo_clause_table(clause) ? libdbo_clause_table(clause) : libdbo_object_table(object)),
-                libdbo_clause_field(clause))) >= *left)
-            {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
+            ret = __db_backend_mysql_sql_append(sql, " ", table, ".", libdbo_clause_field(clause), " != ?", NULL);
             break;
 
         case LIBDBO_CLAUSE_LESS_THEN:
-            if ((ret = snprintf(*sqlp, *left, " %s.%s < ?",
-                (libdbo_clause_table(clause) ? libdbo_clause_table(clause) : libdbo_object_table(object)),
-                libdbo_clause_field(clause))) >= *left)
-            {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
+            ret = __db_backend_mysql_sql_append(sql, " ", table, ".", libdbo_clause_field(clause), " < ?", NULL);
             break;
 
         case LIBDBO_CLAUSE_LESS_OR_EQUAL:
-            if ((ret = snprintf(*sqlp, *left, " %s.%s <= ?",
-                (libdbo_clause_table(clause) ? libdbo_clause_table(clause) : libdbo_object_table(object)),
-                libdbo_clause_field(clause))) >= *left)
-            {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
+            ret = __db_backend_mysql_sql_append(sql, " ", table, ".", libdbo_clause_field(clause), " <= ?", NULL);
             break;
 
         case LIBDBO_CLAUSE_GREATER_OR_EQUAL:
-            if ((ret = snprintf(*sqlp, *left, " %s.%s >= ?",
-                (libdbo_clause_table(clause) ? libdbo_clause_table(clause) : libdbo_object_table(object)),
-                libdbo_clause_field(clause))) >= *left)
-            {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
+            ret = __db_backend_mysql_sql_append(sql, " ", table, ".", libdbo_clause_field(clause), " >= ?", NULL);
             break;
 
         case LIBDBO_CLAUSE_GREATER_THEN:
-            if ((ret = snprintf(*sqlp, *left, " %s.%s > ?",
-                (libdbo_clause_table(clause) ? libdbo_clause_table(clause) : libdbo_object_table(object)),
-                libdbo_clause_field(clause))) >= *left)
-            {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
+            ret = __db_backend_mysql_sql_append(sql, " ", table, ".", libdbo_clause_field(clause), " > ?", NULL);
             break;
 
         case LIBDBO_CLAUSE_IS_NULL:
-            if ((ret = snprintf(*sqlp, *left, " %s.%s IS NULL",
-                (libdbo_clause_table(clause) ? libdbo_clause_table(clause) : libdbo_object_table(object)),
-                libdbo_clause_field(clause))) >= *left)
-            {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
+            ret = __db_backend_mysql_sql_append(sql, " ", table, ".", libdbo_clause_field(clause), " IS NULL", NULL);
             break;
 
         case LIBDBO_CLAUSE_IS_NOT_NULL:
-            if ((ret = snprintf(*sqlp, *left, " %s.%s IS NOT NULL",
-                (libdbo_clause_table(clause) ? libdbo_clause_table(clause) : libdbo_object_table(object)),
-                libdbo_clause_field(clause))) >= *left)
-            {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
+            ret = __db_backend_mysql_sql_append(sql, " ", table, ".", libdbo_clause_field(clause), " IS NOT NULL", NULL);
             break;
 
         case LIBDBO_CLAUSE_NESTED:
-            if ((ret = snprintf(*sqlp, *left, " (")) >= *left) {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            *sqlp += ret;
-            *left -= ret;
-            if (__db_backend_mysql_build_clause(object, libdbo_clause_list(clause), sqlp, left)) {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            if ((ret = snprintf(*sqlp, *left, " )")) >= *left) {
-                return LIBDBO_ERROR_UNKNOWN;
+            if ((ret = __db_backend_mysql_sql_append(sql, " (", NULL))
+                || (ret = __db_backend_mysql_build_clause(object, libdbo_clause_list(clause), sql)))
+            {
+                return ret;
             }
+            ret = __db_backend_mysql_sql_append(sql, " )", NULL);
             break;
 
         default:
             return LIBDBO_ERROR_UNKNOWN;
         }
-        *sqlp += ret;
-        *left -= ret;
+        if (ret) {
+            return ret;
+        }
 
         clause = libdbo_clause_next(clause);
     }
@@ -1309,9 +1775,7 @@ static int libdbo_backend_mysql_create(void* data, const libdbo_object_t* object
     libdbo_backend_mysql_t* backend_mysql = (libdbo_backend_mysql_t*)data;
     const libdbo_object_field_t* object_field;
     const libdbo_object_field_t* revision_field = NULL;
-    char sql[4*1024];
-    char* sqlp;
-    int ret, left, first;
+    const libdbo_backend_mysql_template_t* template;
     libdbo_backend_mysql_statement_t* statement = NULL;
     libdbo_backend_mysql_bind_t* bind;
     libdbo_value_t revision = LIBDBO_VALUE_EMPTY;
@@ -1350,133 +1814,18 @@ static int libdbo_backend_mysql_create(void* data, const libdbo_object_t* object
         object_field = libdbo_object_field_next(object_field);
     }
 
-    left = sizeof(sql);
-    sqlp = sql;
-
-    if (!libdbo_object_field_list_begin(object_field_list) && !revision_field) {
-        /*
-         * Special case when tables has no fields except maybe a primary key.
-         */
-        if ((ret = snprintf(sqlp, left, "INSERT INTO %s () VALUES ()", libdbo_object_table(object))) >= left) {
-            return LIBDBO_ERROR_UNKNOWN;
-        }
-        sqlp += ret;
-        left -= ret;
-    }
-    else {
-        if ((ret = snprintf(sqlp, left, "INSERT INTO %s (", libdbo_object_table(object))) >= left) {
-            return LIBDBO_ERROR_UNKNOWN;
-        }
-        sqlp += ret;
-        left -= ret;
-
-        /*
-         * Add the fields from the given object_field_list.
-         */
-        object_field = libdbo_object_field_list_begin(object_field_list);
-        first = 1;
-        while (object_field) {
-            if (first) {
-                if ((ret = snprintf(sqlp, left, " %s", libdbo_object_field_name(object_field))) >= left) {
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
-                first = 0;
-            }
-            else {
-                if ((ret = snprintf(sqlp, left, ", %s", libdbo_object_field_name(object_field))) >= left) {
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
-            }
-            sqlp += ret;
-            left -= ret;
-
-            object_field = libdbo_object_field_next(object_field);
-        }
-
-        /*
-         * Add the revision field if we have one.
-         */
-        if (revision_field) {
-            if (first) {
-                if ((ret = snprintf(sqlp, left, " %s", libdbo_object_field_name(revision_field))) >= left) {
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
-                first = 0;
-            }
-            else {
-                if ((ret = snprintf(sqlp, left, ", %s", libdbo_object_field_name(revision_field))) >= left) {
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
-            }
-            sqlp += ret;
-            left -= ret;
-        }
-
-        if ((ret = snprintf(sqlp, left, " ) VALUES (")) >= left) {
-            return LIBDBO_ERROR_UNKNOWN;
-        }
-        sqlp += ret;
-        left -= ret;
-
-        /*
-         * Mark all the fields for binding from the object_field_list.
-         */
-        object_field = libdbo_object_field_list_begin(object_field_list);
-        first = 1;
-        while (object_field) {
-            if (first) {
-                if ((ret = snprintf(sqlp, left, " ?")) >= left) {
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
-                first = 0;
-            }
-            else {
-                if ((ret = snprintf(sqlp, left, ", ?")) >= left) {
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
-            }
-            sqlp += ret;
-            left -= ret;
-
-            object_field = libdbo_object_field_next(object_field);
-        }
-
-        /*
-         * Mark revision field for binding if we have one.
-         */
-        if (revision_field) {
-            if (first) {
-                if ((ret = snprintf(sqlp, left, " ?")) >= left) {
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
-                first = 0;
-            }
-            else {
-                if ((ret = snprintf(sqlp, left, ", ?")) >= left) {
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
-            }
-            sqlp += ret;
-            left -= ret;
-        }
-
-        if ((ret = snprintf(sqlp, left, " )")) >= left) {
-            return LIBDBO_ERROR_UNKNOWN;
-        }
-        sqlp += ret;
-        left -= ret;
-    }
-
-    /*
-     * Prepare the SQL, create a MySQL statement.
-     */
-    if (__db_backend_mysql_prepare(backend_mysql, &statement, sql, strlen(sql), libdbo_object_object_field_list(object))
-        || !statement
-        || !(bind = statement->bind_input))
-    {
-        __db_backend_mysql_finish(statement);
-        return LIBDBO_ERROR_UNKNOWN;
-    }
+    /*
+     * Get the cached INSERT SQL for the fields and prepare it, create a MySQL
+     * statement.
+     */
+    if (!(template = __db_backend_mysql_template(backend_mysql, LIBDBO_BACKEND_MYSQL_TEMPLATE_INSERT, object, object_field_list, revision_field))
+        || __db_backend_mysql_prepare(backend_mysql, &statement, template->sql, template->length, libdbo_object_object_field_list(object))
+        || !statement
+        || !(bind = statement->bind_input))
+    {
+        __db_backend_mysql_finish(statement);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
 
     /*
      * Bind all the values from value_set.
@@ -1503,7 +1852,7 @@ static int libdbo_backend_mysql_create(void* data, const libdbo_object_t* object
     /*
      * Execute the SQL.
      */
-    if (__db_backend_mysql_execute(statement)
+    if (__db_backend_mysql_execute(statement, LIBDBO_STATS_CREATE, object)
         || mysql_stmt_affected_rows(statement->statement) != 1)
     {
         __db_backend_mysql_finish(statement);
@@ -1516,11 +1865,9 @@ static int libdbo_backend_mysql_create(void* data, const libdbo_object_t* object
 
 static libdbo_result_list_t* libdbo_backend_mysql_read(void* data, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list) {
     libdbo_backend_mysql_t* backend_mysql = (libdbo_backend_mysql_t*)data;
-    const libdbo_object_field_t* object_field;
     const libdbo_join_t* join;
-    char sql[4*1024];
-    char* sqlp;
-    int ret, left, first;
+    const libdbo_backend_mysql_template_t* template;
+    libdbo_backend_mysql_sql_t sql;
     libdbo_result_list_t* result_list;
     libdbo_backend_mysql_statement_t* statement = NULL;
     libdbo_backend_mysql_bind_t* bind;
@@ -1535,78 +1882,48 @@ static libdbo_result_list_t* libdbo_backend_mysql_read(void* data, const libdbo_
         return NULL;
     }
 
-    left = sizeof(sql);
-    sqlp = sql;
-
-    if ((ret = snprintf(sqlp, left, "SELECT")) >= left) {
+    if (!(template = __db_backend_mysql_template(backend_mysql, LIBDBO_BACKEND_MYSQL_TEMPLATE_SELECT, object, libdbo_object_object_field_list(object), NULL))) {
         return NULL;
     }
-    sqlp += ret;
-    left -= ret;
-
-    object_field = libdbo_object_field_list_begin(libdbo_object_object_field_list(object));
-    first = 1;
-    while (object_field) {
-        if (first) {
-            if ((ret = snprintf(sqlp, left, " %s.%s", libdbo_object_table(object), libdbo_object_field_name(object_field))) >= left) {
-                return NULL;
-            }
-            first = 0;
-        }
-        else {
-            if ((ret = snprintf(sqlp, left, ", %s.%s", libdbo_object_table(object), libdbo_object_field_name(object_field))) >= left) {
-                return NULL;
-            }
-        }
-        sqlp += ret;
-        left -= ret;
-
-        object_field = libdbo_object_field_next(object_field);
-    }
 
-    if ((ret = snprintf(sqlp, left, " FROM %s", libdbo_object_table(object))) >= left) {
+    __db_backend_mysql_sql_init(&sql);
+    if (__db_backend_mysql_sql_append(&sql, template->sql, NULL)) {
+        __db_backend_mysql_sql_reset(&sql);
         return NULL;
     }
-    sqlp += ret;
-    left -= ret;
 
     if (join_list) {
         join = libdbo_join_list_begin(join_list);
         while (join) {
-            if ((ret = snprintf(sqlp, left, " INNER JOIN %s ON %s.%s = %s.%s",
-                libdbo_join_to_table(join),
-                libdbo_join_to_table(join),
-                libdbo_join_to_field(join),
-                libdbo_join_from_table(join),
-                libdbo_join_from_field(join))) >= left)
+            if (__db_backend_mysql_sql_append(&sql, " INNER JOIN ", libdbo_join_to_table(join),
+                " ON ", libdbo_join_to_table(join), ".", libdbo_join_to_field(join),
+                " = ", libdbo_join_from_table(join), ".", libdbo_join_from_field(join), NULL))
             {
+                __db_backend_mysql_sql_reset(&sql);
                 return NULL;
             }
-            sqlp += ret;
-            left -= ret;
             join = libdbo_join_next(join);
         }
     }
 
     if (clause_list) {
-        if (libdbo_clause_list_begin(clause_list)) {
-            if ((ret = snprintf(sqlp, left, " WHERE")) >= left) {
-                return NULL;
-            }
-            sqlp += ret;
-            left -= ret;
-        }
-        if (__db_backend_mysql_build_clause(object, clause_list, &sqlp, &left)) {
+        if ((libdbo_clause_list_begin(clause_list)
+                && __db_backend_mysql_sql_append(&sql, " WHERE", NULL))
+            || __db_backend_mysql_build_clause(object, clause_list, &sql))
+        {
+            __db_backend_mysql_sql_reset(&sql);
             return NULL;
         }
     }
 
-    if (__db_backend_mysql_prepare(backend_mysql, &statement, sql, strlen(sql), libdbo_object_object_field_list(object))
+    if (__db_backend_mysql_prepare(backend_mysql, &statement, sql.string, sql.length, libdbo_object_object_field_list(object))
         || !statement)
     {
+        __db_backend_mysql_sql_reset(&sql);
         __db_backend_mysql_finish(statement);
         return NULL;
     }
+    __db_backend_mysql_sql_reset(&sql);
 
     bind = statement->bind_input;
 
@@ -1620,7 +1937,7 @@ static libdbo_result_list_t* libdbo_backend_mysql_read(void* data, const libdbo_
     /*
      * Execute the SQL.
      */
-    if (__db_backend_mysql_execute(statement)) {
+    if (__db_backend_mysql_execute(statement, LIBDBO_STATS_READ, object)) {
         __db_backend_mysql_finish(statement);
         return NULL;
     }
@@ -1642,9 +1959,8 @@ static int libdbo_backend_mysql_update(void* data, const libdbo_object_t* object
     const libdbo_clause_t* clause;
     const libdbo_clause_t* revision_clause = NULL;
     libdbo_type_int64_t revision_number = -1;
-    char sql[4*1024];
-    char* sqlp;
-    int ret, left, first;
+    const libdbo_backend_mysql_template_t* template;
+    libdbo_backend_mysql_sql_t sql;
     libdbo_backend_mysql_statement_t* statement = NULL;
     libdbo_backend_mysql_bind_t* bind;
     libdbo_value_t revision = LIBDBO_VALUE_EMPTY;
@@ -1736,69 +2052,24 @@ static int libdbo_backend_mysql_update(void* data, const libdbo_object_t* object
         }
     }
 
-    left = sizeof(sql);
-    sqlp = sql;
-
-    if ((ret = snprintf(sqlp, left, "UPDATE %s SET", libdbo_object_table(object))) >= left) {
-        return LIBDBO_ERROR_UNKNOWN;
-    }
-    sqlp += ret;
-    left -= ret;
-
     /*
-     * Build the update SQL from the object_field_list.
+     * Get the cached UPDATE SQL for the fields and build the clauses.
      */
-    object_field = libdbo_object_field_list_begin(object_field_list);
-    first = 1;
-    while (object_field) {
-        if (first) {
-            if ((ret = snprintf(sqlp, left, " %s = ?", libdbo_object_field_name(object_field))) >= left) {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            first = 0;
-        }
-        else {
-            if ((ret = snprintf(sqlp, left, ", %s = ?", libdbo_object_field_name(object_field))) >= left) {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-        }
-        sqlp += ret;
-        left -= ret;
-
-        object_field = libdbo_object_field_next(object_field);
+    if (!(template = __db_backend_mysql_template(backend_mysql, LIBDBO_BACKEND_MYSQL_TEMPLATE_UPDATE, object, object_field_list, revision_field))) {
+        return LIBDBO_ERROR_UNKNOWN;
     }
 
-    /*
-     * Add a new revision if we have any.
-     */
-    if (revision_field) {
-        if (first) {
-            if ((ret = snprintf(sqlp, left, " %s = ?", libdbo_object_field_name(revision_field))) >= left) {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            first = 0;
-        }
-        else {
-            if ((ret = snprintf(sqlp, left, ", %s = ?", libdbo_object_field_name(revision_field))) >= left) {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-        }
-        sqlp += ret;
-        left -= ret;
+    __db_backend_mysql_sql_init(&sql);
+    if (__db_backend_mysql_sql_append(&sql, template->sql, NULL)) {
+        __db_backend_mysql_sql_reset(&sql);
+        return LIBDBO_ERROR_UNKNOWN;
     }
-
-    /*
-     * Build the clauses.
-     */
     if (clause_list) {
-        if (libdbo_clause_list_begin(clause_list)) {
-            if ((ret = snprintf(sqlp, left, " WHERE")) >= left) {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            sqlp += ret;
-            left -= ret;
-        }
-        if (__db_backend_mysql_build_clause(object, clause_list, &sqlp, &left)) {
+        if ((libdbo_clause_list_begin(clause_list)
+                && __db_backend_mysql_sql_append(&sql, " WHERE", NULL))
+            || __db_backend_mysql_build_clause(object, clause_list, &sql))
+        {
+            __db_backend_mysql_sql_reset(&sql);
             return LIBDBO_ERROR_UNKNOWN;
         }
     }
@@ -1806,12 +2077,14 @@ static int libdbo_backend_mysql_update(void* data, const libdbo_object_t* object
     /*
      * Prepare the SQL.
      */
-    if (__db_backend_mysql_prepare(backend_mysql, &statement, sql, strlen(sql), libdbo_object_object_field_list(object))
+    if (__db_backend_mysql_prepare(backend_mysql, &statement, sql.string, sql.length, libdbo_object_object_field_list(object))
         || !statement)
     {
+        __db_backend_mysql_sql_reset(&sql);
         __db_backend_mysql_finish(statement);
         return LIBDBO_ERROR_UNKNOWN;
     }
+    __db_backend_mysql_sql_reset(&sql);
 
     bind = statement->bind_input;
 
@@ -1856,7 +2129,7 @@ static int libdbo_backend_mysql_update(void* data, const libdbo_object_t* object
     /*
      * Execute the SQL.
      */
-    if (__db_backend_mysql_execute(statement)) {
+    if (__db_backend_mysql_execute(statement, LIBDBO_STATS_UPDATE, object)) {
         __db_backend_mysql_finish(statement);
         return LIBDBO_ERROR_UNKNOWN;
     }
@@ -1868,7 +2141,7 @@ static int libdbo_backend_mysql_update(void* data, const libdbo_object_t* object
     if (revision_field) {
         if (mysql_stmt_affected_rows(statement->statement) < 1) {
             __db_backend_mysql_finish(statement);
-            return LIBDBO_ERROR_UNKNOWN;
+            return LIBDBO_ERROR_REVISION;
         }
     }
 
@@ -1878,9 +2151,7 @@ static int libdbo_backend_mysql_update(void* data, const libdbo_object_t* object
 
 static int libdbo_backend_mysql_delete(void* data, const libdbo_object_t* object, const libdbo_clause_list_t* clause_list) {
     libdbo_backend_mysql_t* backend_mysql = (libdbo_backend_mysql_t*)data;
-    char sql[4*1024];
-    char* sqlp;
-    int ret, left;
+    libdbo_backend_mysql_sql_t sql;
     const libdbo_object_field_t* revision_field = NULL;
     const libdbo_object_field_t* object_field;
     const libdbo_clause_t* clause;
@@ -1931,34 +2202,30 @@ static int libdbo_backend_mysql_delete(void* data, const libdbo_object_t* object
         }
     }
 
-    left = sizeof(sql);
-    sqlp = sql;
-
-    if ((ret = snprintf(sqlp, left, "DELETE FROM %s", libdbo_object_table(object))) >= left) {
+    __db_backend_mysql_sql_init(&sql);
+    if (__db_backend_mysql_sql_append(&sql, "DELETE FROM ", libdbo_object_table(object), NULL)) {
+        __db_backend_mysql_sql_reset(&sql);
         return LIBDBO_ERROR_UNKNOWN;
     }
-    sqlp += ret;
-    left -= ret;
 
     if (clause_list) {
-        if (libdbo_clause_list_begin(clause_list)) {
-            if ((ret = snprintf(sqlp, left, " WHERE")) >= left) {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            sqlp += ret;
-            left -= ret;
-        }
-        if (__db_backend_mysql_build_clause(object, clause_list, &sqlp, &left)) {
+        if ((libdbo_clause_list_begin(clause_list)
+                && __db_backend_mysql_sql_append(&sql, " WHERE", NULL))
+            || __db_backend_mysql_build_clause(object, clause_list, &sql))
+        {
+            __db_backend_mysql_sql_reset(&sql);
             return LIBDBO_ERROR_UNKNOWN;
         }
     }
 
-    if (__db_backend_mysql_prepare(backend_mysql, &statement, sql, strlen(sql), libdbo_object_object_field_list(object))
+    if (__db_backend_mysql_prepare(backend_mysql, &statement, sql.string, sql.length, libdbo_object_object_field_list(object))
         || !statement)
     {
+        __db_backend_mysql_sql_reset(&sql);
         __db_backend_mysql_finish(statement);
         return LIBDBO_ERROR_UNKNOWN;
     }
+    __db_backend_mysql_sql_reset(&sql);
 
     bind = statement->bind_input;
 
@@ -1969,7 +2236,7 @@ static int libdbo_backend_mysql_delete(void* data, const libdbo_object_t* object
         }
     }
 
-    if (__db_backend_mysql_execute(statement)) {
+    if (__db_backend_mysql_execute(statement, LIBDBO_STATS_DELETE, object)) {
         __db_backend_mysql_finish(statement);
         return LIBDBO_ERROR_UNKNOWN;
     }
@@ -1981,7 +2248,7 @@ static int libdbo_backend_mysql_delete(void* data, const libdbo_object_t* object
     if (revision_field) {
         if (mysql_stmt_affected_rows(statement->statement) < 1) {
             __db_backend_mysql_finish(statement);
-            return LIBDBO_ERROR_UNKNOWN;
+            return LIBDBO_ERROR_REVISION;
         }
     }
 
@@ -1992,9 +2259,7 @@ static int libdbo_backend_mysql_delete(void* data, const libdbo_object_t* object
 static int libdbo_backend_mysql_count(void* data, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list, size_t* count) {
     libdbo_backend_mysql_t* backend_mysql = (libdbo_backend_mysql_t*)data;
     const libdbo_join_t* join;
-    char sql[4*1024];
-    char* sqlp;
-    int ret, left;
+    libdbo_backend_mysql_sql_t sql;
     libdbo_backend_mysql_statement_t* statement = NULL;
     libdbo_backend_mysql_bind_t* bind;
     libdbo_object_field_list_t* object_field_list;
@@ -2013,48 +2278,32 @@ static int libdbo_backend_mysql_count(void* data, const libdbo_object_t* object,
         return LIBDBO_ERROR_UNKNOWN;
     }
 
-    left = sizeof(sql);
-    sqlp = sql;
-
-    if ((ret = snprintf(sqlp, left, "SELECT COUNT(*)")) >= left) {
-        return LIBDBO_ERROR_UNKNOWN;
-    }
-    sqlp += ret;
-    left -= ret;
-
-    if ((ret = snprintf(sqlp, left, " FROM %s", libdbo_object_table(object))) >= left) {
+    __db_backend_mysql_sql_init(&sql);
+    if (__db_backend_mysql_sql_append(&sql, "SELECT COUNT(*) FROM ", libdbo_object_table(object), NULL)) {
+        __db_backend_mysql_sql_reset(&sql);
         return LIBDBO_ERROR_UNKNOWN;
     }
-    sqlp += ret;
-    left -= ret;
 
     if (join_list) {
         join = libdbo_join_list_begin(join_list);
         while (join) {
-            if ((ret = snprintf(sqlp, left, " INNER JOIN %s ON %s.%s = %s.%s",
-                libdbo_join_to_table(join),
-                libdbo_join_to_table(join),
-                libdbo_join_to_field(join),
-                libdbo_join_from_table(join),
-                libdbo_join_from_field(join))) >= left)
+            if (__db_backend_mysql_sql_append(&sql, " INNER JOIN ", libdbo_join_to_table(join),
+                " ON ", libdbo_join_to_table(join), ".", libdbo_join_to_field(join),
+                " = ", libdbo_join_from_table(join), ".", libdbo_join_from_field(join), NULL))
             {
+                __db_backend_mysql_sql_reset(&sql);
                 return LIBDBO_ERROR_UNKNOWN;
             }
-            sqlp += ret;
-            left -= ret;
             join = libdbo_join_next(join);
         }
     }
 
     if (clause_list) {
-        if (libdbo_clause_list_begin(clause_list)) {
-            if ((ret = snprintf(sqlp, left, " WHERE")) >= left) {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            sqlp += ret;
-            left -= ret;
-        }
-        if (__db_backend_mysql_build_clause(object, clause_list, &sqlp, &left)) {
+        if ((libdbo_clause_list_begin(clause_list)
+                && __db_backend_mysql_sql_append(&sql, " WHERE", NULL))
+            || __db_backend_mysql_build_clause(object, clause_list, &sql))
+        {
+            __db_backend_mysql_sql_reset(&sql);
             return LIBDBO_ERROR_UNKNOWN;
         }
     }
@@ -2065,18 +2314,21 @@ static int libdbo_backend_mysql_count(void* data, const libdbo_object_t* object,
         || libdbo_object_field_set_type(object_field, LIBDBO_TYPE_UINT32)
         || libdbo_object_field_list_add(object_field_list, object_field))
     {
+        __db_backend_mysql_sql_reset(&sql);
         libdbo_object_field_free(object_field);
         libdbo_object_field_list_free(object_field_list);
         return LIBDBO_ERROR_UNKNOWN;
     }
 
-    if (__db_backend_mysql_prepare(backend_mysql, &statement, sql, strlen(sql), object_field_list)
+    if (__db_backend_mysql_prepare(backend_mysql, &statement, sql.string, sql.length, object_field_list)
         || !statement)
     {
+        __db_backend_mysql_sql_reset(&sql);
         libdbo_object_field_list_free(object_field_list);
         __db_backend_mysql_finish(statement);
         return LIBDBO_ERROR_UNKNOWN;
     }
+    __db_backend_mysql_sql_reset(&sql);
     libdbo_object_field_list_free(object_field_list);
 
     bind = statement->bind_input;
@@ -2088,7 +2340,7 @@ static int libdbo_backend_mysql_count(void* data, const libdbo_object_t* object,
         }
     }
 
-    if (__db_backend_mysql_execute(statement)) {
+    if (__db_backend_mysql_execute(statement, LIBDBO_STATS_COUNT, object)) {
         __db_backend_mysql_finish(statement);
         return LIBDBO_ERROR_UNKNOWN;
     }
@@ -2114,6 +2366,223 @@ static int libdbo_backend_mysql_count(void* data, const libdbo_object_t* object,
     return LIBDBO_OK;
 }
 
+static int libdbo_backend_mysql_upsert(void* data, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, const libdbo_clause_list_t* clause_list) {
+    libdbo_backend_mysql_t* backend_mysql = (libdbo_backend_mysql_t*)data;
+    const libdbo_object_field_t* object_field;
+    const libdbo_object_field_t* revision_field = NULL;
+    const libdbo_clause_t* clause;
+    const libdbo_clause_t* revision_clause = NULL;
+    libdbo_backend_mysql_sql_t sql;
+    int ret, first;
+    libdbo_backend_mysql_statement_t* statement = NULL;
+    libdbo_backend_mysql_bind_t* bind;
+
+    if (!__mysql_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_mysql) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object_field_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!value_set) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!clause_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!libdbo_object_field_list_begin(object_field_list)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * Check if the object has a revision field and keep it for later use.
+     */
+    object_field = libdbo_object_field_list_begin(libdbo_object_object_field_list(object));
+    while (object_field) {
+        if (libdbo_object_field_type(object_field) == LIBDBO_TYPE_REVISION) {
+            if (revision_field) {
+                /*
+                 * We do not support multiple revision fields.
+                 */
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+
+            revision_field = object_field;
+        }
+        object_field = libdbo_object_field_next(object_field);
+    }
+
+    /*
+     * The clauses can only be equal clauses on the unique fields and the
+     * revision field. MySQL will use any unique key that conflicts so the
+     * unique fields are only validated here, the revision clause is optional
+     * and if given the update will only be done if the object is still on
+     * that revision.
+     */
+    clause = libdbo_clause_list_begin(clause_list);
+    if (!clause) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    while (clause) {
+        if (libdbo_clause_type(clause) != LIBDBO_CLAUSE_EQUAL) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        if (revision_field
+            && !strcmp(libdbo_clause_field(clause), libdbo_object_field_name(revision_field)))
+        {
+            if (revision_clause) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            revision_clause = clause;
+        }
+        clause = libdbo_clause_next(clause);
+    }
+
+    /*
+     * Build the insert with the fields from the given object_field_list and
+     * the revision field if we have one, a new object always starts on
+     * revision 1.
+     */
+    __db_backend_mysql_sql_init(&sql);
+    ret = __db_backend_mysql_sql_append(&sql, "INSERT INTO ", libdbo_object_table(object), " (", NULL);
+    object_field = libdbo_object_field_list_begin(object_field_list);
+    first = 1;
+    while (!ret && object_field) {
+        ret = __db_backend_mysql_sql_append(&sql, first ? " " : ", ", libdbo_object_field_name(object_field), NULL);
+        first = 0;
+        object_field = libdbo_object_field_next(object_field);
+    }
+    if (!ret && revision_field) {
+        ret = __db_backend_mysql_sql_append(&sql, ", ", libdbo_object_field_name(revision_field), NULL);
+    }
+    if (!ret) {
+        ret = __db_backend_mysql_sql_append(&sql, " ) VALUES (", NULL);
+    }
+    object_field = libdbo_object_field_list_begin(object_field_list);
+    first = 1;
+    while (!ret && object_field) {
+        ret = __db_backend_mysql_sql_append(&sql, first ? " ?" : ", ?", NULL);
+        first = 0;
+        object_field = libdbo_object_field_next(object_field);
+    }
+    if (!ret && revision_field) {
+        ret = __db_backend_mysql_sql_append(&sql, ", 1", NULL);
+    }
+    if (!ret) {
+        ret = __db_backend_mysql_sql_append(&sql, " ) ON DUPLICATE KEY UPDATE", NULL);
+    }
+
+    /*
+     * Update all the fields with the new values, if restricted to a revision
+     * each field is only updated if the revision matches. The revision is
+     * updated last since MySQL evaluates the assignments in order.
+     */
+    object_field = libdbo_object_field_list_begin(object_field_list);
+    first = 1;
+    while (!ret && object_field) {
+        if (revision_clause) {
+            ret = __db_backend_mysql_sql_append(&sql, first ? " " : ", ",
+                libdbo_object_field_name(object_field), " = IF(",
+                libdbo_object_field_name(revision_field), " = ?, VALUES(",
+                libdbo_object_field_name(object_field), "), ",
+                libdbo_object_field_name(object_field), ")", NULL);
+        }
+        else {
+            ret = __db_backend_mysql_sql_append(&sql, first ? " " : ", ",
+                libdbo_object_field_name(object_field), " = VALUES(",
+                libdbo_object_field_name(object_field), ")", NULL);
+        }
+        first = 0;
+        object_field = libdbo_object_field_next(object_field);
+    }
+    if (!ret && revision_field) {
+        if (revision_clause) {
+            ret = __db_backend_mysql_sql_append(&sql, ", ",
+                libdbo_object_field_name(revision_field), " = IF(",
+                libdbo_object_field_name(revision_field), " = ?, ",
+                libdbo_object_field_name(revision_field), " + 1, ",
+                libdbo_object_field_name(revision_field), ")", NULL);
+        }
+        else {
+            ret = __db_backend_mysql_sql_append(&sql, ", ",
+                libdbo_object_field_name(revision_field), " = ",
+                libdbo_object_field_name(revision_field), " + 1", NULL);
+        }
+    }
+
+    /*
+     * Prepare the SQL.
+     */
+    if (ret
+        || __db_backend_mysql_prepare(backend_mysql, &statement, sql.string, sql.length, libdbo_object_object_field_list(object))
+        || !statement
+        || !(bind = statement->bind_input))
+    {
+        __db_backend_mysql_sql_reset(&sql);
+        __db_backend_mysql_finish(statement);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    __db_backend_mysql_sql_reset(&sql);
+
+    /*
+     * Bind all the values from value_set.
+     */
+    if (__db_backend_mysql_bind_value_set(&bind, value_set)) {
+        __db_backend_mysql_finish(statement);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * Bind the current revision for each field and the revision itself if
+     * restricted to a revision.
+     */
+    if (revision_clause) {
+        object_field = libdbo_object_field_list_begin(object_field_list);
+        while (object_field) {
+            if (__db_backend_mysql_bind_value(bind, libdbo_clause_value(revision_clause))) {
+                __db_backend_mysql_finish(statement);
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            if (bind) {
+                bind = bind->next;
+            }
+
+            object_field = libdbo_object_field_next(object_field);
+        }
+        if (__db_backend_mysql_bind_value(bind, libdbo_clause_value(revision_clause))) {
+            __db_backend_mysql_finish(statement);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+
+    /*
+     * Execute the SQL.
+     */
+    if (__db_backend_mysql_execute(statement, LIBDBO_STATS_UPSERT, object)) {
+        __db_backend_mysql_finish(statement);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * If the update was restricted to a revision we have to have a positive
+     * number of changes otherwise the object was changed by someone else.
+     */
+    if (revision_clause) {
+        if (mysql_stmt_affected_rows(statement->statement) < 1) {
+            __db_backend_mysql_finish(statement);
+            return LIBDBO_ERROR_REVISION;
+        }
+    }
+
+    __db_backend_mysql_finish(statement);
+    return LIBDBO_OK;
+}
+
 static void libdbo_backend_mysql_free(void* data) {
     libdbo_backend_mysql_t* backend_mysql = (libdbo_backend_mysql_t*)data;
 
@@ -2121,43 +2590,81 @@ static void libdbo_backend_mysql_free(void* data) {
         if (backend_mysql->db) {
             (void)libdbo_backend_mysql_disconnect(backend_mysql);
         }
+        __db_backend_mysql_template_free(backend_mysql);
         libdbo_mm_delete(&__mysql_alloc, backend_mysql);
     }
 }
 
-static int libdbo_backend_mysql_transaction_begin(void* data) {
-    libdbo_backend_mysql_t* backend_mysql = (libdbo_backend_mysql_t*)data;
-    static const char* sql = "BEGIN TRANSACTION";
-    libdbo_backend_mysql_statement_t* statement = NULL;
+/**
+ * Execute a SQL statement that does not return any rows, this uses the text
+ * protocol since not all transaction statements can be prepared.
+ */
+static int __db_backend_mysql_exec(libdbo_backend_mysql_t* backend_mysql, libdbo_stats_operation_t operation, const char* sql) {
+    libdbo_trace_event_t event;
+    int traced;
+    int ret;
 
-    if (!__mysql_initialized) {
+    if (!backend_mysql) {
         return LIBDBO_ERROR_UNKNOWN;
     }
-    if (!backend_mysql) {
+    if (!backend_mysql->db) {
         return LIBDBO_ERROR_UNKNOWN;
     }
-    if (backend_mysql->transaction) {
+    if (!sql) {
         return LIBDBO_ERROR_UNKNOWN;
     }
 
-    if (__db_backend_mysql_prepare(backend_mysql, &statement, sql, strlen(sql), NULL)) {
+    traced = LIBDBO_TRACE_CALL_BEGIN(&event, "mysql", operation, NULL, sql, 0);
+    ret = mysql_real_query(backend_mysql->db, sql, strlen(sql));
+    if (traced) {
+        LIBDBO_TRACE_CALL_END(&event, 0, ret ? LIBDBO_ERROR_UNKNOWN : LIBDBO_OK);
+    }
+    if (ret) {
+        libdbo_log(LIBDBO_LOG_ERROR, "MySQL query error %u: %s (SQL: %s)",
+            mysql_errno(backend_mysql->db), mysql_error(backend_mysql->db), sql);
         return LIBDBO_ERROR_UNKNOWN;
     }
 
-    if (__db_backend_mysql_execute(statement)) {
-        __db_backend_mysql_finish(statement);
+    return LIBDBO_OK;
+}
+
+/*
+ * Transactions can be nested, the outer most transaction is a real MySQL
+ * transaction and each nested transaction is a savepoint named after the
+ * depth it was started at.
+ */
+
+static int libdbo_backend_mysql_transaction_begin(void* data) {
+    libdbo_backend_mysql_t* backend_mysql = (libdbo_backend_mysql_t*)data;
+    char sql[64];
+
+    if (!__mysql_initialized) {
         return LIBDBO_ERROR_UNKNOWN;
     }
-    __db_backend_mysql_finish(statement);
+    if (!backend_mysql) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (!backend_mysql->transaction) {
+        if (__db_backend_mysql_exec(backend_mysql, LIBDBO_STATS_TRANSACTION_BEGIN, "START TRANSACTION")) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+    else {
+        if (snprintf(sql, sizeof(sql), "SAVEPOINT libdbo_%d", backend_mysql->transaction) >= (int)sizeof(sql)
+            || __db_backend_mysql_exec(backend_mysql, LIBDBO_STATS_TRANSACTION_BEGIN, sql))
+        {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
 
-    backend_mysql->transaction = 1;
+    backend_mysql->transaction++;
     return LIBDBO_OK;
 }
 
 static int libdbo_backend_mysql_transaction_commit(void* data) {
     libdbo_backend_mysql_t* backend_mysql = (libdbo_backend_mysql_t*)data;
-    static const char* sql = "COMMIT TRANSACTION";
-    libdbo_backend_mysql_statement_t* statement = NULL;
+    char sql[64];
 
     if (!__mysql_initialized) {
         return LIBDBO_ERROR_UNKNOWN;
@@ -2169,24 +2676,26 @@ static int libdbo_backend_mysql_transaction_commit(void* data) {
         return LIBDBO_ERROR_UNKNOWN;
     }
 
-    if (__db_backend_mysql_prepare(backend_mysql, &statement, sql, strlen(sql), NULL)) {
-        return LIBDBO_ERROR_UNKNOWN;
+    if (backend_mysql->transaction == 1) {
+        if (__db_backend_mysql_exec(backend_mysql, LIBDBO_STATS_TRANSACTION_COMMIT, "COMMIT")) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
     }
-
-    if (__db_backend_mysql_execute(statement)) {
-        __db_backend_mysql_finish(statement);
-        return LIBDBO_ERROR_UNKNOWN;
+    else {
+        if (snprintf(sql, sizeof(sql), "RELEASE SAVEPOINT libdbo_%d", backend_mysql->transaction - 1) >= (int)sizeof(sql)
+            || __db_backend_mysql_exec(backend_mysql, LIBDBO_STATS_TRANSACTION_COMMIT, sql))
+        {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
     }
-    __db_backend_mysql_finish(statement);
 
-    backend_mysql->transaction = 0;
+    backend_mysql->transaction--;
     return LIBDBO_OK;
 }
 
 static int libdbo_backend_mysql_transaction_rollback(void* data) {
     libdbo_backend_mysql_t* backend_mysql = (libdbo_backend_mysql_t*)data;
-    static const char* sql = "ROLLBACK TRANSACTION";
-    libdbo_backend_mysql_statement_t* statement = NULL;
+    char sql[64];
 
     if (!__mysql_initialized) {
         return LIBDBO_ERROR_UNKNOWN;
@@ -2198,17 +2707,26 @@ static int libdbo_backend_mysql_transaction_rollback(void* data) {
         return LIBDBO_ERROR_UNKNOWN;
     }
 
-    if (__db_backend_mysql_prepare(backend_mysql, &statement, sql, strlen(sql), NULL)) {
-        return LIBDBO_ERROR_UNKNOWN;
+    if (backend_mysql->transaction == 1) {
+        if (__db_backend_mysql_exec(backend_mysql, LIBDBO_STATS_TRANSACTION_ROLLBACK, "ROLLBACK")) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
     }
-
-    if (__db_backend_mysql_execute(statement)) {
-        __db_backend_mysql_finish(statement);
-        return LIBDBO_ERROR_UNKNOWN;
+    else {
+        /*
+         * Rolling back to a savepoint keeps it so it also needs to be
+         * released.
+         */
+        if (snprintf(sql, sizeof(sql), "ROLLBACK TO SAVEPOINT libdbo_%d", backend_mysql->transaction - 1) >= (int)sizeof(sql)
+            || __db_backend_mysql_exec(backend_mysql, LIBDBO_STATS_TRANSACTION_ROLLBACK, sql)
+            || snprintf(sql, sizeof(sql), "RELEASE SAVEPOINT libdbo_%d", backend_mysql->transaction - 1) >= (int)sizeof(sql)
+            || __db_backend_mysql_exec(backend_mysql, LIBDBO_STATS_TRANSACTION_ROLLBACK, sql))
+        {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
     }
-    __db_backend_mysql_finish(statement);
 
-    backend_mysql->transaction = 0;
+    backend_mysql->transaction--;
     return LIBDBO_OK;
 }
 
@@ -2228,6 +2746,7 @@ libdbo_backend_handle_t* libdbo_backend_mysql_new_handle(void) {
             || libdbo_backend_handle_set_update(backend_handle, libdbo_backend_mysql_update)
             || libdbo_backend_handle_set_delete(backend_handle, libdbo_backend_mysql_delete)
             || libdbo_backend_handle_set_count(backend_handle, libdbo_backend_mysql_count)
+            || libdbo_backend_handle_set_upsert(backend_handle, libdbo_backend_mysql_upsert)
             || libdbo_backend_handle_set_free(backend_handle, libdbo_backend_mysql_free)
             || libdbo_backend_handle_set_transaction_begin(backend_handle, libdbo_backend_mysql_transaction_begin)
             || libdbo_backend_handle_set_transaction_commit(backend_handle, libdbo_backend_mysql_transaction_commit)
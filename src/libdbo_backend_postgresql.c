@@ -0,0 +1,2514 @@
+/*
+ * Copyright (c) 2014 Jerry Lundström <lundstrom.jerry@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "config.h"
+
+#include "libdbo/backend/postgresql.h"
+
+#include "libdbo/error.h"
+#include "libdbo/mm.h"
+#include "libdbo/log.h"
+#include "libdbo/trace.h"
+
+#include <libpq-fe.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+
+static int libdbo_backend_postgresql_transaction_rollback(void*);
+
+/**
+ * Keep track of if we have initialized the PostgreSQL backend.
+ */
+static int __postgresql_initialized = 0;
+
+/**
+ * The type OIDs used for parameters and results, these are fixed in the
+ * PostgreSQL catalog.
+ */
+#define LIBDBO_BACKEND_POSTGRESQL_INT8OID 20
+#define LIBDBO_BACKEND_POSTGRESQL_INT2OID 21
+#define LIBDBO_BACKEND_POSTGRESQL_INT4OID 23
+#define LIBDBO_BACKEND_POSTGRESQL_TEXTOID 25
+#define LIBDBO_BACKEND_POSTGRESQL_BPCHAROID 1042
+#define LIBDBO_BACKEND_POSTGRESQL_VARCHAROID 1043
+
+/**
+ * The checks done on the number of rows affected by a statement.
+ */
+#define LIBDBO_BACKEND_POSTGRESQL_CHECK_NONE 0
+#define LIBDBO_BACKEND_POSTGRESQL_CHECK_ONE 1
+#define LIBDBO_BACKEND_POSTGRESQL_CHECK_SOME 2
+
+/**
+ * The types of SQL templates that are cached per object.
+ */
+#define LIBDBO_BACKEND_POSTGRESQL_TEMPLATE_SELECT 1
+#define LIBDBO_BACKEND_POSTGRESQL_TEMPLATE_INSERT 2
+#define LIBDBO_BACKEND_POSTGRESQL_TEMPLATE_UPDATE 3
+
+/**
+ * A cached SQL template, the static part of the SQL for an operation on a
+ * table with a specific set of fields. The fields are stored comma separated
+ * and are used together with the type, table and revision field to find the
+ * template.
+ */
+typedef struct libdbo_backend_postgresql_template libdbo_backend_postgresql_template_t;
+struct libdbo_backend_postgresql_template {
+    libdbo_backend_postgresql_template_t* next;
+    int type;
+    char* table;
+    char* fields;
+    char* revision;
+    char* sql;
+    /** The number of parameters used in the SQL. */
+    int params;
+};
+
+static libdbo_mm_t __postgresql_template_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_backend_postgresql_template_t));
+
+/**
+ * The states of a named prepared statement.
+ */
+#define LIBDBO_BACKEND_POSTGRESQL_PREPARED_NONE 0
+#define LIBDBO_BACKEND_POSTGRESQL_PREPARED_PENDING 1
+#define LIBDBO_BACKEND_POSTGRESQL_PREPARED_DONE 2
+
+/**
+ * A named prepared statement, found by the SQL and the parameter types it
+ * was prepared with.
+ */
+typedef struct libdbo_backend_postgresql_prepared libdbo_backend_postgresql_prepared_t;
+struct libdbo_backend_postgresql_prepared {
+    libdbo_backend_postgresql_prepared_t* next;
+    char* sql;
+    Oid* types;
+    int params;
+    int state;
+    char name[32];
+};
+
+static libdbo_mm_t __postgresql_prepared_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_backend_postgresql_prepared_t));
+
+/**
+ * A statement sent in pipeline mode that we have not yet got the result for.
+ */
+typedef struct libdbo_backend_postgresql_pending {
+    /** The prepared statement if this is the prepare of it. */
+    libdbo_backend_postgresql_prepared_t* prepared;
+    int check;
+} libdbo_backend_postgresql_pending_t;
+
+/**
+ * The PostgreSQL database backend specific data.
+ */
+typedef struct libdbo_backend_postgresql {
+    PGconn* db;
+    /** The depth of nested transactions, zero if none. */
+    int transaction;
+    unsigned int timeout;
+    /** If creates and updates within transactions should be pipelined. */
+    int pipeline;
+    /** Statements taking at least this many microseconds are logged, 0 if not. */
+    unsigned long slow_query;
+    /** If the values bound to a slow statement are left out of the log. */
+    int slow_query_redact;
+    /** The cached SQL templates. */
+    libdbo_backend_postgresql_template_t* template_list;
+    /** The named prepared statements on this connection. */
+    libdbo_backend_postgresql_prepared_t* prepared_list;
+    size_t prepared_size;
+    unsigned int prepared_next;
+    /** The statements waiting for a result in pipeline mode. */
+    libdbo_backend_postgresql_pending_t pending[LIBDBO_BACKEND_POSTGRESQL_PIPELINE_MAX];
+    size_t pending_size;
+} libdbo_backend_postgresql_t;
+
+static libdbo_mm_t __postgresql_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_backend_postgresql_t));
+
+/**
+ * The parameters for a statement, all parameters are sent in binary format.
+ * Integers are stored in network byte order in `buffer` and text parameters
+ * point to the text of the value they were bound from.
+ */
+typedef struct libdbo_backend_postgresql_params {
+    int count;
+    int size;
+    const char** values;
+    int* lengths;
+    int* formats;
+    Oid* types;
+    char* buffer;
+} libdbo_backend_postgresql_params_t;
+
+/**
+ * The PostgreSQL database backend specific data for statements.
+ */
+typedef struct libdbo_backend_postgresql_statement {
+    PGresult* result;
+    libdbo_object_field_list_t* object_field_list;
+    int fields;
+    int row;
+    int rows;
+} libdbo_backend_postgresql_statement_t;
+
+static libdbo_mm_t __postgresql_statement_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_backend_postgresql_statement_t));
+
+/**
+ * The initial size of the SQL buffer, this is kept on the stack and only SQL
+ * larger then this will be allocated.
+ */
+#define LIBDBO_BACKEND_POSTGRESQL_SQL_SIZE 1024
+
+/**
+ * A growable buffer used to build SQL.
+ */
+typedef struct libdbo_backend_postgresql_sql {
+    char* string;
+    size_t length;
+    size_t size;
+    char buffer[LIBDBO_BACKEND_POSTGRESQL_SQL_SIZE];
+} libdbo_backend_postgresql_sql_t;
+
+/**
+ * Initialize a SQL buffer.
+ */
+static inline void __db_backend_postgresql_sql_init(libdbo_backend_postgresql_sql_t* sql) {
+    sql->string = sql->buffer;
+    sql->length = 0;
+    sql->size = sizeof(sql->buffer);
+    sql->buffer[0] = 0;
+}
+
+/**
+ * Release any memory allocated by a SQL buffer.
+ */
+static inline void __db_backend_postgresql_sql_reset(libdbo_backend_postgresql_sql_t* sql) {
+    if (sql->string != sql->buffer) {
+        free(sql->string);
+    }
+    __db_backend_postgresql_sql_init(sql);
+}
+
+/**
+ * Append one or more strings to a SQL buffer, the list of strings must be
+ * terminated by a NULL.
+ */
+static int __db_backend_postgresql_sql_append(libdbo_backend_postgresql_sql_t* sql, ...) {
+    va_list ap;
+    const char* string;
+    size_t length, size;
+    char* new_string;
+
+    if (!sql) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    va_start(ap, sql);
+    while ((string = va_arg(ap, const char*))) {
+        length = strlen(string);
+        if (sql->length + length >= sql->size) {
+            size = sql->size * 2;
+            while (sql->length + length >= size) {
+                size *= 2;
+            }
+            if (sql->string == sql->buffer) {
+                if ((new_string = malloc(size))) {
+                    memcpy(new_string, sql->buffer, sql->length + 1);
+                }
+            }
+            else {
+                new_string = realloc(sql->string, size);
+            }
+            if (!new_string) {
+                va_end(ap);
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            sql->string = new_string;
+            sql->size = size;
+        }
+        memcpy(sql->string + sql->length, string, length + 1);
+        sql->length += length;
+    }
+    va_end(ap);
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Append the parameter placeholder for parameter number `number` to a SQL
+ * buffer, prefixed by `prefix`.
+ */
+static int __db_backend_postgresql_sql_append_param(libdbo_backend_postgresql_sql_t* sql, const char* prefix, int number) {
+    char param[16];
+
+    if (snprintf(param, sizeof(param), "$%d", number) >= (int)sizeof(param)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    return __db_backend_postgresql_sql_append(sql, prefix, param, NULL);
+}
+
+/**
+ * Initialize a parameter list.
+ */
+static inline void __db_backend_postgresql_params_init(libdbo_backend_postgresql_params_t* params) {
+    memset(params, 0, sizeof(libdbo_backend_postgresql_params_t));
+}
+
+/**
+ * Release any memory allocated by a parameter list.
+ */
+static inline void __db_backend_postgresql_params_reset(libdbo_backend_postgresql_params_t* params) {
+    free(params->values);
+    free(params->lengths);
+    free(params->formats);
+    free(params->types);
+    free(params->buffer);
+    __db_backend_postgresql_params_init(params);
+}
+
+/**
+ * Make room for one more parameter in a parameter list.
+ */
+static int __db_backend_postgresql_params_grow(libdbo_backend_postgresql_params_t* params) {
+    int size;
+    void* new_array;
+
+    if (params->count < params->size) {
+        return LIBDBO_OK;
+    }
+
+    size = params->size ? params->size * 2 : 16;
+    if (!(new_array = realloc((void*)params->values, size * sizeof(const char*)))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    params->values = new_array;
+    if (!(new_array = realloc(params->lengths, size * sizeof(int)))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    params->lengths = new_array;
+    if (!(new_array = realloc(params->formats, size * sizeof(int)))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    params->formats = new_array;
+    if (!(new_array = realloc(params->types, size * sizeof(Oid)))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    params->types = new_array;
+    if (!(new_array = realloc(params->buffer, size * 8))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    params->buffer = new_array;
+    params->size = size;
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Add an integer parameter of type `type`, either INT4 or INT8, to a
+ * parameter list.
+ */
+static int __db_backend_postgresql_params_add_integer(libdbo_backend_postgresql_params_t* params, Oid type, libdbo_type_int64_t integer) {
+    unsigned char* buffer;
+    libdbo_type_uint64_t bits = (libdbo_type_uint64_t)integer;
+    int i, length;
+
+    if (__db_backend_postgresql_params_grow(params)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    length = type == LIBDBO_BACKEND_POSTGRESQL_INT4OID ? 4 : 8;
+    buffer = (unsigned char*)params->buffer + params->count * 8;
+    for (i = length - 1; i >= 0; i--) {
+        buffer[i] = (unsigned char)(bits & 0xff);
+        bits >>= 8;
+    }
+
+    /*
+     * The value is pointed to the buffer when executing since the buffer can
+     * move when more parameters are added.
+     */
+    params->values[params->count] = NULL;
+    params->lengths[params->count] = length;
+    params->formats[params->count] = 1;
+    params->types[params->count] = type;
+    params->count++;
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Add a text parameter to a parameter list, the text must be valid until the
+ * statement has been executed.
+ */
+static int __db_backend_postgresql_params_add_text(libdbo_backend_postgresql_params_t* params, const char* text) {
+    if (__db_backend_postgresql_params_grow(params)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    params->values[params->count] = text;
+    params->lengths[params->count] = strlen(text);
+    params->formats[params->count] = 1;
+    params->types[params->count] = LIBDBO_BACKEND_POSTGRESQL_TEXTOID;
+    params->count++;
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Free all the cached SQL templates.
+ */
+static void __db_backend_postgresql_template_free(libdbo_backend_postgresql_t* backend_postgresql) {
+    libdbo_backend_postgresql_template_t* template;
+
+    while ((template = backend_postgresql->template_list)) {
+        backend_postgresql->template_list = template->next;
+        free(template->table);
+        free(template->fields);
+        free(template->revision);
+        free(template->sql);
+        libdbo_mm_delete(&__postgresql_template_alloc, template);
+    }
+}
+
+/**
+ * Check if a template matches the fields in `object_field_list`.
+ */
+static int __db_backend_postgresql_template_match(const libdbo_backend_postgresql_template_t* template, const libdbo_object_field_list_t* object_field_list) {
+    const libdbo_object_field_t* object_field;
+    const char* fields = template->fields;
+    size_t length;
+
+    object_field = libdbo_object_field_list_begin(object_field_list);
+    while (object_field) {
+        length = strlen(libdbo_object_field_name(object_field));
+        if (strncmp(fields, libdbo_object_field_name(object_field), length)) {
+            return 0;
+        }
+        fields += length;
+        if (*fields == ',') {
+            fields++;
+        }
+        else if (*fields) {
+            return 0;
+        }
+        object_field = libdbo_object_field_next(object_field);
+    }
+
+    return !*fields;
+}
+
+/**
+ * Get the SQL template of type `type` for the object with the fields in
+ * `object_field_list` and the revision field `revision_field`, the template is
+ * created and cached if it does not already exist.
+ * \param[in] backend_postgresql a libdbo_backend_postgresql_t pointer.
+ * \param[in] type an integer.
+ * \param[in] object a libdbo_object_t pointer.
+ * \param[in] object_field_list a libdbo_object_field_list_t pointer.
+ * \param[in] revision_field a libdbo_object_field_t pointer or NULL.
+ * \return a libdbo_backend_postgresql_template_t pointer or NULL on error.
+ */
+static const libdbo_backend_postgresql_template_t* __db_backend_postgresql_template(libdbo_backend_postgresql_t* backend_postgresql, int type, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_object_field_t* revision_field) {
+    libdbo_backend_postgresql_template_t* template;
+    const libdbo_object_field_t* object_field;
+    const char* table = libdbo_object_table(object);
+    const char* revision = revision_field ? libdbo_object_field_name(revision_field) : NULL;
+    libdbo_backend_postgresql_sql_t sql;
+    libdbo_backend_postgresql_sql_t fields;
+    int first, fields_size, params, ret;
+
+    for (template = backend_postgresql->template_list; template; template = template->next) {
+        if (template->type == type
+            && !strcmp(template->table, table)
+            && (revision ? (template->revision && !strcmp(template->revision, revision)) : !template->revision)
+            && __db_backend_postgresql_template_match(template, object_field_list))
+        {
+            return template;
+        }
+    }
+
+    __db_backend_postgresql_sql_init(&sql);
+    __db_backend_postgresql_sql_init(&fields);
+    ret = LIBDBO_OK;
+    params = 0;
+
+    switch (type) {
+    case LIBDBO_BACKEND_POSTGRESQL_TEMPLATE_SELECT:
+        ret = __db_backend_postgresql_sql_append(&sql, "SELECT", NULL);
+        break;
+
+    case LIBDBO_BACKEND_POSTGRESQL_TEMPLATE_INSERT:
+        if (!libdbo_object_field_list_begin(object_field_list) && !revision) {
+            /*
+             * Special case when tables has no fields except maybe a primary key.
+             */
+            ret = __db_backend_postgresql_sql_append(&sql, "INSERT INTO ", table, " DEFAULT VALUES", NULL);
+        }
+        else {
+            ret = __db_backend_postgresql_sql_append(&sql, "INSERT INTO ", table, " (", NULL);
+        }
+        break;
+
+    case LIBDBO_BACKEND_POSTGRESQL_TEMPLATE_UPDATE:
+        ret = __db_backend_postgresql_sql_append(&sql, "UPDATE ", table, " SET", NULL);
+        break;
+
+    default:
+        return NULL;
+    }
+
+    object_field = libdbo_object_field_list_begin(object_field_list);
+    first = 1;
+    fields_size = 0;
+    while (!ret && object_field) {
+        switch (type) {
+        case LIBDBO_BACKEND_POSTGRESQL_TEMPLATE_SELECT:
+            ret = __db_backend_postgresql_sql_append(&sql, first ? " " : ", ", table, ".", libdbo_object_field_name(object_field), NULL);
+            break;
+
+        case LIBDBO_BACKEND_POSTGRESQL_TEMPLATE_INSERT:
+            ret = __db_backend_postgresql_sql_append(&sql, first ? " " : ", ", libdbo_object_field_name(object_field), NULL);
+            break;
+
+        case LIBDBO_BACKEND_POSTGRESQL_TEMPLATE_UPDATE:
+            if (!(ret = __db_backend_postgresql_sql_append(&sql, first ? " " : ", ", libdbo_object_field_name(object_field), NULL))) {
+                ret = __db_backend_postgresql_sql_append_param(&sql, " = ", ++params);
+            }
+            break;
+        }
+        if (!ret) {
+            ret = __db_backend_postgresql_sql_append(&fields, first ? "" : ",", libdbo_object_field_name(object_field), NULL);
+        }
+        first = 0;
+        fields_size++;
+
+        object_field = libdbo_object_field_next(object_field);
+    }
+
+    switch (type) {
+    case LIBDBO_BACKEND_POSTGRESQL_TEMPLATE_SELECT:
+        if (!ret) {
+            ret = __db_backend_postgresql_sql_append(&sql, " FROM ", table, NULL);
+        }
+        break;
+
+    case LIBDBO_BACKEND_POSTGRESQL_TEMPLATE_INSERT:
+        if (!libdbo_object_field_list_begin(object_field_list) && !revision) {
+            break;
+        }
+        if (!ret && revision) {
+            ret = __db_backend_postgresql_sql_append(&sql, first ? " " : ", ", revision, NULL);
+        }
+        if (!ret) {
+            ret = __db_backend_postgresql_sql_append(&sql, " ) VALUES (", NULL);
+        }
+        while (!ret && params < fields_size + (revision ? 1 : 0)) {
+            ret = __db_backend_postgresql_sql_append_param(&sql, params ? ", " : " ", params + 1);
+            params++;
+        }
+        if (!ret) {
+            ret = __db_backend_postgresql_sql_append(&sql, " )", NULL);
+        }
+        break;
+
+    case LIBDBO_BACKEND_POSTGRESQL_TEMPLATE_UPDATE:
+        if (!ret && revision) {
+            if (!(ret = __db_backend_postgresql_sql_append(&sql, first ? " " : ", ", revision, NULL))) {
+                ret = __db_backend_postgresql_sql_append_param(&sql, " = ", ++params);
+            }
+        }
+        break;
+    }
+
+    if (ret
+        || !(template = libdbo_mm_new0(&__postgresql_template_alloc))
+        || !(template->table = strdup(table))
+        || !(template->fields = strdup(fields.string))
+        || (revision && !(template->revision = strdup(revision)))
+        || !(template->sql = strdup(sql.string)))
+    {
+        if (template) {
+            free(template->table);
+            free(template->fields);
+            free(template->revision);
+            libdbo_mm_delete(&__postgresql_template_alloc, template);
+        }
+        __db_backend_postgresql_sql_reset(&sql);
+        __db_backend_postgresql_sql_reset(&fields);
+        return NULL;
+    }
+    template->type = type;
+    template->params = params;
+    template->next = backend_postgresql->template_list;
+    backend_postgresql->template_list = template;
+
+    __db_backend_postgresql_sql_reset(&sql);
+    __db_backend_postgresql_sql_reset(&fields);
+    return template;
+}
+
+/**
+ * Free all the named prepared statements, the statements on the server are
+ * released when the connection is closed.
+ */
+static void __db_backend_postgresql_prepared_free(libdbo_backend_postgresql_t* backend_postgresql) {
+    libdbo_backend_postgresql_prepared_t* prepared;
+
+    while ((prepared = backend_postgresql->prepared_list)) {
+        backend_postgresql->prepared_list = prepared->next;
+        free(prepared->sql);
+        free(prepared->types);
+        libdbo_mm_delete(&__postgresql_prepared_alloc, prepared);
+    }
+    backend_postgresql->prepared_size = 0;
+}
+
+/**
+ * Get the named prepared statement for the SQL `sql` with the parameter
+ * types in `params`, a new entry is created if it does not exist and there
+ * is room for it in the cache.
+ * \return a libdbo_backend_postgresql_prepared_t pointer or NULL if the cache
+ * is full or on error.
+ */
+static libdbo_backend_postgresql_prepared_t* __db_backend_postgresql_prepared(libdbo_backend_postgresql_t* backend_postgresql, const char* sql, const libdbo_backend_postgresql_params_t* params) {
+    libdbo_backend_postgresql_prepared_t* prepared;
+
+    for (prepared = backend_postgresql->prepared_list; prepared; prepared = prepared->next) {
+        if (prepared->params == params->count
+            && (!params->count || !memcmp(prepared->types, params->types, params->count * sizeof(Oid)))
+            && !strcmp(prepared->sql, sql))
+        {
+            return prepared;
+        }
+    }
+
+    if (backend_postgresql->prepared_size >= LIBDBO_BACKEND_POSTGRESQL_PREPARED_MAX) {
+        return NULL;
+    }
+
+    if (!(prepared = libdbo_mm_new0(&__postgresql_prepared_alloc))
+        || !(prepared->sql = strdup(sql))
+        || (params->count && !(prepared->types = malloc(params->count * sizeof(Oid))))
+        || snprintf(prepared->name, sizeof(prepared->name), "libdbo_%u", backend_postgresql->prepared_next) >= (int)sizeof(prepared->name))
+    {
+        if (prepared) {
+            free(prepared->sql);
+            free(prepared->types);
+            libdbo_mm_delete(&__postgresql_prepared_alloc, prepared);
+        }
+        return NULL;
+    }
+    if (params->count) {
+        memcpy(prepared->types, params->types, params->count * sizeof(Oid));
+    }
+    prepared->params = params->count;
+    prepared->state = LIBDBO_BACKEND_POSTGRESQL_PREPARED_NONE;
+    prepared->next = backend_postgresql->prepared_list;
+    backend_postgresql->prepared_list = prepared;
+    backend_postgresql->prepared_size++;
+    backend_postgresql->prepared_next++;
+
+    return prepared;
+}
+
+/**
+ * Check the result of a statement and the number of rows it affected.
+ * \param[in] result a PGresult pointer.
+ * \param[in] check a LIBDBO_BACKEND_POSTGRESQL_CHECK_* define.
+ * \param[in] sql the SQL that was executed or NULL if not known.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_postgresql_check(const PGresult* result, int check, const char* sql) {
+    unsigned long rows;
+
+    if (!result) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    switch (PQresultStatus(result)) {
+    case PGRES_COMMAND_OK:
+    case PGRES_TUPLES_OK:
+        break;
+
+    default:
+        libdbo_log(LIBDBO_LOG_ERROR, "PostgreSQL execute statement error: %s (SQL: %s)",
+            PQresultErrorMessage(result), sql ? sql : "unknown");
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    rows = strtoul(PQcmdTuples((PGresult*)result), NULL, 10);
+    switch (check) {
+    case LIBDBO_BACKEND_POSTGRESQL_CHECK_ONE:
+        if (rows != 1) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        break;
+
+    case LIBDBO_BACKEND_POSTGRESQL_CHECK_SOME:
+        if (rows < 1) {
+            return LIBDBO_ERROR_REVISION;
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Collect the results of all statements sent in pipeline mode and leave
+ * pipeline mode. All results and the sync are always collected, even after a
+ * statement failed, so the connection can leave pipeline mode. The error of
+ * the first statement that failed is returned.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_postgresql_pipeline_flush(libdbo_backend_postgresql_t* backend_postgresql) {
+#ifdef LIBPQ_HAS_PIPELINING
+    libdbo_backend_postgresql_pending_t* pending;
+    PGresult* result;
+    size_t i;
+    int ret = LIBDBO_OK;
+    int check_ret;
+    int synced = 1;
+
+    if (PQpipelineStatus(backend_postgresql->db) == PQ_PIPELINE_OFF) {
+        return LIBDBO_OK;
+    }
+
+    if (!PQpipelineSync(backend_postgresql->db)) {
+        libdbo_log(LIBDBO_LOG_ERROR, "PostgreSQL pipeline sync error: %s",
+            PQerrorMessage(backend_postgresql->db));
+        ret = LIBDBO_ERROR_UNKNOWN;
+        synced = 0;
+    }
+
+    for (i = 0; i < backend_postgresql->pending_size; i++) {
+        pending = &(backend_postgresql->pending[i]);
+        result = synced ? PQgetResult(backend_postgresql->db) : NULL;
+        check_ret = LIBDBO_OK;
+
+        if (pending->prepared) {
+            if (result && PQresultStatus(result) == PGRES_COMMAND_OK) {
+                pending->prepared->state = LIBDBO_BACKEND_POSTGRESQL_PREPARED_DONE;
+            }
+            else {
+                pending->prepared->state = LIBDBO_BACKEND_POSTGRESQL_PREPARED_NONE;
+                if (result && PQresultStatus(result) != PGRES_PIPELINE_ABORTED) {
+                    libdbo_log(LIBDBO_LOG_ERROR, "PostgreSQL prepare statement error: %s (SQL: %s)",
+                        PQresultErrorMessage(result), pending->prepared->sql);
+                }
+                if (!result) {
+                    check_ret = LIBDBO_ERROR_UNKNOWN;
+                }
+            }
+        }
+        else if (!result) {
+            check_ret = LIBDBO_ERROR_UNKNOWN;
+        }
+        else {
+            check_ret = __db_backend_postgresql_check(result, pending->check, NULL);
+        }
+        if (check_ret && !ret) {
+            ret = check_ret;
+        }
+
+        /*
+         * Each statement ends with a NULL result.
+         */
+        if (result) {
+            PQclear(result);
+            while ((result = PQgetResult(backend_postgresql->db))) {
+                PQclear(result);
+            }
+        }
+    }
+    backend_postgresql->pending_size = 0;
+
+    if (synced) {
+        if (!(result = PQgetResult(backend_postgresql->db))
+            || PQresultStatus(result) != PGRES_PIPELINE_SYNC)
+        {
+            libdbo_log(LIBDBO_LOG_ERROR, "PostgreSQL pipeline sync result missing: %s",
+                PQerrorMessage(backend_postgresql->db));
+            if (!ret) {
+                ret = LIBDBO_ERROR_UNKNOWN;
+            }
+        }
+        PQclear(result);
+    }
+
+    if (!PQexitPipelineMode(backend_postgresql->db)) {
+        libdbo_log(LIBDBO_LOG_ERROR, "PostgreSQL exit pipeline error: %s",
+            PQerrorMessage(backend_postgresql->db));
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    return ret;
+#else
+    return LIBDBO_OK;
+#endif
+}
+
+/**
+ * Log a statement that was slow to execute together with the query plan
+ * PostgreSQL uses for it with the same parameters.
+ */
+static void __db_backend_postgresql_slow_query(libdbo_backend_postgresql_t* backend_postgresql, const char* sql, const libdbo_backend_postgresql_params_t* params, unsigned long usec) {
+    libdbo_backend_postgresql_sql_t explain;
+    PGresult* result;
+    const unsigned char* buffer;
+    libdbo_type_uint64_t bits;
+    char number[32];
+    int i, j, ret = LIBDBO_OK;
+
+    libdbo_log(LIBDBO_LOG_WARNING, "PostgreSQL slow query %lu.%03lu ms: %s",
+        usec / 1000, usec % 1000, sql);
+
+    __db_backend_postgresql_sql_init(&explain);
+    if (backend_postgresql->slow_query_redact) {
+        if (params->count) {
+            libdbo_log(LIBDBO_LOG_WARNING, "PostgreSQL slow query values: %d values not shown", params->count);
+        }
+    }
+    else if (params->count) {
+        for (i = 0; i < params->count && !ret; i++) {
+            snprintf(number, sizeof(number), "%s$%d = ", i ? ", " : "", i + 1);
+            ret = __db_backend_postgresql_sql_append(&explain, number, NULL);
+            if (ret) {
+                break;
+            }
+            if (params->types[i] == LIBDBO_BACKEND_POSTGRESQL_TEXTOID) {
+                /*
+                 * Text parameters point to the text of the value and are
+                 * always NUL terminated.
+                 */
+                ret = __db_backend_postgresql_sql_append(&explain, "'", params->values[i], "'", NULL);
+                continue;
+            }
+            buffer = (const unsigned char*)params->values[i];
+            bits = 0;
+            for (j = 0; j < params->lengths[i]; j++) {
+                bits = (bits << 8) | buffer[j];
+            }
+            if (params->lengths[i] == 4) {
+                snprintf(number, sizeof(number), "%ld", (long)(libdbo_type_int32_t)bits);
+            }
+            else {
+                snprintf(number, sizeof(number), "%lld", (long long)(libdbo_type_int64_t)bits);
+            }
+            ret = __db_backend_postgresql_sql_append(&explain, number, NULL);
+        }
+        if (!ret) {
+            libdbo_log(LIBDBO_LOG_WARNING, "PostgreSQL slow query values: %s", explain.string);
+        }
+    }
+
+    __db_backend_postgresql_sql_reset(&explain);
+    if (__db_backend_postgresql_sql_append(&explain, "EXPLAIN ", sql, NULL)) {
+        return;
+    }
+    result = PQexecParams(backend_postgresql->db, explain.string, params->count, params->types,
+        params->values, params->lengths, params->formats, 0);
+    if (result && PQresultStatus(result) == PGRES_TUPLES_OK) {
+        for (i = 0; i < PQntuples(result); i++) {
+            libdbo_log(LIBDBO_LOG_WARNING, "PostgreSQL slow query plan: %s", PQgetvalue(result, i, 0));
+        }
+    }
+    PQclear(result);
+    __db_backend_postgresql_sql_reset(&explain);
+}
+
+/**
+ * Execute the SQL `sql` with the parameters `params` as a named prepared
+ * statement, preparing it first if needed. The SQL is executed as an unnamed
+ * statement if the prepared statement cache is full.
+ *
+ * If `result` is NULL, pipelining is enabled and we are within a transaction
+ * then the statement is only sent in pipeline mode and the result is checked
+ * later by __db_backend_postgresql_pipeline_flush(). Otherwise any pipeline is
+ * flushed first and the statement is executed directly, if that is slower
+ * than the `slow_query` configuration it is logged.
+ * \param[in] backend_postgresql a libdbo_backend_postgresql_t pointer.
+ * \param[in] operation a libdbo_stats_operation_t for tracing.
+ * \param[in] object a libdbo_object_t pointer for tracing.
+ * \param[in] sql a character pointer.
+ * \param[in] params a libdbo_backend_postgresql_params_t pointer.
+ * \param[in] check a LIBDBO_BACKEND_POSTGRESQL_CHECK_* define.
+ * \param[out] result a PGresult pointer pointer to get the result of the
+ * statement or NULL if not needed.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_postgresql_execute(libdbo_backend_postgresql_t* backend_postgresql, libdbo_stats_operation_t operation, const libdbo_object_t* object, const char* sql, libdbo_backend_postgresql_params_t* params, int check, PGresult** result) {
+    libdbo_backend_postgresql_prepared_t* prepared;
+    libdbo_trace_event_t event;
+    struct timespec start, end;
+    unsigned long usec;
+    PGresult* pg_result;
+    int traced;
+    int i;
+    int ret;
+
+    if (!backend_postgresql) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_postgresql->db) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!sql) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!params) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    for (i = 0; i < params->count; i++) {
+        if (!params->values[i]) {
+            params->values[i] = params->buffer + i * 8;
+        }
+    }
+
+    prepared = __db_backend_postgresql_prepared(backend_postgresql, sql, params);
+
+#ifdef LIBPQ_HAS_PIPELINING
+    if (!result && backend_postgresql->pipeline && backend_postgresql->transaction) {
+        if (backend_postgresql->pending_size + 2 > LIBDBO_BACKEND_POSTGRESQL_PIPELINE_MAX
+            && (ret = __db_backend_postgresql_pipeline_flush(backend_postgresql)))
+        {
+            return ret;
+        }
+
+        if (PQpipelineStatus(backend_postgresql->db) == PQ_PIPELINE_OFF
+            && !PQenterPipelineMode(backend_postgresql->db))
+        {
+            libdbo_log(LIBDBO_LOG_ERROR, "PostgreSQL enter pipeline error: %s",
+                PQerrorMessage(backend_postgresql->db));
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+
+        if (prepared && prepared->state == LIBDBO_BACKEND_POSTGRESQL_PREPARED_NONE) {
+            if (!PQsendPrepare(backend_postgresql->db, prepared->name, sql, params->count, params->types)) {
+                libdbo_log(LIBDBO_LOG_ERROR, "PostgreSQL prepare statement error: %s (SQL: %s)",
+                    PQerrorMessage(backend_postgresql->db), sql);
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            prepared->state = LIBDBO_BACKEND_POSTGRESQL_PREPARED_PENDING;
+            backend_postgresql->pending[backend_postgresql->pending_size].prepared = prepared;
+            backend_postgresql->pending[backend_postgresql->pending_size].check = LIBDBO_BACKEND_POSTGRESQL_CHECK_NONE;
+            backend_postgresql->pending_size++;
+        }
+
+        /*
+         * A pipelined statement is traced when it is sent, the result is not
+         * known until the pipeline is flushed.
+         */
+        traced = LIBDBO_TRACE_CALL_BEGIN(&event, "postgresql", operation,
+            object ? libdbo_object_table(object) : NULL, sql, params->count);
+        if ((prepared
+                && !PQsendQueryPrepared(backend_postgresql->db, prepared->name, params->count,
+                    params->values, params->lengths, params->formats, 1))
+            || (!prepared
+                && !PQsendQueryParams(backend_postgresql->db, sql, params->count, params->types,
+                    params->values, params->lengths, params->formats, 1)))
+        {
+            if (traced) {
+                LIBDBO_TRACE_CALL_END(&event, 0, LIBDBO_ERROR_UNKNOWN);
+            }
+            libdbo_log(LIBDBO_LOG_ERROR, "PostgreSQL execute statement error: %s (SQL: %s)",
+                PQerrorMessage(backend_postgresql->db), sql);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        if (traced) {
+            LIBDBO_TRACE_CALL_END(&event, 0, LIBDBO_OK);
+        }
+        backend_postgresql->pending[backend_postgresql->pending_size].prepared = NULL;
+        backend_postgresql->pending[backend_postgresql->pending_size].check = check;
+        backend_postgresql->pending_size++;
+
+        return LIBDBO_OK;
+    }
+#endif
+
+    if ((ret = __db_backend_postgresql_pipeline_flush(backend_postgresql))) {
+        return ret;
+    }
+
+    if (prepared && prepared->state != LIBDBO_BACKEND_POSTGRESQL_PREPARED_DONE) {
+        pg_result = PQprepare(backend_postgresql->db, prepared->name, sql, params->count, params->types);
+        if (!pg_result || PQresultStatus(pg_result) != PGRES_COMMAND_OK) {
+            libdbo_log(LIBDBO_LOG_ERROR, "PostgreSQL prepare statement error: %s (SQL: %s)",
+                pg_result ? PQresultErrorMessage(pg_result) : PQerrorMessage(backend_postgresql->db), sql);
+            PQclear(pg_result);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        PQclear(pg_result);
+        prepared->state = LIBDBO_BACKEND_POSTGRESQL_PREPARED_DONE;
+    }
+
+    if (backend_postgresql->slow_query) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+    }
+    traced = LIBDBO_TRACE_CALL_BEGIN(&event, "postgresql", operation,
+        object ? libdbo_object_table(object) : NULL, sql, params->count);
+    if (prepared) {
+        pg_result = PQexecPrepared(backend_postgresql->db, prepared->name, params->count,
+            params->values, params->lengths, params->formats, 1);
+    }
+    else {
+        pg_result = PQexecParams(backend_postgresql->db, sql, params->count, params->types,
+            params->values, params->lengths, params->formats, 1);
+    }
+    if (backend_postgresql->slow_query) {
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        usec = (end.tv_sec - start.tv_sec) * 1000000 + (end.tv_nsec - start.tv_nsec) / 1000;
+        if (usec >= backend_postgresql->slow_query) {
+            __db_backend_postgresql_slow_query(backend_postgresql, sql, params, usec);
+        }
+    }
+    if (!pg_result) {
+        if (traced) {
+            LIBDBO_TRACE_CALL_END(&event, 0, LIBDBO_ERROR_UNKNOWN);
+        }
+        libdbo_log(LIBDBO_LOG_ERROR, "PostgreSQL execute statement error: %s (SQL: %s)",
+            PQerrorMessage(backend_postgresql->db), sql);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    ret = __db_backend_postgresql_check(pg_result, check, sql);
+    if (traced) {
+        LIBDBO_TRACE_CALL_END(&event,
+            PQresultStatus(pg_result) == PGRES_TUPLES_OK ? (unsigned long long)PQntuples(pg_result) : strtoull(PQcmdTuples(pg_result), NULL, 10),
+            ret);
+    }
+    if (ret) {
+        PQclear(pg_result);
+        return ret;
+    }
+
+    if (result) {
+        *result = pg_result;
+    }
+    else {
+        PQclear(pg_result);
+    }
+    return LIBDBO_OK;
+}
+
+/**
+ * PostgreSQL finish function.
+ *
+ * Frees all data related to a libdbo_backend_postgresql_statement_t.
+ */
+static inline void __db_backend_postgresql_finish(libdbo_backend_postgresql_statement_t* statement) {
+    if (!statement) {
+        return;
+    }
+
+    if (statement->result) {
+        PQclear(statement->result);
+    }
+    if (statement->object_field_list) {
+        libdbo_object_field_list_free(statement->object_field_list);
+    }
+
+    libdbo_mm_delete(&__postgresql_statement_alloc, statement);
+}
+
+/**
+ * Get the integer in binary format at `row` and `column` in a result.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_postgresql_integer(const PGresult* result, int row, int column, libdbo_type_int64_t* integer) {
+    const unsigned char* value;
+    libdbo_type_uint64_t bits = 0;
+    int i, length;
+
+    if (PQgetisnull(result, row, column)) {
+        *integer = 0;
+        return LIBDBO_OK;
+    }
+
+    switch (PQftype(result, column)) {
+    case LIBDBO_BACKEND_POSTGRESQL_INT2OID:
+        length = 2;
+        break;
+
+    case LIBDBO_BACKEND_POSTGRESQL_INT4OID:
+        length = 4;
+        break;
+
+    case LIBDBO_BACKEND_POSTGRESQL_INT8OID:
+        length = 8;
+        break;
+
+    default:
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (PQgetlength(result, row, column) != length
+        || !(value = (const unsigned char*)PQgetvalue(result, row, column)))
+    {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    for (i = 0; i < length; i++) {
+        bits = (bits << 8) | value[i];
+    }
+
+    /*
+     * Sign extend the smaller integers.
+     */
+    switch (length) {
+    case 2:
+        *integer = (int16_t)bits;
+        break;
+
+    case 4:
+        *integer = (libdbo_type_int32_t)bits;
+        break;
+
+    default:
+        *integer = (libdbo_type_int64_t)bits;
+        break;
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Check if the column `column` in a result is text.
+ */
+static inline int __db_backend_postgresql_is_text(const PGresult* result, int column) {
+    switch (PQftype(result, column)) {
+    case LIBDBO_BACKEND_POSTGRESQL_TEXTOID:
+    case LIBDBO_BACKEND_POSTGRESQL_VARCHAROID:
+    case LIBDBO_BACKEND_POSTGRESQL_BPCHAROID:
+        return 1;
+
+    default:
+        break;
+    }
+    return 0;
+}
+
+/**
+ * Set `value` to the text at `row` and `column` in a result.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_postgresql_text(const PGresult* result, int row, int column, libdbo_value_t* value) {
+    if (PQgetisnull(result, row, column) || !PQgetlength(result, row, column)) {
+        return libdbo_value_from_text(value, "");
+    }
+    return libdbo_value_from_text2(value, PQgetvalue(result, row, column), PQgetlength(result, row, column));
+}
+
+/**
+ * Build the clause/WHERE SQL and append it to the SQL buffer `sql`, the
+ * parameters are numbered starting from `number` which is updated.
+ * \param[in] object a libdbo_object_t pointer.
+ * \param[in] clause_list a libdbo_clause_list_t pointer.
+ * \param[in] sql a libdbo_backend_postgresql_sql_t pointer.
+ * \param[in,out] number an integer pointer.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_postgresql_build_clause(const libdbo_object_t* object, const libdbo_clause_list_t* clause_list, libdbo_backend_postgresql_sql_t* sql, int* number) {
+    const libdbo_clause_t* clause;
+    const char* table;
+    const char* operator;
+    int first, ret;
+
+    if (!clause_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!sql) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!number) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    clause = libdbo_clause_list_begin(clause_list);
+    first = 1;
+    while (clause) {
+        if (first) {
+            first = 0;
+        }
+        else {
+            switch (libdbo_clause_operator(clause)) {
+            case LIBDBO_CLAUSE_OPERATOR_AND:
+                ret = __db_backend_postgresql_sql_append(sql, " AND", NULL);
+                break;
+
+            case LIBDBO_CLAUSE_OPERATOR_OR:
+                ret = __db_backend_postgresql_sql_append(sql, " OR", NULL);
+                break;
+
+            default:
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            if (ret) {
+                return ret;
+            }
+        }
+
+        table = libdbo_clause_table(clause) ? libdbo_clause_table(clause) : libdbo_object_table(object);
+        operator = NULL;
+        switch (libdbo_clause_type(clause)) {
+        case LIBDBO_CLAUSE_EQUAL:
+            operator = " = ";
+            break;
+
+        case LIBDBO_CLAUSE_NOT_EQUAL:
+            operator = " != ";
+            break;
+
+        case LIBDBO_CLAUSE_LESS_THEN:
+            operator = " < ";
+            break;
+
+        case LIBDBO_CLAUSE_LESS_OR_EQUAL:
+            operator = " <= ";
+            break;
+
+        case LIBDBO_CLAUSE_GREATER_OR_EQUAL:
+            operator = " >= ";
+            break;
+
+        case LIBDBO_CLAUSE_GREATER_THEN:
+            operator = " > ";
+            break;
+
+        case LIBDBO_CLAUSE_IS_NULL:
+            ret = __db_backend_postgresql_sql_append(sql, " ", table, ".", libdbo_clause_field(clause), " IS NULL", NULL);
+            break;
+
+        case LIBDBO_CLAUSE_IS_NOT_NULL:
+            ret = __db_backend_postgresql_sql_append(sql, " ", table, ".", libdbo_clause_field(clause), " IS NOT NULL", NULL);
+            break;
+
+        case LIBDBO_CLAUSE_NESTED:
+            if ((ret = __db_backend_postgresql_sql_append(sql, " (", NULL))
+                || (ret = __db_backend_postgresql_build_clause(object, libdbo_clause_list(clause), sql, number)))
+            {
+                return ret;
+            }
+            ret = __db_backend_postgresql_sql_append(sql, " )", NULL);
+            break;
+
+        default:
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        if (operator) {
+            if (!(ret = __db_backend_postgresql_sql_append(sql, " ", table, ".", libdbo_clause_field(clause), NULL))) {
+                ret = __db_backend_postgresql_sql_append_param(sql, operator, (*number)++);
+            }
+        }
+        if (ret) {
+            return ret;
+        }
+
+        clause = libdbo_clause_next(clause);
+    }
+    return LIBDBO_OK;
+}
+
+/**
+ * Add a value as a parameter.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_postgresql_bind_value(libdbo_backend_postgresql_params_t* params, const libdbo_value_t* value) {
+    const libdbo_type_int32_t* int32;
+    const libdbo_type_uint32_t* uint32;
+    const libdbo_type_int64_t* int64;
+    const libdbo_type_uint64_t* uint64;
+    const char* text;
+    int value_enum;
+
+    if (!params) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!value) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * PostgreSQL does not have unsigned integers so unsigned 32 bit integers
+     * are sent as 64 bit integers to keep their range.
+     */
+    switch (libdbo_value_type(value)) {
+    case LIBDBO_TYPE_PRIMARY_KEY:
+    case LIBDBO_TYPE_INT32:
+        if (!(int32 = libdbo_value_int32(value))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        return __db_backend_postgresql_params_add_integer(params, LIBDBO_BACKEND_POSTGRESQL_INT4OID, *int32);
+
+    case LIBDBO_TYPE_UINT32:
+        if (!(uint32 = libdbo_value_uint32(value))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        return __db_backend_postgresql_params_add_integer(params, LIBDBO_BACKEND_POSTGRESQL_INT8OID, *uint32);
+
+    case LIBDBO_TYPE_INT64:
+        if (!(int64 = libdbo_value_int64(value))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        return __db_backend_postgresql_params_add_integer(params, LIBDBO_BACKEND_POSTGRESQL_INT8OID, *int64);
+
+    case LIBDBO_TYPE_UINT64:
+        if (!(uint64 = libdbo_value_uint64(value))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        return __db_backend_postgresql_params_add_integer(params, LIBDBO_BACKEND_POSTGRESQL_INT8OID, (libdbo_type_int64_t)*uint64);
+
+    case LIBDBO_TYPE_TEXT:
+        if (!(text = libdbo_value_text(value))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        return __db_backend_postgresql_params_add_text(params, text);
+
+    case LIBDBO_TYPE_ENUM:
+        if (libdbo_value_enum_value(value, &value_enum)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        return __db_backend_postgresql_params_add_integer(params, LIBDBO_BACKEND_POSTGRESQL_INT4OID, value_enum);
+
+    default:
+        break;
+    }
+
+    return LIBDBO_ERROR_UNKNOWN;
+}
+
+/**
+ * Add the values from the clause list as parameters, in the same order as
+ * the placeholders built by __db_backend_postgresql_build_clause().
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_postgresql_bind_clause(libdbo_backend_postgresql_params_t* params, const libdbo_clause_list_t* clause_list) {
+    const libdbo_clause_t* clause;
+
+    if (!params) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!clause_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    clause = libdbo_clause_list_begin(clause_list);
+    while (clause) {
+        switch (libdbo_clause_type(clause)) {
+        case LIBDBO_CLAUSE_EQUAL:
+        case LIBDBO_CLAUSE_NOT_EQUAL:
+        case LIBDBO_CLAUSE_LESS_THEN:
+        case LIBDBO_CLAUSE_LESS_OR_EQUAL:
+        case LIBDBO_CLAUSE_GREATER_OR_EQUAL:
+        case LIBDBO_CLAUSE_GREATER_THEN:
+            if (__db_backend_postgresql_bind_value(params, libdbo_clause_value(clause))) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            break;
+
+        case LIBDBO_CLAUSE_IS_NULL:
+        case LIBDBO_CLAUSE_IS_NOT_NULL:
+            break;
+
+        case LIBDBO_CLAUSE_NESTED:
+            if (__db_backend_postgresql_bind_clause(params, libdbo_clause_list(clause))) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            break;
+
+        default:
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+
+        clause = libdbo_clause_next(clause);
+    }
+    return LIBDBO_OK;
+}
+
+static int __db_backend_postgresql_bind_value_set(libdbo_backend_postgresql_params_t* params, const libdbo_value_set_t* value_set) {
+    size_t i;
+
+    if (!params) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!value_set) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    for (i = 0; i < libdbo_value_set_size(value_set); i++) {
+        if (__db_backend_postgresql_bind_value(params, libdbo_value_set_at(value_set, i))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+    return LIBDBO_OK;
+}
+
+/**
+ * Get the revision number from the value of the revision clause.
+ * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
+ */
+static int __db_backend_postgresql_revision(const libdbo_clause_t* revision_clause, libdbo_type_int64_t* revision_number) {
+    libdbo_type_int32_t int32;
+    libdbo_type_uint32_t uint32;
+    libdbo_type_int64_t int64;
+    libdbo_type_uint64_t uint64;
+
+    switch (libdbo_value_type(libdbo_clause_value(revision_clause))) {
+    case LIBDBO_TYPE_INT32:
+        if (libdbo_value_to_int32(libdbo_clause_value(revision_clause), &int32)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        *revision_number = int32;
+        break;
+
+    case LIBDBO_TYPE_UINT32:
+        if (libdbo_value_to_uint32(libdbo_clause_value(revision_clause), &uint32)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        *revision_number = uint32;
+        break;
+
+    case LIBDBO_TYPE_INT64:
+        if (libdbo_value_to_int64(libdbo_clause_value(revision_clause), &int64)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        *revision_number = int64;
+        break;
+
+    case LIBDBO_TYPE_UINT64:
+        if (libdbo_value_to_uint64(libdbo_clause_value(revision_clause), &uint64)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        *revision_number = uint64;
+        break;
+
+    default:
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Find the revision field of an object.
+ * \return LIBDBO_ERROR_* if the object has more then one revision field,
+ * otherwise LIBDBO_OK.
+ */
+static int __db_backend_postgresql_revision_field(const libdbo_object_t* object, const libdbo_object_field_t** revision_field) {
+    const libdbo_object_field_t* object_field;
+
+    *revision_field = NULL;
+    object_field = libdbo_object_field_list_begin(libdbo_object_object_field_list(object));
+    while (object_field) {
+        if (libdbo_object_field_type(object_field) == LIBDBO_TYPE_REVISION) {
+            if (*revision_field) {
+                /*
+                 * We do not support multiple revision fields.
+                 */
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+
+            *revision_field = object_field;
+        }
+        object_field = libdbo_object_field_next(object_field);
+    }
+
+    return LIBDBO_OK;
+}
+
+static int libdbo_backend_postgresql_initialize(void* data) {
+    libdbo_backend_postgresql_t* backend_postgresql = (libdbo_backend_postgresql_t*)data;
+
+    if (!backend_postgresql) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    __postgresql_initialized = 1;
+    return LIBDBO_OK;
+}
+
+static int libdbo_backend_postgresql_shutdown(void* data) {
+    libdbo_backend_postgresql_t* backend_postgresql = (libdbo_backend_postgresql_t*)data;
+
+    if (!backend_postgresql) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    __postgresql_initialized = 0;
+    return LIBDBO_OK;
+}
+
+static int libdbo_backend_postgresql_connect(void* data, const libdbo_configuration_list_t* configuration_list) {
+    libdbo_backend_postgresql_t* backend_postgresql = (libdbo_backend_postgresql_t*)data;
+    const libdbo_configuration_t* configuration;
+    const char* keywords[7];
+    const char* values[7];
+    char timeout_text[16];
+    double slow_query_ms;
+    int i = 0, timeout;
+
+    if (!__postgresql_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_postgresql) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (backend_postgresql->db) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!configuration_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if ((configuration = libdbo_configuration_list_find(configuration_list, "host"))) {
+        keywords[i] = "host";
+        values[i++] = libdbo_configuration_value(configuration);
+    }
+    if ((configuration = libdbo_configuration_list_find(configuration_list, "port"))
+        && atoi(libdbo_configuration_value(configuration)) > 0)
+    {
+        keywords[i] = "port";
+        values[i++] = libdbo_configuration_value(configuration);
+    }
+    if ((configuration = libdbo_configuration_list_find(configuration_list, "user"))) {
+        keywords[i] = "user";
+        values[i++] = libdbo_configuration_value(configuration);
+    }
+    if ((configuration = libdbo_configuration_list_find(configuration_list, "pass"))) {
+        keywords[i] = "password";
+        values[i++] = libdbo_configuration_value(configuration);
+    }
+    if ((configuration = libdbo_configuration_list_find(configuration_list, "db"))) {
+        keywords[i] = "dbname";
+        values[i++] = libdbo_configuration_value(configuration);
+    }
+
+    backend_postgresql->timeout = LIBDBO_BACKEND_POSTGRESQL_DEFAULT_TIMEOUT;
+    if ((configuration = libdbo_configuration_list_find(configuration_list, "timeout"))) {
+        timeout = atoi(libdbo_configuration_value(configuration));
+        if (timeout > 0) {
+            backend_postgresql->timeout = (unsigned int)timeout;
+        }
+    }
+    snprintf(timeout_text, sizeof(timeout_text), "%u", backend_postgresql->timeout);
+    keywords[i] = "connect_timeout";
+    values[i++] = timeout_text;
+    keywords[i] = NULL;
+    values[i] = NULL;
+
+    backend_postgresql->slow_query = 0;
+    if ((configuration = libdbo_configuration_list_find(configuration_list, "slow_query"))
+        && (slow_query_ms = strtod(libdbo_configuration_value(configuration), NULL)) > 0)
+    {
+        backend_postgresql->slow_query = slow_query_ms * 1000;
+        if (!backend_postgresql->slow_query) {
+            backend_postgresql->slow_query = 1;
+        }
+    }
+    backend_postgresql->slow_query_redact = 0;
+    if ((configuration = libdbo_configuration_list_find(configuration_list, "slow_query_redact"))
+        && atoi(libdbo_configuration_value(configuration)))
+    {
+        backend_postgresql->slow_query_redact = 1;
+    }
+
+    backend_postgresql->pipeline = 0;
+    if ((configuration = libdbo_configuration_list_find(configuration_list, "pipeline"))
+        && atoi(libdbo_configuration_value(configuration)))
+    {
+#ifdef LIBPQ_HAS_PIPELINING
+        backend_postgresql->pipeline = 1;
+#else
+        libdbo_log(LIBDBO_LOG_WARNING, "PostgreSQL pipeline mode is not supported by this libpq, ignoring it");
+#endif
+    }
+
+    if (!(backend_postgresql->db = PQconnectdbParams(keywords, values, 0))
+        || PQstatus(backend_postgresql->db) != CONNECTION_OK)
+    {
+        if (backend_postgresql->db) {
+            libdbo_log(LIBDBO_LOG_ERROR, "PostgreSQL connection error: %s",
+                PQerrorMessage(backend_postgresql->db));
+            PQfinish(backend_postgresql->db);
+            backend_postgresql->db = NULL;
+        }
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    return LIBDBO_OK;
+}
+
+static int libdbo_backend_postgresql_disconnect(void* data) {
+    libdbo_backend_postgresql_t* backend_postgresql = (libdbo_backend_postgresql_t*)data;
+
+    if (!__postgresql_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_postgresql) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_postgresql->db) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (backend_postgresql->transaction) {
+        /*
+         * Rolling back the outer most transaction also discards all the
+         * nested ones.
+         */
+        backend_postgresql->transaction = 1;
+        libdbo_backend_postgresql_transaction_rollback(backend_postgresql);
+    }
+    (void)__db_backend_postgresql_pipeline_flush(backend_postgresql);
+
+    PQfinish(backend_postgresql->db);
+    backend_postgresql->db = NULL;
+    __db_backend_postgresql_prepared_free(backend_postgresql);
+
+    return LIBDBO_OK;
+}
+
+static libdbo_result_t* libdbo_backend_postgresql_next(void* data, int finish) {
+    libdbo_backend_postgresql_statement_t* statement = (libdbo_backend_postgresql_statement_t*)data;
+    libdbo_result_t* result = NULL;
+    libdbo_value_set_t* value_set = NULL;
+    libdbo_value_t* value;
+    const libdbo_object_field_t* object_field;
+    libdbo_type_int64_t integer;
+    int column, ret;
+
+    if (!statement) {
+        return NULL;
+    }
+    if (!statement->object_field_list) {
+        return NULL;
+    }
+    if (!statement->result) {
+        return NULL;
+    }
+
+    if (finish) {
+        __db_backend_postgresql_finish(statement);
+        return NULL;
+    }
+
+    if (statement->row >= statement->rows) {
+        return NULL;
+    }
+
+    if (!(result = libdbo_result_new())
+        || !(value_set = libdbo_value_set_new(statement->fields))
+        || libdbo_result_set_value_set(result, value_set))
+    {
+        libdbo_result_free(result);
+        libdbo_value_set_free(value_set);
+        return NULL;
+    }
+    object_field = libdbo_object_field_list_begin(statement->object_field_list);
+    column = 0;
+    while (object_field) {
+        if (!(value = libdbo_value_set_get(value_set, column))) {
+            libdbo_result_free(result);
+            return NULL;
+        }
+
+        switch (libdbo_object_field_type(object_field)) {
+        case LIBDBO_TYPE_PRIMARY_KEY:
+        case LIBDBO_TYPE_ANY:
+        case LIBDBO_TYPE_REVISION:
+            if (__db_backend_postgresql_is_text(statement->result, column)) {
+                ret = __db_backend_postgresql_text(statement->result, statement->row, column, value);
+            }
+            else if (!(ret = __db_backend_postgresql_integer(statement->result, statement->row, column, &integer))) {
+                if (PQftype(statement->result, column) == LIBDBO_BACKEND_POSTGRESQL_INT8OID) {
+                    ret = libdbo_value_from_int64(value, integer);
+                }
+                else {
+                    ret = libdbo_value_from_int32(value, (libdbo_type_int32_t)integer);
+                }
+            }
+            if (!ret && libdbo_object_field_type(object_field) == LIBDBO_TYPE_PRIMARY_KEY) {
+                ret = libdbo_value_set_primary_key(value);
+            }
+            break;
+
+        case LIBDBO_TYPE_ENUM:
+            /*
+             * Enum needs to be handled elsewhere since we don't know the
+             * enum_set_t here.
+             */
+        case LIBDBO_TYPE_INT32:
+            if (!(ret = __db_backend_postgresql_integer(statement->result, statement->row, column, &integer))) {
+                ret = (libdbo_type_int64_t)(libdbo_type_int32_t)integer != integer
+                    || libdbo_value_from_int32(value, (libdbo_type_int32_t)integer);
+            }
+            break;
+
+        case LIBDBO_TYPE_UINT32:
+            if (!(ret = __db_backend_postgresql_integer(statement->result, statement->row, column, &integer))) {
+                ret = (libdbo_type_int64_t)(libdbo_type_uint32_t)integer != integer
+                    || libdbo_value_from_uint32(value, (libdbo_type_uint32_t)integer);
+            }
+            break;
+
+        case LIBDBO_TYPE_INT64:
+            if (!(ret = __db_backend_postgresql_integer(statement->result, statement->row, column, &integer))) {
+                ret = libdbo_value_from_int64(value, integer);
+            }
+            break;
+
+        case LIBDBO_TYPE_UINT64:
+            if (!(ret = __db_backend_postgresql_integer(statement->result, statement->row, column, &integer))) {
+                ret = libdbo_value_from_uint64(value, (libdbo_type_uint64_t)integer);
+            }
+            break;
+
+        case LIBDBO_TYPE_TEXT:
+            ret = !__db_backend_postgresql_is_text(statement->result, column)
+                || __db_backend_postgresql_text(statement->result, statement->row, column, value);
+            break;
+
+        default:
+            ret = LIBDBO_ERROR_UNKNOWN;
+            break;
+        }
+        if (ret) {
+            libdbo_result_free(result);
+            return NULL;
+        }
+
+        object_field = libdbo_object_field_next(object_field);
+        column++;
+    }
+    statement->row++;
+
+    return result;
+}
+
+static int libdbo_backend_postgresql_create(void* data, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set) {
+    libdbo_backend_postgresql_t* backend_postgresql = (libdbo_backend_postgresql_t*)data;
+    const libdbo_object_field_t* revision_field;
+    const libdbo_backend_postgresql_template_t* template;
+    libdbo_backend_postgresql_params_t params;
+    int ret;
+
+    if (!__postgresql_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_postgresql) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object_field_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!value_set) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * Check if the object has a revision field and keep it for later use.
+     */
+    if (__db_backend_postgresql_revision_field(object, &revision_field)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * Get the cached INSERT SQL for the fields.
+     */
+    if (!(template = __db_backend_postgresql_template(backend_postgresql, LIBDBO_BACKEND_POSTGRESQL_TEMPLATE_INSERT, object, object_field_list, revision_field))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * Bind all the values from value_set and the revision, a new object always
+     * starts on revision 1.
+     */
+    __db_backend_postgresql_params_init(&params);
+    if (__db_backend_postgresql_bind_value_set(&params, value_set)
+        || (revision_field
+            && __db_backend_postgresql_params_add_integer(&params, LIBDBO_BACKEND_POSTGRESQL_INT8OID, 1))
+        || params.count != template->params)
+    {
+        __db_backend_postgresql_params_reset(&params);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * Execute the SQL, this may be pipelined.
+     */
+    if ((ret = __db_backend_postgresql_execute(backend_postgresql, LIBDBO_STATS_CREATE, object, template->sql, &params, LIBDBO_BACKEND_POSTGRESQL_CHECK_ONE, NULL))) {
+        __db_backend_postgresql_params_reset(&params);
+        return ret;
+    }
+    __db_backend_postgresql_params_reset(&params);
+
+    return LIBDBO_OK;
+}
+
+static libdbo_result_list_t* libdbo_backend_postgresql_read(void* data, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list) {
+    libdbo_backend_postgresql_t* backend_postgresql = (libdbo_backend_postgresql_t*)data;
+    const libdbo_join_t* join;
+    const libdbo_backend_postgresql_template_t* template;
+    libdbo_backend_postgresql_sql_t sql;
+    libdbo_backend_postgresql_params_t params;
+    libdbo_result_list_t* result_list;
+    libdbo_backend_postgresql_statement_t* statement;
+    PGresult* result = NULL;
+    int number = 1;
+
+    if (!__postgresql_initialized) {
+        return NULL;
+    }
+    if (!backend_postgresql) {
+        return NULL;
+    }
+    if (!object) {
+        return NULL;
+    }
+
+    if (!(template = __db_backend_postgresql_template(backend_postgresql, LIBDBO_BACKEND_POSTGRESQL_TEMPLATE_SELECT, object, libdbo_object_object_field_list(object), NULL))) {
+        return NULL;
+    }
+
+    __db_backend_postgresql_sql_init(&sql);
+    if (__db_backend_postgresql_sql_append(&sql, template->sql, NULL)) {
+        __db_backend_postgresql_sql_reset(&sql);
+        return NULL;
+    }
+
+    if (join_list) {
+        join = libdbo_join_list_begin(join_list);
+        while (join) {
+            if (__db_backend_postgresql_sql_append(&sql, " INNER JOIN ", libdbo_join_to_table(join),
+                " ON ", libdbo_join_to_table(join), ".", libdbo_join_to_field(join),
+                " = ", libdbo_join_from_table(join), ".", libdbo_join_from_field(join), NULL))
+            {
+                __db_backend_postgresql_sql_reset(&sql);
+                return NULL;
+            }
+            join = libdbo_join_next(join);
+        }
+    }
+
+    __db_backend_postgresql_params_init(&params);
+    if (clause_list) {
+        if ((libdbo_clause_list_begin(clause_list)
+                && __db_backend_postgresql_sql_append(&sql, " WHERE", NULL))
+            || __db_backend_postgresql_build_clause(object, clause_list, &sql, &number)
+            || __db_backend_postgresql_bind_clause(&params, clause_list))
+        {
+            __db_backend_postgresql_sql_reset(&sql);
+            __db_backend_postgresql_params_reset(&params);
+            return NULL;
+        }
+    }
+
+    /*
+     * Execute the SQL.
+     */
+    if (__db_backend_postgresql_execute(backend_postgresql, LIBDBO_STATS_READ, object, sql.string, &params, LIBDBO_BACKEND_POSTGRESQL_CHECK_NONE, &result)) {
+        __db_backend_postgresql_sql_reset(&sql);
+        __db_backend_postgresql_params_reset(&params);
+        return NULL;
+    }
+    __db_backend_postgresql_sql_reset(&sql);
+    __db_backend_postgresql_params_reset(&params);
+
+    if (!(statement = libdbo_mm_new0(&__postgresql_statement_alloc))) {
+        PQclear(result);
+        return NULL;
+    }
+    statement->result = result;
+    statement->fields = libdbo_object_field_list_size(libdbo_object_object_field_list(object));
+    statement->rows = PQntuples(result);
+    if (statement->fields != PQnfields(result)
+        || !(statement->object_field_list = libdbo_object_field_list_new_copy(libdbo_object_object_field_list(object))))
+    {
+        __db_backend_postgresql_finish(statement);
+        return NULL;
+    }
+
+    if (!(result_list = libdbo_result_list_new())
+        || libdbo_result_list_set_next(result_list, libdbo_backend_postgresql_next, statement, statement->rows))
+    {
+        libdbo_result_list_free(result_list);
+        __db_backend_postgresql_finish(statement);
+        return NULL;
+    }
+    return result_list;
+}
+
+static int libdbo_backend_postgresql_update(void* data, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, const libdbo_clause_list_t* clause_list) {
+    libdbo_backend_postgresql_t* backend_postgresql = (libdbo_backend_postgresql_t*)data;
+    const libdbo_object_field_t* revision_field;
+    const libdbo_clause_t* clause;
+    const libdbo_clause_t* revision_clause = NULL;
+    libdbo_type_int64_t revision_number = -1;
+    const libdbo_backend_postgresql_template_t* template;
+    libdbo_backend_postgresql_sql_t sql;
+    libdbo_backend_postgresql_params_t params;
+    int number;
+    int ret;
+
+    if (!__postgresql_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_postgresql) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object_field_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!value_set) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * Check if the object has a revision field and keep it for later use.
+     */
+    if (__db_backend_postgresql_revision_field(object, &revision_field)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (revision_field) {
+        /*
+         * If we have a revision field we should also have it in the clause,
+         * find it and get the value for later use or return error if not found.
+         */
+        clause = libdbo_clause_list_begin(clause_list);
+        while (clause) {
+            if (!strcmp(libdbo_clause_field(clause), libdbo_object_field_name(revision_field))) {
+                revision_clause = clause;
+                break;
+            }
+            clause = libdbo_clause_next(clause);
+        }
+        if (!revision_clause
+            || __db_backend_postgresql_revision(revision_clause, &revision_number))
+        {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+
+    /*
+     * Get the cached UPDATE SQL for the fields and build the clauses, the
+     * clause parameters are numbered after the ones in the template.
+     */
+    if (!(template = __db_backend_postgresql_template(backend_postgresql, LIBDBO_BACKEND_POSTGRESQL_TEMPLATE_UPDATE, object, object_field_list, revision_field))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    number = template->params + 1;
+
+    __db_backend_postgresql_sql_init(&sql);
+    if (__db_backend_postgresql_sql_append(&sql, template->sql, NULL)) {
+        __db_backend_postgresql_sql_reset(&sql);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (clause_list) {
+        if ((libdbo_clause_list_begin(clause_list)
+                && __db_backend_postgresql_sql_append(&sql, " WHERE", NULL))
+            || __db_backend_postgresql_build_clause(object, clause_list, &sql, &number))
+        {
+            __db_backend_postgresql_sql_reset(&sql);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+
+    /*
+     * Bind all the values from value_set, the new revision if we have any and
+     * then the clauses values.
+     */
+    __db_backend_postgresql_params_init(&params);
+    if (__db_backend_postgresql_bind_value_set(&params, value_set)
+        || (revision_field
+            && __db_backend_postgresql_params_add_integer(&params, LIBDBO_BACKEND_POSTGRESQL_INT8OID, revision_number + 1))
+        || params.count != template->params
+        || (clause_list
+            && __db_backend_postgresql_bind_clause(&params, clause_list)))
+    {
+        __db_backend_postgresql_sql_reset(&sql);
+        __db_backend_postgresql_params_reset(&params);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * Execute the SQL, this may be pipelined. If we are using revision we have
+     * to have a positive number of changes otherwise its a failure.
+     */
+    if ((ret = __db_backend_postgresql_execute(backend_postgresql, LIBDBO_STATS_UPDATE, object, sql.string, &params,
+        revision_field ? LIBDBO_BACKEND_POSTGRESQL_CHECK_SOME : LIBDBO_BACKEND_POSTGRESQL_CHECK_NONE, NULL)))
+    {
+        __db_backend_postgresql_sql_reset(&sql);
+        __db_backend_postgresql_params_reset(&params);
+        return ret;
+    }
+    __db_backend_postgresql_sql_reset(&sql);
+    __db_backend_postgresql_params_reset(&params);
+
+    return LIBDBO_OK;
+}
+
+static int libdbo_backend_postgresql_delete(void* data, const libdbo_object_t* object, const libdbo_clause_list_t* clause_list) {
+    libdbo_backend_postgresql_t* backend_postgresql = (libdbo_backend_postgresql_t*)data;
+    libdbo_backend_postgresql_sql_t sql;
+    libdbo_backend_postgresql_params_t params;
+    const libdbo_object_field_t* revision_field;
+    const libdbo_clause_t* clause;
+    int number = 1;
+    int ret;
+
+    if (!__postgresql_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_postgresql) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * Check if the object has a revision field and keep it for later use.
+     */
+    if (__db_backend_postgresql_revision_field(object, &revision_field)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (revision_field) {
+        /*
+         * If we have a revision field we should also have it in the clause,
+         * find it or return error if not found.
+         */
+        clause = libdbo_clause_list_begin(clause_list);
+        while (clause) {
+            if (!strcmp(libdbo_clause_field(clause), libdbo_object_field_name(revision_field))) {
+                break;
+            }
+            clause = libdbo_clause_next(clause);
+        }
+        if (!clause) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+
+    __db_backend_postgresql_sql_init(&sql);
+    if (__db_backend_postgresql_sql_append(&sql, "DELETE FROM ", libdbo_object_table(object), NULL)) {
+        __db_backend_postgresql_sql_reset(&sql);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    __db_backend_postgresql_params_init(&params);
+    if (clause_list) {
+        if ((libdbo_clause_list_begin(clause_list)
+                && __db_backend_postgresql_sql_append(&sql, " WHERE", NULL))
+            || __db_backend_postgresql_build_clause(object, clause_list, &sql, &number)
+            || __db_backend_postgresql_bind_clause(&params, clause_list))
+        {
+            __db_backend_postgresql_sql_reset(&sql);
+            __db_backend_postgresql_params_reset(&params);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+
+    /*
+     * If we are using revision we have to have a positive number of changes
+     * otherwise its a failure.
+     */
+    if ((ret = __db_backend_postgresql_execute(backend_postgresql, LIBDBO_STATS_DELETE, object, sql.string, &params,
+        revision_field ? LIBDBO_BACKEND_POSTGRESQL_CHECK_SOME : LIBDBO_BACKEND_POSTGRESQL_CHECK_NONE, NULL)))
+    {
+        __db_backend_postgresql_sql_reset(&sql);
+        __db_backend_postgresql_params_reset(&params);
+        return ret;
+    }
+    __db_backend_postgresql_sql_reset(&sql);
+    __db_backend_postgresql_params_reset(&params);
+
+    return LIBDBO_OK;
+}
+
+static int libdbo_backend_postgresql_count(void* data, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list, size_t* count) {
+    libdbo_backend_postgresql_t* backend_postgresql = (libdbo_backend_postgresql_t*)data;
+    const libdbo_join_t* join;
+    libdbo_backend_postgresql_sql_t sql;
+    libdbo_backend_postgresql_params_t params;
+    PGresult* result = NULL;
+    libdbo_type_int64_t integer;
+    int number = 1;
+    int ret;
+
+    if (!__postgresql_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_postgresql) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!count) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    __db_backend_postgresql_sql_init(&sql);
+    if (__db_backend_postgresql_sql_append(&sql, "SELECT COUNT(*) FROM ", libdbo_object_table(object), NULL)) {
+        __db_backend_postgresql_sql_reset(&sql);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (join_list) {
+        join = libdbo_join_list_begin(join_list);
+        while (join) {
+            if (__db_backend_postgresql_sql_append(&sql, " INNER JOIN ", libdbo_join_to_table(join),
+                " ON ", libdbo_join_to_table(join), ".", libdbo_join_to_field(join),
+                " = ", libdbo_join_from_table(join), ".", libdbo_join_from_field(join), NULL))
+            {
+                __db_backend_postgresql_sql_reset(&sql);
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            join = libdbo_join_next(join);
+        }
+    }
+
+    __db_backend_postgresql_params_init(&params);
+    if (clause_list) {
+        if ((libdbo_clause_list_begin(clause_list)
+                && __db_backend_postgresql_sql_append(&sql, " WHERE", NULL))
+            || __db_backend_postgresql_build_clause(object, clause_list, &sql, &number)
+            || __db_backend_postgresql_bind_clause(&params, clause_list))
+        {
+            __db_backend_postgresql_sql_reset(&sql);
+            __db_backend_postgresql_params_reset(&params);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+
+    if ((ret = __db_backend_postgresql_execute(backend_postgresql, LIBDBO_STATS_COUNT, object, sql.string, &params, LIBDBO_BACKEND_POSTGRESQL_CHECK_NONE, &result))) {
+        __db_backend_postgresql_sql_reset(&sql);
+        __db_backend_postgresql_params_reset(&params);
+        return ret;
+    }
+    __db_backend_postgresql_sql_reset(&sql);
+    __db_backend_postgresql_params_reset(&params);
+
+    /*
+     * COUNT(*) is returned as a binary 64 bit integer.
+     */
+    if (PQntuples(result) != 1
+        || PQnfields(result) != 1
+        || __db_backend_postgresql_integer(result, 0, 0, &integer)
+        || integer < 0)
+    {
+        PQclear(result);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    PQclear(result);
+
+    *count = (size_t)integer;
+    return LIBDBO_OK;
+}
+
+static int libdbo_backend_postgresql_upsert(void* data, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, const libdbo_clause_list_t* clause_list) {
+    libdbo_backend_postgresql_t* backend_postgresql = (libdbo_backend_postgresql_t*)data;
+    const libdbo_object_field_t* object_field;
+    const libdbo_object_field_t* revision_field;
+    const libdbo_clause_t* clause;
+    const libdbo_clause_t* revision_clause = NULL;
+    libdbo_backend_postgresql_sql_t sql;
+    libdbo_backend_postgresql_params_t params;
+    int ret, first, number;
+
+    if (!__postgresql_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_postgresql) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object_field_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!value_set) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!clause_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!libdbo_object_field_list_begin(object_field_list)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * Check if the object has a revision field and keep it for later use.
+     */
+    if (__db_backend_postgresql_revision_field(object, &revision_field)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * The clauses can only be equal clauses on the unique fields and the
+     * revision field, the revision clause is optional and if given the update
+     * will only be done if the object is still on that revision.
+     */
+    clause = libdbo_clause_list_begin(clause_list);
+    if (!clause) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    while (clause) {
+        if (libdbo_clause_type(clause) != LIBDBO_CLAUSE_EQUAL) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        if (revision_field
+            && !strcmp(libdbo_clause_field(clause), libdbo_object_field_name(revision_field)))
+        {
+            if (revision_clause) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            revision_clause = clause;
+        }
+        clause = libdbo_clause_next(clause);
+    }
+
+    /*
+     * Build the insert with the fields from the given object_field_list and
+     * the revision field if we have one, a new object always starts on
+     * revision 1.
+     */
+    __db_backend_postgresql_sql_init(&sql);
+    ret = __db_backend_postgresql_sql_append(&sql, "INSERT INTO ", libdbo_object_table(object), " (", NULL);
+    object_field = libdbo_object_field_list_begin(object_field_list);
+    first = 1;
+    while (!ret && object_field) {
+        ret = __db_backend_postgresql_sql_append(&sql, first ? " " : ", ", libdbo_object_field_name(object_field), NULL);
+        first = 0;
+        object_field = libdbo_object_field_next(object_field);
+    }
+    if (!ret && revision_field) {
+        ret = __db_backend_postgresql_sql_append(&sql, ", ", libdbo_object_field_name(revision_field), NULL);
+    }
+    if (!ret) {
+        ret = __db_backend_postgresql_sql_append(&sql, " ) VALUES (", NULL);
+    }
+    object_field = libdbo_object_field_list_begin(object_field_list);
+    number = 1;
+    while (!ret && object_field) {
+        ret = __db_backend_postgresql_sql_append_param(&sql, number > 1 ? ", " : " ", number);
+        number++;
+        object_field = libdbo_object_field_next(object_field);
+    }
+    if (!ret && revision_field) {
+        ret = __db_backend_postgresql_sql_append(&sql, ", 1", NULL);
+    }
+
+    /*
+     * Add the conflict target, all clause fields except the revision.
+     */
+    if (!ret) {
+        ret = __db_backend_postgresql_sql_append(&sql, " ) ON CONFLICT (", NULL);
+    }
+    clause = libdbo_clause_list_begin(clause_list);
+    first = 1;
+    while (!ret && clause) {
+        if (clause != revision_clause) {
+            ret = __db_backend_postgresql_sql_append(&sql, first ? " " : ", ", libdbo_clause_field(clause), NULL);
+            first = 0;
+        }
+        clause = libdbo_clause_next(clause);
+    }
+    if (first) {
+        __db_backend_postgresql_sql_reset(&sql);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * Update all the fields with the values that conflicted and bump the
+     * revision if we have one.
+     */
+    if (!ret) {
+        ret = __db_backend_postgresql_sql_append(&sql, " ) DO UPDATE SET", NULL);
+    }
+    object_field = libdbo_object_field_list_begin(object_field_list);
+    first = 1;
+    while (!ret && object_field) {
+        ret = __db_backend_postgresql_sql_append(&sql, first ? " " : ", ", libdbo_object_field_name(object_field), " = EXCLUDED.", libdbo_object_field_name(object_field), NULL);
+        first = 0;
+        object_field = libdbo_object_field_next(object_field);
+    }
+    if (!ret && revision_field) {
+        ret = __db_backend_postgresql_sql_append(&sql, ", ", libdbo_object_field_name(revision_field), " = ", libdbo_object_table(object), ".", libdbo_object_field_name(revision_field), " + 1", NULL);
+    }
+    if (!ret && revision_clause) {
+        if (!(ret = __db_backend_postgresql_sql_append(&sql, " WHERE ", libdbo_object_table(object), ".", libdbo_object_field_name(revision_field), NULL))) {
+            ret = __db_backend_postgresql_sql_append_param(&sql, " = ", number);
+        }
+    }
+    if (ret) {
+        __db_backend_postgresql_sql_reset(&sql);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * Bind all the values from value_set and the current revision if given.
+     */
+    __db_backend_postgresql_params_init(&params);
+    if (__db_backend_postgresql_bind_value_set(&params, value_set)
+        || (revision_clause
+            && __db_backend_postgresql_bind_value(&params, libdbo_clause_value(revision_clause))))
+    {
+        __db_backend_postgresql_sql_reset(&sql);
+        __db_backend_postgresql_params_reset(&params);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * If the update was restricted to a revision we have to have a positive
+     * number of changes otherwise the object was changed by someone else.
+     */
+    if ((ret = __db_backend_postgresql_execute(backend_postgresql, LIBDBO_STATS_UPSERT, object, sql.string, &params,
+        revision_clause ? LIBDBO_BACKEND_POSTGRESQL_CHECK_SOME : LIBDBO_BACKEND_POSTGRESQL_CHECK_NONE, NULL)))
+    {
+        __db_backend_postgresql_sql_reset(&sql);
+        __db_backend_postgresql_params_reset(&params);
+        return ret;
+    }
+    __db_backend_postgresql_sql_reset(&sql);
+    __db_backend_postgresql_params_reset(&params);
+
+    return LIBDBO_OK;
+}
+
+static void libdbo_backend_postgresql_free(void* data) {
+    libdbo_backend_postgresql_t* backend_postgresql = (libdbo_backend_postgresql_t*)data;
+
+    if (backend_postgresql) {
+        if (backend_postgresql->db) {
+            (void)libdbo_backend_postgresql_disconnect(backend_postgresql);
+        }
+        __db_backend_postgresql_template_free(backend_postgresql);
+        __db_backend_postgresql_prepared_free(backend_postgresql);
+        libdbo_mm_delete(&__postgresql_alloc, backend_postgresql);
+    }
+}
+
+/**
+ * Execute a SQL statement that does not return any rows, this uses the simple
+ * query protocol since it is only used for transaction statements. Any
+ * pipelined statements are flushed first and if that fails the SQL is not
+ * executed unless `force` is set.
+ */
+static int __db_backend_postgresql_exec(libdbo_backend_postgresql_t* backend_postgresql, libdbo_stats_operation_t operation, const char* sql, int force) {
+    libdbo_trace_event_t event;
+    PGresult* result;
+    int traced;
+    int ret;
+
+    if (!backend_postgresql) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_postgresql->db) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!sql) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if ((ret = __db_backend_postgresql_pipeline_flush(backend_postgresql)) && !force) {
+        return ret;
+    }
+
+    traced = LIBDBO_TRACE_CALL_BEGIN(&event, "postgresql", operation, NULL, sql, 0);
+    result = PQexec(backend_postgresql->db, sql);
+    if (traced) {
+        LIBDBO_TRACE_CALL_END(&event, 0,
+            result && PQresultStatus(result) == PGRES_COMMAND_OK ? LIBDBO_OK : LIBDBO_ERROR_UNKNOWN);
+    }
+    if (!result
+        || PQresultStatus(result) != PGRES_COMMAND_OK)
+    {
+        libdbo_log(LIBDBO_LOG_ERROR, "PostgreSQL query error: %s (SQL: %s)",
+            result ? PQresultErrorMessage(result) : PQerrorMessage(backend_postgresql->db), sql);
+        PQclear(result);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    PQclear(result);
+
+    return LIBDBO_OK;
+}
+
+/*
+ * Transactions can be nested, the outer most transaction is a real PostgreSQL
+ * transaction and each nested transaction is a savepoint named after the
+ * depth it was started at.
+ */
+
+static int libdbo_backend_postgresql_transaction_begin(void* data) {
+    libdbo_backend_postgresql_t* backend_postgresql = (libdbo_backend_postgresql_t*)data;
+    char sql[64];
+
+    if (!__postgresql_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_postgresql) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (!backend_postgresql->transaction) {
+        if (__db_backend_postgresql_exec(backend_postgresql, LIBDBO_STATS_TRANSACTION_BEGIN, "BEGIN", 0)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+    else {
+        if (snprintf(sql, sizeof(sql), "SAVEPOINT libdbo_%d", backend_postgresql->transaction) >= (int)sizeof(sql)
+            || __db_backend_postgresql_exec(backend_postgresql, LIBDBO_STATS_TRANSACTION_BEGIN, sql, 0))
+        {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+
+    backend_postgresql->transaction++;
+    return LIBDBO_OK;
+}
+
+static int libdbo_backend_postgresql_transaction_commit(void* data) {
+    libdbo_backend_postgresql_t* backend_postgresql = (libdbo_backend_postgresql_t*)data;
+    char sql[64];
+    int ret;
+
+    if (!__postgresql_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_postgresql) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_postgresql->transaction) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * A failed pipelined statement fails the commit with its error, such as
+     * LIBDBO_ERROR_REVISION, and the transaction is left open so that it can
+     * be rolled back.
+     */
+    if (backend_postgresql->transaction == 1) {
+        if ((ret = __db_backend_postgresql_exec(backend_postgresql, LIBDBO_STATS_TRANSACTION_COMMIT, "COMMIT", 0))) {
+            return ret;
+        }
+    }
+    else {
+        if (snprintf(sql, sizeof(sql), "RELEASE SAVEPOINT libdbo_%d", backend_postgresql->transaction - 1) >= (int)sizeof(sql)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        if ((ret = __db_backend_postgresql_exec(backend_postgresql, LIBDBO_STATS_TRANSACTION_COMMIT, sql, 0))) {
+            return ret;
+        }
+    }
+
+    backend_postgresql->transaction--;
+    return LIBDBO_OK;
+}
+
+static int libdbo_backend_postgresql_transaction_rollback(void* data) {
+    libdbo_backend_postgresql_t* backend_postgresql = (libdbo_backend_postgresql_t*)data;
+    char sql[64];
+
+    if (!__postgresql_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_postgresql) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_postgresql->transaction) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * The errors of any pipelined statements are discarded since they are
+     * rolled back.
+     */
+    if (backend_postgresql->transaction == 1) {
+        if (__db_backend_postgresql_exec(backend_postgresql, LIBDBO_STATS_TRANSACTION_ROLLBACK, "ROLLBACK", 1)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+    else {
+        /*
+         * Rolling back to a savepoint keeps it so it also needs to be
+         * released.
+         */
+        if (snprintf(sql, sizeof(sql), "ROLLBACK TO SAVEPOINT libdbo_%d", backend_postgresql->transaction - 1) >= (int)sizeof(sql)
+            || __db_backend_postgresql_exec(backend_postgresql, LIBDBO_STATS_TRANSACTION_ROLLBACK, sql, 1)
+            || snprintf(sql, sizeof(sql), "RELEASE SAVEPOINT libdbo_%d", backend_postgresql->transaction - 1) >= (int)sizeof(sql)
+            || __db_backend_postgresql_exec(backend_postgresql, LIBDBO_STATS_TRANSACTION_ROLLBACK, sql, 0))
+        {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+
+    backend_postgresql->transaction--;
+    return LIBDBO_OK;
+}
+
+libdbo_backend_handle_t* libdbo_backend_postgresql_new_handle(void) {
+    libdbo_backend_handle_t* backend_handle = NULL;
+    libdbo_backend_postgresql_t* backend_postgresql =
+        (libdbo_backend_postgresql_t*)libdbo_mm_new0(&__postgresql_alloc);
+
+    if (backend_postgresql && (backend_handle = libdbo_backend_handle_new())) {
+        if (libdbo_backend_handle_set_data(backend_handle, (void*)backend_postgresql)
+            || libdbo_backend_handle_set_initialize(backend_handle, libdbo_backend_postgresql_initialize)
+            || libdbo_backend_handle_set_shutdown(backend_handle, libdbo_backend_postgresql_shutdown)
+            || libdbo_backend_handle_set_connect(backend_handle, libdbo_backend_postgresql_connect)
+            || libdbo_backend_handle_set_disconnect(backend_handle, libdbo_backend_postgresql_disconnect)
+            || libdbo_backend_handle_set_create(backend_handle, libdbo_backend_postgresql_create)
+            || libdbo_backend_handle_set_read(backend_handle, libdbo_backend_postgresql_read)
+            || libdbo_backend_handle_set_update(backend_handle, libdbo_backend_postgresql_update)
+            || libdbo_backend_handle_set_delete(backend_handle, libdbo_backend_postgresql_delete)
+            || libdbo_backend_handle_set_count(backend_handle, libdbo_backend_postgresql_count)
+            || libdbo_backend_handle_set_upsert(backend_handle, libdbo_backend_postgresql_upsert)
+            || libdbo_backend_handle_set_free(backend_handle, libdbo_backend_postgresql_free)
+            || libdbo_backend_handle_set_transaction_begin(backend_handle, libdbo_backend_postgresql_transaction_begin)
+            || libdbo_backend_handle_set_transaction_commit(backend_handle, libdbo_backend_postgresql_transaction_commit)
+            || libdbo_backend_handle_set_transaction_rollback(backend_handle, libdbo_backend_postgresql_transaction_rollback))
+        {
+            libdbo_backend_handle_free(backend_handle);
+            libdbo_mm_delete(&__postgresql_alloc, backend_postgresql);
+            return NULL;
+        }
+    }
+    return backend_handle;
+}
@@ -33,11 +33,14 @@
  * All rights reserved.
  */
 
+#include "config.h"
+
 #include "libdbo/backend/sqlite.h"
 
 #include "libdbo/error.h"
 #include "libdbo/mm.h"
 #include "libdbo/log.h"
+#include "libdbo/trace.h"
 
 #include <stdlib.h>
 #include <sqlite3.h>
@@ -47,6 +50,7 @@
 #include <time.h>
 #include <pthread.h>
 #include <errno.h>
+#include <stdarg.h>
 
 static int libdbo_backend_sqlite_transaction_rollback(void*);
 
@@ -67,15 +71,54 @@ static int __sqlite3_initialized = 0;
 static pthread_mutex_t __sqlite_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t __sqlite_cond = PTHREAD_COND_INITIALIZER;
 
+/**
+ * The types of SQL templates that are cached per object.
+ */
+#define LIBDBO_BACKEND_SQLITE_TEMPLATE_SELECT 1
+#define LIBDBO_BACKEND_SQLITE_TEMPLATE_INSERT 2
+#define LIBDBO_BACKEND_SQLITE_TEMPLATE_UPDATE 3
+
+/**
+ * A cached SQL template, the static part of the SQL for an operation on a
+ * table with a specific set of fields. The fields are stored comma separated
+ * and are used together with the type, table and revision field to find the
+ * template.
+ */
+typedef struct libdbo_backend_sqlite_template libdbo_backend_sqlite_template_t;
+struct libdbo_backend_sqlite_template {
+    libdbo_backend_sqlite_template_t* next;
+    int type;
+    char* table;
+    char* fields;
+    char* revision;
+    char* sql;
+    size_t length;
+    int fields_size;
+};
+
+static libdbo_mm_t __sqlite_template_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_backend_sqlite_template_t));
+
 /**
  * The SQLite database backend specific data.
  */
 typedef struct libdbo_backend_sqlite {
     sqlite3* db;
+    /** The depth of nested transactions, zero if none. */
     int transaction;
     int timeout;
     int time;
     long usleep;
+    /** Steps taking at least this many microseconds are logged, 0 if not. */
+    unsigned long slow_query;
+    /** If the values bound to a slow statement are left out of the log. */
+    int slow_query_redact;
+    /**
+     * The rows changed by the last step, kept since logging a slow step
+     * executes other statements.
+     */
+    int changes;
+    /** The cached SQL templates. */
+    libdbo_backend_sqlite_template_t* template_list;
 } libdbo_backend_sqlite_t;
 
 static libdbo_mm_t __sqlite_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_backend_sqlite_t));
@@ -92,6 +135,275 @@ typedef struct libdbo_backend_sqlite_statement {
 
 static libdbo_mm_t __sqlite_statement_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_backend_sqlite_statement_t));
 
+/**
+ * The initial size of the SQL buffer, this is kept on the stack and only SQL
+ * larger then this will be allocated.
+ */
+#define LIBDBO_BACKEND_SQLITE_SQL_SIZE 1024
+
+/**
+ * A growable buffer used to build SQL.
+ */
+typedef struct libdbo_backend_sqlite_sql {
+    char* string;
+    size_t length;
+    size_t size;
+    char buffer[LIBDBO_BACKEND_SQLITE_SQL_SIZE];
+} libdbo_backend_sqlite_sql_t;
+
+/**
+ * Initialize a SQL buffer.
+ */
+static inline void __db_backend_sqlite_sql_init(libdbo_backend_sqlite_sql_t* sql) {
+    sql->string = sql->buffer;
+    sql->length = 0;
+    sql->size = sizeof(sql->buffer);
+    sql->buffer[0] = 0;
+}
+
+/**
+ * Release any memory allocated by a SQL buffer.
+ */
+static inline void __db_backend_sqlite_sql_reset(libdbo_backend_sqlite_sql_t* sql) {
+    if (sql->string != sql->buffer) {
+        free(sql->string);
+    }
+    __db_backend_sqlite_sql_init(sql);
+}
+
+/**
+ * Append one or more strings to a SQL buffer, the list of strings must be
+ * terminated by a NULL.
+ */
+static int __db_backend_sqlite_sql_append(libdbo_backend_sqlite_sql_t* sql, ...) {
+    va_list ap;
+    const char* string;
+    size_t length, size;
+    char* new_string;
+
+    if (!sql) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    va_start(ap, sql);
+    while ((string = va_arg(ap, const char*))) {
+        length = strlen(string);
+        if (sql->length + length >= sql->size) {
+            size = sql->size * 2;
+            while (sql->length + length >= size) {
+                size *= 2;
+            }
+            if (sql->string == sql->buffer) {
+                if ((new_string = malloc(size))) {
+                    memcpy(new_string, sql->buffer, sql->length + 1);
+                }
+            }
+            else {
+                new_string = realloc(sql->string, size);
+            }
+            if (!new_string) {
+                va_end(ap);
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            sql->string = new_string;
+            sql->size = size;
+        }
+        memcpy(sql->string + sql->length, string, length + 1);
+        sql->length += length;
+    }
+    va_end(ap);
+
+    return LIBDBO_OK;
+}
+
+/**
+ * Free all the cached SQL templates.
+ */
+static void __db_backend_sqlite_template_free(libdbo_backend_sqlite_t* backend_sqlite) {
+    libdbo_backend_sqlite_template_t* template;
+
+    while ((template = backend_sqlite->template_list)) {
+        backend_sqlite->template_list = template->next;
+        free(template->table);
+        free(template->fields);
+        free(template->revision);
+        free(template->sql);
+        libdbo_mm_delete(&__sqlite_template_alloc, template);
+    }
+}
+
+/**
+ * Check if a template matches the fields in `object_field_list`.
+ */
+static int __db_backend_sqlite_template_match(const libdbo_backend_sqlite_template_t* template, const libdbo_object_field_list_t* object_field_list) {
+    const libdbo_object_field_t* object_field;
+    const char* fields = template->fields;
+    size_t length;
+
+    object_field = libdbo_object_field_list_begin(object_field_list);
+    while (object_field) {
+        length = strlen(libdbo_object_field_name(object_field));
+        if (strncmp(fields, libdbo_object_field_name(object_field), length)) {
+            return 0;
+        }
+        fields += length;
+        if (*fields == ',') {
+            fields++;
+        }
+        else if (*fields) {
+            return 0;
+        }
+        object_field = libdbo_object_field_next(object_field);
+    }
+
+    return !*fields;
+}
+
+/**
+ * Get the SQL template of type `type` for the object with the fields in
+ * `object_field_list` and the revision field `revision_field`, the template is
+ * created and cached if it does not already exist.
+ * \param[in] backend_sqlite a libdbo_backend_sqlite_t pointer.
+ * \param[in] type an integer.
+ * \param[in] object a libdbo_object_t pointer.
+ * \param[in] object_field_list a libdbo_object_field_list_t pointer.
+ * \param[in] revision_field a libdbo_object_field_t pointer or NULL.
+ * \return a libdbo_backend_sqlite_template_t pointer or NULL on error.
+ */
+static const libdbo_backend_sqlite_template_t* __db_backend_sqlite_template(libdbo_backend_sqlite_t* backend_sqlite, int type, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_object_field_t* revision_field) {
+    libdbo_backend_sqlite_template_t* template;
+    const libdbo_object_field_t* object_field;
+    const char* table = libdbo_object_table(object);
+    const char* revision = revision_field ? libdbo_object_field_name(revision_field) : NULL;
+    libdbo_backend_sqlite_sql_t sql;
+    libdbo_backend_sqlite_sql_t fields;
+    int first, fields_size, ret;
+
+    for (template = backend_sqlite->template_list; template; template = template->next) {
+        if (template->type == type
+            && !strcmp(template->table, table)
+            && (revision ? (template->revision && !strcmp(template->revision, revision)) : !template->revision)
+            && __db_backend_sqlite_template_match(template, object_field_list))
+        {
+            return template;
+        }
+    }
+
+    __db_backend_sqlite_sql_init(&sql);
+    __db_backend_sqlite_sql_init(&fields);
+    ret = LIBDBO_OK;
+
+    switch (type) {
+    case LIBDBO_BACKEND_SQLITE_TEMPLATE_SELECT:
+        ret = __db_backend_sqlite_sql_append(&sql, "SELECT", NULL);
+        break;
+
+    case LIBDBO_BACKEND_SQLITE_TEMPLATE_INSERT:
+        if (!libdbo_object_field_list_begin(object_field_list) && !revision) {
+            /*
+             * Special case when tables has no fields except maybe a primary key.
+             */
+            ret = __db_backend_sqlite_sql_append(&sql, "INSERT INTO ", table, " DEFAULT VALUES", NULL);
+        }
+        else {
+            ret = __db_backend_sqlite_sql_append(&sql, "INSERT INTO ", table, " (", NULL);
+        }
+        break;
+
+    case LIBDBO_BACKEND_SQLITE_TEMPLATE_UPDATE:
+        ret = __db_backend_sqlite_sql_append(&sql, "UPDATE ", table, " SET", NULL);
+        break;
+
+    default:
+        return NULL;
+    }
+
+    object_field = libdbo_object_field_list_begin(object_field_list);
+    first = 1;
+    fields_size = 0;
+    while (!ret && object_field) {
+        switch (type) {
+        case LIBDBO_BACKEND_SQLITE_TEMPLATE_SELECT:
+            ret = __db_backend_sqlite_sql_append(&sql, first ? " " : ", ", table, ".", libdbo_object_field_name(object_field), NULL);
+            break;
+
+        case LIBDBO_BACKEND_SQLITE_TEMPLATE_INSERT:
+            ret = __db_backend_sqlite_sql_append(&sql, first ? " " : ", ", libdbo_object_field_name(object_field), NULL);
+            break;
+
+        case LIBDBO_BACKEND_SQLITE_TEMPLATE_UPDATE:
+            ret = __db_backend_sqlite_sql_append(&sql, first ? " " : ", ", libdbo_object_field_name(object_field), " = ?", NULL);
+            break;
+        }
+        if (!ret) {
+            ret = __db_backend_sqlite_sql_append(&fields, first ? "" : ",", libdbo_object_field_name(object_field), NULL);
+        }
+        first = 0;
+        fields_size++;
+
+        object_field = libdbo_object_field_next(object_field);
+    }
+
+    switch (type) {
+    case LIBDBO_BACKEND_SQLITE_TEMPLATE_SELECT:
+        if (!ret) {
+            ret = __db_backend_sqlite_sql_append(&sql, " FROM ", table, NULL);
+        }
+        break;
+
+    case LIBDBO_BACKEND_SQLITE_TEMPLATE_INSERT:
+        if (!libdbo_object_field_list_begin(object_field_list) && !revision) {
+            break;
+        }
+        if (!ret && revision) {
+            ret = __db_backend_sqlite_sql_append(&sql, first ? " " : ", ", revision, NULL);
+        }
+        if (!ret) {
+            ret = __db_backend_sqlite_sql_append(&sql, " ) VALUES (", NULL);
+        }
+        for (first = 0; !ret && first < fields_size + (revision ? 1 : 0); first++) {
+            ret = __db_backend_sqlite_sql_append(&sql, first ? ", ?" : " ?", NULL);
+        }
+        if (!ret) {
+            ret = __db_backend_sqlite_sql_append(&sql, " )", NULL);
+        }
+        break;
+
+    case LIBDBO_BACKEND_SQLITE_TEMPLATE_UPDATE:
+        if (!ret && revision) {
+            ret = __db_backend_sqlite_sql_append(&sql, first ? " " : ", ", revision, " = ?", NULL);
+        }
+        break;
+    }
+
+    if (ret
+        || !(template = libdbo_mm_new0(&__sqlite_template_alloc))
+        || !(template->table = strdup(table))
+        || !(template->fields = strdup(fields.string))
+        || (revision && !(template->revision = strdup(revision)))
+        || !(template->sql = strdup(sql.string)))
+    {
+        if (template) {
+            free(template->table);
+            free(template->fields);
+            free(template->revision);
+            libdbo_mm_delete(&__sqlite_template_alloc, template);
+        }
+        __db_backend_sqlite_sql_reset(&sql);
+        __db_backend_sqlite_sql_reset(&fields);
+        return NULL;
+    }
+    template->type = type;
+    template->length = sql.length;
+    template->fields_size = fields_size;
+    template->next = backend_sqlite->template_list;
+    backend_sqlite->template_list = template;
+
+    __db_backend_sqlite_sql_reset(&sql);
+    __db_backend_sqlite_sql_reset(&fields);
+    return template;
+}
+
 /**
  * The SQLite bust handler that is used to wait for database access.
  */
@@ -178,10 +490,56 @@ static inline int __db_backend_sqlite_prepare(libdbo_backend_sqlite_t* backend_s
     return LIBDBO_OK;
 }
 
+/**
+ * Log a statement that was slow to step together with the query plan SQLite
+ * uses for it. The plan is explained without any values bound, it is the same
+ * unless the values make SQLite choose another index. The values are only
+ * shown with SQLite 3.14.0 or later which can expand them into the SQL.
+ */
+static void __db_backend_sqlite_slow_query(libdbo_backend_sqlite_t* backend_sqlite, sqlite3_stmt* statement, unsigned long usec) {
+    libdbo_backend_sqlite_sql_t sql;
+    sqlite3_stmt* explain = NULL;
+    char* expanded = NULL;
+
+#if SQLITE_VERSION_NUMBER >= 3014000
+    if (!backend_sqlite->slow_query_redact) {
+        expanded = sqlite3_expanded_sql(statement);
+    }
+#endif
+    if (expanded) {
+        libdbo_log(LIBDBO_LOG_WARNING, "SQLite slow query %lu.%03lu ms: %s",
+            usec / 1000, usec % 1000, expanded);
+        sqlite3_free(expanded);
+    }
+    else {
+        libdbo_log(LIBDBO_LOG_WARNING, "SQLite slow query %lu.%03lu ms: %s (%d values not shown)",
+            usec / 1000, usec % 1000, sqlite3_sql(statement), sqlite3_bind_parameter_count(statement));
+    }
+
+    __db_backend_sqlite_sql_init(&sql);
+    if (!__db_backend_sqlite_sql_append(&sql, "EXPLAIN QUERY PLAN ", sqlite3_sql(statement), NULL)
+        && sqlite3_prepare_v2(backend_sqlite->db, sql.string, sql.length, &explain, NULL) == SQLITE_OK)
+    {
+        while (sqlite3_step(explain) == SQLITE_ROW) {
+            libdbo_log(LIBDBO_LOG_WARNING, "SQLite slow query plan: %s",
+                (const char*)sqlite3_column_text(explain, 3));
+        }
+    }
+    sqlite3_finalize(explain);
+    __db_backend_sqlite_sql_reset(&sql);
+}
+
 /**
  * SQLite step function.
+ *
+ * Each step is a traced call, reads are stepped once for every row. Steps
+ * slower than the `slow_query` configuration are logged.
  */
-static inline int __db_backend_sqlite_step(libdbo_backend_sqlite_t* backend_sqlite, sqlite3_stmt* statement) {
+static inline int __db_backend_sqlite_step(libdbo_backend_sqlite_t* backend_sqlite, sqlite3_stmt* statement, libdbo_stats_operation_t operation, const libdbo_object_t* object) {
+    libdbo_trace_event_t event;
+    struct timespec start, end;
+    unsigned long usec;
+    int traced;
     int ret;
 
     if (!backend_sqlite) {
@@ -192,7 +550,26 @@ static inline int __db_backend_sqlite_step(libdbo_backend_sqlite_t* backend_sqli
     }
 
     backend_sqlite->time = time(NULL);
+    if (backend_sqlite->slow_query) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+    }
+    traced = LIBDBO_TRACE_CALL_BEGIN(&event, "sqlite", operation,
+        object ? libdbo_object_table(object) : NULL,
+        sqlite3_sql(statement), sqlite3_bind_parameter_count(statement));
     ret = sqlite3_step(statement);
+    backend_sqlite->changes = sqlite3_changes(backend_sqlite->db);
+    if (traced) {
+        LIBDBO_TRACE_CALL_END(&event,
+            ret == SQLITE_ROW ? 1 : (ret == SQLITE_DONE && !sqlite3_stmt_readonly(statement) ? backend_sqlite->changes : 0),
+            ret == SQLITE_ROW || ret == SQLITE_DONE ? LIBDBO_OK : LIBDBO_ERROR_UNKNOWN);
+    }
+    if (backend_sqlite->slow_query) {
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        usec = (end.tv_sec - start.tv_sec) * 1000000 + (end.tv_nsec - start.tv_nsec) / 1000;
+        if (usec >= backend_sqlite->slow_query) {
+            __db_backend_sqlite_slow_query(backend_sqlite, statement, usec);
+        }
+    }
 
     return ret;
 }
@@ -250,6 +627,8 @@ static int libdbo_backend_sqlite_connect(void* data, const libdbo_configuration_
     const libdbo_configuration_t* file;
     const libdbo_configuration_t* timeout;
     const libdbo_configuration_t* usleep;
+    const libdbo_configuration_t* slow_query;
+    double slow_query_ms;
     int ret;
 
     if (!__sqlite3_initialized) {
@@ -285,6 +664,22 @@ static int libdbo_backend_sqlite_connect(void* data, const libdbo_configuration_
         }
     }
 
+    backend_sqlite->slow_query = 0;
+    if ((slow_query = libdbo_configuration_list_find(configuration_list, "slow_query"))
+        && (slow_query_ms = strtod(libdbo_configuration_value(slow_query), NULL)) > 0)
+    {
+        backend_sqlite->slow_query = slow_query_ms * 1000;
+        if (!backend_sqlite->slow_query) {
+            backend_sqlite->slow_query = 1;
+        }
+    }
+    backend_sqlite->slow_query_redact = 0;
+    if ((slow_query = libdbo_configuration_list_find(configuration_list, "slow_query_redact"))
+        && atoi(libdbo_configuration_value(slow_query)))
+    {
+        backend_sqlite->slow_query_redact = 1;
+    }
+
     ret = sqlite3_open_v2(
         libdbo_configuration_value(file),
         &(backend_sqlite->db),
@@ -319,6 +714,11 @@ static int libdbo_backend_sqlite_disconnect(void* data) {
     }
 
     if (backend_sqlite->transaction) {
+        /*
+         * Rolling back the outer most transaction also discards all the
+         * nested ones.
+         */
+        backend_sqlite->transaction = 1;
         libdbo_backend_sqlite_transaction_rollback(backend_sqlite);
     }
     ret = sqlite3_close(backend_sqlite->db);
@@ -330,31 +730,21 @@ static int libdbo_backend_sqlite_disconnect(void* data) {
 }
 
 /**
- * Build the clause/WHERE SQL and append it to `sqlp`, how much that is left in
- * the buffer pointed by `sqlp` is specified by `left`.
+ * Build the clause/WHERE SQL and append it to the SQL buffer `sql`.
  * \param[in] object a libdbo_object_t pointer.
  * \param[in] clause_list a libdbo_clause_list_t pointer.
- * \param[in] sqlp a character pointer pointer.
- * \param[in] left an integer pointer.
+ * \param[in] sql a libdbo_backend_sqlite_sql_t pointer.
  * \return LIBDBO_ERROR_* on failure, otherwise LIBDBO_OK.
  */
-static int __db_backend_sqlite_build_clause(const libdbo_object_t* object, const libdbo_clause_list_t* clause_list, char** sqlp, int* left) {
+static int __db_backend_sqlite_build_clause(const libdbo_object_t* object, const libdbo_clause_list_t* clause_list, libdbo_backend_sqlite_sql_t* sql) {
     const libdbo_clause_t* clause;
+    const char* table;
     int first, ret;
 
     if (!clause_list) {
         return LIBDBO_ERROR_UNKNOWN;
     }
-    if (!sqlp) {
-        return LIBDBO_ERROR_UNKNOWN;
-    }
-    if (!*sqlp) {
-        return LIBDBO_ERROR_UNKNOWN;
-    }
-    if (!left) {
-        return LIBDBO_ERROR_UNKNOWN;
-    }
-    if (*left < 1) {
+    if (!sql) {
         return LIBDBO_ERROR_UNKNOWN;
     }
 
@@ -367,116 +757,70 @@ static int __db_backend_sqlite_build_clause(const libdbo_object_t* object, const
         else {
             switch (libdbo_clause_operator(clause)) {
             case LIBDBO_CLAUSE_OPERATOR_AND:
-                if ((ret = snprintf(*sqlp, *left, " AND")) >= *left) {
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
+                ret = __db_backend_sqlite_sql_append(sql, " AND", NULL);
                 break;
 
             case LIBDBO_CLAUSE_OPERATOR_OR:
-                if ((ret = snprintf(*sqlp, *left, " OR")) >= *left) {
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
+                ret = __db_backend_sqlite_sql_append(sql, " OR", NULL);
                 break;
 
             default:
                 return LIBDBO_ERROR_UNKNOWN;
             }
-            *sqlp += ret;
-            *left -= ret;
+            if (ret) {
+                return ret;
+            }
         }
 
+        table = libdbo_clause_table(clause) ? libdbo_clause_table(clause) : libdbo_object_table(object);
         switch (libdbo_clause_type(clause)) {
         case LIBDBO_CLAUSE_EQUAL:
-            if ((ret = snprintf(*sqlp, *left, " %s.%s = ?",
-                (libdbo_clause_table(clause) ? libdbo_clause_table(clause) : libdbo_object_table(object)),
-                libdbo_clause_field(clause))) >= *left)
-            {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
+            ret = __db_backend_sqlite_sql_append(sql, " ", table, ".", libdbo_clause_field(clause), " = ?", NULL);
             break;
 
         case LIBDBO_CLAUSE_NOT_EQUAL:
-            if ((ret = snprintf(*sqlp, *left, " %s.%s != ?",
-                (libdbo_clause_table(clause) ? libdbo_clause_table(clause) : libdbo_object_table(object)),
-                libdbo_clause_field(clause))) >= *left)
-            {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
+            ret = __db_backend_sqlite_sql_append(sql, " ", table, ".", libdbo_clause_field(clause), " != ?", NULL);
             break;
 
         case LIBDBO_CLAUSE_LESS_THEN:
-            if ((ret = snprintf(*sqlp, *left, " %s.%s < ?",
-                (libdbo_clause_table(clause) ? libdbo_clause_table(clause) : libdbo_object_table(object)),
-                libdbo_clause_field(clause))) >= *left)
-            {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
+            ret = __db_backend_sqlite_sql_append(sql, " ", table, ".", libdbo_clause_field(clause), " < ?", NULL);
             break;
 
         case LIBDBO_CLAUSE_LESS_OR_EQUAL:
-            if ((ret = snprintf(*sqlp, *left, " %s.%s <= ?",
-                (libdbo_clause_table(clause) ? libdbo_clause_table(clause) : libdbo_object_table(object)),
-                libdbo_clause_field(clause))) >= *left)
-            {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
+            ret = __db_backend_sqlite_sql_append(sql, " ", table, ".", libdbo_clause_field(clause), " <= ?", NULL);
             break;
 
         case LIBDBO_CLAUSE_GREATER_OR_EQUAL:
-            if ((ret = snprintf(*sqlp, *left, " %s.%s >= ?",
-                (libdbo_clause_table(clause) ? libdbo_clause_table(clause) : libdbo_object_table(object)),
-                libdbo_clause_field(clause))) >= *left)
-            {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
+            ret = __db_backend_sqlite_sql_append(sql, " ", table, ".", libdbo_clause_field(clause), " >= ?", NULL);
             break;
 
         case LIBDBO_CLAUSE_GREATER_THEN:
-            if ((ret = snprintf(*sqlp, *left, " %s.%s > ?",
-                (libdbo_clause_table(clause) ? libdbo_clause_table(clause) : libdbo_object_table(object)),
-                libdbo_clause_field(clause))) >= *left)
-            {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
+            ret = __db_backend_sqlite_sql_append(sql, " ", table, ".", libdbo_clause_field(clause), " > ?", NULL);
             break;
 
         case LIBDBO_CLAUSE_IS_NULL:
-            if ((ret = snprintf(*sqlp, *left, " %s.%s IS NULL",
-                (libdbo_clause_table(clause) ? libdbo_clause_table(clause) : libdbo_object_table(object)),
-                libdbo_clause_field(clause))) >= *left)
-            {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
+            ret = __db_backend_sqlite_sql_append(sql, " ", table, ".", libdbo_clause_field(clause), " IS NULL", NULL);
             break;
 
         case LIBDBO_CLAUSE_IS_NOT_NULL:
-            if ((ret = snprintf(*sqlp, *left, " %s.%s IS NOT NULL",
-                (libdbo_clause_table(clause) ? libdbo_clause_table(clause) : libdbo_object_table(object)),
-                libdbo_clause_field(clause))) >= *left)
-            {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
+            ret = __db_backend_sqlite_sql_append(sql, " ", table, ".", libdbo_clause_field(clause), " IS NOT NULL", NULL);
             break;
 
         case LIBDBO_CLAUSE_NESTED:
-            if ((ret = snprintf(*sqlp, *left, " (")) >= *left) {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            *sqlp += ret;
-            *left -= ret;
-            if (__db_backend_sqlite_build_clause(object, libdbo_clause_list(clause), sqlp, left)) {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            if ((ret = snprintf(*sqlp, *left, " )")) >= *left) {
-                return LIBDBO_ERROR_UNKNOWN;
+            if ((ret = __db_backend_sqlite_sql_append(sql, " (", NULL))
+                || (ret = __db_backend_sqlite_build_clause(object, libdbo_clause_list(clause), sql)))
+            {
+                return ret;
             }
+            ret = __db_backend_sqlite_sql_append(sql, " )", NULL);
             break;
 
         default:
             return LIBDBO_ERROR_UNKNOWN;
         }
-        *sqlp += ret;
-        *left -= ret;
+        if (ret) {
+            return ret;
+        }
 
         clause = libdbo_clause_next(clause);
     }
@@ -609,71 +953,173 @@ static int __db_backend_sqlite_bind_clause(sqlite3_stmt* statement, const libdbo
     return LIBDBO_OK;
 }
 
-static libdbo_result_t* libdbo_backend_sqlite_next(void* data, int finish) {
-    libdbo_backend_sqlite_statement_t* statement = (libdbo_backend_sqlite_statement_t*)data;
+/**
+ * Bind all the values from `value_set` to the statement starting at `bind`.
+ */
+static int __db_backend_sqlite_bind_value_set(sqlite3_stmt* statement, const libdbo_value_set_t* value_set, int* bind) {
+    const libdbo_value_t* value;
+    size_t value_pos;
     int ret;
-    int bind;
-    libdbo_result_t* result = NULL;
-    libdbo_value_set_t* value_set = NULL;
-    const libdbo_object_field_t* object_field;
-    int from_int;
-    sqlite3_int64 from_int64;
+    int to_int;
+    sqlite3_int64 to_int64;
     libdbo_type_int32_t int32;
     libdbo_type_uint32_t uint32;
     libdbo_type_int64_t int64;
     libdbo_type_uint64_t uint64;
-    const char* text;
 
     if (!statement) {
-        return NULL;
+        return LIBDBO_ERROR_UNKNOWN;
     }
-    if (!statement->object) {
-        return NULL;
+    if (!value_set) {
+        return LIBDBO_ERROR_UNKNOWN;
     }
-    if (!statement->statement) {
-        return NULL;
+    if (!bind) {
+        return LIBDBO_ERROR_UNKNOWN;
     }
-
-    if (finish) {
-        __db_backend_sqlite_finalize(statement->statement);
-        libdbo_mm_delete(&__sqlite_statement_alloc, statement);
-        return NULL;
+    if (!*bind) {
+        return LIBDBO_ERROR_UNKNOWN;
     }
 
-    if (__db_backend_sqlite_step(statement->backend_sqlite, statement->statement) != SQLITE_ROW) {
-        return NULL;
-    }
+    for (value_pos = 0; value_pos < libdbo_value_set_size(value_set); value_pos++) {
+        if (!(value = libdbo_value_set_at(value_set, value_pos))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
 
-    if (!(result = libdbo_result_new())
-        || !(value_set = libdbo_value_set_new(statement->fields))
-        || libdbo_result_set_value_set(result, value_set))
-    {
-        libdbo_result_free(result);
-        libdbo_value_set_free(value_set);
-        return NULL;
-    }
-    object_field = libdbo_object_field_list_begin(libdbo_object_object_field_list(statement->object));
-    bind = 0;
-    while (object_field) {
-        switch (libdbo_object_field_type(object_field)) {
-        case LIBDBO_TYPE_PRIMARY_KEY:
-            from_int = sqlite3_column_int(statement->statement, bind);
-            int32 = from_int;
-            ret = sqlite3_errcode(statement->backend_sqlite->db);
-            if ((ret != SQLITE_OK && ret != SQLITE_ROW && ret != SQLITE_DONE)
-                || libdbo_value_from_int32(libdbo_value_set_get(value_set, bind), int32)
-                || libdbo_value_set_primary_key(libdbo_value_set_get(value_set, bind)))
-            {
-                libdbo_result_free(result);
-                return NULL;
+        switch (libdbo_value_type(value)) {
+        case LIBDBO_TYPE_INT32:
+            if (libdbo_value_to_int32(value, &int32)) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            to_int = int32;
+            ret = sqlite3_bind_int(statement, (*bind)++, to_int);
+            if (ret != SQLITE_OK) {
+                return LIBDBO_ERROR_UNKNOWN;
             }
             break;
 
-        case LIBDBO_TYPE_ENUM:
-            /*
-             * Enum needs to be handled elsewhere since we don't know the
-             * enum_set_t here.
-             */
+        case LIBDBO_TYPE_UINT32:
+            if (libdbo_value_to_uint32(value, &uint32)) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            to_int = uint32;
+            ret = sqlite3_bind_int(statement, (*bind)++, to_int);
+            if (ret != SQLITE_OK) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            break;
+
+        case LIBDBO_TYPE_INT64:
+            if (libdbo_value_to_int64(value, &int64)) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            to_int64 = int64;
+            ret = sqlite3_bind_int64(statement, (*bind)++, to_int64);
+            if (ret != SQLITE_OK) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            break;
+
+        case LIBDBO_TYPE_UINT64:
+            if (libdbo_value_to_uint64(value, &uint64)) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            to_int64 = uint64;
+            ret = sqlite3_bind_int64(statement, (*bind)++, to_int64);
+            if (ret != SQLITE_OK) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            break;
+
+        case LIBDBO_TYPE_TEXT:
+            ret = sqlite3_bind_text(statement, (*bind)++, libdbo_value_text(value), -1, SQLITE_TRANSIENT);
+            if (ret != SQLITE_OK) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            break;
+
+        case LIBDBO_TYPE_ENUM:
+            if (libdbo_value_enum_value(value, &to_int)) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            ret = sqlite3_bind_int(statement, (*bind)++, to_int);
+            if (ret != SQLITE_OK) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            break;
+
+        default:
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+
+    return LIBDBO_OK;
+}
+
+static libdbo_result_t* libdbo_backend_sqlite_next(void* data, int finish) {
+    libdbo_backend_sqlite_statement_t* statement = (libdbo_backend_sqlite_statement_t*)data;
+    int ret;
+    int bind;
+    libdbo_result_t* result = NULL;
+    libdbo_value_set_t* value_set = NULL;
+    const libdbo_object_field_t* object_field;
+    int from_int;
+    sqlite3_int64 from_int64;
+    libdbo_type_int32_t int32;
+    libdbo_type_uint32_t uint32;
+    libdbo_type_int64_t int64;
+    libdbo_type_uint64_t uint64;
+    const char* text;
+
+    if (!statement) {
+        return NULL;
+    }
+    if (!statement->object) {
+        return NULL;
+    }
+    if (!statement->statement) {
+        return NULL;
+    }
+
+    if (finish) {
+        __db_backend_sqlite_finalize(statement->statement);
+        libdbo_mm_delete(&__sqlite_statement_alloc, statement);
+        return NULL;
+    }
+
+    if (__db_backend_sqlite_step(statement->backend_sqlite, statement->statement, LIBDBO_STATS_READ, statement->object) != SQLITE_ROW) {
+        return NULL;
+    }
+
+    if (!(result = libdbo_result_new())
+        || !(value_set = libdbo_value_set_new(statement->fields))
+        || libdbo_result_set_value_set(result, value_set))
+    {
+        libdbo_result_free(result);
+        libdbo_value_set_free(value_set);
+        return NULL;
+    }
+    object_field = libdbo_object_field_list_begin(libdbo_object_object_field_list(statement->object));
+    bind = 0;
+    while (object_field) {
+        switch (libdbo_object_field_type(object_field)) {
+        case LIBDBO_TYPE_PRIMARY_KEY:
+            from_int = sqlite3_column_int(statement->statement, bind);
+            int32 = from_int;
+            ret = sqlite3_errcode(statement->backend_sqlite->db);
+            if ((ret != SQLITE_OK && ret != SQLITE_ROW && ret != SQLITE_DONE)
+                || libdbo_value_from_int32(libdbo_value_set_get(value_set, bind), int32)
+                || libdbo_value_set_primary_key(libdbo_value_set_get(value_set, bind)))
+            {
+                libdbo_result_free(result);
+                return NULL;
+            }
+            break;
+
+        case LIBDBO_TYPE_ENUM:
+            /*
+             * Enum needs to be handled elsewhere since we don't know the
+             * enum_set_t here.
+             */
         case LIBDBO_TYPE_INT32:
             from_int = sqlite3_column_int(statement->statement, bind);
             int32 = from_int;
@@ -781,18 +1227,9 @@ static int libdbo_backend_sqlite_create(void* data, const libdbo_object_t* objec
     libdbo_backend_sqlite_t* backend_sqlite = (libdbo_backend_sqlite_t*)data;
     const libdbo_object_field_t* object_field;
     const libdbo_object_field_t* revision_field = NULL;
-    const libdbo_value_t* value;
-    char sql[4*1024];
-    char* sqlp;
-    int ret, left, bind, first;
+    const libdbo_backend_sqlite_template_t* template;
+    int ret, bind;
     sqlite3_stmt* statement = NULL;
-    size_t value_pos;
-    int to_int;
-    sqlite3_int64 to_int64;
-    libdbo_type_int32_t int32;
-    libdbo_type_uint32_t uint32;
-    libdbo_type_int64_t int64;
-    libdbo_type_uint64_t uint64;
 
     if (!__sqlite3_initialized) {
         return LIBDBO_ERROR_UNKNOWN;
@@ -828,127 +1265,13 @@ static int libdbo_backend_sqlite_create(void* data, const libdbo_object_t* objec
         object_field = libdbo_object_field_next(object_field);
     }
 
-    left = sizeof(sql);
-    sqlp = sql;
-
-    if (!libdbo_object_field_list_begin(object_field_list) && !revision_field) {
-        /*
-         * Special case when tables has no fields except maybe a primary key.
-         */
-        if ((ret = snprintf(sqlp, left, "INSERT INTO %s DEFAULT VALUES", libdbo_object_table(object))) >= left) {
-            return LIBDBO_ERROR_UNKNOWN;
-        }
-        sqlp += ret;
-        left -= ret;
-    }
-    else {
-        if ((ret = snprintf(sqlp, left, "INSERT INTO %s (", libdbo_object_table(object))) >= left) {
-            return LIBDBO_ERROR_UNKNOWN;
-        }
-        sqlp += ret;
-        left -= ret;
-
-        /*
-         * Add the fields from the given object_field_list.
-         */
-        object_field = libdbo_object_field_list_begin(object_field_list);
-        first = 1;
-        while (object_field) {
-            if (first) {
-                if ((ret = snprintf(sqlp, left, " %s", libdbo_object_field_name(object_field))) >= left) {
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
-                first = 0;
-            }
-            else {
-                if ((ret = snprintf(sqlp, left, ", %s", libdbo_object_field_name(object_field))) >= left) {
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
-            }
-            sqlp += ret;
-            left -= ret;
-
-            object_field = libdbo_object_field_next(object_field);
-        }
-
-        /*
-         * Add the revision field if we have one.
-         */
-        if (revision_field) {
-            if (first) {
-                if ((ret = snprintf(sqlp, left, " %s", libdbo_object_field_name(revision_field))) >= left) {
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
-                first = 0;
-            }
-            else {
-                if ((ret = snprintf(sqlp, left, ", %s", libdbo_object_field_name(revision_field))) >= left) {
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
-            }
-            sqlp += ret;
-            left -= ret;
-        }
-
-        if ((ret = snprintf(sqlp, left, " ) VALUES (")) >= left) {
-            return LIBDBO_ERROR_UNKNOWN;
-        }
-        sqlp += ret;
-        left -= ret;
-
-        /*
-         * Mark all the fields for binding from the object_field_list.
-         */
-        object_field = libdbo_object_field_list_begin(object_field_list);
-        first = 1;
-        while (object_field) {
-            if (first) {
-                if ((ret = snprintf(sqlp, left, " ?")) >= left) {
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
-                first = 0;
-            }
-            else {
-                if ((ret = snprintf(sqlp, left, ", ?")) >= left) {
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
-            }
-            sqlp += ret;
-            left -= ret;
-
-            object_field = libdbo_object_field_next(object_field);
-        }
-
-        /*
-         * Mark revision field for binding if we have one.
-         */
-        if (revision_field) {
-            if (first) {
-                if ((ret = snprintf(sqlp, left, " ?")) >= left) {
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
-                first = 0;
-            }
-            else {
-                if ((ret = snprintf(sqlp, left, ", ?")) >= left) {
-                    return LIBDBO_ERROR_UNKNOWN;
-                }
-            }
-            sqlp += ret;
-            left -= ret;
-        }
-
-        if ((ret = snprintf(sqlp, left, " )")) >= left) {
-            return LIBDBO_ERROR_UNKNOWN;
-        }
-        sqlp += ret;
-        left -= ret;
-    }
-
     /*
-     * Prepare the SQL, create a SQLite statement.
+     * Get the cached INSERT SQL for the fields and prepare it, create a
+     * SQLite statement.
      */
-    if (__db_backend_sqlite_prepare(backend_sqlite, &statement, sql, sizeof(sql))) {
+    if (!(template = __db_backend_sqlite_template(backend_sqlite, LIBDBO_BACKEND_SQLITE_TEMPLATE_INSERT, object, object_field_list, revision_field))
+        || __db_backend_sqlite_prepare(backend_sqlite, &statement, template->sql, template->length + 1))
+    {
         return LIBDBO_ERROR_UNKNOWN;
     }
 
@@ -956,89 +1279,9 @@ static int libdbo_backend_sqlite_create(void* data, const libdbo_object_t* objec
      * Bind all the values from value_set.
      */
     bind = 1;
-    for (value_pos = 0; value_pos < libdbo_value_set_size(value_set); value_pos++) {
-        if (!(value = libdbo_value_set_at(value_set, value_pos))) {
-            __db_backend_sqlite_finalize(statement);
-            return LIBDBO_ERROR_UNKNOWN;
-        }
-
-        switch (libdbo_value_type(value)) {
-        case LIBDBO_TYPE_INT32:
-            if (libdbo_value_to_int32(value, &int32)) {
-                __db_backend_sqlite_finalize(statement);
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            to_int = int32;
-            ret = sqlite3_bind_int(statement, bind++, to_int);
-            if (ret != SQLITE_OK) {
-                __db_backend_sqlite_finalize(statement);
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            break;
-
-        case LIBDBO_TYPE_UINT32:
-            if (libdbo_value_to_uint32(value, &uint32)) {
-                __db_backend_sqlite_finalize(statement);
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            to_int = uint32;
-            ret = sqlite3_bind_int(statement, bind++, to_int);
-            if (ret != SQLITE_OK) {
-                __db_backend_sqlite_finalize(statement);
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            break;
-
-        case LIBDBO_TYPE_INT64:
-            if (libdbo_value_to_int64(value, &int64)) {
-                __db_backend_sqlite_finalize(statement);
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            to_int64 = int64;
-            ret = sqlite3_bind_int64(statement, bind++, to_int64);
-            if (ret != SQLITE_OK) {
-                __db_backend_sqlite_finalize(statement);
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            break;
-
-        case LIBDBO_TYPE_UINT64:
-            if (libdbo_value_to_uint64(value, &uint64)) {
-                __db_backend_sqlite_finalize(statement);
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            to_int64 = uint64;
-            ret = sqlite3_bind_int64(statement, bind++, to_int64);
-            if (ret != SQLITE_OK) {
-                __db_backend_sqlite_finalize(statement);
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            break;
-
-        case LIBDBO_TYPE_TEXT:
-            ret = sqlite3_bind_text(statement, bind++, libdbo_value_text(value), -1, SQLITE_TRANSIENT);
-            if (ret != SQLITE_OK) {
-                __db_backend_sqlite_finalize(statement);
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            break;
-
-        case LIBDBO_TYPE_ENUM:
-            if (libdbo_value_enum_value(value, &to_int)) {
-                __db_backend_sqlite_finalize(statement);
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            ret = sqlite3_bind_int(statement, bind++, to_int);
-            if (ret != SQLITE_OK) {
-                __db_backend_sqlite_finalize(statement);
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            break;
-
-        default:
-            __db_backend_sqlite_finalize(statement);
-            return LIBDBO_ERROR_UNKNOWN;
-        }
+    if (__db_backend_sqlite_bind_value_set(statement, value_set, &bind)) {
+        __db_backend_sqlite_finalize(statement);
+        return LIBDBO_ERROR_UNKNOWN;
     }
 
     /*
@@ -1055,7 +1298,7 @@ static int libdbo_backend_sqlite_create(void* data, const libdbo_object_t* objec
     /*
      * Execute the SQL.
      */
-    if (__db_backend_sqlite_step(backend_sqlite, statement) != SQLITE_DONE) {
+    if (__db_backend_sqlite_step(backend_sqlite, statement, LIBDBO_STATS_CREATE, object) != SQLITE_DONE) {
         __db_backend_sqlite_finalize(statement);
         return LIBDBO_ERROR_UNKNOWN;
     }
@@ -1066,11 +1309,10 @@ static int libdbo_backend_sqlite_create(void* data, const libdbo_object_t* objec
 
 static libdbo_result_list_t* libdbo_backend_sqlite_read(void* data, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list) {
     libdbo_backend_sqlite_t* backend_sqlite = (libdbo_backend_sqlite_t*)data;
-    const libdbo_object_field_t* object_field;
     const libdbo_join_t* join;
-    char sql[4*1024];
-    char* sqlp;
-    int ret, left, first, fields, bind;
+    const libdbo_backend_sqlite_template_t* template;
+    libdbo_backend_sqlite_sql_t sql;
+    int bind;
     libdbo_result_list_t* result_list;
     libdbo_backend_sqlite_statement_t* statement;
 
@@ -1084,87 +1326,59 @@ static libdbo_result_list_t* libdbo_backend_sqlite_read(void* data, const libdbo
         return NULL;
     }
 
-    left = sizeof(sql);
-    sqlp = sql;
-
-    if ((ret = snprintf(sqlp, left, "SELECT")) >= left) {
+    if (!(template = __db_backend_sqlite_template(backend_sqlite, LIBDBO_BACKEND_SQLITE_TEMPLATE_SELECT, object, libdbo_object_object_field_list(object), NULL))) {
         return NULL;
     }
-    sqlp += ret;
-    left -= ret;
-
-    object_field = libdbo_object_field_list_begin(libdbo_object_object_field_list(object));
-    first = 1;
-    fields = 0;
-    while (object_field) {
-        if (first) {
-            if ((ret = snprintf(sqlp, left, " %s.%s", libdbo_object_table(object), libdbo_object_field_name(object_field))) >= left) {
-                return NULL;
-            }
-            first = 0;
-        }
-        else {
-            if ((ret = snprintf(sqlp, left, ", %s.%s", libdbo_object_table(object), libdbo_object_field_name(object_field))) >= left) {
-                return NULL;
-            }
-        }
-        sqlp += ret;
-        left -= ret;
 
-        object_field = libdbo_object_field_next(object_field);
-        fields++;
-    }
-
-    if ((ret = snprintf(sqlp, left, " FROM %s", libdbo_object_table(object))) >= left) {
+    __db_backend_sqlite_sql_init(&sql);
+    if (__db_backend_sqlite_sql_append(&sql, template->sql, NULL)) {
+        __db_backend_sqlite_sql_reset(&sql);
         return NULL;
     }
-    sqlp += ret;
-    left -= ret;
 
     if (join_list) {
         join = libdbo_join_list_begin(join_list);
         while (join) {
-            if ((ret = snprintf(sqlp, left, " INNER JOIN %s ON %s.%s = %s.%s",
-                libdbo_join_to_table(join),
-                libdbo_join_to_table(join),
-                libdbo_join_to_field(join),
-                libdbo_join_from_table(join),
-                libdbo_join_from_field(join))) >= left)
+            if (__db_backend_sqlite_sql_append(&sql, " INNER JOIN ", libdbo_join_to_table(join),
+                " ON ", libdbo_join_to_table(join), ".", libdbo_join_to_field(join),
+                " = ", libdbo_join_from_table(join), ".", libdbo_join_from_field(join), NULL))
             {
+                __db_backend_sqlite_sql_reset(&sql);
                 return NULL;
             }
-            sqlp += ret;
-            left -= ret;
             join = libdbo_join_next(join);
         }
     }
 
     if (clause_list) {
-        if (libdbo_clause_list_begin(clause_list)) {
-            if ((ret = snprintf(sqlp, left, " WHERE")) >= left) {
-                return NULL;
-            }
-            sqlp += ret;
-            left -= ret;
+        if (libdbo_clause_list_begin(clause_list)
+            && __db_backend_sqlite_sql_append(&sql, " WHERE", NULL))
+        {
+            __db_backend_sqlite_sql_reset(&sql);
+            return NULL;
         }
-        if (__db_backend_sqlite_build_clause(object, clause_list, &sqlp, &left)) {
+        if (__db_backend_sqlite_build_clause(object, clause_list, &sql)) {
+            __db_backend_sqlite_sql_reset(&sql);
             return NULL;
         }
     }
 
     statement = libdbo_mm_new0(&__sqlite_statement_alloc);
     if (!statement) {
+        __db_backend_sqlite_sql_reset(&sql);
         return NULL;
     }
     statement->backend_sqlite = backend_sqlite;
     statement->object = object;
-    statement->fields = fields;
+    statement->fields = template->fields_size;
     statement->statement = NULL;
 
-    if (__db_backend_sqlite_prepare(backend_sqlite, &(statement->statement), sql, sizeof(sql))) {
+    if (__db_backend_sqlite_prepare(backend_sqlite, &(statement->statement), sql.string, sql.length + 1)) {
+        __db_backend_sqlite_sql_reset(&sql);
         libdbo_mm_delete(&__sqlite_statement_alloc, statement);
         return NULL;
     }
+    __db_backend_sqlite_sql_reset(&sql);
 
     if (clause_list) {
         bind = 1;
@@ -1193,14 +1407,10 @@ static int libdbo_backend_sqlite_update(void* data, const libdbo_object_t* objec
     const libdbo_clause_t* clause;
     const libdbo_clause_t* revision_clause = NULL;
     sqlite3_int64 revision_number = -1;
-    const libdbo_value_t* value;
-    char sql[4*1024];
-    char* sqlp;
-    int ret, left, bind, first;
+    const libdbo_backend_sqlite_template_t* template;
+    libdbo_backend_sqlite_sql_t sql;
+    int ret, bind;
     sqlite3_stmt* statement = NULL;
-    size_t value_pos;
-    int to_int;
-    sqlite3_int64 to_int64;
     libdbo_type_int32_t int32;
     libdbo_type_uint32_t uint32;
     libdbo_type_int64_t int64;
@@ -1289,69 +1499,24 @@ static int libdbo_backend_sqlite_update(void* data, const libdbo_object_t* objec
         }
     }
 
-    left = sizeof(sql);
-    sqlp = sql;
-
-    if ((ret = snprintf(sqlp, left, "UPDATE %s SET", libdbo_object_table(object))) >= left) {
-        return LIBDBO_ERROR_UNKNOWN;
-    }
-    sqlp += ret;
-    left -= ret;
-
     /*
-     * Build the update SQL from the object_field_list.
+     * Get the cached UPDATE SQL for the fields and build the clauses.
      */
-    object_field = libdbo_object_field_list_begin(object_field_list);
-    first = 1;
-    while (object_field) {
-        if (first) {
-            if ((ret = snprintf(sqlp, left, " %s = ?", libdbo_object_field_name(object_field))) >= left) {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            first = 0;
-        }
-        else {
-            if ((ret = snprintf(sqlp, left, ", %s = ?", libdbo_object_field_name(object_field))) >= left) {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-        }
-        sqlp += ret;
-        left -= ret;
-
-        object_field = libdbo_object_field_next(object_field);
+    if (!(template = __db_backend_sqlite_template(backend_sqlite, LIBDBO_BACKEND_SQLITE_TEMPLATE_UPDATE, object, object_field_list, revision_field))) {
+        return LIBDBO_ERROR_UNKNOWN;
     }
 
-    /*
-     * Add a new revision if we have any.
-     */
-    if (revision_field) {
-        if (first) {
-            if ((ret = snprintf(sqlp, left, " %s = ?", libdbo_object_field_name(revision_field))) >= left) {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            first = 0;
-        }
-        else {
-            if ((ret = snprintf(sqlp, left, ", %s = ?", libdbo_object_field_name(revision_field))) >= left) {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-        }
-        sqlp += ret;
-        left -= ret;
+    __db_backend_sqlite_sql_init(&sql);
+    if (__db_backend_sqlite_sql_append(&sql, template->sql, NULL)) {
+        __db_backend_sqlite_sql_reset(&sql);
+        return LIBDBO_ERROR_UNKNOWN;
     }
-
-    /*
-     * Build the clauses.
-     */
     if (clause_list) {
-        if (libdbo_clause_list_begin(clause_list)) {
-            if ((ret = snprintf(sqlp, left, " WHERE")) >= left) {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            sqlp += ret;
-            left -= ret;
-        }
-        if (__db_backend_sqlite_build_clause(object, clause_list, &sqlp, &left)) {
+        if ((libdbo_clause_list_begin(clause_list)
+                && __db_backend_sqlite_sql_append(&sql, " WHERE", NULL))
+            || __db_backend_sqlite_build_clause(object, clause_list, &sql))
+        {
+            __db_backend_sqlite_sql_reset(&sql);
             return LIBDBO_ERROR_UNKNOWN;
         }
     }
@@ -1359,97 +1524,19 @@ static int libdbo_backend_sqlite_update(void* data, const libdbo_object_t* objec
     /*
      * Prepare the SQL.
      */
-    if (__db_backend_sqlite_prepare(backend_sqlite, &statement, sql, sizeof(sql))) {
-        return LIBDBO_ERROR_UNKNOWN;
-    }
-
-    /*
-     * Bind all the values from value_set.
-     */
-    bind = 1;
-    for (value_pos = 0; value_pos < libdbo_value_set_size(value_set); value_pos++) {
-        if (!(value = libdbo_value_set_at(value_set, value_pos))) {
-            __db_backend_sqlite_finalize(statement);
-            return LIBDBO_ERROR_UNKNOWN;
-        }
-
-        switch (libdbo_value_type(value)) {
-        case LIBDBO_TYPE_INT32:
-            if (libdbo_value_to_int32(value, &int32)) {
-                __db_backend_sqlite_finalize(statement);
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            to_int = int32;
-            ret = sqlite3_bind_int(statement, bind++, to_int);
-            if (ret != SQLITE_OK) {
-                __db_backend_sqlite_finalize(statement);
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            break;
-
-        case LIBDBO_TYPE_UINT32:
-            if (libdbo_value_to_uint32(value, &uint32)) {
-                __db_backend_sqlite_finalize(statement);
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            to_int = uint32;
-            ret = sqlite3_bind_int(statement, bind++, to_int);
-            if (ret != SQLITE_OK) {
-                __db_backend_sqlite_finalize(statement);
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            break;
-
-        case LIBDBO_TYPE_INT64:
-            if (libdbo_value_to_int64(value, &int64)) {
-                __db_backend_sqlite_finalize(statement);
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            to_int64 = int64;
-            ret = sqlite3_bind_int64(statement, bind++, to_int64);
-            if (ret != SQLITE_OK) {
-                __db_backend_sqlite_finalize(statement);
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            break;
-
-        case LIBDBO_TYPE_UINT64:
-            if (libdbo_value_to_uint64(value, &uint64)) {
-                __db_backend_sqlite_finalize(statement);
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            to_int64 = uint64;
-            ret = sqlite3_bind_int64(statement, bind++, to_int64);
-            if (ret != SQLITE_OK) {
-                __db_backend_sqlite_finalize(statement);
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            break;
-
-        case LIBDBO_TYPE_TEXT:
-            ret = sqlite3_bind_text(statement, bind++, libdbo_value_text(value), -1, SQLITE_TRANSIENT);
-            if (ret != SQLITE_OK) {
-                __db_backend_sqlite_finalize(statement);
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            break;
-
-        case LIBDBO_TYPE_ENUM:
-            if (libdbo_value_enum_value(value, &to_int)) {
-                __db_backend_sqlite_finalize(statement);
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            ret = sqlite3_bind_int(statement, bind++, to_int);
-            if (ret != SQLITE_OK) {
-                __db_backend_sqlite_finalize(statement);
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            break;
-
-        default:
-            __db_backend_sqlite_finalize(statement);
-            return LIBDBO_ERROR_UNKNOWN;
-        }
+    if (__db_backend_sqlite_prepare(backend_sqlite, &statement, sql.string, sql.length + 1)) {
+        __db_backend_sqlite_sql_reset(&sql);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    __db_backend_sqlite_sql_reset(&sql);
+
+    /*
+     * Bind all the values from value_set.
+     */
+    bind = 1;
+    if (__db_backend_sqlite_bind_value_set(statement, value_set, &bind)) {
+        __db_backend_sqlite_finalize(statement);
+        return LIBDBO_ERROR_UNKNOWN;
     }
 
     /*
@@ -1476,7 +1563,7 @@ static int libdbo_backend_sqlite_update(void* data, const libdbo_object_t* objec
     /*
      * Execute the SQL.
      */
-    if (__db_backend_sqlite_step(backend_sqlite, statement) != SQLITE_DONE) {
+    if (__db_backend_sqlite_step(backend_sqlite, statement, LIBDBO_STATS_UPDATE, object) != SQLITE_DONE) {
         __db_backend_sqlite_finalize(statement);
         return LIBDBO_ERROR_UNKNOWN;
     }
@@ -1487,8 +1574,8 @@ static int libdbo_backend_sqlite_update(void* data, const libdbo_object_t* objec
      * otherwise its a failure.
      */
     if (revision_field) {
-        if (sqlite3_changes(backend_sqlite->db) < 1) {
-            return LIBDBO_ERROR_UNKNOWN;
+        if (backend_sqlite->changes < 1) {
+            return LIBDBO_ERROR_REVISION;
         }
     }
 
@@ -1497,9 +1584,8 @@ static int libdbo_backend_sqlite_update(void* data, const libdbo_object_t* objec
 
 static int libdbo_backend_sqlite_delete(void* data, const libdbo_object_t* object, const libdbo_clause_list_t* clause_list) {
     libdbo_backend_sqlite_t* backend_sqlite = (libdbo_backend_sqlite_t*)data;
-    char sql[4*1024];
-    char* sqlp;
-    int ret, left, bind;
+    libdbo_backend_sqlite_sql_t sql;
+    int bind;
     sqlite3_stmt* statement = NULL;
     const libdbo_object_field_t* revision_field = NULL;
     const libdbo_object_field_t* object_field;
@@ -1549,31 +1635,27 @@ static int libdbo_backend_sqlite_delete(void* data, const libdbo_object_t* objec
         }
     }
 
-    left = sizeof(sql);
-    sqlp = sql;
-
-    if ((ret = snprintf(sqlp, left, "DELETE FROM %s", libdbo_object_table(object))) >= left) {
+    __db_backend_sqlite_sql_init(&sql);
+    if (__db_backend_sqlite_sql_append(&sql, "DELETE FROM ", libdbo_object_table(object), NULL)) {
+        __db_backend_sqlite_sql_reset(&sql);
         return LIBDBO_ERROR_UNKNOWN;
     }
-    sqlp += ret;
-    left -= ret;
 
     if (clause_list) {
-        if (libdbo_clause_list_begin(clause_list)) {
-            if ((ret = snprintf(sqlp, left, " WHERE")) >= left) {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            sqlp += ret;
-            left -= ret;
-        }
-        if (__db_backend_sqlite_build_clause(object, clause_list, &sqlp, &left)) {
+        if ((libdbo_clause_list_begin(clause_list)
+                && __db_backend_sqlite_sql_append(&sql, " WHERE", NULL))
+            || __db_backend_sqlite_build_clause(object, clause_list, &sql))
+        {
+            __db_backend_sqlite_sql_reset(&sql);
             return LIBDBO_ERROR_UNKNOWN;
         }
     }
 
-    if (__db_backend_sqlite_prepare(backend_sqlite, &statement, sql, sizeof(sql))) {
+    if (__db_backend_sqlite_prepare(backend_sqlite, &statement, sql.string, sql.length + 1)) {
+        __db_backend_sqlite_sql_reset(&sql);
         return LIBDBO_ERROR_UNKNOWN;
     }
+    __db_backend_sqlite_sql_reset(&sql);
 
     if (clause_list) {
         bind = 1;
@@ -1583,7 +1665,7 @@ static int libdbo_backend_sqlite_delete(void* data, const libdbo_object_t* objec
         }
     }
 
-    if (__db_backend_sqlite_step(backend_sqlite, statement) != SQLITE_DONE) {
+    if (__db_backend_sqlite_step(backend_sqlite, statement, LIBDBO_STATS_DELETE, object) != SQLITE_DONE) {
         __db_backend_sqlite_finalize(statement);
         return LIBDBO_ERROR_UNKNOWN;
     }
@@ -1594,8 +1676,8 @@ static int libdbo_backend_sqlite_delete(void* data, const libdbo_object_t* objec
      * otherwise its a failure.
      */
     if (revision_field) {
-        if (sqlite3_changes(backend_sqlite->db) < 1) {
-            return LIBDBO_ERROR_UNKNOWN;
+        if (backend_sqlite->changes < 1) {
+            return LIBDBO_ERROR_REVISION;
         }
     }
 
@@ -1605,9 +1687,8 @@ static int libdbo_backend_sqlite_delete(void* data, const libdbo_object_t* objec
 static int libdbo_backend_sqlite_count(void* data, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list, size_t* count) {
     libdbo_backend_sqlite_t* backend_sqlite = (libdbo_backend_sqlite_t*)data;
     const libdbo_join_t* join;
-    char sql[4*1024];
-    char* sqlp;
-    int ret, left, bind;
+    libdbo_backend_sqlite_sql_t sql;
+    int ret, bind;
     sqlite3_stmt* statement = NULL;
     int sqlite_count;
 
@@ -1624,55 +1705,41 @@ static int libdbo_backend_sqlite_count(void* data, const libdbo_object_t* object
         return LIBDBO_ERROR_UNKNOWN;
     }
 
-    left = sizeof(sql);
-    sqlp = sql;
-
-    if ((ret = snprintf(sqlp, left, "SELECT COUNT(*)")) >= left) {
-        return LIBDBO_ERROR_UNKNOWN;
-    }
-    sqlp += ret;
-    left -= ret;
-
-    if ((ret = snprintf(sqlp, left, " FROM %s", libdbo_object_table(object))) >= left) {
+    __db_backend_sqlite_sql_init(&sql);
+    if (__db_backend_sqlite_sql_append(&sql, "SELECT COUNT(*) FROM ", libdbo_object_table(object), NULL)) {
+        __db_backend_sqlite_sql_reset(&sql);
         return LIBDBO_ERROR_UNKNOWN;
     }
-    sqlp += ret;
-    left -= ret;
 
     if (join_list) {
         join = libdbo_join_list_begin(join_list);
         while (join) {
-            if ((ret = snprintf(sqlp, left, " INNER JOIN %s ON %s.%s = %s.%s",
-                libdbo_join_to_table(join),
-                libdbo_join_to_table(join),
-                libdbo_join_to_field(join),
-                libdbo_join_from_table(join),
-                libdbo_join_from_field(join))) >= left)
+            if (__db_backend_sqlite_sql_append(&sql, " INNER JOIN ", libdbo_join_to_table(join),
+                " ON ", libdbo_join_to_table(join), ".", libdbo_join_to_field(join),
+                " = ", libdbo_join_from_table(join), ".", libdbo_join_from_field(join), NULL))
             {
+                __db_backend_sqlite_sql_reset(&sql);
                 return LIBDBO_ERROR_UNKNOWN;
             }
-            sqlp += ret;
-            left -= ret;
             join = libdbo_join_next(join);
         }
     }
 
     if (clause_list) {
-        if (libdbo_clause_list_begin(clause_list)) {
-            if ((ret = snprintf(sqlp, left, " WHERE")) >= left) {
-                return LIBDBO_ERROR_UNKNOWN;
-            }
-            sqlp += ret;
-            left -= ret;
-        }
-        if (__db_backend_sqlite_build_clause(object, clause_list, &sqlp, &left)) {
+        if ((libdbo_clause_list_begin(clause_list)
+                && __db_backend_sqlite_sql_append(&sql, " WHERE", NULL))
+            || __db_backend_sqlite_build_clause(object, clause_list, &sql))
+        {
+            __db_backend_sqlite_sql_reset(&sql);
             return LIBDBO_ERROR_UNKNOWN;
         }
     }
 
-    if (__db_backend_sqlite_prepare(backend_sqlite, &statement, sql, sizeof(sql))) {
+    if (__db_backend_sqlite_prepare(backend_sqlite, &statement, sql.string, sql.length + 1)) {
+        __db_backend_sqlite_sql_reset(&sql);
         return LIBDBO_ERROR_UNKNOWN;
     }
+    __db_backend_sqlite_sql_reset(&sql);
 
     if (clause_list) {
         bind = 1;
@@ -1682,7 +1749,7 @@ static int libdbo_backend_sqlite_count(void* data, const libdbo_object_t* object
         }
     }
 
-    ret = __db_backend_sqlite_step(backend_sqlite, statement);
+    ret = __db_backend_sqlite_step(backend_sqlite, statement, LIBDBO_STATS_COUNT, object);
     if (ret != SQLITE_DONE && ret != SQLITE_ROW) {
         __db_backend_sqlite_finalize(statement);
         return LIBDBO_ERROR_UNKNOWN;
@@ -1700,6 +1767,240 @@ static int libdbo_backend_sqlite_count(void* data, const libdbo_object_t* object
     return LIBDBO_OK;
 }
 
+static int libdbo_backend_sqlite_upsert(void* data, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, const libdbo_clause_list_t* clause_list) {
+    libdbo_backend_sqlite_t* backend_sqlite = (libdbo_backend_sqlite_t*)data;
+    const libdbo_object_field_t* object_field;
+    const libdbo_object_field_t* revision_field = NULL;
+    const libdbo_clause_t* clause;
+    const libdbo_clause_t* revision_clause = NULL;
+    sqlite3_int64 revision_number = -1;
+    libdbo_backend_sqlite_sql_t sql;
+    int ret, bind, first;
+    sqlite3_stmt* statement = NULL;
+    libdbo_type_int32_t int32;
+    libdbo_type_uint32_t uint32;
+    libdbo_type_int64_t int64;
+    libdbo_type_uint64_t uint64;
+
+    if (!__sqlite3_initialized) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!backend_sqlite) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object_field_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!value_set) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!clause_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!libdbo_object_field_list_begin(object_field_list)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * Check if the object has a revision field and keep it for later use.
+     */
+    object_field = libdbo_object_field_list_begin(libdbo_object_object_field_list(object));
+    while (object_field) {
+        if (libdbo_object_field_type(object_field) == LIBDBO_TYPE_REVISION) {
+            if (revision_field) {
+                /*
+                 * We do not support multiple revision fields.
+                 */
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+
+            revision_field = object_field;
+        }
+        object_field = libdbo_object_field_next(object_field);
+    }
+
+    /*
+     * The clauses can only be equal clauses on the unique fields and the
+     * revision field, the revision clause is optional and if given the update
+     * will only be done if the object is still on that revision.
+     */
+    clause = libdbo_clause_list_begin(clause_list);
+    if (!clause) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    while (clause) {
+        if (libdbo_clause_type(clause) != LIBDBO_CLAUSE_EQUAL) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        if (revision_field
+            && !strcmp(libdbo_clause_field(clause), libdbo_object_field_name(revision_field)))
+        {
+            if (revision_clause) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            revision_clause = clause;
+        }
+        clause = libdbo_clause_next(clause);
+    }
+    if (revision_clause) {
+        switch (libdbo_value_type(libdbo_clause_value(revision_clause))) {
+        case LIBDBO_TYPE_INT32:
+            if (libdbo_value_to_int32(libdbo_clause_value(revision_clause), &int32)) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            revision_number = int32;
+            break;
+
+        case LIBDBO_TYPE_UINT32:
+            if (libdbo_value_to_uint32(libdbo_clause_value(revision_clause), &uint32)) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            revision_number = uint32;
+            break;
+
+        case LIBDBO_TYPE_INT64:
+            if (libdbo_value_to_int64(libdbo_clause_value(revision_clause), &int64)) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            revision_number = int64;
+            break;
+
+        case LIBDBO_TYPE_UINT64:
+            if (libdbo_value_to_uint64(libdbo_clause_value(revision_clause), &uint64)) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+            revision_number = uint64;
+            break;
+
+        default:
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+
+    /*
+     * Build the insert with the fields from the given object_field_list and
+     * the revision field if we have one, a new object always starts on
+     * revision 1.
+     */
+    __db_backend_sqlite_sql_init(&sql);
+    ret = __db_backend_sqlite_sql_append(&sql, "INSERT INTO ", libdbo_object_table(object), " (", NULL);
+    object_field = libdbo_object_field_list_begin(object_field_list);
+    first = 1;
+    while (!ret && object_field) {
+        ret = __db_backend_sqlite_sql_append(&sql, first ? " " : ", ", libdbo_object_field_name(object_field), NULL);
+        first = 0;
+        object_field = libdbo_object_field_next(object_field);
+    }
+    if (!ret && revision_field) {
+        ret = __db_backend_sqlite_sql_append(&sql, ", ", libdbo_object_field_name(revision_field), NULL);
+    }
+    if (!ret) {
+        ret = __db_backend_sqlite_sql_append(&sql, " ) VALUES (", NULL);
+    }
+    object_field = libdbo_object_field_list_begin(object_field_list);
+    first = 1;
+    while (!ret && object_field) {
+        ret = __db_backend_sqlite_sql_append(&sql, first ? " ?" : ", ?", NULL);
+        first = 0;
+        object_field = libdbo_object_field_next(object_field);
+    }
+    if (!ret && revision_field) {
+        ret = __db_backend_sqlite_sql_append(&sql, ", 1", NULL);
+    }
+
+    /*
+     * Add the conflict target, all clause fields except the revision.
+     */
+    if (!ret) {
+        ret = __db_backend_sqlite_sql_append(&sql, " ) ON CONFLICT (", NULL);
+    }
+    clause = libdbo_clause_list_begin(clause_list);
+    first = 1;
+    while (!ret && clause) {
+        if (clause != revision_clause) {
+            ret = __db_backend_sqlite_sql_append(&sql, first ? " " : ", ", libdbo_clause_field(clause), NULL);
+            first = 0;
+        }
+        clause = libdbo_clause_next(clause);
+    }
+    if (first) {
+        __db_backend_sqlite_sql_reset(&sql);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * Update all the fields with the values that conflicted and bump the
+     * revision if we have one.
+     */
+    if (!ret) {
+        ret = __db_backend_sqlite_sql_append(&sql, " ) DO UPDATE SET", NULL);
+    }
+    object_field = libdbo_object_field_list_begin(object_field_list);
+    first = 1;
+    while (!ret && object_field) {
+        ret = __db_backend_sqlite_sql_append(&sql, first ? " " : ", ", libdbo_object_field_name(object_field), " = excluded.", libdbo_object_field_name(object_field), NULL);
+        first = 0;
+        object_field = libdbo_object_field_next(object_field);
+    }
+    if (!ret && revision_field) {
+        ret = __db_backend_sqlite_sql_append(&sql, ", ", libdbo_object_field_name(revision_field), " = ", libdbo_object_table(object), ".", libdbo_object_field_name(revision_field), " + 1", NULL);
+    }
+    if (!ret && revision_clause) {
+        ret = __db_backend_sqlite_sql_append(&sql, " WHERE ", libdbo_object_table(object), ".", libdbo_object_field_name(revision_field), " = ?", NULL);
+    }
+
+    /*
+     * Prepare the SQL.
+     */
+    if (ret
+        || __db_backend_sqlite_prepare(backend_sqlite, &statement, sql.string, sql.length + 1))
+    {
+        __db_backend_sqlite_sql_reset(&sql);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    __db_backend_sqlite_sql_reset(&sql);
+
+    /*
+     * Bind all the values from value_set and the current revision if given.
+     */
+    bind = 1;
+    if (__db_backend_sqlite_bind_value_set(statement, value_set, &bind)) {
+        __db_backend_sqlite_finalize(statement);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (revision_clause) {
+        ret = sqlite3_bind_int64(statement, bind++, revision_number);
+        if (ret != SQLITE_OK) {
+            __db_backend_sqlite_finalize(statement);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+
+    /*
+     * Execute the SQL.
+     */
+    if (__db_backend_sqlite_step(backend_sqlite, statement, LIBDBO_STATS_UPSERT, object) != SQLITE_DONE) {
+        __db_backend_sqlite_finalize(statement);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    __db_backend_sqlite_finalize(statement);
+
+    /*
+     * If the update was restricted to a revision we have to have a positive
+     * number of changes otherwise the object was changed by someone else.
+     */
+    if (revision_clause) {
+        if (backend_sqlite->changes < 1) {
+            return LIBDBO_ERROR_REVISION;
+        }
+    }
+
+    return LIBDBO_OK;
+}
+
 static void libdbo_backend_sqlite_free(void* data) {
     libdbo_backend_sqlite_t* backend_sqlite = (libdbo_backend_sqlite_t*)data;
 
@@ -1707,43 +2008,46 @@ static void libdbo_backend_sqlite_free(void* data) {
         if (backend_sqlite->db) {
             (void)libdbo_backend_sqlite_disconnect(backend_sqlite);
         }
+        __db_backend_sqlite_template_free(backend_sqlite);
         libdbo_mm_delete(&__sqlite_alloc, backend_sqlite);
     }
 }
 
-static int libdbo_backend_sqlite_transaction_begin(void* data) {
-    libdbo_backend_sqlite_t* backend_sqlite = (libdbo_backend_sqlite_t*)data;
-    static const char* sql = "BEGIN TRANSACTION";
+/**
+ * Execute a SQL statement that does not return any rows.
+ */
+static int __db_backend_sqlite_exec(libdbo_backend_sqlite_t* backend_sqlite, const char* sql, libdbo_stats_operation_t operation) {
     sqlite3_stmt* statement = NULL;
 
-    if (!__sqlite3_initialized) {
-        return LIBDBO_ERROR_UNKNOWN;
-    }
     if (!backend_sqlite) {
         return LIBDBO_ERROR_UNKNOWN;
     }
-    if (backend_sqlite->transaction) {
+    if (!sql) {
         return LIBDBO_ERROR_UNKNOWN;
     }
 
-    if (__db_backend_sqlite_prepare(backend_sqlite, &statement, sql, sizeof(sql))) {
+    if (__db_backend_sqlite_prepare(backend_sqlite, &statement, sql, strlen(sql))) {
         return LIBDBO_ERROR_UNKNOWN;
     }
 
-    if (__db_backend_sqlite_step(backend_sqlite, statement) != SQLITE_DONE) {
+    if (__db_backend_sqlite_step(backend_sqlite, statement, operation, NULL) != SQLITE_DONE) {
         __db_backend_sqlite_finalize(statement);
         return LIBDBO_ERROR_UNKNOWN;
     }
     __db_backend_sqlite_finalize(statement);
 
-    backend_sqlite->transaction = 1;
     return LIBDBO_OK;
 }
 
-static int libdbo_backend_sqlite_transaction_commit(void* data) {
+/*
+ * Transactions can be nested, the outer most transaction is a real SQLite
+ * transaction and each nested transaction is a savepoint named after the
+ * depth it was started at.
+ */
+
+static int libdbo_backend_sqlite_transaction_begin(void* data) {
     libdbo_backend_sqlite_t* backend_sqlite = (libdbo_backend_sqlite_t*)data;
-    static const char* sql = "COMMIT TRANSACTION";
-    sqlite3_stmt* statement = NULL;
+    char sql[64];
 
     if (!__sqlite3_initialized) {
         return LIBDBO_ERROR_UNKNOWN;
@@ -1751,28 +2055,58 @@ static int libdbo_backend_sqlite_transaction_commit(void* data) {
     if (!backend_sqlite) {
         return LIBDBO_ERROR_UNKNOWN;
     }
+
     if (!backend_sqlite->transaction) {
-        return LIBDBO_ERROR_UNKNOWN;
+        if (__db_backend_sqlite_exec(backend_sqlite, "BEGIN TRANSACTION", LIBDBO_STATS_TRANSACTION_BEGIN)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+    else {
+        if (snprintf(sql, sizeof(sql), "SAVEPOINT libdbo_%d", backend_sqlite->transaction) >= (int)sizeof(sql)
+            || __db_backend_sqlite_exec(backend_sqlite, sql, LIBDBO_STATS_TRANSACTION_BEGIN))
+        {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
     }
 
-    if (__db_backend_sqlite_prepare(backend_sqlite, &statement, sql, sizeof(sql))) {
+    backend_sqlite->transaction++;
+    return LIBDBO_OK;
+}
+
+static int libdbo_backend_sqlite_transaction_commit(void* data) {
+    libdbo_backend_sqlite_t* backend_sqlite = (libdbo_backend_sqlite_t*)data;
+    char sql[64];
+
+    if (!__sqlite3_initialized) {
         return LIBDBO_ERROR_UNKNOWN;
     }
-
-    if (__db_backend_sqlite_step(backend_sqlite, statement) != SQLITE_DONE) {
-        __db_backend_sqlite_finalize(statement);
+    if (!backend_sqlite) {
         return LIBDBO_ERROR_UNKNOWN;
     }
-    __db_backend_sqlite_finalize(statement);
+    if (!backend_sqlite->transaction) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (backend_sqlite->transaction == 1) {
+        if (__db_backend_sqlite_exec(backend_sqlite, "COMMIT TRANSACTION", LIBDBO_STATS_TRANSACTION_COMMIT)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+    else {
+        if (snprintf(sql, sizeof(sql), "RELEASE SAVEPOINT libdbo_%d", backend_sqlite->transaction - 1) >= (int)sizeof(sql)
+            || __db_backend_sqlite_exec(backend_sqlite, sql, LIBDBO_STATS_TRANSACTION_COMMIT))
+        {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
 
-    backend_sqlite->transaction = 0;
+    backend_sqlite->transaction--;
     return LIBDBO_OK;
 }
 
 static int libdbo_backend_sqlite_transaction_rollback(void* data) {
     libdbo_backend_sqlite_t* backend_sqlite = (libdbo_backend_sqlite_t*)data;
-    static const char* sql = "ROLLBACK TRANSACTION";
-    sqlite3_stmt* statement = NULL;
+    char sql[64];
 
     if (!__sqlite3_initialized) {
         return LIBDBO_ERROR_UNKNOWN;
@@ -1784,17 +2118,26 @@ static int libdbo_backend_sqlite_transaction_rollback(void* data) {
         return LIBDBO_ERROR_UNKNOWN;
     }
 
-    if (__db_backend_sqlite_prepare(backend_sqlite, &statement, sql, sizeof(sql))) {
-        return LIBDBO_ERROR_UNKNOWN;
+    if (backend_sqlite->transaction == 1) {
+        if (__db_backend_sqlite_exec(backend_sqlite, "ROLLBACK TRANSACTION", LIBDBO_STATS_TRANSACTION_ROLLBACK)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
     }
-
-    if (__db_backend_sqlite_step(backend_sqlite, statement) != SQLITE_DONE) {
-        __db_backend_sqlite_finalize(statement);
-        return LIBDBO_ERROR_UNKNOWN;
+    else {
+        /*
+         * Rolling back to a savepoint keeps it so it also needs to be
+         * released.
+         */
+        if (snprintf(sql, sizeof(sql), "ROLLBACK TO SAVEPOINT libdbo_%d", backend_sqlite->transaction - 1) >= (int)sizeof(sql)
+            || __db_backend_sqlite_exec(backend_sqlite, sql, LIBDBO_STATS_TRANSACTION_ROLLBACK)
+            || snprintf(sql, sizeof(sql), "RELEASE SAVEPOINT libdbo_%d", backend_sqlite->transaction - 1) >= (int)sizeof(sql)
+            || __db_backend_sqlite_exec(backend_sqlite, sql, LIBDBO_STATS_TRANSACTION_ROLLBACK))
+        {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
     }
-    __db_backend_sqlite_finalize(statement);
 
-    backend_sqlite->transaction = 0;
+    backend_sqlite->transaction--;
     return LIBDBO_OK;
 }
 
@@ -1814,6 +2157,7 @@ libdbo_backend_handle_t* libdbo_backend_sqlite_new_handle(void) {
             || libdbo_backend_handle_set_update(backend_handle, libdbo_backend_sqlite_update)
             || libdbo_backend_handle_set_delete(backend_handle, libdbo_backend_sqlite_delete)
             || libdbo_backend_handle_set_count(backend_handle, libdbo_backend_sqlite_count)
+            || libdbo_backend_handle_set_upsert(backend_handle, libdbo_backend_sqlite_upsert)
             || libdbo_backend_handle_set_free(backend_handle, libdbo_backend_sqlite_free)
             || libdbo_backend_handle_set_transaction_begin(backend_handle, libdbo_backend_sqlite_transaction_begin)
             || libdbo_backend_handle_set_transaction_commit(backend_handle, libdbo_backend_sqlite_transaction_commit)
@@ -39,6 +39,7 @@
 #include "libdbo/mm.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 static libdbo_mm_t __connection_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_connection_t));
 
@@ -51,9 +52,21 @@ libdbo_connection_t* libdbo_connection_new(void) {
 
 void libdbo_connection_free(libdbo_connection_t* connection) {
     if (connection) {
+        if (connection->clause_shape_log) {
+            if (connection->backend && libdbo_backend_stats(connection->backend)) {
+                libdbo_stats_write_shapes(libdbo_backend_stats(connection->backend), connection->clause_shape_log);
+            }
+            free(connection->clause_shape_log);
+        }
         if (connection->backend) {
             libdbo_backend_free(connection->backend);
         }
+        if (connection->identity_map) {
+            libdbo_identity_map_free(connection->identity_map);
+        }
+        if (connection->lookup_filter) {
+            libdbo_lookup_filter_free(connection->lookup_filter);
+        }
         libdbo_mm_delete(&__connection_alloc, connection);
     }
 }
@@ -80,6 +93,11 @@ int libdbo_connection_setup(libdbo_connection_t* connection) {
 
     if (!connection->backend) {
         const libdbo_configuration_t* backend = libdbo_configuration_list_find(connection->configuration_list, "backend");
+        const libdbo_configuration_t* identity_map = libdbo_configuration_list_find(connection->configuration_list, "identity_map");
+        const libdbo_configuration_t* lookup_filter = libdbo_configuration_list_find(connection->configuration_list, "lookup_filter");
+        const libdbo_configuration_t* lookup_filter_bits = libdbo_configuration_list_find(connection->configuration_list, "lookup_filter_bits");
+        const libdbo_configuration_t* lookup_negative_cache = libdbo_configuration_list_find(connection->configuration_list, "lookup_negative_cache");
+        const libdbo_configuration_t* clause_shape_log = libdbo_configuration_list_find(connection->configuration_list, "clause_shape_log");
         if (!backend) {
             return LIBDBO_ERROR_UNKNOWN;
         }
@@ -88,6 +106,26 @@ int libdbo_connection_setup(libdbo_connection_t* connection) {
         if (!connection->backend) {
             return LIBDBO_ERROR_UNKNOWN;
         }
+
+        if (identity_map && atol(libdbo_configuration_value(identity_map)) > 0) {
+            connection->identity_map = libdbo_identity_map_new((size_t)atol(libdbo_configuration_value(identity_map)));
+            if (!connection->identity_map) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+        }
+        if (lookup_filter) {
+            connection->lookup_filter = libdbo_lookup_filter_new(libdbo_configuration_value(lookup_filter),
+                lookup_filter_bits ? (size_t)atol(libdbo_configuration_value(lookup_filter_bits)) : LIBDBO_LOOKUP_FILTER_DEFAULT_BITS,
+                lookup_negative_cache ? (size_t)atol(libdbo_configuration_value(lookup_negative_cache)) : LIBDBO_LOOKUP_FILTER_DEFAULT_NEGATIVE_SIZE);
+            if (!connection->lookup_filter) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+        }
+        if (clause_shape_log) {
+            if (!(connection->clause_shape_log = strdup(libdbo_configuration_value(clause_shape_log)))) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+        }
     }
     return LIBDBO_OK;
 }
@@ -114,10 +152,15 @@ int libdbo_connection_disconnect(const libdbo_connection_t* connection) {
         return LIBDBO_ERROR_UNKNOWN;
     }
 
+    libdbo_identity_map_clear(connection->identity_map);
+    libdbo_lookup_filter_reset(connection->lookup_filter);
+    ((libdbo_connection_t*)connection)->transaction = 0;
     return libdbo_backend_disconnect(connection->backend);
 }
 
 int libdbo_connection_create(const libdbo_connection_t* connection, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set) {
+    int ret;
+
     if (!connection) {
         return LIBDBO_ERROR_UNKNOWN;
     }
@@ -134,10 +177,15 @@ int libdbo_connection_create(const libdbo_connection_t* connection, const libdbo
         return LIBDBO_ERROR_UNKNOWN;
     }
 
-    return libdbo_backend_create(connection->backend, object, object_field_list, value_set);
+    ret = libdbo_backend_create(connection->backend, object, object_field_list, value_set);
+    libdbo_lookup_filter_write(connection->lookup_filter, object, object_field_list, value_set);
+    return ret;
 }
 
 libdbo_result_list_t* libdbo_connection_read(const libdbo_connection_t* connection, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list) {
+    libdbo_result_list_t* result_list;
+    int lookup;
+
     if (!connection) {
         return NULL;
     }
@@ -148,10 +196,37 @@ libdbo_result_list_t* libdbo_connection_read(const libdbo_connection_t* connecti
         return NULL;
     }
 
-    return libdbo_backend_read(connection->backend, object, join_list, clause_list);
+    lookup = libdbo_lookup_filter_lookup(connection->lookup_filter, object, join_list, clause_list);
+    if (lookup && libdbo_lookup_filter_miss(connection->lookup_filter, connection, object, clause_list)) {
+        return libdbo_result_list_new();
+    }
+    if ((result_list = libdbo_identity_map_get(connection->identity_map, object, join_list, clause_list))) {
+        return result_list;
+    }
+
+    if (!(result_list = libdbo_backend_read(connection->backend, object, join_list, clause_list))) {
+        return NULL;
+    }
+    if (lookup
+        || (connection->identity_map && libdbo_identity_map_primary_key(object, join_list, clause_list)))
+    {
+        if (libdbo_result_list_fetch_all(result_list)) {
+            libdbo_result_list_free(result_list);
+            return NULL;
+        }
+        if (lookup && !libdbo_result_list_size(result_list)) {
+            libdbo_lookup_filter_add_miss(connection->lookup_filter, object, clause_list);
+        }
+        if (connection->identity_map) {
+            (void)libdbo_identity_map_put(connection->identity_map, object, join_list, clause_list, result_list);
+        }
+    }
+    return result_list;
 }
 
 int libdbo_connection_update(const libdbo_connection_t* connection, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, const libdbo_clause_list_t* clause_list) {
+    int ret;
+
     if (!connection) {
         return LIBDBO_ERROR_UNKNOWN;
     }
@@ -168,10 +243,15 @@ int libdbo_connection_update(const libdbo_connection_t* connection, const libdbo
         return LIBDBO_ERROR_UNKNOWN;
     }
 
-    return libdbo_backend_update(connection->backend, object, object_field_list, value_set, clause_list);
+    ret = libdbo_backend_update(connection->backend, object, object_field_list, value_set, clause_list);
+    libdbo_identity_map_invalidate(connection->identity_map, object, clause_list);
+    libdbo_lookup_filter_write(connection->lookup_filter, object, object_field_list, value_set);
+    return ret;
 }
 
 int libdbo_connection_delete(const libdbo_connection_t* connection, const libdbo_object_t* object, const libdbo_clause_list_t* clause_list) {
+    int ret;
+
     if (!connection) {
         return LIBDBO_ERROR_UNKNOWN;
     }
@@ -182,10 +262,14 @@ int libdbo_connection_delete(const libdbo_connection_t* connection, const libdbo
         return LIBDBO_ERROR_UNKNOWN;
     }
 
-    return libdbo_backend_delete(connection->backend, object, clause_list);
+    ret = libdbo_backend_delete(connection->backend, object, clause_list);
+    libdbo_identity_map_invalidate(connection->identity_map, object, clause_list);
+    return ret;
 }
 
 int libdbo_connection_count(const libdbo_connection_t* connection, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list, size_t* count) {
+    int lookup;
+
     if (!connection) {
         return LIBDBO_ERROR_UNKNOWN;
     }
@@ -199,10 +283,69 @@ int libdbo_connection_count(const libdbo_connection_t* connection, const libdbo_
         return LIBDBO_ERROR_UNKNOWN;
     }
 
-    return libdbo_backend_count(connection->backend, object, join_list, clause_list, count);
+    lookup = libdbo_lookup_filter_lookup(connection->lookup_filter, object, join_list, clause_list);
+    if (lookup && libdbo_lookup_filter_miss(connection->lookup_filter, connection, object, clause_list)) {
+        *count = 0;
+        return LIBDBO_OK;
+    }
+
+    if (libdbo_backend_count(connection->backend, object, join_list, clause_list, count)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (lookup && !*count) {
+        libdbo_lookup_filter_add_miss(connection->lookup_filter, object, clause_list);
+    }
+    return LIBDBO_OK;
+}
+
+int libdbo_connection_upsert(const libdbo_connection_t* connection, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, const libdbo_clause_list_t* clause_list) {
+    int ret;
+
+    if (!connection) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object_field_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!value_set) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!clause_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!connection->backend) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    ret = libdbo_backend_upsert(connection->backend, object, object_field_list, value_set, clause_list);
+    libdbo_identity_map_invalidate(connection->identity_map, object, clause_list);
+    libdbo_lookup_filter_write(connection->lookup_filter, object, object_field_list, value_set);
+    return ret;
+}
+
+int libdbo_connection_read_batch(const libdbo_connection_t* connection, size_t size, const libdbo_object_t** objects, const libdbo_join_list_t** join_lists, const libdbo_clause_list_t** clause_lists, libdbo_result_list_t** result_lists) {
+    if (!connection) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!objects) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!result_lists) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!connection->backend) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    return libdbo_backend_read_batch(connection->backend, size, objects, join_lists, clause_lists, result_lists);
 }
 
 int libdbo_connection_transaction_begin(const libdbo_connection_t* connection) {
+    int ret;
+
     if (!connection) {
         return LIBDBO_ERROR_UNKNOWN;
     }
@@ -210,10 +353,25 @@ int libdbo_connection_transaction_begin(const libdbo_connection_t* connection) {
         return LIBDBO_ERROR_UNKNOWN;
     }
 
-    return libdbo_backend_transaction_begin(connection->backend);
+    /*
+     * Objects read before the transaction may have been changed by others.
+     */
+    libdbo_identity_map_clear(connection->identity_map);
+    if ((ret = libdbo_backend_transaction_begin(connection->backend))) {
+        return ret;
+    }
+
+    /*
+     * The depth is kept on the connection, which is otherwise not changed by
+     * transactions, so that a connection pool can tell if it is left open.
+     */
+    ((libdbo_connection_t*)connection)->transaction++;
+    return LIBDBO_OK;
 }
 
 int libdbo_connection_transaction_commit(const libdbo_connection_t* connection) {
+    int ret;
+
     if (!connection) {
         return LIBDBO_ERROR_UNKNOWN;
     }
@@ -221,10 +379,23 @@ int libdbo_connection_transaction_commit(const libdbo_connection_t* connection)
         return LIBDBO_ERROR_UNKNOWN;
     }
 
-    return libdbo_backend_transaction_commit(connection->backend);
+    /*
+     * The objects read inside the transaction are not kept after it.
+     */
+    libdbo_identity_map_clear(connection->identity_map);
+    if ((ret = libdbo_backend_transaction_commit(connection->backend))) {
+        return ret;
+    }
+
+    if (connection->transaction) {
+        ((libdbo_connection_t*)connection)->transaction--;
+    }
+    return LIBDBO_OK;
 }
 
 int libdbo_connection_transaction_rollback(const libdbo_connection_t* connection) {
+    int ret;
+
     if (!connection) {
         return LIBDBO_ERROR_UNKNOWN;
     }
@@ -232,5 +403,55 @@ int libdbo_connection_transaction_rollback(const libdbo_connection_t* connection
         return LIBDBO_ERROR_UNKNOWN;
     }
 
-    return libdbo_backend_transaction_rollback(connection->backend);
+    libdbo_identity_map_clear(connection->identity_map);
+    libdbo_lookup_filter_reset(connection->lookup_filter);
+    if ((ret = libdbo_backend_transaction_rollback(connection->backend))) {
+        return ret;
+    }
+
+    if (connection->transaction) {
+        ((libdbo_connection_t*)connection)->transaction--;
+    }
+    return LIBDBO_OK;
+}
+
+int libdbo_connection_transaction(const libdbo_connection_t* connection) {
+    if (!connection) {
+        return 0;
+    }
+
+    return connection->transaction;
+}
+
+const libdbo_identity_map_t* libdbo_connection_identity_map(const libdbo_connection_t* connection) {
+    if (!connection) {
+        return NULL;
+    }
+
+    return connection->identity_map;
+}
+
+const libdbo_lookup_filter_t* libdbo_connection_lookup_filter(const libdbo_connection_t* connection) {
+    if (!connection) {
+        return NULL;
+    }
+
+    return connection->lookup_filter;
+}
+
+libdbo_stats_t* libdbo_connection_stats(const libdbo_connection_t* connection) {
+    if (!connection) {
+        return NULL;
+    }
+
+    return libdbo_backend_stats(connection->backend);
+}
+
+int libdbo_connection_identity_map_clear(const libdbo_connection_t* connection) {
+    if (!connection) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    libdbo_identity_map_clear(connection->identity_map);
+    return LIBDBO_OK;
 }
@@ -0,0 +1,503 @@
+/*
+ * Copyright (c) 2014 Jerry Lundström <lundstrom.jerry@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "libdbo/connection_pool.h"
+#include "libdbo/error.h"
+
+#include "libdbo/mm.h"
+
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+
+/**
+ * A connection of the pool, it is either in the idle list with the most
+ * recently checked in first or in the in use list.
+ */
+typedef struct libdbo_connection_pool_entry libdbo_connection_pool_entry_t;
+struct libdbo_connection_pool_entry {
+    libdbo_connection_pool_entry_t* next;
+    libdbo_connection_t* connection;
+    time_t idle_since;
+};
+
+static libdbo_mm_t __connection_pool_entry_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_connection_pool_entry_t));
+
+/**
+ * A database connection pool, `stats.size` also counts connections that are
+ * being opened without holding the lock.
+ */
+struct libdbo_connection_pool {
+    const libdbo_configuration_list_t* configuration_list;
+    size_t min_size;
+    size_t max_size;
+    unsigned int idle_timeout;
+    libdbo_connection_pool_validate_t validate;
+    void* validate_data;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    libdbo_connection_pool_entry_t* idle_list;
+    libdbo_connection_pool_entry_t* in_use_list;
+    libdbo_connection_pool_stats_t stats;
+};
+
+static libdbo_mm_t __connection_pool_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_connection_pool_t));
+
+/**
+ * Opening connections is serialized over all pools since initializing the
+ * backends is not thread safe.
+ */
+static pthread_mutex_t __connection_pool_open_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static libdbo_connection_t* __connection_pool_open(const libdbo_connection_pool_t* connection_pool) {
+    libdbo_connection_t* connection;
+
+    if (pthread_mutex_lock(&__connection_pool_open_lock)) {
+        return NULL;
+    }
+    if (!(connection = libdbo_connection_new())
+        || libdbo_connection_set_configuration_list(connection, connection_pool->configuration_list)
+        || libdbo_connection_setup(connection)
+        || libdbo_connection_connect(connection))
+    {
+        libdbo_connection_free(connection);
+        connection = NULL;
+    }
+    pthread_mutex_unlock(&__connection_pool_open_lock);
+
+    return connection;
+}
+
+static void __connection_pool_entry_free(libdbo_connection_pool_entry_t* entry) {
+    libdbo_connection_pool_entry_t* next;
+
+    while (entry) {
+        next = entry->next;
+        if (entry->connection) {
+            libdbo_connection_disconnect(entry->connection);
+            libdbo_connection_free(entry->connection);
+        }
+        libdbo_mm_delete(&__connection_pool_entry_alloc, entry);
+        entry = next;
+    }
+}
+
+/**
+ * The default validation, begins and commits an empty transaction.
+ */
+static int __connection_pool_validate(const libdbo_connection_t* connection, void* user_data) {
+    (void)user_data;
+
+    if (libdbo_connection_transaction_begin(connection)
+        || libdbo_connection_transaction_commit(connection))
+    {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    return LIBDBO_OK;
+}
+
+/**
+ * Remove the entry of a checked out connection from the in use list, must be
+ * called with the lock held.
+ */
+static libdbo_connection_pool_entry_t* __connection_pool_take(libdbo_connection_pool_t* connection_pool, const libdbo_connection_t* connection) {
+    libdbo_connection_pool_entry_t** entryp;
+    libdbo_connection_pool_entry_t* entry;
+
+    for (entryp = &(connection_pool->in_use_list); (entry = *entryp); entryp = &(entry->next)) {
+        if (entry->connection == connection) {
+            *entryp = entry->next;
+            entry->next = NULL;
+            connection_pool->stats.in_use--;
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Remove the idle connections that have reached the idle timeout while there
+ * are more then the minimum number of connections, must be called with the
+ * lock held. The removed entries are returned so they can be closed without
+ * the lock.
+ */
+static libdbo_connection_pool_entry_t* __connection_pool_evict(libdbo_connection_pool_t* connection_pool, time_t now) {
+    libdbo_connection_pool_entry_t** entryp;
+    libdbo_connection_pool_entry_t* entry;
+    libdbo_connection_pool_entry_t* evict_list = NULL;
+
+    if (!connection_pool->idle_timeout) {
+        return NULL;
+    }
+
+    entryp = &(connection_pool->idle_list);
+    while ((entry = *entryp) && connection_pool->stats.size > connection_pool->min_size) {
+        if (now - entry->idle_since >= (time_t)connection_pool->idle_timeout) {
+            *entryp = entry->next;
+            entry->next = evict_list;
+            evict_list = entry;
+            connection_pool->stats.size--;
+            connection_pool->stats.idle--;
+            connection_pool->stats.evicted++;
+            continue;
+        }
+        entryp = &(entry->next);
+    }
+    return evict_list;
+}
+
+static libdbo_connection_t* __connection_pool_checkout(libdbo_connection_pool_t* connection_pool, const struct timespec* deadline) {
+    libdbo_connection_pool_entry_t* entry;
+    libdbo_connection_pool_validate_t validate;
+    void* validate_data;
+    struct timespec start, now;
+    unsigned long long wait_usec;
+    int waited = 0;
+    int created;
+    int ret;
+
+    if (clock_gettime(CLOCK_REALTIME, &start)) {
+        return NULL;
+    }
+    if (pthread_mutex_lock(&(connection_pool->lock))) {
+        return NULL;
+    }
+
+    for (;;) {
+        created = 0;
+        if ((entry = connection_pool->idle_list)) {
+            connection_pool->idle_list = entry->next;
+            connection_pool->stats.idle--;
+        }
+        else if (connection_pool->stats.size < connection_pool->max_size) {
+            if (!(entry = (libdbo_connection_pool_entry_t*)libdbo_mm_new0(&__connection_pool_entry_alloc))) {
+                pthread_mutex_unlock(&(connection_pool->lock));
+                return NULL;
+            }
+            connection_pool->stats.size++;
+            pthread_mutex_unlock(&(connection_pool->lock));
+
+            entry->connection = __connection_pool_open(connection_pool);
+
+            pthread_mutex_lock(&(connection_pool->lock));
+            if (!entry->connection) {
+                connection_pool->stats.size--;
+                pthread_cond_signal(&(connection_pool->cond));
+                pthread_mutex_unlock(&(connection_pool->lock));
+                libdbo_mm_delete(&__connection_pool_entry_alloc, entry);
+                return NULL;
+            }
+            connection_pool->stats.created++;
+            created = 1;
+        }
+        else {
+            if (!waited) {
+                connection_pool->stats.waits++;
+                waited = 1;
+            }
+            if (deadline) {
+                ret = pthread_cond_timedwait(&(connection_pool->cond), &(connection_pool->lock), deadline);
+                if (ret == ETIMEDOUT) {
+                    connection_pool->stats.timeouts++;
+                }
+            }
+            else {
+                ret = pthread_cond_wait(&(connection_pool->cond), &(connection_pool->lock));
+            }
+            if (ret) {
+                pthread_mutex_unlock(&(connection_pool->lock));
+                return NULL;
+            }
+            continue;
+        }
+
+        entry->next = connection_pool->in_use_list;
+        connection_pool->in_use_list = entry;
+        connection_pool->stats.in_use++;
+        validate = connection_pool->validate;
+        validate_data = connection_pool->validate_data;
+        pthread_mutex_unlock(&(connection_pool->lock));
+
+        if (created || !validate || !validate(entry->connection, validate_data)) {
+            break;
+        }
+
+        pthread_mutex_lock(&(connection_pool->lock));
+        __connection_pool_take(connection_pool, entry->connection);
+        connection_pool->stats.size--;
+        connection_pool->stats.invalid++;
+        pthread_cond_signal(&(connection_pool->cond));
+        pthread_mutex_unlock(&(connection_pool->lock));
+
+        __connection_pool_entry_free(entry);
+
+        pthread_mutex_lock(&(connection_pool->lock));
+    }
+
+    if (clock_gettime(CLOCK_REALTIME, &now)) {
+        now = start;
+    }
+    wait_usec = 0;
+    if (now.tv_sec > start.tv_sec || (now.tv_sec == start.tv_sec && now.tv_nsec > start.tv_nsec)) {
+        wait_usec = (unsigned long long)(now.tv_sec - start.tv_sec) * 1000000
+            + (unsigned long long)(now.tv_nsec / 1000)
+            - (unsigned long long)(start.tv_nsec / 1000);
+    }
+
+    pthread_mutex_lock(&(connection_pool->lock));
+    connection_pool->stats.checkouts++;
+    if (waited) {
+        connection_pool->stats.wait_usec += wait_usec;
+        if (wait_usec > connection_pool->stats.max_wait_usec) {
+            connection_pool->stats.max_wait_usec = wait_usec;
+        }
+    }
+    pthread_mutex_unlock(&(connection_pool->lock));
+
+    return entry->connection;
+}
+
+/* DB CONNECTION POOL */
+
+libdbo_connection_pool_t* libdbo_connection_pool_new(const libdbo_configuration_list_t* configuration_list, size_t min_size, size_t max_size) {
+    libdbo_connection_pool_t* connection_pool;
+    libdbo_connection_pool_entry_t* entry;
+    size_t i;
+
+    if (!configuration_list) {
+        return NULL;
+    }
+    if (!max_size) {
+        return NULL;
+    }
+    if (min_size > max_size) {
+        return NULL;
+    }
+
+    if (!(connection_pool = (libdbo_connection_pool_t*)libdbo_mm_new0(&__connection_pool_alloc))) {
+        return NULL;
+    }
+    if (pthread_mutex_init(&(connection_pool->lock), NULL)) {
+        libdbo_mm_delete(&__connection_pool_alloc, connection_pool);
+        return NULL;
+    }
+    if (pthread_cond_init(&(connection_pool->cond), NULL)) {
+        pthread_mutex_destroy(&(connection_pool->lock));
+        libdbo_mm_delete(&__connection_pool_alloc, connection_pool);
+        return NULL;
+    }
+    connection_pool->configuration_list = configuration_list;
+    connection_pool->min_size = min_size;
+    connection_pool->max_size = max_size;
+    connection_pool->validate = __connection_pool_validate;
+
+    for (i = 0; i < min_size; i++) {
+        if (!(entry = (libdbo_connection_pool_entry_t*)libdbo_mm_new0(&__connection_pool_entry_alloc))) {
+            libdbo_connection_pool_free(connection_pool);
+            return NULL;
+        }
+        if (!(entry->connection = __connection_pool_open(connection_pool))) {
+            libdbo_mm_delete(&__connection_pool_entry_alloc, entry);
+            libdbo_connection_pool_free(connection_pool);
+            return NULL;
+        }
+        entry->idle_since = time(NULL);
+        entry->next = connection_pool->idle_list;
+        connection_pool->idle_list = entry;
+        connection_pool->stats.size++;
+        connection_pool->stats.idle++;
+        connection_pool->stats.created++;
+    }
+
+    return connection_pool;
+}
+
+void libdbo_connection_pool_free(libdbo_connection_pool_t* connection_pool) {
+    if (connection_pool) {
+        __connection_pool_entry_free(connection_pool->idle_list);
+        __connection_pool_entry_free(connection_pool->in_use_list);
+        pthread_cond_destroy(&(connection_pool->cond));
+        pthread_mutex_destroy(&(connection_pool->lock));
+        libdbo_mm_delete(&__connection_pool_alloc, connection_pool);
+    }
+}
+
+int libdbo_connection_pool_set_idle_timeout(libdbo_connection_pool_t* connection_pool, unsigned int idle_timeout) {
+    if (!connection_pool) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (pthread_mutex_lock(&(connection_pool->lock))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    connection_pool->idle_timeout = idle_timeout;
+    pthread_mutex_unlock(&(connection_pool->lock));
+    return LIBDBO_OK;
+}
+
+int libdbo_connection_pool_set_validate(libdbo_connection_pool_t* connection_pool, libdbo_connection_pool_validate_t validate, void* user_data) {
+    if (!connection_pool) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (pthread_mutex_lock(&(connection_pool->lock))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    connection_pool->validate = validate;
+    connection_pool->validate_data = user_data;
+    pthread_mutex_unlock(&(connection_pool->lock));
+    return LIBDBO_OK;
+}
+
+libdbo_connection_t* libdbo_connection_pool_checkout(libdbo_connection_pool_t* connection_pool) {
+    if (!connection_pool) {
+        return NULL;
+    }
+
+    return __connection_pool_checkout(connection_pool, NULL);
+}
+
+libdbo_connection_t* libdbo_connection_pool_checkout_timed(libdbo_connection_pool_t* connection_pool, unsigned int timeout) {
+    struct timespec deadline;
+
+    if (!connection_pool) {
+        return NULL;
+    }
+
+    if (clock_gettime(CLOCK_REALTIME, &deadline)) {
+        return NULL;
+    }
+    deadline.tv_sec += timeout / 1000;
+    deadline.tv_nsec += (long)(timeout % 1000) * 1000000;
+    if (deadline.tv_nsec > 999999999) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    return __connection_pool_checkout(connection_pool, &deadline);
+}
+
+int libdbo_connection_pool_checkin(libdbo_connection_pool_t* connection_pool, libdbo_connection_t* connection) {
+    libdbo_connection_pool_entry_t* entry;
+    libdbo_connection_pool_entry_t* evict_list;
+
+    if (!connection_pool) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!connection) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * The next user of the connection must not end up inside a transaction
+     * it did not begin.
+     */
+    while (libdbo_connection_transaction(connection)) {
+        if (libdbo_connection_transaction_rollback(connection)) {
+            libdbo_connection_pool_discard(connection_pool, connection);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+
+    if (pthread_mutex_lock(&(connection_pool->lock))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!(entry = __connection_pool_take(connection_pool, connection))) {
+        pthread_mutex_unlock(&(connection_pool->lock));
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    entry->idle_since = time(NULL);
+    entry->next = connection_pool->idle_list;
+    connection_pool->idle_list = entry;
+    connection_pool->stats.idle++;
+    evict_list = __connection_pool_evict(connection_pool, entry->idle_since);
+    pthread_cond_signal(&(connection_pool->cond));
+    pthread_mutex_unlock(&(connection_pool->lock));
+
+    __connection_pool_entry_free(evict_list);
+    return LIBDBO_OK;
+}
+
+int libdbo_connection_pool_discard(libdbo_connection_pool_t* connection_pool, libdbo_connection_t* connection) {
+    libdbo_connection_pool_entry_t* entry;
+
+    if (!connection_pool) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!connection) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (pthread_mutex_lock(&(connection_pool->lock))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!(entry = __connection_pool_take(connection_pool, connection))) {
+        pthread_mutex_unlock(&(connection_pool->lock));
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    connection_pool->stats.size--;
+    connection_pool->stats.invalid++;
+    pthread_cond_signal(&(connection_pool->cond));
+    pthread_mutex_unlock(&(connection_pool->lock));
+
+    __connection_pool_entry_free(entry);
+    return LIBDBO_OK;
+}
+
+int libdbo_connection_pool_evict(libdbo_connection_pool_t* connection_pool) {
+    libdbo_connection_pool_entry_t* evict_list;
+
+    if (!connection_pool) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (pthread_mutex_lock(&(connection_pool->lock))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    evict_list = __connection_pool_evict(connection_pool, time(NULL));
+    pthread_mutex_unlock(&(connection_pool->lock));
+
+    __connection_pool_entry_free(evict_list);
+    return LIBDBO_OK;
+}
+
+int libdbo_connection_pool_stats(libdbo_connection_pool_t* connection_pool, libdbo_connection_pool_stats_t* stats) {
+    if (!connection_pool) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!stats) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (pthread_mutex_lock(&(connection_pool->lock))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    *stats = connection_pool->stats;
+    pthread_mutex_unlock(&(connection_pool->lock));
+    return LIBDBO_OK;
+}
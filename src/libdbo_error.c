@@ -32,6 +32,9 @@ const char* libdbo_errstr(int errno) {
     case LIBDBO_OK:
         return 0;
 
+    case LIBDBO_ERROR_REVISION:
+        return "Revision mismatch";
+
     case LIBDBO_ERROR_UNKNOWN:
     default:
         return "Unknown error";
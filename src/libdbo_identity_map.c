@@ -0,0 +1,539 @@
+/*
+ * Copyright (c) 2014 Jerry Lundström <lundstrom.jerry@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "libdbo/identity_map.h"
+#include "libdbo/error.h"
+
+#include "libdbo/mm.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * An object in the identity map, it is both in a hash bucket and in the LRU
+ * list.
+ */
+typedef struct libdbo_identity_map_entry libdbo_identity_map_entry_t;
+struct libdbo_identity_map_entry {
+    libdbo_identity_map_entry_t* bucket_next;
+    libdbo_identity_map_entry_t* lru_prev;
+    libdbo_identity_map_entry_t* lru_next;
+    unsigned long hash;
+    char* table;
+    libdbo_value_t* primary_key;
+    /** The object fields the result was read with, each NUL terminated. */
+    char* fields;
+    size_t fields_length;
+    libdbo_result_t* result;
+};
+
+static libdbo_mm_t __identity_map_entry_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_identity_map_entry_t));
+
+struct libdbo_identity_map {
+    size_t size;
+    size_t entries;
+    unsigned long hits;
+    unsigned long misses;
+    libdbo_identity_map_entry_t** buckets;
+    size_t buckets_size;
+    libdbo_identity_map_entry_t* lru_first;
+    libdbo_identity_map_entry_t* lru_last;
+};
+
+static libdbo_mm_t __identity_map_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_identity_map_t));
+
+/**
+ * Hash the table and primary key, integer keys are hashed by their value so
+ * that keys of different integer sizes that compare equal hash the same.
+ */
+static int __identity_map_hash(const char* table, const libdbo_value_t* primary_key, unsigned long* hash) {
+    unsigned long h = 2166136261UL;
+    libdbo_type_int32_t int32;
+    libdbo_type_uint32_t uint32;
+    libdbo_type_int64_t int64;
+    libdbo_type_uint64_t uint64;
+    const unsigned char* data;
+    size_t length;
+    size_t i;
+
+    for (data = (const unsigned char*)table; *data; data++) {
+        h ^= *data;
+        h *= 16777619UL;
+    }
+
+    switch (libdbo_value_type(primary_key)) {
+    case LIBDBO_TYPE_INT32:
+        if (libdbo_value_to_int32(primary_key, &int32)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        uint64 = (libdbo_type_uint64_t)int32;
+        data = (const unsigned char*)&uint64;
+        length = sizeof(uint64);
+        break;
+
+    case LIBDBO_TYPE_INT64:
+        if (libdbo_value_to_int64(primary_key, &int64)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        uint64 = (libdbo_type_uint64_t)int64;
+        data = (const unsigned char*)&uint64;
+        length = sizeof(uint64);
+        break;
+
+    case LIBDBO_TYPE_UINT32:
+        if (libdbo_value_to_uint32(primary_key, &uint32)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        uint64 = uint32;
+        data = (const unsigned char*)&uint64;
+        length = sizeof(uint64);
+        break;
+
+    case LIBDBO_TYPE_UINT64:
+        if (libdbo_value_to_uint64(primary_key, &uint64)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        data = (const unsigned char*)&uint64;
+        length = sizeof(uint64);
+        break;
+
+    case LIBDBO_TYPE_TEXT:
+        if (!(data = (const unsigned char*)libdbo_value_text(primary_key))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        length = strlen((const char*)data);
+        break;
+
+    default:
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    for (i = 0; i < length; i++) {
+        h ^= data[i];
+        h *= 16777619UL;
+    }
+
+    *hash = h;
+    return LIBDBO_OK;
+}
+
+/**
+ * Get the object fields of an object as NUL terminated names after each
+ * other, the returned string must be freed.
+ */
+static char* __identity_map_fields(const libdbo_object_t* object, size_t* fields_length) {
+    const libdbo_object_field_t* object_field;
+    char* fields;
+    size_t length = 0;
+
+    object_field = libdbo_object_field_list_begin(libdbo_object_object_field_list(object));
+    while (object_field) {
+        if (!libdbo_object_field_name(object_field)) {
+            return NULL;
+        }
+        length += strlen(libdbo_object_field_name(object_field)) + 1;
+        object_field = libdbo_object_field_next(object_field);
+    }
+
+    if (!(fields = (char*)malloc(length + 1))) {
+        return NULL;
+    }
+    length = 0;
+    object_field = libdbo_object_field_list_begin(libdbo_object_object_field_list(object));
+    while (object_field) {
+        strcpy(fields + length, libdbo_object_field_name(object_field));
+        length += strlen(libdbo_object_field_name(object_field)) + 1;
+        object_field = libdbo_object_field_next(object_field);
+    }
+    fields[length] = 0;
+
+    *fields_length = length;
+    return fields;
+}
+
+static void __identity_map_lru_unlink(libdbo_identity_map_t* identity_map, libdbo_identity_map_entry_t* entry) {
+    if (entry->lru_prev) {
+        entry->lru_prev->lru_next = entry->lru_next;
+    }
+    else {
+        identity_map->lru_first = entry->lru_next;
+    }
+    if (entry->lru_next) {
+        entry->lru_next->lru_prev = entry->lru_prev;
+    }
+    else {
+        identity_map->lru_last = entry->lru_prev;
+    }
+    entry->lru_prev = NULL;
+    entry->lru_next = NULL;
+}
+
+static void __identity_map_lru_push(libdbo_identity_map_t* identity_map, libdbo_identity_map_entry_t* entry) {
+    entry->lru_prev = NULL;
+    entry->lru_next = identity_map->lru_first;
+    if (identity_map->lru_first) {
+        identity_map->lru_first->lru_prev = entry;
+    }
+    else {
+        identity_map->lru_last = entry;
+    }
+    identity_map->lru_first = entry;
+}
+
+static void __identity_map_remove(libdbo_identity_map_t* identity_map, libdbo_identity_map_entry_t* entry) {
+    libdbo_identity_map_entry_t** bucket;
+
+    bucket = &(identity_map->buckets[entry->hash & (identity_map->buckets_size - 1)]);
+    while (*bucket) {
+        if (*bucket == entry) {
+            *bucket = entry->bucket_next;
+            break;
+        }
+        bucket = &((*bucket)->bucket_next);
+    }
+    __identity_map_lru_unlink(identity_map, entry);
+
+    free(entry->table);
+    free(entry->fields);
+    libdbo_value_free(entry->primary_key);
+    libdbo_result_free(entry->result);
+    libdbo_mm_delete(&__identity_map_entry_alloc, entry);
+    identity_map->entries--;
+}
+
+static libdbo_identity_map_entry_t* __identity_map_find(const libdbo_identity_map_t* identity_map, unsigned long hash, const char* table, const libdbo_value_t* primary_key) {
+    libdbo_identity_map_entry_t* entry;
+    int cmp;
+
+    entry = identity_map->buckets[hash & (identity_map->buckets_size - 1)];
+    while (entry) {
+        if (entry->hash == hash
+            && !strcmp(entry->table, table)
+            && !libdbo_value_cmp(entry->primary_key, primary_key, &cmp)
+            && !cmp)
+        {
+            return entry;
+        }
+        entry = entry->bucket_next;
+    }
+    return NULL;
+}
+
+/**
+ * Check if a clause is the primary key of the object equal to a value.
+ */
+static const libdbo_value_t* __identity_map_primary_key_clause(const libdbo_object_t* object, const libdbo_clause_t* clause) {
+    const libdbo_value_t* value;
+
+    if (libdbo_clause_type(clause) != LIBDBO_CLAUSE_EQUAL
+        || !libdbo_clause_field(clause)
+        || !libdbo_object_primary_key_name(object)
+        || strcmp(libdbo_clause_field(clause), libdbo_object_primary_key_name(object)))
+    {
+        return NULL;
+    }
+    if (libdbo_clause_table(clause)
+        && strcmp(libdbo_clause_table(clause), libdbo_object_table(object)))
+    {
+        return NULL;
+    }
+    if (!(value = libdbo_clause_value(clause))) {
+        return NULL;
+    }
+
+    switch (libdbo_value_type(value)) {
+    case LIBDBO_TYPE_INT32:
+    case LIBDBO_TYPE_UINT32:
+    case LIBDBO_TYPE_INT64:
+    case LIBDBO_TYPE_UINT64:
+    case LIBDBO_TYPE_TEXT:
+        return value;
+
+    default:
+        break;
+    }
+    return NULL;
+}
+
+/* DB IDENTITY MAP */
+
+libdbo_identity_map_t* libdbo_identity_map_new(size_t size) {
+    libdbo_identity_map_t* identity_map;
+    size_t buckets_size = 16;
+
+    if (!size) {
+        return NULL;
+    }
+
+    while (buckets_size < size) {
+        buckets_size *= 2;
+    }
+
+    if ((identity_map = (libdbo_identity_map_t*)libdbo_mm_new0(&__identity_map_alloc))) {
+        if (!(identity_map->buckets = (libdbo_identity_map_entry_t**)calloc(buckets_size, sizeof(libdbo_identity_map_entry_t*)))) {
+            libdbo_mm_delete(&__identity_map_alloc, identity_map);
+            return NULL;
+        }
+        identity_map->buckets_size = buckets_size;
+        identity_map->size = size;
+    }
+
+    return identity_map;
+}
+
+void libdbo_identity_map_free(libdbo_identity_map_t* identity_map) {
+    if (identity_map) {
+        libdbo_identity_map_clear(identity_map);
+        free(identity_map->buckets);
+        libdbo_mm_delete(&__identity_map_alloc, identity_map);
+    }
+}
+
+void libdbo_identity_map_clear(libdbo_identity_map_t* identity_map) {
+    if (identity_map) {
+        while (identity_map->lru_first) {
+            __identity_map_remove(identity_map, identity_map->lru_first);
+        }
+    }
+}
+
+const libdbo_value_t* libdbo_identity_map_primary_key(const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list) {
+    const libdbo_clause_t* clause;
+
+    if (!object) {
+        return NULL;
+    }
+    if (!libdbo_object_table(object)) {
+        return NULL;
+    }
+    if (libdbo_join_list_begin(join_list)) {
+        return NULL;
+    }
+    if (!(clause = libdbo_clause_list_begin(clause_list))) {
+        return NULL;
+    }
+    if (libdbo_clause_next(clause)) {
+        return NULL;
+    }
+
+    return __identity_map_primary_key_clause(object, clause);
+}
+
+libdbo_result_list_t* libdbo_identity_map_get(libdbo_identity_map_t* identity_map, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list) {
+    libdbo_identity_map_entry_t* entry;
+    const libdbo_value_t* primary_key;
+    libdbo_result_list_t* result_list;
+    libdbo_result_t* result;
+    char* fields;
+    size_t fields_length;
+    unsigned long hash;
+
+    if (!identity_map) {
+        return NULL;
+    }
+    if (!(primary_key = libdbo_identity_map_primary_key(object, join_list, clause_list))) {
+        return NULL;
+    }
+    if (__identity_map_hash(libdbo_object_table(object), primary_key, &hash)) {
+        return NULL;
+    }
+
+    if (!(entry = __identity_map_find(identity_map, hash, libdbo_object_table(object), primary_key))) {
+        identity_map->misses++;
+        return NULL;
+    }
+
+    /*
+     * The result only fits an object read with the same fields.
+     */
+    if (!(fields = __identity_map_fields(object, &fields_length))) {
+        return NULL;
+    }
+    if (fields_length != entry->fields_length
+        || memcmp(fields, entry->fields, fields_length))
+    {
+        free(fields);
+        identity_map->misses++;
+        return NULL;
+    }
+    free(fields);
+
+    if (!(result_list = libdbo_result_list_new())) {
+        return NULL;
+    }
+    if (!(result = libdbo_result_new_copy(entry->result))
+        || libdbo_result_list_add(result_list, result))
+    {
+        libdbo_result_free(result);
+        libdbo_result_list_free(result_list);
+        return NULL;
+    }
+
+    __identity_map_lru_unlink(identity_map, entry);
+    __identity_map_lru_push(identity_map, entry);
+    identity_map->hits++;
+    return result_list;
+}
+
+int libdbo_identity_map_put(libdbo_identity_map_t* identity_map, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list, const libdbo_result_list_t* result_list) {
+    libdbo_identity_map_entry_t* entry;
+    libdbo_identity_map_entry_t** bucket;
+    const libdbo_value_t* primary_key;
+    libdbo_result_list_t* copy;
+    unsigned long hash;
+
+    if (!identity_map) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!result_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!(primary_key = libdbo_identity_map_primary_key(object, join_list, clause_list))) {
+        return LIBDBO_OK;
+    }
+    if (libdbo_result_list_size(result_list) != 1) {
+        return LIBDBO_OK;
+    }
+    if (__identity_map_hash(libdbo_object_table(object), primary_key, &hash)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if ((entry = __identity_map_find(identity_map, hash, libdbo_object_table(object), primary_key))) {
+        __identity_map_remove(identity_map, entry);
+    }
+
+    /*
+     * The result list is const, take the result from a copy of it.
+     */
+    if (!(copy = libdbo_result_list_new_copy(result_list))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (!(entry = (libdbo_identity_map_entry_t*)libdbo_mm_new0(&__identity_map_entry_alloc))
+        || !(entry->table = strdup(libdbo_object_table(object)))
+        || !(entry->primary_key = libdbo_value_new_copy(primary_key))
+        || !(entry->fields = __identity_map_fields(object, &(entry->fields_length)))
+        || !(entry->result = libdbo_result_new_copy(libdbo_result_list_begin(copy))))
+    {
+        if (entry) {
+            free(entry->table);
+            free(entry->fields);
+            libdbo_value_free(entry->primary_key);
+            libdbo_mm_delete(&__identity_map_entry_alloc, entry);
+        }
+        libdbo_result_list_free(copy);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    libdbo_result_list_free(copy);
+    entry->hash = hash;
+
+    bucket = &(identity_map->buckets[hash & (identity_map->buckets_size - 1)]);
+    entry->bucket_next = *bucket;
+    *bucket = entry;
+    __identity_map_lru_push(identity_map, entry);
+    identity_map->entries++;
+
+    while (identity_map->entries > identity_map->size && identity_map->lru_last) {
+        __identity_map_remove(identity_map, identity_map->lru_last);
+    }
+    return LIBDBO_OK;
+}
+
+void libdbo_identity_map_invalidate(libdbo_identity_map_t* identity_map, const libdbo_object_t* object, const libdbo_clause_list_t* clause_list) {
+    libdbo_identity_map_entry_t* entry;
+    libdbo_identity_map_entry_t* next;
+    const libdbo_clause_t* clause;
+    const libdbo_value_t* primary_key = NULL;
+    const libdbo_value_t* value;
+    unsigned long hash;
+
+    if (!identity_map) {
+        return;
+    }
+    if (!object || !libdbo_object_table(object)) {
+        libdbo_identity_map_clear(identity_map);
+        return;
+    }
+
+    /*
+     * Only drop the one object if all clauses must match and one of them is
+     * the primary key.
+     */
+    clause = libdbo_clause_list_begin(clause_list);
+    while (clause) {
+        if (libdbo_clause_operator(clause) != LIBDBO_CLAUSE_OPERATOR_AND) {
+            primary_key = NULL;
+            break;
+        }
+        if (!primary_key && (value = __identity_map_primary_key_clause(object, clause))) {
+            primary_key = value;
+        }
+        clause = libdbo_clause_next(clause);
+    }
+
+    if (primary_key
+        && !__identity_map_hash(libdbo_object_table(object), primary_key, &hash))
+    {
+        if ((entry = __identity_map_find(identity_map, hash, libdbo_object_table(object), primary_key))) {
+            __identity_map_remove(identity_map, entry);
+        }
+        return;
+    }
+
+    entry = identity_map->lru_first;
+    while (entry) {
+        next = entry->lru_next;
+        if (!strcmp(entry->table, libdbo_object_table(object))) {
+            __identity_map_remove(identity_map, entry);
+        }
+        entry = next;
+    }
+}
+
+size_t libdbo_identity_map_size(const libdbo_identity_map_t* identity_map) {
+    if (!identity_map) {
+        return 0;
+    }
+
+    return identity_map->entries;
+}
+
+unsigned long libdbo_identity_map_hits(const libdbo_identity_map_t* identity_map) {
+    if (!identity_map) {
+        return 0;
+    }
+
+    return identity_map->hits;
+}
+
+unsigned long libdbo_identity_map_misses(const libdbo_identity_map_t* identity_map) {
+    if (!identity_map) {
+        return 0;
+    }
+
+    return identity_map->misses;
+}
@@ -0,0 +1,610 @@
+/*
+ * Copyright (c) 2014 Jerry Lundström <lundstrom.jerry@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "libdbo/lookup_filter.h"
+#include "libdbo/error.h"
+
+#include "libdbo/mm.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * The number of bits set in a Bloom filter for each value.
+ */
+#define __LOOKUP_FILTER_HASHES 7
+/**
+ * The number of bits in a Bloom filter for each value it holds, together
+ * with the number of hashes this gives about 1% false positives.
+ */
+#define __LOOKUP_FILTER_BITS_PER_VALUE 10
+
+/**
+ * A filtered field and its Bloom filter.
+ */
+typedef struct libdbo_lookup_filter_field libdbo_lookup_filter_field_t;
+struct libdbo_lookup_filter_field {
+    libdbo_lookup_filter_field_t* next;
+    char* table;
+    char* field;
+    /** Non-zero if the Bloom filter holds all values of the field. */
+    int loaded;
+    unsigned char* bits;
+    size_t bits_size;
+    size_t values;
+};
+
+static libdbo_mm_t __lookup_filter_field_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_lookup_filter_field_t));
+
+/**
+ * A lookup that did not find anything.
+ */
+typedef struct libdbo_lookup_filter_miss libdbo_lookup_filter_miss_t;
+struct libdbo_lookup_filter_miss {
+    libdbo_lookup_filter_miss_t* bucket_next;
+    const libdbo_lookup_filter_field_t* field;
+    libdbo_value_t* value;
+    libdbo_type_uint64_t hash;
+};
+
+struct libdbo_lookup_filter {
+    libdbo_lookup_filter_field_t* field_list;
+    size_t bits_size;
+    /** The negative cache is a ring of misses indexed by a hash table. */
+    libdbo_lookup_filter_miss_t* misses;
+    size_t misses_size;
+    size_t misses_next;
+    libdbo_lookup_filter_miss_t** buckets;
+    size_t buckets_size;
+    unsigned long bloom_hits;
+    unsigned long negative_hits;
+};
+
+static libdbo_mm_t __lookup_filter_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_lookup_filter_t));
+
+static char* __lookup_filter_strdup(const char* from, size_t length) {
+    char* to;
+
+    if ((to = (char*)malloc(length + 1))) {
+        memcpy(to, from, length);
+        to[length] = 0;
+    }
+    return to;
+}
+
+/**
+ * Hash a value with 64 bit FNV-1a, integer values are hashed by their value
+ * so that the same number hash the same in any integer type.
+ */
+static int __lookup_filter_hash(const libdbo_value_t* value, libdbo_type_uint64_t* hash) {
+    libdbo_type_uint64_t h = 14695981039346656037ULL;
+    libdbo_type_int64_t int64;
+    libdbo_type_uint64_t uint64;
+    const unsigned char* data;
+    size_t length;
+    size_t i;
+    int enum_value;
+
+    switch (libdbo_value_type(value)) {
+    case LIBDBO_TYPE_INT32:
+    case LIBDBO_TYPE_INT64:
+        if (libdbo_value_to_int64(value, &int64)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        uint64 = (libdbo_type_uint64_t)int64;
+        data = (const unsigned char*)&uint64;
+        length = sizeof(uint64);
+        break;
+
+    case LIBDBO_TYPE_UINT32:
+    case LIBDBO_TYPE_UINT64:
+        if (libdbo_value_to_uint64(value, &uint64)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        data = (const unsigned char*)&uint64;
+        length = sizeof(uint64);
+        break;
+
+    case LIBDBO_TYPE_ENUM:
+        if (libdbo_value_enum_value(value, &enum_value)) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        uint64 = (libdbo_type_uint64_t)(libdbo_type_int64_t)enum_value;
+        data = (const unsigned char*)&uint64;
+        length = sizeof(uint64);
+        break;
+
+    case LIBDBO_TYPE_TEXT:
+        if (!(data = (const unsigned char*)libdbo_value_text(value))) {
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        length = strlen((const char*)data);
+        break;
+
+    default:
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    for (i = 0; i < length; i++) {
+        h ^= data[i];
+        h *= 1099511628211ULL;
+    }
+
+    *hash = h;
+    return LIBDBO_OK;
+}
+
+/**
+ * Set or test the bits for a hash, uses double hashing to get all bit
+ * positions from the one hash.
+ */
+static int __lookup_filter_bits(libdbo_lookup_filter_field_t* field, libdbo_type_uint64_t hash, int set) {
+    libdbo_type_uint64_t h1 = hash & 0xffffffffULL;
+    libdbo_type_uint64_t h2 = (hash >> 32) | 1;
+    size_t bit;
+    int i;
+
+    for (i = 0; i < __LOOKUP_FILTER_HASHES; i++) {
+        bit = (size_t)((h1 + i * h2) & (field->bits_size - 1));
+        if (set) {
+            field->bits[bit >> 3] |= 1 << (bit & 7);
+        }
+        else if (!(field->bits[bit >> 3] & (1 << (bit & 7)))) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void __lookup_filter_field_add(libdbo_lookup_filter_field_t* field, const libdbo_value_t* value) {
+    libdbo_type_uint64_t hash;
+
+    if (!field->loaded) {
+        return;
+    }
+
+    /*
+     * A value that can not be hashed can not be ruled out later, unload the
+     * filter so it is not used.
+     */
+    if (__lookup_filter_hash(value, &hash)) {
+        field->loaded = 0;
+        return;
+    }
+    __lookup_filter_bits(field, hash, 1);
+    field->values++;
+
+    /*
+     * Once full the false positives grows fast, rebuild it larger on the next
+     * lookup.
+     */
+    if (field->values * __LOOKUP_FILTER_BITS_PER_VALUE > field->bits_size) {
+        field->loaded = 0;
+    }
+}
+
+/**
+ * Build the Bloom filter for a field by reading all objects of the table.
+ */
+static int __lookup_filter_field_load(const libdbo_lookup_filter_t* lookup_filter, libdbo_lookup_filter_field_t* field, const libdbo_connection_t* connection, const libdbo_object_t* object) {
+    const libdbo_object_field_t* object_field;
+    libdbo_result_list_t* result_list;
+    const libdbo_result_t* result;
+    const libdbo_value_t* value;
+    size_t position = 0;
+    size_t bits_size;
+
+    object_field = libdbo_object_field_list_begin(libdbo_object_object_field_list(object));
+    while (object_field) {
+        if (libdbo_object_field_name(object_field)
+            && !strcmp(libdbo_object_field_name(object_field), field->field))
+        {
+            break;
+        }
+        position++;
+        object_field = libdbo_object_field_next(object_field);
+    }
+    if (!object_field) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (!(result_list = libdbo_connection_read(connection, object, NULL, NULL))
+        || libdbo_result_list_fetch_all(result_list))
+    {
+        libdbo_result_list_free(result_list);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    bits_size = lookup_filter->bits_size;
+    while (bits_size < libdbo_result_list_size(result_list) * __LOOKUP_FILTER_BITS_PER_VALUE * 2) {
+        bits_size *= 2;
+    }
+    if (bits_size != field->bits_size) {
+        free(field->bits);
+        if (!(field->bits = (unsigned char*)calloc(bits_size / 8, 1))) {
+            field->bits_size = 0;
+            libdbo_result_list_free(result_list);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+        field->bits_size = bits_size;
+    }
+    else {
+        memset(field->bits, 0, bits_size / 8);
+    }
+    field->values = 0;
+    field->loaded = 1;
+
+    result = libdbo_result_list_begin(result_list);
+    while (result && field->loaded) {
+        if (!(value = libdbo_value_set_at(libdbo_result_value_set(result), position))) {
+            field->loaded = 0;
+            break;
+        }
+        if (libdbo_value_type(value) != LIBDBO_TYPE_EMPTY) {
+            __lookup_filter_field_add(field, value);
+        }
+        result = libdbo_result_list_next(result_list);
+    }
+    libdbo_result_list_free(result_list);
+
+    if (!field->loaded) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    return LIBDBO_OK;
+}
+
+/**
+ * Get the filtered field and value a lookup is for.
+ */
+static libdbo_lookup_filter_field_t* __lookup_filter_field(const libdbo_lookup_filter_t* lookup_filter, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list, const libdbo_value_t** value) {
+    libdbo_lookup_filter_field_t* field;
+    const libdbo_clause_t* clause;
+
+    if (!lookup_filter) {
+        return NULL;
+    }
+    if (!object || !libdbo_object_table(object)) {
+        return NULL;
+    }
+    if (libdbo_join_list_begin(join_list)) {
+        return NULL;
+    }
+    if (!(clause = libdbo_clause_list_begin(clause_list))
+        || libdbo_clause_next(clause)
+        || libdbo_clause_type(clause) != LIBDBO_CLAUSE_EQUAL
+        || !libdbo_clause_field(clause)
+        || !libdbo_clause_value(clause))
+    {
+        return NULL;
+    }
+    if (libdbo_clause_table(clause)
+        && strcmp(libdbo_clause_table(clause), libdbo_object_table(object)))
+    {
+        return NULL;
+    }
+
+    for (field = lookup_filter->field_list; field; field = field->next) {
+        if (!strcmp(field->table, libdbo_object_table(object))
+            && !strcmp(field->field, libdbo_clause_field(clause)))
+        {
+            if (value) {
+                *value = libdbo_clause_value(clause);
+            }
+            return field;
+        }
+    }
+    return NULL;
+}
+
+static libdbo_lookup_filter_miss_t** __lookup_filter_miss_find(libdbo_lookup_filter_t* lookup_filter, const libdbo_lookup_filter_field_t* field, const libdbo_value_t* value, libdbo_type_uint64_t hash) {
+    libdbo_lookup_filter_miss_t** miss;
+    int cmp;
+
+    miss = &(lookup_filter->buckets[hash & (lookup_filter->buckets_size - 1)]);
+    while (*miss) {
+        if ((*miss)->hash == hash
+            && (*miss)->field == field
+            && !libdbo_value_cmp((*miss)->value, value, &cmp)
+            && !cmp)
+        {
+            return miss;
+        }
+        miss = &((*miss)->bucket_next);
+    }
+    return NULL;
+}
+
+static void __lookup_filter_miss_remove(libdbo_lookup_filter_t* lookup_filter, libdbo_lookup_filter_miss_t* miss) {
+    libdbo_lookup_filter_miss_t** bucket;
+
+    if (!miss->value) {
+        return;
+    }
+
+    bucket = &(lookup_filter->buckets[miss->hash & (lookup_filter->buckets_size - 1)]);
+    while (*bucket) {
+        if (*bucket == miss) {
+            *bucket = miss->bucket_next;
+            break;
+        }
+        bucket = &((*bucket)->bucket_next);
+    }
+
+    libdbo_value_free(miss->value);
+    miss->value = NULL;
+    miss->field = NULL;
+    miss->bucket_next = NULL;
+}
+
+/* DB LOOKUP FILTER */
+
+libdbo_lookup_filter_t* libdbo_lookup_filter_new(const char* fields, size_t bits, size_t negative_size) {
+    libdbo_lookup_filter_t* lookup_filter;
+    libdbo_lookup_filter_field_t* field;
+    const char* start;
+    const char* dot;
+    const char* end;
+
+    if (!fields) {
+        return NULL;
+    }
+
+    if (!(lookup_filter = (libdbo_lookup_filter_t*)libdbo_mm_new0(&__lookup_filter_alloc))) {
+        return NULL;
+    }
+
+    lookup_filter->bits_size = 64;
+    while (lookup_filter->bits_size < bits) {
+        lookup_filter->bits_size *= 2;
+    }
+
+    if (negative_size) {
+        lookup_filter->buckets_size = 16;
+        while (lookup_filter->buckets_size < negative_size) {
+            lookup_filter->buckets_size *= 2;
+        }
+        if (!(lookup_filter->misses = (libdbo_lookup_filter_miss_t*)calloc(negative_size, sizeof(libdbo_lookup_filter_miss_t)))
+            || !(lookup_filter->buckets = (libdbo_lookup_filter_miss_t**)calloc(lookup_filter->buckets_size, sizeof(libdbo_lookup_filter_miss_t*))))
+        {
+            libdbo_lookup_filter_free(lookup_filter);
+            return NULL;
+        }
+        lookup_filter->misses_size = negative_size;
+    }
+
+    for (start = fields; *start; start = *end ? end + 1 : end) {
+        if (!(end = strchr(start, ','))) {
+            end = start + strlen(start);
+        }
+        if (end == start) {
+            continue;
+        }
+        if (!(dot = memchr(start, '.', end - start))
+            || dot == start
+            || dot + 1 == end)
+        {
+            libdbo_lookup_filter_free(lookup_filter);
+            return NULL;
+        }
+
+        if (!(field = (libdbo_lookup_filter_field_t*)libdbo_mm_new0(&__lookup_filter_field_alloc))) {
+            libdbo_lookup_filter_free(lookup_filter);
+            return NULL;
+        }
+        field->next = lookup_filter->field_list;
+        lookup_filter->field_list = field;
+        if (!(field->table = __lookup_filter_strdup(start, dot - start))
+            || !(field->field = __lookup_filter_strdup(dot + 1, end - dot - 1)))
+        {
+            libdbo_lookup_filter_free(lookup_filter);
+            return NULL;
+        }
+    }
+
+    return lookup_filter;
+}
+
+void libdbo_lookup_filter_free(libdbo_lookup_filter_t* lookup_filter) {
+    libdbo_lookup_filter_field_t* field;
+    size_t i;
+
+    if (lookup_filter) {
+        while ((field = lookup_filter->field_list)) {
+            lookup_filter->field_list = field->next;
+            free(field->table);
+            free(field->field);
+            free(field->bits);
+            libdbo_mm_delete(&__lookup_filter_field_alloc, field);
+        }
+        if (lookup_filter->misses) {
+            for (i = 0; i < lookup_filter->misses_size; i++) {
+                libdbo_value_free(lookup_filter->misses[i].value);
+            }
+            free(lookup_filter->misses);
+        }
+        free(lookup_filter->buckets);
+        libdbo_mm_delete(&__lookup_filter_alloc, lookup_filter);
+    }
+}
+
+void libdbo_lookup_filter_reset(libdbo_lookup_filter_t* lookup_filter) {
+    libdbo_lookup_filter_field_t* field;
+    size_t i;
+
+    if (lookup_filter) {
+        for (field = lookup_filter->field_list; field; field = field->next) {
+            field->loaded = 0;
+        }
+        for (i = 0; i < lookup_filter->misses_size; i++) {
+            __lookup_filter_miss_remove(lookup_filter, &(lookup_filter->misses[i]));
+        }
+    }
+}
+
+int libdbo_lookup_filter_lookup(const libdbo_lookup_filter_t* lookup_filter, const libdbo_object_t* object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list) {
+    return __lookup_filter_field(lookup_filter, object, join_list, clause_list, NULL) ? 1 : 0;
+}
+
+int libdbo_lookup_filter_miss(libdbo_lookup_filter_t* lookup_filter, const libdbo_connection_t* connection, const libdbo_object_t* object, const libdbo_clause_list_t* clause_list) {
+    libdbo_lookup_filter_field_t* field;
+    const libdbo_value_t* value;
+    libdbo_type_uint64_t hash;
+
+    if (!lookup_filter) {
+        return 0;
+    }
+    if (!connection) {
+        return 0;
+    }
+    if (!(field = __lookup_filter_field(lookup_filter, object, NULL, clause_list, &value))) {
+        return 0;
+    }
+    if (__lookup_filter_hash(value, &hash)) {
+        return 0;
+    }
+
+    if (lookup_filter->misses_size
+        && __lookup_filter_miss_find(lookup_filter, field, value, hash))
+    {
+        lookup_filter->negative_hits++;
+        return 1;
+    }
+
+    if (!field->loaded
+        && __lookup_filter_field_load(lookup_filter, field, connection, object))
+    {
+        return 0;
+    }
+    if (!__lookup_filter_bits(field, hash, 0)) {
+        lookup_filter->bloom_hits++;
+        return 1;
+    }
+    return 0;
+}
+
+void libdbo_lookup_filter_add_miss(libdbo_lookup_filter_t* lookup_filter, const libdbo_object_t* object, const libdbo_clause_list_t* clause_list) {
+    libdbo_lookup_filter_field_t* field;
+    libdbo_lookup_filter_miss_t* miss;
+    libdbo_lookup_filter_miss_t** bucket;
+    const libdbo_value_t* value;
+    libdbo_type_uint64_t hash;
+
+    if (!lookup_filter) {
+        return;
+    }
+    if (!lookup_filter->misses_size) {
+        return;
+    }
+    if (!(field = __lookup_filter_field(lookup_filter, object, NULL, clause_list, &value))) {
+        return;
+    }
+    if (__lookup_filter_hash(value, &hash)) {
+        return;
+    }
+    if (__lookup_filter_miss_find(lookup_filter, field, value, hash)) {
+        return;
+    }
+
+    miss = &(lookup_filter->misses[lookup_filter->misses_next]);
+    lookup_filter->misses_next = (lookup_filter->misses_next + 1) % lookup_filter->misses_size;
+    __lookup_filter_miss_remove(lookup_filter, miss);
+
+    if (!(miss->value = libdbo_value_new_copy(value))) {
+        return;
+    }
+    miss->field = field;
+    miss->hash = hash;
+    bucket = &(lookup_filter->buckets[hash & (lookup_filter->buckets_size - 1)]);
+    miss->bucket_next = *bucket;
+    *bucket = miss;
+}
+
+void libdbo_lookup_filter_write(libdbo_lookup_filter_t* lookup_filter, const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set) {
+    libdbo_lookup_filter_field_t* field;
+    libdbo_lookup_filter_miss_t** miss;
+    const libdbo_object_field_t* object_field;
+    const libdbo_value_t* value;
+    libdbo_type_uint64_t hash;
+    size_t position;
+
+    if (!lookup_filter) {
+        return;
+    }
+    if (!object || !libdbo_object_table(object)) {
+        libdbo_lookup_filter_reset(lookup_filter);
+        return;
+    }
+
+    for (field = lookup_filter->field_list; field; field = field->next) {
+        if (strcmp(field->table, libdbo_object_table(object))) {
+            continue;
+        }
+
+        position = 0;
+        object_field = libdbo_object_field_list_begin(object_field_list);
+        while (object_field) {
+            if (libdbo_object_field_name(object_field)
+                && !strcmp(libdbo_object_field_name(object_field), field->field))
+            {
+                break;
+            }
+            position++;
+            object_field = libdbo_object_field_next(object_field);
+        }
+        if (!object_field) {
+            continue;
+        }
+
+        if (!(value = libdbo_value_set_at(value_set, position))) {
+            field->loaded = 0;
+            continue;
+        }
+        if (lookup_filter->misses_size
+            && !__lookup_filter_hash(value, &hash)
+            && (miss = __lookup_filter_miss_find(lookup_filter, field, value, hash)))
+        {
+            __lookup_filter_miss_remove(lookup_filter, *miss);
+        }
+        __lookup_filter_field_add(field, value);
+    }
+}
+
+unsigned long libdbo_lookup_filter_bloom_hits(const libdbo_lookup_filter_t* lookup_filter) {
+    if (!lookup_filter) {
+        return 0;
+    }
+
+    return lookup_filter->bloom_hits;
+}
+
+unsigned long libdbo_lookup_filter_negative_hits(const libdbo_lookup_filter_t* lookup_filter) {
+    if (!lookup_filter) {
+        return 0;
+    }
+
+    return lookup_filter->negative_hits;
+}
@@ -541,3 +541,29 @@ int libdbo_object_count(const libdbo_object_t* object, const libdbo_join_list_t*
 
     return libdbo_connection_count(object->connection, object, join_list, clause_list, count);
 }
+
+int libdbo_object_upsert(const libdbo_object_t* object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, const libdbo_clause_list_t* clause_list) {
+    if (!object) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!value_set) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!clause_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object->connection) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object->table) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object->primary_key_name) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (object_field_list) {
+        return libdbo_connection_upsert(object->connection, object, object_field_list, value_set, clause_list);
+    }
+    return libdbo_connection_upsert(object->connection, object, object->object_field_list, value_set, clause_list);
+}
@@ -268,6 +268,7 @@ int libdbo_result_list_copy(libdbo_result_list_t* result_list, const libdbo_resu
 
         result = result->next;
     }
+    result_list->error = from_result_list->error;
 
     return LIBDBO_OK;
 }
@@ -295,6 +296,36 @@ int libdbo_result_list_set_next(libdbo_result_list_t* result_list, libdbo_result
     return 0;
 }
 
+int libdbo_result_list_wrap_next(libdbo_result_list_t* result_list, libdbo_result_list_next_t next_function, void* next_data, libdbo_result_list_next_t* wrapped_function, void** wrapped_data) {
+    if (!result_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!result_list->next_function) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (result_list->current) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!next_function) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!next_data) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!wrapped_function) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!wrapped_data) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    *wrapped_function = result_list->next_function;
+    *wrapped_data = result_list->next_data;
+    result_list->next_function = next_function;
+    result_list->next_data = next_data;
+    return LIBDBO_OK;
+}
+
 int libdbo_result_list_add(libdbo_result_list_t* result_list, libdbo_result_t* result) {
     if (!result_list) {
         return LIBDBO_ERROR_UNKNOWN;
@@ -379,6 +410,23 @@ size_t libdbo_result_list_size(const libdbo_result_list_t* result_list) {
     return result_list->size;
 }
 
+int libdbo_result_list_set_error(libdbo_result_list_t* result_list, int error) {
+    if (!result_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    result_list->error = error;
+    return LIBDBO_OK;
+}
+
+int libdbo_result_list_error(const libdbo_result_list_t* result_list) {
+    if (!result_list) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    return result_list->error;
+}
+
 int libdbo_result_list_fetch_all(libdbo_result_list_t* result_list) {
     libdbo_result_t* result;
     libdbo_result_list_next_t next_function;
@@ -408,5 +456,5 @@ int libdbo_result_list_fetch_all(libdbo_result_list_t* result_list) {
         result_list->next_data = NULL;
     }
 
-    return LIBDBO_OK;
+    return result_list->error;
 }
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2014 Jerry Lundström <lundstrom.jerry@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "libdbo/retry.h"
+#include "libdbo/error.h"
+
+#include "libdbo/mm.h"
+
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+
+/**
+ * A database retry executor, `seed` is the state of the random numbers used
+ * for jitter and is protected by the lock together with the statistics.
+ */
+struct libdbo_retry {
+    unsigned int attempts;
+    unsigned int base_delay;
+    unsigned int max_delay;
+    pthread_mutex_t lock;
+    unsigned int seed;
+    libdbo_retry_stats_t stats;
+};
+
+static libdbo_mm_t __retry_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_retry_t));
+
+/**
+ * Get the delay before retry `retry_number`, starting at 1, in microseconds.
+ * This is full jitter, a random time between zero and the exponentially
+ * growing cap, so that conflicting writers spread out instead of retrying in
+ * lock step.
+ */
+static unsigned long long __retry_delay(libdbo_retry_t* retry, unsigned int retry_number) {
+    unsigned long long cap;
+    unsigned long long random;
+
+    if (!retry->base_delay) {
+        return 0;
+    }
+
+    cap = retry->base_delay;
+    while (--retry_number && cap < retry->max_delay) {
+        cap *= 2;
+    }
+    if (cap > retry->max_delay) {
+        cap = retry->max_delay;
+    }
+    cap *= 1000;
+
+    pthread_mutex_lock(&(retry->lock));
+    random = ((unsigned long long)rand_r(&(retry->seed)) << 31) ^ (unsigned long long)rand_r(&(retry->seed));
+    pthread_mutex_unlock(&(retry->lock));
+
+    return random % (cap + 1);
+}
+
+static void __retry_sleep(unsigned long long usec) {
+    struct timespec request;
+    struct timespec remaining;
+
+    request.tv_sec = usec / 1000000;
+    request.tv_nsec = (usec % 1000000) * 1000;
+    while (nanosleep(&request, &remaining) && errno == EINTR) {
+        request = remaining;
+    }
+}
+
+/* DB RETRY */
+
+libdbo_retry_t* libdbo_retry_new(unsigned int attempts, unsigned int base_delay, unsigned int max_delay) {
+    libdbo_retry_t* retry;
+
+    if (!attempts) {
+        return NULL;
+    }
+    if (max_delay < base_delay) {
+        return NULL;
+    }
+
+    if (!(retry = (libdbo_retry_t*)libdbo_mm_new0(&__retry_alloc))) {
+        return NULL;
+    }
+    if (pthread_mutex_init(&(retry->lock), NULL)) {
+        libdbo_mm_delete(&__retry_alloc, retry);
+        return NULL;
+    }
+    retry->attempts = attempts;
+    retry->base_delay = base_delay;
+    retry->max_delay = max_delay;
+    retry->seed = (unsigned int)time(NULL) ^ (unsigned int)(size_t)retry;
+
+    return retry;
+}
+
+void libdbo_retry_free(libdbo_retry_t* retry) {
+    if (retry) {
+        pthread_mutex_destroy(&(retry->lock));
+        libdbo_mm_delete(&__retry_alloc, retry);
+    }
+}
+
+int libdbo_retry_update(libdbo_retry_t* retry, void* object, const libdbo_value_t* id, libdbo_retry_fetch_t fetch, libdbo_retry_update_t update, void* user_data) {
+    libdbo_value_t primary_key = LIBDBO_VALUE_EMPTY;
+    libdbo_retry_stats_t stats = { 0, 0, 0, 0, 0, 0, 0 };
+    unsigned long long delay;
+    unsigned int attempt;
+    int ret;
+
+    if (!retry) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!object) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!id) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!fetch) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!update) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * The id may be part of the object which is replaced by the fetch.
+     */
+    if (libdbo_value_copy(&primary_key, id)) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    stats.calls = 1;
+    for (attempt = 0;; attempt++) {
+        if (attempt) {
+            stats.retries++;
+            delay = __retry_delay(retry, attempt);
+            if (delay) {
+                __retry_sleep(delay);
+                stats.sleep_usec += delay;
+            }
+            if ((ret = fetch(object, &primary_key))) {
+                break;
+            }
+        }
+
+        if ((ret = update(object, user_data, attempt)) != LIBDBO_ERROR_REVISION) {
+            break;
+        }
+        stats.conflicts++;
+
+        if (attempt + 1 >= retry->attempts) {
+            stats.exhausted = 1;
+            break;
+        }
+    }
+    libdbo_value_reset(&primary_key);
+
+    if (ret == LIBDBO_OK) {
+        stats.successes = 1;
+    }
+    else if (ret != LIBDBO_ERROR_REVISION) {
+        stats.failures = 1;
+    }
+
+    pthread_mutex_lock(&(retry->lock));
+    retry->stats.calls += stats.calls;
+    retry->stats.successes += stats.successes;
+    retry->stats.failures += stats.failures;
+    retry->stats.conflicts += stats.conflicts;
+    retry->stats.retries += stats.retries;
+    retry->stats.exhausted += stats.exhausted;
+    retry->stats.sleep_usec += stats.sleep_usec;
+    pthread_mutex_unlock(&(retry->lock));
+
+    return ret;
+}
+
+int libdbo_retry_stats(libdbo_retry_t* retry, libdbo_retry_stats_t* stats) {
+    if (!retry) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!stats) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (pthread_mutex_lock(&(retry->lock))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    *stats = retry->stats;
+    pthread_mutex_unlock(&(retry->lock));
+    return LIBDBO_OK;
+}
@@ -0,0 +1,821 @@
+/*
+ * Copyright (c) 2014 Jerry Lundström <lundstrom.jerry@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "libdbo/stats.h"
+#include "libdbo/error.h"
+
+#include "libdbo/mm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+/**
+ * The counters of an operation on a table. Entries are never removed, a
+ * reset only zeroes the counters, so result lists being walked can keep a
+ * pointer to them.
+ */
+typedef struct libdbo_stats_entry libdbo_stats_entry_t;
+struct libdbo_stats_entry {
+    libdbo_stats_entry_t* next;
+    char* table;
+    libdbo_stats_operation_t operation;
+    libdbo_stats_counters_t counters;
+};
+
+/**
+ * The number of reads and counts with a clause shape on a table. Like the
+ * entries they are never removed.
+ */
+typedef struct libdbo_stats_shape libdbo_stats_shape_t;
+struct libdbo_stats_shape {
+    libdbo_stats_shape_t* next;
+    char* table;
+    char* shape;
+    unsigned long calls;
+    unsigned long long rows;
+};
+
+/**
+ * Database statistics, `operations` holds the counters of each operation
+ * over all tables. Result lists being walked keep pointers to the counters so
+ * the statistics are only deleted when the last of the `walks` is finished if
+ * libdbo_stats_free() is called before that.
+ */
+struct libdbo_stats {
+    pthread_mutex_t lock;
+    libdbo_stats_counters_t* operations;
+    libdbo_stats_entry_t* entries;
+    libdbo_stats_shape_t* shapes;
+    unsigned int walks;
+    int freed;
+};
+
+static libdbo_mm_t __stats_alloc = LIBDBO_MM_T_STATIC_NEW(sizeof(libdbo_stats_t));
+
+/**
+ * The state of walking a result list that fetches the results from the
+ * backend, the rows and text are added to the counters when it is finished.
+ */
+typedef struct libdbo_stats_walk {
+    libdbo_stats_t* stats;
+    libdbo_stats_counters_t* operation;
+    libdbo_stats_counters_t* table;
+    unsigned long long* shape_rows;
+    libdbo_result_list_next_t next_function;
+    void* next_data;
+    unsigned long long rows;
+    unsigned long long text_bytes;
+} libdbo_stats_walk_t;
+
+static const char* __stats_operation_names[LIBDBO_STATS_OPERATIONS] = {
+    "create",
+    "read",
+    "update",
+    "delete",
+    "count",
+    "upsert",
+    "read_batch",
+    "transaction_begin",
+    "transaction_commit",
+    "transaction_rollback"
+};
+
+static size_t __stats_histogram_bucket(unsigned long long usec) {
+    unsigned int msb = 0;
+    unsigned int shift;
+
+    if (usec < LIBDBO_STATS_HISTOGRAM_SUB_BUCKETS) {
+        return (size_t)usec;
+    }
+
+    while (usec >> (msb + 1)) {
+        msb++;
+    }
+    shift = msb - 4;
+    if ((size_t)shift * LIBDBO_STATS_HISTOGRAM_SUB_BUCKETS + LIBDBO_STATS_HISTOGRAM_SUB_BUCKETS * 2 > LIBDBO_STATS_HISTOGRAM_BUCKETS) {
+        return LIBDBO_STATS_HISTOGRAM_BUCKETS - 1;
+    }
+    return (size_t)shift * LIBDBO_STATS_HISTOGRAM_SUB_BUCKETS + (size_t)(usec >> shift);
+}
+
+static unsigned long long __stats_histogram_highest(size_t bucket) {
+    unsigned int shift;
+    unsigned long long sub_bucket;
+
+    if (bucket < LIBDBO_STATS_HISTOGRAM_SUB_BUCKETS * 2) {
+        return bucket;
+    }
+
+    shift = bucket / LIBDBO_STATS_HISTOGRAM_SUB_BUCKETS - 1;
+    sub_bucket = bucket % LIBDBO_STATS_HISTOGRAM_SUB_BUCKETS + LIBDBO_STATS_HISTOGRAM_SUB_BUCKETS;
+    return ((sub_bucket + 1) << shift) - 1;
+}
+
+static void __stats_counters_add(libdbo_stats_counters_t* counters, unsigned long long usec, int error) {
+    counters->calls++;
+    if (error) {
+        counters->errors++;
+    }
+    counters->total_usec += usec;
+    if (usec > counters->max_usec) {
+        counters->max_usec = usec;
+    }
+    counters->latency.buckets[__stats_histogram_bucket(usec)]++;
+}
+
+/**
+ * Get the entry of the operation on the table, creating it if needed. Must
+ * be called with the lock held.
+ */
+static libdbo_stats_entry_t* __stats_entry(libdbo_stats_t* stats, libdbo_stats_operation_t operation, const char* table, int create) {
+    libdbo_stats_entry_t* entry;
+
+    for (entry = stats->entries; entry; entry = entry->next) {
+        if (entry->operation == operation && !strcmp(entry->table, table)) {
+            return entry;
+        }
+    }
+    if (!create) {
+        return NULL;
+    }
+
+    if (!(entry = calloc(1, sizeof(libdbo_stats_entry_t)))) {
+        return NULL;
+    }
+    if (!(entry->table = strdup(table))) {
+        free(entry);
+        return NULL;
+    }
+    entry->operation = operation;
+    entry->next = stats->entries;
+    stats->entries = entry;
+    return entry;
+}
+
+/**
+ * A field of a clause shape, `kind` is `=` for equality and `<` for a range.
+ */
+typedef struct libdbo_stats_shape_field {
+    const char* field;
+    char kind;
+} libdbo_stats_shape_field_t;
+
+static size_t __stats_shape_clauses(const libdbo_clause_list_t* clause_list) {
+    const libdbo_clause_t* clause;
+    size_t clauses = 0;
+
+    for (clause = libdbo_clause_list_begin(clause_list); clause; clause = libdbo_clause_next(clause)) {
+        if (libdbo_clause_type(clause) == LIBDBO_CLAUSE_NESTED) {
+            clauses += __stats_shape_clauses(libdbo_clause_list(clause));
+        }
+        else {
+            clauses++;
+        }
+    }
+    return clauses;
+}
+
+/**
+ * Collect the fields of the table that an index can be used for, clauses on
+ * other tables and lists joined with OR are left out.
+ */
+static void __stats_shape_collect(const char* table, const libdbo_clause_list_t* clause_list, libdbo_stats_shape_field_t* fields, size_t* size) {
+    const libdbo_clause_t* clause;
+
+    for (clause = libdbo_clause_list_begin(clause_list); clause; clause = libdbo_clause_next(clause)) {
+        if (clause != libdbo_clause_list_begin(clause_list)
+            && libdbo_clause_operator(clause) == LIBDBO_CLAUSE_OPERATOR_OR)
+        {
+            return;
+        }
+    }
+
+    for (clause = libdbo_clause_list_begin(clause_list); clause; clause = libdbo_clause_next(clause)) {
+        if (libdbo_clause_type(clause) == LIBDBO_CLAUSE_NESTED) {
+            __stats_shape_collect(table, libdbo_clause_list(clause), fields, size);
+            continue;
+        }
+        if (!libdbo_clause_field(clause)
+            || (libdbo_clause_table(clause) && strcmp(libdbo_clause_table(clause), table)))
+        {
+            continue;
+        }
+
+        switch (libdbo_clause_type(clause)) {
+        case LIBDBO_CLAUSE_EQUAL:
+        case LIBDBO_CLAUSE_IS_NULL:
+            fields[*size].kind = '=';
+            break;
+
+        case LIBDBO_CLAUSE_LESS_THEN:
+        case LIBDBO_CLAUSE_LESS_OR_EQUAL:
+        case LIBDBO_CLAUSE_GREATER_OR_EQUAL:
+        case LIBDBO_CLAUSE_GREATER_THEN:
+            fields[*size].kind = '<';
+            break;
+
+        default:
+            continue;
+        }
+        fields[*size].field = libdbo_clause_field(clause);
+        (*size)++;
+    }
+}
+
+static int __stats_shape_compare(const void* a, const void* b) {
+    const libdbo_stats_shape_field_t* field_a = (const libdbo_stats_shape_field_t*)a;
+    const libdbo_stats_shape_field_t* field_b = (const libdbo_stats_shape_field_t*)b;
+
+    if (field_a->kind != field_b->kind) {
+        return field_a->kind == '=' ? -1 : 1;
+    }
+    return strcmp(field_a->field, field_b->field);
+}
+
+/**
+ * Get the clause shape of a clause list, the fields compared for equality
+ * followed by the fields compared by range, each sorted by name. Returns NULL
+ * if there is no field an index can be used for or on error.
+ */
+static char* __stats_shape(const char* table, const libdbo_clause_list_t* clause_list) {
+    libdbo_stats_shape_field_t* fields;
+    size_t clauses, size = 0, length = 0, i, j;
+    char* shape;
+    char* p;
+
+    if (!table || !clause_list || !(clauses = __stats_shape_clauses(clause_list))) {
+        return NULL;
+    }
+    if (!(fields = calloc(clauses, sizeof(libdbo_stats_shape_field_t)))) {
+        return NULL;
+    }
+    __stats_shape_collect(table, clause_list, fields, &size);
+    if (!size) {
+        free(fields);
+        return NULL;
+    }
+
+    /*
+     * Remove the same field compared more then once and the range of a
+     * field that is also compared for equality.
+     */
+    qsort(fields, size, sizeof(libdbo_stats_shape_field_t), __stats_shape_compare);
+    for (i = 0; i < size; i++) {
+        for (j = 0; j < i; j++) {
+            if (fields[j].field && !strcmp(fields[j].field, fields[i].field)) {
+                fields[i].field = NULL;
+                break;
+            }
+        }
+        if (fields[i].field) {
+            length += strlen(fields[i].field) + 2;
+        }
+    }
+
+    if (!(shape = malloc(length))) {
+        free(fields);
+        return NULL;
+    }
+    p = shape;
+    for (i = 0; i < size; i++) {
+        if (!fields[i].field) {
+            continue;
+        }
+        if (p != shape) {
+            *p++ = ',';
+        }
+        strcpy(p, fields[i].field);
+        p += strlen(fields[i].field);
+        *p++ = fields[i].kind;
+    }
+    *p = 0;
+    free(fields);
+    return shape;
+}
+
+/**
+ * Get the counters of the clause shape on the table, creating them if
+ * needed. Must be called with the lock held.
+ */
+static libdbo_stats_shape_t* __stats_shape_entry(libdbo_stats_t* stats, const char* table, const char* shape) {
+    libdbo_stats_shape_t* entry;
+
+    for (entry = stats->shapes; entry; entry = entry->next) {
+        if (!strcmp(entry->shape, shape) && !strcmp(entry->table, table)) {
+            return entry;
+        }
+    }
+
+    if (!(entry = calloc(1, sizeof(libdbo_stats_shape_t)))) {
+        return NULL;
+    }
+    if (!(entry->table = strdup(table))) {
+        free(entry);
+        return NULL;
+    }
+    if (!(entry->shape = strdup(shape))) {
+        free(entry->table);
+        free(entry);
+        return NULL;
+    }
+    entry->next = stats->shapes;
+    stats->shapes = entry;
+    return entry;
+}
+
+static size_t __stats_text_bytes(const libdbo_result_t* result) {
+    const libdbo_value_set_t* value_set;
+    const libdbo_value_t* value;
+    size_t i, text_bytes = 0;
+
+    if (!(value_set = libdbo_result_value_set(result))) {
+        return 0;
+    }
+    for (i = 0; i < libdbo_value_set_size(value_set); i++) {
+        if ((value = libdbo_value_set_at(value_set, i))
+            && libdbo_value_type(value) == LIBDBO_TYPE_TEXT
+            && libdbo_value_text(value))
+        {
+            text_bytes += strlen(libdbo_value_text(value));
+        }
+    }
+    return text_bytes;
+}
+
+/**
+ * Delete database statistics now, no result list may be walked with them.
+ * \param[in] stats a libdbo_stats_t pointer.
+ */
+static void __stats_delete(libdbo_stats_t* stats) {
+    libdbo_stats_entry_t* entry;
+    libdbo_stats_shape_t* shape;
+
+    while ((entry = stats->entries)) {
+        stats->entries = entry->next;
+        free(entry->table);
+        free(entry);
+    }
+    while ((shape = stats->shapes)) {
+        stats->shapes = shape->next;
+        free(shape->table);
+        free(shape->shape);
+        free(shape);
+    }
+    free(stats->operations);
+    pthread_mutex_destroy(&(stats->lock));
+    libdbo_mm_delete(&__stats_alloc, stats);
+}
+
+static libdbo_result_t* __stats_walk_next(void* data, int finish) {
+    libdbo_stats_walk_t* walk = (libdbo_stats_walk_t*)data;
+    libdbo_result_t* result;
+    int last;
+
+    if (finish) {
+        result = walk->next_function(walk->next_data, 1);
+
+        pthread_mutex_lock(&(walk->stats->lock));
+        walk->operation->rows += walk->rows;
+        walk->operation->text_bytes += walk->text_bytes;
+        if (walk->table) {
+            walk->table->rows += walk->rows;
+            walk->table->text_bytes += walk->text_bytes;
+        }
+        if (walk->shape_rows) {
+            *(walk->shape_rows) += walk->rows;
+        }
+        walk->stats->walks--;
+        last = walk->stats->freed && !walk->stats->walks;
+        pthread_mutex_unlock(&(walk->stats->lock));
+
+        if (last) {
+            __stats_delete(walk->stats);
+        }
+        free(walk);
+        return result;
+    }
+
+    if ((result = walk->next_function(walk->next_data, 0))) {
+        walk->rows++;
+        walk->text_bytes += __stats_text_bytes(result);
+    }
+    return result;
+}
+
+/* DB STATS */
+
+libdbo_stats_t* libdbo_stats_new(void) {
+    libdbo_stats_t* stats;
+
+    if (!(stats = (libdbo_stats_t*)libdbo_mm_new0(&__stats_alloc))) {
+        return NULL;
+    }
+    if (!(stats->operations = calloc(LIBDBO_STATS_OPERATIONS, sizeof(libdbo_stats_counters_t)))) {
+        libdbo_mm_delete(&__stats_alloc, stats);
+        return NULL;
+    }
+    if (pthread_mutex_init(&(stats->lock), NULL)) {
+        free(stats->operations);
+        libdbo_mm_delete(&__stats_alloc, stats);
+        return NULL;
+    }
+
+    return stats;
+}
+
+void libdbo_stats_free(libdbo_stats_t* stats) {
+    int walks;
+
+    if (stats) {
+        pthread_mutex_lock(&(stats->lock));
+        stats->freed = 1;
+        walks = stats->walks;
+        pthread_mutex_unlock(&(stats->lock));
+
+        if (!walks) {
+            __stats_delete(stats);
+        }
+    }
+}
+
+void libdbo_stats_reset(libdbo_stats_t* stats) {
+    libdbo_stats_entry_t* entry;
+    libdbo_stats_shape_t* shape;
+
+    if (!stats) {
+        return;
+    }
+
+    pthread_mutex_lock(&(stats->lock));
+    memset(stats->operations, 0, LIBDBO_STATS_OPERATIONS * sizeof(libdbo_stats_counters_t));
+    for (entry = stats->entries; entry; entry = entry->next) {
+        memset(&(entry->counters), 0, sizeof(libdbo_stats_counters_t));
+    }
+    for (shape = stats->shapes; shape; shape = shape->next) {
+        shape->calls = 0;
+        shape->rows = 0;
+    }
+    pthread_mutex_unlock(&(stats->lock));
+}
+
+int libdbo_stats_record(libdbo_stats_t* stats, libdbo_stats_operation_t operation, const char* table, unsigned long long usec, int error) {
+    libdbo_stats_entry_t* entry = NULL;
+
+    if (!stats) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if ((unsigned int)operation >= LIBDBO_STATS_OPERATIONS) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (pthread_mutex_lock(&(stats->lock))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    __stats_counters_add(&(stats->operations[operation]), usec, error);
+    if (table && (entry = __stats_entry(stats, operation, table, 1))) {
+        __stats_counters_add(&(entry->counters), usec, error);
+    }
+    pthread_mutex_unlock(&(stats->lock));
+
+    if (table && !entry) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    return LIBDBO_OK;
+}
+
+/**
+ * Record a call of an operation that returned a result list and, if `shape`
+ * is not NULL, a read with that clause shape.
+ */
+static int __stats_record_result_list(libdbo_stats_t* stats, libdbo_stats_operation_t operation, const char* table, const char* shape, unsigned long long usec, libdbo_result_list_t* result_list) {
+    libdbo_stats_entry_t* entry = NULL;
+    libdbo_stats_shape_t* shape_entry = NULL;
+    libdbo_stats_walk_t* walk;
+    const libdbo_result_t* result;
+    unsigned long long rows = 0;
+    unsigned long long text_bytes = 0;
+
+    if (!stats) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if ((unsigned int)operation >= LIBDBO_STATS_OPERATIONS) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    /*
+     * A result list with the results fetched is walked now, otherwise the
+     * walking is wrapped and counted as the results are fetched.
+     */
+    walk = NULL;
+    if (result_list) {
+        if (result_list->next_function) {
+            if (!(walk = calloc(1, sizeof(libdbo_stats_walk_t)))) {
+                return LIBDBO_ERROR_UNKNOWN;
+            }
+        }
+        else {
+            for (result = result_list->begin; result; result = result->next) {
+                rows++;
+                text_bytes += __stats_text_bytes(result);
+            }
+        }
+    }
+
+    if (pthread_mutex_lock(&(stats->lock))) {
+        free(walk);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    __stats_counters_add(&(stats->operations[operation]), usec, !result_list);
+    stats->operations[operation].rows += rows;
+    stats->operations[operation].text_bytes += text_bytes;
+    if (table && (entry = __stats_entry(stats, operation, table, 1))) {
+        __stats_counters_add(&(entry->counters), usec, !result_list);
+        entry->counters.rows += rows;
+        entry->counters.text_bytes += text_bytes;
+    }
+    if (table && shape && result_list && (shape_entry = __stats_shape_entry(stats, table, shape))) {
+        shape_entry->calls++;
+        shape_entry->rows += rows;
+    }
+    if (walk) {
+        stats->walks++;
+    }
+    pthread_mutex_unlock(&(stats->lock));
+
+    if (walk) {
+        walk->stats = stats;
+        walk->operation = &(stats->operations[operation]);
+        walk->table = entry ? &(entry->counters) : NULL;
+        walk->shape_rows = shape_entry ? &(shape_entry->rows) : NULL;
+        if (libdbo_result_list_wrap_next(result_list, __stats_walk_next, walk, &(walk->next_function), &(walk->next_data))) {
+            pthread_mutex_lock(&(stats->lock));
+            stats->walks--;
+            pthread_mutex_unlock(&(stats->lock));
+            free(walk);
+            return LIBDBO_ERROR_UNKNOWN;
+        }
+    }
+
+    if (table && !entry) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (table && shape && result_list && !shape_entry) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    return LIBDBO_OK;
+}
+
+int libdbo_stats_record_result_list(libdbo_stats_t* stats, libdbo_stats_operation_t operation, const char* table, unsigned long long usec, libdbo_result_list_t* result_list) {
+    return __stats_record_result_list(stats, operation, table, NULL, usec, result_list);
+}
+
+int libdbo_stats_record_read(libdbo_stats_t* stats, const char* table, const libdbo_clause_list_t* clause_list, unsigned long long usec, libdbo_result_list_t* result_list) {
+    char* shape;
+    int ret;
+
+    if (!stats) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    shape = __stats_shape(table, clause_list);
+    ret = __stats_record_result_list(stats, LIBDBO_STATS_READ, table, shape, usec, result_list);
+    free(shape);
+    return ret;
+}
+
+int libdbo_stats_record_count(libdbo_stats_t* stats, const char* table, const libdbo_clause_list_t* clause_list, unsigned long long usec, int error, size_t count) {
+    libdbo_stats_shape_t* shape_entry;
+    char* shape;
+    int ret;
+
+    if (!stats) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if ((ret = libdbo_stats_record(stats, LIBDBO_STATS_COUNT, table, usec, error))) {
+        return ret;
+    }
+    if (error || !(shape = __stats_shape(table, clause_list))) {
+        return LIBDBO_OK;
+    }
+
+    if (pthread_mutex_lock(&(stats->lock))) {
+        free(shape);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if ((shape_entry = __stats_shape_entry(stats, table, shape))) {
+        shape_entry->calls++;
+        shape_entry->rows += count;
+    }
+    pthread_mutex_unlock(&(stats->lock));
+    free(shape);
+
+    if (!shape_entry) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    return LIBDBO_OK;
+}
+
+int libdbo_stats_operation(libdbo_stats_t* stats, libdbo_stats_operation_t operation, libdbo_stats_counters_t* counters) {
+    if (!stats) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if ((unsigned int)operation >= LIBDBO_STATS_OPERATIONS) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!counters) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (pthread_mutex_lock(&(stats->lock))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    *counters = stats->operations[operation];
+    pthread_mutex_unlock(&(stats->lock));
+    return LIBDBO_OK;
+}
+
+int libdbo_stats_table(libdbo_stats_t* stats, const char* table, libdbo_stats_operation_t operation, libdbo_stats_counters_t* counters) {
+    libdbo_stats_entry_t* entry;
+
+    if (!stats) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!table) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if ((unsigned int)operation >= LIBDBO_STATS_OPERATIONS) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!counters) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (pthread_mutex_lock(&(stats->lock))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if ((entry = __stats_entry(stats, operation, table, 0))) {
+        *counters = entry->counters;
+    }
+    else {
+        memset(counters, 0, sizeof(libdbo_stats_counters_t));
+    }
+    pthread_mutex_unlock(&(stats->lock));
+    return LIBDBO_OK;
+}
+
+int libdbo_stats_foreach(libdbo_stats_t* stats, libdbo_stats_foreach_t function, void* user_data) {
+    libdbo_stats_entry_t* entry;
+
+    if (!stats) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!function) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (pthread_mutex_lock(&(stats->lock))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    for (entry = stats->entries; entry; entry = entry->next) {
+        function(entry->table, entry->operation, &(entry->counters), user_data);
+    }
+    pthread_mutex_unlock(&(stats->lock));
+    return LIBDBO_OK;
+}
+
+int libdbo_stats_shape_foreach(libdbo_stats_t* stats, libdbo_stats_shape_foreach_t function, void* user_data) {
+    libdbo_stats_shape_t* shape;
+
+    if (!stats) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!function) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (pthread_mutex_lock(&(stats->lock))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    for (shape = stats->shapes; shape; shape = shape->next) {
+        if (shape->calls) {
+            function(shape->table, shape->shape, shape->calls, shape->rows, user_data);
+        }
+    }
+    pthread_mutex_unlock(&(stats->lock));
+    return LIBDBO_OK;
+}
+
+int libdbo_stats_write_shapes(libdbo_stats_t* stats, const char* path) {
+    libdbo_stats_shape_t* shape;
+    FILE* file;
+    int ret = LIBDBO_OK;
+
+    if (!stats) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (!path) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+
+    if (!(file = fopen(path, "a"))) {
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    if (pthread_mutex_lock(&(stats->lock))) {
+        fclose(file);
+        return LIBDBO_ERROR_UNKNOWN;
+    }
+    for (shape = stats->shapes; shape; shape = shape->next) {
+        if (shape->calls
+            && fprintf(file, "%s\t%s\t%lu\t%llu\n", shape->table, shape->shape, shape->calls, shape->rows) < 0)
+        {
+            ret = LIBDBO_ERROR_UNKNOWN;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&(stats->lock));
+    if (fclose(file)) {
+        ret = LIBDBO_ERROR_UNKNOWN;
+    }
+    return ret;
+}
+
+const char* libdbo_stats_operation_name(libdbo_stats_operation_t operation) {
+    if ((unsigned int)operation >= LIBDBO_STATS_OPERATIONS) {
+        return NULL;
+    }
+
+    return __stats_operation_names[operation];
+}
+
+unsigned long libdbo_stats_histogram_count(const libdbo_stats_histogram_t* histogram) {
+    unsigned long count = 0;
+    size_t i;
+
+    if (!histogram) {
+        return 0;
+    }
+
+    for (i = 0; i < LIBDBO_STATS_HISTOGRAM_BUCKETS; i++) {
+        count += histogram->buckets[i];
+    }
+    return count;
+}
+
+unsigned long long libdbo_stats_histogram_percentile(const libdbo_stats_histogram_t* histogram, double percentile) {
+    unsigned long count, target, seen = 0;
+    size_t i;
+
+    if (!histogram) {
+        return 0;
+    }
+    if (!(count = libdbo_stats_histogram_count(histogram))) {
+        return 0;
+    }
+
+    if (percentile <= 0) {
+        target = 1;
+    }
+    else if (percentile >= 100) {
+        target = count;
+    }
+    else {
+        target = (unsigned long)(percentile / 100 * count + 0.5);
+        if (!target) {
+            target = 1;
+        }
+    }
+
+    for (i = 0; i < LIBDBO_STATS_HISTOGRAM_BUCKETS; i++) {
+        if ((seen += histogram->buckets[i]) >= target) {
+            return __stats_histogram_highest(i);
+        }
+    }
+    return __stats_histogram_highest(LIBDBO_STATS_HISTOGRAM_BUCKETS - 1);
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2014 Jerry Lundström <lundstrom.jerry@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "libdbo/trace.h"
+#include "libdbo/error.h"
+
+#include <stdlib.h>
+
+libdbo_trace_hook_t __libdbo_trace_hook = NULL;
+static void* __trace_user_data = NULL;
+
+/* DB TRACE */
+
+void libdbo_trace_set_hook(libdbo_trace_hook_t hook, void* user_data) {
+    __trace_user_data = user_data;
+    __libdbo_trace_hook = hook;
+}
+
+int libdbo_trace_begin(libdbo_trace_event_t* event) {
+    if (!event) {
+        return 0;
+    }
+    if (!(event->hook = __libdbo_trace_hook)) {
+        return 0;
+    }
+
+    event->user_data = __trace_user_data;
+    event->rows = 0;
+    event->status = LIBDBO_OK;
+    event->hook_data = NULL;
+    event->hook(LIBDBO_TRACE_BEGIN, event, event->user_data);
+    return 1;
+}
+
+void libdbo_trace_end(libdbo_trace_event_t* event, unsigned long long rows, int status) {
+    if (!event) {
+        return;
+    }
+    if (!event->hook) {
+        return;
+    }
+
+    event->rows = rows;
+    event->status = status;
+    event->hook(LIBDBO_TRACE_END, event, event->user_data);
+}
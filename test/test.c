@@ -177,6 +177,46 @@ int main(void) {
         return CU_get_error();
     }
 #endif
+#if defined(TEST_POSTGRESQL)
+    pSuite = CU_add_suite("Initialization PostgreSQL", init_suite_initialization, clean_suite_initialization);
+    if (!pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    if (!CU_add_test(pSuite, "test of configuration", test_initialization_configuration_postgresql)
+        || !CU_add_test(pSuite, "test of connection", test_initialization_connection))
+    {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+#endif
+    pSuite = CU_add_suite("Initialization Memory", init_suite_initialization, clean_suite_initialization);
+    if (!pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    if (!CU_add_test(pSuite, "test of configuration", test_initialization_configuration_memory)
+        || !CU_add_test(pSuite, "test of connection", test_initialization_connection))
+    {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+#if defined(HAVE_LMDB)
+    pSuite = CU_add_suite("Initialization LMDB", init_suite_initialization, clean_suite_initialization);
+    if (!pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    if (!CU_add_test(pSuite, "test of configuration", test_initialization_configuration_lmdb)
+        || !CU_add_test(pSuite, "test of connection", test_initialization_connection))
+    {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+#endif
 
 #if defined(HAVE_SQLITE3)
     pSuite = CU_add_suite("SQLite database operations", init_suite_database_operations_sqlite, clean_suite_database_operations);
@@ -193,6 +233,9 @@ int main(void) {
         || !CU_add_test(pSuite, "test of update object 2", test_database_operations_update_object2)
         || !CU_add_test(pSuite, "test of read all", test_database_operations_read_all)
         || !CU_add_test(pSuite, "test of count", test_database_operations_count)
+        || !CU_add_test(pSuite, "test of read batch", test_database_operations_read_batch)
+        || !CU_add_test(pSuite, "test of count with large clause list", test_database_operations_count_large_clause)
+        || !CU_add_test(pSuite, "test of clause operators and nesting", test_database_operations_clause_operators)
         || !CU_add_test(pSuite, "test of delete object 3", test_database_operations_delete_object3)
         || !CU_add_test(pSuite, "test of read object 1 (#3)", test_database_operations_read_object1)
         || !CU_add_test(pSuite, "test of delete object 2", test_database_operations_delete_object2)
@@ -205,12 +248,21 @@ int main(void) {
         || !CU_add_test(pSuite, "test of create object 3 (REV)", test_database_operations_create_object3_2)
         || !CU_add_test(pSuite, "test of update object 2 (REV)", test_database_operations_update_object2_2)
         || !CU_add_test(pSuite, "test of updates revisions (REV)", test_database_operations_update_objects_revisions)
+        || !CU_add_test(pSuite, "test of update retry (REV)", test_database_operations_update_retry)
+        || !CU_add_test(pSuite, "test of stats (REV)", test_database_operations_stats)
+        || !CU_add_test(pSuite, "test of trace (REV)", test_database_operations_trace)
         || !CU_add_test(pSuite, "test of delete object 3 (REV)", test_database_operations_delete_object3_2)
         || !CU_add_test(pSuite, "test of read object 1 (#3) (REV)", test_database_operations_read_object1_2)
         || !CU_add_test(pSuite, "test of delete object 2 (REV)", test_database_operations_delete_object2_2)
         || !CU_add_test(pSuite, "test of read object 1 (#4) (REV)", test_database_operations_read_object1_2)
 
-        || !CU_add_test(pSuite, "test of associated fetch", test_database_operations_associated_fetch))
+        || !CU_add_test(pSuite, "test of associated fetch", test_database_operations_associated_fetch)
+        || !CU_add_test(pSuite, "test of upsert", test_database_operations_upsert)
+        || !CU_add_test(pSuite, "test of nested transactions", test_database_operations_nested_transactions)
+        || !CU_add_test(pSuite, "test of connection pool", test_database_operations_connection_pool)
+        || !CU_add_test(pSuite, "test of async", test_database_operations_async)
+        || !CU_add_test(pSuite, "test of async group commit", test_database_operations_async_group_commit)
+        || !CU_add_test(pSuite, "test of slow query log", test_database_operations_slow_query))
     {
         CU_cleanup_registry();
         return CU_get_error();
@@ -231,6 +283,8 @@ int main(void) {
         || !CU_add_test(pSuite, "test of create object 3", test_database_operations_create_object3)
         || !CU_add_test(pSuite, "test of update object 2", test_database_operations_update_object2)
         || !CU_add_test(pSuite, "test of read all", test_database_operations_read_all)
+        || !CU_add_test(pSuite, "test of count", test_database_operations_count)
+        || !CU_add_test(pSuite, "test of read batch", test_database_operations_read_batch)
         || !CU_add_test(pSuite, "test of delete object 3", test_database_operations_delete_object3)
         || !CU_add_test(pSuite, "test of read object 1 (#3)", test_database_operations_read_object1)
         || !CU_add_test(pSuite, "test of delete object 2", test_database_operations_delete_object2)
@@ -243,6 +297,9 @@ int main(void) {
         || !CU_add_test(pSuite, "test of create object 3 (REV)", test_database_operations_create_object3_2)
         || !CU_add_test(pSuite, "test of update object 2 (REV)", test_database_operations_update_object2_2)
         || !CU_add_test(pSuite, "test of updates revisions (REV)", test_database_operations_update_objects_revisions)
+        || !CU_add_test(pSuite, "test of update retry (REV)", test_database_operations_update_retry)
+        || !CU_add_test(pSuite, "test of stats (REV)", test_database_operations_stats)
+        || !CU_add_test(pSuite, "test of trace (REV)", test_database_operations_trace)
         || !CU_add_test(pSuite, "test of delete object 3 (REV)", test_database_operations_delete_object3_2)
         || !CU_add_test(pSuite, "test of read object 1 (#3) (REV)", test_database_operations_read_object1_2)
         || !CU_add_test(pSuite, "test of delete object 2 (REV)", test_database_operations_delete_object2_2)
@@ -253,6 +310,20 @@ int main(void) {
         CU_cleanup_registry();
         return CU_get_error();
     }
+
+    pSuite = CU_add_suite("CouchDB streaming", init_suite_database_operations_couchdb_stream, clean_suite_database_operations_couchdb_stream);
+    if (!pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    if (!CU_add_test(pSuite, "test of streamed reads", test_database_operations_couchdb_stream)
+        || !CU_add_test(pSuite, "test of streamed reads after disconnect", test_database_operations_couchdb_stream_disconnect)
+        || !CU_add_test(pSuite, "test of paused streamed reads", test_database_operations_couchdb_stream_pause))
+    {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
 #endif
 
 #if defined(TEST_MYSQL)
@@ -269,6 +340,9 @@ int main(void) {
         || !CU_add_test(pSuite, "test of create object 3", test_database_operations_create_object3)
         || !CU_add_test(pSuite, "test of update object 2", test_database_operations_update_object2)
         || !CU_add_test(pSuite, "test of read all", test_database_operations_read_all)
+        || !CU_add_test(pSuite, "test of count with large clause list", test_database_operations_count_large_clause)
+        || !CU_add_test(pSuite, "test of clause operators and nesting", test_database_operations_clause_operators)
+        || !CU_add_test(pSuite, "test of read batch", test_database_operations_read_batch)
         || !CU_add_test(pSuite, "test of delete object 3", test_database_operations_delete_object3)
         || !CU_add_test(pSuite, "test of read object 1 (#3)", test_database_operations_read_object1)
         || !CU_add_test(pSuite, "test of delete object 2", test_database_operations_delete_object2)
@@ -281,12 +355,291 @@ int main(void) {
         || !CU_add_test(pSuite, "test of create object 3 (REV)", test_database_operations_create_object3_2)
         || !CU_add_test(pSuite, "test of update object 2 (REV)", test_database_operations_update_object2_2)
         || !CU_add_test(pSuite, "test of updates revisions (REV)", test_database_operations_update_objects_revisions)
+        || !CU_add_test(pSuite, "test of update retry (REV)", test_database_operations_update_retry)
+        || !CU_add_test(pSuite, "test of stats (REV)", test_database_operations_stats)
+        || !CU_add_test(pSuite, "test of trace (REV)", test_database_operations_trace)
         || !CU_add_test(pSuite, "test of delete object 3 (REV)", test_database_operations_delete_object3_2)
         || !CU_add_test(pSuite, "test of read object 1 (#3) (REV)", test_database_operations_read_object1_2)
         || !CU_add_test(pSuite, "test of delete object 2 (REV)", test_database_operations_delete_object2_2)
         || !CU_add_test(pSuite, "test of read object 1 (#4) (REV)", test_database_operations_read_object1_2)
 
-        || !CU_add_test(pSuite, "test of associated fetch", test_database_operations_associated_fetch))
+        || !CU_add_test(pSuite, "test of associated fetch", test_database_operations_associated_fetch)
+        || !CU_add_test(pSuite, "test of upsert", test_database_operations_upsert)
+        || !CU_add_test(pSuite, "test of nested transactions", test_database_operations_nested_transactions)
+        || !CU_add_test(pSuite, "test of connection pool", test_database_operations_connection_pool)
+        || !CU_add_test(pSuite, "test of async", test_database_operations_async)
+        || !CU_add_test(pSuite, "test of async group commit", test_database_operations_async_group_commit))
+    {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+#endif
+
+#if defined(TEST_POSTGRESQL)
+    pSuite = CU_add_suite("PostgreSQL database operations", init_suite_database_operations_postgresql, clean_suite_database_operations);
+    if (!pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    if (!CU_add_test(pSuite, "test of read object 1", test_database_operations_read_object1)
+        || !CU_add_test(pSuite, "test of create object 2", test_database_operations_create_object2)
+        || !CU_add_test(pSuite, "test of read object 2", test_database_operations_read_object2)
+        || !CU_add_test(pSuite, "test of read object 1 (#2)", test_database_operations_read_object1)
+        || !CU_add_test(pSuite, "test of create object 3", test_database_operations_create_object3)
+        || !CU_add_test(pSuite, "test of update object 2", test_database_operations_update_object2)
+        || !CU_add_test(pSuite, "test of read all", test_database_operations_read_all)
+        || !CU_add_test(pSuite, "test of count with large clause list", test_database_operations_count_large_clause)
+        || !CU_add_test(pSuite, "test of clause operators and nesting", test_database_operations_clause_operators)
+        || !CU_add_test(pSuite, "test of read batch", test_database_operations_read_batch)
+        || !CU_add_test(pSuite, "test of delete object 3", test_database_operations_delete_object3)
+        || !CU_add_test(pSuite, "test of read object 1 (#3)", test_database_operations_read_object1)
+        || !CU_add_test(pSuite, "test of delete object 2", test_database_operations_delete_object2)
+        || !CU_add_test(pSuite, "test of read object 1 (#4)", test_database_operations_read_object1)
+
+        || !CU_add_test(pSuite, "test of read object 1 (REV)", test_database_operations_read_object1_2)
+        || !CU_add_test(pSuite, "test of create object 2 (REV)", test_database_operations_create_object2_2)
+        || !CU_add_test(pSuite, "test of read object 2 (REV)", test_database_operations_read_object2_2)
+        || !CU_add_test(pSuite, "test of read object 1 (#2) (REV)", test_database_operations_read_object1_2)
+        || !CU_add_test(pSuite, "test of create object 3 (REV)", test_database_operations_create_object3_2)
+        || !CU_add_test(pSuite, "test of update object 2 (REV)", test_database_operations_update_object2_2)
+        || !CU_add_test(pSuite, "test of updates revisions (REV)", test_database_operations_update_objects_revisions)
+        || !CU_add_test(pSuite, "test of pipeline revision conflict (REV)", test_database_operations_pipeline)
+        || !CU_add_test(pSuite, "test of update retry (REV)", test_database_operations_update_retry)
+        || !CU_add_test(pSuite, "test of stats (REV)", test_database_operations_stats)
+        || !CU_add_test(pSuite, "test of trace (REV)", test_database_operations_trace)
+        || !CU_add_test(pSuite, "test of delete object 3 (REV)", test_database_operations_delete_object3_2)
+        || !CU_add_test(pSuite, "test of read object 1 (#3) (REV)", test_database_operations_read_object1_2)
+        || !CU_add_test(pSuite, "test of delete object 2 (REV)", test_database_operations_delete_object2_2)
+        || !CU_add_test(pSuite, "test of read object 1 (#4) (REV)", test_database_operations_read_object1_2)
+
+        || !CU_add_test(pSuite, "test of associated fetch", test_database_operations_associated_fetch)
+        || !CU_add_test(pSuite, "test of upsert", test_database_operations_upsert)
+        || !CU_add_test(pSuite, "test of nested transactions", test_database_operations_nested_transactions))
+    {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+#endif
+    pSuite = CU_add_suite("Memory database operations", init_suite_database_operations_memory, clean_suite_database_operations);
+    if (!pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    if (!CU_add_test(pSuite, "test of read object 1", test_database_operations_read_object1)
+        || !CU_add_test(pSuite, "test of create object 2", test_database_operations_create_object2)
+        || !CU_add_test(pSuite, "test of read object 2", test_database_operations_read_object2)
+        || !CU_add_test(pSuite, "test of read object 1 (#2)", test_database_operations_read_object1)
+        || !CU_add_test(pSuite, "test of create object 3", test_database_operations_create_object3)
+        || !CU_add_test(pSuite, "test of update object 2", test_database_operations_update_object2)
+        || !CU_add_test(pSuite, "test of read all", test_database_operations_read_all)
+        || !CU_add_test(pSuite, "test of count with large clause list", test_database_operations_count_large_clause)
+        || !CU_add_test(pSuite, "test of clause operators and nesting", test_database_operations_clause_operators)
+        || !CU_add_test(pSuite, "test of read batch", test_database_operations_read_batch)
+        || !CU_add_test(pSuite, "test of delete object 3", test_database_operations_delete_object3)
+        || !CU_add_test(pSuite, "test of read object 1 (#3)", test_database_operations_read_object1)
+        || !CU_add_test(pSuite, "test of delete object 2", test_database_operations_delete_object2)
+        || !CU_add_test(pSuite, "test of read object 1 (#4)", test_database_operations_read_object1)
+
+        || !CU_add_test(pSuite, "test of read object 1 (REV)", test_database_operations_read_object1_2)
+        || !CU_add_test(pSuite, "test of create object 2 (REV)", test_database_operations_create_object2_2)
+        || !CU_add_test(pSuite, "test of read object 2 (REV)", test_database_operations_read_object2_2)
+        || !CU_add_test(pSuite, "test of read object 1 (#2) (REV)", test_database_operations_read_object1_2)
+        || !CU_add_test(pSuite, "test of create object 3 (REV)", test_database_operations_create_object3_2)
+        || !CU_add_test(pSuite, "test of update object 2 (REV)", test_database_operations_update_object2_2)
+        || !CU_add_test(pSuite, "test of updates revisions (REV)", test_database_operations_update_objects_revisions)
+        || !CU_add_test(pSuite, "test of update retry (REV)", test_database_operations_update_retry)
+        || !CU_add_test(pSuite, "test of stats (REV)", test_database_operations_stats)
+        || !CU_add_test(pSuite, "test of trace (REV)", test_database_operations_trace)
+        || !CU_add_test(pSuite, "test of delete object 3 (REV)", test_database_operations_delete_object3_2)
+        || !CU_add_test(pSuite, "test of read object 1 (#3) (REV)", test_database_operations_read_object1_2)
+        || !CU_add_test(pSuite, "test of delete object 2 (REV)", test_database_operations_delete_object2_2)
+        || !CU_add_test(pSuite, "test of read object 1 (#4) (REV)", test_database_operations_read_object1_2)
+
+        || !CU_add_test(pSuite, "test of associated fetch", test_database_operations_associated_fetch)
+        || !CU_add_test(pSuite, "test of upsert", test_database_operations_upsert)
+        || !CU_add_test(pSuite, "test of nested transactions", test_database_operations_nested_transactions)
+        || !CU_add_test(pSuite, "test of connection pool", test_database_operations_connection_pool)
+        || !CU_add_test(pSuite, "test of async", test_database_operations_async)
+        || !CU_add_test(pSuite, "test of async group commit", test_database_operations_async_group_commit))
+    {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    pSuite = CU_add_suite("Cache database operations", init_suite_database_operations_cache, clean_suite_database_operations);
+    if (!pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    if (!CU_add_test(pSuite, "test of read object 1", test_database_operations_read_object1)
+        || !CU_add_test(pSuite, "test of create object 2", test_database_operations_create_object2)
+        || !CU_add_test(pSuite, "test of read object 2", test_database_operations_read_object2)
+        || !CU_add_test(pSuite, "test of read object 1 (#2)", test_database_operations_read_object1)
+        || !CU_add_test(pSuite, "test of create object 3", test_database_operations_create_object3)
+        || !CU_add_test(pSuite, "test of update object 2", test_database_operations_update_object2)
+        || !CU_add_test(pSuite, "test of read all", test_database_operations_read_all)
+        || !CU_add_test(pSuite, "test of count with large clause list", test_database_operations_count_large_clause)
+        || !CU_add_test(pSuite, "test of clause operators and nesting", test_database_operations_clause_operators)
+        || !CU_add_test(pSuite, "test of read batch", test_database_operations_read_batch)
+        || !CU_add_test(pSuite, "test of delete object 3", test_database_operations_delete_object3)
+        || !CU_add_test(pSuite, "test of read object 1 (#3)", test_database_operations_read_object1)
+        || !CU_add_test(pSuite, "test of delete object 2", test_database_operations_delete_object2)
+        || !CU_add_test(pSuite, "test of read object 1 (#4)", test_database_operations_read_object1)
+
+        || !CU_add_test(pSuite, "test of read object 1 (REV)", test_database_operations_read_object1_2)
+        || !CU_add_test(pSuite, "test of create object 2 (REV)", test_database_operations_create_object2_2)
+        || !CU_add_test(pSuite, "test of read object 2 (REV)", test_database_operations_read_object2_2)
+        || !CU_add_test(pSuite, "test of read object 1 (#2) (REV)", test_database_operations_read_object1_2)
+        || !CU_add_test(pSuite, "test of create object 3 (REV)", test_database_operations_create_object3_2)
+        || !CU_add_test(pSuite, "test of update object 2 (REV)", test_database_operations_update_object2_2)
+        || !CU_add_test(pSuite, "test of updates revisions (REV)", test_database_operations_update_objects_revisions)
+        || !CU_add_test(pSuite, "test of update retry (REV)", test_database_operations_update_retry)
+        || !CU_add_test(pSuite, "test of stats (REV)", test_database_operations_stats)
+        || !CU_add_test(pSuite, "test of trace (REV)", test_database_operations_trace)
+        || !CU_add_test(pSuite, "test of delete object 3 (REV)", test_database_operations_delete_object3_2)
+        || !CU_add_test(pSuite, "test of read object 1 (#3) (REV)", test_database_operations_read_object1_2)
+        || !CU_add_test(pSuite, "test of delete object 2 (REV)", test_database_operations_delete_object2_2)
+        || !CU_add_test(pSuite, "test of read object 1 (#4) (REV)", test_database_operations_read_object1_2)
+
+        || !CU_add_test(pSuite, "test of associated fetch", test_database_operations_associated_fetch)
+        || !CU_add_test(pSuite, "test of upsert", test_database_operations_upsert)
+        || !CU_add_test(pSuite, "test of nested transactions", test_database_operations_nested_transactions)
+        || !CU_add_test(pSuite, "test of cache statistics", test_database_operations_cache_stats))
+    {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    pSuite = CU_add_suite("Identity map database operations", init_suite_database_operations_identity_map, clean_suite_database_operations);
+    if (!pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    if (!CU_add_test(pSuite, "test of read object 1", test_database_operations_read_object1)
+        || !CU_add_test(pSuite, "test of create object 2", test_database_operations_create_object2)
+        || !CU_add_test(pSuite, "test of read object 2", test_database_operations_read_object2)
+        || !CU_add_test(pSuite, "test of read object 1 (#2)", test_database_operations_read_object1)
+        || !CU_add_test(pSuite, "test of create object 3", test_database_operations_create_object3)
+        || !CU_add_test(pSuite, "test of update object 2", test_database_operations_update_object2)
+        || !CU_add_test(pSuite, "test of read all", test_database_operations_read_all)
+        || !CU_add_test(pSuite, "test of count with large clause list", test_database_operations_count_large_clause)
+        || !CU_add_test(pSuite, "test of clause operators and nesting", test_database_operations_clause_operators)
+        || !CU_add_test(pSuite, "test of read batch", test_database_operations_read_batch)
+        || !CU_add_test(pSuite, "test of delete object 3", test_database_operations_delete_object3)
+        || !CU_add_test(pSuite, "test of read object 1 (#3)", test_database_operations_read_object1)
+        || !CU_add_test(pSuite, "test of delete object 2", test_database_operations_delete_object2)
+        || !CU_add_test(pSuite, "test of read object 1 (#4)", test_database_operations_read_object1)
+
+        || !CU_add_test(pSuite, "test of read object 1 (REV)", test_database_operations_read_object1_2)
+        || !CU_add_test(pSuite, "test of create object 2 (REV)", test_database_operations_create_object2_2)
+        || !CU_add_test(pSuite, "test of read object 2 (REV)", test_database_operations_read_object2_2)
+        || !CU_add_test(pSuite, "test of read object 1 (#2) (REV)", test_database_operations_read_object1_2)
+        || !CU_add_test(pSuite, "test of create object 3 (REV)", test_database_operations_create_object3_2)
+        || !CU_add_test(pSuite, "test of update object 2 (REV)", test_database_operations_update_object2_2)
+        || !CU_add_test(pSuite, "test of updates revisions (REV)", test_database_operations_update_objects_revisions)
+        || !CU_add_test(pSuite, "test of update retry (REV)", test_database_operations_update_retry)
+        || !CU_add_test(pSuite, "test of stats (REV)", test_database_operations_stats)
+        || !CU_add_test(pSuite, "test of trace (REV)", test_database_operations_trace)
+        || !CU_add_test(pSuite, "test of delete object 3 (REV)", test_database_operations_delete_object3_2)
+        || !CU_add_test(pSuite, "test of read object 1 (#3) (REV)", test_database_operations_read_object1_2)
+        || !CU_add_test(pSuite, "test of delete object 2 (REV)", test_database_operations_delete_object2_2)
+        || !CU_add_test(pSuite, "test of read object 1 (#4) (REV)", test_database_operations_read_object1_2)
+
+        || !CU_add_test(pSuite, "test of associated fetch", test_database_operations_associated_fetch)
+        || !CU_add_test(pSuite, "test of upsert", test_database_operations_upsert)
+        || !CU_add_test(pSuite, "test of nested transactions", test_database_operations_nested_transactions)
+        || !CU_add_test(pSuite, "test of identity map", test_database_operations_identity_map)
+        || !CU_add_test(pSuite, "test of identity map in transactions", test_database_operations_identity_map_transaction))
+    {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    pSuite = CU_add_suite("Lookup filter database operations", init_suite_database_operations_lookup_filter, clean_suite_database_operations);
+    if (!pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    if (!CU_add_test(pSuite, "test of read object 1", test_database_operations_read_object1)
+        || !CU_add_test(pSuite, "test of create object 2", test_database_operations_create_object2)
+        || !CU_add_test(pSuite, "test of read object 2", test_database_operations_read_object2)
+        || !CU_add_test(pSuite, "test of read object 1 (#2)", test_database_operations_read_object1)
+        || !CU_add_test(pSuite, "test of create object 3", test_database_operations_create_object3)
+        || !CU_add_test(pSuite, "test of update object 2", test_database_operations_update_object2)
+        || !CU_add_test(pSuite, "test of read all", test_database_operations_read_all)
+        || !CU_add_test(pSuite, "test of count with large clause list", test_database_operations_count_large_clause)
+        || !CU_add_test(pSuite, "test of clause operators and nesting", test_database_operations_clause_operators)
+        || !CU_add_test(pSuite, "test of read batch", test_database_operations_read_batch)
+        || !CU_add_test(pSuite, "test of delete object 3", test_database_operations_delete_object3)
+        || !CU_add_test(pSuite, "test of read object 1 (#3)", test_database_operations_read_object1)
+        || !CU_add_test(pSuite, "test of delete object 2", test_database_operations_delete_object2)
+        || !CU_add_test(pSuite, "test of read object 1 (#4)", test_database_operations_read_object1)
+
+        || !CU_add_test(pSuite, "test of read object 1 (REV)", test_database_operations_read_object1_2)
+        || !CU_add_test(pSuite, "test of create object 2 (REV)", test_database_operations_create_object2_2)
+        || !CU_add_test(pSuite, "test of read object 2 (REV)", test_database_operations_read_object2_2)
+        || !CU_add_test(pSuite, "test of read object 1 (#2) (REV)", test_database_operations_read_object1_2)
+        || !CU_add_test(pSuite, "test of create object 3 (REV)", test_database_operations_create_object3_2)
+        || !CU_add_test(pSuite, "test of update object 2 (REV)", test_database_operations_update_object2_2)
+        || !CU_add_test(pSuite, "test of updates revisions (REV)", test_database_operations_update_objects_revisions)
+        || !CU_add_test(pSuite, "test of update retry (REV)", test_database_operations_update_retry)
+        || !CU_add_test(pSuite, "test of stats (REV)", test_database_operations_stats)
+        || !CU_add_test(pSuite, "test of trace (REV)", test_database_operations_trace)
+        || !CU_add_test(pSuite, "test of delete object 3 (REV)", test_database_operations_delete_object3_2)
+        || !CU_add_test(pSuite, "test of read object 1 (#3) (REV)", test_database_operations_read_object1_2)
+        || !CU_add_test(pSuite, "test of delete object 2 (REV)", test_database_operations_delete_object2_2)
+        || !CU_add_test(pSuite, "test of read object 1 (#4) (REV)", test_database_operations_read_object1_2)
+
+        || !CU_add_test(pSuite, "test of associated fetch", test_database_operations_associated_fetch)
+        || !CU_add_test(pSuite, "test of upsert", test_database_operations_upsert)
+        || !CU_add_test(pSuite, "test of nested transactions", test_database_operations_nested_transactions)
+        || !CU_add_test(pSuite, "test of lookup filter", test_database_operations_lookup_filter))
+    {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+#if defined(HAVE_LMDB)
+    pSuite = CU_add_suite("LMDB database operations", init_suite_database_operations_lmdb, clean_suite_database_operations);
+    if (!pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    if (!CU_add_test(pSuite, "test of read object 1", test_database_operations_read_object1)
+        || !CU_add_test(pSuite, "test of create object 2", test_database_operations_create_object2)
+        || !CU_add_test(pSuite, "test of read object 2", test_database_operations_read_object2)
+        || !CU_add_test(pSuite, "test of read object 1 (#2)", test_database_operations_read_object1)
+        || !CU_add_test(pSuite, "test of create object 3", test_database_operations_create_object3)
+        || !CU_add_test(pSuite, "test of update object 2", test_database_operations_update_object2)
+        || !CU_add_test(pSuite, "test of read all", test_database_operations_read_all)
+        || !CU_add_test(pSuite, "test of count with large clause list", test_database_operations_count_large_clause)
+        || !CU_add_test(pSuite, "test of clause operators and nesting", test_database_operations_clause_operators)
+        || !CU_add_test(pSuite, "test of read batch", test_database_operations_read_batch)
+        || !CU_add_test(pSuite, "test of delete object 3", test_database_operations_delete_object3)
+        || !CU_add_test(pSuite, "test of read object 1 (#3)", test_database_operations_read_object1)
+        || !CU_add_test(pSuite, "test of delete object 2", test_database_operations_delete_object2)
+        || !CU_add_test(pSuite, "test of read object 1 (#4)", test_database_operations_read_object1)
+
+        || !CU_add_test(pSuite, "test of read object 1 (REV)", test_database_operations_read_object1_2)
+        || !CU_add_test(pSuite, "test of create object 2 (REV)", test_database_operations_create_object2_2)
+        || !CU_add_test(pSuite, "test of read object 2 (REV)", test_database_operations_read_object2_2)
+        || !CU_add_test(pSuite, "test of read object 1 (#2) (REV)", test_database_operations_read_object1_2)
+        || !CU_add_test(pSuite, "test of create object 3 (REV)", test_database_operations_create_object3_2)
+        || !CU_add_test(pSuite, "test of update object 2 (REV)", test_database_operations_update_object2_2)
+        || !CU_add_test(pSuite, "test of updates revisions (REV)", test_database_operations_update_objects_revisions)
+        || !CU_add_test(pSuite, "test of update retry (REV)", test_database_operations_update_retry)
+        || !CU_add_test(pSuite, "test of stats (REV)", test_database_operations_stats)
+        || !CU_add_test(pSuite, "test of trace (REV)", test_database_operations_trace)
+        || !CU_add_test(pSuite, "test of delete object 3 (REV)", test_database_operations_delete_object3_2)
+        || !CU_add_test(pSuite, "test of read object 1 (#3) (REV)", test_database_operations_read_object1_2)
+        || !CU_add_test(pSuite, "test of delete object 2 (REV)", test_database_operations_delete_object2_2)
+        || !CU_add_test(pSuite, "test of read object 1 (#4) (REV)", test_database_operations_read_object1_2)
+
+        || !CU_add_test(pSuite, "test of associated fetch", test_database_operations_associated_fetch)
+        || !CU_add_test(pSuite, "test of upsert", test_database_operations_upsert)
+        || !CU_add_test(pSuite, "test of nested transactions", test_database_operations_nested_transactions))
     {
         CU_cleanup_registry();
         return CU_get_error();
@@ -87,12 +87,23 @@ int clean_suite_initialization(void);
 void test_initialization_configuration_sqlite3(void);
 void test_initialization_configuration_couchdb(void);
 void test_initialization_configuration_mysql(void);
+void test_initialization_configuration_postgresql(void);
+void test_initialization_configuration_memory(void);
+void test_initialization_configuration_lmdb(void);
 void test_initialization_connection(void);
 
 int init_suite_database_operations_sqlite(void);
 int init_suite_database_operations_couchdb(void);
 int init_suite_database_operations_mysql(void);
+int init_suite_database_operations_postgresql(void);
+int init_suite_database_operations_memory(void);
+int init_suite_database_operations_lmdb(void);
+int init_suite_database_operations_cache(void);
+int init_suite_database_operations_identity_map(void);
+int init_suite_database_operations_lookup_filter(void);
 int clean_suite_database_operations(void);
+int init_suite_database_operations_couchdb_stream(void);
+int clean_suite_database_operations_couchdb_stream(void);
 void test_database_operations_read_object1(void);
 void test_database_operations_create_object2(void);
 void test_database_operations_read_object2(void);
@@ -102,6 +113,9 @@ void test_database_operations_create_object3(void);
 void test_database_operations_delete_object3(void);
 void test_database_operations_read_all(void);
 void test_database_operations_count(void);
+void test_database_operations_count_large_clause(void);
+void test_database_operations_clause_operators(void);
+void test_database_operations_read_batch(void);
 void test_database_operations_read_object1_2(void);
 void test_database_operations_create_object2_2(void);
 void test_database_operations_read_object2_2(void);
@@ -110,7 +124,24 @@ void test_database_operations_delete_object2_2(void);
 void test_database_operations_create_object3_2(void);
 void test_database_operations_delete_object3_2(void);
 void test_database_operations_update_objects_revisions(void);
+void test_database_operations_update_retry(void);
+void test_database_operations_stats(void);
+void test_database_operations_trace(void);
+void test_database_operations_slow_query(void);
+void test_database_operations_pipeline(void);
+void test_database_operations_couchdb_stream(void);
+void test_database_operations_couchdb_stream_disconnect(void);
+void test_database_operations_couchdb_stream_pause(void);
 void test_database_operations_associated_fetch(void);
+void test_database_operations_upsert(void);
+void test_database_operations_nested_transactions(void);
+void test_database_operations_cache_stats(void);
+void test_database_operations_identity_map(void);
+void test_database_operations_identity_map_transaction(void);
+void test_database_operations_lookup_filter(void);
+void test_database_operations_connection_pool(void);
+void test_database_operations_async(void);
+void test_database_operations_async_group_commit(void);
 
 int init_suite_mm(void);
 int clean_suite_mm(void);
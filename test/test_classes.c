@@ -280,6 +280,15 @@ int __libdbo_backend_handle_delete(void* data, const libdbo_object_t* _object, c
     return 0;
 }
 
+int __libdbo_backend_handle_upsert(void* data, const libdbo_object_t* _object, const libdbo_object_field_list_t* object_field_list, const libdbo_value_set_t* value_set, const libdbo_clause_list_t* clause_list) {
+    CU_ASSERT(data == &fake_pointer);
+    CU_ASSERT((void*)_object == &fake_pointer || (object != NULL && _object == object));
+    CU_ASSERT((void*)object_field_list == &fake_pointer);
+    CU_ASSERT((void*)value_set == &fake_pointer);
+    CU_ASSERT((void*)clause_list == &fake_pointer);
+    return 0;
+}
+
 int __libdbo_backend_handle_count(void* data, const libdbo_object_t* _object, const libdbo_join_list_t* join_list, const libdbo_clause_list_t* clause_list, size_t* count) {
     CU_ASSERT(data == &fake_pointer);
     CU_ASSERT((void*)_object == &fake_pointer || (object != NULL && _object == object));
@@ -320,6 +329,7 @@ void test_class_libdbo_backend_handle(void) {
     CU_ASSERT(!libdbo_backend_handle_set_update(backend_handle, __libdbo_backend_handle_update));
     CU_ASSERT(!libdbo_backend_handle_set_delete(backend_handle, __libdbo_backend_handle_delete));
     CU_ASSERT(!libdbo_backend_handle_set_count(backend_handle, __libdbo_backend_handle_count));
+    CU_ASSERT(!libdbo_backend_handle_set_upsert(backend_handle, __libdbo_backend_handle_upsert));
     CU_ASSERT(!libdbo_backend_handle_set_free(backend_handle, __libdbo_backend_handle_free));
     CU_ASSERT(!libdbo_backend_handle_set_transaction_begin(backend_handle, __libdbo_backend_handle_transaction_begin));
     CU_ASSERT(!libdbo_backend_handle_set_transaction_commit(backend_handle, __libdbo_backend_handle_transaction_commit));
@@ -338,6 +348,7 @@ void test_class_libdbo_backend_handle(void) {
     CU_ASSERT(!libdbo_backend_handle_update(backend_handle, (libdbo_object_t*)&fake_pointer, (libdbo_object_field_list_t*)&fake_pointer, (libdbo_value_set_t*)&fake_pointer, (libdbo_clause_list_t*)&fake_pointer));
     CU_ASSERT(!libdbo_backend_handle_delete(backend_handle, (libdbo_object_t*)&fake_pointer, (libdbo_clause_list_t*)&fake_pointer));
     CU_ASSERT(!libdbo_backend_handle_count(backend_handle, (libdbo_object_t*)&fake_pointer, (libdbo_join_list_t*)&fake_pointer, (libdbo_clause_list_t*)&fake_pointer, (size_t*)&fake_pointer));
+    CU_ASSERT(!libdbo_backend_handle_upsert(backend_handle, (libdbo_object_t*)&fake_pointer, (libdbo_object_field_list_t*)&fake_pointer, (libdbo_value_set_t*)&fake_pointer, (libdbo_clause_list_t*)&fake_pointer));
     CU_ASSERT(!libdbo_backend_handle_transaction_begin(backend_handle));
     CU_ASSERT(!libdbo_backend_handle_transaction_commit(backend_handle));
     CU_ASSERT(!libdbo_backend_handle_transaction_rollback(backend_handle));
@@ -364,6 +375,7 @@ void test_class_libdbo_backend(void) {
     CU_ASSERT(!libdbo_backend_update(backend, (libdbo_object_t*)&fake_pointer, (libdbo_object_field_list_t*)&fake_pointer, (libdbo_value_set_t*)&fake_pointer, (libdbo_clause_list_t*)&fake_pointer));
     CU_ASSERT(!libdbo_backend_delete(backend, (libdbo_object_t*)&fake_pointer, (libdbo_clause_list_t*)&fake_pointer));
     CU_ASSERT(!libdbo_backend_count(backend, (libdbo_object_t*)&fake_pointer, (libdbo_join_list_t*)&fake_pointer, (libdbo_clause_list_t*)&fake_pointer, (size_t*)&fake_pointer));
+    CU_ASSERT(!libdbo_backend_upsert(backend, (libdbo_object_t*)&fake_pointer, (libdbo_object_field_list_t*)&fake_pointer, (libdbo_value_set_t*)&fake_pointer, (libdbo_clause_list_t*)&fake_pointer));
     CU_ASSERT(!libdbo_backend_transaction_begin(backend));
     CU_ASSERT(!libdbo_backend_transaction_commit(backend));
     CU_ASSERT(!libdbo_backend_transaction_rollback(backend));
@@ -599,6 +611,7 @@ void test_class_libdbo_connection(void) {
     CU_ASSERT(!libdbo_connection_update(connection, (libdbo_object_t*)&fake_pointer, (libdbo_object_field_list_t*)&fake_pointer, (libdbo_value_set_t*)&fake_pointer, (libdbo_clause_list_t*)&fake_pointer));
     CU_ASSERT(!libdbo_connection_delete(connection, (libdbo_object_t*)&fake_pointer, (libdbo_clause_list_t*)&fake_pointer));
     CU_ASSERT(!libdbo_connection_count(connection, (libdbo_object_t*)&fake_pointer, (libdbo_join_list_t*)&fake_pointer, (libdbo_clause_list_t*)&fake_pointer, (size_t*)&fake_pointer));
+    CU_ASSERT(!libdbo_connection_upsert(connection, (libdbo_object_t*)&fake_pointer, (libdbo_object_field_list_t*)&fake_pointer, (libdbo_value_set_t*)&fake_pointer, (libdbo_clause_list_t*)&fake_pointer));
     CU_ASSERT(!libdbo_connection_transaction_begin(connection));
     CU_ASSERT(!libdbo_connection_transaction_commit(connection));
     CU_ASSERT(!libdbo_connection_transaction_rollback(connection));
@@ -760,6 +773,7 @@ void test_class_libdbo_object(void) {
     CU_ASSERT(!libdbo_object_update(object, (libdbo_object_field_list_t*)&fake_pointer, (libdbo_value_set_t*)&fake_pointer, (libdbo_clause_list_t*)&fake_pointer));
     CU_ASSERT(!libdbo_object_delete(object, (libdbo_clause_list_t*)&fake_pointer));
     CU_ASSERT(!libdbo_object_count(object, (libdbo_join_list_t*)&fake_pointer, (libdbo_clause_list_t*)&fake_pointer, (size_t*)&fake_pointer));
+    CU_ASSERT(!libdbo_object_upsert(object, (libdbo_object_field_list_t*)&fake_pointer, (libdbo_value_set_t*)&fake_pointer, (libdbo_clause_list_t*)&fake_pointer));
 
     libdbo_object_free(object);
     object = NULL;
@@ -899,6 +913,7 @@ void test_class_libdbo_result_list(void) {
     libdbo_result_t* local_result = result;
     libdbo_result_t* local_result2 = result2;
     libdbo_result_list_t* local_result_list;
+    libdbo_stats_t* stats;
 
     CU_ASSERT_PTR_NOT_NULL_FATAL((result_list = libdbo_result_list_new()));
 
@@ -948,10 +963,44 @@ void test_class_libdbo_result_list(void) {
     CU_ASSERT_PTR_NOT_NULL(libdbo_result_list_begin(result_list));
     CU_ASSERT_PTR_NOT_NULL(libdbo_result_list_next(result_list));
 
+    CU_ASSERT(libdbo_result_list_error(result_list) == LIBDBO_OK);
+
     libdbo_result_list_free(result_list);
     result_list = NULL;
     CU_PASS("libdbo_result_list_free");
     CU_PASS("libdbo_result_free");
+
+    /*
+     * An error set while the results are fetched fails fetching all of them.
+     */
+    CU_ASSERT_PTR_NOT_NULL_FATAL((result_list = libdbo_result_list_new()));
+    __libdbo_result_list_next_count = 0;
+    CU_ASSERT_FATAL(!libdbo_result_list_set_next(result_list, __libdbo_result_list_next, &fake_pointer, 2));
+    CU_ASSERT(!libdbo_result_list_set_error(result_list, LIBDBO_ERROR_UNKNOWN));
+    CU_ASSERT(libdbo_result_list_error(result_list) == LIBDBO_ERROR_UNKNOWN);
+    CU_ASSERT(libdbo_result_list_fetch_all(result_list) == LIBDBO_ERROR_UNKNOWN);
+    CU_ASSERT(libdbo_result_list_size(result_list) == 3);
+
+    libdbo_result_list_free(result_list);
+    result_list = NULL;
+    CU_PASS("libdbo_result_list_free");
+
+    /*
+     * Statistics freed while a result list recorded in them is walked are kept
+     * until the result list is freed.
+     */
+    CU_ASSERT_PTR_NOT_NULL_FATAL((stats = libdbo_stats_new()));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((result_list = libdbo_result_list_new()));
+    __libdbo_result_list_next_count = 0;
+    CU_ASSERT_FATAL(!libdbo_result_list_set_next(result_list, __libdbo_result_list_next, &fake_pointer, 2));
+    CU_ASSERT(!libdbo_stats_record_result_list(stats, LIBDBO_STATS_READ, "test", 1, result_list));
+    CU_ASSERT_PTR_NOT_NULL(libdbo_result_list_next(result_list));
+    libdbo_stats_free(stats);
+    CU_ASSERT_PTR_NOT_NULL(libdbo_result_list_next(result_list));
+
+    libdbo_result_list_free(result_list);
+    result_list = NULL;
+    CU_PASS("libdbo_result_list_free");
 }
 
 void test_class_libdbo_value(void) {
@@ -281,6 +281,15 @@ int __db_backend_handle_delete(void* data, const db_object_t* _object, const db_
     return 0;
 }
 
+int __db_backend_handle_upsert(void* data, const db_object_t* _object, const db_object_field_list_t* object_field_list, const db_value_set_t* value_set, const db_clause_list_t* clause_list) {
+    CU_ASSERT(data == &fake_pointer);
+    CU_ASSERT((void*)_object == &fake_pointer || (object != NULL && _object == object));
+    CU_ASSERT((void*)object_field_list == &fake_pointer);
+    CU_ASSERT((void*)value_set == &fake_pointer);
+    CU_ASSERT((void*)clause_list == &fake_pointer);
+    return 0;
+}
+
 int __db_backend_handle_count(void* data, const db_object_t* _object, const db_join_list_t* join_list, const db_clause_list_t* clause_list, size_t* count) {
     CU_ASSERT(data == &fake_pointer);
     CU_ASSERT((void*)_object == &fake_pointer || (object != NULL && _object == object));
@@ -321,6 +330,7 @@ void test_class_short_names_db_backend_handle(void) {
     CU_ASSERT(!db_backend_handle_set_update(backend_handle, __db_backend_handle_update));
     CU_ASSERT(!db_backend_handle_set_delete(backend_handle, __db_backend_handle_delete));
     CU_ASSERT(!db_backend_handle_set_count(backend_handle, __db_backend_handle_count));
+    CU_ASSERT(!db_backend_handle_set_upsert(backend_handle, __db_backend_handle_upsert));
     CU_ASSERT(!db_backend_handle_set_free(backend_handle, __db_backend_handle_free));
     CU_ASSERT(!db_backend_handle_set_transaction_begin(backend_handle, __db_backend_handle_transaction_begin));
     CU_ASSERT(!db_backend_handle_set_transaction_commit(backend_handle, __db_backend_handle_transaction_commit));
@@ -339,6 +349,7 @@ void test_class_short_names_db_backend_handle(void) {
     CU_ASSERT(!db_backend_handle_update(backend_handle, (db_object_t*)&fake_pointer, (db_object_field_list_t*)&fake_pointer, (db_value_set_t*)&fake_pointer, (db_clause_list_t*)&fake_pointer));
     CU_ASSERT(!db_backend_handle_delete(backend_handle, (db_object_t*)&fake_pointer, (db_clause_list_t*)&fake_pointer));
     CU_ASSERT(!db_backend_handle_count(backend_handle, (db_object_t*)&fake_pointer, (db_join_list_t*)&fake_pointer, (db_clause_list_t*)&fake_pointer, (size_t*)&fake_pointer));
+    CU_ASSERT(!db_backend_handle_upsert(backend_handle, (db_object_t*)&fake_pointer, (db_object_field_list_t*)&fake_pointer, (db_value_set_t*)&fake_pointer, (db_clause_list_t*)&fake_pointer));
     CU_ASSERT(!db_backend_handle_transaction_begin(backend_handle));
     CU_ASSERT(!db_backend_handle_transaction_commit(backend_handle));
     CU_ASSERT(!db_backend_handle_transaction_rollback(backend_handle));
@@ -365,6 +376,7 @@ void test_class_short_names_db_backend(void) {
     CU_ASSERT(!db_backend_update(backend, (db_object_t*)&fake_pointer, (db_object_field_list_t*)&fake_pointer, (db_value_set_t*)&fake_pointer, (db_clause_list_t*)&fake_pointer));
     CU_ASSERT(!db_backend_delete(backend, (db_object_t*)&fake_pointer, (db_clause_list_t*)&fake_pointer));
     CU_ASSERT(!db_backend_count(backend, (db_object_t*)&fake_pointer, (db_join_list_t*)&fake_pointer, (db_clause_list_t*)&fake_pointer, (size_t*)&fake_pointer));
+    CU_ASSERT(!db_backend_upsert(backend, (db_object_t*)&fake_pointer, (db_object_field_list_t*)&fake_pointer, (db_value_set_t*)&fake_pointer, (db_clause_list_t*)&fake_pointer));
     CU_ASSERT(!db_backend_transaction_begin(backend));
     CU_ASSERT(!db_backend_transaction_commit(backend));
     CU_ASSERT(!db_backend_transaction_rollback(backend));
@@ -600,6 +612,7 @@ void test_class_short_names_db_connection(void) {
     CU_ASSERT(!db_connection_update(connection, (db_object_t*)&fake_pointer, (db_object_field_list_t*)&fake_pointer, (db_value_set_t*)&fake_pointer, (db_clause_list_t*)&fake_pointer));
     CU_ASSERT(!db_connection_delete(connection, (db_object_t*)&fake_pointer, (db_clause_list_t*)&fake_pointer));
     CU_ASSERT(!db_connection_count(connection, (db_object_t*)&fake_pointer, (db_join_list_t*)&fake_pointer, (db_clause_list_t*)&fake_pointer, (size_t*)&fake_pointer));
+    CU_ASSERT(!db_connection_upsert(connection, (db_object_t*)&fake_pointer, (db_object_field_list_t*)&fake_pointer, (db_value_set_t*)&fake_pointer, (db_clause_list_t*)&fake_pointer));
     CU_ASSERT(!db_connection_transaction_begin(connection));
     CU_ASSERT(!db_connection_transaction_commit(connection));
     CU_ASSERT(!db_connection_transaction_rollback(connection));
@@ -761,6 +774,7 @@ void test_class_short_names_db_object(void) {
     CU_ASSERT(!db_object_update(object, (db_object_field_list_t*)&fake_pointer, (db_value_set_t*)&fake_pointer, (db_clause_list_t*)&fake_pointer));
     CU_ASSERT(!db_object_delete(object, (db_clause_list_t*)&fake_pointer));
     CU_ASSERT(!db_object_count(object, (db_join_list_t*)&fake_pointer, (db_clause_list_t*)&fake_pointer, (size_t*)&fake_pointer));
+    CU_ASSERT(!db_object_upsert(object, (db_object_field_list_t*)&fake_pointer, (db_value_set_t*)&fake_pointer, (db_clause_list_t*)&fake_pointer));
 
     db_object_free(object);
     object = NULL;
@@ -900,6 +914,7 @@ void test_class_short_names_db_result_list(void) {
     db_result_t* local_result = result;
     db_result_t* local_result2 = result2;
     db_result_list_t* local_result_list;
+    db_stats_t* stats;
 
     CU_ASSERT_PTR_NOT_NULL_FATAL((result_list = db_result_list_new()));
 
@@ -949,10 +964,44 @@ void test_class_short_names_db_result_list(void) {
     CU_ASSERT_PTR_NOT_NULL(db_result_list_begin(result_list));
     CU_ASSERT_PTR_NOT_NULL(db_result_list_next(result_list));
 
+    CU_ASSERT(db_result_list_error(result_list) == DB_OK);
+
     db_result_list_free(result_list);
     result_list = NULL;
     CU_PASS("db_result_list_free");
     CU_PASS("db_result_free");
+
+    /*
+     * An error set while the results are fetched fails fetching all of them.
+     */
+    CU_ASSERT_PTR_NOT_NULL_FATAL((result_list = db_result_list_new()));
+    __db_result_list_next_count = 0;
+    CU_ASSERT_FATAL(!db_result_list_set_next(result_list, __db_result_list_next, &fake_pointer, 2));
+    CU_ASSERT(!db_result_list_set_error(result_list, DB_ERROR_UNKNOWN));
+    CU_ASSERT(db_result_list_error(result_list) == DB_ERROR_UNKNOWN);
+    CU_ASSERT(db_result_list_fetch_all(result_list) == DB_ERROR_UNKNOWN);
+    CU_ASSERT(db_result_list_size(result_list) == 3);
+
+    db_result_list_free(result_list);
+    result_list = NULL;
+    CU_PASS("db_result_list_free");
+
+    /*
+     * Statistics freed while a result list recorded in them is walked are kept
+     * until the result list is freed.
+     */
+    CU_ASSERT_PTR_NOT_NULL_FATAL((stats = db_stats_new()));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((result_list = db_result_list_new()));
+    __db_result_list_next_count = 0;
+    CU_ASSERT_FATAL(!db_result_list_set_next(result_list, __db_result_list_next, &fake_pointer, 2));
+    CU_ASSERT(!db_stats_record_result_list(stats, DB_STATS_READ, "test", 1, result_list));
+    CU_ASSERT_PTR_NOT_NULL(db_result_list_next(result_list));
+    db_stats_free(stats);
+    CU_ASSERT_PTR_NOT_NULL(db_result_list_next(result_list));
+
+    db_result_list_free(result_list);
+    result_list = NULL;
+    CU_PASS("db_result_list_free");
 }
 
 void test_class_short_names_db_value(void) {
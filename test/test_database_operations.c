@@ -37,14 +37,31 @@
 
 #include <libdbo/configuration.h>
 #include <libdbo/connection.h>
+#include <libdbo/connection_pool.h>
+#include <libdbo/async.h>
+#include <libdbo/retry.h>
+#include <libdbo/trace.h>
+#include <libdbo/error.h>
 #include <libdbo/object.h>
+#include <libdbo/log.h>
+#include <libdbo/backend/cache.h>
 
 #include "users_rev.h"
 #include "groups_rev.h"
 #include "user_group_link_rev.h"
 
 #include "CUnit/Basic.h"
+#include <stdio.h>
 #include <string.h>
+#include <pthread.h>
+#if defined(HAVE_COUCHDB)
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif
 
 typedef struct {
     libdbo_object_t* dbo;
@@ -65,7 +82,7 @@ static test_t* test = NULL;
 static test_list_t* test_list = NULL;
 static libdbo_value_t object2_id, object3_id;
 
-libdbo_object_t* __test_new_object(const libdbo_connection_t* connection) {
+static libdbo_object_t* __test_new_table_object(const libdbo_connection_t* connection, const char* table) {
     libdbo_object_field_list_t* object_field_list;
     libdbo_object_field_t* object_field;
     libdbo_object_t* object;
@@ -73,7 +90,7 @@ libdbo_object_t* __test_new_object(const libdbo_connection_t* connection) {
     CU_ASSERT_PTR_NOT_NULL_FATAL((object = libdbo_object_new()));
 
     CU_ASSERT_FATAL(!libdbo_object_set_connection(object, connection));
-    CU_ASSERT_FATAL(!libdbo_object_set_table(object, "test"));
+    CU_ASSERT_FATAL(!libdbo_object_set_table(object, table));
     CU_ASSERT_FATAL(!libdbo_object_set_primary_key_name(object, "id"));
 
     CU_ASSERT_PTR_NOT_NULL_FATAL((object_field_list = libdbo_object_field_list_new()));
@@ -93,6 +110,10 @@ libdbo_object_t* __test_new_object(const libdbo_connection_t* connection) {
     return object;
 }
 
+libdbo_object_t* __test_new_object(const libdbo_connection_t* connection) {
+    return __test_new_table_object(connection, "test");
+}
+
 test_t* test_new(const libdbo_connection_t* connection) {
     test_t* test =
         (test_t*)calloc(1, sizeof(test_t));
@@ -762,9 +783,7 @@ int test2_update(test2_t* test2) {
     CU_ASSERT_PTR_NOT_NULL_FATAL((value = libdbo_value_set_get(value_set, 0)));
     CU_ASSERT_FATAL(!libdbo_value_from_text(value, test2->name));
 
-    if (libdbo_object_update(test2->dbo, object_field_list, value_set, clause_list)) {
-        ret = 1;
-    }
+    ret = libdbo_object_update(test2->dbo, object_field_list, value_set, clause_list);
 
     libdbo_clause_list_free(clause_list);
     libdbo_clause_free(clause);
@@ -1095,508 +1114,2881 @@ int init_suite_database_operations_mysql(void) {
 #endif
 }
 
-int clean_suite_database_operations(void) {
-    test_free(test);
-    test = NULL;
-    test_list_free(test_list);
-    test_list = NULL;
-    test2_free(test2);
-    test2 = NULL;
-    test2_free(test2_2);
-    test2_2 = NULL;
-    libdbo_connection_free(connection);
-    connection = NULL;
-    libdbo_configuration_free(configuration);
-    configuration = NULL;
-    libdbo_configuration_list_free(configuration_list);
-    configuration_list = NULL;
-    libdbo_value_reset(&object2_id);
-    libdbo_value_reset(&object3_id);
-    return 0;
-}
-
-void __check_id(const libdbo_value_t* id, int id_int, const char* id_text) {
-    libdbo_type_int32_t int32;
-    libdbo_type_uint32_t uint32;
-    libdbo_type_int64_t int64;
-    libdbo_type_uint64_t uint64;
-    const char* text;
-
-    CU_ASSERT_PTR_NOT_NULL(id);
-    switch (libdbo_value_type(id)) {
-    case LIBDBO_TYPE_INT32:
-        CU_ASSERT(!libdbo_value_to_int32(id, &int32));
-        CU_ASSERT(int32 == (libdbo_type_int32_t)id_int);
-        break;
-
-    case LIBDBO_TYPE_UINT32:
-        CU_ASSERT(!libdbo_value_to_uint32(id, &uint32));
-        CU_ASSERT(uint32 == (libdbo_type_uint32_t)id_int);
-        break;
-
-    case LIBDBO_TYPE_INT64:
-        CU_ASSERT(!libdbo_value_to_int64(id, &int64));
-        CU_ASSERT(int64 == (libdbo_type_int64_t)id_int);
-        break;
-
-    case LIBDBO_TYPE_UINT64:
-        CU_ASSERT(!libdbo_value_to_uint64(id, &uint64));
-        CU_ASSERT(uint64 == (libdbo_type_uint64_t)id_int);
-        break;
+int init_suite_database_operations_postgresql(void) {
+#if defined(HAVE_POSTGRESQL)
+    if (configuration_list) {
+        return 1;
+    }
+    if (configuration) {
+        return 1;
+    }
+    if (connection) {
+        return 1;
+    }
+    if (test) {
+        return 1;
+    }
+    if (test2) {
+        return 1;
+    }
+    if (test2_2) {
+        return 1;
+    }
 
-    case LIBDBO_TYPE_TEXT:
-        CU_ASSERT_PTR_NOT_NULL_FATAL((text = libdbo_value_text(id)));
-        CU_ASSERT(!strcmp(text, id_text));
-        break;
+    /*
+     * Setup the configuration for the connection
+     */
+    if (!(configuration_list = libdbo_configuration_list_new())) {
+        return 1;
+    }
+    if (!(configuration = libdbo_configuration_new())
+        || libdbo_configuration_set_name(configuration, "backend")
+        || libdbo_configuration_set_value(configuration, "postgresql")
+        || libdbo_configuration_list_add(configuration_list, configuration))
+    {
+        libdbo_configuration_free(configuration);
+        configuration = NULL;
+        libdbo_configuration_list_free(configuration_list);
+        configuration_list = NULL;
+        return 1;
+    }
+    configuration = NULL;
+    if (!(configuration = libdbo_configuration_new())
+        || libdbo_configuration_set_name(configuration, "host")
+        || libdbo_configuration_set_value(configuration, TEST_POSTGRESQL_HOST)
+        || libdbo_configuration_list_add(configuration_list, configuration))
+    {
+        libdbo_configuration_free(configuration);
+        configuration = NULL;
+        libdbo_configuration_list_free(configuration_list);
+        configuration_list = NULL;
+        return 1;
+    }
+    configuration = NULL;
+    if (!(configuration = libdbo_configuration_new())
+        || libdbo_configuration_set_name(configuration, "port")
+        || libdbo_configuration_set_value(configuration, TEST_POSTGRESQL_PORT_TXT)
+        || libdbo_configuration_list_add(configuration_list, configuration))
+    {
+        libdbo_configuration_free(configuration);
+        configuration = NULL;
+        libdbo_configuration_list_free(configuration_list);
+        configuration_list = NULL;
+        return 1;
+    }
+    configuration = NULL;
+    if (!(configuration = libdbo_configuration_new())
+        || libdbo_configuration_set_name(configuration, "user")
+        || libdbo_configuration_set_value(configuration, TEST_POSTGRESQL_USER)
+        || libdbo_configuration_list_add(configuration_list, configuration))
+    {
+        libdbo_configuration_free(configuration);
+        configuration = NULL;
+        libdbo_configuration_list_free(configuration_list);
+        configuration_list = NULL;
+        return 1;
+    }
+    configuration = NULL;
+    if (!(configuration = libdbo_configuration_new())
+        || libdbo_configuration_set_name(configuration, "pass")
+        || libdbo_configuration_set_value(configuration, TEST_POSTGRESQL_PASS)
+        || libdbo_configuration_list_add(configuration_list, configuration))
+    {
+        libdbo_configuration_free(configuration);
+        configuration = NULL;
+        libdbo_configuration_list_free(configuration_list);
+        configuration_list = NULL;
+        return 1;
+    }
+    configuration = NULL;
+    if (!(configuration = libdbo_configuration_new())
+        || libdbo_configuration_set_name(configuration, "db")
+        || libdbo_configuration_set_value(configuration, TEST_POSTGRESQL_DB)
+        || libdbo_configuration_list_add(configuration_list, configuration))
+    {
+        libdbo_configuration_free(configuration);
+        configuration = NULL;
+        libdbo_configuration_list_free(configuration_list);
+        configuration_list = NULL;
+        return 1;
+    }
+    configuration = NULL;
 
-    default:
-        CU_FAIL("libdbo_value_type(id)");
+    /*
+     * Connect to the database
+     */
+    if (!(connection = libdbo_connection_new())
+        || libdbo_connection_set_configuration_list(connection, configuration_list))
+    {
+        libdbo_connection_free(connection);
+        connection = NULL;
+        libdbo_configuration_list_free(configuration_list);
+        configuration_list = NULL;
+        return 1;
     }
-}
+    configuration_list = NULL;
 
-void test_database_operations_read_object1(void) {
-    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
-    CU_ASSERT_FATAL(!test_get_by_name(test, "test"));
-    __check_id(test_id(test), 1, "1");
-    CU_ASSERT_PTR_NOT_NULL_FATAL(test_name(test));
-    CU_ASSERT(!strcmp(test_name(test), "test"));
+    if (libdbo_connection_setup(connection)
+        || libdbo_connection_connect(connection))
+    {
+        libdbo_connection_free(connection);
+        connection = NULL;
+        return 1;
+    }
 
-    test_free(test);
-    test = NULL;
-    CU_PASS("test_free");
+    return 0;
+#else
+    return 1;
+#endif
 }
 
-void test_database_operations_create_object2(void) {
-    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
-    CU_ASSERT_FATAL(!test_set_name(test, "name 2"));
-    CU_ASSERT(!strcmp(test_name(test), "name 2"));
-    CU_ASSERT_FATAL(!test_create(test));
+/*
+ * The memory and LMDB backends starts out empty, create the rows that the SQL
+ * backends get from their test schema.
+ */
+static int __insert_test(const char* table, int revision) {
+    libdbo_object_t* object = NULL;
+    libdbo_object_field_list_t* object_field_list = NULL;
+    libdbo_object_field_t* object_field = NULL;
+    libdbo_value_set_t* value_set = NULL;
+    int ret = 1;
+
+    if (!(object = libdbo_object_new())
+        || libdbo_object_set_connection(object, connection)
+        || libdbo_object_set_table(object, table)
+        || libdbo_object_set_primary_key_name(object, "id")
+        || !(object_field_list = libdbo_object_field_list_new()))
+    {
+        goto done;
+    }
 
-    test_free(test);
-    test = NULL;
-    CU_PASS("test_free");
+    if (!(object_field = libdbo_object_field_new())
+        || libdbo_object_field_set_name(object_field, "id")
+        || libdbo_object_field_set_type(object_field, LIBDBO_TYPE_PRIMARY_KEY)
+        || libdbo_object_field_list_add(object_field_list, object_field))
+    {
+        goto done;
+    }
+    object_field = NULL;
+    if (revision) {
+        if (!(object_field = libdbo_object_field_new())
+            || libdbo_object_field_set_name(object_field, "rev")
+            || libdbo_object_field_set_type(object_field, LIBDBO_TYPE_REVISION)
+            || libdbo_object_field_list_add(object_field_list, object_field))
+        {
+            goto done;
+        }
+        object_field = NULL;
+    }
+    if (!(object_field = libdbo_object_field_new())
+        || libdbo_object_field_set_name(object_field, "name")
+        || libdbo_object_field_set_type(object_field, LIBDBO_TYPE_TEXT)
+        || libdbo_object_field_list_add(object_field_list, object_field))
+    {
+        goto done;
+    }
+    object_field = NULL;
+    if (libdbo_object_set_object_field_list(object, object_field_list)) {
+        goto done;
+    }
+    object_field_list = NULL;
 
-    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
-    CU_ASSERT_FATAL(!test_get_by_name(test, "name 2"));
-    libdbo_value_reset(&object2_id);
-    CU_ASSERT(!libdbo_value_copy(&object2_id, test_id(test)));
-    CU_ASSERT(!strcmp(test_name(test), "name 2"));
+    if (!(object_field_list = libdbo_object_field_list_new())
+        || !(object_field = libdbo_object_field_new())
+        || libdbo_object_field_set_name(object_field, "name")
+        || libdbo_object_field_set_type(object_field, LIBDBO_TYPE_TEXT)
+        || libdbo_object_field_list_add(object_field_list, object_field))
+    {
+        goto done;
+    }
+    object_field = NULL;
+    if (!(value_set = libdbo_value_set_new(1))
+        || libdbo_value_from_text(libdbo_value_set_get(value_set, 0), "test")
+        || libdbo_object_create(object, object_field_list, value_set))
+    {
+        goto done;
+    }
+    ret = 0;
 
-    test_free(test);
-    test = NULL;
-    CU_PASS("test_free");
+done:
+    libdbo_value_set_free(value_set);
+    libdbo_object_field_free(object_field);
+    libdbo_object_field_list_free(object_field_list);
+    libdbo_object_free(object);
+    return ret;
 }
 
-void test_database_operations_read_object2(void) {
-    int cmp = 0;
-
-    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
-    CU_ASSERT_FATAL(!test_get_by_id(test, &object2_id));
-    CU_ASSERT(!libdbo_value_cmp(test_id(test), &object2_id, &cmp));
-    CU_ASSERT(!cmp);
-    CU_ASSERT(!strcmp(test_name(test), "name 2"));
-
-    test_free(test);
-    test = NULL;
-    CU_PASS("test_free");
-}
+int init_suite_database_operations_memory(void) {
+    if (configuration_list) {
+        return 1;
+    }
+    if (configuration) {
+        return 1;
+    }
+    if (connection) {
+        return 1;
+    }
+    if (test) {
+        return 1;
+    }
+    if (test2) {
+        return 1;
+    }
+    if (test2_2) {
+        return 1;
+    }
 
-void test_database_operations_update_object2(void) {
-    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
+    /*
+     * Setup the configuration for the connection
+     */
+    if (!(configuration_list = libdbo_configuration_list_new())) {
+        return 1;
+    }
+    if (!(configuration = libdbo_configuration_new())
+        || libdbo_configuration_set_name(configuration, "backend")
+        || libdbo_configuration_set_value(configuration, "memory")
+        || libdbo_configuration_list_add(configuration_list, configuration))
+    {
+        libdbo_configuration_free(configuration);
+        configuration = NULL;
+        libdbo_configuration_list_free(configuration_list);
+        configuration_list = NULL;
+        return 1;
+    }
+    configuration = NULL;
+    if (!(configuration = libdbo_configuration_new())
+        || libdbo_configuration_set_name(configuration, "unique")
+        || libdbo_configuration_set_value(configuration, "users.name,groups.name,users_rev.name,groups_rev.name")
+        || libdbo_configuration_list_add(configuration_list, configuration))
+    {
+        libdbo_configuration_free(configuration);
+        configuration = NULL;
+        libdbo_configuration_list_free(configuration_list);
+        configuration_list = NULL;
+        return 1;
+    }
+    configuration = NULL;
+
+    /*
+     * Connect to the database
+     */
+    if (!(connection = libdbo_connection_new())
+        || libdbo_connection_set_configuration_list(connection, configuration_list))
+    {
+        libdbo_connection_free(connection);
+        connection = NULL;
+        libdbo_configuration_list_free(configuration_list);
+        configuration_list = NULL;
+        return 1;
+    }
+    configuration_list = NULL;
+
+    if (libdbo_connection_setup(connection)
+        || libdbo_connection_connect(connection)
+        || __insert_test("test", 0)
+        || __insert_test("test2", 1))
+    {
+        libdbo_connection_free(connection);
+        connection = NULL;
+        return 1;
+    }
+
+    return 0;
+}
+
+int init_suite_database_operations_lmdb(void) {
+#if defined(HAVE_LMDB)
+    if (configuration_list) {
+        return 1;
+    }
+    if (configuration) {
+        return 1;
+    }
+    if (connection) {
+        return 1;
+    }
+    if (test) {
+        return 1;
+    }
+    if (test2) {
+        return 1;
+    }
+    if (test2_2) {
+        return 1;
+    }
+
+    /*
+     * Setup the configuration for the connection
+     */
+    if (!(configuration_list = libdbo_configuration_list_new())) {
+        return 1;
+    }
+    if (!(configuration = libdbo_configuration_new())
+        || libdbo_configuration_set_name(configuration, "backend")
+        || libdbo_configuration_set_value(configuration, "lmdb")
+        || libdbo_configuration_list_add(configuration_list, configuration))
+    {
+        libdbo_configuration_free(configuration);
+        configuration = NULL;
+        libdbo_configuration_list_free(configuration_list);
+        configuration_list = NULL;
+        return 1;
+    }
+    configuration = NULL;
+    if (!(configuration = libdbo_configuration_new())
+        || libdbo_configuration_set_name(configuration, "file")
+        || libdbo_configuration_set_value(configuration, "test.lmdb")
+        || libdbo_configuration_list_add(configuration_list, configuration))
+    {
+        libdbo_configuration_free(configuration);
+        configuration = NULL;
+        libdbo_configuration_list_free(configuration_list);
+        configuration_list = NULL;
+        return 1;
+    }
+    configuration = NULL;
+    if (!(configuration = libdbo_configuration_new())
+        || libdbo_configuration_set_name(configuration, "unique")
+        || libdbo_configuration_set_value(configuration, "users.name,groups.name,users_rev.name,groups_rev.name")
+        || libdbo_configuration_list_add(configuration_list, configuration))
+    {
+        libdbo_configuration_free(configuration);
+        configuration = NULL;
+        libdbo_configuration_list_free(configuration_list);
+        configuration_list = NULL;
+        return 1;
+    }
+    configuration = NULL;
+
+    /*
+     * Connect to the database
+     */
+    if (!(connection = libdbo_connection_new())
+        || libdbo_connection_set_configuration_list(connection, configuration_list))
+    {
+        libdbo_connection_free(connection);
+        connection = NULL;
+        libdbo_configuration_list_free(configuration_list);
+        configuration_list = NULL;
+        return 1;
+    }
+    configuration_list = NULL;
+
+    if (libdbo_connection_setup(connection)
+        || libdbo_connection_connect(connection)
+        || __insert_test("test", 0)
+        || __insert_test("test2", 1))
+    {
+        libdbo_connection_free(connection);
+        connection = NULL;
+        return 1;
+    }
+
+    return 0;
+#else
+    return 1;
+#endif
+}
+
+int init_suite_database_operations_cache(void) {
+    if (configuration_list) {
+        return 1;
+    }
+    if (configuration) {
+        return 1;
+    }
+    if (connection) {
+        return 1;
+    }
+    if (test) {
+        return 1;
+    }
+    if (test2) {
+        return 1;
+    }
+    if (test2_2) {
+        return 1;
+    }
+
+    /*
+     * Setup the configuration for the connection
+     */
+    if (!(configuration_list = libdbo_configuration_list_new())) {
+        return 1;
+    }
+    if (!(configuration = libdbo_configuration_new())
+        || libdbo_configuration_set_name(configuration, "backend")
+        || libdbo_configuration_set_value(configuration, "cache")
+        || libdbo_configuration_list_add(configuration_list, configuration))
+    {
+        libdbo_configuration_free(configuration);
+        configuration = NULL;
+        libdbo_configuration_list_free(configuration_list);
+        configuration_list = NULL;
+        return 1;
+    }
+    configuration = NULL;
+    if (!(configuration = libdbo_configuration_new())
+        || libdbo_configuration_set_name(configuration, "cache_backend")
+        || libdbo_configuration_set_value(configuration, "memory")
+        || libdbo_configuration_list_add(configuration_list, configuration))
+    {
+        libdbo_configuration_free(configuration);
+        configuration = NULL;
+        libdbo_configuration_list_free(configuration_list);
+        configuration_list = NULL;
+        return 1;
+    }
+    configuration = NULL;
+    if (!(configuration = libdbo_configuration_new())
+        || libdbo_configuration_set_name(configuration, "unique")
+        || libdbo_configuration_set_value(configuration, "users.name,groups.name,users_rev.name,groups_rev.name")
+        || libdbo_configuration_list_add(configuration_list, configuration))
+    {
+        libdbo_configuration_free(configuration);
+        configuration = NULL;
+        libdbo_configuration_list_free(configuration_list);
+        configuration_list = NULL;
+        return 1;
+    }
+    configuration = NULL;
+
+    /*
+     * Connect to the database
+     */
+    if (!(connection = libdbo_connection_new())
+        || libdbo_connection_set_configuration_list(connection, configuration_list))
+    {
+        libdbo_connection_free(connection);
+        connection = NULL;
+        libdbo_configuration_list_free(configuration_list);
+        configuration_list = NULL;
+        return 1;
+    }
+    configuration_list = NULL;
+
+    if (libdbo_connection_setup(connection)
+        || libdbo_connection_connect(connection)
+        || __insert_test("test", 0)
+        || __insert_test("test2", 1))
+    {
+        libdbo_connection_free(connection);
+        connection = NULL;
+        return 1;
+    }
+
+    return 0;
+}
+
+int init_suite_database_operations_identity_map(void) {
+    if (configuration_list) {
+        return 1;
+    }
+    if (configuration) {
+        return 1;
+    }
+    if (connection) {
+        return 1;
+    }
+    if (test) {
+        return 1;
+    }
+    if (test2) {
+        return 1;
+    }
+    if (test2_2) {
+        return 1;
+    }
+
+    /*
+     * Setup the configuration for the connection
+     */
+    if (!(configuration_list = libdbo_configuration_list_new())) {
+        return 1;
+    }
+    if (!(configuration = libdbo_configuration_new())
+        || libdbo_configuration_set_name(configuration, "backend")
+        || libdbo_configuration_set_value(configuration, "memory")
+        || libdbo_configuration_list_add(configuration_list, configuration))
+    {
+        libdbo_configuration_free(configuration);
+        configuration = NULL;
+        libdbo_configuration_list_free(configuration_list);
+        configuration_list = NULL;
+        return 1;
+    }
+    configuration = NULL;
+    if (!(configuration = libdbo_configuration_new())
+        || libdbo_configuration_set_name(configuration, "unique")
+        || libdbo_configuration_set_value(configuration, "users.name,groups.name,users_rev.name,groups_rev.name")
+        || libdbo_configuration_list_add(configuration_list, configuration))
+    {
+        libdbo_configuration_free(configuration);
+        configuration = NULL;
+        libdbo_configuration_list_free(configuration_list);
+        configuration_list = NULL;
+        return 1;
+    }
+    configuration = NULL;
+    if (!(configuration = libdbo_configuration_new())
+        || libdbo_configuration_set_name(configuration, "identity_map")
+        || libdbo_configuration_set_value(configuration, "128")
+        || libdbo_configuration_list_add(configuration_list, configuration))
+    {
+        libdbo_configuration_free(configuration);
+        configuration = NULL;
+        libdbo_configuration_list_free(configuration_list);
+        configuration_list = NULL;
+        return 1;
+    }
+    configuration = NULL;
+
+    /*
+     * Connect to the database
+     */
+    if (!(connection = libdbo_connection_new())
+        || libdbo_connection_set_configuration_list(connection, configuration_list))
+    {
+        libdbo_connection_free(connection);
+        connection = NULL;
+        libdbo_configuration_list_free(configuration_list);
+        configuration_list = NULL;
+        return 1;
+    }
+    configuration_list = NULL;
+
+    if (libdbo_connection_setup(connection)
+        || libdbo_connection_connect(connection)
+        || __insert_test("test", 0)
+        || __insert_test("test2", 1))
+    {
+        libdbo_connection_free(connection);
+        connection = NULL;
+        return 1;
+    }
+
+    return 0;
+}
+
+int init_suite_database_operations_lookup_filter(void) {
+    if (configuration_list) {
+        return 1;
+    }
+    if (configuration) {
+        return 1;
+    }
+    if (connection) {
+        return 1;
+    }
+    if (test) {
+        return 1;
+    }
+    if (test2) {
+        return 1;
+    }
+    if (test2_2) {
+        return 1;
+    }
+
+    /*
+     * Setup the configuration for the connection
+     */
+    if (!(configuration_list = libdbo_configuration_list_new())) {
+        return 1;
+    }
+    if (!(configuration = libdbo_configuration_new())
+        || libdbo_configuration_set_name(configuration, "backend")
+        || libdbo_configuration_set_value(configuration, "memory")
+        || libdbo_configuration_list_add(configuration_list, configuration))
+    {
+        libdbo_configuration_free(configuration);
+        configuration = NULL;
+        libdbo_configuration_list_free(configuration_list);
+        configuration_list = NULL;
+        return 1;
+    }
+    configuration = NULL;
+    if (!(configuration = libdbo_configuration_new())
+        || libdbo_configuration_set_name(configuration, "unique")
+        || libdbo_configuration_set_value(configuration, "users.name,groups.name,users_rev.name,groups_rev.name")
+        || libdbo_configuration_list_add(configuration_list, configuration))
+    {
+        libdbo_configuration_free(configuration);
+        configuration = NULL;
+        libdbo_configuration_list_free(configuration_list);
+        configuration_list = NULL;
+        return 1;
+    }
+    configuration = NULL;
+    if (!(configuration = libdbo_configuration_new())
+        || libdbo_configuration_set_name(configuration, "lookup_filter")
+        || libdbo_configuration_set_value(configuration, "test.name")
+        || libdbo_configuration_list_add(configuration_list, configuration))
+    {
+        libdbo_configuration_free(configuration);
+        configuration = NULL;
+        libdbo_configuration_list_free(configuration_list);
+        configuration_list = NULL;
+        return 1;
+    }
+    configuration = NULL;
+
+    /*
+     * Connect to the database
+     */
+    if (!(connection = libdbo_connection_new())
+        || libdbo_connection_set_configuration_list(connection, configuration_list))
+    {
+        libdbo_connection_free(connection);
+        connection = NULL;
+        libdbo_configuration_list_free(configuration_list);
+        configuration_list = NULL;
+        return 1;
+    }
+    configuration_list = NULL;
+
+    if (libdbo_connection_setup(connection)
+        || libdbo_connection_connect(connection)
+        || __insert_test("test", 0)
+        || __insert_test("test2", 1))
+    {
+        libdbo_connection_free(connection);
+        connection = NULL;
+        return 1;
+    }
+
+    return 0;
+}
+
+int clean_suite_database_operations(void) {
+    test_free(test);
+    test = NULL;
+    test_list_free(test_list);
+    test_list = NULL;
+    test2_free(test2);
+    test2 = NULL;
+    test2_free(test2_2);
+    test2_2 = NULL;
+    libdbo_connection_free(connection);
+    connection = NULL;
+    libdbo_configuration_free(configuration);
+    configuration = NULL;
+    libdbo_configuration_list_free(configuration_list);
+    configuration_list = NULL;
+    libdbo_value_reset(&object2_id);
+    libdbo_value_reset(&object3_id);
+    return 0;
+}
+
+void __check_id(const libdbo_value_t* id, int id_int, const char* id_text) {
+    libdbo_type_int32_t int32;
+    libdbo_type_uint32_t uint32;
+    libdbo_type_int64_t int64;
+    libdbo_type_uint64_t uint64;
+    const char* text;
+
+    CU_ASSERT_PTR_NOT_NULL(id);
+    switch (libdbo_value_type(id)) {
+    case LIBDBO_TYPE_INT32:
+        CU_ASSERT(!libdbo_value_to_int32(id, &int32));
+        CU_ASSERT(int32 == (libdbo_type_int32_t)id_int);
+        break;
+
+    case LIBDBO_TYPE_UINT32:
+        CU_ASSERT(!libdbo_value_to_uint32(id, &uint32));
+        CU_ASSERT(uint32 == (libdbo_type_uint32_t)id_int);
+        break;
+
+    case LIBDBO_TYPE_INT64:
+        CU_ASSERT(!libdbo_value_to_int64(id, &int64));
+        CU_ASSERT(int64 == (libdbo_type_int64_t)id_int);
+        break;
+
+    case LIBDBO_TYPE_UINT64:
+        CU_ASSERT(!libdbo_value_to_uint64(id, &uint64));
+        CU_ASSERT(uint64 == (libdbo_type_uint64_t)id_int);
+        break;
+
+    case LIBDBO_TYPE_TEXT:
+        CU_ASSERT_PTR_NOT_NULL_FATAL((text = libdbo_value_text(id)));
+        CU_ASSERT(!strcmp(text, id_text));
+        break;
+
+    default:
+        CU_FAIL("libdbo_value_type(id)");
+    }
+}
+
+void test_database_operations_read_object1(void) {
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
+    CU_ASSERT_FATAL(!test_get_by_name(test, "test"));
+    __check_id(test_id(test), 1, "1");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(test_name(test));
+    CU_ASSERT(!strcmp(test_name(test), "test"));
+
+    test_free(test);
+    test = NULL;
+    CU_PASS("test_free");
+}
+
+void test_database_operations_create_object2(void) {
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
+    CU_ASSERT_FATAL(!test_set_name(test, "name 2"));
+    CU_ASSERT(!strcmp(test_name(test), "name 2"));
+    CU_ASSERT_FATAL(!test_create(test));
+
+    test_free(test);
+    test = NULL;
+    CU_PASS("test_free");
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
+    CU_ASSERT_FATAL(!test_get_by_name(test, "name 2"));
+    libdbo_value_reset(&object2_id);
+    CU_ASSERT(!libdbo_value_copy(&object2_id, test_id(test)));
+    CU_ASSERT(!strcmp(test_name(test), "name 2"));
+
+    test_free(test);
+    test = NULL;
+    CU_PASS("test_free");
+}
+
+void test_database_operations_read_object2(void) {
+    int cmp = 0;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
+    CU_ASSERT_FATAL(!test_get_by_id(test, &object2_id));
+    CU_ASSERT(!libdbo_value_cmp(test_id(test), &object2_id, &cmp));
+    CU_ASSERT(!cmp);
+    CU_ASSERT(!strcmp(test_name(test), "name 2"));
+
+    test_free(test);
+    test = NULL;
+    CU_PASS("test_free");
+}
+
+void test_database_operations_update_object2(void) {
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
+    CU_ASSERT_FATAL(!test_get_by_id(test, &object2_id));
+    CU_ASSERT_FATAL(!test_set_name(test, "name 3"));
+    CU_ASSERT(!strcmp(test_name(test), "name 3"));
+    CU_ASSERT_FATAL(!test_update(test));
+
+    test_free(test);
+    test = NULL;
+    CU_PASS("test_free");
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
+    CU_ASSERT_FATAL(!test_get_by_id(test, &object2_id));
+    CU_ASSERT(!strcmp(test_name(test), "name 3"));
+
+    test_free(test);
+    test = NULL;
+    CU_PASS("test_free");
+}
+
+void test_database_operations_delete_object2(void) {
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
     CU_ASSERT_FATAL(!test_get_by_id(test, &object2_id));
+    CU_ASSERT_FATAL(!test_delete(test));
+
+    test_free(test);
+    test = NULL;
+    CU_PASS("test_free");
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
+    CU_ASSERT_FATAL(test_get_by_id(test, &object2_id));
+
+    test_free(test);
+    test = NULL;
+    CU_PASS("test_free");
+}
+
+void test_database_operations_create_object3(void) {
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
     CU_ASSERT_FATAL(!test_set_name(test, "name 3"));
     CU_ASSERT(!strcmp(test_name(test), "name 3"));
-    CU_ASSERT_FATAL(!test_update(test));
+    CU_ASSERT_FATAL(!test_create(test));
+
+    test_free(test);
+    test = NULL;
+    CU_PASS("test_free");
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
+    CU_ASSERT_FATAL(!test_get_by_name(test, "name 3"));
+    libdbo_value_reset(&object3_id);
+    CU_ASSERT(!libdbo_value_copy(&object3_id, test_id(test)));
+    CU_ASSERT(!strcmp(test_name(test), "name 3"));
+
+    test_free(test);
+    test = NULL;
+    CU_PASS("test_free");
+}
+
+void test_database_operations_delete_object3(void) {
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
+    CU_ASSERT_FATAL(!test_get_by_id(test, &object3_id));
+    CU_ASSERT_FATAL(!test_delete(test));
+
+    test_free(test);
+    test = NULL;
+    CU_PASS("test_free");
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
+    CU_ASSERT_FATAL(test_get_by_id(test, &object3_id));
+
+    test_free(test);
+    test = NULL;
+    CU_PASS("test_free");
+}
+
+void test_database_operations_read_all(void) {
+    const test_t* local_test;
+    int count = 0;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test_list = test_list_new(connection)));
+    CU_ASSERT_FATAL(!test_list_get(test_list));
+    local_test = test_list_begin(test_list);
+    while (local_test) {
+        count++;
+        local_test = test_list_next(test_list);
+    }
+    CU_ASSERT(count == 3);
+
+    test_list_free(test_list);
+    test_list = NULL;
+    CU_PASS("test_list_free");
+}
+
+void test_database_operations_count(void) {
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
+    CU_ASSERT(test_count_by_name(test, "test") == 1);
+    CU_ASSERT(test_count_by_id(test, &object2_id) == 1);
+    CU_ASSERT(test_count_by_id(test, &object3_id) == 1);
+    CU_ASSERT(test_count_by_name(test, "name 3") == 2);
+    test_free(test);
+    test = NULL;
+    CU_PASS("test_free");
+}
+
+void test_database_operations_count_large_clause(void) {
+    libdbo_clause_list_t* clause_list;
+    libdbo_clause_t* clause;
+    char name[32];
+    size_t count = 0;
+    int i;
+
+    /*
+     * Build a clause list that generates SQL larger then any fixed size
+     * buffer, only the last clause will match an object.
+     */
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((clause_list = libdbo_clause_list_new()));
+    for (i = 0; i < 500; i++) {
+        CU_ASSERT_PTR_NOT_NULL_FATAL((clause = libdbo_clause_new()));
+        CU_ASSERT_FATAL(!libdbo_clause_set_field(clause, "name"));
+        CU_ASSERT_FATAL(!libdbo_clause_set_type(clause, LIBDBO_CLAUSE_EQUAL));
+        CU_ASSERT_FATAL(!libdbo_clause_set_operator(clause, LIBDBO_CLAUSE_OPERATOR_OR));
+        snprintf(name, sizeof(name), "no such name %d", i);
+        CU_ASSERT_FATAL(!libdbo_value_from_text(libdbo_clause_get_value(clause), i < 499 ? name : "test"));
+        CU_ASSERT_FATAL(!libdbo_clause_list_add(clause_list, clause));
+    }
+
+    CU_ASSERT(!libdbo_object_count(test->dbo, NULL, clause_list, &count));
+    CU_ASSERT(count == 1);
+
+    libdbo_clause_list_free(clause_list);
+    test_free(test);
+    test = NULL;
+    CU_PASS("test_free");
+}
+
+/*
+ * Add a clause on a field of the test object to a clause list, the value is
+ * a text if `text` is set otherwise a copy of `id`.
+ */
+static void __clause_add(libdbo_clause_list_t* clause_list, const char* field, libdbo_clause_type_t type, libdbo_clause_operator_t clause_operator, const char* text, const libdbo_value_t* id) {
+    libdbo_clause_t* clause;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((clause = libdbo_clause_new()));
+    CU_ASSERT_FATAL(!libdbo_clause_set_field(clause, field));
+    CU_ASSERT_FATAL(!libdbo_clause_set_type(clause, type));
+    CU_ASSERT_FATAL(!libdbo_clause_set_operator(clause, clause_operator));
+    if (text) {
+        CU_ASSERT_FATAL(!libdbo_value_from_text(libdbo_clause_get_value(clause), text));
+    }
+    else {
+        CU_ASSERT_FATAL(!libdbo_value_copy(libdbo_clause_get_value(clause), id));
+    }
+    CU_ASSERT_FATAL(!libdbo_clause_list_add(clause_list, clause));
+}
+
+/*
+ * Add a nested clause to a clause list, the ownership of the nested clause
+ * list is taken.
+ */
+static void __clause_add_nested(libdbo_clause_list_t* clause_list, libdbo_clause_operator_t clause_operator, libdbo_clause_list_t* nested) {
+    libdbo_clause_t* clause;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((clause = libdbo_clause_new()));
+    CU_ASSERT_FATAL(!libdbo_clause_set_type(clause, LIBDBO_CLAUSE_NESTED));
+    CU_ASSERT_FATAL(!libdbo_clause_set_operator(clause, clause_operator));
+    CU_ASSERT_FATAL(!libdbo_clause_set_list(clause, nested));
+    CU_ASSERT_FATAL(!libdbo_clause_list_add(clause_list, clause));
+}
+
+/*
+ * Count and read the test objects matching a clause list, both must find the
+ * expected number of objects. The clause list is freed.
+ */
+static void __clause_check(libdbo_clause_list_t* clause_list, size_t expected) {
+    libdbo_result_list_t* result_list;
+    size_t count = 0;
+
+    CU_ASSERT(!libdbo_object_count(test->dbo, NULL, clause_list, &count));
+    CU_ASSERT(count == expected);
+
+    count = 0;
+    CU_ASSERT_PTR_NOT_NULL((result_list = libdbo_object_read(test->dbo, NULL, clause_list)));
+    if (result_list) {
+        while (libdbo_result_list_next(result_list)) {
+            count++;
+        }
+        libdbo_result_list_free(result_list);
+    }
+    CU_ASSERT(count == expected);
+
+    libdbo_clause_list_free(clause_list);
+}
+
+void test_database_operations_clause_operators(void) {
+    libdbo_clause_list_t* clause_list;
+    libdbo_clause_list_t* nested;
+
+    /*
+     * The objects are "test", object 2 and object 3 both named "name 3". The
+     * operator of a clause joins it with the clause before it and AND binds
+     * harder then OR, the expected counts differ from evaluating the clauses
+     * from left to right.
+     */
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
+
+    /*
+     * name = "test" OR ( name = "name 3" AND id = object 2 )
+     */
+    CU_ASSERT_PTR_NOT_NULL_FATAL((clause_list = libdbo_clause_list_new()));
+    __clause_add(clause_list, "name", LIBDBO_CLAUSE_EQUAL, LIBDBO_CLAUSE_OPERATOR_AND, "test", NULL);
+    __clause_add(clause_list, "name", LIBDBO_CLAUSE_EQUAL, LIBDBO_CLAUSE_OPERATOR_OR, "name 3", NULL);
+    __clause_add(clause_list, "id", LIBDBO_CLAUSE_EQUAL, LIBDBO_CLAUSE_OPERATOR_AND, NULL, &object2_id);
+    __clause_check(clause_list, 2);
+
+    /*
+     * id = object 3 OR ( name = "name 3" AND name = "test" )
+     */
+    CU_ASSERT_PTR_NOT_NULL_FATAL((clause_list = libdbo_clause_list_new()));
+    __clause_add(clause_list, "id", LIBDBO_CLAUSE_EQUAL, LIBDBO_CLAUSE_OPERATOR_AND, NULL, &object3_id);
+    __clause_add(clause_list, "name", LIBDBO_CLAUSE_EQUAL, LIBDBO_CLAUSE_OPERATOR_OR, "name 3", NULL);
+    __clause_add(clause_list, "name", LIBDBO_CLAUSE_EQUAL, LIBDBO_CLAUSE_OPERATOR_AND, "test", NULL);
+    __clause_check(clause_list, 1);
+
+    /*
+     * name = "test" AND ( id = object 2 OR id = object 3 )
+     */
+    CU_ASSERT_PTR_NOT_NULL_FATAL((clause_list = libdbo_clause_list_new()));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((nested = libdbo_clause_list_new()));
+    __clause_add(nested, "id", LIBDBO_CLAUSE_EQUAL, LIBDBO_CLAUSE_OPERATOR_AND, NULL, &object2_id);
+    __clause_add(nested, "id", LIBDBO_CLAUSE_EQUAL, LIBDBO_CLAUSE_OPERATOR_OR, NULL, &object3_id);
+    __clause_add(clause_list, "name", LIBDBO_CLAUSE_EQUAL, LIBDBO_CLAUSE_OPERATOR_AND, "test", NULL);
+    __clause_add_nested(clause_list, LIBDBO_CLAUSE_OPERATOR_AND, nested);
+    __clause_check(clause_list, 0);
+
+    /*
+     * name = "name 3" AND ( id = object 2 OR name = "test" )
+     */
+    CU_ASSERT_PTR_NOT_NULL_FATAL((clause_list = libdbo_clause_list_new()));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((nested = libdbo_clause_list_new()));
+    __clause_add(nested, "id", LIBDBO_CLAUSE_EQUAL, LIBDBO_CLAUSE_OPERATOR_AND, NULL, &object2_id);
+    __clause_add(nested, "name", LIBDBO_CLAUSE_EQUAL, LIBDBO_CLAUSE_OPERATOR_OR, "test", NULL);
+    __clause_add(clause_list, "name", LIBDBO_CLAUSE_EQUAL, LIBDBO_CLAUSE_OPERATOR_AND, "name 3", NULL);
+    __clause_add_nested(clause_list, LIBDBO_CLAUSE_OPERATOR_AND, nested);
+    __clause_check(clause_list, 1);
+
+    /*
+     * ( name = "name 3" AND id != object 2 ) OR name = "test"
+     */
+    CU_ASSERT_PTR_NOT_NULL_FATAL((clause_list = libdbo_clause_list_new()));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((nested = libdbo_clause_list_new()));
+    __clause_add(nested, "name", LIBDBO_CLAUSE_EQUAL, LIBDBO_CLAUSE_OPERATOR_AND, "name 3", NULL);
+    __clause_add(nested, "id", LIBDBO_CLAUSE_NOT_EQUAL, LIBDBO_CLAUSE_OPERATOR_AND, NULL, &object2_id);
+    __clause_add_nested(clause_list, LIBDBO_CLAUSE_OPERATOR_AND, nested);
+    __clause_add(clause_list, "name", LIBDBO_CLAUSE_EQUAL, LIBDBO_CLAUSE_OPERATOR_OR, "test", NULL);
+    __clause_check(clause_list, 2);
+
+    test_free(test);
+    test = NULL;
+    CU_PASS("test_free");
+}
+
+void test_database_operations_read_batch(void) {
+    libdbo_clause_list_t* clause_list;
+    libdbo_clause_t* clause;
+    const libdbo_object_t* objects[2];
+    const libdbo_clause_list_t* clause_lists[2];
+    libdbo_result_list_t* result_lists[2];
+    int count[2] = { 0, 0 };
+    size_t i;
+
+    /*
+     * Read all objects and the objects named "name 3" in one batch.
+     */
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((clause_list = libdbo_clause_list_new()));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((clause = libdbo_clause_new()));
+    CU_ASSERT_FATAL(!libdbo_clause_set_field(clause, "name"));
+    CU_ASSERT_FATAL(!libdbo_clause_set_type(clause, LIBDBO_CLAUSE_EQUAL));
+    CU_ASSERT_FATAL(!libdbo_value_from_text(libdbo_clause_get_value(clause), "name 3"));
+    CU_ASSERT_FATAL(!libdbo_clause_list_add(clause_list, clause));
+
+    objects[0] = test->dbo;
+    objects[1] = test->dbo;
+    clause_lists[0] = NULL;
+    clause_lists[1] = clause_list;
+    CU_ASSERT_FATAL(!libdbo_connection_read_batch(connection, 2, objects, NULL, clause_lists, result_lists));
+    for (i = 0; i < 2; i++) {
+        CU_ASSERT_PTR_NOT_NULL_FATAL(result_lists[i]);
+        while (libdbo_result_list_next(result_lists[i])) {
+            count[i]++;
+        }
+        libdbo_result_list_free(result_lists[i]);
+    }
+    CU_ASSERT(count[0] == 3);
+    CU_ASSERT(count[1] == 2);
+
+    libdbo_clause_list_free(clause_list);
+    test_free(test);
+    test = NULL;
+    CU_PASS("test_free");
+}
+
+void test_database_operations_read_object1_2(void) {
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
+    CU_ASSERT_FATAL(!test2_get_by_name(test2, "test"));
+    __check_id(test2_id(test2), 1, "1");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(test2_name(test2));
+    CU_ASSERT(!strcmp(test2_name(test2), "test"));
+
+    test2_free(test2);
+    test2 = NULL;
+    CU_PASS("test2_free");
+}
+
+void test_database_operations_create_object2_2(void) {
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
+    CU_ASSERT_FATAL(!test2_set_name(test2, "name 2"));
+    CU_ASSERT(!strcmp(test2_name(test2), "name 2"));
+    CU_ASSERT_FATAL(!test2_create(test2));
+
+    test2_free(test2);
+    test2 = NULL;
+    CU_PASS("test2_free");
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
+    CU_ASSERT_FATAL(!test2_get_by_name(test2, "name 2"));
+    libdbo_value_reset(&object2_id);
+    CU_ASSERT(!libdbo_value_copy(&object2_id, test2_id(test2)));
+    CU_ASSERT(!strcmp(test2_name(test2), "name 2"));
+
+    test2_free(test2);
+    test2 = NULL;
+    CU_PASS("test2_free");
+}
+
+void test_database_operations_read_object2_2(void) {
+    int cmp = 0;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
+    CU_ASSERT_FATAL(!test2_get_by_id(test2, &object2_id));
+    CU_ASSERT(!libdbo_value_cmp(test2_id(test2), &object2_id, &cmp));
+    CU_ASSERT(!cmp);
+    CU_ASSERT(!strcmp(test2_name(test2), "name 2"));
+
+    test2_free(test2);
+    test2 = NULL;
+    CU_PASS("test2_free");
+}
+
+void test_database_operations_update_object2_2(void) {
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
+    CU_ASSERT_FATAL(!test2_get_by_id(test2, &object2_id));
+    CU_ASSERT_FATAL(!test2_set_name(test2, "name 3"));
+    CU_ASSERT(!strcmp(test2_name(test2), "name 3"));
+    CU_ASSERT_FATAL(!test2_update(test2));
+
+    test2_free(test2);
+    test2 = NULL;
+    CU_PASS("test2_free");
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
+    CU_ASSERT_FATAL(!test2_get_by_id(test2, &object2_id));
+    CU_ASSERT(!strcmp(test2_name(test2), "name 3"));
+
+    test2_free(test2);
+    test2 = NULL;
+    CU_PASS("test2_free");
+}
+
+void test_database_operations_update_objects_revisions(void) {
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
+    CU_ASSERT_FATAL(!test2_set_name(test2, "name 4"));
+    CU_ASSERT(!strcmp(test2_name(test2), "name 4"));
+    CU_ASSERT_FATAL(!test2_create(test2));
+
+    test2_free(test2);
+    test2 = NULL;
+    CU_PASS("test2_free");
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
+    CU_ASSERT_FATAL(!test2_get_by_name(test2, "name 4"));
+    CU_ASSERT(!strcmp(test2_name(test2), "name 4"));
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2_2 = test2_new(connection)));
+    CU_ASSERT_FATAL(!test2_get_by_name(test2_2, "name 4"));
+    CU_ASSERT(!strcmp(test2_name(test2_2), "name 4"));
+
+    CU_ASSERT_FATAL(!test2_set_name(test2_2, "name 5"));
+    CU_ASSERT(!strcmp(test2_name(test2_2), "name 5"));
+    CU_ASSERT_FATAL(!test2_update(test2_2));
+
+    CU_ASSERT_FATAL(!test2_set_name(test2, "name 5"));
+    CU_ASSERT(!strcmp(test2_name(test2), "name 5"));
+    CU_ASSERT_FATAL(test2_update(test2));
+
+    test2_free(test2);
+    test2 = NULL;
+    CU_PASS("test2_free");
+
+    test2_free(test2_2);
+    test2_2 = NULL;
+    CU_PASS("test2_free");
+}
+
+static int __retry_fetch(void* object, const libdbo_value_t* id) {
+    return test2_get_by_id((test2_t*)object, id);
+}
+
+/*
+ * Update the name of test2 and, while attempts are left in `conflicts`, let
+ * test2_2 change the object first so that the update conflicts.
+ */
+static int __retry_update(void* object, void* user_data, unsigned int attempt) {
+    int* conflicts = (int*)user_data;
+
+    if (*conflicts) {
+        (*conflicts)--;
+        CU_ASSERT_FATAL(!test2_get_by_id(test2_2, test2_id((test2_t*)object)));
+        CU_ASSERT_FATAL(!test2_set_name(test2_2, attempt ? "name retry 3" : "name retry 2"));
+        CU_ASSERT_FATAL(!test2_update(test2_2));
+    }
+
+    CU_ASSERT_FATAL(!test2_set_name((test2_t*)object, "name retry 4"));
+    return test2_update((test2_t*)object);
+}
+
+void test_database_operations_update_retry(void) {
+    libdbo_retry_t* retry;
+    libdbo_retry_stats_t stats;
+    int conflicts;
+
+    CU_ASSERT_PTR_NULL(libdbo_retry_new(0, 0, 0));
+    CU_ASSERT_PTR_NULL(libdbo_retry_new(1, 2, 1));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((retry = libdbo_retry_new(3, 1, 2)));
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
+    CU_ASSERT_FATAL(!test2_set_name(test2, "name retry 1"));
+    CU_ASSERT_FATAL(!test2_create(test2));
+    CU_ASSERT_FATAL(!test2_get_by_name(test2, "name retry 1"));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2_2 = test2_new(connection)));
+
+    /*
+     * Two conflicts and then a successful update on the last attempt.
+     */
+    conflicts = 2;
+    CU_ASSERT(libdbo_retry_update(retry, test2, test2_id(test2), __retry_fetch, __retry_update, &conflicts) == LIBDBO_OK);
+    CU_ASSERT(!conflicts);
+    CU_ASSERT_FATAL(!test2_get_by_id(test2_2, test2_id(test2)));
+    CU_ASSERT(!strcmp(test2_name(test2_2), "name retry 4"));
+
+    CU_ASSERT(!libdbo_retry_stats(retry, &stats));
+    CU_ASSERT(stats.calls == 1);
+    CU_ASSERT(stats.successes == 1);
+    CU_ASSERT(stats.failures == 0);
+    CU_ASSERT(stats.conflicts == 2);
+    CU_ASSERT(stats.retries == 2);
+    CU_ASSERT(stats.exhausted == 0);
+    CU_ASSERT(stats.sleep_usec <= 3000);
+
+    /*
+     * Conflicts on every attempt exhaust the retries.
+     */
+    conflicts = 3;
+    CU_ASSERT(libdbo_retry_update(retry, test2, test2_id(test2), __retry_fetch, __retry_update, &conflicts) == LIBDBO_ERROR_REVISION);
+    CU_ASSERT(!conflicts);
+
+    CU_ASSERT(!libdbo_retry_stats(retry, &stats));
+    CU_ASSERT(stats.calls == 2);
+    CU_ASSERT(stats.successes == 1);
+    CU_ASSERT(stats.conflicts == 5);
+    CU_ASSERT(stats.retries == 4);
+    CU_ASSERT(stats.exhausted == 1);
+
+    CU_ASSERT_FATAL(!test2_get_by_id(test2, test2_id(test2)));
+    CU_ASSERT_FATAL(!test2_delete(test2));
+
+    test2_free(test2);
+    test2 = NULL;
+    CU_PASS("test2_free");
+
+    test2_free(test2_2);
+    test2_2 = NULL;
+    CU_PASS("test2_free");
+
+    libdbo_retry_free(retry);
+}
+
+static void __stats_foreach(const char* table, libdbo_stats_operation_t operation, const libdbo_stats_counters_t* counters, void* user_data) {
+    if (!strcmp(table, "test2") && operation == LIBDBO_STATS_UPDATE) {
+        *(unsigned long*)user_data += counters->calls;
+    }
+}
+
+typedef struct {
+    unsigned long calls;
+    unsigned long long rows;
+} stats_shape_t;
+
+static void __stats_shape_foreach(const char* table, const char* shape, unsigned long calls, unsigned long long rows, void* user_data) {
+    if (!strcmp(table, "test2") && !strcmp(shape, "name=")) {
+        ((stats_shape_t*)user_data)->calls += calls;
+        ((stats_shape_t*)user_data)->rows += rows;
+    }
+}
+
+void test_database_operations_stats(void) {
+    libdbo_stats_t* stats;
+    libdbo_stats_counters_t counters;
+    unsigned long updates = 0;
+    stats_shape_t shape;
+    FILE* file;
+    char line[128];
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((stats = libdbo_connection_stats(connection)));
+    libdbo_stats_reset(stats);
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
+    CU_ASSERT_FATAL(!test2_set_name(test2, "name stats"));
+    CU_ASSERT_FATAL(!test2_create(test2));
+    CU_ASSERT_FATAL(!test2_get_by_name(test2, "name stats"));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2_2 = test2_new(connection)));
+    CU_ASSERT_FATAL(!test2_get_by_name(test2_2, "name stats"));
+
+    CU_ASSERT(!libdbo_stats_operation(stats, LIBDBO_STATS_CREATE, &counters));
+    CU_ASSERT(counters.calls == 1);
+    CU_ASSERT(counters.errors == 0);
+    CU_ASSERT(counters.total_usec == counters.max_usec);
+    CU_ASSERT(libdbo_stats_histogram_count(&(counters.latency)) == 1);
+    CU_ASSERT(libdbo_stats_histogram_percentile(&(counters.latency), 100) >= counters.max_usec);
+    CU_ASSERT(libdbo_stats_histogram_percentile(&(counters.latency), 100) <= counters.max_usec + counters.max_usec / 16);
+
+    /*
+     * Both reads have finished walking their result lists so the rows and
+     * text are counted even if the backend fetches them as they are walked.
+     */
+    CU_ASSERT(!libdbo_stats_table(stats, "test2", LIBDBO_STATS_READ, &counters));
+    CU_ASSERT(counters.calls == 2);
+    CU_ASSERT(counters.errors == 0);
+    CU_ASSERT(counters.rows == 2);
+    CU_ASSERT(counters.text_bytes == 2 * strlen("name stats"));
+    CU_ASSERT(!libdbo_stats_table(stats, "no_such_table", LIBDBO_STATS_READ, &counters));
+    CU_ASSERT(counters.calls == 0);
+
+    memset(&shape, 0, sizeof(shape));
+    CU_ASSERT(!libdbo_stats_shape_foreach(stats, __stats_shape_foreach, &shape));
+    CU_ASSERT(shape.calls == 2);
+    CU_ASSERT(shape.rows == 2);
+    remove("test.shapes");
+    CU_ASSERT(!libdbo_stats_write_shapes(stats, "test.shapes"));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((file = fopen("test.shapes", "r")));
+    CU_ASSERT_PTR_NOT_NULL(fgets(line, sizeof(line), file));
+    CU_ASSERT(!strcmp(line, "test2\tname=\t2\t2\n"));
+    fclose(file);
+    remove("test.shapes");
+
+    CU_ASSERT_FATAL(!test2_set_name(test2_2, "name stats 2"));
+    CU_ASSERT_FATAL(!test2_update(test2_2));
+    CU_ASSERT_FATAL(!test2_set_name(test2, "name stats 3"));
+    CU_ASSERT_FATAL(test2_update(test2));
+
+    CU_ASSERT(!libdbo_stats_operation(stats, LIBDBO_STATS_UPDATE, &counters));
+    CU_ASSERT(counters.calls == 2);
+    CU_ASSERT(counters.errors == 1);
+    CU_ASSERT(libdbo_stats_histogram_percentile(&(counters.latency), 50) <= libdbo_stats_histogram_percentile(&(counters.latency), 100));
+    CU_ASSERT(!libdbo_stats_foreach(stats, __stats_foreach, &updates));
+    CU_ASSERT(updates == 2);
+    CU_ASSERT(!strcmp(libdbo_stats_operation_name(LIBDBO_STATS_UPDATE), "update"));
+    CU_ASSERT_PTR_NULL(libdbo_stats_operation_name(LIBDBO_STATS_OPERATIONS));
+
+    libdbo_stats_reset(stats);
+    CU_ASSERT(!libdbo_stats_operation(stats, LIBDBO_STATS_UPDATE, &counters));
+    CU_ASSERT(counters.calls == 0);
+    CU_ASSERT(libdbo_stats_histogram_count(&(counters.latency)) == 0);
+    CU_ASSERT(libdbo_stats_histogram_percentile(&(counters.latency), 50) == 0);
+    CU_ASSERT(!libdbo_stats_table(stats, "test2", LIBDBO_STATS_READ, &counters));
+    CU_ASSERT(counters.rows == 0);
+    memset(&shape, 0, sizeof(shape));
+    CU_ASSERT(!libdbo_stats_shape_foreach(stats, __stats_shape_foreach, &shape));
+    CU_ASSERT(shape.calls == 0);
+
+    CU_ASSERT_FATAL(!test2_get_by_id(test2_2, test2_id(test2)));
+    CU_ASSERT_FATAL(!test2_delete(test2_2));
+
+    test2_free(test2);
+    test2 = NULL;
+    CU_PASS("test2_free");
+
+    test2_free(test2_2);
+    test2_2 = NULL;
+    CU_PASS("test2_free");
+}
+
+typedef struct {
+    int begins;
+    int ends;
+    int creates;
+    int unmatched;
+} trace_t;
+
+static void __trace_hook(libdbo_trace_phase_t phase, libdbo_trace_event_t* event, void* user_data) {
+    trace_t* trace = (trace_t*)user_data;
+
+    if (phase == LIBDBO_TRACE_BEGIN) {
+        trace->begins++;
+        event->hook_data = trace;
+        return;
+    }
+
+    trace->ends++;
+    if (event->hook_data != trace) {
+        trace->unmatched++;
+    }
+    if (event->operation == LIBDBO_STATS_CREATE
+        && event->status == LIBDBO_OK
+        && event->backend
+        && event->table && !strcmp(event->table, "test2")
+        && event->statement)
+    {
+        trace->creates++;
+    }
+}
+
+void test_database_operations_trace(void) {
+    trace_t trace;
+
+    memset(&trace, 0, sizeof(trace));
+    libdbo_trace_set_hook(__trace_hook, &trace);
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
+    CU_ASSERT(!test2_set_name(test2, "name trace"));
+    CU_ASSERT(!test2_create(test2));
+    CU_ASSERT(!test2_get_by_name(test2, "name trace"));
+    CU_ASSERT(!test2_delete(test2));
+    libdbo_trace_set_hook(NULL, NULL);
+
+    test2_free(test2);
+    test2 = NULL;
+    CU_PASS("test2_free");
+
+    /*
+     * Only the backends that execute statements in a database call the hook,
+     * if they do the create must have been traced once.
+     */
+    CU_ASSERT(trace.begins == trace.ends);
+    CU_ASSERT(trace.unmatched == 0);
+#if defined(USE_LIBDBO_TRACE)
+    CU_ASSERT(!trace.ends || trace.creates == 1);
+#else
+    CU_ASSERT(trace.ends == 0);
+#endif
+}
+
+static int __slow_queries = 0;
+static int __slow_query_values = 0;
+static int __slow_query_plans = 0;
+
+static void __slow_query_log_handler(libdbo_log_priority_t priority, const char* format, va_list ap) {
+    char message[4096];
+
+    vsnprintf(message, sizeof(message), format, ap);
+    if (priority != LIBDBO_LOG_WARNING) {
+        return;
+    }
+    if (strstr(message, "slow query plan: ")) {
+        __slow_query_plans++;
+    }
+    else if (strstr(message, "slow query ")) {
+        __slow_queries++;
+        if (strstr(message, "name slow")) {
+            __slow_query_values++;
+        }
+    }
+}
+
+static void __test_log_handler(libdbo_log_priority_t priority, const char* format, va_list ap) {
+    vprintf(format, ap);
+    printf("\n");
+}
+
+static libdbo_connection_t* __slow_query_connection(const char* redact) {
+    libdbo_configuration_list_t* configuration_list;
+    libdbo_configuration_t* configuration;
+    libdbo_connection_t* connection;
+    const char* settings[] = {
+        "backend", "sqlite",
+        "file", "test.db",
+        "slow_query", "0.001",
+        "slow_query_redact", redact,
+        NULL
+    };
+    int i;
+
+    if (!(configuration_list = libdbo_configuration_list_new())) {
+        return NULL;
+    }
+    for (i = 0; settings[i]; i += 2) {
+        if (!(configuration = libdbo_configuration_new())
+            || libdbo_configuration_set_name(configuration, settings[i])
+            || libdbo_configuration_set_value(configuration, settings[i + 1])
+            || libdbo_configuration_list_add(configuration_list, configuration))
+        {
+            libdbo_configuration_free(configuration);
+            libdbo_configuration_list_free(configuration_list);
+            return NULL;
+        }
+    }
+
+    if (!(connection = libdbo_connection_new())
+        || libdbo_connection_set_configuration_list(connection, configuration_list))
+    {
+        libdbo_connection_free(connection);
+        libdbo_configuration_list_free(configuration_list);
+        return NULL;
+    }
+    if (libdbo_connection_setup(connection)
+        || libdbo_connection_connect(connection))
+    {
+        libdbo_connection_free(connection);
+        return NULL;
+    }
+    return connection;
+}
+
+void test_database_operations_slow_query(void) {
+    libdbo_connection_t* slow_connection;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
+    CU_ASSERT_FATAL(!test2_set_name(test2, "name slow"));
+    CU_ASSERT_FATAL(!test2_create(test2));
+    test2_free(test2);
+    test2 = NULL;
+
+    /*
+     * Every step is slower than the threshold so the read is logged with the
+     * value it was done with and its query plan.
+     */
+    CU_ASSERT_PTR_NOT_NULL_FATAL((slow_connection = __slow_query_connection("0")));
+    CU_ASSERT_FATAL(!libdbo_log_set_handler(__slow_query_log_handler));
+    CU_ASSERT_PTR_NOT_NULL((test2 = test2_new(slow_connection)));
+    CU_ASSERT(!test2_get_by_name(test2, "name slow"));
+    CU_ASSERT(!libdbo_log_set_handler(__test_log_handler));
+    test2_free(test2);
+    test2 = NULL;
+    libdbo_connection_free(slow_connection);
+    CU_ASSERT(__slow_queries > 0);
+    CU_ASSERT(__slow_query_values > 0);
+    CU_ASSERT(__slow_query_plans > 0);
+
+    __slow_queries = 0;
+    __slow_query_values = 0;
+    __slow_query_plans = 0;
+    CU_ASSERT_PTR_NOT_NULL_FATAL((slow_connection = __slow_query_connection("1")));
+    CU_ASSERT_FATAL(!libdbo_log_set_handler(__slow_query_log_handler));
+    CU_ASSERT_PTR_NOT_NULL((test2 = test2_new(slow_connection)));
+    CU_ASSERT(!test2_get_by_name(test2, "name slow"));
+    CU_ASSERT(!test2_delete(test2));
+    CU_ASSERT(!libdbo_log_set_handler(__test_log_handler));
+    test2_free(test2);
+    test2 = NULL;
+    libdbo_connection_free(slow_connection);
+    CU_ASSERT(__slow_queries > 0);
+    CU_ASSERT(__slow_query_values == 0);
+    CU_ASSERT(__slow_query_plans > 0);
+}
+
+#if defined(HAVE_POSTGRESQL)
+static libdbo_connection_t* __pipeline_connection(void) {
+    libdbo_configuration_list_t* configuration_list;
+    libdbo_configuration_t* configuration;
+    libdbo_connection_t* connection;
+    const char* settings[] = {
+        "backend", "postgresql",
+        "host", TEST_POSTGRESQL_HOST,
+        "port", TEST_POSTGRESQL_PORT_TXT,
+        "user", TEST_POSTGRESQL_USER,
+        "pass", TEST_POSTGRESQL_PASS,
+        "db", TEST_POSTGRESQL_DB,
+        "pipeline", "1",
+        NULL
+    };
+    int i;
+
+    if (!(configuration_list = libdbo_configuration_list_new())) {
+        return NULL;
+    }
+    for (i = 0; settings[i]; i += 2) {
+        if (!(configuration = libdbo_configuration_new())
+            || libdbo_configuration_set_name(configuration, settings[i])
+            || libdbo_configuration_set_value(configuration, settings[i + 1])
+            || libdbo_configuration_list_add(configuration_list, configuration))
+        {
+            libdbo_configuration_free(configuration);
+            libdbo_configuration_list_free(configuration_list);
+            return NULL;
+        }
+    }
+
+    if (!(connection = libdbo_connection_new())
+        || libdbo_connection_set_configuration_list(connection, configuration_list))
+    {
+        libdbo_connection_free(connection);
+        libdbo_configuration_list_free(configuration_list);
+        return NULL;
+    }
+    if (libdbo_connection_setup(connection)
+        || libdbo_connection_connect(connection))
+    {
+        libdbo_connection_free(connection);
+        return NULL;
+    }
+    return connection;
+}
+#endif
+
+void test_database_operations_pipeline(void) {
+#if defined(HAVE_POSTGRESQL)
+    libdbo_connection_t* pipeline_connection;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((pipeline_connection = __pipeline_connection()));
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(pipeline_connection)));
+    CU_ASSERT_FATAL(!test2_set_name(test2, "name pipeline"));
+    CU_ASSERT_FATAL(!test2_create(test2));
+    test2_free(test2);
+    test2 = NULL;
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(pipeline_connection)));
+    CU_ASSERT_FATAL(!test2_set_name(test2, "name pipeline 2"));
+    CU_ASSERT_FATAL(!test2_create(test2));
+    test2_free(test2);
+    test2 = NULL;
+
+    /*
+     * Update the object outside of the transaction so the pipelined update
+     * has an old revision.
+     */
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(pipeline_connection)));
+    CU_ASSERT_FATAL(!test2_get_by_name(test2, "name pipeline"));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2_2 = test2_new(pipeline_connection)));
+    CU_ASSERT_FATAL(!test2_get_by_name(test2_2, "name pipeline"));
+    CU_ASSERT_FATAL(!test2_set_name(test2_2, "name pipeline 3"));
+    CU_ASSERT_FATAL(!test2_update(test2_2));
+    test2_free(test2_2);
+    test2_2 = NULL;
+
+    /*
+     * The conflict is only seen when the pipeline is flushed by the commit,
+     * which fails with LIBDBO_ERROR_REVISION. The update sent after it is
+     * aborted and its result must also be collected for the connection to
+     * leave pipeline mode.
+     */
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2_2 = test2_new(pipeline_connection)));
+    CU_ASSERT_FATAL(!test2_get_by_name(test2_2, "name pipeline 2"));
+    CU_ASSERT_FATAL(!libdbo_connection_transaction_begin(pipeline_connection));
+    CU_ASSERT_FATAL(!test2_set_name(test2, "name pipeline 4"));
+    CU_ASSERT(!test2_update(test2));
+    CU_ASSERT_FATAL(!test2_set_name(test2_2, "name pipeline 5"));
+    CU_ASSERT(!test2_update(test2_2));
+    CU_ASSERT(libdbo_connection_transaction_commit(pipeline_connection) == LIBDBO_ERROR_REVISION);
+    CU_ASSERT(!libdbo_connection_transaction_rollback(pipeline_connection));
+    test2_free(test2);
+    test2 = NULL;
+    test2_free(test2_2);
+    test2_2 = NULL;
+
+    /*
+     * The connection is usable again and nothing from the transaction was
+     * committed.
+     */
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(pipeline_connection)));
+    CU_ASSERT(test2_get_by_name(test2, "name pipeline 4"));
+    CU_ASSERT_FATAL(!test2_get_by_name(test2, "name pipeline 3"));
+    CU_ASSERT(!test2_delete(test2));
+    test2_free(test2);
+    test2 = NULL;
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(pipeline_connection)));
+    CU_ASSERT_FATAL(!test2_get_by_name(test2, "name pipeline 2"));
+    CU_ASSERT(!test2_delete(test2));
+    test2_free(test2);
+    test2 = NULL;
+
+    libdbo_connection_free(pipeline_connection);
+#endif
+}
+
+#if defined(HAVE_COUCHDB)
+/*
+ * A HTTP server answering the view requests of the CouchDB backend with
+ * STREAM_ROWS rows, sent in small pieces so the response comes in many
+ * chunks. The table of the view decides how the response ends,
+ * stream_partial closes the connection after half of the response given by
+ * its Content-Length, stream_truncated does the same without a
+ * Content-Length and stream_invalid has a row that is not JSON in the middle.
+ * stream_stall sends half of the response and then waits for the client to
+ * close the connection, stream_slow waits a second in the middle of the
+ * response. stream_large has STREAM_LARGE_ROWS rows, more than fits in the
+ * socket buffers, and counts the responses that were sent in full.
+ */
+#define STREAM_ROWS 5000
+#define STREAM_LARGE_ROWS 100000
+
+static int __stream_socket = -1;
+static pthread_t __stream_thread;
+static pthread_mutex_t __stream_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t __stream_cond = PTHREAD_COND_INITIALIZER;
+static int __stream_connections = 0;
+static int __stream_errors = 0;
+static int __stream_large_sent = 0;
+static char __stream_url[64];
+
+static char* __stream_body(const char* table, size_t* length) {
+    char* body;
+    char* bodyp;
+    int rows = strcmp(table, "stream_large") ? STREAM_ROWS : STREAM_LARGE_ROWS;
+    int i;
+
+    if (!(body = malloc(64 + rows * 256))) {
+        return NULL;
+    }
+    bodyp = body;
+    bodyp += sprintf(bodyp, "{\"total_rows\":%d,\"offset\":0,\"rows\":[\r\n", rows);
+    for (i = 0; i < rows; i++) {
+        if (i == STREAM_ROWS / 2 && !strcmp(table, "stream_invalid")) {
+            bodyp += sprintf(bodyp, "{\"id\":\"%d\",\"doc\":{\"_id\":\"%d\",\"_rev\":invalid}},\r\n", i, i);
+            continue;
+        }
+        bodyp += sprintf(bodyp, "{\"id\":\"%d\",\"key\":null,\"value\":null,\"doc\":{\"_id\":\"%d\",\"_rev\":\"1-%d\",\"type\":\"%s\",\"%s_name\":\"name %d\"}}%s\r\n",
+            i, i, i, table, table, i, i + 1 < rows ? "," : "");
+    }
+    bodyp += sprintf(bodyp, "]}\n");
+    *length = bodyp - body;
+    return body;
+}
+
+static int __stream_send(int fd, const char* data, size_t length) {
+    ssize_t sent;
+
+    while (length) {
+        if ((sent = send(fd, data, length, MSG_NOSIGNAL)) < 1) {
+            return 1;
+        }
+        data += sent;
+        length -= sent;
+    }
+    return 0;
+}
+
+static void* __stream_serve(void* data) {
+    int fd = (int)(intptr_t)data;
+    char request[4096];
+    char header[256];
+    char table[64];
+    const char* view;
+    char* body = NULL;
+    size_t length = 0, size = 0, position;
+    ssize_t received;
+
+    request[0] = 0;
+    while (!strstr(request, "\r\n\r\n") && length < sizeof(request) - 1) {
+        if ((received = recv(fd, request + length, sizeof(request) - 1 - length, 0)) < 1) {
+            break;
+        }
+        length += received;
+        request[length] = 0;
+    }
+
+    if ((view = strstr(request, "/_view/"))
+        && sscanf(view, "/_view/%63[a-z_]", table) == 1
+        && (body = __stream_body(table, &size)))
+    {
+        if (!strcmp(table, "stream_truncated")) {
+            snprintf(header, sizeof(header), "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nConnection: close\r\n\r\n");
+            size /= 2;
+        }
+        else {
+            snprintf(header, sizeof(header), "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: %lu\r\nConnection: close\r\n\r\n", (unsigned long)size);
+            if (!strcmp(table, "stream_partial") || !strcmp(table, "stream_stall")) {
+                size /= 2;
+            }
+        }
+        if (!__stream_send(fd, header, strlen(header))) {
+            for (position = 0; position < size; position += 1024) {
+                if (position == size / 2 / 1024 * 1024 && !strcmp(table, "stream_slow")) {
+                    sleep(1);
+                }
+                if (__stream_send(fd, body + position, size - position < 1024 ? size - position : 1024)) {
+                    break;
+                }
+            }
+            if (!strcmp(table, "stream_stall")) {
+                while (recv(fd, request, sizeof(request), 0) > 0);
+            }
+            else if (position >= size && !strcmp(table, "stream_large")) {
+                pthread_mutex_lock(&__stream_lock);
+                __stream_large_sent++;
+                pthread_mutex_unlock(&__stream_lock);
+            }
+        }
+    }
+    else {
+        snprintf(header, sizeof(header), "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+        __stream_send(fd, header, strlen(header));
+    }
+    free(body);
+    close(fd);
+
+    pthread_mutex_lock(&__stream_lock);
+    __stream_connections--;
+    pthread_cond_signal(&__stream_cond);
+    pthread_mutex_unlock(&__stream_lock);
+    return NULL;
+}
+
+static void* __stream_server(void* data) {
+    pthread_t thread;
+    int fd;
+
+    /*
+     * Each connection has its own thread so that a client not reading one
+     * response does not stop the others.
+     */
+    while ((fd = accept(__stream_socket, NULL, NULL)) >= 0) {
+        pthread_mutex_lock(&__stream_lock);
+        __stream_connections++;
+        pthread_mutex_unlock(&__stream_lock);
+        if (pthread_create(&thread, NULL, __stream_serve, (void*)(intptr_t)fd)) {
+            close(fd);
+            pthread_mutex_lock(&__stream_lock);
+            __stream_connections--;
+            pthread_mutex_unlock(&__stream_lock);
+            continue;
+        }
+        pthread_detach(thread);
+    }
+    return NULL;
+}
+
+static void __stream_log_handler(libdbo_log_priority_t priority, const char* format, va_list ap) {
+    if (priority == LIBDBO_LOG_ERROR && !strncmp(format, "CouchDB stream", 14)) {
+        __stream_errors++;
+    }
+    __test_log_handler(priority, format, ap);
+}
+
+static libdbo_connection_t* __stream_connect(void) {
+    libdbo_configuration_list_t* configuration_list;
+    libdbo_configuration_t* configuration;
+    libdbo_connection_t* connection;
+    const char* settings[] = {
+        "backend", "couchdb",
+        "url", __stream_url,
+        NULL
+    };
+    int i;
+
+    if (!(configuration_list = libdbo_configuration_list_new())) {
+        return NULL;
+    }
+    for (i = 0; settings[i]; i += 2) {
+        if (!(configuration = libdbo_configuration_new())
+            || libdbo_configuration_set_name(configuration, settings[i])
+            || libdbo_configuration_set_value(configuration, settings[i + 1])
+            || libdbo_configuration_list_add(configuration_list, configuration))
+        {
+            libdbo_configuration_free(configuration);
+            libdbo_configuration_list_free(configuration_list);
+            return NULL;
+        }
+    }
+
+    if (!(connection = libdbo_connection_new())
+        || libdbo_connection_set_configuration_list(connection, configuration_list))
+    {
+        libdbo_connection_free(connection);
+        libdbo_configuration_list_free(configuration_list);
+        return NULL;
+    }
+    if (libdbo_connection_setup(connection)
+        || libdbo_connection_connect(connection))
+    {
+        libdbo_connection_free(connection);
+        return NULL;
+    }
+    return connection;
+}
+
+/*
+ * Walk a result list of the streaming server, the rows must come in order.
+ */
+static int __stream_walk(libdbo_result_list_t* result_list) {
+    const libdbo_result_t* result;
+    const char* text;
+    char name[32];
+    int count = 0;
+
+    while ((result = libdbo_result_list_next(result_list))) {
+        snprintf(name, sizeof(name), "name %d", count);
+        CU_ASSERT_PTR_NOT_NULL_FATAL((text = libdbo_value_text(libdbo_value_set_at(libdbo_result_value_set(result), 1))));
+        CU_ASSERT(!strcmp(text, name));
+        count++;
+    }
+    return count;
+}
+#endif
+
+int init_suite_database_operations_couchdb_stream(void) {
+#if defined(HAVE_COUCHDB)
+    struct sockaddr_in address;
+    socklen_t address_length = sizeof(address);
+
+    if (connection) {
+        return 1;
+    }
+    if (__stream_socket != -1) {
+        return 1;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if ((__stream_socket = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
+        return 1;
+    }
+    if (bind(__stream_socket, (struct sockaddr*)&address, sizeof(address))
+        || listen(__stream_socket, 16)
+        || getsockname(__stream_socket, (struct sockaddr*)&address, &address_length)
+        || pthread_create(&__stream_thread, NULL, __stream_server, NULL))
+    {
+        close(__stream_socket);
+        __stream_socket = -1;
+        return 1;
+    }
+    snprintf(__stream_url, sizeof(__stream_url), "http://127.0.0.1:%u/stream", (unsigned int)ntohs(address.sin_port));
+
+    if (!(connection = __stream_connect())) {
+        return 1;
+    }
+    return 0;
+#else
+    return 1;
+#endif
+}
+
+int clean_suite_database_operations_couchdb_stream(void) {
+    clean_suite_database_operations();
+#if defined(HAVE_COUCHDB)
+    libdbo_log_set_handler(__test_log_handler);
+    if (__stream_socket != -1) {
+        shutdown(__stream_socket, SHUT_RDWR);
+        pthread_join(__stream_thread, NULL);
+        close(__stream_socket);
+        __stream_socket = -1;
+    }
+    pthread_mutex_lock(&__stream_lock);
+    while (__stream_connections) {
+        pthread_cond_wait(&__stream_cond, &__stream_lock);
+    }
+    pthread_mutex_unlock(&__stream_lock);
+#endif
+    return 0;
+}
+
+void test_database_operations_couchdb_stream(void) {
+#if defined(HAVE_COUCHDB)
+    const char* tables[] = { "stream_partial", "stream_truncated", "stream_invalid", NULL };
+    libdbo_object_t* object;
+    libdbo_result_list_t* result_list;
+    int count, i;
+
+    CU_ASSERT_FATAL(!libdbo_log_set_handler(__stream_log_handler));
+
+    /*
+     * A response coming in many chunks gives all the rows.
+     */
+    __stream_errors = 0;
+    CU_ASSERT_PTR_NOT_NULL_FATAL((object = __test_new_table_object(connection, "stream_rows")));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((result_list = libdbo_object_read(object, NULL, NULL)));
+    CU_ASSERT(__stream_walk(result_list) == STREAM_ROWS);
+    CU_ASSERT(libdbo_result_list_error(result_list) == LIBDBO_OK);
+    CU_ASSERT(!__stream_errors);
+    libdbo_result_list_free(result_list);
+    libdbo_object_free(object);
+
+    /*
+     * A transfer error, a response that ends too early or a row that is not
+     * JSON ends the rows with an error on the result list that is logged.
+     */
+    for (i = 0; tables[i]; i++) {
+        __stream_errors = 0;
+        CU_ASSERT_PTR_NOT_NULL_FATAL((object = __test_new_table_object(connection, tables[i])));
+        CU_ASSERT_PTR_NOT_NULL_FATAL((result_list = libdbo_object_read(object, NULL, NULL)));
+        count = __stream_walk(result_list);
+        CU_ASSERT(count > 0);
+        CU_ASSERT(count < STREAM_ROWS);
+        if (!strcmp(tables[i], "stream_invalid")) {
+            CU_ASSERT(count == STREAM_ROWS / 2);
+        }
+        CU_ASSERT(libdbo_result_list_error(result_list) == LIBDBO_ERROR_UNKNOWN);
+        CU_ASSERT_PTR_NULL(libdbo_result_list_next(result_list));
+        CU_ASSERT(__stream_errors == 1);
+        libdbo_result_list_free(result_list);
+
+        CU_ASSERT_PTR_NOT_NULL_FATAL((result_list = libdbo_object_read(object, NULL, NULL)));
+        CU_ASSERT(libdbo_result_list_fetch_all(result_list) == LIBDBO_ERROR_UNKNOWN);
+        CU_ASSERT(libdbo_result_list_size(result_list) == (size_t)count);
+        libdbo_result_list_free(result_list);
+        libdbo_object_free(object);
+    }
+
+    CU_ASSERT(!libdbo_log_set_handler(__test_log_handler));
+#endif
+}
+
+void test_database_operations_couchdb_stream_disconnect(void) {
+#if defined(HAVE_COUCHDB)
+    libdbo_connection_t* stream_connection;
+    libdbo_object_t* object;
+    libdbo_result_list_t* result_list;
+    libdbo_result_list_t* result_list2;
+    int count;
+
+    CU_ASSERT_FATAL(!libdbo_log_set_handler(__stream_log_handler));
+
+    /*
+     * Result lists can be walked and freed after their connection, the rows
+     * already received are returned and then the list has an error.
+     */
+    __stream_errors = 0;
+    CU_ASSERT_PTR_NOT_NULL_FATAL((stream_connection = __stream_connect()));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((object = __test_new_table_object(stream_connection, "stream_stall")));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((result_list = libdbo_object_read(object, NULL, NULL)));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((result_list2 = libdbo_object_read(object, NULL, NULL)));
+    libdbo_connection_free(stream_connection);
+
+    count = __stream_walk(result_list);
+    CU_ASSERT(count < STREAM_ROWS);
+    CU_ASSERT(libdbo_result_list_error(result_list) == LIBDBO_ERROR_UNKNOWN);
+    CU_ASSERT(__stream_errors == 1);
+    libdbo_result_list_free(result_list);
+    libdbo_result_list_free(result_list2);
+    libdbo_object_free(object);
+
+    CU_ASSERT(!libdbo_log_set_handler(__test_log_handler));
+#endif
+}
+
+void test_database_operations_couchdb_stream_pause(void) {
+#if defined(HAVE_COUCHDB)
+    const libdbo_object_t* objects[2];
+    libdbo_result_list_t* result_lists[2];
+    int large_sent;
+
+    /*
+     * The large response is paused while the other one of the batch is walked
+     * so the server can not send all of it, it is resumed when walked.
+     */
+    __stream_large_sent = 0;
+    CU_ASSERT_PTR_NOT_NULL_FATAL((objects[0] = __test_new_table_object(connection, "stream_large")));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((objects[1] = __test_new_table_object(connection, "stream_slow")));
+    CU_ASSERT_FATAL(!libdbo_connection_read_batch(connection, 2, objects, NULL, NULL, result_lists));
+
+    CU_ASSERT(__stream_walk(result_lists[1]) == STREAM_ROWS);
+    CU_ASSERT(libdbo_result_list_error(result_lists[1]) == LIBDBO_OK);
+    pthread_mutex_lock(&__stream_lock);
+    large_sent = __stream_large_sent;
+    pthread_mutex_unlock(&__stream_lock);
+    CU_ASSERT(!large_sent);
+
+    CU_ASSERT(__stream_walk(result_lists[0]) == STREAM_LARGE_ROWS);
+    CU_ASSERT(libdbo_result_list_error(result_lists[0]) == LIBDBO_OK);
+
+    libdbo_result_list_free(result_lists[0]);
+    libdbo_result_list_free(result_lists[1]);
+    libdbo_object_free((libdbo_object_t*)objects[0]);
+    libdbo_object_free((libdbo_object_t*)objects[1]);
+#endif
+}
+
+void test_database_operations_delete_object2_2(void) {
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
+    CU_ASSERT_FATAL(!test2_get_by_id(test2, &object2_id));
+    CU_ASSERT_FATAL(!test2_delete(test2));
+
+    test2_free(test2);
+    test2 = NULL;
+    CU_PASS("test2_free");
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
+    CU_ASSERT_FATAL(test2_get_by_id(test2, &object2_id));
+
+    test2_free(test2);
+    test2 = NULL;
+    CU_PASS("test2_free");
+}
+
+void test_database_operations_create_object3_2(void) {
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
+    CU_ASSERT_FATAL(!test2_set_name(test2, "name 3"));
+    CU_ASSERT(!strcmp(test2_name(test2), "name 3"));
+    CU_ASSERT_FATAL(!test2_create(test2));
+
+    test2_free(test2);
+    test2 = NULL;
+    CU_PASS("test2_free");
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
+    CU_ASSERT_FATAL(!test2_get_by_name(test2, "name 3"));
+    libdbo_value_reset(&object3_id);
+    CU_ASSERT(!libdbo_value_copy(&object3_id, test2_id(test2)));
+    CU_ASSERT(!strcmp(test2_name(test2), "name 3"));
+
+    test2_free(test2);
+    test2 = NULL;
+    CU_PASS("test2_free");
+}
+
+void test_database_operations_delete_object3_2(void) {
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
+    CU_ASSERT_FATAL(!test2_get_by_id(test2, &object3_id));
+    CU_ASSERT_FATAL(!test2_delete(test2));
+
+    test2_free(test2);
+    test2 = NULL;
+    CU_PASS("test2_free");
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
+    CU_ASSERT_FATAL(test2_get_by_id(test2, &object3_id));
+
+    test2_free(test2);
+    test2 = NULL;
+    CU_PASS("test2_free");
+}
+
+void test_database_operations_associated_fetch(void) {
+    users_rev_t* user;
+    groups_rev_t* group;
+    user_group_link_rev_t* user_group;
+    user_group_link_rev_list_t* user_group_list;
+    users_rev_list_t* user_list;
+    const users_rev_t* user2;
+    users_rev_t* user3;
+    groups_rev_list_t* group_list;
+    groups_rev_t* group2;
+    int cmp;
+    const user_group_link_rev_t* user_group2;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((group = groups_rev_new(connection)));
+    CU_ASSERT(!groups_rev_set_name(group, "group 1"));
+    CU_ASSERT_FATAL(!groups_rev_create(group));
+    groups_rev_free(group);
+    CU_PASS("groups_rev_free");
+    CU_ASSERT_PTR_NOT_NULL_FATAL((group = groups_rev_new_get_by_name(connection, "group 1")));
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((user = users_rev_new(connection)));
+    CU_ASSERT(!users_rev_set_name(user, "user 1"));
+    CU_ASSERT(!users_rev_set_group_id(user, groups_rev_id(group)));
+    CU_ASSERT_FATAL(!users_rev_create(user));
+    users_rev_free(user);
+    CU_PASS("users_rev_free");
+    CU_ASSERT_PTR_NOT_NULL_FATAL((user = users_rev_new_get_by_name(connection, "user 1")));
+    CU_ASSERT(!users_rev_cache_group(user));
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((user_group = user_group_link_rev_new(connection)));
+    CU_ASSERT(!user_group_link_rev_set_user_id(user_group, users_rev_id(user)));
+    CU_ASSERT(!user_group_link_rev_set_group_id(user_group, groups_rev_id(group)));
+    CU_ASSERT_FATAL(!user_group_link_rev_create(user_group));
+    user_group_link_rev_free(user_group);
+    CU_PASS("user_group_link_rev_free");
+    CU_ASSERT_PTR_NOT_NULL_FATAL((user_group_list = user_group_link_rev_list_new_get_by_user_id(connection, users_rev_id(user))));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((user_group = user_group_link_rev_list_get_begin(user_group_list)));
+    user_group_link_rev_list_free(user_group_list);
+    CU_PASS("user_group_link_rev_list_free");
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((user_group_list = user_group_link_rev_list_new_get_by_user_id_and_group_id(connection, users_rev_id(user), groups_rev_id(group))));
+    CU_ASSERT_PTR_NOT_NULL((user_group2 = user_group_link_rev_list_begin(user_group_list)));
+    CU_ASSERT_PTR_NULL(user_group_link_rev_list_next(user_group_list));
+    user_group_link_rev_list_free(user_group_list);
+    CU_PASS("user_group_link_rev_list_free");
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((user_list = users_rev_list_new_get_by_group_id_and_name(connection, groups_rev_id(group), "user 1")));
+    CU_ASSERT_PTR_NOT_NULL((user2 = users_rev_list_begin(user_list)));
+    if (user2) {
+        CU_ASSERT(!libdbo_value_cmp(users_rev_id(user), users_rev_id(user2), &cmp));
+        CU_ASSERT(!cmp);
+    }
+    CU_ASSERT_PTR_NULL(users_rev_list_next(user_list));
+    users_rev_list_free(user_list);
+    CU_PASS("users_rev_list_free");
+    CU_ASSERT_PTR_NOT_NULL_FATAL((user_list = users_rev_list_new_get_by_group_id_and_name(connection, groups_rev_id(group), "user 2")));
+    CU_ASSERT_PTR_NULL(users_rev_list_begin(user_list));
+    users_rev_list_free(user_list);
+    CU_PASS("users_rev_list_free");
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((user_list = users_rev_list_new(connection)));
+    CU_ASSERT(!users_rev_list_associated_fetch(user_list));
+    CU_ASSERT(!users_rev_list_get_by_group_id(user_list, groups_rev_id(group)));
+    CU_ASSERT_PTR_NOT_NULL((user3 = users_rev_list_get_begin(user_list)));
+    while (user3) {
+        CU_ASSERT_PTR_NOT_NULL(users_rev_group(user3));
+        CU_ASSERT(!libdbo_value_cmp(users_rev_id(user), users_rev_id(user3), &cmp));
+        CU_ASSERT(!cmp);
+        CU_ASSERT(!libdbo_value_cmp(groups_rev_id(users_rev_group(user)), groups_rev_id(users_rev_group(user3)), &cmp))
+        CU_ASSERT(!cmp);
+
+        CU_ASSERT_PTR_NOT_NULL_FATAL((user_group_list = users_rev_user_group_link_rev_list(user3)));
+        CU_ASSERT_PTR_NOT_NULL((user_group2 = user_group_link_rev_list_begin(user_group_list)));
+        while (user_group2) {
+            CU_ASSERT(!libdbo_value_cmp(users_rev_id(user), user_group_link_rev_user_id(user_group2), &cmp));
+            CU_ASSERT(!cmp);
+            CU_ASSERT(!libdbo_value_cmp(groups_rev_id(group), user_group_link_rev_group_id(user_group2), &cmp));
+            CU_ASSERT(!cmp);
+
+            user_group2 = user_group_link_rev_list_next(user_group_list);
+        }
+
+        users_rev_free(user3);
+        CU_PASS("users_rev_free");
+        user3 = users_rev_list_get_next(user_list);
+    }
+    users_rev_list_free(user_list);
+    CU_PASS("users_rev_list_free");
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((group_list = groups_rev_list_new(connection)));
+    CU_ASSERT(!groups_rev_list_associated_fetch(group_list));
+    CU_ASSERT(!groups_rev_list_get(group_list));
+    CU_ASSERT_PTR_NOT_NULL((group2 = groups_rev_list_get_begin(group_list)));
+    while (group2) {
+        CU_ASSERT(!libdbo_value_cmp(groups_rev_id(group), groups_rev_id(group2), &cmp));
+        CU_ASSERT(!cmp);
+
+        CU_ASSERT_PTR_NOT_NULL_FATAL((user_list = groups_rev_users_rev_list(group2)));
+        CU_ASSERT_PTR_NOT_NULL((user2 = users_rev_list_begin(user_list)));
+        while (user2) {
+            CU_ASSERT(!libdbo_value_cmp(groups_rev_id(group2), users_rev_group_id(user2), &cmp));
+            CU_ASSERT(!cmp);
+            CU_ASSERT(!libdbo_value_cmp(users_rev_id(user), users_rev_id(user2), &cmp));
+            CU_ASSERT(!cmp);
+            user2 = users_rev_list_next(user_list);
+        }
+
+        CU_ASSERT_PTR_NOT_NULL_FATAL((user_group_list = groups_rev_user_group_link_rev_list(group2)));
+        CU_ASSERT_PTR_NOT_NULL((user_group2 = user_group_link_rev_list_begin(user_group_list)));
+        while (user_group2) {
+            CU_ASSERT(!libdbo_value_cmp(users_rev_id(user), user_group_link_rev_user_id(user_group2), &cmp));
+            CU_ASSERT(!cmp);
+            CU_ASSERT(!libdbo_value_cmp(groups_rev_id(group), user_group_link_rev_group_id(user_group2), &cmp));
+            CU_ASSERT(!cmp);
+
+            user_group2 = user_group_link_rev_list_next(user_group_list);
+        }
+
+        groups_rev_free(group2);
+        CU_PASS("groups_rev_free");
+        group2 = groups_rev_list_get_next(group_list);
+    }
+    groups_rev_list_free(group_list);
+    CU_PASS("groups_rev_list_free");
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((user_group_list = user_group_link_rev_list_new(connection)));
+    CU_ASSERT(!user_group_link_rev_list_associated_fetch(user_group_list));
+    CU_ASSERT(!user_group_link_rev_list_get(user_group_list));
+    CU_ASSERT_PTR_NOT_NULL((user_group2 = user_group_link_rev_list_begin(user_group_list)));
+    while (user_group2) {
+        CU_ASSERT_PTR_NOT_NULL(user_group_link_rev_user(user_group2));
+        CU_ASSERT_PTR_NOT_NULL(user_group_link_rev_group(user_group2));
+        CU_ASSERT(!libdbo_value_cmp(users_rev_id(user), user_group_link_rev_user_id(user_group2), &cmp));
+        CU_ASSERT(!cmp);
+        CU_ASSERT(!libdbo_value_cmp(groups_rev_id(group), user_group_link_rev_group_id(user_group2), &cmp));
+        CU_ASSERT(!cmp);
+        CU_ASSERT(!libdbo_value_cmp(users_rev_id(user_group_link_rev_user(user_group2)), users_rev_id(user), &cmp))
+        CU_ASSERT(!cmp);
+        CU_ASSERT(!libdbo_value_cmp(groups_rev_id(user_group_link_rev_group(user_group2)), groups_rev_id(group), &cmp))
+        CU_ASSERT(!cmp);
 
-    test_free(test);
-    test = NULL;
-    CU_PASS("test_free");
+        user_group2 = user_group_link_rev_list_next(user_group_list);
+    }
+    user_group_link_rev_list_free(user_group_list);
+    CU_PASS("user_group_link_rev_list_free");
 
-    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
-    CU_ASSERT_FATAL(!test_get_by_id(test, &object2_id));
-    CU_ASSERT(!strcmp(test_name(test), "name 3"));
+    CU_ASSERT(!user_group_link_rev_delete(user_group));
+    user_group_link_rev_free(user_group);
+    CU_PASS("user_group_link_rev_free");
+
+    CU_ASSERT(!users_rev_delete(user));
+    users_rev_free(user);
+    CU_PASS("users_rev_free");
+
+    CU_ASSERT(!groups_rev_delete(group));
+    groups_rev_free(group);
+    CU_PASS("groups_rev_free");
+}
+
+void test_database_operations_upsert(void) {
+    groups_rev_t* group;
+    groups_rev_t* group2;
+    users_rev_t* user;
+    users_rev_t* user2;
+    libdbo_clause_list_t* clause_list;
+    size_t count;
+    int cmp;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((group = groups_rev_new(connection)));
+    CU_ASSERT(!groups_rev_set_name(group, "upsert group 1"));
+    CU_ASSERT_FATAL(!groups_rev_upsert_by_name(group));
+    groups_rev_free(group);
+    CU_PASS("groups_rev_free");
+    CU_ASSERT_PTR_NOT_NULL_FATAL((group = groups_rev_new_get_by_name(connection, "upsert group 1")));
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((group2 = groups_rev_new(connection)));
+    CU_ASSERT(!groups_rev_set_name(group2, "upsert group 2"));
+    CU_ASSERT_FATAL(!groups_rev_create(group2));
+    groups_rev_free(group2);
+    CU_PASS("groups_rev_free");
+    CU_ASSERT_PTR_NOT_NULL_FATAL((group2 = groups_rev_new_get_by_name(connection, "upsert group 2")));
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((user = users_rev_new(connection)));
+    CU_ASSERT(!users_rev_set_name(user, "upsert user"));
+    CU_ASSERT(!users_rev_set_group_id(user, groups_rev_id(group)));
+    CU_ASSERT_FATAL(!users_rev_upsert_by_name(user));
+    users_rev_free(user);
+    CU_PASS("users_rev_free");
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((user = users_rev_new(connection)));
+    CU_ASSERT(!users_rev_set_name(user, "upsert user"));
+    CU_ASSERT(!users_rev_set_group_id(user, groups_rev_id(group2)));
+    CU_ASSERT_FATAL(!users_rev_upsert_by_name(user));
+    users_rev_free(user);
+    CU_PASS("users_rev_free");
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((user = users_rev_new_get_by_name(connection, "upsert user")));
+    CU_ASSERT(!libdbo_value_cmp(groups_rev_id(group2), users_rev_group_id(user), &cmp));
+    CU_ASSERT(!cmp);
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((clause_list = libdbo_clause_list_new()));
+    CU_ASSERT_PTR_NOT_NULL(users_rev_name_clause(clause_list, "upsert user"));
+    CU_ASSERT(!users_rev_count(user, clause_list, &count));
+    CU_ASSERT(count == 1);
+    libdbo_clause_list_free(clause_list);
+    CU_PASS("libdbo_clause_list_free");
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((user2 = users_rev_new_get_by_name(connection, "upsert user")));
+    CU_ASSERT(!users_rev_set_group_id(user2, groups_rev_id(group)));
+    CU_ASSERT_FATAL(!users_rev_upsert_by_name(user2));
+    CU_ASSERT(!users_rev_set_group_id(user, groups_rev_id(group)));
+    CU_ASSERT_FATAL(users_rev_upsert_by_name(user));
+    users_rev_free(user2);
+    CU_PASS("users_rev_free");
+
+    users_rev_free(user);
+    CU_PASS("users_rev_free");
+    CU_ASSERT_PTR_NOT_NULL_FATAL((user = users_rev_new_get_by_name(connection, "upsert user")));
+    CU_ASSERT(!libdbo_value_cmp(groups_rev_id(group), users_rev_group_id(user), &cmp));
+    CU_ASSERT(!cmp);
+
+    CU_ASSERT(!users_rev_delete(user));
+    users_rev_free(user);
+    CU_PASS("users_rev_free");
+
+    CU_ASSERT(!groups_rev_delete(group2));
+    groups_rev_free(group2);
+    CU_PASS("groups_rev_free");
 
+    CU_ASSERT(!groups_rev_delete(group));
+    groups_rev_free(group);
+    CU_PASS("groups_rev_free");
+}
+
+void test_database_operations_nested_transactions(void) {
+    groups_rev_t* group;
+    groups_rev_t* group2;
+
+    CU_ASSERT(libdbo_connection_transaction_commit(connection));
+    CU_ASSERT(libdbo_connection_transaction_rollback(connection));
+
+    CU_ASSERT_FATAL(!libdbo_connection_transaction_begin(connection));
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((group = groups_rev_new(connection)));
+    CU_ASSERT(!groups_rev_set_name(group, "transaction group 1"));
+    CU_ASSERT_FATAL(!groups_rev_create(group));
+    groups_rev_free(group);
+    CU_PASS("groups_rev_free");
+
+    CU_ASSERT_FATAL(!libdbo_connection_transaction_begin(connection));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((group = groups_rev_new(connection)));
+    CU_ASSERT(!groups_rev_set_name(group, "transaction group 2"));
+    CU_ASSERT_FATAL(!groups_rev_create(group));
+    groups_rev_free(group);
+    CU_PASS("groups_rev_free");
+    CU_ASSERT_FATAL(!libdbo_connection_transaction_rollback(connection));
+
+    CU_ASSERT_FATAL(!libdbo_connection_transaction_begin(connection));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((group = groups_rev_new(connection)));
+    CU_ASSERT(!groups_rev_set_name(group, "transaction group 3"));
+    CU_ASSERT_FATAL(!groups_rev_create(group));
+    groups_rev_free(group);
+    CU_PASS("groups_rev_free");
+    CU_ASSERT_FATAL(!libdbo_connection_transaction_commit(connection));
+
+    CU_ASSERT_FATAL(!libdbo_connection_transaction_commit(connection));
+    CU_ASSERT(libdbo_connection_transaction_commit(connection));
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((group = groups_rev_new_get_by_name(connection, "transaction group 1")));
+    CU_ASSERT_PTR_NULL((group2 = groups_rev_new_get_by_name(connection, "transaction group 2")));
+    groups_rev_free(group2);
+    CU_ASSERT_PTR_NOT_NULL_FATAL((group2 = groups_rev_new_get_by_name(connection, "transaction group 3")));
+
+    CU_ASSERT(!groups_rev_delete(group2));
+    groups_rev_free(group2);
+    CU_PASS("groups_rev_free");
+
+    CU_ASSERT(!groups_rev_delete(group));
+    groups_rev_free(group);
+    CU_PASS("groups_rev_free");
+}
+
+void test_database_operations_cache_stats(void) {
+    libdbo_backend_cache_stats_t stats;
+    unsigned long hits, misses, invalidations;
+
+    CU_ASSERT_FATAL(!libdbo_backend_cache_flush(connection));
+    CU_ASSERT_FATAL(!libdbo_backend_cache_stats(connection, &stats));
+    CU_ASSERT(stats.entries == 0);
+    hits = stats.hits;
+    misses = stats.misses;
+    invalidations = stats.invalidations;
+
+    test_database_operations_read_object1();
+    test_database_operations_read_object1();
+    CU_ASSERT_FATAL(!libdbo_backend_cache_stats(connection, &stats));
+    CU_ASSERT(stats.entries == 1);
+    CU_ASSERT(stats.misses == misses + 1);
+    CU_ASSERT(stats.hits == hits + 1);
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
+    CU_ASSERT_FATAL(!test_set_name(test, "cache"));
+    CU_ASSERT_FATAL(!test_create(test));
+    CU_ASSERT_FATAL(!libdbo_backend_cache_stats(connection, &stats));
+    CU_ASSERT(stats.entries == 0);
+    CU_ASSERT(stats.invalidations == invalidations + 1);
     test_free(test);
     test = NULL;
     CU_PASS("test_free");
-}
 
-void test_database_operations_delete_object2(void) {
     CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
-    CU_ASSERT_FATAL(!test_get_by_id(test, &object2_id));
+    CU_ASSERT_FATAL(!test_get_by_name(test, "cache"));
     CU_ASSERT_FATAL(!test_delete(test));
-
     test_free(test);
     test = NULL;
     CU_PASS("test_free");
 
     CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
-    CU_ASSERT_FATAL(test_get_by_id(test, &object2_id));
-
+    CU_ASSERT(test_get_by_name(test, "cache"));
     test_free(test);
     test = NULL;
     CU_PASS("test_free");
 }
 
-void test_database_operations_create_object3(void) {
-    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
-    CU_ASSERT_FATAL(!test_set_name(test, "name 3"));
-    CU_ASSERT(!strcmp(test_name(test), "name 3"));
-    CU_ASSERT_FATAL(!test_create(test));
+void test_database_operations_identity_map(void) {
+    const libdbo_identity_map_t* identity_map;
+    libdbo_value_t id = LIBDBO_VALUE_EMPTY;
+    unsigned long hits;
 
-    test_free(test);
-    test = NULL;
-    CU_PASS("test_free");
+    CU_ASSERT_PTR_NOT_NULL_FATAL((identity_map = libdbo_connection_identity_map(connection)));
+    CU_ASSERT_FATAL(!libdbo_connection_identity_map_clear(connection));
+    CU_ASSERT(libdbo_identity_map_size(identity_map) == 0);
+    hits = libdbo_identity_map_hits(identity_map);
 
     CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
-    CU_ASSERT_FATAL(!test_get_by_name(test, "name 3"));
-    libdbo_value_reset(&object3_id);
-    CU_ASSERT(!libdbo_value_copy(&object3_id, test_id(test)));
-    CU_ASSERT(!strcmp(test_name(test), "name 3"));
-
+    CU_ASSERT_FATAL(!test_get_by_name(test, "test"));
+    CU_ASSERT_FATAL(!libdbo_value_copy(&id, test_id(test)));
+    CU_ASSERT(libdbo_identity_map_size(identity_map) == 0);
     test_free(test);
     test = NULL;
     CU_PASS("test_free");
-}
 
-void test_database_operations_delete_object3(void) {
     CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
-    CU_ASSERT_FATAL(!test_get_by_id(test, &object3_id));
-    CU_ASSERT_FATAL(!test_delete(test));
-
+    CU_ASSERT_FATAL(!test_get_by_id(test, &id));
+    CU_ASSERT(libdbo_identity_map_size(identity_map) == 1);
+    CU_ASSERT(libdbo_identity_map_hits(identity_map) == hits);
     test_free(test);
     test = NULL;
     CU_PASS("test_free");
 
     CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
-    CU_ASSERT_FATAL(test_get_by_id(test, &object3_id));
-
+    CU_ASSERT_FATAL(!test_get_by_id(test, &id));
+    CU_ASSERT(libdbo_identity_map_hits(identity_map) == hits + 1);
+    CU_ASSERT(!strcmp(test_name(test), "test"));
+    CU_ASSERT_FATAL(!test_set_name(test, "identity map"));
+    CU_ASSERT_FATAL(!test_update(test));
+    CU_ASSERT(libdbo_identity_map_size(identity_map) == 0);
     test_free(test);
     test = NULL;
     CU_PASS("test_free");
-}
-
-void test_database_operations_read_all(void) {
-    const test_t* local_test;
-    int count = 0;
-
-    CU_ASSERT_PTR_NOT_NULL_FATAL((test_list = test_list_new(connection)));
-    CU_ASSERT_FATAL(!test_list_get(test_list));
-    local_test = test_list_begin(test_list);
-    while (local_test) {
-        count++;
-        local_test = test_list_next(test_list);
-    }
-    CU_ASSERT(count == 3);
-
-    test_list_free(test_list);
-    test_list = NULL;
-    CU_PASS("test_list_free");
-}
 
-void test_database_operations_count(void) {
     CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
-    CU_ASSERT(test_count_by_name(test, "test") == 1);
-    CU_ASSERT(test_count_by_id(test, &object2_id) == 1);
-    CU_ASSERT(test_count_by_id(test, &object3_id) == 1);
-    CU_ASSERT(test_count_by_name(test, "name 3") == 2);
+    CU_ASSERT_FATAL(!test_get_by_id(test, &id));
+    CU_ASSERT(libdbo_identity_map_hits(identity_map) == hits + 1);
+    CU_ASSERT(!strcmp(test_name(test), "identity map"));
+    CU_ASSERT_FATAL(!test_set_name(test, "test"));
+    CU_ASSERT_FATAL(!test_update(test));
     test_free(test);
     test = NULL;
     CU_PASS("test_free");
-}
-
-void test_database_operations_read_object1_2(void) {
-    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
-    CU_ASSERT_FATAL(!test2_get_by_name(test2, "test"));
-    __check_id(test2_id(test2), 1, "1");
-    CU_ASSERT_PTR_NOT_NULL_FATAL(test2_name(test2));
-    CU_ASSERT(!strcmp(test2_name(test2), "test"));
-
-    test2_free(test2);
-    test2 = NULL;
-    CU_PASS("test2_free");
-}
-
-void test_database_operations_create_object2_2(void) {
-    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
-    CU_ASSERT_FATAL(!test2_set_name(test2, "name 2"));
-    CU_ASSERT(!strcmp(test2_name(test2), "name 2"));
-    CU_ASSERT_FATAL(!test2_create(test2));
-
-    test2_free(test2);
-    test2 = NULL;
-    CU_PASS("test2_free");
-
-    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
-    CU_ASSERT_FATAL(!test2_get_by_name(test2, "name 2"));
-    libdbo_value_reset(&object2_id);
-    CU_ASSERT(!libdbo_value_copy(&object2_id, test2_id(test2)));
-    CU_ASSERT(!strcmp(test2_name(test2), "name 2"));
-
-    test2_free(test2);
-    test2 = NULL;
-    CU_PASS("test2_free");
-}
-
-void test_database_operations_read_object2_2(void) {
-    int cmp = 0;
-
-    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
-    CU_ASSERT_FATAL(!test2_get_by_id(test2, &object2_id));
-    CU_ASSERT(!libdbo_value_cmp(test2_id(test2), &object2_id, &cmp));
-    CU_ASSERT(!cmp);
-    CU_ASSERT(!strcmp(test2_name(test2), "name 2"));
-
-    test2_free(test2);
-    test2 = NULL;
-    CU_PASS("test2_free");
-}
-
-void test_database_operations_update_object2_2(void) {
-    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
-    CU_ASSERT_FATAL(!test2_get_by_id(test2, &object2_id));
-    CU_ASSERT_FATAL(!test2_set_name(test2, "name 3"));
-    CU_ASSERT(!strcmp(test2_name(test2), "name 3"));
-    CU_ASSERT_FATAL(!test2_update(test2));
-
-    test2_free(test2);
-    test2 = NULL;
-    CU_PASS("test2_free");
 
-    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
-    CU_ASSERT_FATAL(!test2_get_by_id(test2, &object2_id));
-    CU_ASSERT(!strcmp(test2_name(test2), "name 3"));
-
-    test2_free(test2);
-    test2 = NULL;
-    CU_PASS("test2_free");
+    libdbo_value_reset(&id);
 }
 
-void test_database_operations_update_objects_revisions(void) {
-    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
-    CU_ASSERT_FATAL(!test2_set_name(test2, "name 4"));
-    CU_ASSERT(!strcmp(test2_name(test2), "name 4"));
-    CU_ASSERT_FATAL(!test2_create(test2));
-
-    test2_free(test2);
-    test2 = NULL;
-    CU_PASS("test2_free");
-
-    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
-    CU_ASSERT_FATAL(!test2_get_by_name(test2, "name 4"));
-    CU_ASSERT(!strcmp(test2_name(test2), "name 4"));
-
-    CU_ASSERT_PTR_NOT_NULL_FATAL((test2_2 = test2_new(connection)));
-    CU_ASSERT_FATAL(!test2_get_by_name(test2_2, "name 4"));
-    CU_ASSERT(!strcmp(test2_name(test2_2), "name 4"));
-
-    CU_ASSERT_FATAL(!test2_set_name(test2_2, "name 5"));
-    CU_ASSERT(!strcmp(test2_name(test2_2), "name 5"));
-    CU_ASSERT_FATAL(!test2_update(test2_2));
-
-    CU_ASSERT_FATAL(!test2_set_name(test2, "name 5"));
-    CU_ASSERT(!strcmp(test2_name(test2), "name 5"));
-    CU_ASSERT_FATAL(test2_update(test2));
+static libdbo_connection_t* __identity_map_connection(void) {
+    libdbo_configuration_list_t* configuration_list;
+    libdbo_configuration_t* configuration;
+    libdbo_connection_t* connection;
+    const char* settings[] = {
+        "backend", "sqlite",
+        "file", "test.db",
+        "identity_map", "128",
+        NULL
+    };
+    int i;
 
-    test2_free(test2);
-    test2 = NULL;
-    CU_PASS("test2_free");
+    if (!(configuration_list = libdbo_configuration_list_new())) {
+        return NULL;
+    }
+    for (i = 0; settings[i]; i += 2) {
+        if (!(configuration = libdbo_configuration_new())
+            || libdbo_configuration_set_name(configuration, settings[i])
+            || libdbo_configuration_set_value(configuration, settings[i + 1])
+            || libdbo_configuration_list_add(configuration_list, configuration))
+        {
+            libdbo_configuration_free(configuration);
+            libdbo_configuration_list_free(configuration_list);
+            return NULL;
+        }
+    }
 
-    test2_free(test2_2);
-    test2_2 = NULL;
-    CU_PASS("test2_free");
+    if (!(connection = libdbo_connection_new())
+        || libdbo_connection_set_configuration_list(connection, configuration_list))
+    {
+        libdbo_connection_free(connection);
+        libdbo_configuration_list_free(configuration_list);
+        return NULL;
+    }
+    if (libdbo_connection_setup(connection)
+        || libdbo_connection_connect(connection))
+    {
+        libdbo_connection_free(connection);
+        return NULL;
+    }
+    return connection;
 }
 
-void test_database_operations_delete_object2_2(void) {
-    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
-    CU_ASSERT_FATAL(!test2_get_by_id(test2, &object2_id));
-    CU_ASSERT_FATAL(!test2_delete(test2));
+void test_database_operations_identity_map_transaction(void) {
+    libdbo_connection_t* mapped_connection;
+    libdbo_connection_t* other_connection;
+    libdbo_value_t id = LIBDBO_VALUE_EMPTY;
 
+    CU_ASSERT_PTR_NOT_NULL_FATAL((mapped_connection = __identity_map_connection()));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((other_connection = __identity_map_connection()));
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(other_connection)));
+    CU_ASSERT_FATAL(!test2_set_name(test2, "identity map transaction"));
+    CU_ASSERT_FATAL(!test2_create(test2));
     test2_free(test2);
     test2 = NULL;
-    CU_PASS("test2_free");
-
-    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
-    CU_ASSERT_FATAL(test2_get_by_id(test2, &object2_id));
-
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(other_connection)));
+    CU_ASSERT_FATAL(!test2_get_by_name(test2, "identity map transaction"));
+    CU_ASSERT_FATAL(!libdbo_value_copy(&id, test2_id(test2)));
     test2_free(test2);
     test2 = NULL;
-    CU_PASS("test2_free");
-}
-
-void test_database_operations_create_object3_2(void) {
-    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
-    CU_ASSERT_FATAL(!test2_set_name(test2, "name 3"));
-    CU_ASSERT(!strcmp(test2_name(test2), "name 3"));
-    CU_ASSERT_FATAL(!test2_create(test2));
 
+    /*
+     * Read the object so that it is in the identity map.
+     */
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(mapped_connection)));
+    CU_ASSERT_FATAL(!test2_get_by_id(test2, &id));
+    CU_ASSERT(libdbo_identity_map_size(libdbo_connection_identity_map(mapped_connection)) == 1);
     test2_free(test2);
     test2 = NULL;
-    CU_PASS("test2_free");
-
-    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
-    CU_ASSERT_FATAL(!test2_get_by_name(test2, "name 3"));
-    libdbo_value_reset(&object3_id);
-    CU_ASSERT(!libdbo_value_copy(&object3_id, test2_id(test2)));
-    CU_ASSERT(!strcmp(test2_name(test2), "name 3"));
 
+    /*
+     * Begin a transaction and change the object through the other connection,
+     * reading it again inside the transaction must return the change.
+     */
+    CU_ASSERT_FATAL(!libdbo_connection_transaction_begin(mapped_connection));
+    CU_ASSERT(libdbo_identity_map_size(libdbo_connection_identity_map(mapped_connection)) == 0);
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(other_connection)));
+    CU_ASSERT_FATAL(!test2_get_by_id(test2, &id));
+    CU_ASSERT_FATAL(!test2_set_name(test2, "identity map transaction 2"));
+    CU_ASSERT_FATAL(!test2_update(test2));
     test2_free(test2);
     test2 = NULL;
-    CU_PASS("test2_free");
-}
-
-void test_database_operations_delete_object3_2(void) {
-    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
-    CU_ASSERT_FATAL(!test2_get_by_id(test2, &object3_id));
-    CU_ASSERT_FATAL(!test2_delete(test2));
-
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(mapped_connection)));
+    CU_ASSERT_FATAL(!test2_get_by_id(test2, &id));
+    CU_ASSERT(!strcmp(test2_name(test2), "identity map transaction 2"));
     test2_free(test2);
     test2 = NULL;
-    CU_PASS("test2_free");
-
-    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(connection)));
-    CU_ASSERT_FATAL(test2_get_by_id(test2, &object3_id));
+    CU_ASSERT(libdbo_identity_map_size(libdbo_connection_identity_map(mapped_connection)) == 1);
+    CU_ASSERT_FATAL(!libdbo_connection_transaction_commit(mapped_connection));
+    CU_ASSERT(libdbo_identity_map_size(libdbo_connection_identity_map(mapped_connection)) == 0);
 
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test2 = test2_new(other_connection)));
+    CU_ASSERT_FATAL(!test2_get_by_id(test2, &id));
+    CU_ASSERT(!test2_delete(test2));
     test2_free(test2);
     test2 = NULL;
-    CU_PASS("test2_free");
+
+    libdbo_value_reset(&id);
+    libdbo_connection_free(other_connection);
+    libdbo_connection_free(mapped_connection);
 }
 
-void test_database_operations_associated_fetch(void) {
-    users_rev_t* user;
-    groups_rev_t* group;
-    user_group_link_rev_t* user_group;
-    user_group_link_rev_list_t* user_group_list;
-    users_rev_list_t* user_list;
-    const users_rev_t* user2;
-    users_rev_t* user3;
-    groups_rev_list_t* group_list;
-    groups_rev_t* group2;
-    int cmp;
-    const user_group_link_rev_t* user_group2;
+void test_database_operations_lookup_filter(void) {
+    const libdbo_lookup_filter_t* lookup_filter;
+    unsigned long bloom_hits, negative_hits;
 
-    CU_ASSERT_PTR_NOT_NULL_FATAL((group = groups_rev_new(connection)));
-    CU_ASSERT(!groups_rev_set_name(group, "group 1"));
-    CU_ASSERT_FATAL(!groups_rev_create(group));
-    groups_rev_free(group);
-    CU_PASS("groups_rev_free");
-    CU_ASSERT_PTR_NOT_NULL_FATAL((group = groups_rev_new_get_by_name(connection, "group 1")));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((lookup_filter = libdbo_connection_lookup_filter(connection)));
+    bloom_hits = libdbo_lookup_filter_bloom_hits(lookup_filter);
+    negative_hits = libdbo_lookup_filter_negative_hits(lookup_filter);
 
-    CU_ASSERT_PTR_NOT_NULL_FATAL((user = users_rev_new(connection)));
-    CU_ASSERT(!users_rev_set_name(user, "user 1"));
-    CU_ASSERT(!users_rev_set_group_id(user, groups_rev_id(group)));
-    CU_ASSERT_FATAL(!users_rev_create(user));
-    users_rev_free(user);
-    CU_PASS("users_rev_free");
-    CU_ASSERT_PTR_NOT_NULL_FATAL((user = users_rev_new_get_by_name(connection, "user 1")));
-    CU_ASSERT(!users_rev_cache_group(user));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
+    CU_ASSERT_FATAL(!test_get_by_name(test, "test"));
+    CU_ASSERT(libdbo_lookup_filter_bloom_hits(lookup_filter) == bloom_hits);
+    CU_ASSERT(test_get_by_name(test, "lookup filter"));
+    CU_ASSERT(libdbo_lookup_filter_bloom_hits(lookup_filter) + libdbo_lookup_filter_negative_hits(lookup_filter) == bloom_hits + negative_hits + 1);
+    test_free(test);
+    test = NULL;
+    CU_PASS("test_free");
 
-    CU_ASSERT_PTR_NOT_NULL_FATAL((user_group = user_group_link_rev_new(connection)));
-    CU_ASSERT(!user_group_link_rev_set_user_id(user_group, users_rev_id(user)));
-    CU_ASSERT(!user_group_link_rev_set_group_id(user_group, groups_rev_id(group)));
-    CU_ASSERT_FATAL(!user_group_link_rev_create(user_group));
-    user_group_link_rev_free(user_group);
-    CU_PASS("user_group_link_rev_free");
-    CU_ASSERT_PTR_NOT_NULL_FATAL((user_group_list = user_group_link_rev_list_new_get_by_user_id(connection, users_rev_id(user))));
-    CU_ASSERT_PTR_NOT_NULL_FATAL((user_group = user_group_link_rev_list_get_begin(user_group_list)));
-    user_group_link_rev_list_free(user_group_list);
-    CU_PASS("user_group_link_rev_list_free");
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
+    CU_ASSERT_FATAL(!test_set_name(test, "lookup filter"));
+    CU_ASSERT_FATAL(!test_create(test));
+    test_free(test);
+    test = NULL;
+    CU_PASS("test_free");
 
-    CU_ASSERT_PTR_NOT_NULL_FATAL((user_list = users_rev_list_new(connection)));
-    CU_ASSERT(!users_rev_list_associated_fetch(user_list));
-    CU_ASSERT(!users_rev_list_get_by_group_id(user_list, groups_rev_id(group)));
-    CU_ASSERT_PTR_NOT_NULL((user3 = users_rev_list_get_begin(user_list)));
-    while (user3) {
-        CU_ASSERT_PTR_NOT_NULL(users_rev_group(user3));
-        CU_ASSERT(!libdbo_value_cmp(users_rev_id(user), users_rev_id(user3), &cmp));
-        CU_ASSERT(!cmp);
-        CU_ASSERT(!libdbo_value_cmp(groups_rev_id(users_rev_group(user)), groups_rev_id(users_rev_group(user3)), &cmp))
-        CU_ASSERT(!cmp);
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
+    CU_ASSERT_FATAL(!test_get_by_name(test, "lookup filter"));
+    CU_ASSERT_FATAL(!test_delete(test));
+    test_free(test);
+    test = NULL;
+    CU_PASS("test_free");
 
-        CU_ASSERT_PTR_NOT_NULL_FATAL((user_group_list = users_rev_user_group_link_rev_list(user3)));
-        CU_ASSERT_PTR_NOT_NULL((user_group2 = user_group_link_rev_list_begin(user_group_list)));
-        while (user_group2) {
-            CU_ASSERT(!libdbo_value_cmp(users_rev_id(user), user_group_link_rev_user_id(user_group2), &cmp));
-            CU_ASSERT(!cmp);
-            CU_ASSERT(!libdbo_value_cmp(groups_rev_id(group), user_group_link_rev_group_id(user_group2), &cmp));
-            CU_ASSERT(!cmp);
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
+    CU_ASSERT(test_get_by_name(test, "lookup filter"));
+    test_free(test);
+    test = NULL;
+    CU_PASS("test_free");
 
-            user_group2 = user_group_link_rev_list_next(user_group_list);
-        }
+    CU_ASSERT_FATAL(!libdbo_connection_transaction_begin(connection));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
+    CU_ASSERT_FATAL(!test_set_name(test, "lookup filter"));
+    CU_ASSERT_FATAL(!test_create(test));
+    test_free(test);
+    test = NULL;
+    CU_PASS("test_free");
+    CU_ASSERT_FATAL(!libdbo_connection_transaction_rollback(connection));
 
-        users_rev_free(user3);
-        CU_PASS("users_rev_free");
-        user3 = users_rev_list_get_next(user_list);
+    bloom_hits = libdbo_lookup_filter_bloom_hits(lookup_filter);
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
+    CU_ASSERT(test_get_by_name(test, "lookup filter"));
+    CU_ASSERT(libdbo_lookup_filter_bloom_hits(lookup_filter) == bloom_hits + 1);
+    CU_ASSERT_FATAL(!test_get_by_name(test, "test"));
+    test_free(test);
+    test = NULL;
+    CU_PASS("test_free");
+}
+
+static int __connection_pool_validate(const libdbo_connection_t* pool_connection, void* user_data) {
+    int* fail = (int*)user_data;
+
+    (void)pool_connection;
+    if (*fail) {
+        (*fail)--;
+        return 1;
     }
-    users_rev_list_free(user_list);
-    CU_PASS("users_rev_list_free");
+    return 0;
+}
 
-    CU_ASSERT_PTR_NOT_NULL_FATAL((group_list = groups_rev_list_new(connection)));
-    CU_ASSERT(!groups_rev_list_associated_fetch(group_list));
-    CU_ASSERT(!groups_rev_list_get(group_list));
-    CU_ASSERT_PTR_NOT_NULL((group2 = groups_rev_list_get_begin(group_list)));
-    while (group2) {
-        CU_ASSERT(!libdbo_value_cmp(groups_rev_id(group), groups_rev_id(group2), &cmp));
-        CU_ASSERT(!cmp);
+static void* __connection_pool_thread(void* data) {
+    libdbo_connection_pool_t* connection_pool = (libdbo_connection_pool_t*)data;
+    libdbo_connection_t* pool_connection;
+    int i;
 
-        CU_ASSERT_PTR_NOT_NULL_FATAL((user_list = groups_rev_users_rev_list(group2)));
-        CU_ASSERT_PTR_NOT_NULL((user2 = users_rev_list_begin(user_list)));
-        while (user2) {
-            CU_ASSERT(!libdbo_value_cmp(groups_rev_id(group2), users_rev_group_id(user2), &cmp));
-            CU_ASSERT(!cmp);
-            CU_ASSERT(!libdbo_value_cmp(users_rev_id(user), users_rev_id(user2), &cmp));
-            CU_ASSERT(!cmp);
-            user2 = users_rev_list_next(user_list);
+    for (i = 0; i < 50; i++) {
+        if (!(pool_connection = libdbo_connection_pool_checkout(connection_pool))) {
+            return data;
+        }
+        if (libdbo_connection_transaction_begin(pool_connection)
+            || libdbo_connection_transaction_commit(pool_connection))
+        {
+            libdbo_connection_pool_discard(connection_pool, pool_connection);
+            return data;
         }
+        if (libdbo_connection_pool_checkin(connection_pool, pool_connection)) {
+            return data;
+        }
+    }
+    return NULL;
+}
 
-        CU_ASSERT_PTR_NOT_NULL_FATAL((user_group_list = groups_rev_user_group_link_rev_list(group2)));
-        CU_ASSERT_PTR_NOT_NULL((user_group2 = user_group_link_rev_list_begin(user_group_list)));
-        while (user_group2) {
-            CU_ASSERT(!libdbo_value_cmp(users_rev_id(user), user_group_link_rev_user_id(user_group2), &cmp));
-            CU_ASSERT(!cmp);
-            CU_ASSERT(!libdbo_value_cmp(groups_rev_id(group), user_group_link_rev_group_id(user_group2), &cmp));
-            CU_ASSERT(!cmp);
+void test_database_operations_connection_pool(void) {
+    libdbo_connection_pool_t* connection_pool;
+    libdbo_connection_pool_stats_t stats;
+    libdbo_connection_t* connection1;
+    libdbo_connection_t* connection2;
+    pthread_t threads[4];
+    void* thread_ret;
+    int fail = 0;
+    size_t i;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(connection);
+    CU_ASSERT_PTR_NULL(libdbo_connection_pool_new(connection->configuration_list, 2, 1));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((connection_pool = libdbo_connection_pool_new(connection->configuration_list, 1, 2)));
+    CU_ASSERT_FATAL(!libdbo_connection_pool_stats(connection_pool, &stats));
+    CU_ASSERT(stats.size == 1);
+    CU_ASSERT(stats.idle == 1);
+    CU_ASSERT(stats.created == 1);
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((connection1 = libdbo_connection_pool_checkout(connection_pool)));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((connection2 = libdbo_connection_pool_checkout(connection_pool)));
+    CU_ASSERT(connection1 != connection2);
+    CU_ASSERT_PTR_NULL(libdbo_connection_pool_checkout_timed(connection_pool, 10));
+    CU_ASSERT_FATAL(!libdbo_connection_pool_stats(connection_pool, &stats));
+    CU_ASSERT(stats.size == 2);
+    CU_ASSERT(stats.in_use == 2);
+    CU_ASSERT(stats.idle == 0);
+    CU_ASSERT(stats.checkouts == 2);
+    CU_ASSERT(stats.waits == 1);
+    CU_ASSERT(stats.timeouts == 1);
+
+    CU_ASSERT(!libdbo_connection_pool_checkin(connection_pool, connection2));
+    CU_ASSERT(libdbo_connection_pool_checkin(connection_pool, connection2));
+    CU_ASSERT(libdbo_connection_pool_checkin(connection_pool, connection));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((connection2 = libdbo_connection_pool_checkout_timed(connection_pool, 10)));
+    CU_ASSERT(!libdbo_connection_pool_discard(connection_pool, connection2));
+    CU_ASSERT_FATAL(!libdbo_connection_pool_stats(connection_pool, &stats));
+    CU_ASSERT(stats.size == 1);
+    CU_ASSERT(stats.invalid == 1);
+
+    CU_ASSERT(!libdbo_connection_pool_set_validate(connection_pool, __connection_pool_validate, &fail));
+    CU_ASSERT(!libdbo_connection_pool_checkin(connection_pool, connection1));
+    fail = 1;
+    CU_ASSERT_PTR_NOT_NULL_FATAL((connection1 = libdbo_connection_pool_checkout(connection_pool)));
+    CU_ASSERT(!fail);
+    CU_ASSERT(!libdbo_connection_pool_checkin(connection_pool, connection1));
+    CU_ASSERT_FATAL(!libdbo_connection_pool_stats(connection_pool, &stats));
+    CU_ASSERT(stats.size == 1);
+    CU_ASSERT(stats.invalid == 2);
+    CU_ASSERT(stats.created == 3);
+
+    CU_ASSERT(!libdbo_connection_pool_set_validate(connection_pool, NULL, NULL));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((connection1 = libdbo_connection_pool_checkout(connection_pool)));
+    CU_ASSERT_FATAL(!libdbo_connection_transaction_begin(connection1));
+    CU_ASSERT_FATAL(!libdbo_connection_transaction_begin(connection1));
+    CU_ASSERT(libdbo_connection_transaction(connection1) == 2);
+    CU_ASSERT(!libdbo_connection_pool_checkin(connection_pool, connection1));
+    CU_ASSERT(libdbo_connection_transaction(connection1) == 0);
+    CU_ASSERT_PTR_NOT_NULL_FATAL((connection1 = libdbo_connection_pool_checkout(connection_pool)));
+    CU_ASSERT_FATAL(!libdbo_connection_transaction_begin(connection1));
+    CU_ASSERT_FATAL(!libdbo_connection_transaction_commit(connection1));
+    CU_ASSERT(libdbo_connection_transaction(connection1) == 0);
+    CU_ASSERT(!libdbo_connection_pool_checkin(connection_pool, connection1));
+    CU_ASSERT_FATAL(!libdbo_connection_pool_stats(connection_pool, &stats));
+    CU_ASSERT(stats.size == 1);
+    CU_ASSERT(stats.invalid == 2);
+
+    for (i = 0; i < sizeof(threads) / sizeof(threads[0]); i++) {
+        CU_ASSERT_FATAL(!pthread_create(&threads[i], NULL, __connection_pool_thread, connection_pool));
+    }
+    for (i = 0; i < sizeof(threads) / sizeof(threads[0]); i++) {
+        CU_ASSERT_FATAL(!pthread_join(threads[i], &thread_ret));
+        CU_ASSERT_PTR_NULL(thread_ret);
+    }
+    CU_ASSERT_FATAL(!libdbo_connection_pool_stats(connection_pool, &stats));
+    CU_ASSERT(stats.size <= 2);
+    CU_ASSERT(stats.in_use == 0);
+    CU_ASSERT(stats.checkouts == 206);
+    CU_ASSERT(stats.max_wait_usec * stats.waits >= stats.wait_usec);
+
+    CU_ASSERT(!libdbo_connection_pool_set_idle_timeout(connection_pool, 3600));
+    CU_ASSERT(!libdbo_connection_pool_evict(connection_pool));
+    CU_ASSERT_FATAL(!libdbo_connection_pool_stats(connection_pool, &stats));
+    CU_ASSERT(stats.evicted == 0);
+
+    libdbo_connection_pool_free(connection_pool);
+}
 
-            user_group2 = user_group_link_rev_list_next(user_group_list);
-        }
+static pthread_mutex_t __async_callback_lock = PTHREAD_MUTEX_INITIALIZER;
+static int __async_callbacks = 0;
 
-        groups_rev_free(group2);
-        CU_PASS("groups_rev_free");
-        group2 = groups_rev_list_get_next(group_list);
+static void __async_callback(libdbo_async_future_t* future, void* user_data) {
+    (void)user_data;
+
+    pthread_mutex_lock(&__async_callback_lock);
+    if (libdbo_async_future_done(future)) {
+        __async_callbacks++;
     }
-    groups_rev_list_free(group_list);
-    CU_PASS("groups_rev_list_free");
+    pthread_mutex_unlock(&__async_callback_lock);
+}
 
-    CU_ASSERT_PTR_NOT_NULL_FATAL((user_group_list = user_group_link_rev_list_new(connection)));
-    CU_ASSERT(!user_group_link_rev_list_associated_fetch(user_group_list));
-    CU_ASSERT(!user_group_link_rev_list_get(user_group_list));
-    CU_ASSERT_PTR_NOT_NULL((user_group2 = user_group_link_rev_list_begin(user_group_list)));
-    while (user_group2) {
-        CU_ASSERT_PTR_NOT_NULL(user_group_link_rev_user(user_group2));
-        CU_ASSERT_PTR_NOT_NULL(user_group_link_rev_group(user_group2));
-        CU_ASSERT(!libdbo_value_cmp(users_rev_id(user), user_group_link_rev_user_id(user_group2), &cmp));
-        CU_ASSERT(!cmp);
-        CU_ASSERT(!libdbo_value_cmp(groups_rev_id(group), user_group_link_rev_group_id(user_group2), &cmp));
-        CU_ASSERT(!cmp);
-        CU_ASSERT(!libdbo_value_cmp(users_rev_id(user_group_link_rev_user(user_group2)), users_rev_id(user), &cmp))
-        CU_ASSERT(!cmp);
-        CU_ASSERT(!libdbo_value_cmp(groups_rev_id(user_group_link_rev_group(user_group2)), groups_rev_id(group), &cmp))
-        CU_ASSERT(!cmp);
+void test_database_operations_async(void) {
+    libdbo_async_t* async;
+    libdbo_async_future_t* futures[4];
+    libdbo_result_list_t* result_list;
+    size_t i;
 
-        user_group2 = user_group_link_rev_list_next(user_group_list);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(connection);
+    CU_ASSERT_PTR_NULL(libdbo_async_new(connection->configuration_list, 0));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((async = libdbo_async_new(connection->configuration_list, 2)));
+    CU_ASSERT(libdbo_async_workers(async) == 2);
+    CU_ASSERT_PTR_NULL(libdbo_async_transaction_begin(async, LIBDBO_ASYNC_ANY_WORKER, NULL, NULL));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
+    __async_callbacks = 0;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((futures[0] = libdbo_async_transaction_begin(async, 1, __async_callback, NULL)));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((futures[1] = libdbo_async_count(async, 1, test->dbo, NULL, NULL, __async_callback, NULL)));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((futures[2] = libdbo_async_read(async, 1, test->dbo, NULL, NULL, __async_callback, NULL)));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((futures[3] = libdbo_async_transaction_commit(async, 1, __async_callback, NULL)));
+    for (i = 0; i < 4; i++) {
+        CU_ASSERT(!libdbo_async_future_wait(futures[i]));
+        CU_ASSERT(libdbo_async_future_done(futures[i]));
+        CU_ASSERT(!libdbo_async_future_status(futures[i]));
+    }
+    CU_ASSERT_PTR_NOT_NULL_FATAL((result_list = libdbo_async_future_take_result_list(futures[2])));
+    CU_ASSERT_PTR_NULL(libdbo_async_future_take_result_list(futures[2]));
+    CU_ASSERT(libdbo_result_list_size(result_list) == libdbo_async_future_count(futures[1]));
+    libdbo_result_list_free(result_list);
+    for (i = 0; i < 4; i++) {
+        libdbo_async_future_free(futures[i]);
     }
-    user_group_link_rev_list_free(user_group_list);
-    CU_PASS("user_group_link_rev_list_free");
 
-    CU_ASSERT(!user_group_link_rev_delete(user_group));
-    user_group_link_rev_free(user_group);
-    CU_PASS("user_group_link_rev_free");
+    for (i = 0; i < 16; i++) {
+        CU_ASSERT_PTR_NOT_NULL_FATAL((futures[0] = libdbo_async_count(async, LIBDBO_ASYNC_ANY_WORKER, test->dbo, NULL, NULL, __async_callback, NULL)));
+        libdbo_async_future_free(futures[0]);
+    }
 
-    CU_ASSERT(!users_rev_delete(user));
-    users_rev_free(user);
-    CU_PASS("users_rev_free");
+    libdbo_async_free(async);
+    CU_ASSERT(__async_callbacks == 20);
+    test_free(test);
+    test = NULL;
+    CU_PASS("test_free");
+}
 
-    CU_ASSERT(!groups_rev_delete(group));
-    groups_rev_free(group);
-    CU_PASS("groups_rev_free");
+void test_database_operations_async_group_commit(void) {
+    libdbo_async_t* async;
+    libdbo_async_future_t* futures[4];
+    libdbo_object_field_list_t* object_field_list;
+    libdbo_object_field_list_t* bad_object_field_list;
+    libdbo_object_field_t* object_field;
+    libdbo_value_set_t* value_sets[3];
+    libdbo_clause_list_t* clause_lists[3];
+    libdbo_clause_t* clause;
+    char name[32];
+    size_t i;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(connection);
+    CU_ASSERT_PTR_NOT_NULL_FATAL((async = libdbo_async_new(connection->configuration_list, 1)));
+    CU_ASSERT_FATAL(!libdbo_async_set_group_commit(async, 4, 100));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((test = test_new(connection)));
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((object_field_list = libdbo_object_field_list_new()));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((object_field = libdbo_object_field_new()));
+    CU_ASSERT_FATAL(!libdbo_object_field_set_name(object_field, "name"));
+    CU_ASSERT_FATAL(!libdbo_object_field_set_type(object_field, LIBDBO_TYPE_TEXT));
+    CU_ASSERT_FATAL(!libdbo_object_field_list_add(object_field_list, object_field));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((bad_object_field_list = libdbo_object_field_list_new()));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((object_field = libdbo_object_field_new()));
+    CU_ASSERT_FATAL(!libdbo_object_field_set_name(object_field, "no_such_field"));
+    CU_ASSERT_FATAL(!libdbo_object_field_set_type(object_field, LIBDBO_TYPE_TEXT));
+    CU_ASSERT_FATAL(!libdbo_object_field_list_add(bad_object_field_list, object_field));
+    object_field = NULL;
+
+    for (i = 0; i < 3; i++) {
+        snprintf(name, sizeof(name), "group commit %lu", (unsigned long)i);
+        CU_ASSERT_PTR_NOT_NULL_FATAL((value_sets[i] = libdbo_value_set_new(1)));
+        CU_ASSERT_FATAL(!libdbo_value_from_text(libdbo_value_set_get(value_sets[i], 0), name));
+        CU_ASSERT_PTR_NOT_NULL_FATAL((clause_lists[i] = libdbo_clause_list_new()));
+        CU_ASSERT_PTR_NOT_NULL_FATAL((clause = libdbo_clause_new()));
+        CU_ASSERT_FATAL(!libdbo_clause_set_field(clause, "name"));
+        CU_ASSERT_FATAL(!libdbo_clause_set_type(clause, LIBDBO_CLAUSE_EQUAL));
+        CU_ASSERT_FATAL(!libdbo_value_from_text(libdbo_clause_get_value(clause), name));
+        CU_ASSERT_FATAL(!libdbo_clause_list_add(clause_lists[i], clause));
+        clause = NULL;
+    }
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((futures[0] = libdbo_async_create(async, 0, test->dbo, object_field_list, value_sets[0], NULL, NULL)));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((futures[1] = libdbo_async_create(async, 0, test->dbo, bad_object_field_list, value_sets[1], NULL, NULL)));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((futures[2] = libdbo_async_create(async, 0, test->dbo, object_field_list, value_sets[1], NULL, NULL)));
+    CU_ASSERT_PTR_NOT_NULL_FATAL((futures[3] = libdbo_async_create(async, 0, test->dbo, object_field_list, value_sets[2], NULL, NULL)));
+    for (i = 0; i < 4; i++) {
+        CU_ASSERT(!libdbo_async_future_wait(futures[i]));
+        if (i == 1) {
+            CU_ASSERT(libdbo_async_future_status(futures[i]));
+        }
+        else {
+            CU_ASSERT(!libdbo_async_future_status(futures[i]));
+        }
+        libdbo_async_future_free(futures[i]);
+    }
+
+    for (i = 0; i < 3; i++) {
+        CU_ASSERT_PTR_NOT_NULL_FATAL((futures[i] = libdbo_async_count(async, 0, test->dbo, NULL, clause_lists[i], NULL, NULL)));
+        CU_ASSERT(!libdbo_async_future_wait(futures[i]));
+        CU_ASSERT(!libdbo_async_future_status(futures[i]));
+        CU_ASSERT(libdbo_async_future_count(futures[i]) == 1);
+        libdbo_async_future_free(futures[i]);
+    }
+
+    for (i = 0; i < 3; i++) {
+        CU_ASSERT_PTR_NOT_NULL_FATAL((futures[i] = libdbo_async_delete(async, 0, test->dbo, clause_lists[i], NULL, NULL)));
+    }
+    for (i = 0; i < 3; i++) {
+        CU_ASSERT(!libdbo_async_future_wait(futures[i]));
+        CU_ASSERT(!libdbo_async_future_status(futures[i]));
+        libdbo_async_future_free(futures[i]);
+    }
+
+    libdbo_async_free(async);
+    for (i = 0; i < 3; i++) {
+        libdbo_value_set_free(value_sets[i]);
+        libdbo_clause_list_free(clause_lists[i]);
+    }
+    libdbo_object_field_list_free(object_field_list);
+    libdbo_object_field_list_free(bad_object_field_list);
+    test_free(test);
+    test = NULL;
+    CU_PASS("test_free");
 }
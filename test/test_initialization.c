@@ -135,6 +135,76 @@ void test_initialization_configuration_mysql(void) {
 #endif
 }
 
+void test_initialization_configuration_postgresql(void) {
+    CU_ASSERT_PTR_NOT_NULL_FATAL((configuration_list = libdbo_configuration_list_new()));
+
+#if defined(HAVE_POSTGRESQL)
+    CU_ASSERT_PTR_NOT_NULL_FATAL((configuration = libdbo_configuration_new()));
+    CU_ASSERT_FATAL(!libdbo_configuration_set_name(configuration, "backend"));
+    CU_ASSERT_FATAL(!libdbo_configuration_set_value(configuration, "postgresql"));
+    CU_ASSERT_FATAL(!libdbo_configuration_list_add(configuration_list, configuration));
+    configuration = NULL;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((configuration = libdbo_configuration_new()));
+    CU_ASSERT_FATAL(!libdbo_configuration_set_name(configuration, "host"));
+    CU_ASSERT_FATAL(!libdbo_configuration_set_value(configuration, TEST_POSTGRESQL_HOST));
+    CU_ASSERT_FATAL(!libdbo_configuration_list_add(configuration_list, configuration));
+    configuration = NULL;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((configuration = libdbo_configuration_new()));
+    CU_ASSERT_FATAL(!libdbo_configuration_set_name(configuration, "port"));
+    CU_ASSERT_FATAL(!libdbo_configuration_set_value(configuration, TEST_POSTGRESQL_PORT_TXT));
+    CU_ASSERT_FATAL(!libdbo_configuration_list_add(configuration_list, configuration));
+    configuration = NULL;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((configuration = libdbo_configuration_new()));
+    CU_ASSERT_FATAL(!libdbo_configuration_set_name(configuration, "user"));
+    CU_ASSERT_FATAL(!libdbo_configuration_set_value(configuration, TEST_POSTGRESQL_USER));
+    CU_ASSERT_FATAL(!libdbo_configuration_list_add(configuration_list, configuration));
+    configuration = NULL;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((configuration = libdbo_configuration_new()));
+    CU_ASSERT_FATAL(!libdbo_configuration_set_name(configuration, "pass"));
+    CU_ASSERT_FATAL(!libdbo_configuration_set_value(configuration, TEST_POSTGRESQL_PASS));
+    CU_ASSERT_FATAL(!libdbo_configuration_list_add(configuration_list, configuration));
+    configuration = NULL;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((configuration = libdbo_configuration_new()));
+    CU_ASSERT_FATAL(!libdbo_configuration_set_name(configuration, "db"));
+    CU_ASSERT_FATAL(!libdbo_configuration_set_value(configuration, TEST_POSTGRESQL_DB));
+    CU_ASSERT_FATAL(!libdbo_configuration_list_add(configuration_list, configuration));
+    configuration = NULL;
+#endif
+}
+
+void test_initialization_configuration_memory(void) {
+    CU_ASSERT_PTR_NOT_NULL_FATAL((configuration_list = libdbo_configuration_list_new()));
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((configuration = libdbo_configuration_new()));
+    CU_ASSERT_FATAL(!libdbo_configuration_set_name(configuration, "backend"));
+    CU_ASSERT_FATAL(!libdbo_configuration_set_value(configuration, "memory"));
+    CU_ASSERT_FATAL(!libdbo_configuration_list_add(configuration_list, configuration));
+    configuration = NULL;
+}
+
+void test_initialization_configuration_lmdb(void) {
+    CU_ASSERT_PTR_NOT_NULL_FATAL((configuration_list = libdbo_configuration_list_new()));
+
+#if defined(HAVE_LMDB)
+    CU_ASSERT_PTR_NOT_NULL_FATAL((configuration = libdbo_configuration_new()));
+    CU_ASSERT_FATAL(!libdbo_configuration_set_name(configuration, "backend"));
+    CU_ASSERT_FATAL(!libdbo_configuration_set_value(configuration, "lmdb"));
+    CU_ASSERT_FATAL(!libdbo_configuration_list_add(configuration_list, configuration));
+    configuration = NULL;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL((configuration = libdbo_configuration_new()));
+    CU_ASSERT_FATAL(!libdbo_configuration_set_name(configuration, "file"));
+    CU_ASSERT_FATAL(!libdbo_configuration_set_value(configuration, "test.lmdb"));
+    CU_ASSERT_FATAL(!libdbo_configuration_list_add(configuration_list, configuration));
+    configuration = NULL;
+#endif
+}
+
 void test_initialization_connection(void) {
     CU_ASSERT_PTR_NOT_NULL_FATAL((connection = libdbo_connection_new()));
     CU_ASSERT_FATAL(!libdbo_connection_set_configuration_list(connection, configuration_list));